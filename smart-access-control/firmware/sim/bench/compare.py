@@ -0,0 +1,83 @@
+"""
+固件微基准结果比较
+
+比较两次 firmware_bench 的 JSON 结果（按 名称+规模 对应），列出每项的耗时变化。
+主机耗时取各轮最小值(ns_per_op_min，受主机负载影响最小)，增加超过阈值时视为回归；
+设备时间(us/次)由仿真外设模型计算，与主机无关，增加即视为回归。有回归时退出码为1。
+
+用法（firmware 目录下）:
+    python sim/bench/compare.py base.json new.json
+    python sim/bench/compare.py base.json new.json --threshold 15 --filter identity
+"""
+
+import argparse
+import json
+import sys
+
+HOST_METRIC = "ns_per_op_min"
+
+# 设备时间由仿真外设模型计算，与主机无关；消息中的时间戳位数随运行时长变化，留1%余量
+DEVICE_TOLERANCE = 0.01
+
+
+def load_results(path):
+    """读取结果文件，返回 {(名称, 规模): 结果}"""
+    with open(path, encoding="utf-8") as f:
+        data = json.load(f)
+    return {(item["name"], item["size"]): item for item in data["benchmarks"]}
+
+
+def format_change(base, new):
+    """变化百分比"""
+    if base == 0:
+        return "   -   " if new == 0 else "  新增 "
+    return f"{(new - base) / base * 100:+6.1f}%"
+
+
+def main():
+    parser = argparse.ArgumentParser(description="固件微基准结果比较")
+    parser.add_argument("base", help="基准结果（旧提交）")
+    parser.add_argument("new", help="新结果")
+    parser.add_argument("--threshold", type=float, default=10.0, help="主机耗时回归阈值(%%)，默认10")
+    parser.add_argument("--filter", default="", help="只比较名称含此子串的项目")
+    args = parser.parse_args()
+
+    base = load_results(args.base)
+    new = load_results(args.new)
+
+    regressions = []
+    print(f"{'项目':<28} {'规模':>6} {'基准ns':>10} {'新ns':>10} {'变化':>8} {'基准us':>9} {'新us':>9}")
+    for key, result in new.items():
+        name, size = key
+        if args.filter not in name:
+            continue
+        old = base.get(key)
+        if old is None:
+            print(f"{name:<28} {size:>6} {'-':>10} {result[HOST_METRIC]:>10.1f} {'新增':>8}")
+            continue
+
+        change = format_change(old[HOST_METRIC], result[HOST_METRIC])
+        mark = ""
+        if old[HOST_METRIC] > 0 and result[HOST_METRIC] > old[HOST_METRIC] * (1 + args.threshold / 100):
+            mark = " <- 主机耗时"
+            regressions.append(key)
+        if result["device_us_per_op"] > old["device_us_per_op"] * (1 + DEVICE_TOLERANCE) + 0.01:
+            mark += " <- 设备时间"
+            if key not in regressions:
+                regressions.append(key)
+        print(f"{name:<28} {size:>6} {old[HOST_METRIC]:>10.1f} {result[HOST_METRIC]:>10.1f} {change:>8} "
+              f"{old['device_us_per_op']:>9.2f} {result['device_us_per_op']:>9.2f}{mark}")
+
+    for key in base:
+        if key not in new and args.filter in key[0]:
+            print(f"{key[0]:<28} {key[1]:>6} {base[key][HOST_METRIC]:>10.1f} {'-':>10} {'已删除':>8}")
+
+    if regressions:
+        print(f"\n{len(regressions)} 项回归")
+        return 1
+    print("\n无回归")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,492 @@
+// 固件热点路径微基准（主机，PlatformIO native_bench 环境）
+//
+// 在仿真层上直接调用固件函数，每项按几种典型输入规模测量：
+//   identity  按卡号/指纹/密码查找用户（命中、未命中、多人共用的密码），用户数 10/100/1000/10000/50000
+//   uid       卡号格式化为十六进制、从十六进制和读卡器字节解析，UID长度 4/7/10 字节
+//   json      communication.c 中各消息的JSON序列化并发布，消息长度 16/64/128 字节
+//   security  security_encrypt/security_decrypt，数据长度 16/64/256 字节
+//   storage   storage_write_log 追加日志，消息长度 32/128/512 字节
+//   keypad    keypad_matrix_feed 一次扫描，每次按下/抬起的抖动次数 0/3/8
+//   sensor    一串门磁/防拆边沿的消抖（sensor_input_edge + sensor_input_settle），每串边沿数 1/5/20
+//
+// 每项先标定循环次数，使一轮的线程CPU时间不少于 --min-time，再测5轮，取每次操作耗时的中位数和最小值(ns)；
+// 另给出仿真层按外设模型计入的设备时间(us/次：SD读写、MQTT发送等，纯计算为0)，与主机速度无关。
+// 结果写为JSON（--json），用 compare.py 比较两次提交的结果。
+//
+// 用法: program [--json 结果.json] [--filter 名称子串] [--min-time ms]
+//
+// 构建运行（firmware 目录下）:
+//   pio run -e native_bench
+//   .pio/build/native_bench/program --json bench.json
+//   python sim/bench/compare.py base.json bench.json
+
+#include <Arduino.h>
+#include <PubSubClient.h>
+#include <algorithm>
+#include <array>
+#include <errno.h>
+#include <functional>
+#include <unistd.h>
+#include "../src/sim.h"
+#include "drivers/rfid_driver.h"
+#include "drivers/keypad_matrix.h"
+#include "drivers/sensor_input.h"
+#include "modules/identity.h"
+#include "modules/communication.h"
+#include "modules/security.h"
+#include "modules/storage.h"
+
+#define BENCH_ROUNDS           5
+#define BENCH_DEFAULT_MIN_MS   20
+#define BENCH_MAX_ITERATIONS   (1ULL << 32)
+
+// 查找用的凭证轮换个数（2的幂）
+#define BENCH_QUERY_COUNT  1024
+
+// 每隔多少个用户使用同一个共用密码
+#define BENCH_SHARED_PIN_EVERY  64
+#define BENCH_SHARED_PIN        "000000"
+
+// 消抖参数（与 sensor_driver.c 一致）
+#define DOOR_SETTLE_US       50000
+#define TAMPER_SETTLE_US     20000
+#define TAMPER_MIN_PULSE_US  500
+
+// 抖动边沿间隔(us)
+#define SENSOR_BOUNCE_US  300
+
+#define BENCH_DEVICE_ID  "ESP32-ACCESS-CONTROL-001"
+
+extern PubSubClient mqttClient;
+
+struct BenchResult {
+  std::string name;
+  uint32_t size;
+  uint64_t iterations;
+  double nsMedian;
+  double nsMin;
+  double deviceUs;
+};
+
+static std::vector<BenchResult> benchResults;
+static const char *benchFilter = NULL;
+static const char *benchJsonPath = NULL;
+static double benchMinTimeNs = BENCH_DEFAULT_MIN_MS * 1e6;
+
+// 防止被测调用的结果被优化掉
+static volatile uintptr_t benchSink;
+
+static uint64_t bench_thread_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint32_t benchRng = 12345;
+static uint32_t bench_rng() {
+  benchRng ^= benchRng << 13;
+  benchRng ^= benchRng >> 17;
+  benchRng ^= benchRng << 5;
+  return benchRng;
+}
+
+/**
+ * 测量一项
+ * @param name 名称（组.项）
+ * @param size 输入规模，0表示无规模参数
+ * @param body 执行被测操作指定次数
+ */
+static void bench_run(const std::string &name, uint32_t size, const std::function<void(uint64_t)> &body) {
+  if (benchFilter && name.find(benchFilter) == std::string::npos) {
+    return;
+  }
+
+  // 标定：一轮不少于最短时间
+  uint64_t iterations = 1;
+  for (;;) {
+    uint64_t start = bench_thread_ns();
+    body(iterations);
+    double elapsed = (double)(bench_thread_ns() - start);
+    if (elapsed >= benchMinTimeNs || iterations >= BENCH_MAX_ITERATIONS) {
+      break;
+    }
+    double scale = elapsed > benchMinTimeNs / 100 ? benchMinTimeNs * 1.2 / elapsed : 100;
+    iterations = std::min<uint64_t>(BENCH_MAX_ITERATIONS, (uint64_t)(iterations * scale) + 1);
+  }
+
+  double samples[BENCH_ROUNDS];
+  uint64_t deviceStart = sim_now();
+  for (int round = 0; round < BENCH_ROUNDS; round++) {
+    uint64_t start = bench_thread_ns();
+    body(iterations);
+    samples[round] = (double)(bench_thread_ns() - start) / iterations;
+  }
+  double deviceUs = (double)(sim_now() - deviceStart) / ((double)iterations * BENCH_ROUNDS);
+  std::sort(samples, samples + BENCH_ROUNDS);
+
+  BenchResult result = {name, size, iterations, samples[BENCH_ROUNDS / 2], samples[0], deviceUs};
+  benchResults.push_back(result);
+  printf("%-28s %6u %12llu %12.1f %12.1f %12.2f\n", name.c_str(), size, (unsigned long long)iterations,
+         result.nsMedian, result.nsMin, deviceUs);
+}
+
+// ==================== 身份查找 ====================
+
+static void bench_make_card(CardUid *card, uint32_t serial, uint8_t size) {
+  uint8_t bytes[RFID_UID_MAX_SIZE];
+  for (uint8_t i = 0; i < size; i++) {
+    bytes[i] = (uint8_t)(serial >> (8 * (i % 4))) ^ (uint8_t)(i * 0x3D);
+  }
+  bytes[0] = (uint8_t)(serial >> 24) | 0x80;
+  bytes[1] = (uint8_t)(serial >> 16);
+  bytes[2] = (uint8_t)(serial >> 8);
+  bytes[3] = (uint8_t)serial;
+  rfid_uid_from_bytes(card, bytes, size);
+}
+
+static void bench_identity() {
+  static const uint32_t userCounts[] = {10, 100, 1000, 10000, 50000};
+  for (uint32_t count : userCounts) {
+    std::vector<User> users(count);
+    for (uint32_t i = 0; i < count; i++) {
+      User &user = users[i];
+      memset(&user, 0, sizeof(user));
+      user.id = i + 1;
+      snprintf(user.name, sizeof(user.name), "用户%u", i + 1);
+      bench_make_card(&user.card, i + 1, 4);
+      user.fingerprintId = i + 1;
+      if (i % BENCH_SHARED_PIN_EVERY == 0) {
+        strcpy(user.password, BENCH_SHARED_PIN);
+      } else {
+        snprintf(user.password, sizeof(user.password), "%06u", 100000 + i);
+      }
+      user.enabled = true;
+    }
+    if (!identity_replace_users(users.data(), count, 0)) {
+      fprintf(stderr, "用户库替换失败: %u\n", count);
+      continue;
+    }
+
+    // 命中：随机已登记的凭证；未命中：不存在的卡号、指纹ID、密码
+    std::vector<CardUid> hitCards(BENCH_QUERY_COUNT), missCards(BENCH_QUERY_COUNT);
+    std::vector<int> hitFingers(BENCH_QUERY_COUNT), missFingers(BENCH_QUERY_COUNT);
+    std::vector<std::array<char, 8>> hitPasswords(BENCH_QUERY_COUNT), missPasswords(BENCH_QUERY_COUNT);
+    for (int i = 0; i < BENCH_QUERY_COUNT; i++) {
+      uint32_t user = bench_rng() % count;
+      hitCards[i] = users[user].card;
+      bench_make_card(&missCards[i], 0x00800000 + bench_rng() % 0x00800000, 4);
+      hitFingers[i] = users[user].fingerprintId;
+      missFingers[i] = count + 1 + bench_rng() % 1000;
+      memcpy(hitPasswords[i].data(), users[user].password, 7);
+      snprintf(missPasswords[i].data(), 8, "%06u", 900000 + bench_rng() % 100000);
+    }
+
+    bench_run("identity.card_hit", count, [&](uint64_t n) {
+      for (uint64_t i = 0; i < n; i++) {
+        benchSink = identity_find_user_by_card(&hitCards[i & (BENCH_QUERY_COUNT - 1)], NULL);
+      }
+    });
+    bench_run("identity.card_miss", count, [&](uint64_t n) {
+      for (uint64_t i = 0; i < n; i++) {
+        benchSink = identity_find_user_by_card(&missCards[i & (BENCH_QUERY_COUNT - 1)], NULL);
+      }
+    });
+    bench_run("identity.finger_hit", count, [&](uint64_t n) {
+      for (uint64_t i = 0; i < n; i++) {
+        benchSink = identity_find_user_by_fingerprint(hitFingers[i & (BENCH_QUERY_COUNT - 1)], NULL);
+      }
+    });
+    bench_run("identity.finger_miss", count, [&](uint64_t n) {
+      for (uint64_t i = 0; i < n; i++) {
+        benchSink = identity_find_user_by_fingerprint(missFingers[i & (BENCH_QUERY_COUNT - 1)], NULL);
+      }
+    });
+    bench_run("identity.password_hit", count, [&](uint64_t n) {
+      for (uint64_t i = 0; i < n; i++) {
+        benchSink = identity_find_user_by_password(hitPasswords[i & (BENCH_QUERY_COUNT - 1)].data(), NULL);
+      }
+    });
+    bench_run("identity.password_miss", count, [&](uint64_t n) {
+      for (uint64_t i = 0; i < n; i++) {
+        benchSink = identity_find_user_by_password(missPasswords[i & (BENCH_QUERY_COUNT - 1)].data(), NULL);
+      }
+    });
+    bench_run("identity.password_shared", count, [&](uint64_t n) {
+      for (uint64_t i = 0; i < n; i++) {
+        benchSink = identity_find_user_by_password(BENCH_SHARED_PIN, NULL);
+      }
+    });
+  }
+}
+
+// ==================== 卡号格式化与解析 ====================
+
+static void bench_uid() {
+  static const uint8_t sizes[] = {4, 7, 10};
+  for (uint8_t size : sizes) {
+    std::vector<CardUid> cards(BENCH_QUERY_COUNT);
+    std::vector<std::array<char, RFID_UID_HEX_SIZE>> hex(BENCH_QUERY_COUNT);
+    std::vector<std::array<byte, RFID_UID_MAX_SIZE>> raw(BENCH_QUERY_COUNT);
+    for (int i = 0; i < BENCH_QUERY_COUNT; i++) {
+      bench_make_card(&cards[i], bench_rng(), size);
+      rfid_uid_to_hex(&cards[i], hex[i].data(), RFID_UID_HEX_SIZE);
+      memcpy(raw[i].data(), cards[i].bytes, size);
+    }
+
+    bench_run("uid.to_hex", size, [&](uint64_t n) {
+      char buffer[RFID_UID_HEX_SIZE];
+      for (uint64_t i = 0; i < n; i++) {
+        benchSink = (uintptr_t)rfid_uid_to_hex(&cards[i & (BENCH_QUERY_COUNT - 1)], buffer, sizeof(buffer));
+      }
+    });
+    bench_run("uid.from_hex", size, [&](uint64_t n) {
+      CardUid card;
+      for (uint64_t i = 0; i < n; i++) {
+        benchSink = rfid_uid_from_hex(&card, hex[i & (BENCH_QUERY_COUNT - 1)].data());
+      }
+    });
+    bench_run("uid.from_bytes", size, [&](uint64_t n) {
+      CardUid card;
+      for (uint64_t i = 0; i < n; i++) {
+        benchSink = rfid_uid_from_bytes(&card, raw[i & (BENCH_QUERY_COUNT - 1)].data(), size);
+      }
+    });
+  }
+}
+
+// ==================== JSON消息 ====================
+
+static void bench_json() {
+  // 按固件流程建立MQTT会话（仿真服务器，发布按链路速率计入设备时间）
+  if (!communication_connect_wifi() || !communication_connect_mqtt(&mqttClient, BENCH_DEVICE_ID)) {
+    fprintf(stderr, "MQTT连接失败，跳过JSON消息\n");
+    return;
+  }
+
+  CardUid card;
+  bench_make_card(&card, 0x12345678, 7);
+  bench_run("json.status", 0, [&](uint64_t n) {
+    for (uint64_t i = 0; i < n; i++) {
+      communication_publish_status(&mqttClient, BENCH_DEVICE_ID, "online");
+    }
+  });
+  bench_run("json.access_record", 0, [&](uint64_t n) {
+    for (uint64_t i = 0; i < n; i++) {
+      communication_publish_access_record(1, "card", "success", &card);
+    }
+  });
+  bench_run("json.sensor_data", 0, [&](uint64_t n) {
+    for (uint64_t i = 0; i < n; i++) {
+      communication_publish_sensor_data(&mqttClient, BENCH_DEVICE_ID);
+    }
+  });
+  bench_run("json.device_status", 0, [&](uint64_t n) {
+    for (uint64_t i = 0; i < n; i++) {
+      communication_publish_device_status(&mqttClient, BENCH_DEVICE_ID);
+    }
+  });
+
+  static const uint32_t lengths[] = {16, 64, 128};
+  for (uint32_t length : lengths) {
+    std::string message(length, 'x');
+    bench_run("json.alarm", length, [&](uint64_t n) {
+      for (uint64_t i = 0; i < n; i++) {
+        communication_publish_alarm("tamper", message.c_str());
+      }
+    });
+    bench_run("json.event", length, [&](uint64_t n) {
+      for (uint64_t i = 0; i < n; i++) {
+        communication_publish_event(&mqttClient, BENCH_DEVICE_ID, "door_held_open_clear", message.c_str());
+      }
+    });
+  }
+}
+
+// ==================== 加解密 ====================
+
+static void bench_security() {
+  static const int lengths[] = {16, 64, 256};
+  byte key[8] = {0x13, 0x57, 0x9B, 0xDF, 0x24, 0x68, 0xAC, 0xE0};
+  for (int length : lengths) {
+    std::vector<byte> data(length);
+    for (int i = 0; i < length; i++) {
+      data[i] = (byte)bench_rng();
+    }
+    bench_run("security.encrypt", length, [&](uint64_t n) {
+      for (uint64_t i = 0; i < n; i++) {
+        benchSink = (uintptr_t)security_encrypt(data.data(), length, key);
+      }
+    });
+    bench_run("security.decrypt", length, [&](uint64_t n) {
+      for (uint64_t i = 0; i < n; i++) {
+        benchSink = (uintptr_t)security_decrypt(data.data(), length, key);
+      }
+    });
+  }
+}
+
+// ==================== 日志追加 ====================
+
+static void bench_storage() {
+  if (!storage_is_initialized()) {
+    fprintf(stderr, "存储未初始化，跳过日志追加\n");
+    return;
+  }
+  static const uint32_t lengths[] = {32, 128, 512};
+  for (uint32_t length : lengths) {
+    std::string message(length, 'l');
+    bench_run("storage.write_log", length, [&](uint64_t n) {
+      for (uint64_t i = 0; i < n; i++) {
+        benchSink = storage_write_log(message.c_str());
+      }
+    });
+  }
+}
+
+// ==================== 键盘与门磁/防拆消抖 ====================
+
+/**
+ * 生成一次密码输入（123456#）的扫描序列：每次按下和抬起前后各有若干次抖动
+ */
+static std::vector<uint16_t> bench_keypad_scans(uint32_t bounces) {
+  static const uint8_t keys[] = {0, 1, 2, 4, 5, 6, 14};   // 行×4+列
+  std::vector<uint16_t> scans;
+  for (uint8_t key : keys) {
+    uint16_t bit = 1 << key;
+    for (uint32_t i = 0; i < bounces; i++) {
+      scans.push_back(i % 2 ? 0 : bit);
+    }
+    scans.insert(scans.end(), 16, bit);     // 按住80ms
+    for (uint32_t i = 0; i < bounces; i++) {
+      scans.push_back(i % 2 ? bit : 0);
+    }
+    scans.insert(scans.end(), 30, 0);       // 间隔150ms
+  }
+  return scans;
+}
+
+static void bench_keypad() {
+  static const uint32_t bounceCounts[] = {0, 3, 8};
+  for (uint32_t bounces : bounceCounts) {
+    std::vector<uint16_t> scans = bench_keypad_scans(bounces);
+    KeypadMatrix matrix;
+    keypad_matrix_init(&matrix, "123A456B789C*0#D");
+    uint32_t now = 0;
+    bench_run("keypad.feed", bounces, [&](uint64_t n) {
+      KeypadEvent events[KEYPAD_KEYS];
+      for (uint64_t i = 0; i < n; i++) {
+        now += KEYPAD_SCAN_INTERVAL_MS;
+        benchSink = keypad_matrix_feed(&matrix, scans[i % scans.size()], now, events, KEYPAD_KEYS);
+      }
+    });
+  }
+}
+
+/**
+ * 一串边沿：有效、无效交替共edges个，之后静默并取出状态变化；下一串从相反电平开始
+ */
+static void bench_sensor_bursts(SensorInput *input, uint32_t edges, uint32_t *now, uint64_t bursts) {
+  SensorChange change;
+  for (uint64_t b = 0; b < bursts; b++) {
+    bool level = !input->stable;
+    for (uint32_t e = 0; e < edges; e++) {
+      *now += SENSOR_BOUNCE_US;
+      sensor_input_edge(input, e % 2 ? !level : level, *now);
+    }
+    // 边沿数为偶数时回到原电平，补一个边沿使每串都改变状态
+    if (edges % 2 == 0) {
+      *now += SENSOR_BOUNCE_US;
+      sensor_input_edge(input, level, *now);
+    }
+    *now += input->settleUs;
+    while (sensor_input_settle(input, *now, &change)) {
+      benchSink = change.active;
+    }
+  }
+}
+
+static void bench_sensor() {
+  static const uint32_t edgeCounts[] = {1, 5, 20};
+  for (uint32_t edges : edgeCounts) {
+    SensorInput door;
+    SensorInput tamper;
+    sensor_input_init(&door, false, DOOR_SETTLE_US, 0, true);
+    sensor_input_init(&tamper, false, TAMPER_SETTLE_US, TAMPER_MIN_PULSE_US, false);
+    uint32_t now = 0;
+    bench_run("sensor.door_burst", edges, [&](uint64_t n) {
+      bench_sensor_bursts(&door, edges, &now, n);
+    });
+    bench_run("sensor.tamper_burst", edges, [&](uint64_t n) {
+      bench_sensor_bursts(&tamper, edges, &now, n);
+    });
+  }
+}
+
+// ==================== 结果 ====================
+
+static void bench_write_json(const char *path) {
+  FILE *out = fopen(path, "w");
+  if (!out) {
+    fprintf(stderr, "无法写入结果 %s: %s\n", path, strerror(errno));
+    return;
+  }
+  fprintf(out, "{\n  \"suite\": \"firmware\",\n  \"rounds\": %d,\n  \"benchmarks\": [", BENCH_ROUNDS);
+  for (size_t i = 0; i < benchResults.size(); i++) {
+    const BenchResult &r = benchResults[i];
+    fprintf(out, "%s\n    {\"name\": \"%s\", \"size\": %u, \"iterations\": %llu, \"ns_per_op\": %.2f, "
+                 "\"ns_per_op_min\": %.2f, \"device_us_per_op\": %.3f}",
+            i ? "," : "", r.name.c_str(), r.size, (unsigned long long)r.iterations, r.nsMedian, r.nsMin, r.deviceUs);
+  }
+  fprintf(out, "\n  ]\n}\n");
+  fclose(out);
+}
+
+static void bench_task(void *) {
+  // 被测模块的初始化输出不打印
+  storage_init();
+  identity_init();
+  communication_init(&mqttClient);
+
+  printf("%-28s %6s %12s %12s %12s %12s\n", "项目", "规模", "次数", "ns/次", "最小ns/次", "设备us/次");
+  bench_identity();
+  bench_uid();
+  bench_json();
+  bench_security();
+  bench_storage();
+  bench_keypad();
+  bench_sensor();
+
+  if (benchJsonPath) {
+    bench_write_json(benchJsonPath);
+  }
+  fflush(stdout);
+  sim_sd_cleanup();
+  _exit(0);
+}
+
+static void bench_usage(const char *program) {
+  fprintf(stderr, "用法: %s [--json 结果.json] [--filter 名称子串] [--min-time ms]\n", program);
+}
+
+int main(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (strcmp(arg, "--json") == 0 && hasValue) {
+      benchJsonPath = argv[++i];
+    } else if (strcmp(arg, "--filter") == 0 && hasValue) {
+      benchFilter = argv[++i];
+    } else if (strcmp(arg, "--min-time") == 0 && hasValue) {
+      benchMinTimeNs = atof(argv[++i]) * 1e6;
+    } else {
+      bench_usage(argv[0]);
+      return 2;
+    }
+  }
+
+  simOptions.quiet = true;
+  setvbuf(stdout, NULL, _IOLBF, 0);
+  sim_sd_init();
+  sim_devices_init();
+  sim_kernel_run(SIM_FOREVER, bench_task);
+}
@@ -0,0 +1,40 @@
+#ifndef SIM_ADAFRUIT_FINGERPRINT_H
+#define SIM_ADAFRUIT_FINGERPRINT_H
+
+// 主机仿真：指纹库（只有驱动直接调用的管理接口，直接访问仿真指纹模块的模板库；
+// 识别流水线和录入作业按串口协议经 Serial2 与仿真模块收发）
+
+#include <Arduino.h>
+
+#define FINGERPRINT_OK                0x00
+#define FINGERPRINT_PACKETRECIEVEERR  0x01
+#define FINGERPRINT_NOFINGER          0x02
+#define FINGERPRINT_NOTFOUND          0x09
+#define FINGERPRINT_BADLOCATION       0x0B
+
+class Adafruit_Fingerprint {
+ public:
+  Adafruit_Fingerprint(HardwareSerial *serial, uint32_t password = 0x0);
+
+  void begin(uint32_t baud);
+  bool verifyPassword();
+  uint8_t getTemplateCount();
+  uint8_t deleteModel(uint16_t id);
+  uint8_t emptyDatabase();
+
+  uint16_t fingerID = 0;
+  uint16_t confidence = 0;
+  uint16_t templateCount = 0;
+  uint16_t status_reg = 0;
+  uint16_t system_id = 0;
+  uint16_t capacity = 0;
+  uint16_t security_level = 0;
+  uint32_t device_addr = 0xFFFFFFFF;
+  uint16_t packet_len = 0;
+  uint16_t baud_rate = 0;
+
+ private:
+  HardwareSerial *serial_;
+};
+
+#endif
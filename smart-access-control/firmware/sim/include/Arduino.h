@@ -0,0 +1,174 @@
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+// 主机仿真：Arduino核心（ESP32）的最小子集
+// 时间取自仿真内核的虚拟时钟，GPIO、串口接到设备模型（sim/src），只提供固件用到的接口。
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <math.h>
+#include <time.h>
+#include <string>
+#include <type_traits>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+
+typedef uint8_t byte;
+typedef unsigned long ulong;
+typedef bool boolean;
+
+#define IRAM_ATTR
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT          0x01
+#define OUTPUT         0x03
+#define INPUT_PULLUP   0x05
+#define INPUT_PULLDOWN 0x09
+
+#define RISING  0x01
+#define FALLING 0x02
+#define CHANGE  0x03
+
+#define DEC 10
+#define HEX 16
+
+#define SERIAL_8N1 0x800001c
+
+template <class T, class U>
+inline auto min(T a, U b) -> typename std::common_type<T, U>::type { return a < b ? a : b; }
+template <class T, class U>
+inline auto max(T a, U b) -> typename std::common_type<T, U>::type { return a > b ? a : b; }
+
+#if !defined(__GLIBC__) || !__GLIBC_PREREQ(2, 38)
+extern "C" size_t strlcpy(char *dst, const char *src, size_t size);
+#endif
+
+// 时间（虚拟时钟）
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+// GPIO
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode);
+void detachInterrupt(uint8_t pin);
+#define digitalPinToInterrupt(p) (p)
+
+// LEDC PWM
+double ledcSetup(uint8_t channel, double frequency, uint8_t resolution);
+void ledcAttachPin(uint8_t pin, uint8_t channel);
+void ledcWrite(uint8_t channel, uint32_t duty);
+double ledcWriteTone(uint8_t channel, double frequency);
+
+// PSRAM
+bool psramFound();
+
+// NTP校时
+void configTzTime(const char *tz, const char *server1, const char *server2 = NULL, const char *server3 = NULL);
+
+// 字符串（只用于 IPAddress::toString）
+class String {
+ public:
+  String(const char *text = "") : text_(text ? text : "") {}
+  const char *c_str() const { return text_.c_str(); }
+  unsigned int length() const { return text_.size(); }
+
+ private:
+  std::string text_;
+};
+
+// 输出
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  size_t write(const char *text) { return write((const uint8_t *)text, strlen(text)); }
+
+  size_t print(const char *text) { return write(text); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int value, int base = DEC) { return print((long)value, base); }
+  size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+  size_t print(long value, int base = DEC);
+  size_t print(unsigned long value, int base = DEC);
+  size_t print(double value, int digits = 2);
+  size_t print(const String &text) { return print(text.c_str()); }
+
+  size_t println() { return write("\r\n"); }
+  template <class T>
+  size_t println(T value) { size_t n = print(value); return n + println(); }
+  template <class T>
+  size_t println(T value, int format) { size_t n = print(value, format); return n + println(); }
+
+  size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+// 输入输出流
+class Stream : public Print {
+ public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  virtual void flush() {}
+  size_t readBytes(char *buffer, size_t length);
+  size_t readBytes(uint8_t *buffer, size_t length) { return readBytes((char *)buffer, length); }
+};
+
+// 硬件串口：Serial接控制台（输出加虚拟时间前缀，输入来自场景），Serial2接指纹模块模型
+class HardwareSerial : public Stream {
+ public:
+  explicit HardwareSerial(int port) : port_(port) {}
+  void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int8_t rxPin = -1, int8_t txPin = -1);
+  void end() {}
+  void updateBaudRate(unsigned long baud);
+  unsigned long baudRate() const { return baud_; }
+  void setRxBufferSize(size_t) {}
+
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t read(uint8_t *buffer, size_t size);
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *buffer, size_t size) override;
+  using Print::write;
+  operator bool() const { return true; }
+
+  // 仿真：对端数据到达接收缓冲区
+  void sim_receive(const uint8_t *data, size_t length);
+
+ private:
+  int port_;
+  unsigned long baud_ = 115200;
+  std::string rx_;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+extern HardwareSerial Serial2;
+
+// 芯片信息（周期计数由虚拟时钟推出）
+class EspClass {
+ public:
+  uint32_t getCycleCount();
+  uint32_t getCpuFreqMHz() { return 240; }
+  uint32_t getFreeHeap();
+  void restart();
+};
+
+extern EspClass ESP;
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef SIM_MFRC522_H
+#define SIM_MFRC522_H
+
+// 主机仿真：MFRC522读卡器，接到仿真读卡区（场景 card 指令放入、移出卡片）
+// 各调用按SPI传输和读卡器定时器超时（TReload/40kHz）计入调用任务的忙时间：
+// 读卡区无卡或卡已休眠时寻卡等满超时，HaltA无应答也等满超时，与原库的行为一致
+
+#include <Arduino.h>
+
+class MFRC522 {
+ public:
+  enum PCD_Register : byte {
+    CommandReg = 0x01 << 1,
+    ComIEnReg = 0x02 << 1,
+    DivIEnReg = 0x03 << 1,
+    ComIrqReg = 0x04 << 1,
+    DivIrqReg = 0x05 << 1,
+    ErrorReg = 0x06 << 1,
+    Status2Reg = 0x08 << 1,
+    FIFODataReg = 0x09 << 1,
+    FIFOLevelReg = 0x0A << 1,
+    ModeReg = 0x11 << 1,
+    TxControlReg = 0x14 << 1,
+    TxASKReg = 0x15 << 1,
+    RFCfgReg = 0x26 << 1,
+    TModeReg = 0x2A << 1,
+    TPrescalerReg = 0x2B << 1,
+    TReloadRegH = 0x2C << 1,
+    TReloadRegL = 0x2D << 1,
+    VersionReg = 0x37 << 1,
+  };
+
+  enum PCD_RxGain : byte {
+    RxGain_18dB = 0x00 << 4,
+    RxGain_23dB = 0x01 << 4,
+    RxGain_18dB_2 = 0x02 << 4,
+    RxGain_23dB_2 = 0x03 << 4,
+    RxGain_33dB = 0x04 << 4,
+    RxGain_38dB = 0x05 << 4,
+    RxGain_43dB = 0x06 << 4,
+    RxGain_48dB = 0x07 << 4,
+    RxGain_min = 0x00 << 4,
+    RxGain_avg = 0x04 << 4,
+    RxGain_max = 0x07 << 4,
+  };
+
+  enum PICC_Type : byte {
+    PICC_TYPE_UNKNOWN,
+    PICC_TYPE_ISO_14443_4,
+    PICC_TYPE_ISO_18092,
+    PICC_TYPE_MIFARE_MINI,
+    PICC_TYPE_MIFARE_1K,
+    PICC_TYPE_MIFARE_4K,
+    PICC_TYPE_MIFARE_UL,
+    PICC_TYPE_MIFARE_PLUS,
+    PICC_TYPE_MIFARE_DESFIRE,
+    PICC_TYPE_TNP3XXX,
+    PICC_TYPE_NOT_COMPLETE = 0xff,
+  };
+
+  enum StatusCode : byte {
+    STATUS_OK,
+    STATUS_ERROR,
+    STATUS_COLLISION,
+    STATUS_TIMEOUT,
+    STATUS_NO_ROOM,
+    STATUS_INTERNAL_ERROR,
+    STATUS_INVALID,
+    STATUS_CRC_WRONG,
+    STATUS_MIFARE_NACK = 0xff,
+  };
+
+  typedef struct {
+    byte size;
+    byte uidByte[10];
+    byte sak;
+  } Uid;
+
+  Uid uid;
+
+  MFRC522(byte chipSelectPin, byte resetPowerDownPin);
+
+  void PCD_Init();
+  void PCD_Reset();
+  byte PCD_ReadRegister(PCD_Register reg);
+  void PCD_WriteRegister(PCD_Register reg, byte value);
+  void PCD_SetAntennaGain(byte mask);
+  byte PCD_GetAntennaGain();
+  bool PCD_PerformSelfTest();
+  void PCD_StopCrypto1();
+
+  bool PICC_IsNewCardPresent();
+  bool PICC_ReadCardSerial();
+  StatusCode PICC_HaltA();
+  static PICC_Type PICC_GetType(byte sak);
+
+ private:
+  byte registers_[64];
+  uint32_t timeout_us() const;
+};
+
+#endif
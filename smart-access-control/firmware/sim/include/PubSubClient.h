@@ -0,0 +1,67 @@
+#ifndef SIM_PUBSUBCLIENT_H
+#define SIM_PUBSUBCLIENT_H
+
+// 主机仿真：MQTT客户端，连接进程内的仿真服务器
+// 发布的消息记入仿真日志（场景 expect 检查），场景 mqtt 注入的消息在 loop() 中按订阅交付回调
+// 报文超过缓冲区大小时与原库一样发布失败；发送时间按链路速率计入调用任务的忙时间
+// 流式发布（beginPublish到endPublish）期间其他调用插入报文时，按代理收到错误报文断开连接
+
+#include <Arduino.h>
+#include <functional>
+#include "WiFiClient.h"
+
+#define MQTT_MAX_PACKET_SIZE 256
+
+#define MQTT_CONNECTION_TIMEOUT     -4
+#define MQTT_CONNECTION_LOST        -3
+#define MQTT_CONNECT_FAILED         -2
+#define MQTT_DISCONNECTED           -1
+#define MQTT_CONNECTED               0
+
+#define MQTT_CALLBACK_SIGNATURE std::function<void(char *, uint8_t *, unsigned int)> callback
+
+class PubSubClient : public Print {
+ public:
+  PubSubClient() {}
+  explicit PubSubClient(Client &client) : client_(&client) {}
+
+  PubSubClient &setServer(const char *domain, uint16_t port);
+  PubSubClient &setCallback(MQTT_CALLBACK_SIGNATURE);
+  PubSubClient &setClient(Client &client);
+  bool setBufferSize(uint16_t size);
+  uint16_t getBufferSize() { return bufferSize_; }
+
+  bool connect(const char *id);
+  bool connect(const char *id, const char *user, const char *pass);
+  void disconnect();
+  bool connected();
+  int state();
+  bool loop();
+
+  bool publish(const char *topic, const char *payload);
+  bool publish(const char *topic, const char *payload, bool retained);
+  bool publish(const char *topic, const uint8_t *payload, unsigned int length);
+  bool publish(const char *topic, const uint8_t *payload, unsigned int length, bool retained);
+  bool beginPublish(const char *topic, unsigned int length, bool retained);
+  int endPublish();
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  using Print::write;
+
+  bool subscribe(const char *topic, uint8_t qos = 0);
+  bool unsubscribe(const char *topic);
+
+ private:
+  bool sim_interleaved(const char *call);
+
+  Client *client_ = NULL;
+  std::function<void(char *, uint8_t *, unsigned int)> callback_;
+  uint16_t bufferSize_ = MQTT_MAX_PACKET_SIZE;
+  bool connected_ = false;
+  std::string streamTopic_;
+  std::string streamPayload_;
+  size_t streamLength_ = 0;
+  bool streaming_ = false;
+};
+
+#endif
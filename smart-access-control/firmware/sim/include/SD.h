@@ -0,0 +1,70 @@
+#ifndef SIM_SD_H
+#define SIM_SD_H
+
+// 主机仿真：SD卡映射到主机目录（--sd 指定，未指定时每次运行使用新的临时目录）
+// 读写按SPI SD卡的典型速度计入调用任务的忙时间
+
+#include <Arduino.h>
+#include <memory>
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+typedef enum {
+  CARD_NONE,
+  CARD_MMC,
+  CARD_SD,
+  CARD_SDHC,
+  CARD_UNKNOWN,
+} sdcard_type_t;
+
+struct SimFileHandle;
+
+class File : public Stream {
+ public:
+  File() {}
+  explicit File(std::shared_ptr<SimFileHandle> handle) : handle_(handle) {}
+
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *buffer, size_t size) override;
+  using Print::write;
+  int available() override;
+  int read() override;
+  int peek() override;
+  void flush() override;
+  size_t read(uint8_t *buffer, size_t size);
+  bool seek(uint32_t position);
+  size_t position();
+  size_t size();
+  void close();
+  const char *name() const;
+  const char *path() const;
+  bool isDirectory() const;
+  File openNextFile(const char *mode = FILE_READ);
+  void rewindDirectory();
+  explicit operator bool() const;
+
+ private:
+  std::shared_ptr<SimFileHandle> handle_;
+};
+
+class SDFS {
+ public:
+  bool begin(uint8_t ssPin = 5);
+  void end() {}
+  sdcard_type_t cardType();
+  uint64_t cardSize();
+  uint64_t totalBytes();
+  uint64_t usedBytes();
+  File open(const char *path, const char *mode = FILE_READ, bool create = false);
+  bool exists(const char *path);
+  bool remove(const char *path);
+  bool rename(const char *from, const char *to);
+  bool mkdir(const char *path);
+  bool rmdir(const char *path);
+};
+
+extern SDFS SD;
+
+#endif
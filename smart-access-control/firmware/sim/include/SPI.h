@@ -0,0 +1,16 @@
+#ifndef SIM_SPI_H
+#define SIM_SPI_H
+
+// 主机仿真：SPI总线（传输时间计入各设备模型）
+
+#include <Arduino.h>
+
+class SPIClass {
+ public:
+  void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1) {}
+  void end() {}
+};
+
+extern SPIClass SPI;
+
+#endif
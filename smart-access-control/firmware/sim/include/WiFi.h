@@ -0,0 +1,39 @@
+#ifndef SIM_WIFI_H
+#define SIM_WIFI_H
+
+// 主机仿真：WiFi（begin后立即连接，场景中 wifi off/on 断开、恢复）
+
+#include <Arduino.h>
+#include "WiFiClient.h"
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6,
+} wl_status_t;
+
+class IPAddress {
+ public:
+  IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0) : bytes_{a, b, c, d} {}
+  String toString() const;
+  bool operator==(const IPAddress &other) const { return memcmp(bytes_, other.bytes_, sizeof(bytes_)) == 0; }
+
+ private:
+  uint8_t bytes_[4];
+};
+
+class WiFiClass {
+ public:
+  wl_status_t begin(const char *ssid, const char *password = NULL);
+  bool disconnect(bool wifiOff = false);
+  wl_status_t status();
+  IPAddress localIP();
+  int8_t RSSI();
+};
+
+extern WiFiClass WiFi;
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef SIM_WIFI_CLIENT_H
+#define SIM_WIFI_CLIENT_H
+
+// 主机仿真：TCP客户端（只作为PubSubClient的底层连接，数据由仿真MQTT服务器直接交付）
+
+#include <Arduino.h>
+
+class Client : public Stream {
+ public:
+  virtual uint8_t connected() = 0;
+};
+
+class WiFiClient : public Client {
+ public:
+  uint8_t connected() override;
+  int fd() const;
+  int available() override;
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  size_t write(uint8_t c) override { return 1; }
+  size_t write(const uint8_t *buffer, size_t size) override { return size; }
+  using Print::write;
+};
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef SIM_ESP_HEAP_CAPS_H
+#define SIM_ESP_HEAP_CAPS_H
+
+// 主机仿真：按能力分配内存（全部来自主机堆，剩余量返回典型模组的固定值）
+
+#include <stddef.h>
+
+#define MALLOC_CAP_EXEC      (1 << 0)
+#define MALLOC_CAP_32BIT     (1 << 1)
+#define MALLOC_CAP_8BIT      (1 << 2)
+#define MALLOC_CAP_DMA       (1 << 3)
+#define MALLOC_CAP_SPIRAM    (1 << 10)
+#define MALLOC_CAP_INTERNAL  (1 << 11)
+#define MALLOC_CAP_DEFAULT   (1 << 12)
+
+void *heap_caps_malloc(size_t size, unsigned int caps);
+void *heap_caps_calloc(size_t count, size_t size, unsigned int caps);
+void *heap_caps_aligned_alloc(size_t alignment, size_t size, unsigned int caps);
+void heap_caps_free(void *ptr);
+size_t heap_caps_get_free_size(unsigned int caps);
+size_t heap_caps_get_minimum_free_size(unsigned int caps);
+
+#endif
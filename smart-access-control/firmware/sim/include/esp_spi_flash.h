@@ -0,0 +1,15 @@
+#ifndef SIM_ESP_SPI_FLASH_H
+#define SIM_ESP_SPI_FLASH_H
+
+#include <stdint.h>
+
+typedef enum {
+  SPI_FLASH_MMAP_DATA,
+  SPI_FLASH_MMAP_INST,
+} spi_flash_mmap_memory_t;
+
+typedef uint32_t spi_flash_mmap_handle_t;
+
+void spi_flash_munmap(spi_flash_mmap_handle_t handle);
+
+#endif
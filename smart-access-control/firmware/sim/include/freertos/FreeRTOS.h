@@ -0,0 +1,44 @@
+#ifndef SIM_FREERTOS_H
+#define SIM_FREERTOS_H
+
+// 主机仿真：FreeRTOS（ESP-IDF）
+// 任务由仿真内核按优先级在虚拟时间上调度（同一时刻只运行一个任务），tick为1ms。
+// 两个核按一个核调度；临界区只屏蔽设备事件（中断），不需要自旋锁。
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdTRUE   1
+#define pdFALSE  0
+#define pdPASS   pdTRUE
+#define pdFAIL   pdFALSE
+
+#define portMAX_DELAY        ((TickType_t)0xFFFFFFFF)
+#define portTICK_PERIOD_MS   1
+#define pdMS_TO_TICKS(ms)    ((TickType_t)(ms) / portTICK_PERIOD_MS)
+#define portNUM_PROCESSORS   2
+
+typedef struct {
+  uint32_t owner;
+  uint32_t count;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED  {0, 0}
+
+void sim_enter_critical();
+void sim_exit_critical();
+
+#define portENTER_CRITICAL(mux)      ((void)(mux), sim_enter_critical())
+#define portEXIT_CRITICAL(mux)       ((void)(mux), sim_exit_critical())
+#define portENTER_CRITICAL_ISR(mux)  ((void)(mux), sim_enter_critical())
+#define portEXIT_CRITICAL_ISR(mux)   ((void)(mux), sim_exit_critical())
+
+// 中断返回时内核总会检查是否需要切换任务
+#define portYIELD_FROM_ISR(...)      ((void)0)
+
+BaseType_t xPortGetCoreID();
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef SIM_IMG_CONVERTERS_H
+#define SIM_IMG_CONVERTERS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_camera.h"
+
+typedef enum {
+  JPG_SCALE_NONE,
+  JPG_SCALE_2X,
+  JPG_SCALE_4X,
+  JPG_SCALE_8X,
+  JPG_SCALE_MAX = JPG_SCALE_8X,
+} jpg_scale_t;
+
+bool jpg2rgb565(const uint8_t *src, size_t srcLength, uint8_t *out, jpg_scale_t scale);
+
+#endif
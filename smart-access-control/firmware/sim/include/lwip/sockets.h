@@ -0,0 +1,13 @@
+#ifndef SIM_LWIP_SOCKETS_H
+#define SIM_LWIP_SOCKETS_H
+
+// 主机仿真：select() 在虚拟时间上等待MQTT连接的入站数据（只支持 WiFiClient::fd() 返回的描述符）
+
+#include <sys/select.h>
+#include <sys/time.h>
+
+int sim_lwip_select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds, struct timeval *timeout);
+
+#define select sim_lwip_select
+
+#endif
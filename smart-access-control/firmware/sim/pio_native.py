@@ -0,0 +1,5 @@
+# PlatformIO native 环境的预处理脚本
+# 固件的 .c 文件用到了 Serial、String、ArduinoJson 等C++接口，主机上统一按C++编译
+Import("env")
+
+env.Replace(CC="$CXX")
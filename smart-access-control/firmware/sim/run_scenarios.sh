@@ -0,0 +1,24 @@
+#!/bin/sh
+# 运行全部仿真场景，每个场景的报告写入 JSON（CI性能回归比较用）
+# 用法（firmware 目录下）: sh sim/run_scenarios.sh [报告目录]
+# 任一场景的期望失败时退出码非0
+
+PROGRAM=.pio/build/native/program
+REPORT_DIR=${1:-.pio/sim-reports}
+
+if [ ! -x "$PROGRAM" ]; then
+  pio run -e native || exit 1
+fi
+mkdir -p "$REPORT_DIR"
+
+failed=0
+for scenario in sim/scenarios/*.txt; do
+  name=$(basename "$scenario" .txt)
+  if "$PROGRAM" -q --report "$REPORT_DIR/$name.json" "$scenario"; then
+    echo "通过 $name"
+  else
+    echo "失败 $name"
+    failed=1
+  fi
+done
+exit $failed
@@ -0,0 +1,228 @@
+#ifndef SIM_H
+#define SIM_H
+
+// 主机仿真内部接口（内核、设备模型、场景之间共用，固件代码不包含本文件）
+//
+// 虚拟时间以微秒计，只在任务忙（sim_busy，各设备模型按传输/处理时间调用）或
+// 所有任务都阻塞时前进；设备事件（场景注入、模型应答）按时间排队，到点后在
+// 当前线程上以中断上下文执行。任务是主机线程，但同一时刻只有一个在运行，
+// 两个核各有一个虚拟时钟，每个核按FreeRTOS规则调度绑定在该核上的任务：
+// 就绪任务中优先级最高者运行，同优先级先就绪者先运行。
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+#define SIM_FOREVER UINT64_MAX
+
+// 运行参数（命令行）
+struct SimOptions {
+  bool quiet = false;
+  std::string sdDir;               // SD卡目录，空表示临时目录
+  std::string userDbImage;         // userdb分区镜像文件，空表示没有该分区
+  std::string reportJson;          // JSON报告文件
+  double cpuScale = 0;             // >0时把主机线程CPU时间乘以该系数计入虚拟时间
+  time_t epoch = 1704070800;       // NTP校时后的起始时间（2024-01-01 09:00 +08:00）
+  bool camera = false;             // 接入摄像头
+  std::vector<uint16_t> fingerprints = {1, 2, 3, 4, 5};   // 指纹模块中已录入的模板号
+};
+
+extern SimOptions simOptions;
+
+// ==================== 内核 ====================
+
+/**
+ * 当前虚拟时间(us)
+ */
+uint64_t sim_now();
+
+/**
+ * 创建定时器任务和入口任务并开始调度（不返回，结束时间到达后输出报告并退出进程）
+ * @param endUs 结束时间(us)
+ * @param entry 入口任务（核1，优先级1），NULL表示Arduino的loopTask（运行固件的 setup()/loop()）
+ */
+[[noreturn]] void sim_kernel_run(uint64_t endUs, void (*entry)(void *) = NULL);
+
+/**
+ * 安排设备事件（到点后以中断上下文执行）
+ * @param timeUs 时间(us)
+ * @param action 事件
+ */
+void sim_at(uint64_t timeUs, std::function<void()> action);
+
+/**
+ * 当前任务占用CPU一段时间（期间到点的设备事件照常执行，之后检查抢占）
+ * @param us 时长(us)
+ */
+void sim_busy(uint64_t us);
+
+/**
+ * 阻塞当前任务，直到对象被通知或到达唤醒时间（唤醒时间已过时只计一次查询开销）
+ * @param object 等待对象
+ * @param wakeAt 唤醒时间(us)，SIM_FOREVER表示不超时
+ * @return 是否被通知（false表示超时）
+ */
+bool sim_wait(const void *object, uint64_t wakeAt);
+
+/**
+ * 唤醒等待对象的任务（优先级最高者，all为true时全部）
+ * @param object 等待对象
+ * @param all 是否全部唤醒
+ * @return 是否唤醒了任务
+ */
+bool sim_notify(const void *object, bool all);
+
+/**
+ * 任务上下文中检查是否切换：本核有更高优先级的任务就绪，或另一核的时钟落后
+ * （中断上下文和临界区内不切换）
+ */
+void sim_preempt();
+
+/**
+ * 把等待对象上阻塞任务的唤醒时间提前（定时器任务用，避免为改期切换任务）
+ * @param object 等待对象
+ * @param wakeAt 唤醒时间(us)
+ */
+void sim_advance_wake(const void *object, uint64_t wakeAt);
+
+/**
+ * 按tick数计算唤醒时间
+ * @param ticks 节拍数（portMAX_DELAY表示不超时）
+ * @return 唤醒时间(us)
+ */
+uint64_t sim_wake_after(uint32_t ticks);
+
+/**
+ * 以中断上下文执行（从任务上下文触发时返回后检查抢占）
+ * @param isr 中断处理
+ */
+void sim_run_isr(const std::function<void()> &isr);
+
+/**
+ * 是否处于中断上下文
+ */
+bool sim_in_isr();
+
+/**
+ * 把主机线程CPU时间计入虚拟时间（-c 参数打开时）
+ */
+void sim_charge();
+
+/**
+ * millis()/micros() 忙等保护：虚拟时间不前进时连续调用多次后推进1us
+ */
+void sim_spin_guard();
+
+/**
+ * 当前任务名（没有任务时为"-"）
+ */
+const char *sim_task_name();
+
+// 任务统计（报告用）
+struct SimTaskStats {
+  std::string name;
+  unsigned priority;
+  int core;
+  uint64_t switches;
+  uint64_t timeouts;
+  uint64_t busyUs;
+};
+
+std::vector<SimTaskStats> sim_task_stats();
+
+// ==================== 设备 ====================
+
+/**
+ * 设备模型初始化（读卡器、指纹模块、键盘、门磁、继电器、摄像头）
+ */
+void sim_devices_init();
+
+/**
+ * 外部电路驱动输入引脚（电平变化时按引脚中断模式触发中断）
+ * @param pin 引脚
+ * @param level 电平，-1表示释放（由上拉/下拉决定）
+ */
+void sim_gpio_drive(uint8_t pin, int level);
+
+/**
+ * 读取引脚的输出电平（设备模型观察固件输出用），引脚不是输出时为-1
+ */
+int sim_gpio_output(uint8_t pin);
+
+/**
+ * 观察引脚输出（固件 digitalWrite 电平变化时回调）
+ */
+void sim_gpio_observe(uint8_t pin, std::function<void(int)> observer);
+
+/**
+ * LEDC输出变化（蜂鸣器）
+ */
+void sim_ledc_changed(uint8_t channel, double frequency);
+
+void sim_rfid_present(const uint8_t *uid, uint8_t size, uint64_t holdUs);
+void sim_fingerprint_touch(uint16_t id, uint64_t holdUs);
+void sim_fingerprint_uart(const uint8_t *data, size_t length, unsigned long baud);
+uint16_t sim_fingerprint_template_count();
+bool sim_fingerprint_delete(uint16_t id);
+void sim_fingerprint_clear();
+void sim_keypad_press(char key, uint64_t holdUs);
+void sim_camera_motion(bool on);
+
+// 控制台串口（Serial）
+void sim_console_write(const uint8_t *data, size_t length);
+void sim_console_inject(const std::string &line);
+
+// 网络
+void sim_wifi_set(bool up);
+void sim_mqtt_inject(const std::string &topic, const std::string &payload);
+
+// SD卡
+void sim_sd_init();
+void sim_sd_cleanup();
+
+// ==================== 场景与报告 ====================
+
+/**
+ * 记录一条可观察输出（控制台打印，并交给 expect/reject 检查）
+ * @param channel 通道：MQTT主题或 relay/buzzer/serial
+ * @param text 内容
+ */
+void sim_record(const std::string &channel, const std::string &text);
+
+/**
+ * 记录刺激（用于刺激→继电器吸合延迟统计）
+ * @param kind 类型：card/finger/pin/mqtt
+ */
+void sim_stimulus(const char *kind);
+
+/**
+ * 继电器吸合（结束最近一次刺激的延迟计时）
+ */
+void sim_relay_on();
+
+/**
+ * 统计MQTT发布
+ */
+void sim_mqtt_count(const std::string &topic, size_t bytes);
+
+/**
+ * 控制台输出（带虚拟时间前缀，-q 时不输出）
+ */
+void sim_printf(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+/**
+ * 读取场景文件并安排事件
+ * @param path 场景文件
+ * @return 结束时间(us)，0表示出错
+ */
+uint64_t sim_scenario_load(const char *path);
+
+/**
+ * 输出报告并退出进程（退出码：期望全部满足为0，否则为1）
+ */
+[[noreturn]] void sim_finish();
+
+#endif
@@ -0,0 +1,199 @@
+// 主机仿真：mbedtls 中固件用到的 SHA-256 与 Base64 解码（行为与 mbedtls 2.x 一致）
+
+#include <string.h>
+#include "mbedtls/sha256.h"
+#include "mbedtls/base64.h"
+#include "sim.h"
+
+// ESP32硬件SHA约每64字节块1us
+#define SIM_SHA256_BLOCK_US 1
+
+static const uint32_t simSha256K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static inline uint32_t sim_ror(uint32_t x, int n) {
+  return (x >> n) | (x << (32 - n));
+}
+
+static void sim_sha256_block(mbedtls_sha256_context *ctx, const unsigned char *data) {
+  uint32_t w[64];
+  for (int i = 0; i < 16; i++) {
+    w[i] = ((uint32_t)data[i * 4] << 24) | ((uint32_t)data[i * 4 + 1] << 16) | ((uint32_t)data[i * 4 + 2] << 8) |
+           data[i * 4 + 3];
+  }
+  for (int i = 16; i < 64; i++) {
+    uint32_t s0 = sim_ror(w[i - 15], 7) ^ sim_ror(w[i - 15], 18) ^ (w[i - 15] >> 3);
+    uint32_t s1 = sim_ror(w[i - 2], 17) ^ sim_ror(w[i - 2], 19) ^ (w[i - 2] >> 10);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+
+  uint32_t a = ctx->state[0], b = ctx->state[1], c = ctx->state[2], d = ctx->state[3];
+  uint32_t e = ctx->state[4], f = ctx->state[5], g = ctx->state[6], h = ctx->state[7];
+  for (int i = 0; i < 64; i++) {
+    uint32_t s1 = sim_ror(e, 6) ^ sim_ror(e, 11) ^ sim_ror(e, 25);
+    uint32_t ch = (e & f) ^ (~e & g);
+    uint32_t t1 = h + s1 + ch + simSha256K[i] + w[i];
+    uint32_t s0 = sim_ror(a, 2) ^ sim_ror(a, 13) ^ sim_ror(a, 22);
+    uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+    uint32_t t2 = s0 + maj;
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+  ctx->state[0] += a;
+  ctx->state[1] += b;
+  ctx->state[2] += c;
+  ctx->state[3] += d;
+  ctx->state[4] += e;
+  ctx->state[5] += f;
+  ctx->state[6] += g;
+  ctx->state[7] += h;
+}
+
+void mbedtls_sha256_init(mbedtls_sha256_context *ctx) {
+  memset(ctx, 0, sizeof(*ctx));
+}
+
+void mbedtls_sha256_free(mbedtls_sha256_context *ctx) {
+  memset(ctx, 0, sizeof(*ctx));
+}
+
+int mbedtls_sha256_starts_ret(mbedtls_sha256_context *ctx, int is224) {
+  static const uint32_t initial[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                      0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+  static const uint32_t initial224[8] = {0xc1059ed8, 0x367cd507, 0x3070dd17, 0xf70e5939,
+                                         0xffc00b31, 0x68581511, 0x64f98fa7, 0xbefa4fa4};
+  ctx->total[0] = 0;
+  ctx->total[1] = 0;
+  memcpy(ctx->state, is224 ? initial224 : initial, sizeof(ctx->state));
+  ctx->is224 = is224;
+  return 0;
+}
+
+int mbedtls_sha256_update_ret(mbedtls_sha256_context *ctx, const unsigned char *input, size_t length) {
+  size_t fill = ctx->total[0] & 0x3F;
+  ctx->total[0] += (uint32_t)length;
+  if (ctx->total[0] < (uint32_t)length) {
+    ctx->total[1]++;
+  }
+  sim_busy((fill + length) / 64 * SIM_SHA256_BLOCK_US);
+
+  if (fill && fill + length >= 64) {
+    memcpy(ctx->buffer + fill, input, 64 - fill);
+    sim_sha256_block(ctx, ctx->buffer);
+    input += 64 - fill;
+    length -= 64 - fill;
+    fill = 0;
+  }
+  while (length >= 64) {
+    sim_sha256_block(ctx, input);
+    input += 64;
+    length -= 64;
+  }
+  if (length) {
+    memcpy(ctx->buffer + fill, input, length);
+  }
+  return 0;
+}
+
+int mbedtls_sha256_finish_ret(mbedtls_sha256_context *ctx, unsigned char output[32]) {
+  uint64_t bits = ((uint64_t)ctx->total[1] << 32 | ctx->total[0]) * 8;
+  unsigned char padding[72] = {0x80};
+  size_t used = ctx->total[0] & 0x3F;
+  size_t padLength = used < 56 ? 56 - used : 120 - used;
+  for (int i = 0; i < 8; i++) {
+    padding[padLength + i] = (unsigned char)(bits >> (56 - i * 8));
+  }
+  mbedtls_sha256_update_ret(ctx, padding, padLength + 8);
+
+  for (int i = 0; i < (ctx->is224 ? 7 : 8); i++) {
+    output[i * 4] = ctx->state[i] >> 24;
+    output[i * 4 + 1] = ctx->state[i] >> 16;
+    output[i * 4 + 2] = ctx->state[i] >> 8;
+    output[i * 4 + 3] = ctx->state[i];
+  }
+  return 0;
+}
+
+static int sim_base64_value(unsigned char c) {
+  if (c >= 'A' && c <= 'Z') {
+    return c - 'A';
+  }
+  if (c >= 'a' && c <= 'z') {
+    return c - 'a' + 26;
+  }
+  if (c >= '0' && c <= '9') {
+    return c - '0' + 52;
+  }
+  if (c == '+') {
+    return 62;
+  }
+  if (c == '/') {
+    return 63;
+  }
+  return -1;
+}
+
+int mbedtls_base64_decode(unsigned char *dst, size_t dlen, size_t *olen, const unsigned char *src, size_t slen) {
+  // 第一遍：校验字符并计算输出长度（跳过空白和换行，'=' 只能出现在末尾且最多两个）
+  size_t count = 0;
+  size_t padding = 0;
+  for (size_t i = 0; i < slen; i++) {
+    unsigned char c = src[i];
+    if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+      continue;
+    }
+    if (c == '=') {
+      if (++padding > 2) {
+        return MBEDTLS_ERR_BASE64_INVALID_CHARACTER;
+      }
+    } else if (padding || sim_base64_value(c) < 0) {
+      return MBEDTLS_ERR_BASE64_INVALID_CHARACTER;
+    }
+    count++;
+  }
+  if (count == 0) {
+    *olen = 0;
+    return 0;
+  }
+  if (count % 4) {
+    return MBEDTLS_ERR_BASE64_INVALID_CHARACTER;
+  }
+
+  size_t needed = count / 4 * 3 - padding;
+  if (!dst || dlen < needed) {
+    *olen = needed;
+    return MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL;
+  }
+
+  uint32_t accumulator = 0;
+  size_t bits = 0;
+  size_t written = 0;
+  for (size_t i = 0; i < slen; i++) {
+    int value = sim_base64_value(src[i]);
+    if (value < 0) {
+      continue;
+    }
+    accumulator = (accumulator << 6) | value;
+    bits += 6;
+    if (bits >= 8) {
+      bits -= 8;
+      dst[written++] = (unsigned char)(accumulator >> bits);
+    }
+  }
+  *olen = written;
+  return 0;
+}
@@ -0,0 +1,734 @@
+// 主机仿真：外设模型（继电器、蜂鸣器、读卡器、指纹模块、矩阵键盘、摄像头）
+// 各模型的时间参数取自器件手册的典型值，只用于得到量级正确、可复现的延迟
+
+#include <Arduino.h>
+#include <MFRC522.h>
+#include <Adafruit_Fingerprint.h>
+#include <map>
+#include "esp_camera.h"
+#include "img_converters.h"
+#include "drivers/fingerprint_protocol.h"
+#include "sim.h"
+
+#define SIM_RELAY_PIN          13
+#define SIM_TOUCH_PIN          14
+
+// ==================== 继电器、蜂鸣器 ====================
+
+void sim_ledc_changed(uint8_t channel, double frequency) {
+  (void)channel;
+  char text[32];
+  if (frequency > 0) {
+    snprintf(text, sizeof(text), "%.0f Hz", frequency);
+  } else {
+    snprintf(text, sizeof(text), "off");
+  }
+  sim_record("buzzer", text);
+}
+
+// ==================== 读卡器 ====================
+
+// MFRC522：SPI 4MHz，一次寄存器访问约10us；寻卡（REQA）收到应答约150us，
+// 防冲突+选卡约1.5ms；定时器按PCD_Init的设置为40kHz
+#define SIM_RFID_REGISTER_US   10
+#define SIM_RFID_REQUEST_US    60
+#define SIM_RFID_ANSWER_US     150
+#define SIM_RFID_SELECT_US     1500
+#define SIM_RFID_INIT_US       50000
+#define SIM_RFID_TICK_US       25
+
+static struct {
+  uint8_t uid[10];
+  uint8_t size;
+  bool present;
+  bool halted;
+  uint32_t generation;
+} simCard;
+
+void sim_rfid_present(const uint8_t *uid, uint8_t size, uint64_t holdUs) {
+  uint32_t generation = ++simCard.generation;
+  memcpy(simCard.uid, uid, size);
+  simCard.size = size;
+  simCard.present = true;
+  simCard.halted = false;
+  sim_stimulus("card");
+  sim_at(sim_now() + holdUs, [generation] {
+    if (simCard.generation == generation) {
+      simCard.present = false;
+    }
+  });
+}
+
+MFRC522::MFRC522(byte chipSelectPin, byte resetPowerDownPin) {
+  (void)chipSelectPin;
+  (void)resetPowerDownPin;
+  memset(registers_, 0, sizeof(registers_));
+  memset(&uid, 0, sizeof(uid));
+}
+
+void MFRC522::PCD_Init() {
+  sim_busy(SIM_RFID_INIT_US);
+  PCD_Reset();
+  // 与原库一致：定时器40kHz，重装值1000（25ms）
+  registers_[TModeReg >> 1] = 0x80;
+  registers_[TPrescalerReg >> 1] = 0xA9;
+  registers_[TReloadRegH >> 1] = 0x03;
+  registers_[TReloadRegL >> 1] = 0xE8;
+  registers_[TxASKReg >> 1] = 0x40;
+  registers_[ModeReg >> 1] = 0x3D;
+}
+
+void MFRC522::PCD_Reset() {
+  memset(registers_, 0, sizeof(registers_));
+  registers_[RFCfgReg >> 1] = 0x48;
+  registers_[VersionReg >> 1] = 0x92;
+}
+
+byte MFRC522::PCD_ReadRegister(PCD_Register reg) {
+  sim_busy(SIM_RFID_REGISTER_US);
+  return registers_[reg >> 1];
+}
+
+void MFRC522::PCD_WriteRegister(PCD_Register reg, byte value) {
+  sim_busy(SIM_RFID_REGISTER_US);
+  registers_[reg >> 1] = value;
+}
+
+void MFRC522::PCD_SetAntennaGain(byte mask) {
+  if (PCD_GetAntennaGain() != (mask & (0x07 << 4))) {
+    byte value = (registers_[RFCfgReg >> 1] & ~(0x07 << 4)) | (mask & (0x07 << 4));
+    PCD_WriteRegister(RFCfgReg, value);
+  }
+}
+
+byte MFRC522::PCD_GetAntennaGain() {
+  return PCD_ReadRegister(RFCfgReg) & (0x07 << 4);
+}
+
+bool MFRC522::PCD_PerformSelfTest() {
+  sim_busy(30000);
+  return true;
+}
+
+void MFRC522::PCD_StopCrypto1() {
+  sim_busy(SIM_RFID_REGISTER_US * 2);
+}
+
+uint32_t MFRC522::timeout_us() const {
+  uint32_t reload = ((uint32_t)registers_[TReloadRegH >> 1] << 8) | registers_[TReloadRegL >> 1];
+  return reload * SIM_RFID_TICK_US;
+}
+
+bool MFRC522::PICC_IsNewCardPresent() {
+  sim_busy(SIM_RFID_REQUEST_US);
+  if (simCard.present && !simCard.halted) {
+    sim_busy(SIM_RFID_ANSWER_US);
+    return true;
+  }
+  // 无应答：等读卡器定时器超时
+  sim_busy(timeout_us());
+  return false;
+}
+
+bool MFRC522::PICC_ReadCardSerial() {
+  if (!simCard.present || simCard.halted) {
+    sim_busy(timeout_us());
+    return false;
+  }
+  sim_busy(SIM_RFID_SELECT_US);
+  uid.size = simCard.size;
+  memcpy(uid.uidByte, simCard.uid, simCard.size);
+  uid.sak = 0x08;
+  return true;
+}
+
+MFRC522::StatusCode MFRC522::PICC_HaltA() {
+  // 卡片收到HLTA后不应答，原库按超时判定成功
+  sim_busy(SIM_RFID_REQUEST_US + timeout_us());
+  if (simCard.present) {
+    simCard.halted = true;
+  }
+  return STATUS_OK;
+}
+
+MFRC522::PICC_Type MFRC522::PICC_GetType(byte sak) {
+  switch (sak & 0x7F) {
+    case 0x04:
+      return PICC_TYPE_NOT_COMPLETE;
+    case 0x09:
+      return PICC_TYPE_MIFARE_MINI;
+    case 0x08:
+      return PICC_TYPE_MIFARE_1K;
+    case 0x18:
+      return PICC_TYPE_MIFARE_4K;
+    case 0x00:
+      return PICC_TYPE_MIFARE_UL;
+    case 0x10:
+    case 0x11:
+      return PICC_TYPE_MIFARE_PLUS;
+    case 0x01:
+      return PICC_TYPE_TNP3XXX;
+    case 0x20:
+      return PICC_TYPE_ISO_14443_4;
+    case 0x40:
+      return PICC_TYPE_ISO_18092;
+    default:
+      return PICC_TYPE_UNKNOWN;
+  }
+}
+
+// ==================== 指纹模块 ====================
+
+// R30x系列：出厂57600波特，采集图像（有手指）约60ms，生成特征约45ms，1:N搜索约35ms
+#define SIM_FINGER_FACTORY_BAUD  57600
+#define SIM_FINGER_CAPACITY      300
+#define SIM_FINGER_PACKET_CODE   2          // 数据包128字节
+#define SIM_FINGER_TEMPLATE_SIZE 512
+#define SIM_FINGER_NONE          0xFFFF
+
+static struct {
+  unsigned long baud = SIM_FINGER_FACTORY_BAUD;
+  FingerprintParser parser;
+  std::map<uint16_t, uint16_t> pages;      // 模板号 → 手指
+  uint16_t finger = SIM_FINGER_NONE;       // 按在传感器上的手指
+  uint32_t generation = 0;
+  uint16_t image = SIM_FINGER_NONE;        // 图像缓冲区
+  uint16_t chars[3] = {SIM_FINGER_NONE, SIM_FINGER_NONE, SIM_FINGER_NONE};   // 特征缓冲区1、2
+  bool downloading = false;
+  uint8_t downloadBuffer = 1;
+  std::string download;
+  uint64_t busyUntil = 0;                  // 模块处理完已收到指令的时间
+} simFinger;
+
+static uint64_t sim_uart_time(size_t bytes, unsigned long baud) {
+  return (uint64_t)bytes * 10 * 1000000 / baud;
+}
+
+static uint64_t sim_finger_processing_us(uint8_t command) {
+  switch (command) {
+    case FINGERPRINT_CMD_GEN_IMAGE:
+      return simFinger.finger != SIM_FINGER_NONE ? 60000 : 25000;
+    case FINGERPRINT_CMD_IMAGE_TO_TZ:
+      return 45000;
+    case FINGERPRINT_CMD_SEARCH:
+    case FINGERPRINT_CMD_HIGH_SPEED_SEARCH:
+      return 35000;
+    case FINGERPRINT_CMD_REG_MODEL:
+      return 30000;
+    case FINGERPRINT_CMD_STORE:
+      return 25000;
+    case FINGERPRINT_CMD_LOAD_CHAR:
+      return 10000;
+    default:
+      return 2000;
+  }
+}
+
+static void sim_finger_append(std::string &out, uint8_t pid, const uint8_t *content, uint16_t length) {
+  uint8_t packet[FINGERPRINT_MAX_PACKET];
+  size_t size = fingerprint_packet_encode(pid, content, length, packet, sizeof(packet));
+  out.append((const char *)packet, size);
+}
+
+/**
+ * 执行指令并生成应答（在处理完成时刻调用，按当时的手指状态）
+ */
+static std::string sim_finger_execute(const FingerprintPacket &command) {
+  uint8_t reply[20] = {FINGERPRINT_ACK_OK};
+  uint16_t length = 1;
+  std::string out;
+  uint8_t code = command.content[0];
+  uint8_t buffer = command.length > 1 && command.content[1] == 2 ? 2 : 1;
+
+  switch (code) {
+    case FINGERPRINT_CMD_GEN_IMAGE:
+      if (simFinger.finger == SIM_FINGER_NONE) {
+        reply[0] = FINGERPRINT_ACK_NO_FINGER;
+      } else {
+        simFinger.image = simFinger.finger;
+      }
+      break;
+
+    case FINGERPRINT_CMD_IMAGE_TO_TZ:
+      simFinger.chars[buffer] = simFinger.image;
+      break;
+
+    case FINGERPRINT_CMD_SEARCH:
+    case FINGERPRINT_CMD_HIGH_SPEED_SEARCH: {
+      reply[0] = FINGERPRINT_ACK_NOT_FOUND;
+      length = 5;
+      for (auto &page : simFinger.pages) {
+        if (page.second == simFinger.chars[buffer] && simFinger.chars[buffer] != 0) {
+          reply[0] = FINGERPRINT_ACK_OK;
+          reply[1] = page.first >> 8;
+          reply[2] = page.first & 0xFF;
+          reply[4] = 100;
+          break;
+        }
+      }
+      break;
+    }
+
+    case FINGERPRINT_CMD_REG_MODEL:
+      if (simFinger.chars[1] != simFinger.chars[2]) {
+        reply[0] = FINGERPRINT_ACK_MISMATCH;
+      }
+      break;
+
+    case FINGERPRINT_CMD_STORE: {
+      uint16_t page = (command.content[2] << 8) | command.content[3];
+      if (page >= SIM_FINGER_CAPACITY) {
+        reply[0] = FINGERPRINT_BADLOCATION;
+      } else {
+        simFinger.pages[page] = simFinger.chars[buffer];
+      }
+      break;
+    }
+
+    case FINGERPRINT_CMD_LOAD_CHAR: {
+      uint16_t page = (command.content[2] << 8) | command.content[3];
+      auto it = simFinger.pages.find(page);
+      if (it == simFinger.pages.end()) {
+        reply[0] = FINGERPRINT_ACK_EMPTY_PAGE;
+      } else {
+        simFinger.chars[buffer] = it->second;
+      }
+      break;
+    }
+
+    case FINGERPRINT_CMD_UP_CHAR: {
+      sim_finger_append(out, FINGERPRINT_PID_ACK, reply, 1);
+      // 模板：前两个字节为手指编号，其余为固定图案
+      uint8_t data[SIM_FINGER_TEMPLATE_SIZE];
+      for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)(i * 7 + 3);
+      }
+      data[0] = simFinger.chars[buffer] >> 8;
+      data[1] = simFinger.chars[buffer] & 0xFF;
+      uint16_t packetSize = 32 << SIM_FINGER_PACKET_CODE;
+      for (uint16_t sent = 0; sent < sizeof(data); sent += packetSize) {
+        uint8_t pid = sent + packetSize >= sizeof(data) ? FINGERPRINT_PID_END : FINGERPRINT_PID_DATA;
+        sim_finger_append(out, pid, data + sent, packetSize);
+      }
+      return out;
+    }
+
+    case FINGERPRINT_CMD_DOWN_CHAR:
+      break;
+
+    case FINGERPRINT_CMD_SET_SYS_PARA:
+      if (command.length < 3 || command.content[1] != FINGERPRINT_PARAM_BAUD || command.content[2] < 1 ||
+          command.content[2] > FINGERPRINT_BAUD_MAX_N) {
+        reply[0] = FINGERPRINT_ACK_PACKET_ERROR;
+      }
+      break;
+
+    case FINGERPRINT_CMD_READ_SYS_PARA:
+      length = 17;
+      reply[5] = SIM_FINGER_CAPACITY >> 8;
+      reply[6] = SIM_FINGER_CAPACITY & 0xFF;
+      reply[8] = 3;
+      memset(reply + 9, 0xFF, 4);
+      reply[14] = SIM_FINGER_PACKET_CODE;
+      reply[16] = (uint8_t)(simFinger.baud / FINGERPRINT_BAUD_UNIT);
+      break;
+
+    case FINGERPRINT_CMD_VERIFY_PASSWORD:
+      break;
+
+    case FINGERPRINT_CMD_TEMPLATE_COUNT:
+      length = 3;
+      reply[1] = simFinger.pages.size() >> 8;
+      reply[2] = simFinger.pages.size() & 0xFF;
+      break;
+
+    default:
+      reply[0] = FINGERPRINT_ACK_PACKET_ERROR;
+      break;
+  }
+
+  sim_finger_append(out, FINGERPRINT_PID_ACK, reply, length);
+  return out;
+}
+
+/**
+ * 收到一条指令：排在已收到的指令之后处理，处理完成后按当前波特率回送应答
+ */
+static void sim_finger_command(const FingerprintPacket &command, uint64_t arrivedAt) {
+  uint64_t start = arrivedAt > simFinger.busyUntil ? arrivedAt : simFinger.busyUntil;
+  uint64_t done = start + sim_finger_processing_us(command.content[0]);
+  simFinger.busyUntil = done;
+
+  sim_at(done, [command] {
+    std::string reply = sim_finger_execute(command);
+    unsigned long baud = simFinger.baud;
+    uint64_t deliverAt = sim_now() + sim_uart_time(reply.size(), baud);
+    if (deliverAt > simFinger.busyUntil) {
+      simFinger.busyUntil = deliverAt;
+    }
+    sim_at(deliverAt, [reply] { Serial2.sim_receive((const uint8_t *)reply.data(), reply.size()); });
+
+    // 修改波特率的应答按原波特率发送，之后切换
+    if (command.content[0] == FINGERPRINT_CMD_SET_SYS_PARA && command.length >= 3 &&
+        command.content[1] == FINGERPRINT_PARAM_BAUD && command.content[2] >= 1 &&
+        command.content[2] <= FINGERPRINT_BAUD_MAX_N) {
+      unsigned long newBaud = command.content[2] * FINGERPRINT_BAUD_UNIT;
+      sim_at(deliverAt, [newBaud] { simFinger.baud = newBaud; });
+    }
+  });
+}
+
+void sim_fingerprint_uart(const uint8_t *data, size_t length, unsigned long baud) {
+  if (baud != simFinger.baud) {
+    // 波特率不一致，模块收到的是乱码
+    fingerprint_parser_reset(&simFinger.parser);
+    return;
+  }
+
+  uint64_t arrivedAt = sim_now() + sim_uart_time(length, baud);
+  for (size_t i = 0; i < length; i++) {
+    int result = fingerprint_parser_feed(&simFinger.parser, data[i]);
+    if (result < 0) {
+      fingerprint_parser_reset(&simFinger.parser);
+      continue;
+    }
+    if (result == 0) {
+      continue;
+    }
+
+    const FingerprintPacket &packet = simFinger.parser.packet;
+    if (packet.pid == FINGERPRINT_PID_COMMAND && packet.length >= 1) {
+      if (packet.content[0] == FINGERPRINT_CMD_DOWN_CHAR) {
+        simFinger.downloading = true;
+        simFinger.downloadBuffer = packet.length > 1 && packet.content[1] == 2 ? 2 : 1;
+        simFinger.download.clear();
+      }
+      sim_finger_command(packet, arrivedAt);
+    } else if (simFinger.downloading &&
+               (packet.pid == FINGERPRINT_PID_DATA || packet.pid == FINGERPRINT_PID_END)) {
+      simFinger.download.append((const char *)packet.content, packet.length);
+      if (packet.pid == FINGERPRINT_PID_END) {
+        simFinger.downloading = false;
+        if (simFinger.download.size() >= 2) {
+          simFinger.chars[simFinger.downloadBuffer] =
+              ((uint8_t)simFinger.download[0] << 8) | (uint8_t)simFinger.download[1];
+        }
+      }
+    }
+    fingerprint_parser_reset(&simFinger.parser);
+  }
+}
+
+void sim_fingerprint_touch(uint16_t id, uint64_t holdUs) {
+  uint32_t generation = ++simFinger.generation;
+  simFinger.finger = id;
+  sim_stimulus("finger");
+  sim_gpio_drive(SIM_TOUCH_PIN, HIGH);
+  sim_at(sim_now() + holdUs, [generation] {
+    if (simFinger.generation == generation) {
+      simFinger.finger = SIM_FINGER_NONE;
+      sim_gpio_drive(SIM_TOUCH_PIN, LOW);
+    }
+  });
+}
+
+uint16_t sim_fingerprint_template_count() {
+  return simFinger.pages.size();
+}
+
+bool sim_fingerprint_delete(uint16_t id) {
+  return simFinger.pages.erase(id) > 0;
+}
+
+void sim_fingerprint_clear() {
+  simFinger.pages.clear();
+}
+
+// Adafruit库的管理接口直接访问模块模型，按一次串口往返计时
+static void sim_finger_roundtrip(HardwareSerial *serial) {
+  sim_busy(sim_uart_time(12 + 12, serial->baudRate()) + 2000);
+}
+
+Adafruit_Fingerprint::Adafruit_Fingerprint(HardwareSerial *serial, uint32_t password) : serial_(serial) {
+  (void)password;
+}
+
+void Adafruit_Fingerprint::begin(uint32_t baud) {
+  serial_->begin(baud);
+}
+
+bool Adafruit_Fingerprint::verifyPassword() {
+  sim_finger_roundtrip(serial_);
+  return serial_->baudRate() == simFinger.baud;
+}
+
+uint8_t Adafruit_Fingerprint::getTemplateCount() {
+  sim_finger_roundtrip(serial_);
+  templateCount = sim_fingerprint_template_count();
+  return FINGERPRINT_OK;
+}
+
+uint8_t Adafruit_Fingerprint::deleteModel(uint16_t id) {
+  sim_finger_roundtrip(serial_);
+  sim_fingerprint_delete(id);
+  return FINGERPRINT_OK;
+}
+
+uint8_t Adafruit_Fingerprint::emptyDatabase() {
+  sim_finger_roundtrip(serial_);
+  sim_fingerprint_clear();
+  return FINGERPRINT_OK;
+}
+
+// ==================== 矩阵键盘 ====================
+
+static const uint8_t simKeypadRows[4] = {25, 26, 27, 32};
+static const uint8_t simKeypadCols[4] = {33, 2, 0, 4};
+static const char simKeymap[4][4] = {
+    {'1', '2', '3', 'A'},
+    {'4', '5', '6', 'B'},
+    {'7', '8', '9', 'C'},
+    {'*', '0', '#', 'D'},
+};
+static bool simKeyDown[4][4];
+static uint32_t simKeyGeneration[4][4];
+
+/**
+ * 按键把所在行、列接通：某列上有按下的键且该键的行输出低电平时列为低，否则由上拉保持高
+ */
+static void sim_keypad_update() {
+  for (int c = 0; c < 4; c++) {
+    bool low = false;
+    for (int r = 0; r < 4; r++) {
+      if (simKeyDown[r][c] && sim_gpio_output(simKeypadRows[r]) == LOW) {
+        low = true;
+      }
+    }
+    sim_gpio_drive(simKeypadCols[c], low ? LOW : -1);
+  }
+}
+
+void sim_keypad_press(char key, uint64_t holdUs) {
+  for (int r = 0; r < 4; r++) {
+    for (int c = 0; c < 4; c++) {
+      if (simKeymap[r][c] != key) {
+        continue;
+      }
+      uint32_t generation = ++simKeyGeneration[r][c];
+      simKeyDown[r][c] = true;
+      if (key == '#') {
+        sim_stimulus("pin");
+      }
+      sim_keypad_update();
+      sim_at(sim_now() + holdUs, [r, c, generation] {
+        if (simKeyGeneration[r][c] == generation) {
+          simKeyDown[r][c] = false;
+          sim_keypad_update();
+        }
+      });
+      return;
+    }
+  }
+}
+
+// ==================== 摄像头 ====================
+
+// OV2640：QVGA及以下25fps，JPEG约为像素数的1/10字节；解码按约40像素/us计
+#define SIM_CAMERA_FRAME_US    40000
+#define SIM_CAMERA_INIT_US     120000
+#define SIM_CAMERA_BLOCK       16
+
+struct SimFrame {
+  camera_fb_t fb;
+  std::vector<uint8_t> data;
+  bool inUse;
+};
+
+static const struct {
+  uint16_t width;
+  uint16_t height;
+} simFrameSizes[] = {
+    {96, 96}, {160, 120}, {176, 144}, {240, 176}, {240, 240}, {320, 240}, {400, 296},
+    {480, 320}, {640, 480}, {800, 600}, {1024, 768}, {1280, 720}, {1280, 1024}, {1600, 1200},
+};
+
+static struct {
+  bool initialized;
+  std::vector<SimFrame *> frames;
+  framesize_t frameSize;
+  pixformat_t format;
+  uint64_t lastFrame;           // 上次取出的帧序号
+  bool motion;
+  sensor_t sensor;
+} simCamera;
+
+static int sim_camera_set_framesize(sensor_t *sensor, framesize_t frameSize) {
+  (void)sensor;
+  if (frameSize >= FRAMESIZE_INVALID) {
+    return -1;
+  }
+  simCamera.frameSize = frameSize;
+  return 0;
+}
+
+static int sim_camera_set_pixformat(sensor_t *sensor, pixformat_t format) {
+  (void)sensor;
+  simCamera.format = format;
+  return 0;
+}
+
+static int sim_camera_set_quality(sensor_t *sensor, int quality) {
+  (void)sensor;
+  (void)quality;
+  return 0;
+}
+
+esp_err_t esp_camera_init(const camera_config_t *config) {
+  sim_busy(SIM_CAMERA_INIT_US);
+  if (!simOptions.camera) {
+    // 未接摄像头：探测不到传感器
+    return ESP_ERR_NOT_FOUND;
+  }
+  if (simCamera.initialized) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  simCamera.frameSize = config->frame_size;
+  simCamera.format = config->pixel_format;
+  for (size_t i = 0; i < config->fb_count; i++) {
+    simCamera.frames.push_back(new SimFrame());
+  }
+  simCamera.sensor.set_framesize = sim_camera_set_framesize;
+  simCamera.sensor.set_pixformat = sim_camera_set_pixformat;
+  simCamera.sensor.set_quality = sim_camera_set_quality;
+  simCamera.lastFrame = sim_now() / SIM_CAMERA_FRAME_US;
+  simCamera.initialized = true;
+  return ESP_OK;
+}
+
+esp_err_t esp_camera_deinit() {
+  for (SimFrame *frame : simCamera.frames) {
+    delete frame;
+  }
+  simCamera.frames.clear();
+  simCamera.initialized = false;
+  return ESP_OK;
+}
+
+sensor_t *esp_camera_sensor_get() {
+  return simCamera.initialized ? &simCamera.sensor : NULL;
+}
+
+camera_fb_t *esp_camera_fb_get() {
+  if (!simCamera.initialized) {
+    return NULL;
+  }
+  SimFrame *frame = NULL;
+  for (SimFrame *candidate : simCamera.frames) {
+    if (!candidate->inUse) {
+      frame = candidate;
+      break;
+    }
+  }
+  if (!frame) {
+    return NULL;
+  }
+
+  // 取最新一帧；上次之后还没有新帧时等下一帧
+  uint64_t index = sim_now() / SIM_CAMERA_FRAME_US;
+  if (index <= simCamera.lastFrame) {
+    index = simCamera.lastFrame + 1;
+    sim_wait(&simCamera, index * SIM_CAMERA_FRAME_US);
+  }
+  simCamera.lastFrame = index;
+
+  uint16_t width = simFrameSizes[simCamera.frameSize].width;
+  uint16_t height = simFrameSizes[simCamera.frameSize].height;
+  size_t length = (size_t)width * height / 10;
+  frame->data.assign(length, 0);
+  for (size_t i = 11; i + 2 < length; i++) {
+    frame->data[i] = (uint8_t)(i * 31 + index);
+  }
+  // 帧头：SOI、帧序号、运动标志、宽高；帧尾：EOI
+  frame->data[0] = 0xFF;
+  frame->data[1] = 0xD8;
+  frame->data[2] = index >> 24;
+  frame->data[3] = index >> 16;
+  frame->data[4] = index >> 8;
+  frame->data[5] = index;
+  frame->data[6] = simCamera.motion;
+  frame->data[7] = width >> 8;
+  frame->data[8] = width;
+  frame->data[9] = height >> 8;
+  frame->data[10] = height;
+  frame->data[length - 2] = 0xFF;
+  frame->data[length - 1] = 0xD9;
+
+  uint64_t capturedAt = index * SIM_CAMERA_FRAME_US;
+  frame->fb.buf = frame->data.data();
+  frame->fb.len = length;
+  frame->fb.width = width;
+  frame->fb.height = height;
+  frame->fb.format = PIXFORMAT_JPEG;
+  frame->fb.timestamp.tv_sec = capturedAt / 1000000;
+  frame->fb.timestamp.tv_usec = capturedAt % 1000000;
+  frame->inUse = true;
+  return &frame->fb;
+}
+
+void esp_camera_fb_return(camera_fb_t *fb) {
+  for (SimFrame *frame : simCamera.frames) {
+    if (&frame->fb == fb) {
+      frame->inUse = false;
+    }
+  }
+}
+
+bool jpg2rgb565(const uint8_t *src, size_t srcLength, uint8_t *out, jpg_scale_t scale) {
+  if (srcLength < 13 || src[0] != 0xFF || src[1] != 0xD8) {
+    return false;
+  }
+  uint32_t index = ((uint32_t)src[2] << 24) | ((uint32_t)src[3] << 16) | (src[4] << 8) | src[5];
+  bool motion = src[6];
+  size_t width = ((src[7] << 8) | src[8]) >> scale;
+  size_t height = ((src[9] << 8) | src[10]) >> scale;
+  sim_busy((width << scale) * (height << scale) / 40);
+
+  // 灰色背景；有运动时一个白色方块随帧序号水平移动
+  size_t block = SIM_CAMERA_BLOCK >> scale;
+  size_t span = width > block ? width - block : 1;
+  size_t blockX = motion ? (index * 8 >> scale) % span : 0;
+  size_t blockY = height / 2;
+  for (size_t y = 0; y < height; y++) {
+    for (size_t x = 0; x < width; x++) {
+      bool white = motion && x >= blockX && x < blockX + block && y >= blockY && y < blockY + block;
+      uint16_t pixel = white ? 0xFFFF : 0x8410;
+      out[(y * width + x) * 2] = pixel >> 8;
+      out[(y * width + x) * 2 + 1] = pixel & 0xFF;
+    }
+  }
+  return true;
+}
+
+void sim_camera_motion(bool on) {
+  simCamera.motion = on;
+}
+
+// ==================== 初始化 ====================
+
+void sim_devices_init() {
+  fingerprint_parser_reset(&simFinger.parser);
+  for (uint16_t id : simOptions.fingerprints) {
+    simFinger.pages[id] = id;
+  }
+  sim_gpio_drive(SIM_TOUCH_PIN, LOW);
+
+  sim_gpio_observe(SIM_RELAY_PIN, [](int level) {
+    sim_record("relay", level ? "on" : "off");
+    if (level) {
+      sim_relay_on();
+    }
+  });
+  for (uint8_t row : simKeypadRows) {
+    sim_gpio_observe(row, [](int) { sim_keypad_update(); });
+  }
+}
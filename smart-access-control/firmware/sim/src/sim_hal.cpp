@@ -0,0 +1,443 @@
+// 主机仿真：Arduino核心与ESP-IDF基础接口（时间、GPIO、LEDC、串口、堆、分区、NTP）
+
+#include <Arduino.h>
+#include <SPI.h>
+#include "esp_partition.h"
+#include "esp_spi_flash.h"
+#include "sim.h"
+
+HardwareSerial Serial(0);
+HardwareSerial Serial1(1);
+HardwareSerial Serial2(2);
+EspClass ESP;
+SPIClass SPI;
+
+// ==================== 时间 ====================
+
+unsigned long millis() {
+  sim_charge();
+  sim_spin_guard();
+  return (unsigned long)(sim_now() / 1000);
+}
+
+unsigned long micros() {
+  sim_charge();
+  sim_spin_guard();
+  return (unsigned long)sim_now();
+}
+
+void delay(uint32_t ms) {
+  vTaskDelay(ms / portTICK_PERIOD_MS);
+}
+
+void delayMicroseconds(uint32_t us) {
+  sim_busy(us);
+}
+
+uint32_t EspClass::getCycleCount() {
+  sim_charge();
+  sim_spin_guard();
+  return (uint32_t)(sim_now() * getCpuFreqMHz());
+}
+
+uint32_t EspClass::getFreeHeap() {
+  return heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+}
+
+void EspClass::restart() {
+  sim_record("serial", "ESP.restart()");
+  sim_finish();
+}
+
+// NTP：配置后约200ms完成校时，此前 time() 返回上电后的秒数（与真机未校时一致）
+static bool simTimeSynced = false;
+static uint64_t simTimeSyncedAt = 0;
+
+void configTzTime(const char *tz, const char *server1, const char *server2, const char *server3) {
+  (void)server1;
+  (void)server2;
+  (void)server3;
+  setenv("TZ", tz, 1);
+  tzset();
+  if (!simTimeSynced) {
+    sim_at(sim_now() + 200000, [] {
+      simTimeSynced = true;
+      simTimeSyncedAt = sim_now();
+    });
+  }
+}
+
+// 固件用 time(NULL) 取当前时间，这里替换C库实现，使时间随虚拟时钟走
+extern "C" time_t time(time_t *out) noexcept {
+  time_t now = (time_t)(sim_now() / 1000000);
+  if (simTimeSynced) {
+    now = simOptions.epoch + (time_t)((sim_now() - simTimeSyncedAt) / 1000000);
+  }
+  if (out) {
+    *out = now;
+  }
+  return now;
+}
+
+#if !defined(__GLIBC__) || !__GLIBC_PREREQ(2, 38)
+extern "C" size_t strlcpy(char *dst, const char *src, size_t size) {
+  size_t length = strlen(src);
+  if (size) {
+    size_t n = length < size - 1 ? length : size - 1;
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+  }
+  return length;
+}
+#endif
+
+// ==================== GPIO ====================
+
+#define SIM_PIN_COUNT 40
+
+struct SimPin {
+  uint8_t mode = INPUT;
+  int output = LOW;            // 固件输出电平
+  int driven = -1;             // 外部电路驱动的电平，-1表示未驱动
+  void (*isr)() = NULL;
+  int isrMode = 0;
+  std::vector<std::function<void(int)>> observers;
+};
+
+static SimPin simPins[SIM_PIN_COUNT];
+
+static int sim_gpio_input(const SimPin &pin) {
+  if (pin.driven >= 0) {
+    return pin.driven;
+  }
+  return pin.mode == INPUT_PULLUP ? HIGH : LOW;
+}
+
+static void sim_gpio_edge(SimPin &pin, int before, int after) {
+  if (before == after || !pin.isr) {
+    return;
+  }
+  bool fire = pin.isrMode == CHANGE || (pin.isrMode == RISING && after == HIGH) ||
+              (pin.isrMode == FALLING && after == LOW);
+  if (fire) {
+    void (*isr)() = pin.isr;
+    sim_run_isr([isr] { isr(); });
+  }
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin >= SIM_PIN_COUNT) {
+    return;
+  }
+  SimPin &p = simPins[pin];
+  int before = sim_gpio_input(p);
+  p.mode = mode;
+  if (mode != OUTPUT) {
+    sim_gpio_edge(p, before, sim_gpio_input(p));
+  }
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin >= SIM_PIN_COUNT) {
+    return;
+  }
+  SimPin &p = simPins[pin];
+  int level = value ? HIGH : LOW;
+  if (p.output == level) {
+    return;
+  }
+  p.output = level;
+  for (auto &observer : p.observers) {
+    observer(level);
+  }
+}
+
+int digitalRead(uint8_t pin) {
+  if (pin >= SIM_PIN_COUNT) {
+    return LOW;
+  }
+  const SimPin &p = simPins[pin];
+  return p.mode == OUTPUT ? p.output : sim_gpio_input(p);
+}
+
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode) {
+  if (pin < SIM_PIN_COUNT) {
+    simPins[pin].isr = handler;
+    simPins[pin].isrMode = mode;
+  }
+}
+
+void detachInterrupt(uint8_t pin) {
+  if (pin < SIM_PIN_COUNT) {
+    simPins[pin].isr = NULL;
+  }
+}
+
+void sim_gpio_drive(uint8_t pin, int level) {
+  if (pin >= SIM_PIN_COUNT) {
+    return;
+  }
+  SimPin &p = simPins[pin];
+  int before = sim_gpio_input(p);
+  p.driven = level;
+  if (p.mode != OUTPUT) {
+    sim_gpio_edge(p, before, sim_gpio_input(p));
+  }
+}
+
+int sim_gpio_output(uint8_t pin) {
+  if (pin >= SIM_PIN_COUNT || simPins[pin].mode != OUTPUT) {
+    return -1;
+  }
+  return simPins[pin].output;
+}
+
+void sim_gpio_observe(uint8_t pin, std::function<void(int)> observer) {
+  if (pin < SIM_PIN_COUNT) {
+    simPins[pin].observers.push_back(std::move(observer));
+  }
+}
+
+// ==================== LEDC ====================
+
+#define SIM_LEDC_CHANNELS 16
+
+static double simLedcFrequency[SIM_LEDC_CHANNELS];
+
+double ledcSetup(uint8_t channel, double frequency, uint8_t resolution) {
+  (void)resolution;
+  (void)channel;
+  return frequency;
+}
+
+void ledcAttachPin(uint8_t pin, uint8_t channel) {
+  (void)pin;
+  (void)channel;
+}
+
+void ledcWrite(uint8_t channel, uint32_t duty) {
+  if (channel < SIM_LEDC_CHANNELS && duty == 0 && simLedcFrequency[channel] != 0) {
+    simLedcFrequency[channel] = 0;
+    sim_ledc_changed(channel, 0);
+  }
+}
+
+double ledcWriteTone(uint8_t channel, double frequency) {
+  if (channel < SIM_LEDC_CHANNELS && simLedcFrequency[channel] != frequency) {
+    simLedcFrequency[channel] = frequency;
+    sim_ledc_changed(channel, frequency);
+  }
+  return frequency;
+}
+
+// ==================== 串口 ====================
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while (size--) {
+    n += write(*buffer++);
+  }
+  return n;
+}
+
+size_t Print::print(long value, int base) {
+  char text[34];
+  if (base == HEX) {
+    snprintf(text, sizeof(text), "%lX", value);
+  } else {
+    snprintf(text, sizeof(text), "%ld", value);
+  }
+  return write(text);
+}
+
+size_t Print::print(unsigned long value, int base) {
+  char text[34];
+  snprintf(text, sizeof(text), base == HEX ? "%lX" : "%lu", value);
+  return write(text);
+}
+
+size_t Print::print(double value, int digits) {
+  char text[64];
+  snprintf(text, sizeof(text), "%.*f", digits, value);
+  return write(text);
+}
+
+size_t Print::printf(const char *format, ...) {
+  char stackBuffer[256];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(stackBuffer, sizeof(stackBuffer), format, args);
+  va_end(args);
+  if (length < 0) {
+    return 0;
+  }
+  if ((size_t)length < sizeof(stackBuffer)) {
+    return write((const uint8_t *)stackBuffer, length);
+  }
+
+  std::string text(length + 1, '\0');
+  va_start(args, format);
+  vsnprintf(&text[0], text.size(), format, args);
+  va_end(args);
+  return write((const uint8_t *)text.data(), length);
+}
+
+size_t Stream::readBytes(char *buffer, size_t length) {
+  size_t count = 0;
+  while (count < length && available() > 0) {
+    buffer[count++] = (char)read();
+  }
+  return count;
+}
+
+void HardwareSerial::begin(unsigned long baud, uint32_t config, int8_t rxPin, int8_t txPin) {
+  (void)config;
+  (void)rxPin;
+  (void)txPin;
+  baud_ = baud;
+}
+
+void HardwareSerial::updateBaudRate(unsigned long baud) {
+  baud_ = baud;
+}
+
+int HardwareSerial::available() {
+  return (int)rx_.size();
+}
+
+int HardwareSerial::read() {
+  if (rx_.empty()) {
+    return -1;
+  }
+  uint8_t c = (uint8_t)rx_[0];
+  rx_.erase(0, 1);
+  return c;
+}
+
+int HardwareSerial::peek() {
+  return rx_.empty() ? -1 : (uint8_t)rx_[0];
+}
+
+size_t HardwareSerial::read(uint8_t *buffer, size_t size) {
+  size_t count = size < rx_.size() ? size : rx_.size();
+  memcpy(buffer, rx_.data(), count);
+  rx_.erase(0, count);
+  return count;
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+  if (port_ == 0) {
+    sim_console_write(buffer, size);
+  } else if (port_ == 2) {
+    sim_fingerprint_uart(buffer, size, baud_);
+  }
+  return size;
+}
+
+void HardwareSerial::sim_receive(const uint8_t *data, size_t length) {
+  rx_.append((const char *)data, length);
+}
+
+// ==================== 堆 ====================
+
+// ESP32-WROVER：内部RAM约320KB（扣除协议栈等常驻占用后按160KB计），PSRAM 4MB
+#define SIM_INTERNAL_FREE  (160 * 1024)
+#define SIM_SPIRAM_FREE    (4 * 1024 * 1024)
+
+void *heap_caps_malloc(size_t size, unsigned int caps) {
+  (void)caps;
+  return malloc(size);
+}
+
+void *heap_caps_calloc(size_t count, size_t size, unsigned int caps) {
+  (void)caps;
+  return calloc(count, size);
+}
+
+void *heap_caps_aligned_alloc(size_t alignment, size_t size, unsigned int caps) {
+  (void)caps;
+  void *memory = NULL;
+  if (posix_memalign(&memory, alignment < sizeof(void *) ? sizeof(void *) : alignment, size) != 0) {
+    return NULL;
+  }
+  return memory;
+}
+
+void heap_caps_free(void *ptr) {
+  free(ptr);
+}
+
+size_t heap_caps_get_free_size(unsigned int caps) {
+  return (caps & MALLOC_CAP_SPIRAM) ? SIM_SPIRAM_FREE : SIM_INTERNAL_FREE;
+}
+
+size_t heap_caps_get_minimum_free_size(unsigned int caps) {
+  return heap_caps_get_free_size(caps);
+}
+
+bool psramFound() {
+  return true;
+}
+
+// ==================== 分区 ====================
+
+static esp_partition_t simUserDbPartition;
+static std::string simUserDbData;
+static bool simUserDbLoaded = false;
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char *label) {
+  if (type != ESP_PARTITION_TYPE_DATA || simOptions.userDbImage.empty()) {
+    return NULL;
+  }
+  if (!simUserDbLoaded) {
+    FILE *file = fopen(simOptions.userDbImage.c_str(), "rb");
+    if (!file) {
+      return NULL;
+    }
+    char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+      simUserDbData.append(buffer, n);
+    }
+    fclose(file);
+    simUserDbLoaded = true;
+
+    memset(&simUserDbPartition, 0, sizeof(simUserDbPartition));
+    simUserDbPartition.type = ESP_PARTITION_TYPE_DATA;
+    simUserDbPartition.subtype = 0x40;
+    simUserDbPartition.address = 0x310000;
+    simUserDbPartition.size = (uint32_t)simUserDbData.size();
+    strlcpy(simUserDbPartition.label, "userdb", sizeof(simUserDbPartition.label));
+  }
+  if ((subtype != ESP_PARTITION_SUBTYPE_ANY && subtype != simUserDbPartition.subtype) ||
+      (label && strcmp(label, simUserDbPartition.label) != 0)) {
+    return NULL;
+  }
+  return &simUserDbPartition;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t *partition, size_t offset, size_t size,
+                             spi_flash_mmap_memory_t memory, const void **out, spi_flash_mmap_handle_t *handle) {
+  (void)memory;
+  if (partition != &simUserDbPartition || offset + size > simUserDbData.size()) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  *out = simUserDbData.data() + offset;
+  *handle = 1;
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t offset, void *dst, size_t size) {
+  if (partition != &simUserDbPartition || offset + size > simUserDbData.size()) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  memcpy(dst, simUserDbData.data() + offset, size);
+  // 闪存读取约 20MB/s
+  sim_busy(size / 20 + 1);
+  return ESP_OK;
+}
+
+void spi_flash_munmap(spi_flash_mmap_handle_t handle) {
+  (void)handle;
+}
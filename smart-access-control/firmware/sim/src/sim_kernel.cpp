@@ -0,0 +1,930 @@
+// 主机仿真内核：虚拟时间、任务调度、队列、互斥锁、软件定时器、esp_timer
+//
+// 每个FreeRTOS任务是一个主机线程，运行权在线程之间显式交接（同一时刻只有一个线程
+// 执行固件或仿真代码），因此仿真状态不需要加锁，运行结果与主机线程调度无关。
+// ESP32的两个核各有一个虚拟时钟，每个核按优先级调度绑定在该核上的任务；运行权总是
+// 交给时钟落后的核，正在运行的核最多领先另一个有任务可运行的核 SIM_CORE_LOOKAHEAD_US，
+// 因此跨核的唤醒和设备事件最多晚这么多时间。
+
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+#include <deque>
+#include <map>
+#include "sim.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/timers.h"
+#include "esp_timer.h"
+
+#define SIM_CORES              2
+#define SIM_CORE_LOOKAHEAD_US  50
+// 不阻塞的查询（超时为0且条件不满足）的开销
+#define SIM_POLL_US            2
+
+struct SimTask {
+  std::string name;
+  TaskFunction_t function;
+  void *parameter;
+  unsigned priority;
+  int core;
+  pthread_t thread;
+  pthread_cond_t cond;
+  bool ready;
+  bool deleted;
+  bool notified;
+  uint64_t readySeq;
+  uint64_t readyAt;     // 就绪时刻（另一核唤醒时可能晚于本核时钟）
+  const void *waitObject;
+  uint64_t wakeAt;
+  uint64_t chargeMarkNs;
+  // 统计
+  uint64_t switches;
+  uint64_t timeouts;
+  uint64_t busyUs;
+};
+
+static pthread_mutex_t simMutex = PTHREAD_MUTEX_INITIALIZER;
+static std::vector<SimTask *> simTasks;
+static SimTask *simCurrent = NULL;
+static int simCore = 0;                      // 当前运行的核
+static uint64_t simCoreNow[SIM_CORES];      // 每个核的虚拟时钟(us)
+static int simCriticalNesting[SIM_CORES];
+static uint64_t simEndUs = SIM_FOREVER;
+static uint64_t simReadySeq = 0;
+static uint64_t simEventSeq = 0;
+static bool simIsr = false;
+static std::map<std::pair<uint64_t, uint64_t>, std::function<void()>> simEvents;
+
+// ==================== 调度 ====================
+
+uint64_t sim_now() {
+  return simCoreNow[simCore];
+}
+
+bool sim_in_isr() {
+  return simIsr;
+}
+
+const char *sim_task_name() {
+  return simCurrent ? simCurrent->name.c_str() : "-";
+}
+
+static uint64_t sim_thread_cpu_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * 任务变为就绪
+ * @param task 任务
+ * @param when 就绪时刻
+ */
+static void sim_make_ready(SimTask *task, uint64_t when) {
+  task->ready = true;
+  task->readySeq = ++simReadySeq;
+  task->readyAt = when;
+  task->waitObject = NULL;
+  task->wakeAt = SIM_FOREVER;
+}
+
+/**
+ * 选出一个核上下一个运行的任务：本核时钟之前已就绪的任务按优先级（同优先级先就绪先运行，
+ * 正在运行的任务不被同优先级抢占）；没有时取最早就绪的任务，核空闲到那时
+ * @param core 核号
+ * @param when 输出：任务开始运行的时刻
+ * @return 任务，没有就绪任务时返回NULL
+ */
+static SimTask *sim_pick_core(int core, uint64_t *when) {
+  uint64_t now = simCoreNow[core];
+  SimTask *best = NULL;
+  SimTask *pending = NULL;
+  for (SimTask *task : simTasks) {
+    if (!task->ready || task->deleted || task->core != core) {
+      continue;
+    }
+    if (task->readyAt > now) {
+      if (!pending || task->readyAt < pending->readyAt ||
+          (task->readyAt == pending->readyAt && task->priority > pending->priority)) {
+        pending = task;
+      }
+      continue;
+    }
+    if (!best || task->priority > best->priority ||
+        (task->priority == best->priority && best != simCurrent &&
+         (task == simCurrent || task->readySeq < best->readySeq))) {
+      best = task;
+    }
+  }
+  if (best) {
+    *when = now;
+    return best;
+  }
+  if (pending) {
+    *when = pending->readyAt;
+  }
+  return pending;
+}
+
+/**
+ * 选出下一个运行的任务：时钟落后的核优先，相同时优先当前核
+ * @param when 输出：任务开始运行的时刻
+ */
+static SimTask *sim_pick(uint64_t *when) {
+  SimTask *best = NULL;
+  for (int core = 0; core < SIM_CORES; core++) {
+    uint64_t coreWhen;
+    SimTask *task = sim_pick_core(core, &coreWhen);
+    if (task && (!best || coreWhen < *when || (coreWhen == *when && core == simCore))) {
+      best = task;
+      *when = coreWhen;
+    }
+  }
+  return best;
+}
+
+/**
+ * 执行到期的设备事件，并唤醒超时的任务
+ * @param masked 是否屏蔽设备事件（临界区内）
+ */
+static void sim_fire_due(bool masked) {
+  while (!masked && !simEvents.empty() && simEvents.begin()->first.first <= sim_now()) {
+    std::function<void()> action = std::move(simEvents.begin()->second);
+    simEvents.erase(simEvents.begin());
+    bool nested = simIsr;
+    simIsr = true;
+    action();
+    simIsr = nested;
+  }
+
+  for (SimTask *task : simTasks) {
+    if (!task->ready && !task->deleted && task->wakeAt <= sim_now()) {
+      task->timeouts++;
+      task->notified = false;
+      sim_make_ready(task, task->wakeAt);
+    }
+  }
+}
+
+/**
+ * 当前核最近的设备事件、任务唤醒时间或另一核唤醒的任务就绪时间
+ */
+static uint64_t sim_next_deadline() {
+  uint64_t next = simEvents.empty() ? SIM_FOREVER : simEvents.begin()->first.first;
+  for (SimTask *task : simTasks) {
+    if (task->deleted) {
+      continue;
+    }
+    if (!task->ready && task->wakeAt < next) {
+      next = task->wakeAt;
+    }
+    if (task->ready && task->core == simCore && task->readyAt > sim_now() && task->readyAt < next) {
+      next = task->readyAt;
+    }
+  }
+  return next;
+}
+
+/**
+ * 所有任务都阻塞：时间跳到下一个事件或唤醒时间
+ */
+static void sim_idle() {
+  uint64_t next = sim_next_deadline();
+
+  if (next > simEndUs) {
+    simCoreNow[simCore] = simEndUs;
+    sim_finish();
+  }
+  if (next > sim_now()) {
+    simCoreNow[simCore] = next;
+  }
+  // 阻塞的任务不可能持有临界区
+  sim_fire_due(false);
+}
+
+/**
+ * 把运行权交给另一个任务，当前任务（未删除时）等到重新获得运行权后返回
+ * @param next 下一个任务
+ * @param when 下一个任务开始运行的时刻（所在核空闲到此时）
+ */
+static void sim_switch(SimTask *next, uint64_t when) {
+  SimTask *self = simCurrent;
+  if (simCoreNow[next->core] < when) {
+    simCoreNow[next->core] = when;
+  }
+  if (next == self) {
+    return;
+  }
+  next->switches++;
+
+  pthread_mutex_lock(&simMutex);
+  simCurrent = next;
+  simCore = next->core;
+  pthread_cond_signal(&next->cond);
+  if (self && !self->deleted) {
+    while (simCurrent != self) {
+      pthread_cond_wait(&self->cond, &simMutex);
+    }
+  }
+  pthread_mutex_unlock(&simMutex);
+
+  if (self && !self->deleted) {
+    self->chargeMarkNs = sim_thread_cpu_ns();
+  }
+}
+
+/**
+ * 当前任务不再运行（阻塞、让出或删除）：运行下一个就绪任务
+ */
+static void sim_schedule() {
+  for (;;) {
+    uint64_t when;
+    SimTask *next = sim_pick(&when);
+    if (next) {
+      sim_switch(next, when);
+      return;
+    }
+    sim_idle();
+  }
+}
+
+void sim_preempt() {
+  if (simIsr || !simCurrent || simCriticalNesting[simCore] > 0) {
+    return;
+  }
+  uint64_t when;
+  SimTask *next = sim_pick(&when);
+  if (next) {
+    sim_switch(next, when);
+  }
+}
+
+void sim_busy(uint64_t us) {
+  if (us == 0) {
+    return;
+  }
+  if (simIsr) {
+    // 中断处理不应忙等，只推进时间
+    simCoreNow[simCore] += us;
+    return;
+  }
+
+  // 忙时间按事件和唤醒时间分段：中途到点的中断照常执行，更高优先级任务就绪时被抢占，
+  // 另一核落后时交出运行权，切换回来后继续剩余的忙时间
+  SimTask *self = simCurrent;
+  int core = simCore;
+  while (us > 0) {
+    uint64_t now = simCoreNow[core];
+    uint64_t step = us;
+    if (simCriticalNesting[core] == 0) {
+      uint64_t next = sim_next_deadline();
+      if (next > now && next - now < step) {
+        step = next - now;
+      }
+      uint64_t otherWhen;
+      if (sim_pick_core(1 - core, &otherWhen)) {
+        uint64_t limit = otherWhen + SIM_CORE_LOOKAHEAD_US;
+        if (limit > now && limit - now < step) {
+          step = limit - now;
+        }
+      }
+    }
+    if (now + step > simEndUs) {
+      simCoreNow[core] = simEndUs;
+      sim_finish();
+    }
+    simCoreNow[core] += step;
+    us -= step;
+    if (self) {
+      self->busyUs += step;
+    }
+    sim_fire_due(simCriticalNesting[core] > 0);
+    sim_preempt();
+  }
+}
+
+void sim_charge() {
+  if (simOptions.cpuScale <= 0 || !simCurrent || simIsr) {
+    return;
+  }
+  uint64_t ns = sim_thread_cpu_ns();
+  uint64_t us = (uint64_t)((ns - simCurrent->chargeMarkNs) * simOptions.cpuScale / 1000.0);
+  if (us == 0) {
+    return;
+  }
+  simCurrent->chargeMarkNs = ns;
+  sim_busy(us);
+}
+
+void sim_spin_guard() {
+  static uint64_t lastNow = SIM_FOREVER;
+  static uint32_t spins = 0;
+  if (simIsr) {
+    return;
+  }
+  if (sim_now() != lastNow) {
+    lastNow = sim_now();
+    spins = 0;
+    return;
+  }
+  if (++spins >= 1000) {
+    spins = 0;
+    sim_busy(1);
+  }
+}
+
+bool sim_wait(const void *object, uint64_t wakeAt) {
+  SimTask *self = simCurrent;
+  sim_charge();
+  if (wakeAt <= sim_now()) {
+    // 不阻塞的查询也要花时间，否则轮询的任务会让虚拟时间停住
+    sim_busy(SIM_POLL_US);
+    return false;
+  }
+  self->ready = false;
+  self->notified = false;
+  self->waitObject = object;
+  self->wakeAt = wakeAt;
+  sim_schedule();
+
+  bool notified = self->notified;
+  self->notified = false;
+  return notified;
+}
+
+bool sim_notify(const void *object, bool all) {
+  bool woken = false;
+  for (;;) {
+    SimTask *best = NULL;
+    for (SimTask *task : simTasks) {
+      if (!task->ready && !task->deleted && task->waitObject == object &&
+          (!best || task->priority > best->priority)) {
+        best = task;
+      }
+    }
+    if (!best) {
+      return woken;
+    }
+    best->notified = true;
+    sim_make_ready(best, sim_now());
+    woken = true;
+    if (!all) {
+      return true;
+    }
+  }
+}
+
+void sim_advance_wake(const void *object, uint64_t wakeAt) {
+  for (SimTask *task : simTasks) {
+    if (!task->ready && !task->deleted && task->waitObject == object && wakeAt < task->wakeAt) {
+      task->wakeAt = wakeAt < sim_now() ? sim_now() : wakeAt;
+    }
+  }
+}
+
+uint64_t sim_wake_after(uint32_t ticks) {
+  if (ticks == portMAX_DELAY) {
+    return SIM_FOREVER;
+  }
+  return sim_now() + (uint64_t)ticks * portTICK_PERIOD_MS * 1000;
+}
+
+void sim_at(uint64_t timeUs, std::function<void()> action) {
+  if (timeUs < sim_now()) {
+    timeUs = sim_now();
+  }
+  simEvents.emplace(std::make_pair(timeUs, ++simEventSeq), std::move(action));
+}
+
+void sim_run_isr(const std::function<void()> &isr) {
+  bool nested = simIsr;
+  simIsr = true;
+  isr();
+  simIsr = nested;
+  if (!nested) {
+    sim_preempt();
+  }
+}
+
+void sim_enter_critical() {
+  simCriticalNesting[simCore]++;
+}
+
+void sim_exit_critical() {
+  if (simCriticalNesting[simCore] > 0 && --simCriticalNesting[simCore] == 0 && !simIsr && simCurrent) {
+    // 临界区内被推迟的中断
+    sim_fire_due(false);
+    sim_preempt();
+  }
+}
+
+BaseType_t xPortGetCoreID() {
+  return simCore;
+}
+
+std::vector<SimTaskStats> sim_task_stats() {
+  std::vector<SimTaskStats> stats;
+  for (SimTask *task : simTasks) {
+    stats.push_back({task->name, task->priority, task->core, task->switches, task->timeouts, task->busyUs});
+  }
+  return stats;
+}
+
+// ==================== 任务 ====================
+
+static void sim_task_exit() {
+  SimTask *self = simCurrent;
+  self->deleted = true;
+  self->ready = false;
+  sim_schedule();
+}
+
+static void *sim_task_entry(void *arg) {
+  SimTask *self = (SimTask *)arg;
+  pthread_mutex_lock(&simMutex);
+  while (simCurrent != self) {
+    pthread_cond_wait(&self->cond, &simMutex);
+  }
+  pthread_mutex_unlock(&simMutex);
+  self->chargeMarkNs = sim_thread_cpu_ns();
+
+  self->function(self->parameter);
+
+  // FreeRTOS任务函数不应返回，按删除自身处理
+  sim_task_exit();
+  return NULL;
+}
+
+static SimTask *sim_task_create(TaskFunction_t function, const char *name, void *parameter, unsigned priority,
+                                int core) {
+  SimTask *task = new SimTask();
+  task->name = name ? name : "";
+  task->function = function;
+  task->parameter = parameter;
+  task->priority = priority;
+  task->core = core < 0 ? 0 : core;
+  pthread_cond_init(&task->cond, NULL);
+  sim_make_ready(task, sim_now());
+  simTasks.push_back(task);
+
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  pthread_attr_setstacksize(&attr, 1 << 20);
+  pthread_create(&task->thread, &attr, sim_task_entry, task);
+  pthread_attr_destroy(&attr);
+  return task;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stackDepth, void *parameter,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core) {
+  (void)stackDepth;
+  SimTask *task = sim_task_create(function, name, parameter, priority, core);
+  if (handle) {
+    *handle = task;
+  }
+  sim_preempt();
+  return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stackDepth, void *parameter,
+                       UBaseType_t priority, TaskHandle_t *handle) {
+  return xTaskCreatePinnedToCore(function, name, stackDepth, parameter, priority, handle, 0);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  if (!task || task == simCurrent) {
+    sim_task_exit();
+    pthread_exit(NULL);
+  }
+  task->deleted = true;
+  task->ready = false;
+}
+
+void vTaskDelay(TickType_t ticks) {
+  if (ticks == 0) {
+    taskYIELD();
+    return;
+  }
+  sim_wait(NULL, sim_wake_after(ticks));
+}
+
+void taskYIELD() {
+  sim_charge();
+  simCurrent->readySeq = ++simReadySeq;
+  sim_schedule();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+  return simCurrent;
+}
+
+TickType_t xTaskGetTickCount() {
+  return (TickType_t)(sim_now() / (portTICK_PERIOD_MS * 1000));
+}
+
+// ==================== 队列 ====================
+
+struct SimQueue {
+  UBaseType_t length;
+  UBaseType_t itemSize;
+  std::deque<std::string> items;
+  char sendObject;   // 等待队列有空位的任务阻塞在此
+  char receiveObject;   // 等待队列有数据的任务阻塞在此
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+  SimQueue *queue = new SimQueue();
+  queue->length = length;
+  queue->itemSize = itemSize;
+  return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+  delete queue;
+}
+
+static bool sim_queue_push(SimQueue *queue, const void *item) {
+  if (queue->items.size() >= queue->length) {
+    return false;
+  }
+  queue->items.emplace_back((const char *)item, queue->itemSize);
+  sim_notify(&queue->receiveObject, false);
+  return true;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks) {
+  uint64_t wakeAt = sim_wake_after(ticks);
+  for (;;) {
+    if (sim_queue_push(queue, item)) {
+      sim_preempt();
+      return pdTRUE;
+    }
+    if (simIsr || !sim_wait(&queue->sendObject, wakeAt)) {
+      if (queue->items.size() >= queue->length) {
+        return pdFALSE;
+      }
+    }
+  }
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void *item, TickType_t ticks) {
+  return xQueueSend(queue, item, ticks);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *woken) {
+  bool hadWaiter = false;
+  for (SimTask *task : simTasks) {
+    if (!task->ready && !task->deleted && task->waitObject == &queue->receiveObject) {
+      hadWaiter = true;
+    }
+  }
+  if (!sim_queue_push(queue, item)) {
+    return pdFALSE;
+  }
+  if (woken && hadWaiter) {
+    *woken = pdTRUE;
+  }
+  return pdTRUE;
+}
+
+static BaseType_t sim_queue_receive(SimQueue *queue, void *item, TickType_t ticks, bool remove) {
+  uint64_t wakeAt = sim_wake_after(ticks);
+  for (;;) {
+    if (!queue->items.empty()) {
+      memcpy(item, queue->items.front().data(), queue->itemSize);
+      if (remove) {
+        queue->items.pop_front();
+        sim_notify(&queue->sendObject, false);
+        sim_preempt();
+      }
+      return pdTRUE;
+    }
+    if (simIsr || !sim_wait(&queue->receiveObject, wakeAt)) {
+      if (queue->items.empty()) {
+        return pdFALSE;
+      }
+    }
+  }
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks) {
+  return sim_queue_receive(queue, item, ticks, true);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void *item, TickType_t ticks) {
+  return sim_queue_receive(queue, item, ticks, false);
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+  queue->items.clear();
+  sim_notify(&queue->sendObject, true);
+  sim_preempt();
+  return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+  return queue->items.size();
+}
+
+// ==================== 互斥锁 ====================
+
+struct SimMutex {
+  SimTask *owner;
+  UBaseType_t depth;  // 递归互斥锁的获取次数
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+  return new SimMutex();
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t mutex) {
+  delete mutex;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t ticks) {
+  uint64_t wakeAt = sim_wake_after(ticks);
+  for (;;) {
+    if (!mutex->owner) {
+      mutex->owner = simCurrent;
+      return pdTRUE;
+    }
+    if (!sim_wait(mutex, wakeAt) && mutex->owner) {
+      return pdFALSE;
+    }
+  }
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex) {
+  if (mutex->owner != simCurrent) {
+    return pdFALSE;
+  }
+  mutex->owner = NULL;
+  sim_notify(mutex, false);
+  sim_preempt();
+  return pdTRUE;
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() {
+  return new SimMutex();
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t mutex, TickType_t ticks) {
+  if (mutex->owner == simCurrent) {
+    mutex->depth++;
+    return pdTRUE;
+  }
+  if (!xSemaphoreTake(mutex, ticks)) {
+    return pdFALSE;
+  }
+  mutex->depth = 1;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t mutex) {
+  if (mutex->owner != simCurrent) {
+    return pdFALSE;
+  }
+  if (--mutex->depth > 0) {
+    return pdTRUE;
+  }
+  return xSemaphoreGive(mutex);
+}
+
+// ==================== 软件定时器（定时器服务任务，优先级1） ====================
+
+struct SimTimer {
+  std::string name;
+  uint64_t periodUs;
+  bool autoReload;
+  void *id;
+  TimerCallbackFunction_t callback;
+  bool active;
+  uint64_t due;
+};
+
+static std::vector<SimTimer *> simTimers;
+static char simTimerObject;
+static char simEspTimerObject;
+
+#define SIM_TIMER_TASK_PRIORITY      1
+#define SIM_ESP_TIMER_TASK_PRIORITY  22
+
+static void sim_timer_task(void *) {
+  for (;;) {
+    SimTimer *due = NULL;
+    uint64_t next = SIM_FOREVER;
+    for (SimTimer *timer : simTimers) {
+      if (!timer->active) {
+        continue;
+      }
+      if (timer->due <= sim_now() && (!due || timer->due < due->due)) {
+        due = timer;
+      }
+      if (timer->due < next) {
+        next = timer->due;
+      }
+    }
+    if (due) {
+      if (due->autoReload) {
+        due->due += due->periodUs;
+      } else {
+        due->active = false;
+      }
+      due->callback(due);
+      continue;
+    }
+    sim_wait(&simTimerObject, next);
+  }
+}
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t autoReload, void *id,
+                           TimerCallbackFunction_t callback) {
+  SimTimer *timer = new SimTimer();
+  timer->name = name ? name : "";
+  timer->periodUs = (uint64_t)period * portTICK_PERIOD_MS * 1000;
+  timer->autoReload = autoReload;
+  timer->id = id;
+  timer->callback = callback;
+  simTimers.push_back(timer);
+  return timer;
+}
+
+static BaseType_t sim_timer_start(SimTimer *timer) {
+  timer->active = true;
+  timer->due = sim_now() + timer->periodUs;
+  sim_advance_wake(&simTimerObject, timer->due);
+  return pdPASS;
+}
+
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t ticks) {
+  (void)ticks;
+  return sim_timer_start(timer);
+}
+
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticks) {
+  (void)ticks;
+  timer->active = false;
+  return pdPASS;
+}
+
+BaseType_t xTimerReset(TimerHandle_t timer, TickType_t ticks) {
+  (void)ticks;
+  return sim_timer_start(timer);
+}
+
+BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t period, TickType_t ticks) {
+  (void)ticks;
+  timer->periodUs = (uint64_t)period * portTICK_PERIOD_MS * 1000;
+  return sim_timer_start(timer);
+}
+
+BaseType_t xTimerStartFromISR(TimerHandle_t timer, BaseType_t *woken) {
+  (void)woken;
+  return sim_timer_start(timer);
+}
+
+BaseType_t xTimerStopFromISR(TimerHandle_t timer, BaseType_t *woken) {
+  (void)woken;
+  timer->active = false;
+  return pdPASS;
+}
+
+BaseType_t xTimerIsTimerActive(TimerHandle_t timer) {
+  return timer->active ? pdTRUE : pdFALSE;
+}
+
+void *pvTimerGetTimerID(TimerHandle_t timer) {
+  return timer->id;
+}
+
+// ==================== esp_timer（esp_timer任务，优先级22） ====================
+
+struct SimEspTimer {
+  esp_timer_cb_t callback;
+  void *arg;
+  std::string name;
+  bool active;
+  uint64_t due;
+  uint64_t periodUs;
+};
+
+static std::vector<SimEspTimer *> simEspTimers;
+
+static void sim_esp_timer_task(void *) {
+  for (;;) {
+    SimEspTimer *due = NULL;
+    uint64_t next = SIM_FOREVER;
+    for (SimEspTimer *timer : simEspTimers) {
+      if (!timer->active) {
+        continue;
+      }
+      if (timer->due <= sim_now() && (!due || timer->due < due->due)) {
+        due = timer;
+      }
+      if (timer->due < next) {
+        next = timer->due;
+      }
+    }
+    if (due) {
+      if (due->periodUs) {
+        due->due += due->periodUs;
+      } else {
+        due->active = false;
+      }
+      due->callback(due->arg);
+      continue;
+    }
+    sim_wait(&simEspTimerObject, next);
+  }
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *handle) {
+  SimEspTimer *timer = new SimEspTimer();
+  timer->callback = args->callback;
+  timer->arg = args->arg;
+  timer->name = args->name ? args->name : "";
+  simEspTimers.push_back(timer);
+  *handle = timer;
+  return ESP_OK;
+}
+
+static esp_err_t sim_esp_timer_start(SimEspTimer *timer, uint64_t timeoutUs, uint64_t periodUs) {
+  if (timer->active) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  timer->active = true;
+  timer->due = sim_now() + timeoutUs;
+  timer->periodUs = periodUs;
+  sim_advance_wake(&simEspTimerObject, timer->due);
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeoutUs) {
+  return sim_esp_timer_start(timer, timeoutUs, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t periodUs) {
+  return sim_esp_timer_start(timer, periodUs, periodUs);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+  if (!timer->active) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  timer->active = false;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+  if (timer->active) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  for (size_t i = 0; i < simEspTimers.size(); i++) {
+    if (simEspTimers[i] == timer) {
+      simEspTimers.erase(simEspTimers.begin() + i);
+      break;
+    }
+  }
+  delete timer;
+  return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer) {
+  return timer->active;
+}
+
+int64_t esp_timer_get_time() {
+  sim_charge();
+  return (int64_t)sim_now();
+}
+
+// ==================== 启动 ====================
+
+void setup();
+void loop();
+
+static void sim_loop_task(void *) {
+  setup();
+  for (;;) {
+    loop();
+  }
+}
+
+void sim_kernel_run(uint64_t endUs, void (*entry)(void *)) {
+  simEndUs = endUs;
+
+  // Arduino-ESP32：setup()/loop() 在核1上的loopTask中运行，优先级1
+  sim_task_create(sim_esp_timer_task, "esp_timer", NULL, SIM_ESP_TIMER_TASK_PRIORITY, 0);
+  sim_task_create(sim_timer_task, "Tmr Svc", NULL, SIM_TIMER_TASK_PRIORITY, 0);
+  sim_task_create(entry ? entry : sim_loop_task, "loopTask", NULL, 1, 1);
+
+  // 运行权交出后主线程只等待，进程由 sim_finish 结束
+  sim_schedule();
+  for (;;) {
+    pause();
+  }
+}
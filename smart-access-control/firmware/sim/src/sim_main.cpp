@@ -0,0 +1,57 @@
+// 主机仿真入口：读取场景，初始化设备模型，运行固件的 setup()/loop() 及其创建的任务
+//
+// 用法: program [-q] [-c 系数] [--sd 目录] [--userdb 镜像] [--report 报告.json] 场景.txt
+//   -q            不输出过程日志，只输出报告
+//   -c 系数       把主机CPU时间乘以系数计入虚拟时间（默认不计，结果只取决于模型参数，可复现）
+//   --sd 目录     SD卡目录（默认使用临时目录，结束后删除）
+//   --userdb 镜像 userdb分区镜像（tools/userdb_image.py生成，默认无分区，使用内置用户）
+//   --report 文件 输出JSON报告
+// 退出码：0表示场景中的期望全部满足，1表示有期望失败，2表示参数或场景错误
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+
+static void sim_usage(const char *program) {
+  fprintf(stderr, "用法: %s [-q] [-c 系数] [--sd 目录] [--userdb 镜像] [--report 报告.json] 场景.txt\n",
+          program);
+}
+
+int main(int argc, char **argv) {
+  const char *scenario = NULL;
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (strcmp(arg, "-q") == 0) {
+      simOptions.quiet = true;
+    } else if (strcmp(arg, "-c") == 0 && hasValue) {
+      simOptions.cpuScale = atof(argv[++i]);
+    } else if (strcmp(arg, "--sd") == 0 && hasValue) {
+      simOptions.sdDir = argv[++i];
+    } else if (strcmp(arg, "--userdb") == 0 && hasValue) {
+      simOptions.userDbImage = argv[++i];
+    } else if (strcmp(arg, "--report") == 0 && hasValue) {
+      simOptions.reportJson = argv[++i];
+    } else if (arg[0] != '-' && !scenario) {
+      scenario = arg;
+    } else {
+      sim_usage(argv[0]);
+      return 2;
+    }
+  }
+  if (!scenario) {
+    sim_usage(argv[0]);
+    return 2;
+  }
+
+  uint64_t endUs = sim_scenario_load(scenario);
+  if (endUs == 0) {
+    return 2;
+  }
+
+  setvbuf(stdout, NULL, _IOLBF, 0);
+  sim_sd_init();
+  sim_devices_init();
+  sim_kernel_run(endUs);
+}
@@ -0,0 +1,353 @@
+// 主机仿真：WiFi与进程内MQTT服务器
+// 发布按约2Mbit/s的有效链路速率计时；入站消息在 PubSubClient::loop() 中每次交付一条（与原库一致）
+
+#include <WiFi.h>
+#include <PubSubClient.h>
+#include <deque>
+#include "lwip/sockets.h"
+#include "sim.h"
+
+#define SIM_WIFI_CONNECT_US       300000
+#define SIM_MQTT_CONNECT_US       20000
+#define SIM_MQTT_PACKET_US        200
+#define SIM_MQTT_BYTE_US          4
+#define SIM_MQTT_FD               54
+#define SIM_MQTT_HEADER_SIZE      5
+
+WiFiClass WiFi;
+
+struct SimMessage {
+  std::string topic;
+  std::string payload;
+};
+
+static bool simWifiUp = true;
+static bool simWifiStarted = false;
+static uint64_t simWifiConnectedAt = 0;
+static bool simMqttSession = false;
+static std::vector<std::string> simSubscriptions;
+static std::deque<SimMessage> simInbound;
+
+// ==================== WiFi ====================
+
+String IPAddress::toString() const {
+  char text[16];
+  snprintf(text, sizeof(text), "%u.%u.%u.%u", bytes_[0], bytes_[1], bytes_[2], bytes_[3]);
+  return String(text);
+}
+
+wl_status_t WiFiClass::begin(const char *ssid, const char *password) {
+  (void)ssid;
+  (void)password;
+  simWifiStarted = true;
+  simWifiConnectedAt = sim_now() + SIM_WIFI_CONNECT_US;
+  return status();
+}
+
+bool WiFiClass::disconnect(bool wifiOff) {
+  (void)wifiOff;
+  simWifiStarted = false;
+  simMqttSession = false;
+  return true;
+}
+
+wl_status_t WiFiClass::status() {
+  if (!simWifiStarted || !simWifiUp) {
+    return WL_DISCONNECTED;
+  }
+  return sim_now() >= simWifiConnectedAt ? WL_CONNECTED : WL_IDLE_STATUS;
+}
+
+IPAddress WiFiClass::localIP() {
+  return status() == WL_CONNECTED ? IPAddress(192, 168, 1, 100) : IPAddress();
+}
+
+int8_t WiFiClass::RSSI() {
+  return status() == WL_CONNECTED ? -55 : 0;
+}
+
+void sim_wifi_set(bool up) {
+  simWifiUp = up;
+  if (!up) {
+    // 断网：服务器侧会话失效，select 中等待的任务返回
+    simMqttSession = false;
+    simInbound.clear();
+    sim_notify(&simInbound, true);
+  } else {
+    simWifiConnectedAt = sim_now() + SIM_WIFI_CONNECT_US;
+  }
+  sim_record("wifi", up ? "up" : "down");
+}
+
+// ==================== TCP ====================
+
+uint8_t WiFiClient::connected() {
+  return simMqttSession;
+}
+
+int WiFiClient::fd() const {
+  return simMqttSession ? SIM_MQTT_FD : -1;
+}
+
+int WiFiClient::available() {
+  size_t bytes = 0;
+  for (const SimMessage &message : simInbound) {
+    bytes += SIM_MQTT_HEADER_SIZE + message.topic.size() + message.payload.size();
+  }
+  return simMqttSession ? (int)bytes : 0;
+}
+
+int sim_lwip_select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds, struct timeval *timeout) {
+  (void)nfds;
+  (void)writefds;
+  (void)exceptfds;
+  if (simMqttSession && !simInbound.empty()) {
+    return 1;
+  }
+  uint64_t wakeAt = SIM_FOREVER;
+  if (timeout) {
+    wakeAt = sim_now() + (uint64_t)timeout->tv_sec * 1000000 + timeout->tv_usec;
+  }
+  if (sim_wait(&simInbound, wakeAt)) {
+    return 1;
+  }
+  if (readfds) {
+    FD_ZERO(readfds);
+  }
+  return 0;
+}
+
+// ==================== MQTT ====================
+
+/**
+ * 主题过滤器匹配（支持 + 和 # 通配符）
+ */
+static bool sim_topic_matches(const std::string &filter, const std::string &topic) {
+  size_t f = 0;
+  size_t t = 0;
+  while (f < filter.size()) {
+    if (filter[f] == '#') {
+      return true;
+    }
+    if (filter[f] == '+') {
+      while (t < topic.size() && topic[t] != '/') {
+        t++;
+      }
+      f++;
+      continue;
+    }
+    if (t >= topic.size() || filter[f] != topic[t]) {
+      return false;
+    }
+    f++;
+    t++;
+  }
+  return t == topic.size();
+}
+
+void sim_mqtt_inject(const std::string &topic, const std::string &payload) {
+  sim_stimulus("mqtt");
+  if (!simMqttSession) {
+    sim_printf("MQTT< (离线，丢弃) %s %s\n", topic.c_str(), payload.c_str());
+    return;
+  }
+  sim_printf("MQTT< %s %s\n", topic.c_str(), payload.c_str());
+  simInbound.push_back({topic, payload});
+  sim_notify(&simInbound, true);
+}
+
+static void sim_mqtt_delivered(const std::string &topic, const std::string &payload) {
+  sim_mqtt_count(topic, payload.size());
+  sim_record(topic, payload);
+}
+
+// 流式发布未结束时的其他调用：原库直接写入连接，报文插入未写完的PUBLISH中，代理按协议错误断开
+bool PubSubClient::sim_interleaved(const char *call) {
+  if (!streaming_) {
+    return false;
+  }
+  fprintf(stderr, "MQTT %s 插入未结束的流式发布（%s），代理断开连接\n", call, streamTopic_.c_str());
+  streaming_ = false;
+  connected_ = false;
+  simMqttSession = false;
+  return true;
+}
+
+PubSubClient &PubSubClient::setServer(const char *domain, uint16_t port) {
+  (void)domain;
+  (void)port;
+  return *this;
+}
+
+PubSubClient &PubSubClient::setCallback(MQTT_CALLBACK_SIGNATURE) {
+  callback_ = callback;
+  return *this;
+}
+
+PubSubClient &PubSubClient::setClient(Client &client) {
+  client_ = &client;
+  return *this;
+}
+
+bool PubSubClient::setBufferSize(uint16_t size) {
+  if (size == 0) {
+    return false;
+  }
+  bufferSize_ = size;
+  return true;
+}
+
+bool PubSubClient::connect(const char *id) {
+  (void)id;
+  sim_interleaved("connect");
+  if (WiFi.status() != WL_CONNECTED) {
+    sim_busy(SIM_MQTT_CONNECT_US);
+    return false;
+  }
+  sim_busy(SIM_MQTT_CONNECT_US);
+  simMqttSession = true;
+  simSubscriptions.clear();
+  simInbound.clear();
+  connected_ = true;
+  return true;
+}
+
+bool PubSubClient::connect(const char *id, const char *user, const char *pass) {
+  (void)user;
+  (void)pass;
+  return connect(id);
+}
+
+void PubSubClient::disconnect() {
+  connected_ = false;
+  simMqttSession = false;
+}
+
+bool PubSubClient::connected() {
+  if (connected_ && !simMqttSession) {
+    connected_ = false;
+  }
+  return connected_;
+}
+
+int PubSubClient::state() {
+  return connected() ? MQTT_CONNECTED : MQTT_CONNECTION_LOST;
+}
+
+bool PubSubClient::loop() {
+  if (sim_interleaved("loop") || !connected()) {
+    return false;
+  }
+  if (simInbound.empty()) {
+    return true;
+  }
+
+  SimMessage message = simInbound.front();
+  simInbound.pop_front();
+  size_t packetSize = SIM_MQTT_HEADER_SIZE + message.topic.size() + message.payload.size();
+  sim_busy(SIM_MQTT_PACKET_US + packetSize * SIM_MQTT_BYTE_US);
+  if (packetSize > bufferSize_) {
+    // 原库：报文超过缓冲区时丢弃
+    return true;
+  }
+
+  bool subscribed = false;
+  for (const std::string &filter : simSubscriptions) {
+    if (sim_topic_matches(filter, message.topic)) {
+      subscribed = true;
+      break;
+    }
+  }
+  if (subscribed && callback_) {
+    std::vector<char> topic(message.topic.begin(), message.topic.end());
+    topic.push_back('\0');
+    std::vector<uint8_t> payload(message.payload.begin(), message.payload.end());
+    payload.push_back('\0');
+    callback_(topic.data(), payload.data(), message.payload.size());
+  }
+  return true;
+}
+
+bool PubSubClient::publish(const char *topic, const char *payload) {
+  return publish(topic, (const uint8_t *)payload, payload ? strlen(payload) : 0, false);
+}
+
+bool PubSubClient::publish(const char *topic, const char *payload, bool retained) {
+  return publish(topic, (const uint8_t *)payload, payload ? strlen(payload) : 0, retained);
+}
+
+bool PubSubClient::publish(const char *topic, const uint8_t *payload, unsigned int length) {
+  return publish(topic, payload, length, false);
+}
+
+bool PubSubClient::publish(const char *topic, const uint8_t *payload, unsigned int length, bool retained) {
+  (void)retained;
+  if (sim_interleaved("publish") || !connected()) {
+    return false;
+  }
+  size_t packetSize = SIM_MQTT_HEADER_SIZE + strlen(topic) + length;
+  if (packetSize > bufferSize_) {
+    return false;
+  }
+  sim_busy(SIM_MQTT_PACKET_US + packetSize * SIM_MQTT_BYTE_US);
+  sim_mqtt_delivered(topic, std::string((const char *)payload, length));
+  return true;
+}
+
+bool PubSubClient::beginPublish(const char *topic, unsigned int length, bool retained) {
+  (void)retained;
+  if (sim_interleaved("beginPublish") || !connected()) {
+    return false;
+  }
+  streamTopic_ = topic;
+  streamPayload_.clear();
+  streamLength_ = length;
+  streaming_ = true;
+  sim_busy(SIM_MQTT_PACKET_US + (SIM_MQTT_HEADER_SIZE + streamTopic_.size()) * SIM_MQTT_BYTE_US);
+  return true;
+}
+
+int PubSubClient::endPublish() {
+  if (!streaming_) {
+    return 0;
+  }
+  streaming_ = false;
+  if (streamPayload_.size() != streamLength_) {
+    return 0;
+  }
+  sim_mqtt_delivered(streamTopic_, streamPayload_);
+  return 1;
+}
+
+size_t PubSubClient::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t PubSubClient::write(const uint8_t *buffer, size_t size) {
+  if (!streaming_ || !connected()) {
+    return 0;
+  }
+  sim_busy(size * SIM_MQTT_BYTE_US);
+  streamPayload_.append((const char *)buffer, size);
+  return size;
+}
+
+bool PubSubClient::subscribe(const char *topic, uint8_t qos) {
+  (void)qos;
+  if (sim_interleaved("subscribe") || !connected()) {
+    return false;
+  }
+  sim_busy(SIM_MQTT_PACKET_US);
+  simSubscriptions.push_back(topic);
+  return true;
+}
+
+bool PubSubClient::unsubscribe(const char *topic) {
+  for (size_t i = 0; i < simSubscriptions.size(); i++) {
+    if (simSubscriptions[i] == topic) {
+      simSubscriptions.erase(simSubscriptions.begin() + i);
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,576 @@
+// 主机仿真：场景脚本、可观察输出、期望检查与报告
+//
+// 场景文件每行一条指令，时间为虚拟毫秒，# 开头的行为注释：
+//   end <ms>                            仿真结束时间（默认10000）
+//   camera on                           接入摄像头
+//   epoch <unix秒>                      NTP校时后的时间
+//   fingerprints <模板号...>            指纹模块中已录入的模板（默认1~5，模板号即手指编号）
+//   <ms> card <UID十六进制> [保持ms]      卡片进入读卡区（默认保持300ms）
+//   <ms> touch <手指编号> [保持ms]        手指按在指纹传感器上（0表示未录入的手指，默认保持800ms）
+//   <ms> key <按键序列> [按下ms]          依次按键（默认每键按下80ms，间隔150ms）
+//   <ms> door open|close [抖动次数]       门磁
+//   <ms> tamper on|off [抖动次数]         防拆开关
+//   <ms> motion on|off                  摄像头画面中有无运动
+//   <ms> wifi on|off                    网络恢复/断开
+//   <ms> mqtt <主题> <内容>              服务器下发消息
+//   <ms> serial <命令>                   串口输入一行
+//   <ms> expect <通道> [文本] [within <ms>]   此后一段时间内（默认1000ms）通道上出现含该文本的输出
+//   <ms> reject <通道> [文本] [within <ms>]   此后一段时间内通道上不出现含该文本的输出
+// 通道为MQTT主题，或 relay（继电器 on/off）、buzzer（蜂鸣器频率）、serial（串口输出行）、wifi
+
+#include <Arduino.h>
+#include <errno.h>
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <unistd.h>
+#include "sim.h"
+
+#define SIM_DEFAULT_END_MS        10000
+#define SIM_DEFAULT_CARD_HOLD_MS  300
+#define SIM_DEFAULT_TOUCH_HOLD_MS 800
+#define SIM_DEFAULT_KEY_HOLD_MS   80
+#define SIM_KEY_GAP_MS            150
+#define SIM_BOUNCE_INTERVAL_US    1000
+#define SIM_DEFAULT_WITHIN_MS     1000
+#define SIM_STIMULUS_EXPIRE_US    10000000
+#define SIM_CONSOLE_MAX_TEXT      200
+
+SimOptions simOptions;
+
+struct SimExpectation {
+  int line;
+  bool reject;
+  std::string channel;
+  std::string text;
+  uint64_t from;
+  uint64_t until;
+  uint64_t matchedAt;
+};
+
+struct SimStimulus {
+  std::string kind;
+  uint64_t time;
+};
+
+struct SimTopicStats {
+  uint64_t count;
+  uint64_t bytes;
+};
+
+static std::string simScenarioPath;
+static std::vector<SimExpectation> simExpectations;
+static std::vector<SimStimulus> simPendingStimuli;
+static std::map<std::string, std::vector<uint64_t>> simLatencies;
+static std::map<std::string, SimTopicStats> simTopics;
+static std::string simConsoleLine;
+
+// ==================== 输出 ====================
+
+static void sim_vprint(const char *format, va_list args) {
+  if (simOptions.quiet) {
+    return;
+  }
+  uint64_t now = sim_now();
+  printf("[%5llu.%06llu] ", (unsigned long long)(now / 1000000), (unsigned long long)(now % 1000000));
+  vprintf(format, args);
+}
+
+void sim_printf(const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  sim_vprint(format, args);
+  va_end(args);
+}
+
+/**
+ * 控制台显示用：二进制内容只显示长度，过长的文本截断
+ */
+static std::string sim_display_text(const std::string &text) {
+  for (unsigned char c : text) {
+    if (c < 0x20 && c != '\t') {
+      return "<" + std::to_string(text.size()) + " bytes>";
+    }
+  }
+  if (text.size() > SIM_CONSOLE_MAX_TEXT) {
+    size_t cut = SIM_CONSOLE_MAX_TEXT;
+    while (cut > 0 && ((unsigned char)text[cut] & 0xC0) == 0x80) {
+      cut--;
+    }
+    return text.substr(0, cut) + "...(" + std::to_string(text.size()) + " bytes)";
+  }
+  return text;
+}
+
+void sim_record(const std::string &channel, const std::string &text) {
+  if (channel == "serial") {
+    sim_printf("%s\n", text.c_str());
+  } else if (channel == "relay" || channel == "buzzer" || channel == "wifi") {
+    sim_printf("SIM %s %s\n", channel.c_str(), text.c_str());
+  } else {
+    sim_printf("MQTT> %s %s\n", channel.c_str(), sim_display_text(text).c_str());
+  }
+
+  uint64_t now = sim_now();
+  for (SimExpectation &expectation : simExpectations) {
+    if (expectation.matchedAt != SIM_FOREVER || now < expectation.from || now > expectation.until ||
+        expectation.channel != channel) {
+      continue;
+    }
+    if (text.find(expectation.text) != std::string::npos) {
+      expectation.matchedAt = now;
+      if (expectation.reject) {
+        sim_printf("SIM 第%d行 reject 命中: %s %s\n", expectation.line, channel.c_str(),
+                   expectation.text.c_str());
+      }
+    }
+  }
+}
+
+void sim_console_write(const uint8_t *data, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    char c = (char)data[i];
+    if (c == '\n') {
+      sim_record("serial", simConsoleLine);
+      simConsoleLine.clear();
+    } else if (c != '\r') {
+      simConsoleLine += c;
+    }
+  }
+}
+
+void sim_console_inject(const std::string &line) {
+  sim_printf("SERIAL< %s\n", line.c_str());
+  std::string data = line + "\n";
+  Serial.sim_receive((const uint8_t *)data.data(), data.size());
+}
+
+// ==================== 延迟统计 ====================
+
+void sim_stimulus(const char *kind) {
+  uint64_t now = sim_now();
+  simPendingStimuli.erase(std::remove_if(simPendingStimuli.begin(), simPendingStimuli.end(),
+                                         [now](const SimStimulus &s) { return now - s.time > SIM_STIMULUS_EXPIRE_US; }),
+                          simPendingStimuli.end());
+  simPendingStimuli.push_back({kind, now});
+}
+
+void sim_relay_on() {
+  if (simPendingStimuli.empty()) {
+    return;
+  }
+  // 继电器吸合归于最近的一次刺激（之前被拒绝的刺激不计）
+  const SimStimulus &stimulus = simPendingStimuli.back();
+  uint64_t latency = sim_now() - stimulus.time;
+  if (latency <= SIM_STIMULUS_EXPIRE_US) {
+    simLatencies[stimulus.kind].push_back(latency);
+  }
+  simPendingStimuli.clear();
+}
+
+void sim_mqtt_count(const std::string &topic, size_t bytes) {
+  SimTopicStats &stats = simTopics[topic];
+  stats.count++;
+  stats.bytes += bytes;
+}
+
+// ==================== 场景 ====================
+
+static bool sim_parse_uid(const std::string &hex, uint8_t *uid, uint8_t *size) {
+  if (hex.size() % 2 != 0 || (hex.size() != 8 && hex.size() != 14 && hex.size() != 20)) {
+    return false;
+  }
+  for (size_t i = 0; i < hex.size(); i += 2) {
+    char *end;
+    std::string byte = hex.substr(i, 2);
+    long value = strtol(byte.c_str(), &end, 16);
+    if (*end) {
+      return false;
+    }
+    uid[i / 2] = (uint8_t)value;
+  }
+  *size = hex.size() / 2;
+  return true;
+}
+
+static bool sim_parse_number(const std::string &text, uint64_t *value) {
+  if (text.empty()) {
+    return false;
+  }
+  char *end;
+  errno = 0;
+  unsigned long long parsed = strtoull(text.c_str(), &end, 10);
+  if (*end || errno) {
+    return false;
+  }
+  *value = parsed;
+  return true;
+}
+
+/**
+ * 解析一条带时间的指令并安排事件
+ * @return 错误信息，空表示成功
+ */
+static std::string sim_parse_timed(int line, uint64_t at, const std::string &command,
+                                   const std::vector<std::string> &args, const std::string &rest) {
+  uint64_t value;
+
+  if (command == "card") {
+    uint8_t uid[10];
+    uint8_t size;
+    if (args.empty() || !sim_parse_uid(args[0], uid, &size)) {
+      return "card 需要4/7/10字节的十六进制UID";
+    }
+    uint64_t hold = SIM_DEFAULT_CARD_HOLD_MS;
+    if (args.size() > 1 && !sim_parse_number(args[1], &hold)) {
+      return "保持时间无效";
+    }
+    std::string bytes((const char *)uid, size);
+    sim_at(at, [bytes, hold] { sim_rfid_present((const uint8_t *)bytes.data(), bytes.size(), hold * 1000); });
+  } else if (command == "touch") {
+    if (args.empty() || !sim_parse_number(args[0], &value) || value > 0xFFFE) {
+      return "touch 需要手指编号";
+    }
+    uint64_t hold = SIM_DEFAULT_TOUCH_HOLD_MS;
+    if (args.size() > 1 && !sim_parse_number(args[1], &hold)) {
+      return "保持时间无效";
+    }
+    uint16_t id = value;
+    sim_at(at, [id, hold] { sim_fingerprint_touch(id, hold * 1000); });
+  } else if (command == "key") {
+    if (args.empty()) {
+      return "key 需要按键序列";
+    }
+    uint64_t hold = SIM_DEFAULT_KEY_HOLD_MS;
+    if (args.size() > 1 && !sim_parse_number(args[1], &hold)) {
+      return "按下时间无效";
+    }
+    uint64_t t = at;
+    for (char key : args[0]) {
+      if (!strchr("0123456789ABCD*#", key)) {
+        return std::string("无效按键: ") + key;
+      }
+      sim_at(t, [key, hold] { sim_keypad_press(key, hold * 1000); });
+      t += (hold + SIM_KEY_GAP_MS) * 1000;
+    }
+  } else if (command == "door" || command == "tamper") {
+    if (args.empty() || (args[0] != "open" && args[0] != "close" && args[0] != "on" && args[0] != "off")) {
+      return command + " 需要 open/close 或 on/off";
+    }
+    uint64_t bounce = 0;
+    if (args.size() > 1 && !sim_parse_number(args[1], &bounce)) {
+      return "抖动次数无效";
+    }
+    // 驱动约定低电平表示门开/防拆触发；关门/恢复时释放，由上拉保持高电平
+    uint8_t pin = command == "door" ? 34 : 35;
+    int active = (args[0] == "open" || args[0] == "on") ? 0 : -1;
+    int inactive = active == 0 ? -1 : 0;
+    for (uint64_t k = 0; k <= bounce * 2; k++) {
+      int level = k % 2 == 0 ? active : inactive;
+      sim_at(at + k * SIM_BOUNCE_INTERVAL_US, [pin, level] { sim_gpio_drive(pin, level); });
+    }
+  } else if (command == "motion") {
+    if (args.empty() || (args[0] != "on" && args[0] != "off")) {
+      return "motion 需要 on/off";
+    }
+    bool on = args[0] == "on";
+    sim_at(at, [on] { sim_camera_motion(on); });
+  } else if (command == "wifi") {
+    if (args.empty() || (args[0] != "on" && args[0] != "off")) {
+      return "wifi 需要 on/off";
+    }
+    bool on = args[0] == "on";
+    sim_at(at, [on] { sim_wifi_set(on); });
+  } else if (command == "mqtt") {
+    if (args.size() < 2) {
+      return "mqtt 需要主题和内容";
+    }
+    std::string topic = args[0];
+    std::string payload = rest.substr(rest.find(topic) + topic.size());
+    payload.erase(0, payload.find_first_not_of(" \t"));
+    sim_at(at, [topic, payload] { sim_mqtt_inject(topic, payload); });
+  } else if (command == "serial") {
+    if (rest.empty()) {
+      return "serial 需要命令";
+    }
+    std::string text = rest;
+    sim_at(at, [text] { sim_console_inject(text); });
+  } else if (command == "expect" || command == "reject") {
+    std::vector<std::string> words = args;
+    uint64_t within = SIM_DEFAULT_WITHIN_MS;
+    if (words.size() >= 3 && words[words.size() - 2] == "within") {
+      if (!sim_parse_number(words.back(), &within)) {
+        return "within 时间无效";
+      }
+      words.resize(words.size() - 2);
+    }
+    if (words.empty()) {
+      return command + " 需要通道";
+    }
+    // 省略文本时匹配通道上的任意输出
+    std::string text = words.size() > 1 ? words[1] : "";
+    for (size_t i = 2; i < words.size(); i++) {
+      text += " " + words[i];
+    }
+    simExpectations.push_back({line, command == "reject", words[0], text, at, at + within * 1000, SIM_FOREVER});
+  } else {
+    return "未知指令: " + command;
+  }
+  return "";
+}
+
+uint64_t sim_scenario_load(const char *path) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    fprintf(stderr, "无法打开场景文件 %s: %s\n", path, strerror(errno));
+    return 0;
+  }
+  simScenarioPath = path;
+
+  uint64_t endMs = SIM_DEFAULT_END_MS;
+  char buffer[4096];
+  int line = 0;
+  bool ok = true;
+  while (fgets(buffer, sizeof(buffer), file)) {
+    line++;
+    std::string text = buffer;
+    while (!text.empty() && (text.back() == '\n' || text.back() == '\r' || text.back() == ' ')) {
+      text.pop_back();
+    }
+    size_t start = text.find_first_not_of(" \t");
+    if (start == std::string::npos || text[start] == '#') {
+      continue;
+    }
+    text = text.substr(start);
+
+    std::istringstream stream(text);
+    std::vector<std::string> words;
+    std::string word;
+    while (stream >> word) {
+      words.push_back(word);
+    }
+
+    std::string error;
+    uint64_t value;
+    if (words[0] == "end") {
+      if (words.size() < 2 || !sim_parse_number(words[1], &endMs)) {
+        error = "end 需要时间";
+      }
+    } else if (words[0] == "camera") {
+      simOptions.camera = words.size() < 2 || words[1] == "on";
+    } else if (words[0] == "epoch") {
+      if (words.size() < 2 || !sim_parse_number(words[1], &value)) {
+        error = "epoch 需要秒数";
+      } else {
+        simOptions.epoch = (time_t)value;
+      }
+    } else if (words[0] == "fingerprints") {
+      simOptions.fingerprints.clear();
+      for (size_t i = 1; i < words.size(); i++) {
+        if (!sim_parse_number(words[i], &value) || value > 0xFFFE) {
+          error = "模板号无效: " + words[i];
+          break;
+        }
+        simOptions.fingerprints.push_back(value);
+      }
+    } else if (sim_parse_number(words[0], &value)) {
+      if (words.size() < 2) {
+        error = "缺少指令";
+      } else {
+        // 指令之后的原始文本（mqtt内容、serial命令保留空格）
+        size_t commandAt = text.find(words[1], words[0].size());
+        std::string rest = text.substr(commandAt + words[1].size());
+        rest.erase(0, rest.find_first_not_of(" \t") == std::string::npos ? rest.size()
+                                                                           : rest.find_first_not_of(" \t"));
+        std::vector<std::string> args(words.begin() + 2, words.end());
+        error = sim_parse_timed(line, value * 1000, words[1], args, rest);
+      }
+    } else {
+      error = "行首应为时间(ms)或 end/camera/epoch/fingerprints";
+    }
+
+    if (!error.empty()) {
+      fprintf(stderr, "%s:%d: %s\n", path, line, error.c_str());
+      ok = false;
+    }
+  }
+  fclose(file);
+
+  if (!ok) {
+    return 0;
+  }
+  return endMs * 1000;
+}
+
+// ==================== 报告 ====================
+
+static double sim_ms(uint64_t us) {
+  return us / 1000.0;
+}
+
+static uint64_t sim_percentile(std::vector<uint64_t> samples, double fraction) {
+  std::sort(samples.begin(), samples.end());
+  size_t index = (size_t)(fraction * (samples.size() - 1) + 0.5);
+  return samples[index];
+}
+
+static std::string sim_json_string(const std::string &text) {
+  std::string out = "\"";
+  for (unsigned char c : text) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += (char)c;
+    } else if (c < 0x20) {
+      char escaped[8];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      out += escaped;
+    } else {
+      out += (char)c;
+    }
+  }
+  return out + "\"";
+}
+
+static bool sim_expectation_passed(const SimExpectation &expectation) {
+  bool matched = expectation.matchedAt != SIM_FOREVER;
+  return expectation.reject ? !matched : matched;
+}
+
+/**
+ * 每个核上任务忙时间之和
+ */
+static void sim_core_busy(uint64_t busy[2]) {
+  busy[0] = 0;
+  busy[1] = 0;
+  for (const SimTaskStats &task : sim_task_stats()) {
+    busy[task.core & 1] += task.busyUs;
+  }
+}
+
+static void sim_write_json(uint64_t now, int failed) {
+  FILE *out = fopen(simOptions.reportJson.c_str(), "w");
+  if (!out) {
+    fprintf(stderr, "无法写入报告 %s: %s\n", simOptions.reportJson.c_str(), strerror(errno));
+    return;
+  }
+
+  fprintf(out, "{\n  \"scenario\": %s,\n", sim_json_string(simScenarioPath).c_str());
+  uint64_t coreBusy[2];
+  sim_core_busy(coreBusy);
+  fprintf(out, "  \"virtual_ms\": %.3f,\n  \"core_busy_ms\": [%.3f, %.3f],\n", sim_ms(now), sim_ms(coreBusy[0]),
+          sim_ms(coreBusy[1]));
+
+  fprintf(out, "  \"tasks\": [");
+  std::vector<SimTaskStats> tasks = sim_task_stats();
+  for (size_t i = 0; i < tasks.size(); i++) {
+    fprintf(out, "%s\n    {\"name\": %s, \"priority\": %u, \"core\": %d, \"switches\": %llu, \"timeouts\": %llu, "
+                 "\"busy_ms\": %.3f}",
+            i ? "," : "", sim_json_string(tasks[i].name).c_str(), tasks[i].priority, tasks[i].core,
+            (unsigned long long)tasks[i].switches, (unsigned long long)tasks[i].timeouts, sim_ms(tasks[i].busyUs));
+  }
+  fprintf(out, "\n  ],\n");
+
+  fprintf(out, "  \"relay_latency\": {");
+  bool first = true;
+  for (auto &entry : simLatencies) {
+    fprintf(out, "%s\n    %s: {\"count\": %zu, \"p50_ms\": %.3f, \"max_ms\": %.3f, \"samples_ms\": [",
+            first ? "" : ",", sim_json_string(entry.first).c_str(), entry.second.size(),
+            sim_ms(sim_percentile(entry.second, 0.5)), sim_ms(sim_percentile(entry.second, 1.0)));
+    for (size_t i = 0; i < entry.second.size(); i++) {
+      fprintf(out, "%s%.3f", i ? ", " : "", sim_ms(entry.second[i]));
+    }
+    fprintf(out, "]}");
+    first = false;
+  }
+  fprintf(out, "\n  },\n");
+
+  fprintf(out, "  \"mqtt\": {");
+  first = true;
+  for (auto &entry : simTopics) {
+    fprintf(out, "%s\n    %s: {\"count\": %llu, \"bytes\": %llu}", first ? "" : ",",
+            sim_json_string(entry.first).c_str(), (unsigned long long)entry.second.count,
+            (unsigned long long)entry.second.bytes);
+    first = false;
+  }
+  fprintf(out, "\n  },\n");
+
+  fprintf(out, "  \"expectations\": [");
+  for (size_t i = 0; i < simExpectations.size(); i++) {
+    const SimExpectation &e = simExpectations[i];
+    fprintf(out, "%s\n    {\"line\": %d, \"kind\": \"%s\", \"channel\": %s, \"text\": %s, \"passed\": %s",
+            i ? "," : "", e.line, e.reject ? "reject" : "expect", sim_json_string(e.channel).c_str(),
+            sim_json_string(e.text).c_str(), sim_expectation_passed(e) ? "true" : "false");
+    if (e.matchedAt != SIM_FOREVER) {
+      fprintf(out, ", \"after_ms\": %.3f", sim_ms(e.matchedAt - e.from));
+    }
+    fprintf(out, "}");
+  }
+  fprintf(out, "\n  ],\n  \"failed\": %d\n}\n", failed);
+  fclose(out);
+}
+
+void sim_finish() {
+  uint64_t now = sim_now();
+  if (!simConsoleLine.empty()) {
+    sim_record("serial", simConsoleLine);
+    simConsoleLine.clear();
+  }
+
+  int failed = 0;
+  for (const SimExpectation &expectation : simExpectations) {
+    if (!sim_expectation_passed(expectation)) {
+      failed++;
+    }
+  }
+
+  printf("\n======== 仿真报告: %s ========\n", simScenarioPath.c_str());
+  uint64_t coreBusy[2];
+  sim_core_busy(coreBusy);
+  printf("虚拟时间 %.3f s，核0忙 %.1f%%，核1忙 %.1f%%\n", now / 1e6, now ? 100.0 * coreBusy[0] / now : 0.0,
+         now ? 100.0 * coreBusy[1] / now : 0.0);
+
+  printf("\n%-20s %6s %4s %10s %10s %12s %7s\n", "任务", "优先级", "核", "切换", "超时唤醒", "忙时间(ms)", "占比");
+  for (const SimTaskStats &task : sim_task_stats()) {
+    printf("%-20s %6u %4d %10llu %10llu %12.3f %6.2f%%\n", task.name.c_str(), task.priority, task.core,
+           (unsigned long long)task.switches, (unsigned long long)task.timeouts, sim_ms(task.busyUs),
+           now ? 100.0 * task.busyUs / now : 0.0);
+  }
+
+  if (!simLatencies.empty()) {
+    printf("\n%-10s %6s %10s %10s\n", "刺激→继电器", "次数", "p50(ms)", "最大(ms)");
+    for (auto &entry : simLatencies) {
+      printf("%-10s %6zu %10.3f %10.3f\n", entry.first.c_str(), entry.second.size(),
+             sim_ms(sim_percentile(entry.second, 0.5)), sim_ms(sim_percentile(entry.second, 1.0)));
+    }
+  }
+
+  if (!simTopics.empty()) {
+    printf("\n%-36s %6s %10s\n", "MQTT发布", "次数", "字节");
+    for (auto &entry : simTopics) {
+      printf("%-36s %6llu %10llu\n", entry.first.c_str(), (unsigned long long)entry.second.count,
+             (unsigned long long)entry.second.bytes);
+    }
+  }
+
+  if (!simExpectations.empty()) {
+    printf("\n期望: %zu 条，失败 %d 条\n", simExpectations.size(), failed);
+    for (const SimExpectation &e : simExpectations) {
+      bool passed = sim_expectation_passed(e);
+      printf("  %s 第%d行 %s %s \"%s\"", passed ? "通过" : "失败", e.line, e.reject ? "reject" : "expect",
+             e.channel.c_str(), e.text.c_str());
+      if (e.matchedAt != SIM_FOREVER) {
+        printf("（%.3f ms 后出现）", sim_ms(e.matchedAt - e.from));
+      }
+      printf("\n");
+    }
+  }
+
+  if (!simOptions.reportJson.empty()) {
+    sim_write_json(now, failed);
+  }
+
+  fflush(stdout);
+  fflush(stderr);
+  sim_sd_cleanup();
+  _exit(failed ? 1 : 0);
+}
@@ -0,0 +1,271 @@
+// 主机仿真：SD卡（映射到主机目录）
+// SPI SD卡典型速度：打开文件约1ms，读写每次约100us加每4字节1us（约4MB/s）
+
+#include <SD.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <ftw.h>
+#include "sim.h"
+
+#define SIM_SD_OPEN_US        1000
+#define SIM_SD_ACCESS_US      100
+#define SIM_SD_BYTES_PER_US   4
+#define SIM_SD_CAPACITY       (8ULL * 1024 * 1024 * 1024)
+
+SDFS SD;
+
+static std::string simSdRoot;
+static bool simSdTemporary = false;
+
+struct SimFileHandle {
+  std::string path;             // SD卡上的路径
+  FILE *file = NULL;
+  DIR *dir = NULL;
+
+  ~SimFileHandle() {
+    if (file) {
+      fclose(file);
+    }
+    if (dir) {
+      closedir(dir);
+    }
+  }
+};
+
+static std::string sim_sd_host_path(const char *path) {
+  std::string sdPath = path && path[0] == '/' ? path : std::string("/") + (path ? path : "");
+  return simSdRoot + sdPath;
+}
+
+static void sim_sd_transfer(size_t bytes) {
+  sim_busy(SIM_SD_ACCESS_US + bytes / SIM_SD_BYTES_PER_US);
+}
+
+void sim_sd_init() {
+  if (!simOptions.sdDir.empty()) {
+    simSdRoot = simOptions.sdDir;
+    mkdir(simSdRoot.c_str(), 0755);
+    return;
+  }
+  char pattern[] = "/tmp/access-sim-sd-XXXXXX";
+  if (mkdtemp(pattern)) {
+    simSdRoot = pattern;
+    simSdTemporary = true;
+  }
+}
+
+static int sim_sd_remove_entry(const char *path, const struct stat *, int, struct FTW *) {
+  return ::remove(path);
+}
+
+void sim_sd_cleanup() {
+  if (simSdTemporary) {
+    nftw(simSdRoot.c_str(), sim_sd_remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+  }
+}
+
+// ==================== File ====================
+
+size_t File::write(const uint8_t *buffer, size_t size) {
+  if (!handle_ || !handle_->file) {
+    return 0;
+  }
+  sim_sd_transfer(size);
+  return fwrite(buffer, 1, size, handle_->file);
+}
+
+int File::available() {
+  if (!handle_ || !handle_->file) {
+    return 0;
+  }
+  long position = ftell(handle_->file);
+  fseek(handle_->file, 0, SEEK_END);
+  long end = ftell(handle_->file);
+  fseek(handle_->file, position, SEEK_SET);
+  return (int)(end - position);
+}
+
+int File::read() {
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+int File::peek() {
+  if (!handle_ || !handle_->file) {
+    return -1;
+  }
+  int c = fgetc(handle_->file);
+  if (c != EOF) {
+    ungetc(c, handle_->file);
+  }
+  return c == EOF ? -1 : c;
+}
+
+void File::flush() {
+  if (handle_ && handle_->file) {
+    fflush(handle_->file);
+    sim_busy(SIM_SD_OPEN_US);
+  }
+}
+
+size_t File::read(uint8_t *buffer, size_t size) {
+  if (!handle_ || !handle_->file) {
+    return 0;
+  }
+  sim_sd_transfer(size);
+  return fread(buffer, 1, size, handle_->file);
+}
+
+bool File::seek(uint32_t position) {
+  return handle_ && handle_->file && fseek(handle_->file, position, SEEK_SET) == 0;
+}
+
+size_t File::position() {
+  return handle_ && handle_->file ? (size_t)ftell(handle_->file) : 0;
+}
+
+size_t File::size() {
+  if (!handle_ || !handle_->file) {
+    return 0;
+  }
+  fflush(handle_->file);
+  struct stat st;
+  return fstat(fileno(handle_->file), &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+void File::close() {
+  if (handle_) {
+    sim_busy(SIM_SD_ACCESS_US);
+  }
+  handle_.reset();
+}
+
+const char *File::name() const {
+  if (!handle_) {
+    return "";
+  }
+  size_t slash = handle_->path.rfind('/');
+  return handle_->path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+}
+
+const char *File::path() const {
+  return handle_ ? handle_->path.c_str() : "";
+}
+
+bool File::isDirectory() const {
+  return handle_ && handle_->dir;
+}
+
+File File::openNextFile(const char *mode) {
+  if (!handle_ || !handle_->dir) {
+    return File();
+  }
+  struct dirent *entry;
+  while ((entry = readdir(handle_->dir)) != NULL) {
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+      continue;
+    }
+    std::string child = handle_->path;
+    if (child.empty() || child.back() != '/') {
+      child += '/';
+    }
+    child += entry->d_name;
+    return SD.open(child.c_str(), mode);
+  }
+  return File();
+}
+
+void File::rewindDirectory() {
+  if (handle_ && handle_->dir) {
+    rewinddir(handle_->dir);
+  }
+}
+
+File::operator bool() const {
+  return handle_ && (handle_->file || handle_->dir);
+}
+
+// ==================== SDFS ====================
+
+bool SDFS::begin(uint8_t ssPin) {
+  (void)ssPin;
+  sim_busy(SIM_SD_OPEN_US * 20);
+  return !simSdRoot.empty();
+}
+
+sdcard_type_t SDFS::cardType() {
+  return simSdRoot.empty() ? CARD_NONE : CARD_SDHC;
+}
+
+uint64_t SDFS::cardSize() {
+  return SIM_SD_CAPACITY;
+}
+
+uint64_t SDFS::totalBytes() {
+  return SIM_SD_CAPACITY;
+}
+
+static uint64_t simSdUsed;
+
+static int sim_sd_count_entry(const char *, const struct stat *st, int flag, struct FTW *) {
+  if (flag == FTW_F) {
+    simSdUsed += st->st_size;
+  }
+  return 0;
+}
+
+uint64_t SDFS::usedBytes() {
+  simSdUsed = 0;
+  nftw(simSdRoot.c_str(), sim_sd_count_entry, 16, FTW_PHYS);
+  return simSdUsed;
+}
+
+File SDFS::open(const char *path, const char *mode, bool create) {
+  (void)create;
+  sim_busy(SIM_SD_OPEN_US);
+  std::string hostPath = sim_sd_host_path(path);
+  auto handle = std::make_shared<SimFileHandle>();
+  handle->path = path && path[0] == '/' ? path : std::string("/") + (path ? path : "");
+
+  struct stat st;
+  if (stat(hostPath.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+    handle->dir = opendir(hostPath.c_str());
+    return handle->dir ? File(handle) : File();
+  }
+
+  const char *hostMode = "rb";
+  if (strcmp(mode, FILE_WRITE) == 0) {
+    hostMode = "w+b";
+  } else if (strcmp(mode, FILE_APPEND) == 0) {
+    hostMode = "a+b";
+  }
+  handle->file = fopen(hostPath.c_str(), hostMode);
+  return handle->file ? File(handle) : File();
+}
+
+bool SDFS::exists(const char *path) {
+  sim_busy(SIM_SD_ACCESS_US);
+  struct stat st;
+  return stat(sim_sd_host_path(path).c_str(), &st) == 0;
+}
+
+bool SDFS::remove(const char *path) {
+  sim_busy(SIM_SD_OPEN_US);
+  return ::unlink(sim_sd_host_path(path).c_str()) == 0;
+}
+
+bool SDFS::rename(const char *from, const char *to) {
+  sim_busy(SIM_SD_OPEN_US);
+  return ::rename(sim_sd_host_path(from).c_str(), sim_sd_host_path(to).c_str()) == 0;
+}
+
+bool SDFS::mkdir(const char *path) {
+  sim_busy(SIM_SD_OPEN_US);
+  return ::mkdir(sim_sd_host_path(path).c_str(), 0755) == 0;
+}
+
+bool SDFS::rmdir(const char *path) {
+  sim_busy(SIM_SD_OPEN_US);
+  return ::rmdir(sim_sd_host_path(path).c_str()) == 0;
+}
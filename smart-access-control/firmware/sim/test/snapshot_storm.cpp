@@ -0,0 +1,435 @@
+// 用户库RCU快照并发主机测试（真实线程，不经过仿真内核）
+//
+// user_snapshot.c、credential_index.c、bloom_filter.c 原样编译；本文件用 pthread 提供它们用到的
+// FreeRTOS 接口（互斥锁、任务句柄、vTaskDelay）和串口，闪存用户库视为未挂载。
+//   - 读者线程（3个，对应访问控制、通信、安全任务）不停按卡号、指纹、密码查找，
+//     记录每次 read_lock + 查找 + read_unlock 的耗时
+//   - 先运行一段无写者的基准，再启动写者风暴：连续发布增量批次（新增/换卡、启用、禁用、删除），
+//     每64批穿插一次全量替换
+// 检查：
+//   - 常驻用户（写者不修改）的三种凭证始终命中且用户ID正确
+//   - 风暴用户的卡只可能查到0或本人，未登记的卡始终为0
+//   - 停止后全部旧快照被回收（回收数 = 发布数）
+// 输出两个阶段的查找耗时 p50/p99/p99.9/最大值、发布与回收次数、写者等待回收的次数。
+//
+// 编译运行（firmware 目录下）:
+//   c++ -std=gnu++17 -O2 -pthread -Isim/include -Isrc -x c++ src/modules/user_snapshot.c src/modules/credential_index.c src/modules/bloom_filter.c -x none sim/test/snapshot_storm.cpp -o snapshot_storm && ./snapshot_storm
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "modules/user_snapshot.h"
+#include "modules/user_db.h"
+
+#define READER_COUNT       3
+#define RESIDENT_USERS     1000
+#define STORM_USERS        500
+#define STORM_BATCH_MAX    32
+#define FULL_REPLACE_EVERY 64
+
+#define QUIET_MS  1000
+#define STORM_MS  3000
+
+// 每个读者每阶段最多保留的耗时样本
+#define MAX_SAMPLES  (1 << 22)
+
+// ==================== FreeRTOS 与串口（主机线程版） ====================
+
+struct SimMutex {
+  pthread_mutex_t mutex;
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+  SimMutex *mutex = new SimMutex;
+  pthread_mutex_init(&mutex->mutex, NULL);
+  return mutex;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t ticks) {
+  (void)ticks;
+  pthread_mutex_lock(&mutex->mutex);
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex) {
+  pthread_mutex_unlock(&mutex->mutex);
+  return pdTRUE;
+}
+
+// 每个线程一个任务句柄
+static thread_local char taskTag;
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+  return (TaskHandle_t)&taskTag;
+}
+
+void vTaskDelay(TickType_t ticks) {
+  usleep(ticks * portTICK_PERIOD_MS * 1000);
+}
+
+// 无PSRAM，按能力分配都来自主机堆
+bool psramFound() {
+  return false;
+}
+
+void *heap_caps_malloc(size_t size, unsigned int caps) {
+  (void)caps;
+  return malloc(size);
+}
+
+void *heap_caps_calloc(size_t count, size_t size, unsigned int caps) {
+  (void)caps;
+  return calloc(count, size);
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t written = 0;
+  while (size--) {
+    written += write(*buffer++);
+  }
+  return written;
+}
+
+size_t Print::printf(const char *format, ...) {
+  char text[256];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+  return write((const uint8_t *)text, std::min<size_t>(length, sizeof(text) - 1));
+}
+
+int HardwareSerial::available() {
+  return 0;
+}
+
+int HardwareSerial::read() {
+  return -1;
+}
+
+int HardwareSerial::peek() {
+  return -1;
+}
+
+// 快照模块的串口输出（过滤器大小等）不打印
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+  (void)buffer;
+  return size;
+}
+
+HardwareSerial Serial(0);
+
+// 与 rfid_driver.c 一致
+bool rfid_uid_equals(const CardUid *a, const CardUid *b) {
+  return memcmp(a, b, sizeof(CardUid)) == 0;
+}
+
+// 闪存用户库未挂载
+bool user_db_is_mounted() { return false; }
+uint32_t user_db_get_version() { return 0; }
+uint32_t user_db_get_card_count() { return 0; }
+const UserDbCardEntry *user_db_get_card_entry(uint32_t index) { (void)index; return NULL; }
+const UserDbUser *user_db_get_user(uint32_t index) { (void)index; return NULL; }
+const UserDbUser *user_db_find_user(uint32_t userId) { (void)userId; return NULL; }
+const UserDbUser *user_db_find_card(const CardUid *card) { (void)card; return NULL; }
+const UserDbUser *user_db_find_fingerprint(uint32_t fingerprintId) { (void)fingerprintId; return NULL; }
+const UserDbUser *user_db_find_password(const char *password) { (void)password; return NULL; }
+bool user_db_check_password(const UserDbUser *user, const char *password) { (void)user; (void)password; return false; }
+
+// ==================== 用户 ====================
+
+static void make_card(CardUid *card, uint8_t prefix, uint32_t id, uint8_t variant) {
+  memset(card, 0, sizeof(CardUid));
+  card->size = 7;
+  card->bytes[0] = prefix;
+  card->bytes[1] = (uint8_t)(id >> 16);
+  card->bytes[2] = (uint8_t)(id >> 8);
+  card->bytes[3] = (uint8_t)id;
+  card->bytes[4] = variant;
+}
+
+static void make_user(User *user, int id, uint8_t variant) {
+  memset(user, 0, sizeof(User));
+  user->id = id;
+  snprintf(user->name, sizeof(user->name), "用户%d", id);
+  make_card(&user->card, 0x04, id, variant);
+  user->fingerprintId = id;
+  snprintf(user->password, sizeof(user->password), "%06d", 100000 + id);
+  user->enabled = true;
+}
+
+// 写者维护的风暴用户状态
+struct StormUser {
+  bool present;
+  bool enabled;
+  uint8_t variant;
+};
+
+static StormUser stormUsers[STORM_USERS];
+
+static int storm_id(int i) {
+  return RESIDENT_USERS + 1 + i;
+}
+
+// ==================== 读者 ====================
+
+enum Phase { PHASE_QUIET, PHASE_STORM, PHASE_COUNT };
+
+static std::atomic<int> phase(PHASE_QUIET);
+static std::atomic<bool> stopReaders(false);
+static std::atomic<bool> stopWriter(false);
+
+struct Reader {
+  pthread_t thread;
+  uint32_t rng;
+  std::vector<uint32_t> samples[PHASE_COUNT];
+  uint64_t lookups[PHASE_COUNT];
+  uint64_t violations;
+};
+
+static Reader readers[READER_COUNT];
+
+static uint32_t next_random(uint32_t *state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+  return *state;
+}
+
+static uint64_t now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void *reader_main(void *arg) {
+  Reader *reader = (Reader *)arg;
+
+  while (!stopReaders.load(std::memory_order_relaxed)) {
+    uint32_t r = next_random(&reader->rng);
+    int kind = r % 5;
+    int resident = 1 + (r >> 8) % RESIDENT_USERS;
+    int storm = storm_id((r >> 8) % STORM_USERS);
+    CardUid card;
+    char password[8];
+
+    switch (kind) {
+      case 0:
+      case 1:
+        make_card(&card, 0x04, kind == 0 ? resident : storm, (r >> 24) % 4);
+        if (kind == 0) {
+          card.bytes[4] = 0;
+        }
+        break;
+      case 2:
+        make_card(&card, 0x20, r >> 8, 0);   // 未登记
+        break;
+      case 4:
+        snprintf(password, sizeof(password), "%06d", 100000 + resident);
+        break;
+    }
+
+    uint64_t start = now_ns();
+    const UserSnapshot *snapshot = user_snapshot_read_lock();
+    int userId;
+    if (kind == 3) {
+      userId = user_snapshot_find_fingerprint(snapshot, resident, NULL);
+    } else if (kind == 4) {
+      userId = user_snapshot_find_password(snapshot, password, NULL);
+    } else {
+      userId = user_snapshot_find_card(snapshot, &card, NULL);
+    }
+    user_snapshot_read_unlock();
+    uint64_t elapsed = now_ns() - start;
+
+    bool ok;
+    if (kind == 1) {
+      ok = (userId == 0 || userId == storm);
+    } else if (kind == 2) {
+      ok = (userId == 0);
+    } else {
+      ok = (userId == resident);
+    }
+    if (!ok) {
+      reader->violations++;
+    }
+
+    int current = phase.load(std::memory_order_relaxed);
+    reader->lookups[current]++;
+    if (reader->samples[current].size() < MAX_SAMPLES) {
+      reader->samples[current].push_back((uint32_t)std::min<uint64_t>(elapsed, UINT32_MAX));
+    }
+  }
+  return NULL;
+}
+
+// ==================== 写者 ====================
+
+static uint32_t writerRng = 0x2545F491;
+static uint32_t dbVersion = 1;
+static uint32_t incrementalBatches = 0;
+static uint32_t fullReplaces = 0;
+static uint32_t failedPublishes = 0;
+
+static void writer_full_replace() {
+  std::vector<User> users;
+  users.reserve(RESIDENT_USERS + STORM_USERS);
+  for (int id = 1; id <= RESIDENT_USERS; id++) {
+    User user;
+    make_user(&user, id, 0);
+    users.push_back(user);
+  }
+  for (int i = 0; i < STORM_USERS; i++) {
+    if (stormUsers[i].present) {
+      User user;
+      make_user(&user, storm_id(i), stormUsers[i].variant);
+      user.enabled = stormUsers[i].enabled;
+      users.push_back(user);
+    }
+  }
+
+  if (user_snapshot_replace(users.data(), users.size(), ++dbVersion)) {
+    fullReplaces++;
+  } else {
+    failedPublishes++;
+  }
+}
+
+static void writer_batch() {
+  IdentityUpdate updates[STORM_BATCH_MAX];
+  int count = 1 + next_random(&writerRng) % STORM_BATCH_MAX;
+
+  for (int n = 0; n < count; n++) {
+    uint32_t r = next_random(&writerRng);
+    int i = (r >> 8) % STORM_USERS;
+    StormUser *user = &stormUsers[i];
+    IdentityUpdate *update = &updates[n];
+    memset(update, 0, sizeof(IdentityUpdate));
+    update->user.id = storm_id(i);
+
+    switch (r % 4) {
+      case 0:
+        // 新增或换卡
+        user->present = true;
+        user->enabled = true;
+        user->variant = (user->variant + 1) % 4;
+        update->type = IDENTITY_UPDATE_ADD;
+        make_user(&update->user, storm_id(i), user->variant);
+        break;
+      case 1:
+        update->type = IDENTITY_UPDATE_ENABLE;
+        user->enabled = user->present;
+        break;
+      case 2:
+        update->type = IDENTITY_UPDATE_DISABLE;
+        user->enabled = false;
+        break;
+      case 3:
+        update->type = IDENTITY_UPDATE_DELETE;
+        user->present = false;
+        user->enabled = false;
+        break;
+    }
+  }
+
+  if (user_snapshot_apply(updates, count, ++dbVersion) >= 0) {
+    incrementalBatches++;
+  } else {
+    failedPublishes++;
+  }
+}
+
+static void *writer_main(void *arg) {
+  (void)arg;
+  uint32_t batch = 0;
+  while (!stopWriter.load(std::memory_order_relaxed)) {
+    if (++batch % FULL_REPLACE_EVERY == 0) {
+      writer_full_replace();
+    } else {
+      writer_batch();
+    }
+  }
+  return NULL;
+}
+
+// ==================== 主程序 ====================
+
+static void print_phase(const char *name, int which) {
+  std::vector<uint32_t> all;
+  uint64_t lookups = 0;
+  for (Reader &reader : readers) {
+    all.insert(all.end(), reader.samples[which].begin(), reader.samples[which].end());
+    lookups += reader.lookups[which];
+  }
+  if (all.empty()) {
+    printf("%-10s 无样本\n", name);
+    return;
+  }
+
+  std::sort(all.begin(), all.end());
+  auto percentile = [&](double p) { return all[std::min(all.size() - 1, (size_t)(all.size() * p))]; };
+  printf("%-10s %12llu %10u %10u %10u %10u\n", name, (unsigned long long)lookups,
+         percentile(0.50), percentile(0.99), percentile(0.999), all.back());
+}
+
+int main() {
+  std::vector<User> residents(RESIDENT_USERS);
+  for (int id = 1; id <= RESIDENT_USERS; id++) {
+    make_user(&residents[id - 1], id, 0);
+  }
+  if (!user_snapshot_init(residents.data(), RESIDENT_USERS)) {
+    printf("快照初始化失败\n");
+    return 1;
+  }
+
+  for (int i = 0; i < READER_COUNT; i++) {
+    readers[i].rng = 0x9E3779B9u * (i + 1);
+    readers[i].samples[PHASE_QUIET].reserve(MAX_SAMPLES);
+    readers[i].samples[PHASE_STORM].reserve(MAX_SAMPLES);
+    pthread_create(&readers[i].thread, NULL, reader_main, &readers[i]);
+  }
+
+  usleep(QUIET_MS * 1000);
+  phase.store(PHASE_STORM);
+  pthread_t writer;
+  pthread_create(&writer, NULL, writer_main, NULL);
+  usleep(STORM_MS * 1000);
+
+  stopWriter.store(true);
+  pthread_join(writer, NULL);
+  stopReaders.store(true);
+  for (Reader &reader : readers) {
+    pthread_join(reader.thread, NULL);
+  }
+
+  // 读者都已退出，剩余的旧快照应全部可回收
+  user_snapshot_reclaim();
+
+  uint32_t published, reclaimed, retireWaits;
+  user_snapshot_get_reclaim_stats(&published, &reclaimed, &retireWaits);
+  uint64_t violations = 0;
+  for (Reader &reader : readers) {
+    violations += reader.violations;
+  }
+
+  printf("%d个读者，常驻用户%d，风暴用户%d\n", READER_COUNT, RESIDENT_USERS, STORM_USERS);
+  printf("%-10s %12s %10s %10s %10s %10s\n", "阶段", "查找次数", "p50(ns)", "p99(ns)", "p99.9(ns)", "最大(ns)");
+  print_phase("无写者", PHASE_QUIET);
+  print_phase("写者风暴", PHASE_STORM);
+  printf("发布: 增量%u批, 全量%u次, 失败%u次\n", incrementalBatches, fullReplaces, failedPublishes);
+  printf("快照: 发布%u, 回收%u, 写者等待回收%u次\n", published, reclaimed, retireWaits);
+  printf("读者不一致: %llu\n", (unsigned long long)violations);
+
+  bool ok = violations == 0 && failedPublishes == 0 && reclaimed == published;
+  printf("%s\n", ok ? "通过" : "失败");
+  return ok ? 0 : 1;
+}
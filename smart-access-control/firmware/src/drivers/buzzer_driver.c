@@ -0,0 +1,137 @@
+#include <Arduino.h>
+#include "esp_timer.h"
+
+// 头文件包含
+#include "drivers/buzzer_driver.h"
+#include "drivers/tone_sequencer.h"
+
+// 蜂鸣器引脚
+#define BUZZER_PIN  12
+
+// LEDC通道：通道0和定时器0供摄像头XCLK使用，通道2使用高速定时器1
+#define BUZZER_LEDC_CHANNEL     2
+#define BUZZER_LEDC_RESOLUTION  10
+
+// 蜂鸣器状态
+bool buzzerInitialized = false;
+
+// 播放状态（各任务和定时器任务访问，互斥访问）
+ToneSequencer buzzerSequencer;
+SemaphoreHandle_t buzzerMutex = NULL;
+esp_timer_handle_t buzzerTimer = NULL;
+uint16_t buzzerFrequency = 0;
+
+/**
+ * 按播放状态输出PWM并设置下一次推进的定时器（持有互斥锁时调用）
+ * @param wait 距下一次变化的时间(ms)，TONE_IDLE表示空闲
+ */
+static void buzzer_apply(int32_t wait) {
+  if (buzzerSequencer.frequency != buzzerFrequency) {
+    buzzerFrequency = buzzerSequencer.frequency;
+    if (buzzerFrequency > 0) {
+      ledcWriteTone(BUZZER_LEDC_CHANNEL, buzzerFrequency);
+    } else {
+      ledcWrite(BUZZER_LEDC_CHANNEL, 0);
+    }
+  }
+
+  esp_timer_stop(buzzerTimer);
+  if (wait != TONE_IDLE) {
+    esp_timer_start_once(buzzerTimer, (uint64_t)wait * 1000);
+  }
+}
+
+/**
+ * 定时器回调（esp_timer任务中执行）
+ */
+static void buzzer_timer(void *arg) {
+  xSemaphoreTake(buzzerMutex, portMAX_DELAY);
+  buzzer_apply(tone_sequencer_advance(&buzzerSequencer, millis()));
+  xSemaphoreGive(buzzerMutex);
+}
+
+/**
+ * 蜂鸣器初始化
+ */
+void buzzer_init() {
+  buzzerMutex = xSemaphoreCreateMutex();
+  esp_timer_create_args_t timerArgs = {};
+  timerArgs.callback = buzzer_timer;
+  timerArgs.name = "buzzer";
+  if (!buzzerMutex || esp_timer_create(&timerArgs, &buzzerTimer) != ESP_OK) {
+    Serial.println("蜂鸣器初始化失败");
+    return;
+  }
+
+  ledcSetup(BUZZER_LEDC_CHANNEL, 2000, BUZZER_LEDC_RESOLUTION);
+  ledcAttachPin(BUZZER_PIN, BUZZER_LEDC_CHANNEL);
+  ledcWrite(BUZZER_LEDC_CHANNEL, 0);
+  tone_sequencer_init(&buzzerSequencer);
+
+  buzzerInitialized = true;
+  Serial.println("蜂鸣器初始化完成");
+}
+
+/**
+ * 播放提示音
+ * @param id 提示音
+ * @return 是否开始播放
+ */
+bool buzzer_play(TonePatternId id) {
+  if (!buzzerInitialized) {
+    return false;
+  }
+
+  xSemaphoreTake(buzzerMutex, portMAX_DELAY);
+  uint32_t now = millis();
+  bool started = tone_sequencer_play(&buzzerSequencer, id, now);
+  buzzer_apply(tone_sequencer_advance(&buzzerSequencer, now));
+  xSemaphoreGive(buzzerMutex);
+  return started;
+}
+
+/**
+ * 停止提示音
+ * @param id 提示音
+ */
+void buzzer_stop(TonePatternId id) {
+  if (!buzzerInitialized) {
+    return;
+  }
+
+  xSemaphoreTake(buzzerMutex, portMAX_DELAY);
+  uint32_t now = millis();
+  tone_sequencer_stop(&buzzerSequencer, id, now);
+  buzzer_apply(tone_sequencer_advance(&buzzerSequencer, now));
+  xSemaphoreGive(buzzerMutex);
+}
+
+/**
+ * 检查蜂鸣器状态
+ * @return 是否初始化成功
+ */
+bool buzzer_is_initialized() {
+  return buzzerInitialized;
+}
+
+/**
+ * 测试蜂鸣器
+ * 依次播放全部提示音，循环提示音播放3秒后停止
+ */
+void buzzer_test() {
+  if (!buzzerInitialized) {
+    Serial.println("蜂鸣器未初始化");
+    return;
+  }
+
+  Serial.println("蜂鸣器测试开始...");
+  for (int i = 0; i < TONE_PATTERN_COUNT; i++) {
+    const TonePattern *pattern = tone_pattern((TonePatternId)i);
+    Serial.printf("提示音: %s\n", pattern->name);
+    buzzer_play((TonePatternId)i);
+    delay(3000);
+    buzzer_stop((TonePatternId)i);
+    delay(500);
+  }
+  Serial.println("蜂鸣器测试完成");
+}
@@ -0,0 +1,38 @@
+#ifndef BUZZER_DRIVER_H
+#define BUZZER_DRIVER_H
+
+#include <Arduino.h>
+
+// 头文件包含
+#include "drivers/tone_sequencer.h"
+
+/**
+ * 蜂鸣器初始化
+ */
+void buzzer_init();
+
+/**
+ * 播放提示音（立即返回，由定时器推进）
+ * @param id 提示音
+ * @return 是否开始播放（正在播放更高优先级的提示音时为false）
+ */
+bool buzzer_play(TonePatternId id);
+
+/**
+ * 停止提示音
+ * @param id 提示音
+ */
+void buzzer_stop(TonePatternId id);
+
+/**
+ * 检查蜂鸣器状态
+ * @return 是否初始化成功
+ */
+bool buzzer_is_initialized();
+
+/**
+ * 测试蜂鸣器
+ */
+void buzzer_test();
+
+#endif
@@ -1,5 +1,10 @@
 #include <Arduino.h>
+#include <esp_heap_caps.h>
 #include "esp_camera.h"
+#include "img_converters.h"
+
+// 头文件包含
+#include "drivers/camera_driver.h"
 
 // 摄像头引脚定义
 #define PWDN_GPIO_NUM     32
@@ -21,8 +26,17 @@
 #define HREF_GPIO_NUM     23
 #define PCLK_GPIO_NUM     22
 
+// 帧缓冲区数：事件录像帧槽 + 驱动采集用2个；PSRAM不足时退回2个（不录像）
+#define CAMERA_FB_COUNT          26
+#define CAMERA_FB_COUNT_FALLBACK 2
+
 // 摄像头状态
 bool cameraInitialized = false;
+int cameraFbCount = 0;
+
+// JPEG解码缓冲区（RGB565，PSRAM优先，按需分配）
+uint8_t *cameraDecodeBuffer = NULL;
+size_t cameraDecodeSize = 0;
 
 /**
  * 摄像头初始化
@@ -54,17 +68,24 @@ void camera_init() {
   config.pixel_format = PIXFORMAT_JPEG;
   config.frame_size = FRAMESIZE_QVGA;
   config.jpeg_quality = 12;
-  config.fb_count = 2;
+  config.fb_count = CAMERA_FB_COUNT;
+  config.fb_location = CAMERA_FB_IN_PSRAM;
+  config.grab_mode = CAMERA_GRAB_LATEST;
 
   // 初始化摄像头
   esp_err_t err = esp_camera_init(&config);
+  if (err != ESP_OK) {
+    config.fb_count = CAMERA_FB_COUNT_FALLBACK;
+    err = esp_camera_init(&config);
+  }
   if (err != ESP_OK) {
     Serial.printf("摄像头初始化失败: %d\n", err);
     return;
   }
 
+  cameraFbCount = config.fb_count;
   cameraInitialized = true;
-  Serial.println("摄像头初始化完成");
+  Serial.printf("摄像头初始化完成（帧缓冲区%d个）\n", cameraFbCount);
 }
 
 /**
@@ -96,6 +117,75 @@ void camera_release_fb(camera_fb_t *fb) {
   }
 }
 
+/**
+ * RGB565（高字节在前）转灰度
+ */
+static void camera_rgb565_to_gray(const uint8_t *rgb, size_t pixels, uint8_t *gray) {
+  for (size_t i = 0; i < pixels; i++) {
+    uint8_t high = rgb[i * 2];
+    uint8_t low = rgb[i * 2 + 1];
+    uint32_t r = high & 0xF8;
+    uint32_t g = ((high & 0x07) << 5) | ((low & 0xE0) >> 3);
+    uint32_t b = (low & 0x1F) << 3;
+    gray[i] = (r * 77 + g * 150 + b * 29) >> 8;
+  }
+}
+
+/**
+ * 帧转换为灰度图像
+ * @param fb 帧缓冲区
+ * @param gray 输出缓冲区
+ * @param size 缓冲区大小
+ * @param width 输出宽度
+ * @param height 输出高度
+ * @return 是否成功
+ */
+bool camera_fb_to_gray(const camera_fb_t *fb, uint8_t *gray, size_t size, int *width, int *height) {
+  if (!fb) {
+    return false;
+  }
+
+  size_t w = fb->width;
+  size_t h = fb->height;
+  if (fb->format == PIXFORMAT_JPEG) {
+    w /= 2;
+    h /= 2;
+  }
+  if (w * h > size) {
+    return false;
+  }
+  *width = w;
+  *height = h;
+
+  switch (fb->format) {
+    case PIXFORMAT_GRAYSCALE:
+      memcpy(gray, fb->buf, w * h);
+      return true;
+
+    case PIXFORMAT_RGB565:
+      camera_rgb565_to_gray(fb->buf, w * h, gray);
+      return true;
+
+    case PIXFORMAT_JPEG:
+      if (cameraDecodeSize < w * h * 2) {
+        free(cameraDecodeBuffer);
+        cameraDecodeBuffer = (uint8_t *)heap_caps_malloc(w * h * 2, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!cameraDecodeBuffer) {
+          cameraDecodeBuffer = (uint8_t *)malloc(w * h * 2);
+        }
+        cameraDecodeSize = cameraDecodeBuffer ? w * h * 2 : 0;
+      }
+      if (!cameraDecodeBuffer || !jpg2rgb565(fb->buf, fb->len, cameraDecodeBuffer, JPG_SCALE_2X)) {
+        return false;
+      }
+      camera_rgb565_to_gray(cameraDecodeBuffer, w * h, gray);
+      return true;
+
+    default:
+      return false;
+  }
+}
+
 /**
  * 设置摄像头参数
  * @param frameSize 帧大小
@@ -113,6 +203,14 @@ void camera_set_params(framesize_t frameSize, int quality) {
   }
 }
 
+/**
+ * 获取帧缓冲区数
+ * @return 帧缓冲区数，未初始化时为0
+ */
+int camera_get_fb_count() {
+  return cameraFbCount;
+}
+
 /**
  * 获取摄像头状态
  * @return 是否初始化成功
@@ -22,6 +22,18 @@ bool camera_capture(camera_fb_t **fb);
  */
 void camera_release_fb(camera_fb_t *fb);
 
+/**
+ * 帧转换为灰度图像
+ * JPEG帧按1/2比例解码（QVGA得到160×120），灰度和RGB565帧按原尺寸转换
+ * @param fb 帧缓冲区
+ * @param gray 输出缓冲区
+ * @param size 缓冲区大小
+ * @param width 输出宽度
+ * @param height 输出高度
+ * @return 是否成功
+ */
+bool camera_fb_to_gray(const camera_fb_t *fb, uint8_t *gray, size_t size, int *width, int *height);
+
 /**
  * 设置摄像头参数
  * @param frameSize 帧大小
@@ -29,6 +41,13 @@ void camera_release_fb(camera_fb_t *fb);
  */
 void camera_set_params(framesize_t frameSize, int quality);
 
+/**
+ * 获取帧缓冲区数
+ * 驱动按该数量在PSRAM中常驻分配，事件录像持有其中除2个以外的全部
+ * @return 帧缓冲区数，未初始化时为0
+ */
+int camera_get_fb_count();
+
 /**
  * 获取摄像头状态
  * @return 是否初始化成功
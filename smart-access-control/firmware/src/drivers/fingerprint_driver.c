@@ -1,145 +1,560 @@
 #include <Arduino.h>
-#include <SoftwareSerial.h>
 #include <Adafruit_Fingerprint.h>
 
-// 指纹模块引脚定义
-#define FINGERPRINT_TX_PIN  16
-#define FINGERPRINT_RX_PIN  17
+// 头文件包含
+#include "drivers/fingerprint_driver.h"
+#include "drivers/fingerprint_protocol.h"
+#include "modules/event_bus.h"
 
-// 串口实例
-SoftwareSerial fingerprintSerial(FINGERPRINT_TX_PIN, FINGERPRINT_RX_PIN);
+// 指纹模块引脚定义（UART2）
+#define FINGERPRINT_RX_PIN  16
+#define FINGERPRINT_TX_PIN  17
 
-// 指纹模块实例
+// 波特率：模块出厂为57600，初始化时切换到支持的最高波特率（9600 × 12）
+#define FINGERPRINT_DEFAULT_BAUD  57600
+#define FINGERPRINT_BAUD  (FINGERPRINT_BAUD_UNIT * FINGERPRINT_BAUD_MAX_N)
+
+// 读取系统参数失败时的默认指纹库容量
+#define FINGERPRINT_DEFAULT_CAPACITY  300
+
+// 触摸感应输出（模块TOUCH/WAKEUP脚，手指按下时为高电平）
+#define FINGERPRINT_TOUCH_PIN  14
+
+// 默认识别模式
+#define FINGERPRINT_DEFAULT_MODE  FINGERPRINT_MODE_IRQ
+
+// 中断模式下单次按压的最大采集次数（手指未放稳时重试）
+#define FINGERPRINT_IRQ_MAX_ATTEMPTS  3
+
+// 串口实例（硬件UART）
+HardwareSerial &fingerprintSerial = Serial2;
+
+// 指纹模块实例（录入、删除等管理指令）
 Adafruit_Fingerprint finger = Adafruit_Fingerprint(&fingerprintSerial);
 
 // 指纹模块状态
 bool fingerprintInitialized = false;
+uint32_t fingerprintBaud = 0;
+
+// 识别流水线及最近一次结果
+FingerprintPipeline fingerprintPipeline;
+int fingerprintResultId = -1;
+
+// 管理作业（录入、模板读出/写入），进行中时暂停识别
+FingerprintJob fingerprintJob;
+uint16_t fingerprintPacketSize = FINGERPRINT_DEFAULT_PACKET_SIZE;
+
+// 取消作业后丢弃迟到应答的截止时间
+uint32_t fingerprintDrainUntil = 0;
+bool fingerprintDraining = false;
+
+// 识别模式
+FingerprintMode fingerprintMode = FINGERPRINT_DEFAULT_MODE;
+
+// 触摸中断（中断服务程序写入）
+volatile uint32_t fingerprintTouchCount = 0;
+volatile uint32_t fingerprintTouchAt = 0;
+
+// 采集任务：收到触摸后采集，手指未放稳时有限次重试
+uint32_t fingerprintTouchHandled = 0;
+uint32_t fingerprintLatencyHandled = 0;
+bool fingerprintCaptureArmed = false;
+int fingerprintCaptureAttempts = 0;
+
+// 统计
+FingerprintStats fingerprintStats;
+uint32_t fingerprintStatsSince = 0;
+
+/**
+ * 触摸中断服务程序
+ * 记录按下时间并投递触摸事件，采集在访问控制任务中进行
+ */
+static void IRAM_ATTR fingerprint_touch_isr() {
+  fingerprintTouchAt = millis();
+  fingerprintTouchCount++;
+
+  BusEvent event = {};
+  event.type = BUS_EVENT_TOUCH;
+  event.timestamp = fingerprintTouchAt;
+  event_bus_post_from_isr(&event);
+}
+
+/**
+ * 记录一次按压到出结果的延迟
+ * 两种模式都用触摸中断的时间戳作为按压时间
+ */
+static void fingerprint_record_latency(uint32_t now) {
+  fingerprintStats.results++;
+
+  uint32_t touches = fingerprintTouchCount;
+  if (touches == fingerprintLatencyHandled) {
+    return;
+  }
+  fingerprintLatencyHandled = touches;
+
+  uint32_t latency = now - fingerprintTouchAt;
+  uint32_t bucket = latency / FINGERPRINT_LATENCY_BUCKET_MS;
+  if (bucket >= FINGERPRINT_LATENCY_BUCKETS) {
+    bucket = FINGERPRINT_LATENCY_BUCKETS - 1;
+  }
+  fingerprintStats.latencyHistogram[bucket]++;
+  fingerprintStats.latencyCount++;
+  if (latency > fingerprintStats.latencyMaxMs) {
+    fingerprintStats.latencyMaxMs = latency;
+  }
+}
+
+/**
+ * 判断是否应发起采集
+ * @param answered 本次调用是否刚处理完上一条指令的应答
+ */
+static bool fingerprint_should_capture(bool answered) {
+  if (fingerprintMode == FINGERPRINT_MODE_POLL) {
+    // 轮询模式每个周期只采集一次，无指纹应答后等到下一周期
+    return !answered;
+  }
+
+  // 新的按压：清除等待抬起标志（能产生新的上升沿说明手指已离开过）
+  uint32_t touches = fingerprintTouchCount;
+  if (touches != fingerprintTouchHandled) {
+    fingerprintTouchHandled = touches;
+    fingerprintCaptureArmed = true;
+    fingerprintCaptureAttempts = 0;
+    fingerprintPipeline.awaitLift = false;
+  }
+
+  if (!fingerprintCaptureArmed) {
+    return false;
+  }
+  if (fingerprintCaptureAttempts >= FINGERPRINT_IRQ_MAX_ATTEMPTS) {
+    fingerprintCaptureArmed = false;
+    return false;
+  }
+  fingerprintCaptureAttempts++;
+  return true;
+}
+
+/**
+ * 发送指令并等待应答（仅用于初始化）
+ * @param command 指令内容
+ * @param length 指令长度
+ * @param response 应答包
+ * @return 是否收到应答且确认码为成功
+ */
+static bool fingerprint_transact(const uint8_t *command, uint16_t length, FingerprintPacket *response) {
+  uint8_t packet[32];
+  size_t packetLength = fingerprint_packet_encode(FINGERPRINT_PID_COMMAND, command, length, packet, sizeof(packet));
+
+  while (fingerprintSerial.available()) {
+    fingerprintSerial.read();
+  }
+  fingerprintSerial.write(packet, packetLength);
+
+  FingerprintParser parser;
+  fingerprint_parser_reset(&parser);
+  unsigned long startTime = millis();
+  while (millis() - startTime < FINGERPRINT_RESPONSE_TIMEOUT) {
+    if (!fingerprintSerial.available()) {
+      delay(1);
+      continue;
+    }
+    int result = fingerprint_parser_feed(&parser, fingerprintSerial.read());
+    if (result < 0) {
+      return false;
+    }
+    if (result > 0) {
+      *response = parser.packet;
+      return response->pid == FINGERPRINT_PID_ACK && response->length >= 1 &&
+             response->content[0] == FINGERPRINT_ACK_OK;
+    }
+  }
+  return false;
+}
+
+/**
+ * 以指定波特率握手
+ * @param baud 波特率
+ * @return 是否成功
+ */
+static bool fingerprint_handshake(uint32_t baud) {
+  fingerprintSerial.updateBaudRate(baud);
+  delay(10);
+
+  const uint8_t command[] = {FINGERPRINT_CMD_VERIFY_PASSWORD,
+                             (FINGERPRINT_DEFAULT_PASSWORD >> 24) & 0xFF, (FINGERPRINT_DEFAULT_PASSWORD >> 16) & 0xFF,
+                             (FINGERPRINT_DEFAULT_PASSWORD >> 8) & 0xFF, FINGERPRINT_DEFAULT_PASSWORD & 0xFF};
+  FingerprintPacket response;
+  return fingerprint_transact(command, sizeof(command), &response);
+}
+
+/**
+ * 等待进行中的识别指令结束并清空串口（管理指令使用串口前调用）
+ */
+static void fingerprint_pipeline_idle() {
+  if (fingerprint_pipeline_busy(&fingerprintPipeline)) {
+    unsigned long startTime = millis();
+    while (!fingerprintSerial.available() && millis() - startTime < FINGERPRINT_RESPONSE_TIMEOUT) {
+      delay(1);
+    }
+    delay(5);
+  }
+
+  while (fingerprintSerial.available()) {
+    fingerprintSerial.read();
+  }
+  fingerprint_pipeline_init(&fingerprintPipeline, fingerprintPipeline.capacity);
+}
 
 /**
  * 指纹模块初始化
  */
 void fingerprint_init() {
-  // 初始化串口
-  fingerprintSerial.begin(57600);
-  
-  // 初始化指纹模块
-  finger.begin(57600);
-  
-  // 检查模块连接
-  if (finger.verifyPassword()) {
-    fingerprintInitialized = true;
-    Serial.println("指纹模块初始化完成");
-    
-    // 获取模块信息
-    uint16_t version = finger.getTemplateCount();
-    Serial.printf("指纹模板数量: %d\n", version);
+  // 初始化硬件串口
+  fingerprintSerial.begin(FINGERPRINT_BAUD, SERIAL_8N1, FINGERPRINT_RX_PIN, FINGERPRINT_TX_PIN);
+
+  // 先按最高波特率握手，失败时按出厂波特率握手并切换
+  if (fingerprint_handshake(FINGERPRINT_BAUD)) {
+    fingerprintBaud = FINGERPRINT_BAUD;
+  } else if (fingerprint_handshake(FINGERPRINT_DEFAULT_BAUD)) {
+    fingerprintBaud = FINGERPRINT_DEFAULT_BAUD;
+
+    const uint8_t command[] = {FINGERPRINT_CMD_SET_SYS_PARA, FINGERPRINT_PARAM_BAUD, FINGERPRINT_BAUD_MAX_N};
+    FingerprintPacket response;
+    if (fingerprint_transact(command, sizeof(command), &response)) {
+      if (fingerprint_handshake(FINGERPRINT_BAUD)) {
+        fingerprintBaud = FINGERPRINT_BAUD;
+      } else {
+        fingerprint_handshake(FINGERPRINT_DEFAULT_BAUD);
+      }
+    }
   } else {
     Serial.println("指纹模块初始化失败");
+    return;
   }
+
+  // 读取指纹库容量（搜索范围）及数据包长度（模板读出/写入分包）
+  uint16_t capacity = FINGERPRINT_DEFAULT_CAPACITY;
+  const uint8_t command[] = {FINGERPRINT_CMD_READ_SYS_PARA};
+  FingerprintPacket response;
+  if (fingerprint_transact(command, sizeof(command), &response) && response.length >= 15) {
+    capacity = (response.content[5] << 8) | response.content[6];
+    fingerprintPacketSize = 32 << (response.content[14] & 0x03);
+  }
+
+  fingerprint_pipeline_init(&fingerprintPipeline, capacity);
+  memset(&fingerprintJob, 0, sizeof(fingerprintJob));
+  fingerprintInitialized = true;
+  Serial.printf("指纹模块初始化完成，波特率: %u, 指纹库容量: %u, 数据包: %u字节\n", fingerprintBaud, capacity,
+                fingerprintPacketSize);
+
+  // 触摸中断（轮询模式下仅用于统计按压时间）
+  pinMode(FINGERPRINT_TOUCH_PIN, INPUT);
+  attachInterrupt(digitalPinToInterrupt(FINGERPRINT_TOUCH_PIN), fingerprint_touch_isr, RISING);
+  fingerprint_reset_stats();
+  Serial.printf("指纹识别模式: %s\n", fingerprintMode == FINGERPRINT_MODE_IRQ ? "触摸中断" : "轮询");
+
+  // 获取模块信息
+  uint16_t version = finger.getTemplateCount();
+  Serial.printf("指纹模板数量: %d\n", version);
+}
+
+/**
+ * 推进管理作业：处理已到达的应答，发送到期的指令
+ * @param now 当前时间(ms)
+ */
+static void fingerprint_job_step(uint32_t now) {
+  uint8_t buffer[64];
+  int available;
+  while (fingerprint_job_running(&fingerprintJob) && (available = fingerprintSerial.available()) > 0) {
+    size_t count = fingerprintSerial.read(buffer, min((size_t)available, sizeof(buffer)));
+    fingerprint_job_receive(&fingerprintJob, buffer, count, now);
+  }
+
+  fingerprint_job_poll(&fingerprintJob, now);
+  if (fingerprintJob.txLength) {
+    fingerprintSerial.write(fingerprintJob.tx, fingerprintJob.txLength);
+    fingerprintJob.txLength = 0;
+  }
+}
+
+/**
+ * 准备开始管理作业
+ * 识别指令等待应答或已有作业时不开始（不等待），调用方稍后重试
+ * @return 是否可以开始
+ */
+static bool fingerprint_job_prepare() {
+  if (!fingerprintInitialized || fingerprintJob.type != FINGERPRINT_JOB_NONE || fingerprintDraining ||
+      fingerprint_pipeline_busy(&fingerprintPipeline)) {
+    return false;
+  }
+
+  while (fingerprintSerial.available()) {
+    fingerprintSerial.read();
+  }
+  fingerprintResultId = -1;
+  fingerprintCaptureArmed = false;
+  return true;
 }
 
 /**
  * 检查指纹
- * @return 是否检测到指纹
+ * 推进识别流水线：空闲时发起采集，收到应答后立即发送下一条指令，不等待应答
+ * 管理作业进行中时只推进作业
+ * @return 是否得到识别结果（结果由fingerprint_identify获取）
  */
 bool fingerprint_check() {
   if (!fingerprintInitialized) {
     return false;
   }
-  
-  // 检查是否有指纹
-  int p = finger.getImage();
-  if (p != FINGERPRINT_OK) {
+
+  uint32_t now = millis();
+  if (fingerprintJob.type != FINGERPRINT_JOB_NONE) {
+    fingerprint_job_step(now);
     return false;
   }
-  
-  return true;
+
+  if (fingerprintDraining) {
+    while (fingerprintSerial.available()) {
+      fingerprintSerial.read();
+    }
+    if ((int32_t)(now - fingerprintDrainUntil) < 0) {
+      return false;
+    }
+    fingerprintDraining = false;
+  }
+
+  bool answered = fingerprint_pipeline_busy(&fingerprintPipeline);
+  FingerprintEvent event = fingerprint_pipeline_check_timeout(&fingerprintPipeline, now);
+
+  // 解析已到达的应答
+  uint8_t buffer[32];
+  int available;
+  while (event == FINGERPRINT_EVENT_NONE && (available = fingerprintSerial.available()) > 0) {
+    size_t count = fingerprintSerial.read(buffer, min((size_t)available, sizeof(buffer)));
+    event = fingerprint_pipeline_receive(&fingerprintPipeline, buffer, count, now);
+  }
+
+  // 空闲时发起下一次采集（中断模式只在按压后采集）
+  if (event == FINGERPRINT_EVENT_NONE && !fingerprint_pipeline_busy(&fingerprintPipeline) &&
+      fingerprint_should_capture(answered) && fingerprint_pipeline_start(&fingerprintPipeline, now)) {
+    fingerprintStats.captures++;
+  }
+
+  if (fingerprintPipeline.txLength) {
+    fingerprintSerial.write(fingerprintPipeline.tx, fingerprintPipeline.txLength);
+    fingerprintPipeline.txLength = 0;
+  }
+
+  if (event == FINGERPRINT_EVENT_ERROR) {
+    Serial.println("指纹采集失败，请重新按压");
+    return false;
+  }
+
+  if (event == FINGERPRINT_EVENT_MATCH || event == FINGERPRINT_EVENT_NO_MATCH) {
+    fingerprintResultId = fingerprintPipeline.resultId;
+    fingerprintCaptureArmed = false;
+    fingerprint_record_latency(now);
+    return true;
+  }
+
+  return false;
 }
 
 /**
  * 识别指纹
+ * 返回fingerprint_check得到的结果，不再重新采集
  * @return 指纹ID，-1表示未识别
  */
 int fingerprint_identify() {
+  int id = fingerprintResultId;
+  fingerprintResultId = -1;
+  return id;
+}
+
+/**
+ * 判断识别流水线或管理作业是否在等待应答
+ * @return 是否忙
+ */
+bool fingerprint_is_busy() {
   if (!fingerprintInitialized) {
-    return -1;
+    return false;
   }
-  
-  // 获取指纹图像
-  int p = finger.getImage();
-  if (p != FINGERPRINT_OK) {
-    return -1;
+  if (fingerprintJob.type != FINGERPRINT_JOB_NONE) {
+    // 作业等待按压时按正常周期采集，其余时间（等待应答、待发送、待取结果）视为忙
+    return !fingerprint_job_running(&fingerprintJob) || fingerprintJob.waiting ||
+           (int32_t)(millis() - fingerprintJob.nextAt) >= 0;
   }
-  
-  // 转换图像
-  p = finger.image2Tz();
-  if (p != FINGERPRINT_OK) {
-    return -1;
+  return fingerprint_pipeline_busy(&fingerprintPipeline);
+}
+
+/**
+ * 设置识别模式
+ * @param mode 模式
+ */
+void fingerprint_set_mode(FingerprintMode mode) {
+  if (mode == fingerprintMode) {
+    return;
   }
-  
-  // 搜索指纹
-  p = finger.fingerFastSearch();
-  if (p != FINGERPRINT_OK) {
-    return -1;
+
+  fingerprintMode = mode;
+  fingerprintCaptureArmed = false;
+  fingerprintTouchHandled = fingerprintTouchCount;
+  fingerprint_reset_stats();
+  Serial.printf("指纹识别模式: %s\n", mode == FINGERPRINT_MODE_IRQ ? "触摸中断" : "轮询");
+}
+
+/**
+ * 获取识别模式
+ * @return 模式
+ */
+FingerprintMode fingerprint_get_mode() {
+  return fingerprintMode;
+}
+
+/**
+ * 获取统计
+ * @param stats 统计
+ */
+void fingerprint_get_stats(FingerprintStats *stats) {
+  *stats = fingerprintStats;
+  stats->mode = fingerprintMode;
+  stats->touches = fingerprintTouchCount - stats->touches;
+  stats->elapsedMs = millis() - fingerprintStatsSince;
+}
+
+/**
+ * 清零统计
+ */
+void fingerprint_reset_stats() {
+  memset(&fingerprintStats, 0, sizeof(fingerprintStats));
+  // touches 记录清零时的中断计数，读取时换算为增量
+  fingerprintStats.touches = fingerprintTouchCount;
+  fingerprintLatencyHandled = fingerprintTouchCount;
+  fingerprintStatsSince = millis();
+}
+
+/**
+ * 延迟分位数（按直方图估算，取所在区间上界）
+ * @param stats 统计
+ * @param percent 百分位（1~100）
+ * @return 延迟(ms)，无样本时为0
+ */
+uint32_t fingerprint_latency_percentile(const FingerprintStats *stats, uint32_t percent) {
+  if (stats->latencyCount == 0) {
+    return 0;
   }
-  
-  // 返回指纹ID
-  return finger.fingerID;
+
+  uint32_t target = (stats->latencyCount * percent + 99) / 100;
+  uint32_t seen = 0;
+  for (int i = 0; i < FINGERPRINT_LATENCY_BUCKETS - 1; i++) {
+    seen += stats->latencyHistogram[i];
+    if (seen >= target) {
+      return (i + 1) * FINGERPRINT_LATENCY_BUCKET_MS;
+    }
+  }
+  return stats->latencyMaxMs;
+}
+
+/**
+ * 每小时采集指令次数
+ * @param stats 统计
+ * @return 次数
+ */
+uint32_t fingerprint_captures_per_hour(const FingerprintStats *stats) {
+  if (stats->elapsedMs == 0) {
+    return 0;
+  }
+  return (uint32_t)((uint64_t)stats->captures * 3600000ULL / stats->elapsedMs);
 }
 
 /**
  * 添加指纹
+ * 开始录入作业，不等待按压，由fingerprint_check推进
  * @param id 指纹ID
- * @return 是否成功
+ * @return 是否开始
  */
 bool fingerprint_add(uint8_t id) {
-  if (!fingerprintInitialized) {
-    return false;
-  }
-  
-  // 获取指纹图像
-  Serial.println("请放置指纹...");
-  int p = 0;
-  while (p != FINGERPRINT_OK) {
-    p = finger.getImage();
-    delay(100);
-  }
-  
-  // 转换图像
-  p = finger.image2Tz(1);
-  if (p != FINGERPRINT_OK) {
+  return fingerprint_start_enroll(id);
+}
+
+/**
+ * 开始录入作业
+ * 两次按压合并后存储到指定模板号，再读出模板供镜像备份
+ * @param id 模板号
+ * @return 是否开始（模块忙时返回false）
+ */
+bool fingerprint_start_enroll(uint16_t id) {
+  if (id >= fingerprintPipeline.capacity || !fingerprint_job_prepare()) {
     return false;
   }
-  
-  Serial.println("请抬起手指...");
-  delay(2000);
-  
-  Serial.println("请再次放置指纹...");
-  p = 0;
-  while (p != FINGERPRINT_OK) {
-    p = finger.getImage();
-    delay(100);
-  }
-  
-  // 转换图像
-  p = finger.image2Tz(2);
-  if (p != FINGERPRINT_OK) {
+
+  fingerprint_job_enroll(&fingerprintJob, id, millis());
+  Serial.printf("开始录入指纹: %u\n", id);
+  return true;
+}
+
+/**
+ * 开始读出模板作业
+ * @param id 模板号
+ * @return 是否开始
+ */
+bool fingerprint_start_upload(uint16_t id) {
+  if (id >= fingerprintPipeline.capacity || !fingerprint_job_prepare()) {
     return false;
   }
-  
-  // 创建模板
-  p = finger.createTemplate();
-  if (p != FINGERPRINT_OK) {
+
+  fingerprint_job_upload(&fingerprintJob, id, millis());
+  return true;
+}
+
+/**
+ * 开始写入模板作业
+ * @param id 模板号
+ * @param data 模板
+ * @param length 模板长度
+ * @return 是否开始
+ */
+bool fingerprint_start_download(uint16_t id, const uint8_t *data, uint16_t length) {
+  if (id >= fingerprintPipeline.capacity || !fingerprint_job_prepare()) {
     return false;
   }
-  
-  // 存储模板
-  p = finger.storeTemplate(id, 1);
-  if (p != FINGERPRINT_OK) {
-    return false;
+
+  return fingerprint_job_download(&fingerprintJob, id, data, length, fingerprintPacketSize, millis());
+}
+
+/**
+ * 获取当前作业
+ * @return 作业（type为FINGERPRINT_JOB_NONE表示无作业）
+ */
+const FingerprintJob *fingerprint_get_job() {
+  return &fingerprintJob;
+}
+
+/**
+ * 结束作业（读取结果后调用，或取消进行中的作业），恢复识别
+ */
+void fingerprint_finish_job() {
+  if (fingerprint_job_running(&fingerprintJob) && fingerprintJob.waiting) {
+    // 取消时进行中指令的应答稍后到达，丢弃后再恢复识别
+    fingerprintDraining = true;
+    fingerprintDrainUntil = millis() + FINGERPRINT_RESPONSE_TIMEOUT;
   }
-  
-  return true;
+
+  fingerprintJob.type = FINGERPRINT_JOB_NONE;
+  fingerprintJob.txLength = 0;
+
+  // 录入期间的按压不作为识别请求
+  fingerprintTouchHandled = fingerprintTouchCount;
+  fingerprintCaptureArmed = false;
+  fingerprintPipeline.awaitLift = true;
+}
+
+/**
+ * 获取指纹库容量
+ * @return 容量
+ */
+uint16_t fingerprint_get_capacity() {
+  return fingerprintInitialized ? fingerprintPipeline.capacity : 0;
 }
 
 /**
@@ -148,11 +563,13 @@ bool fingerprint_add(uint8_t id) {
  * @return 是否成功
  */
 bool fingerprint_delete(uint8_t id) {
-  if (!fingerprintInitialized) {
+  if (!fingerprintInitialized || fingerprintJob.type != FINGERPRINT_JOB_NONE) {
     return false;
   }
   
-  int p = finger.deleteTemplate(id);
+  fingerprint_pipeline_idle();
+  
+  int p = finger.deleteModel(id);
   return (p == FINGERPRINT_OK);
 }
 
@@ -161,10 +578,12 @@ bool fingerprint_delete(uint8_t id) {
  * @return 是否成功
  */
 bool fingerprint_clear_all() {
-  if (!fingerprintInitialized) {
+  if (!fingerprintInitialized || fingerprintJob.type != FINGERPRINT_JOB_NONE) {
     return false;
   }
   
+  fingerprint_pipeline_idle();
+  
   int p = finger.emptyDatabase();
   return (p == FINGERPRINT_OK);
 }
@@ -174,10 +593,12 @@ bool fingerprint_clear_all() {
  * @return 模板数量
  */
 int fingerprint_get_template_count() {
-  if (!fingerprintInitialized) {
+  if (!fingerprintInitialized || fingerprintJob.type != FINGERPRINT_JOB_NONE) {
     return 0;
   }
   
+  fingerprint_pipeline_idle();
+  
   return finger.getTemplateCount();
 }
 
@@ -209,8 +630,18 @@ void fingerprint_test() {
     Serial.printf("当前模板数量: %d\n", count);
     
     // 获取模块地址
-    uint32_t address = finger.getAddress();
+    uint32_t address = finger.device_addr;
     Serial.printf("模块地址: 0x%08X\n", address);
+    
+    // 识别统计
+    FingerprintStats stats;
+    fingerprint_get_stats(&stats);
+    Serial.printf("识别模式: %s, 采集指令: %u（%u次/小时）, 按压: %u, 结果: %u\n",
+                 stats.mode == FINGERPRINT_MODE_IRQ ? "触摸中断" : "轮询", stats.captures,
+                 fingerprint_captures_per_hour(&stats), stats.touches, stats.results);
+    Serial.printf("按压到结果延迟: p50=%ums, p99=%ums, 最大=%ums\n",
+                 fingerprint_latency_percentile(&stats, 50), fingerprint_latency_percentile(&stats, 99),
+                 stats.latencyMaxMs);
   } else {
     Serial.println("指纹模块连接失败");
   }
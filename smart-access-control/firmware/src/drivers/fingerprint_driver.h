@@ -3,6 +3,31 @@
 
 #include <Arduino.h>
 
+// 头文件包含
+#include "drivers/fingerprint_protocol.h"
+
+// 识别模式
+typedef enum {
+  FINGERPRINT_MODE_IRQ,    // 模块触摸输出触发中断后采集（默认）
+  FINGERPRINT_MODE_POLL    // 周期轮询采集（触摸输出未接线时的备用模式）
+} FingerprintMode;
+
+// 延迟直方图：每格20ms，最后一格包含更大的值
+#define FINGERPRINT_LATENCY_BUCKETS    16
+#define FINGERPRINT_LATENCY_BUCKET_MS  20
+
+// 识别统计
+typedef struct {
+  FingerprintMode mode;
+  uint32_t elapsedMs;            // 统计时长
+  uint32_t captures;             // 采集指令次数（轮询模式下空闲时也在增长）
+  uint32_t touches;              // 触摸中断次数
+  uint32_t results;              // 识别结果次数
+  uint32_t latencyCount;         // 有按压时间戳的结果次数
+  uint32_t latencyMaxMs;
+  uint32_t latencyHistogram[FINGERPRINT_LATENCY_BUCKETS];
+} FingerprintStats;
+
 /**
  * 指纹模块初始化
  */
@@ -10,23 +35,115 @@ void fingerprint_init();
 
 /**
  * 检查指纹
- * @return 是否检测到指纹
+ * 推进识别流水线（采集一次 → 生成特征 → 搜索），不等待模块应答
+ * @return 是否得到识别结果
  */
 bool fingerprint_check();
 
 /**
  * 识别指纹
+ * 返回fingerprint_check得到的结果，不再重新采集
  * @return 指纹ID，-1表示未识别
  */
 int fingerprint_identify();
 
+/**
+ * 判断识别流水线或管理作业是否在等待应答
+ * 忙时调用方应缩短轮询间隔
+ * @return 是否忙
+ */
+bool fingerprint_is_busy();
+
+/**
+ * 设置识别模式
+ * 切换时统计清零
+ * @param mode 模式
+ */
+void fingerprint_set_mode(FingerprintMode mode);
+
+/**
+ * 获取识别模式
+ * @return 模式
+ */
+FingerprintMode fingerprint_get_mode();
+
+/**
+ * 获取统计
+ * @param stats 统计
+ */
+void fingerprint_get_stats(FingerprintStats *stats);
+
+/**
+ * 清零统计
+ */
+void fingerprint_reset_stats();
+
+/**
+ * 延迟分位数（按直方图估算，取所在区间上界）
+ * @param stats 统计
+ * @param percent 百分位（1~100）
+ * @return 延迟(ms)，无样本时为0
+ */
+uint32_t fingerprint_latency_percentile(const FingerprintStats *stats, uint32_t percent);
+
+/**
+ * 每小时采集指令次数
+ * @param stats 统计
+ * @return 次数
+ */
+uint32_t fingerprint_captures_per_hour(const FingerprintStats *stats);
+
 /**
  * 添加指纹
+ * 开始录入作业，不等待按压，由fingerprint_check推进
  * @param id 指纹ID
- * @return 是否成功
+ * @return 是否开始
  */
 bool fingerprint_add(uint8_t id);
 
+/**
+ * 开始录入作业
+ * 两次按压合并后存储到指定模板号，再读出模板供镜像备份
+ * 作业进行中识别暂停，fingerprint_check只推进作业
+ * @param id 模板号
+ * @return 是否开始（模块忙时返回false）
+ */
+bool fingerprint_start_enroll(uint16_t id);
+
+/**
+ * 开始读出模板作业
+ * @param id 模板号
+ * @return 是否开始
+ */
+bool fingerprint_start_upload(uint16_t id);
+
+/**
+ * 开始写入模板作业
+ * @param id 模板号
+ * @param data 模板
+ * @param length 模板长度
+ * @return 是否开始
+ */
+bool fingerprint_start_download(uint16_t id, const uint8_t *data, uint16_t length);
+
+/**
+ * 获取当前作业
+ * state为DONE/FAILED时读取结果后须调用fingerprint_finish_job
+ * @return 作业（type为FINGERPRINT_JOB_NONE表示无作业）
+ */
+const FingerprintJob *fingerprint_get_job();
+
+/**
+ * 结束作业（读取结果后调用，或取消进行中的作业），恢复识别
+ */
+void fingerprint_finish_job();
+
+/**
+ * 获取指纹库容量
+ * @return 容量
+ */
+uint16_t fingerprint_get_capacity();
+
 /**
  * 删除指纹
  * @param id 指纹ID
@@ -0,0 +1,634 @@
+#include <string.h>
+
+// 头文件包含
+#include "drivers/fingerprint_protocol.h"
+
+// 解析状态
+enum {
+  PARSER_START_HIGH,
+  PARSER_START_LOW,
+  PARSER_ADDRESS,
+  PARSER_PID,
+  PARSER_LENGTH_HIGH,
+  PARSER_LENGTH_LOW,
+  PARSER_CONTENT,
+  PARSER_CHECKSUM_HIGH,
+  PARSER_CHECKSUM_LOW
+};
+
+/**
+ * 编码数据包
+ * @param pid 包标识
+ * @param content 内容
+ * @param length 内容长度
+ * @param out 输出缓冲区
+ * @param size 缓冲区大小
+ * @return 编码长度，0表示缓冲区不足
+ */
+size_t fingerprint_packet_encode(uint8_t pid, const uint8_t *content, uint16_t length, uint8_t *out, size_t size) {
+  size_t total = (size_t)length + FINGERPRINT_PACKET_OVERHEAD;
+  if (total > size) {
+    return 0;
+  }
+
+  uint16_t packetLength = length + 2;
+  uint16_t checksum = pid + (packetLength >> 8) + (packetLength & 0xFF);
+
+  size_t i = 0;
+  out[i++] = FINGERPRINT_START_CODE >> 8;
+  out[i++] = FINGERPRINT_START_CODE & 0xFF;
+  out[i++] = (FINGERPRINT_DEFAULT_ADDRESS >> 24) & 0xFF;
+  out[i++] = (FINGERPRINT_DEFAULT_ADDRESS >> 16) & 0xFF;
+  out[i++] = (FINGERPRINT_DEFAULT_ADDRESS >> 8) & 0xFF;
+  out[i++] = FINGERPRINT_DEFAULT_ADDRESS & 0xFF;
+  out[i++] = pid;
+  out[i++] = packetLength >> 8;
+  out[i++] = packetLength & 0xFF;
+  for (uint16_t j = 0; j < length; j++) {
+    out[i++] = content[j];
+    checksum += content[j];
+  }
+  out[i++] = checksum >> 8;
+  out[i++] = checksum & 0xFF;
+  return i;
+}
+
+/**
+ * 解析器复位
+ * @param parser 解析器
+ */
+void fingerprint_parser_reset(FingerprintParser *parser) {
+  parser->state = PARSER_START_HIGH;
+  parser->index = 0;
+  parser->remaining = 0;
+  parser->checksum = 0;
+  parser->received = 0;
+}
+
+/**
+ * 输入一个字节
+ * @param parser 解析器
+ * @param byte 字节
+ * @return 1表示收到完整数据包，-1表示校验错误，0表示继续
+ */
+int fingerprint_parser_feed(FingerprintParser *parser, uint8_t byte) {
+  switch (parser->state) {
+    case PARSER_START_HIGH:
+      if (byte == (FINGERPRINT_START_CODE >> 8)) {
+        parser->state = PARSER_START_LOW;
+      }
+      return 0;
+
+    case PARSER_START_LOW:
+      if (byte == (FINGERPRINT_START_CODE & 0xFF)) {
+        parser->state = PARSER_ADDRESS;
+        parser->index = 0;
+      } else if (byte != (FINGERPRINT_START_CODE >> 8)) {
+        parser->state = PARSER_START_HIGH;
+      }
+      return 0;
+
+    case PARSER_ADDRESS:
+      if (++parser->index == 4) {
+        parser->state = PARSER_PID;
+      }
+      return 0;
+
+    case PARSER_PID:
+      parser->packet.pid = byte;
+      parser->checksum = byte;
+      parser->state = PARSER_LENGTH_HIGH;
+      return 0;
+
+    case PARSER_LENGTH_HIGH:
+      parser->remaining = (uint16_t)byte << 8;
+      parser->checksum += byte;
+      parser->state = PARSER_LENGTH_LOW;
+      return 0;
+
+    case PARSER_LENGTH_LOW:
+      parser->remaining |= byte;
+      parser->checksum += byte;
+      if (parser->remaining < 2 || parser->remaining - 2 > FINGERPRINT_MAX_CONTENT) {
+        fingerprint_parser_reset(parser);
+        return -1;
+      }
+      parser->remaining -= 2;
+      parser->packet.length = parser->remaining;
+      parser->index = 0;
+      parser->state = parser->remaining ? PARSER_CONTENT : PARSER_CHECKSUM_HIGH;
+      return 0;
+
+    case PARSER_CONTENT:
+      parser->packet.content[parser->index++] = byte;
+      parser->checksum += byte;
+      if (--parser->remaining == 0) {
+        parser->state = PARSER_CHECKSUM_HIGH;
+      }
+      return 0;
+
+    case PARSER_CHECKSUM_HIGH:
+      parser->received = (uint16_t)byte << 8;
+      parser->state = PARSER_CHECKSUM_LOW;
+      return 0;
+
+    case PARSER_CHECKSUM_LOW: {
+      uint16_t received = parser->received | byte;
+      uint16_t expected = parser->checksum;
+      fingerprint_parser_reset(parser);
+      return received == expected ? 1 : -1;
+    }
+
+    default:
+      fingerprint_parser_reset(parser);
+      return 0;
+  }
+}
+
+/**
+ * 生成指令放入待发送缓冲区
+ */
+static void fingerprint_pipeline_command(FingerprintPipeline *pipeline, FingerprintStage stage,
+                                         const uint8_t *content, uint16_t length, uint32_t now) {
+  pipeline->txLength = fingerprint_packet_encode(FINGERPRINT_PID_COMMAND, content, length,
+                                                 pipeline->tx, sizeof(pipeline->tx));
+  pipeline->stage = stage;
+  pipeline->sentAt = now;
+}
+
+/**
+ * 流水线初始化
+ * @param pipeline 流水线
+ * @param capacity 指纹库容量
+ */
+void fingerprint_pipeline_init(FingerprintPipeline *pipeline, uint16_t capacity) {
+  memset(pipeline, 0, sizeof(FingerprintPipeline));
+  fingerprint_parser_reset(&pipeline->parser);
+  pipeline->capacity = capacity;
+  pipeline->resultId = -1;
+}
+
+/**
+ * 空闲时发起一次采集
+ * @param pipeline 流水线
+ * @param now 当前时间(ms)
+ * @return 是否发起
+ */
+bool fingerprint_pipeline_start(FingerprintPipeline *pipeline, uint32_t now) {
+  if (pipeline->stage != FINGERPRINT_STAGE_IDLE) {
+    return false;
+  }
+
+  const uint8_t command[] = {FINGERPRINT_CMD_GEN_IMAGE};
+  fingerprint_parser_reset(&pipeline->parser);
+  fingerprint_pipeline_command(pipeline, FINGERPRINT_STAGE_CAPTURE, command, sizeof(command), now);
+  return true;
+}
+
+/**
+ * 处理一个应答包
+ */
+static FingerprintEvent fingerprint_pipeline_ack(FingerprintPipeline *pipeline, const FingerprintPacket *packet, uint32_t now) {
+  if (packet->pid != FINGERPRINT_PID_ACK || packet->length < 1) {
+    pipeline->stage = FINGERPRINT_STAGE_IDLE;
+    return FINGERPRINT_EVENT_ERROR;
+  }
+
+  uint8_t code = packet->content[0];
+  switch (pipeline->stage) {
+    case FINGERPRINT_STAGE_CAPTURE:
+      if (code == FINGERPRINT_ACK_NO_FINGER) {
+        pipeline->awaitLift = false;
+        pipeline->stage = FINGERPRINT_STAGE_IDLE;
+        return FINGERPRINT_EVENT_NONE;
+      }
+      if (code != FINGERPRINT_ACK_OK || pipeline->awaitLift) {
+        // 采集失败，或上次识别的手指尚未离开
+        pipeline->stage = FINGERPRINT_STAGE_IDLE;
+        return FINGERPRINT_EVENT_NONE;
+      } else {
+        const uint8_t command[] = {FINGERPRINT_CMD_IMAGE_TO_TZ, 1};
+        fingerprint_pipeline_command(pipeline, FINGERPRINT_STAGE_CONVERT, command, sizeof(command), now);
+        return FINGERPRINT_EVENT_NONE;
+      }
+
+    case FINGERPRINT_STAGE_CONVERT:
+      if (code != FINGERPRINT_ACK_OK) {
+        pipeline->stage = FINGERPRINT_STAGE_IDLE;
+        return FINGERPRINT_EVENT_ERROR;
+      } else {
+        const uint8_t command[] = {FINGERPRINT_CMD_HIGH_SPEED_SEARCH, 1, 0, 0,
+                                   (uint8_t)(pipeline->capacity >> 8), (uint8_t)(pipeline->capacity & 0xFF)};
+        fingerprint_pipeline_command(pipeline, FINGERPRINT_STAGE_SEARCH, command, sizeof(command), now);
+        return FINGERPRINT_EVENT_NONE;
+      }
+
+    case FINGERPRINT_STAGE_SEARCH:
+      pipeline->stage = FINGERPRINT_STAGE_IDLE;
+      pipeline->awaitLift = true;
+      if (code == FINGERPRINT_ACK_OK && packet->length >= 5) {
+        pipeline->resultId = (packet->content[1] << 8) | packet->content[2];
+        return FINGERPRINT_EVENT_MATCH;
+      }
+      pipeline->resultId = -1;
+      return code == FINGERPRINT_ACK_NOT_FOUND ? FINGERPRINT_EVENT_NO_MATCH : FINGERPRINT_EVENT_ERROR;
+
+    default:
+      // 空闲时收到的数据（如上一条指令超时后的迟到应答）丢弃
+      return FINGERPRINT_EVENT_NONE;
+  }
+}
+
+/**
+ * 输入模块应答数据
+ * @param pipeline 流水线
+ * @param data 数据
+ * @param length 长度
+ * @param now 当前时间(ms)
+ * @return 事件
+ */
+FingerprintEvent fingerprint_pipeline_receive(FingerprintPipeline *pipeline, const uint8_t *data, size_t length, uint32_t now) {
+  FingerprintEvent event = FINGERPRINT_EVENT_NONE;
+  for (size_t i = 0; i < length; i++) {
+    int result = fingerprint_parser_feed(&pipeline->parser, data[i]);
+    if (result < 0 && pipeline->stage != FINGERPRINT_STAGE_IDLE) {
+      pipeline->stage = FINGERPRINT_STAGE_IDLE;
+      event = FINGERPRINT_EVENT_ERROR;
+    } else if (result > 0) {
+      FingerprintEvent packetEvent = fingerprint_pipeline_ack(pipeline, &pipeline->parser.packet, now);
+      if (packetEvent != FINGERPRINT_EVENT_NONE) {
+        event = packetEvent;
+      }
+    }
+  }
+  return event;
+}
+
+/**
+ * 检查应答超时
+ * @param pipeline 流水线
+ * @param now 当前时间(ms)
+ * @return 超时时为FINGERPRINT_EVENT_ERROR
+ */
+FingerprintEvent fingerprint_pipeline_check_timeout(FingerprintPipeline *pipeline, uint32_t now) {
+  if (pipeline->stage == FINGERPRINT_STAGE_IDLE || now - pipeline->sentAt < FINGERPRINT_RESPONSE_TIMEOUT) {
+    return FINGERPRINT_EVENT_NONE;
+  }
+
+  pipeline->stage = FINGERPRINT_STAGE_IDLE;
+  fingerprint_parser_reset(&pipeline->parser);
+  return FINGERPRINT_EVENT_ERROR;
+}
+
+/**
+ * 判断流水线是否在等待应答
+ * @param pipeline 流水线
+ * @return 是否忙
+ */
+bool fingerprint_pipeline_busy(const FingerprintPipeline *pipeline) {
+  return pipeline->stage != FINGERPRINT_STAGE_IDLE;
+}
+
+// 作业步骤
+enum {
+  JOB_CAPTURE1,        // 第一次采集
+  JOB_CONVERT1,        // 第一次生成特征（缓冲区1）
+  JOB_LIFT,            // 等待手指抬起
+  JOB_CAPTURE2,        // 第二次采集
+  JOB_CONVERT2,        // 第二次生成特征（缓冲区2）
+  JOB_MODEL,           // 合并模板
+  JOB_STORE,           // 存储模板
+  JOB_LOAD,            // 载入模板到缓冲区1
+  JOB_UP_CHAR,         // 上传缓冲区1
+  JOB_UP_DATA,         // 接收模板数据包
+  JOB_DOWN_CHAR,       // 下载到缓冲区1
+  JOB_DOWN_DATA        // 发送模板数据包及存储指令
+};
+
+/**
+ * 作业初始化
+ */
+static void fingerprint_job_begin(FingerprintJob *job, FingerprintJobType type, uint8_t step, uint16_t pageId, uint32_t now) {
+  memset(job, 0, offsetof(FingerprintJob, templateData));
+  fingerprint_parser_reset(&job->parser);
+  job->type = type;
+  job->state = FINGERPRINT_JOB_RUNNING;
+  job->step = step;
+  job->pageId = pageId;
+  job->startedAt = now;
+  job->nextAt = now;
+  job->templateLength = 0;
+  job->txLength = 0;
+}
+
+/**
+ * 作业结束
+ */
+static void fingerprint_job_finish(FingerprintJob *job, FingerprintJobState state, uint8_t error) {
+  job->state = state;
+  job->error = error;
+  job->waiting = false;
+  job->prompt = FINGERPRINT_PROMPT_NONE;
+}
+
+/**
+ * 进入下一步骤
+ * @param delay 距下一条指令的时间(ms)，等待按压或抬起时按采集间隔重试
+ */
+static void fingerprint_job_next(FingerprintJob *job, uint8_t step, uint32_t now, uint32_t delay) {
+  job->step = step;
+  job->waiting = false;
+  job->nextAt = now + delay;
+}
+
+/**
+ * 开始录入作业
+ * @param job 作业
+ * @param pageId 模板号
+ * @param now 当前时间(ms)
+ */
+void fingerprint_job_enroll(FingerprintJob *job, uint16_t pageId, uint32_t now) {
+  fingerprint_job_begin(job, FINGERPRINT_JOB_ENROLL, JOB_CAPTURE1, pageId, now);
+  job->prompt = FINGERPRINT_PROMPT_PLACE;
+}
+
+/**
+ * 开始读出作业（模板存入job->templateData）
+ * @param job 作业
+ * @param pageId 模板号
+ * @param now 当前时间(ms)
+ */
+void fingerprint_job_upload(FingerprintJob *job, uint16_t pageId, uint32_t now) {
+  fingerprint_job_begin(job, FINGERPRINT_JOB_UPLOAD, JOB_LOAD, pageId, now);
+}
+
+/**
+ * 开始写入作业
+ * @param job 作业
+ * @param pageId 模板号
+ * @param data 模板
+ * @param length 模板长度
+ * @param packetSize 模块数据包长度
+ * @param now 当前时间(ms)
+ * @return 是否开始（模板过长时失败）
+ */
+bool fingerprint_job_download(FingerprintJob *job, uint16_t pageId, const uint8_t *data, uint16_t length,
+                              uint16_t packetSize, uint32_t now) {
+  if (length == 0 || length > FINGERPRINT_TEMPLATE_MAX || packetSize < 32 || packetSize > FINGERPRINT_MAX_CONTENT) {
+    return false;
+  }
+
+  fingerprint_job_begin(job, FINGERPRINT_JOB_DOWNLOAD, JOB_DOWN_CHAR, pageId, now);
+  if (data != job->templateData) {
+    memcpy(job->templateData, data, length);
+  }
+  job->templateLength = length;
+  job->packetSize = packetSize;
+  return true;
+}
+
+/**
+ * 生成当前步骤的指令
+ */
+static void fingerprint_job_send(FingerprintJob *job, uint32_t now) {
+  uint8_t command[6];
+  uint16_t length = 0;
+  uint8_t page[2] = {(uint8_t)(job->pageId >> 8), (uint8_t)(job->pageId & 0xFF)};
+
+  switch (job->step) {
+    case JOB_CAPTURE1:
+    case JOB_LIFT:
+    case JOB_CAPTURE2:
+      command[length++] = FINGERPRINT_CMD_GEN_IMAGE;
+      break;
+    case JOB_CONVERT1:
+    case JOB_CONVERT2:
+      command[length++] = FINGERPRINT_CMD_IMAGE_TO_TZ;
+      command[length++] = job->step == JOB_CONVERT1 ? 1 : 2;
+      break;
+    case JOB_MODEL:
+      command[length++] = FINGERPRINT_CMD_REG_MODEL;
+      break;
+    case JOB_STORE:
+    case JOB_LOAD:
+      command[length++] = job->step == JOB_STORE ? FINGERPRINT_CMD_STORE : FINGERPRINT_CMD_LOAD_CHAR;
+      command[length++] = 1;
+      command[length++] = page[0];
+      command[length++] = page[1];
+      break;
+    case JOB_UP_CHAR:
+    case JOB_DOWN_CHAR:
+      command[length++] = job->step == JOB_UP_CHAR ? FINGERPRINT_CMD_UP_CHAR : FINGERPRINT_CMD_DOWN_CHAR;
+      command[length++] = 1;
+      break;
+    case JOB_DOWN_DATA: {
+      // 模块确认下载后连续发送数据包（最后一包为结束包），紧接存储指令
+      size_t offset = 0;
+      for (uint16_t sent = 0; sent < job->templateLength; sent += job->packetSize) {
+        uint16_t chunk = job->templateLength - sent;
+        if (chunk > job->packetSize) {
+          chunk = job->packetSize;
+        }
+        uint8_t pid = sent + chunk >= job->templateLength ? FINGERPRINT_PID_END : FINGERPRINT_PID_DATA;
+        offset += fingerprint_packet_encode(pid, job->templateData + sent, chunk, job->tx + offset, sizeof(job->tx) - offset);
+      }
+      const uint8_t store[] = {FINGERPRINT_CMD_STORE, 1, page[0], page[1]};
+      offset += fingerprint_packet_encode(FINGERPRINT_PID_COMMAND, store, sizeof(store), job->tx + offset, sizeof(job->tx) - offset);
+      job->txLength = offset;
+      job->step = JOB_STORE;
+      job->waiting = true;
+      job->sentAt = now;
+      return;
+    }
+    default:
+      return;
+  }
+
+  job->txLength = fingerprint_packet_encode(FINGERPRINT_PID_COMMAND, command, length, job->tx, sizeof(job->tx));
+  job->waiting = true;
+  job->sentAt = now;
+}
+
+/**
+ * 推进作业：发送到期的指令并检查超时
+ * @param job 作业
+ * @param now 当前时间(ms)
+ */
+void fingerprint_job_poll(FingerprintJob *job, uint32_t now) {
+  if (!fingerprint_job_running(job)) {
+    return;
+  }
+
+  if (job->type == FINGERPRINT_JOB_ENROLL && now - job->startedAt >= FINGERPRINT_ENROLL_TIMEOUT) {
+    fingerprint_job_finish(job, FINGERPRINT_JOB_FAILED, FINGERPRINT_ACK_TIMEOUT);
+    return;
+  }
+
+  if (job->waiting) {
+    if (now - job->sentAt >= FINGERPRINT_RESPONSE_TIMEOUT) {
+      fingerprint_job_finish(job, FINGERPRINT_JOB_FAILED, FINGERPRINT_ACK_TIMEOUT);
+    }
+    return;
+  }
+
+  if ((int32_t)(now - job->nextAt) >= 0) {
+    fingerprint_job_send(job, now);
+  }
+}
+
+/**
+ * 处理录入过程中的应答
+ */
+static void fingerprint_job_enroll_ack(FingerprintJob *job, uint8_t code, uint32_t now) {
+  switch (job->step) {
+    case JOB_CAPTURE1:
+    case JOB_CAPTURE2:
+      if (code == FINGERPRINT_ACK_OK) {
+        fingerprint_job_next(job, job->step == JOB_CAPTURE1 ? JOB_CONVERT1 : JOB_CONVERT2, now, 0);
+      } else {
+        // 无手指或图像不合格，继续等待按压
+        fingerprint_job_next(job, job->step, now, FINGERPRINT_JOB_POLL_MS);
+      }
+      return;
+
+    case JOB_CONVERT1:
+    case JOB_CONVERT2:
+      if (code == FINGERPRINT_ACK_OK) {
+        if (job->step == JOB_CONVERT1) {
+          job->prompt = FINGERPRINT_PROMPT_LIFT;
+          fingerprint_job_next(job, JOB_LIFT, now, FINGERPRINT_JOB_POLL_MS);
+        } else {
+          fingerprint_job_next(job, JOB_MODEL, now, 0);
+        }
+      } else {
+        // 特征质量差，重新采集同一次按压
+        fingerprint_job_next(job, job->step == JOB_CONVERT1 ? JOB_CAPTURE1 : JOB_CAPTURE2, now, FINGERPRINT_JOB_POLL_MS);
+      }
+      return;
+
+    case JOB_LIFT:
+      if (code != FINGERPRINT_ACK_NO_FINGER) {
+        fingerprint_job_next(job, JOB_LIFT, now, FINGERPRINT_JOB_POLL_MS);
+      } else if (job->restart) {
+        job->restart = false;
+        job->prompt = FINGERPRINT_PROMPT_PLACE;
+        fingerprint_job_next(job, JOB_CAPTURE1, now, 0);
+      } else {
+        job->prompt = FINGERPRINT_PROMPT_PLACE_AGAIN;
+        fingerprint_job_next(job, JOB_CAPTURE2, now, 0);
+      }
+      return;
+
+    case JOB_MODEL:
+      if (code == FINGERPRINT_ACK_OK) {
+        fingerprint_job_next(job, JOB_STORE, now, 0);
+      } else if (++job->attempts >= FINGERPRINT_ENROLL_ATTEMPTS) {
+        fingerprint_job_finish(job, FINGERPRINT_JOB_FAILED, code);
+      } else {
+        // 两次按压不是同一手指或差异过大：抬起后从头录入
+        job->restart = true;
+        job->prompt = FINGERPRINT_PROMPT_RETRY;
+        fingerprint_job_next(job, JOB_LIFT, now, 0);
+      }
+      return;
+
+    case JOB_STORE:
+      if (code != FINGERPRINT_ACK_OK) {
+        fingerprint_job_finish(job, FINGERPRINT_JOB_FAILED, code);
+      } else {
+        // 存储后上传模板供镜像备份
+        job->prompt = FINGERPRINT_PROMPT_NONE;
+        fingerprint_job_next(job, JOB_UP_CHAR, now, 0);
+      }
+      return;
+  }
+}
+
+/**
+ * 处理一个数据包
+ */
+static void fingerprint_job_packet(FingerprintJob *job, const FingerprintPacket *packet, uint32_t now) {
+  if (!job->waiting) {
+    // 未等待应答时收到的数据（如超时后的迟到应答）丢弃
+    return;
+  }
+
+  if (job->step == JOB_UP_DATA) {
+    if (packet->pid != FINGERPRINT_PID_DATA && packet->pid != FINGERPRINT_PID_END) {
+      fingerprint_job_finish(job, FINGERPRINT_JOB_FAILED, FINGERPRINT_ACK_PACKET_ERROR);
+      return;
+    }
+    if (job->templateLength + packet->length > FINGERPRINT_TEMPLATE_MAX) {
+      fingerprint_job_finish(job, FINGERPRINT_JOB_FAILED, FINGERPRINT_ACK_PACKET_ERROR);
+      return;
+    }
+    memcpy(job->templateData + job->templateLength, packet->content, packet->length);
+    job->templateLength += packet->length;
+    job->sentAt = now;
+    if (packet->pid == FINGERPRINT_PID_END) {
+      fingerprint_job_finish(job, FINGERPRINT_JOB_DONE, FINGERPRINT_ACK_OK);
+    }
+    return;
+  }
+
+  if (packet->pid != FINGERPRINT_PID_ACK || packet->length < 1) {
+    fingerprint_job_finish(job, FINGERPRINT_JOB_FAILED, FINGERPRINT_ACK_PACKET_ERROR);
+    return;
+  }
+
+  uint8_t code = packet->content[0];
+  if (job->type == FINGERPRINT_JOB_ENROLL && job->step <= JOB_STORE) {
+    fingerprint_job_enroll_ack(job, code, now);
+    return;
+  }
+
+  if (code != FINGERPRINT_ACK_OK) {
+    fingerprint_job_finish(job, FINGERPRINT_JOB_FAILED, code);
+    return;
+  }
+
+  switch (job->step) {
+    case JOB_LOAD:
+      fingerprint_job_next(job, JOB_UP_CHAR, now, 0);
+      break;
+    case JOB_UP_CHAR:
+      // 确认后模块连续发送数据包，保持等待状态
+      job->step = JOB_UP_DATA;
+      job->templateLength = 0;
+      job->sentAt = now;
+      break;
+    case JOB_DOWN_CHAR:
+      fingerprint_job_next(job, JOB_DOWN_DATA, now, 0);
+      break;
+    case JOB_STORE:
+      fingerprint_job_finish(job, FINGERPRINT_JOB_DONE, FINGERPRINT_ACK_OK);
+      break;
+  }
+}
+
+/**
+ * 输入模块应答数据
+ * @param job 作业
+ * @param data 数据
+ * @param length 长度
+ * @param now 当前时间(ms)
+ */
+void fingerprint_job_receive(FingerprintJob *job, const uint8_t *data, size_t length, uint32_t now) {
+  for (size_t i = 0; i < length && fingerprint_job_running(job); i++) {
+    int result = fingerprint_parser_feed(&job->parser, data[i]);
+    if (result < 0 && job->waiting) {
+      fingerprint_job_finish(job, FINGERPRINT_JOB_FAILED, FINGERPRINT_ACK_PACKET_ERROR);
+    } else if (result > 0) {
+      fingerprint_job_packet(job, &job->parser.packet, now);
+    }
+  }
+}
+
+/**
+ * 判断作业是否在进行
+ * @param job 作业
+ * @return 是否进行中
+ */
+bool fingerprint_job_running(const FingerprintJob *job) {
+  return job->type != FINGERPRINT_JOB_NONE && job->state == FINGERPRINT_JOB_RUNNING;
+}
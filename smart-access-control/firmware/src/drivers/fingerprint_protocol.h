@@ -0,0 +1,283 @@
+#ifndef FINGERPRINT_PROTOCOL_H
+#define FINGERPRINT_PROTOCOL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// 指纹模块（R30x / AS608 / ZFM系列）串口协议
+// 数据包: EF01 | 地址(4) | 包标识(1) | 长度(2，内容+校验和) | 内容 | 校验和(2)
+// 本文件不依赖Arduino，驱动只负责串口收发
+
+#define FINGERPRINT_START_CODE       0xEF01
+#define FINGERPRINT_DEFAULT_ADDRESS  0xFFFFFFFF
+#define FINGERPRINT_DEFAULT_PASSWORD 0x00000000
+
+// 包标识
+#define FINGERPRINT_PID_COMMAND  0x01
+#define FINGERPRINT_PID_DATA     0x02
+#define FINGERPRINT_PID_ACK      0x07
+#define FINGERPRINT_PID_END      0x08
+
+// 指令码
+#define FINGERPRINT_CMD_GEN_IMAGE        0x01
+#define FINGERPRINT_CMD_IMAGE_TO_TZ      0x02
+#define FINGERPRINT_CMD_SEARCH           0x04
+#define FINGERPRINT_CMD_REG_MODEL        0x05
+#define FINGERPRINT_CMD_STORE            0x06
+#define FINGERPRINT_CMD_LOAD_CHAR        0x07
+#define FINGERPRINT_CMD_UP_CHAR          0x08
+#define FINGERPRINT_CMD_DOWN_CHAR        0x09
+#define FINGERPRINT_CMD_SET_SYS_PARA     0x0E
+#define FINGERPRINT_CMD_READ_SYS_PARA    0x0F
+#define FINGERPRINT_CMD_VERIFY_PASSWORD  0x13
+#define FINGERPRINT_CMD_HIGH_SPEED_SEARCH 0x1B
+#define FINGERPRINT_CMD_TEMPLATE_COUNT   0x1D
+
+// 确认码
+#define FINGERPRINT_ACK_OK            0x00
+#define FINGERPRINT_ACK_PACKET_ERROR  0x01   // 数据包错误
+#define FINGERPRINT_ACK_NO_FINGER     0x02
+#define FINGERPRINT_ACK_NOT_FOUND     0x09
+#define FINGERPRINT_ACK_MISMATCH      0x0A   // 两次特征无法合并
+#define FINGERPRINT_ACK_EMPTY_PAGE    0x0C   // 读出模板出错（该模板号未录入）
+#define FINGERPRINT_ACK_TIMEOUT       0xFF   // 本地定义：应答或作业超时
+
+// 系统参数：波特率 = 9600 × N，模块支持 N = 1..12
+#define FINGERPRINT_PARAM_BAUD     4
+#define FINGERPRINT_BAUD_UNIT      9600
+#define FINGERPRINT_BAUD_MAX_N     12
+
+// 系统参数：数据包长度 = 32 << N
+#define FINGERPRINT_DEFAULT_PACKET_SIZE  128
+
+// 包内容上限（数据包最大256字节）及编码后整包上限
+#define FINGERPRINT_MAX_CONTENT  256
+#define FINGERPRINT_PACKET_OVERHEAD  11
+#define FINGERPRINT_MAX_PACKET  (FINGERPRINT_MAX_CONTENT + FINGERPRINT_PACKET_OVERHEAD)
+
+// 流水线单条指令的应答超时(ms)
+#define FINGERPRINT_RESPONSE_TIMEOUT  1000
+
+// 模板（特征文件）长度上限
+#define FINGERPRINT_TEMPLATE_MAX  1536
+
+// 作业发送缓冲区：模板按最小数据包（32字节）分包后再加一条存储指令
+#define FINGERPRINT_JOB_TX_SIZE  (FINGERPRINT_TEMPLATE_MAX + (FINGERPRINT_TEMPLATE_MAX / 32 + 2) * FINGERPRINT_PACKET_OVERHEAD)
+
+// 录入：等待按压/抬起时的采集间隔、总超时及合并失败重试次数
+#define FINGERPRINT_JOB_POLL_MS       100
+#define FINGERPRINT_ENROLL_TIMEOUT    60000
+#define FINGERPRINT_ENROLL_ATTEMPTS   3
+
+// 数据包
+typedef struct {
+  uint8_t pid;
+  uint16_t length;                           // 内容长度（不含校验和）
+  uint8_t content[FINGERPRINT_MAX_CONTENT];
+} FingerprintPacket;
+
+// 增量解析器（逐字节输入，不阻塞）
+typedef struct {
+  uint8_t state;
+  uint16_t index;
+  uint16_t remaining;
+  uint16_t checksum;
+  uint16_t received;
+  FingerprintPacket packet;
+} FingerprintParser;
+
+// 识别流水线阶段
+typedef enum {
+  FINGERPRINT_STAGE_IDLE,
+  FINGERPRINT_STAGE_CAPTURE,     // 已发送采集图像
+  FINGERPRINT_STAGE_CONVERT,     // 已发送生成特征
+  FINGERPRINT_STAGE_SEARCH       // 已发送搜索
+} FingerprintStage;
+
+// 识别流水线事件
+typedef enum {
+  FINGERPRINT_EVENT_NONE,
+  FINGERPRINT_EVENT_MATCH,       // 识别成功，pipeline.resultId为模板号
+  FINGERPRINT_EVENT_NO_MATCH,    // 指纹库中无此指纹
+  FINGERPRINT_EVENT_ERROR        // 图像质量差、应答超时或校验错误
+} FingerprintEvent;
+
+// 识别流水线：采集一次 → 生成特征 → 搜索
+typedef struct {
+  FingerprintStage stage;
+  FingerprintParser parser;
+  uint16_t capacity;             // 指纹库容量（搜索范围）
+  bool awaitLift;                // 出结果后等待手指离开，避免同一次按压重复识别
+  uint32_t sentAt;
+  int resultId;
+  uint8_t tx[FINGERPRINT_MAX_PACKET];   // 待发送指令
+  size_t txLength;
+} FingerprintPipeline;
+
+// 管理作业类型
+typedef enum {
+  FINGERPRINT_JOB_NONE,
+  FINGERPRINT_JOB_ENROLL,        // 录入：两次采集 → 合并 → 存储 → 上传模板
+  FINGERPRINT_JOB_UPLOAD,        // 读出：载入模板 → 上传
+  FINGERPRINT_JOB_DOWNLOAD       // 写入：下载模板 → 存储
+} FingerprintJobType;
+
+// 作业状态
+typedef enum {
+  FINGERPRINT_JOB_RUNNING,
+  FINGERPRINT_JOB_DONE,
+  FINGERPRINT_JOB_FAILED
+} FingerprintJobState;
+
+// 录入提示
+typedef enum {
+  FINGERPRINT_PROMPT_NONE,
+  FINGERPRINT_PROMPT_PLACE,        // 请放置手指
+  FINGERPRINT_PROMPT_LIFT,         // 请抬起手指
+  FINGERPRINT_PROMPT_PLACE_AGAIN,  // 请再次放置手指
+  FINGERPRINT_PROMPT_RETRY         // 两次不一致，请重新录入
+} FingerprintPrompt;
+
+// 管理作业（可恢复的状态机，不阻塞）
+typedef struct {
+  FingerprintJobType type;
+  FingerprintJobState state;
+  FingerprintPrompt prompt;
+  uint8_t step;
+  uint8_t attempts;
+  uint8_t error;                 // 失败时的模块确认码
+  bool waiting;                  // 已发送指令，等待应答
+  bool restart;                  // 抬起后从第一次采集重新开始
+  uint16_t pageId;
+  uint16_t packetSize;
+  uint32_t startedAt;
+  uint32_t sentAt;
+  uint32_t nextAt;               // 下一条指令的发送时间
+  FingerprintParser parser;
+  uint8_t templateData[FINGERPRINT_TEMPLATE_MAX];
+  uint16_t templateLength;
+  uint8_t tx[FINGERPRINT_JOB_TX_SIZE];
+  size_t txLength;
+} FingerprintJob;
+
+/**
+ * 编码数据包
+ * @param pid 包标识
+ * @param content 内容
+ * @param length 内容长度
+ * @param out 输出缓冲区
+ * @param size 缓冲区大小
+ * @return 编码长度，0表示缓冲区不足
+ */
+size_t fingerprint_packet_encode(uint8_t pid, const uint8_t *content, uint16_t length, uint8_t *out, size_t size);
+
+/**
+ * 解析器复位
+ * @param parser 解析器
+ */
+void fingerprint_parser_reset(FingerprintParser *parser);
+
+/**
+ * 输入一个字节
+ * @param parser 解析器
+ * @param byte 字节
+ * @return 1表示收到完整数据包（parser->packet），-1表示校验错误，0表示继续
+ */
+int fingerprint_parser_feed(FingerprintParser *parser, uint8_t byte);
+
+/**
+ * 流水线初始化
+ * @param pipeline 流水线
+ * @param capacity 指纹库容量
+ */
+void fingerprint_pipeline_init(FingerprintPipeline *pipeline, uint16_t capacity);
+
+/**
+ * 空闲时发起一次采集
+ * @param pipeline 流水线
+ * @param now 当前时间(ms)
+ * @return 是否发起（指令放入pipeline->tx）
+ */
+bool fingerprint_pipeline_start(FingerprintPipeline *pipeline, uint32_t now);
+
+/**
+ * 输入模块应答数据
+ * 收到应答后下一条指令放入pipeline->tx
+ * @param pipeline 流水线
+ * @param data 数据
+ * @param length 长度
+ * @param now 当前时间(ms)
+ * @return 事件
+ */
+FingerprintEvent fingerprint_pipeline_receive(FingerprintPipeline *pipeline, const uint8_t *data, size_t length, uint32_t now);
+
+/**
+ * 检查应答超时
+ * @param pipeline 流水线
+ * @param now 当前时间(ms)
+ * @return 超时时为FINGERPRINT_EVENT_ERROR
+ */
+FingerprintEvent fingerprint_pipeline_check_timeout(FingerprintPipeline *pipeline, uint32_t now);
+
+/**
+ * 判断流水线是否在等待应答
+ * @param pipeline 流水线
+ * @return 是否忙
+ */
+bool fingerprint_pipeline_busy(const FingerprintPipeline *pipeline);
+
+/**
+ * 开始录入作业
+ * @param job 作业
+ * @param pageId 模板号
+ * @param now 当前时间(ms)
+ */
+void fingerprint_job_enroll(FingerprintJob *job, uint16_t pageId, uint32_t now);
+
+/**
+ * 开始读出作业（模板存入job->templateData）
+ * @param job 作业
+ * @param pageId 模板号
+ * @param now 当前时间(ms)
+ */
+void fingerprint_job_upload(FingerprintJob *job, uint16_t pageId, uint32_t now);
+
+/**
+ * 开始写入作业
+ * @param job 作业
+ * @param pageId 模板号
+ * @param data 模板
+ * @param length 模板长度
+ * @param packetSize 模块数据包长度
+ * @param now 当前时间(ms)
+ * @return 是否开始（模板过长时失败）
+ */
+bool fingerprint_job_download(FingerprintJob *job, uint16_t pageId, const uint8_t *data, uint16_t length,
+                              uint16_t packetSize, uint32_t now);
+
+/**
+ * 推进作业：发送到期的指令并检查超时
+ * 待发送数据放入job->tx
+ * @param job 作业
+ * @param now 当前时间(ms)
+ */
+void fingerprint_job_poll(FingerprintJob *job, uint32_t now);
+
+/**
+ * 输入模块应答数据
+ * @param job 作业
+ * @param data 数据
+ * @param length 长度
+ * @param now 当前时间(ms)
+ */
+void fingerprint_job_receive(FingerprintJob *job, const uint8_t *data, size_t length, uint32_t now);
+
+/**
+ * 判断作业是否在进行
+ * @param job 作业
+ * @return 是否进行中
+ */
+bool fingerprint_job_running(const FingerprintJob *job);
+
+#endif
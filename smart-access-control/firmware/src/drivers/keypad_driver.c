@@ -1,4 +1,10 @@
 #include <Arduino.h>
+#include <freertos/timers.h>
+
+// 头文件包含
+#include "drivers/keypad_driver.h"
+#include "drivers/keypad_matrix.h"
+#include "modules/event_bus.h"
 
 // 键盘引脚定义
 #define ROW1_PIN 25
@@ -11,9 +17,21 @@
 #define COL3_PIN 0
 #define COL4_PIN 4
 
+// 按键事件队列长度
+#define KEYPAD_QUEUE_LENGTH 16
+
+// 行切换后等待列电平稳定的时间(us)
+#define KEYPAD_SETTLE_US 5
+
 // 键盘状态
 bool keypadInitialized = false;
 
+// 非阻塞密码输入状态
+#define KEYPAD_ENTRY_SIZE 20
+char keypadEntry[KEYPAD_ENTRY_SIZE];
+int keypadEntryLength = 0;
+unsigned long keypadEntryLastKey = 0;
+
 // 键盘映射
 char keymap[4][4] = {
   {'1', '2', '3', 'A'},
@@ -28,19 +46,143 @@ int rowPins[] = {ROW1_PIN, ROW2_PIN, ROW3_PIN, ROW4_PIN};
 // 列引脚
 int colPins[] = {COL1_PIN, COL2_PIN, COL3_PIN, COL4_PIN};
 
+// 扫描消抖（只在定时器回调中访问）
+KeypadMatrix keypadMatrix;
+
+// 按键事件队列（定时器回调写入，读取方任务取出）
+QueueHandle_t keypadQueue = NULL;
+
+// 扫描定时器：列中断启动，全部按键抬起并稳定后停止
+TimerHandle_t keypadScanTimer = NULL;
+volatile bool keypadScanning = false;
+
+// 统计
+volatile uint32_t keypadInterrupts = 0;
+uint32_t keypadScans = 0;
+uint32_t keypadEvents = 0;
+uint32_t keypadDropped = 0;
+
+/**
+ * 列中断服务程序
+ * 空闲时所有行为低电平，任一按键按下都会拉低所在列；扫描期间行电平切换产生的中断直接忽略
+ */
+static void IRAM_ATTR keypad_column_isr() {
+  if (keypadScanning) {
+    return;
+  }
+  keypadScanning = true;
+  keypadInterrupts++;
+
+  // 定时器命令队列满时保持空闲，下一次下降沿再启动
+  BaseType_t woken = pdFALSE;
+  if (xTimerStartFromISR(keypadScanTimer, &woken) != pdPASS) {
+    keypadScanning = false;
+  }
+  if (woken) {
+    portYIELD_FROM_ISR();
+  }
+}
+
+/**
+ * 读取按下位图
+ * 逐行拉低，结束后恢复所有行为低电平（空闲状态）
+ */
+static uint16_t keypad_read_matrix() {
+  uint16_t raw = 0;
+  for (int row = 0; row < 4; row++) {
+    for (int i = 0; i < 4; i++) {
+      digitalWrite(rowPins[i], i == row ? LOW : HIGH);
+    }
+    delayMicroseconds(KEYPAD_SETTLE_US);
+    for (int col = 0; col < 4; col++) {
+      if (digitalRead(colPins[col]) == LOW) {
+        raw |= 1u << (row * KEYPAD_COLS + col);
+      }
+    }
+  }
+
+  for (int i = 0; i < 4; i++) {
+    digitalWrite(rowPins[i], LOW);
+  }
+  return raw;
+}
+
+/**
+ * 判断是否有列处于低电平（所有行为低电平时调用）
+ */
+static bool keypad_any_column_low() {
+  for (int col = 0; col < 4; col++) {
+    if (digitalRead(colPins[col]) == LOW) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * 扫描定时器回调（定时器服务任务中执行）
+ */
+static void keypad_scan_timer(TimerHandle_t timer) {
+  uint16_t raw = keypad_read_matrix();
+  keypadScans++;
+
+  KeypadEvent events[KEYPAD_KEYS];
+  int count = keypad_matrix_feed(&keypadMatrix, raw, millis(), events, KEYPAD_KEYS);
+  for (int i = 0; i < count; i++) {
+    if (xQueueSend(keypadQueue, &events[i], 0) == pdTRUE) {
+      keypadEvents++;
+    } else {
+      keypadDropped++;
+      continue;
+    }
+
+    // 按下时通知访问控制任务（按键内容由 keypad_read_event 按序取出）
+    if (events[i].pressed) {
+      BusEvent event = {};
+      event.type = BUS_EVENT_KEY;
+      event.active = true;
+      event.key = events[i].key;
+      event.timestamp = events[i].timestamp;
+      event_bus_post(&event);
+    }
+  }
+
+  if (!keypad_matrix_idle(&keypadMatrix)) {
+    return;
+  }
+
+  // 停止扫描，等待下一次列中断；清除标志后再检查一次列电平，避免漏掉其间按下的键
+  xTimerStop(timer, 0);
+  keypadScanning = false;
+  if (keypad_any_column_low()) {
+    keypadScanning = true;
+    xTimerStart(timer, 0);
+  }
+}
+
 /**
  * 键盘初始化
  */
 void keypad_init() {
-  // 初始化行引脚为输出
+  keypadQueue = xQueueCreate(KEYPAD_QUEUE_LENGTH, sizeof(KeypadEvent));
+  keypadScanTimer = xTimerCreate("KeypadScan", pdMS_TO_TICKS(KEYPAD_SCAN_INTERVAL_MS), pdTRUE, NULL,
+                                 keypad_scan_timer);
+  if (!keypadQueue || !keypadScanTimer) {
+    Serial.println("键盘驱动初始化失败");
+    return;
+  }
+  keypad_matrix_init(&keypadMatrix, &keymap[0][0]);
+
+  // 初始化行引脚为输出，空闲时全部拉低
   for (int i = 0; i < 4; i++) {
     pinMode(rowPins[i], OUTPUT);
-    digitalWrite(rowPins[i], HIGH);
+    digitalWrite(rowPins[i], LOW);
   }
   
-  // 初始化列引脚为输入，上拉
+  // 初始化列引脚为输入，上拉，按键按下时产生下降沿
   for (int i = 0; i < 4; i++) {
     pinMode(colPins[i], INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(colPins[i]), keypad_column_isr, FALLING);
   }
   
   keypadInitialized = true;
@@ -48,44 +190,42 @@ void keypad_init() {
 }
 
 /**
- * 扫描键盘
- * @return 按键值，0表示无按键
+ * 读取按键事件（不等待）
+ * @param event 按键事件
+ * @return 是否有事件
  */
-char keypad_scan() {
+bool keypad_read_event(KeypadEvent *event) {
   if (!keypadInitialized) {
-    return 0;
+    return false;
   }
-  
-  // 扫描每一行
-  for (int row = 0; row < 4; row++) {
-    // 设置当前行为低电平
-    digitalWrite(rowPins[row], LOW);
-    
-    // 扫描每一列
-    for (int col = 0; col < 4; col++) {
-      if (digitalRead(colPins[col]) == LOW) {
-        // 按键被按下
-        delay(50); // 消抖
-        
-        // 等待按键释放
-        while (digitalRead(colPins[col]) == LOW) {
-          delay(10);
-        }
-        
-        // 恢复行状态
-        digitalWrite(rowPins[row], HIGH);
-        
-        return keymap[row][col];
-      }
+  return xQueueReceive(keypadQueue, event, 0) == pdTRUE;
+}
+
+/**
+ * 读取按键
+ * @return 按键值，0表示无按键
+ */
+char keypad_scan() {
+  KeypadEvent event;
+  while (keypad_read_event(&event)) {
+    if (event.pressed) {
+      return event.key;
     }
-    
-    // 恢复行状态
-    digitalWrite(rowPins[row], HIGH);
   }
-  
   return 0;
 }
 
+/**
+ * 获取键盘统计
+ * @param stats 统计
+ */
+void keypad_get_stats(KeypadStats *stats) {
+  stats->interrupts = keypadInterrupts;
+  stats->scans = keypadScans;
+  stats->events = keypadEvents;
+  stats->dropped = keypadDropped;
+}
+
 /**
  * 获取密码输入
  * @param password 密码缓冲区
@@ -112,7 +252,7 @@ int keypad_get_password(char *password, int maxLength, unsigned long timeout) {
         // 删除
         if (length > 0) {
           length--;
-          Serial.print("\b \");
+          Serial.print("\b \b");
         }
       } else {
         // 数字或字母
@@ -128,6 +268,69 @@ int keypad_get_password(char *password, int maxLength, unsigned long timeout) {
   return length;
 }
 
+/**
+ * 非阻塞密码输入
+ * @param password 密码缓冲区
+ * @param size 缓冲区大小
+ * @param idleTimeout 空闲超时时间(ms)
+ * @return 输入完成时返回长度，否则返回0
+ */
+int keypad_poll_password(char *password, int size, unsigned long idleTimeout) {
+  if (!keypadInitialized) {
+    return 0;
+  }
+
+  // 空闲超时，丢弃未完成的输入
+  if (keypadEntryLength > 0 && millis() - keypadEntryLastKey >= idleTimeout) {
+    keypadEntryLength = 0;
+    Serial.println("\n密码输入超时");
+  }
+
+  // 处理队列中全部按键（多个按键可能在一次唤醒前入队），到#为止
+  KeypadEvent event;
+  while (keypad_read_event(&event)) {
+    if (!event.pressed) {
+      continue;
+    }
+    keypadEntryLastKey = event.timestamp;
+
+    if (event.key == '#') {
+      // 结束输入
+      int length = keypadEntryLength;
+      if (length >= size) {
+        length = size - 1;
+      }
+      memcpy(password, keypadEntry, length);
+      password[length] = '\0';
+      keypadEntryLength = 0;
+      Serial.println();
+      return length;
+    }
+
+    if (event.key == '*') {
+      // 删除
+      if (keypadEntryLength > 0) {
+        keypadEntryLength--;
+        Serial.print("\b \b");
+      }
+    } else if (keypadEntryLength < KEYPAD_ENTRY_SIZE - 1) {
+      // 数字或字母
+      keypadEntry[keypadEntryLength++] = event.key;
+      Serial.print('*');
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * 判断是否有未完成的密码输入
+ * @return 是否正在输入
+ */
+bool keypad_is_entering() {
+  return keypadEntryLength > 0;
+}
+
 /**
  * 检查键盘状态
  * @return 是否初始化成功
@@ -156,5 +359,8 @@ void keypad_test() {
     delay(10);
   }
   
-  Serial.println("键盘测试完成");
+  KeypadStats stats;
+  keypad_get_stats(&stats);
+  Serial.printf("键盘测试完成（中断%u次，扫描%u次，事件%u个，丢弃%u个）\n", stats.interrupts, stats.scans,
+                stats.events, stats.dropped);
 }
@@ -3,17 +3,42 @@
 
 #include <Arduino.h>
 
+// 头文件包含
+#include "drivers/keypad_matrix.h"
+
+// 键盘统计
+typedef struct {
+  uint32_t interrupts;   // 列中断启动扫描的次数
+  uint32_t scans;        // 扫描次数（空闲时不扫描）
+  uint32_t events;       // 入队的按键事件数
+  uint32_t dropped;      // 队列满丢弃的事件数
+} KeypadStats;
+
 /**
  * 键盘初始化
  */
 void keypad_init();
 
 /**
- * 扫描键盘
+ * 读取按键
+ * 按键由列中断启动的定时器扫描、消抖后放入事件队列，本函数只从队列取出一个按下事件，不等待
  * @return 按键值，0表示无按键
  */
 char keypad_scan();
 
+/**
+ * 读取按键事件（按下和抬起，不等待）
+ * @param event 按键事件
+ * @return 是否有事件
+ */
+bool keypad_read_event(KeypadEvent *event);
+
+/**
+ * 获取键盘统计
+ * @param stats 统计
+ */
+void keypad_get_stats(KeypadStats *stats);
+
 /**
  * 获取密码输入
  * @param password 密码缓冲区
@@ -23,6 +48,22 @@ char keypad_scan();
  */
 int keypad_get_password(char *password, int maxLength, unsigned long timeout);
 
+/**
+ * 非阻塞密码输入
+ * 每次调用处理事件队列中已有的按键，按#结束输入，*删除一位；超过空闲时间未按键则清空已输入内容
+ * @param password 密码缓冲区
+ * @param size 缓冲区大小
+ * @param idleTimeout 空闲超时时间(ms)
+ * @return 输入完成时返回长度，否则返回0
+ */
+int keypad_poll_password(char *password, int size, unsigned long idleTimeout);
+
+/**
+ * 判断是否有未完成的密码输入
+ * @return 是否正在输入
+ */
+bool keypad_is_entering();
+
 /**
  * 检查键盘状态
  * @return 是否初始化成功
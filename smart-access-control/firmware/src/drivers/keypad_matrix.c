@@ -0,0 +1,69 @@
+#include <string.h>
+
+// 头文件包含
+#include "drivers/keypad_matrix.h"
+
+/**
+ * 扫描消抖初始化
+ * @param matrix 扫描消抖状态
+ * @param keymap 按键值
+ */
+void keypad_matrix_init(KeypadMatrix *matrix, const char *keymap) {
+  memset(matrix, 0, sizeof(*matrix));
+  matrix->keymap = keymap;
+  matrix->quiet = KEYPAD_DEBOUNCE_SCANS;
+}
+
+/**
+ * 处理一次扫描结果
+ * @param matrix 扫描消抖状态
+ * @param raw 按下位图
+ * @param now 当前时间(ms)
+ * @param events 输出事件
+ * @param maxEvents 输出事件数上限
+ * @return 事件数
+ */
+int keypad_matrix_feed(KeypadMatrix *matrix, uint16_t raw, uint32_t now, KeypadEvent *events, int maxEvents) {
+  if (raw) {
+    matrix->quiet = 0;
+  } else if (matrix->quiet < KEYPAD_DEBOUNCE_SCANS) {
+    matrix->quiet++;
+  }
+
+  int count = 0;
+  uint16_t changed = raw ^ matrix->stable;
+  for (int i = 0; i < KEYPAD_KEYS; i++) {
+    uint16_t bit = 1u << i;
+    if (!(changed & bit)) {
+      // 抖动回到稳定状态，重新计数
+      matrix->counts[i] = 0;
+      continue;
+    }
+    if (matrix->counts[i] == 0) {
+      matrix->since[i] = now;
+    }
+    if (matrix->counts[i] < KEYPAD_DEBOUNCE_SCANS) {
+      matrix->counts[i]++;
+    }
+    if (matrix->counts[i] < KEYPAD_DEBOUNCE_SCANS || count >= maxEvents) {
+      continue;
+    }
+
+    matrix->stable ^= bit;
+    matrix->counts[i] = 0;
+    events[count].key = matrix->keymap[i];
+    events[count].pressed = (raw & bit) != 0;
+    events[count].timestamp = matrix->since[i];
+    count++;
+  }
+  return count;
+}
+
+/**
+ * 判断是否可以停止扫描
+ * @param matrix 扫描消抖状态
+ * @return 全部按键抬起且已稳定
+ */
+bool keypad_matrix_idle(const KeypadMatrix *matrix) {
+  return matrix->stable == 0 && matrix->quiet >= KEYPAD_DEBOUNCE_SCANS;
+}
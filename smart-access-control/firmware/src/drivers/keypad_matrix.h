@@ -0,0 +1,64 @@
+#ifndef KEYPAD_MATRIX_H
+#define KEYPAD_MATRIX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 4×4矩阵键盘扫描消抖
+// 驱动在定时器中逐行扫描，把16个按键的电平合成位图交给本模块；每个按键单独消抖，
+// 电平与稳定状态不同且连续若干次扫描保持时产生按下/抬起事件，一个键抖动不影响其他键（滚键）。
+// 全部按键抬起并稳定后驱动停止扫描，等待列中断。
+// 本文件不依赖Arduino，可在主机上测试（tools/bench/keypad_bench.c）
+
+#define KEYPAD_ROWS  4
+#define KEYPAD_COLS  4
+#define KEYPAD_KEYS  (KEYPAD_ROWS * KEYPAD_COLS)
+
+// 扫描间隔(ms)
+#define KEYPAD_SCAN_INTERVAL_MS  5
+
+// 按键电平连续保持的扫描次数（4次×5ms，覆盖常见薄膜键盘10ms以内的抖动）
+#define KEYPAD_DEBOUNCE_SCANS  4
+
+// 按键事件
+typedef struct {
+  char key;             // 按键值
+  bool pressed;         // 按下/抬起
+  uint32_t timestamp;   // 首次扫描到该变化的时间(ms)
+} KeypadEvent;
+
+// 扫描消抖状态
+typedef struct {
+  const char *keymap;   // 按行排列的按键值（KEYPAD_KEYS个）
+  uint16_t stable;                 // 稳定的按下位图（位序号 = 行 × KEYPAD_COLS + 列）
+  uint8_t counts[KEYPAD_KEYS];     // 电平与稳定状态不同的连续扫描次数
+  uint32_t since[KEYPAD_KEYS];     // 本次变化首次扫描到的时间(ms)
+  uint8_t quiet;                   // 无按键接通的连续扫描次数
+} KeypadMatrix;
+
+/**
+ * 扫描消抖初始化
+ * @param matrix 扫描消抖状态
+ * @param keymap 按行排列的按键值（KEYPAD_KEYS个）
+ */
+void keypad_matrix_init(KeypadMatrix *matrix, const char *keymap);
+
+/**
+ * 处理一次扫描结果
+ * @param matrix 扫描消抖状态
+ * @param raw 按下位图
+ * @param now 当前时间(ms)
+ * @param events 输出事件
+ * @param maxEvents 输出事件数上限（不小于KEYPAD_KEYS时不会丢事件）
+ * @return 事件数
+ */
+int keypad_matrix_feed(KeypadMatrix *matrix, uint16_t raw, uint32_t now, KeypadEvent *events, int maxEvents);
+
+/**
+ * 判断是否可以停止扫描
+ * @param matrix 扫描消抖状态
+ * @return 全部按键抬起且已稳定
+ */
+bool keypad_matrix_idle(const KeypadMatrix *matrix);
+
+#endif
@@ -1,16 +1,84 @@
 #include <Arduino.h>
+#include "esp_timer.h"
+
+// 头文件包含
+#include "drivers/lock_driver.h"
+#include "drivers/buzzer_driver.h"
+#include "modules/access_trace.h"
 
 // 锁引脚定义
 #define LOCK_PIN    13
-#define BUZZER_PIN  12
 
 // 状态定义
 #define LOCK_STATE_LOCKED    0
 #define LOCK_STATE_UNLOCKED  1
 
-// 锁状态
-int lockState = LOCK_STATE_LOCKED;
+// 锁状态（访问控制任务、通信任务和定时器任务访问，修改在临界区内进行）
+volatile int lockState = LOCK_STATE_LOCKED;
 bool lockInitialized = false;
+portMUX_TYPE lockMux = portMUX_INITIALIZER_UNLOCKED;
+
+// 关锁定时器：开锁时启动，再次开锁时重新计时；开锁期间门打开后又关上则提前关锁
+esp_timer_handle_t lockRelockTimer = NULL;
+bool lockDoorOpened = false;
+
+// 关锁到期时间(us)，0表示不自动关锁；在临界区内随锁状态一起修改。
+// 定时器在临界区外重启，旧的一次可能在重新计时后才到时，回调以到期时间为准
+int64_t lockRelockAt = 0;
+
+// 锁状态变化回调
+LockCallback lockCallback = NULL;
+
+// 统计
+LockStats lockStats;
+
+/**
+ * 关锁输出（临界区外调用）
+ * 不停止关锁定时器：此时可能已被再次开锁重新启动，残留的一次到时后按到期时间忽略
+ * @param timedNow 关锁定时器到时的当前时间(us)，未到期（已重新计时或不自动关锁）时不关锁；0表示立即关锁
+ * @return 锁状态是否变化
+ */
+static bool lock_engage(int64_t timedNow) {
+  portENTER_CRITICAL(&lockMux);
+  if (timedNow && (lockRelockAt == 0 || lockRelockAt > timedNow)) {
+    portEXIT_CRITICAL(&lockMux);
+    return false;
+  }
+  bool changed = lockState != LOCK_STATE_LOCKED;
+  lockState = LOCK_STATE_LOCKED;
+  lockDoorOpened = false;
+  lockRelockAt = 0;
+  digitalWrite(LOCK_PIN, LOW);
+  portEXIT_CRITICAL(&lockMux);
+
+  if (changed) {
+    if (lockCallback) {
+      lockCallback(true);
+    }
+    buzzer_play(TONE_PATTERN_LOCK);
+    Serial.println("门已关锁");
+  }
+  return changed;
+}
+
+/**
+ * 关锁定时器回调（esp_timer任务中执行）
+ */
+static void lock_relock_timer(void *arg) {
+  int64_t now = esp_timer_get_time();
+  if (lock_engage(now)) {
+    lockStats.timedRelocks++;
+    return;
+  }
+
+  // 重新计时后旧的一次提前到时，按剩余时间再启动（定时器已被重新启动时不影响）
+  portENTER_CRITICAL(&lockMux);
+  int64_t relockAt = lockRelockAt;
+  portEXIT_CRITICAL(&lockMux);
+  if (relockAt > now) {
+    esp_timer_start_once(lockRelockTimer, (uint64_t)(relockAt - now));
+  }
+}
 
 /**
  * 锁驱动初始化
@@ -18,11 +86,19 @@ bool lockInitialized = false;
 void lock_init() {
   // 初始化引脚
   pinMode(LOCK_PIN, OUTPUT);
-  pinMode(BUZZER_PIN, OUTPUT);
   
   // 初始状态
   digitalWrite(LOCK_PIN, LOW); // 锁定状态
-  digitalWrite(BUZZER_PIN, LOW); // 蜂鸣器关闭
+
+  // 关锁定时器
+  esp_timer_create_args_t relockArgs = {};
+  relockArgs.callback = lock_relock_timer;
+  relockArgs.name = "lock_relock";
+  if (esp_timer_create(&relockArgs, &lockRelockTimer) != ESP_OK) {
+    Serial.println("锁驱动定时器创建失败");
+    return;
+  }
+  memset(&lockStats, 0, sizeof(lockStats));
   
   lockInitialized = true;
   Serial.println("锁驱动初始化完成");
@@ -30,7 +106,8 @@ void lock_init() {
 
 /**
  * 开锁
- * @param duration 开锁时间(ms)
+ * 立即返回，到时由定时器关锁；开锁期间再次开锁从本次开始重新计时
+ * @param duration 开锁时间(ms)，0表示不自动关锁
  * @return 是否成功
  */
 bool lock_unlock(unsigned long duration) {
@@ -38,21 +115,35 @@ bool lock_unlock(unsigned long duration) {
     return false;
   }
   
-  // 开锁
+  // 开锁，到期时间与锁状态一起更新
+  int64_t now = esp_timer_get_time();
+  portENTER_CRITICAL(&lockMux);
+  bool extended = lockState == LOCK_STATE_UNLOCKED;
   digitalWrite(LOCK_PIN, HIGH);
   lockState = LOCK_STATE_UNLOCKED;
+  lockRelockAt = duration > 0 ? now + (int64_t)duration * 1000 : 0;
+  portEXIT_CRITICAL(&lockMux);
+  ACCESS_TRACE(ACCESS_TRACE_RELAY);
+
+  // 重新计时（不自动关锁时保留定时器，到时按到期时间忽略）
+  if (duration > 0) {
+    esp_timer_stop(lockRelockTimer);
+    esp_timer_start_once(lockRelockTimer, (uint64_t)duration * 1000);
+  }
   
   // 蜂鸣器提示
-  digitalWrite(BUZZER_PIN, HIGH);
-  delay(200);
-  digitalWrite(BUZZER_PIN, LOW);
+  buzzer_play(TONE_PATTERN_ACCEPT);
   
-  Serial.println("门已开锁");
-  
-  // 延时后关锁
-  if (duration > 0) {
-    delay(duration);
-    lock_lock();
+  if (!extended && lockCallback) {
+    lockCallback(false);
+  }
+
+  if (extended) {
+    lockStats.extensions++;
+    Serial.printf("门保持开锁，重新计时%lums\n", duration);
+  } else {
+    lockStats.unlocks++;
+    Serial.println("门已开锁");
   }
   
   return true;
@@ -67,49 +158,59 @@ bool lock_lock() {
     return false;
   }
   
-  // 关锁
-  digitalWrite(LOCK_PIN, LOW);
-  lockState = LOCK_STATE_LOCKED;
-  
-  // 蜂鸣器提示
-  digitalWrite(BUZZER_PIN, HIGH);
-  delay(100);
-  digitalWrite(BUZZER_PIN, LOW);
-  
-  Serial.println("门已关锁");
+  lock_engage(0);
   
   return true;
 }
 
 /**
- * 获取锁状态
- * @return 锁状态
- */
-int lock_get_state() {
-  return lockState;
-}
-
-/**
- * 蜂鸣器报警
- * @param duration 报警时间(ms)
- * @param frequency 频率(Hz)
+ * 门状态变化通知
+ * 开锁期间门打开后又关上，说明已有人通过，立即关锁而不等到开锁时间结束
+ * @param open 门是否打开
  */
-void lock_buzzer_alarm(unsigned long duration, unsigned int frequency) {
+void lock_door_changed(bool open) {
   if (!lockInitialized) {
     return;
   }
-  
-  unsigned long startTime = millis();
-  unsigned int halfPeriod = 1000000 / (frequency * 2);
-  
-  while (millis() - startTime < duration) {
-    digitalWrite(BUZZER_PIN, HIGH);
-    delayMicroseconds(halfPeriod);
-    digitalWrite(BUZZER_PIN, LOW);
-    delayMicroseconds(halfPeriod);
+
+  portENTER_CRITICAL(&lockMux);
+  bool relock = false;
+  if (lockState == LOCK_STATE_UNLOCKED) {
+    if (open) {
+      lockDoorOpened = true;
+    } else {
+      relock = lockDoorOpened;
+    }
+  }
+  portEXIT_CRITICAL(&lockMux);
+
+  if (relock && lock_engage(0)) {
+    lockStats.doorRelocks++;
   }
-  
-  digitalWrite(BUZZER_PIN, LOW);
+}
+
+/**
+ * 设置锁状态变化回调
+ * @param callback 回调
+ */
+void lock_set_callback(LockCallback callback) {
+  lockCallback = callback;
+}
+
+/**
+ * 获取锁统计
+ * @param stats 统计
+ */
+void lock_get_stats(LockStats *stats) {
+  *stats = lockStats;
+}
+
+/**
+ * 获取锁状态
+ * @return 锁状态
+ */
+int lock_get_state() {
+  return lockState;
 }
 
 /**
@@ -135,11 +236,15 @@ void lock_test() {
   Serial.println("测试开锁...");
   lock_unlock(2000);
   
-  delay(1000);
+  delay(3000);
   
   // 测试蜂鸣器
   Serial.println("测试蜂鸣器...");
-  lock_buzzer_alarm(1000, 1000);
+  buzzer_play(TONE_PATTERN_DENY);
+  delay(1000);
   
-  Serial.println("锁驱动测试完成");
+  LockStats stats;
+  lock_get_stats(&stats);
+  Serial.printf("锁驱动测试完成（开锁%u次，重新计时%u次，到时关锁%u次，关门关锁%u次）\n", stats.unlocks,
+                stats.extensions, stats.timedRelocks, stats.doorRelocks);
 }
@@ -3,6 +3,17 @@
 
 #include <Arduino.h>
 
+// 锁统计
+typedef struct {
+  uint32_t unlocks;        // 开锁次数
+  uint32_t extensions;     // 开锁期间再次开锁（重新计时）的次数
+  uint32_t timedRelocks;   // 开锁时间到自动关锁的次数
+  uint32_t doorRelocks;    // 门关上后提前关锁的次数
+} LockStats;
+
+// 锁状态变化回调（在改变锁状态的任务中调用，关锁定时器到时为esp_timer任务）
+typedef void (*LockCallback)(bool locked);
+
 /**
  * 锁驱动初始化
  */
@@ -10,7 +21,8 @@ void lock_init();
 
 /**
  * 开锁
- * @param duration 开锁时间(ms)
+ * 立即返回，到时由定时器关锁；开锁期间再次开锁从本次开始重新计时
+ * @param duration 开锁时间(ms)，0表示不自动关锁
  * @return 是否成功
  */
 bool lock_unlock(unsigned long duration);
@@ -22,17 +34,29 @@ bool lock_unlock(unsigned long duration);
 bool lock_lock();
 
 /**
- * 获取锁状态
- * @return 锁状态
+ * 门状态变化通知
+ * 开锁期间门打开后又关上时提前关锁
+ * @param open 门是否打开
  */
-int lock_get_state();
+void lock_door_changed(bool open);
+
+/**
+ * 设置锁状态变化回调
+ * @param callback 回调
+ */
+void lock_set_callback(LockCallback callback);
 
 /**
- * 蜂鸣器报警
- * @param duration 报警时间(ms)
- * @param frequency 频率(Hz)
+ * 获取锁统计
+ * @param stats 统计
  */
-void lock_buzzer_alarm(unsigned long duration, unsigned int frequency);
+void lock_get_stats(LockStats *stats);
+
+/**
+ * 获取锁状态
+ * @return 锁状态
+ */
+int lock_get_state();
 
 /**
  * 检查锁驱动状态
@@ -2,6 +2,11 @@
 #include <SPI.h>
 #include <MFRC522.h>
 
+// 头文件包含
+#include "drivers/rfid_driver.h"
+#include "modules/event_bus.h"
+#include "modules/access_trace.h"
+
 // RFID引脚定义
 #define RFID_SS_PIN    5
 #define RFID_RST_PIN   4
@@ -12,6 +17,14 @@ MFRC522 mfrc522(RFID_SS_PIN, RFID_RST_PIN);
 // RFID状态
 bool rfidInitialized = false;
 
+// MFRC522定时器重装值（PCD_Init设置为40kHz）：默认25ms，寻卡时1ms
+// 读卡区无卡时库函数忙等定时器超时才返回；REQA应答在100us内到达，寻卡不需要25ms
+#define RFID_TIMER_RELOAD_DEFAULT  1000
+#define RFID_TIMER_RELOAD_PROBE    40
+
+// 十六进制字符表
+static const char hexDigits[] = "0123456789ABCDEF";
+
 /**
  * RFID初始化
  */
@@ -51,6 +64,43 @@ bool rfid_check_card() {
   return true;
 }
 
+/**
+ * 设置MFRC522接收超时
+ */
+static void rfid_set_timer_reload(uint16_t reload) {
+  mfrc522.PCD_WriteRegister(MFRC522::TReloadRegH, reload >> 8);
+  mfrc522.PCD_WriteRegister(MFRC522::TReloadRegL, reload & 0xFF);
+}
+
+/**
+ * 探测读卡区，有卡时投递BUS_EVENT_CARD
+ * @return 是否检测到卡
+ */
+bool rfid_probe() {
+  if (!rfidInitialized) {
+    return false;
+  }
+
+  // 寻卡使用短超时，选卡恢复默认超时
+  rfid_set_timer_reload(RFID_TIMER_RELOAD_PROBE);
+  bool present = mfrc522.PICC_IsNewCardPresent();
+  rfid_set_timer_reload(RFID_TIMER_RELOAD_DEFAULT);
+  if (!present) {
+    return false;
+  }
+  uint16_t trace = ACCESS_TRACE_BEGIN();
+  if (!mfrc522.PICC_ReadCardSerial()) {
+    return false;
+  }
+  ACCESS_TRACE_POINT(trace, ACCESS_TRACE_SELECTED);
+
+  BusEvent event = {};
+  event.type = BUS_EVENT_CARD;
+  event.trace = trace;
+  event_bus_post(&event);
+  return true;
+}
+
 /**
  * 获取卡号
  * @param cardId 卡号缓冲区
@@ -75,6 +125,105 @@ int rfid_get_card_id(byte *cardId, int len) {
   return uidLen;
 }
 
+/**
+ * 获取卡号键
+ * @param uid 卡号键
+ * @return 是否成功
+ */
+bool rfid_get_card_uid(CardUid *uid) {
+  if (!rfidInitialized) {
+    return false;
+  }
+
+  return rfid_uid_from_bytes(uid, mfrc522.uid.uidByte, mfrc522.uid.size);
+}
+
+/**
+ * 由原始字节构造卡号键
+ * @param uid 卡号键
+ * @param bytes UID字节
+ * @param size UID长度（4/7/10）
+ * @return 是否成功
+ */
+bool rfid_uid_from_bytes(CardUid *uid, const byte *bytes, uint8_t size) {
+  if (size != 4 && size != 7 && size != 10) {
+    return false;
+  }
+
+  memset(uid, 0, sizeof(CardUid));
+  uid->size = size;
+  memcpy(uid->bytes, bytes, size);
+
+  return true;
+}
+
+/**
+ * 解析十六进制卡号
+ * @param uid 卡号键
+ * @param hex 十六进制字符串
+ * @return 是否成功
+ */
+bool rfid_uid_from_hex(CardUid *uid, const char *hex) {
+  byte bytes[RFID_UID_MAX_SIZE];
+  size_t length = strlen(hex);
+
+  if (length % 2 != 0 || length / 2 > RFID_UID_MAX_SIZE) {
+    return false;
+  }
+
+  for (size_t i = 0; i < length; i++) {
+    char c = hex[i];
+    int nibble;
+    if (c >= '0' && c <= '9') {
+      nibble = c - '0';
+    } else if (c >= 'A' && c <= 'F') {
+      nibble = c - 'A' + 10;
+    } else if (c >= 'a' && c <= 'f') {
+      nibble = c - 'a' + 10;
+    } else {
+      return false;
+    }
+
+    if (i % 2 == 0) {
+      bytes[i / 2] = nibble << 4;
+    } else {
+      bytes[i / 2] |= nibble;
+    }
+  }
+
+  return rfid_uid_from_bytes(uid, bytes, length / 2);
+}
+
+/**
+ * 格式化卡号为十六进制字符串（仅用于日志和显示）
+ * @param uid 卡号键
+ * @param buffer 缓冲区
+ * @param bufferSize 缓冲区大小
+ * @return 卡号字符串
+ */
+char* rfid_uid_to_hex(const CardUid *uid, char *buffer, size_t bufferSize) {
+  size_t pos = 0;
+
+  for (int i = 0; i < uid->size && pos + 2 < bufferSize; i++) {
+    buffer[pos++] = hexDigits[uid->bytes[i] >> 4];
+    buffer[pos++] = hexDigits[uid->bytes[i] & 0x0F];
+  }
+
+  buffer[pos] = '\0';
+  return buffer;
+}
+
+/**
+ * 比较卡号键
+ * @param a 卡号键
+ * @param b 卡号键
+ * @return 是否相同
+ */
+bool rfid_uid_equals(const CardUid *a, const CardUid *b) {
+  // 长度字节参与比较，未用字节已清零
+  return memcmp(a, b, sizeof(CardUid)) == 0;
+}
+
 /**
  * 获取卡号字符串
  * @param buffer 缓冲区
@@ -82,25 +231,12 @@ int rfid_get_card_id(byte *cardId, int len) {
  * @return 卡号字符串
  */
 char* rfid_get_card_id_string(char *buffer, size_t bufferSize) {
-  if (!rfidInitialized || !mfrc522.uid.uidByte) {
+  CardUid uid;
+  if (!rfid_get_card_uid(&uid)) {
     return NULL;
   }
-  
-  // 格式化卡号
-  int uidLen = mfrc522.uid.size;
-  int pos = 0;
-  
-  for (int i = 0; i < uidLen; i++) {
-    if (pos + 2 >= bufferSize) {
-      break;
-    }
-    
-    sprintf(buffer + pos, "%02X", mfrc522.uid.uidByte[i]);
-    pos += 2;
-  }
-  
-  buffer[pos] = '\0';
-  return buffer;
+
+  return rfid_uid_to_hex(&uid, buffer, bufferSize);
 }
 
 /**
@@ -180,8 +316,8 @@ void rfid_test() {
   byte version = rfid_get_version();
   Serial.printf("RFID版本: 0x%02X\n", version);
   
-  // 测试天线
-  mfrc522.PCD_Test天线(0);
+  // 天线增益
+  Serial.printf("RFID天线增益: 0x%02X\n", mfrc522.PCD_GetAntennaGain());
   
   Serial.println("RFID测试完成");
 }
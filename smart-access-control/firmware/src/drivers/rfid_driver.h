@@ -3,6 +3,23 @@
 
 #include <Arduino.h>
 
+// UID最大长度（ISO14443A单/双/三倍长UID：4/7/10字节）
+#define RFID_UID_MAX_SIZE  10
+
+// UID十六进制字符串缓冲区大小
+#define RFID_UID_HEX_SIZE  (RFID_UID_MAX_SIZE * 2 + 1)
+
+// 寻卡间隔(ms)：MFRC522的IRQ引脚未接，读卡区有无卡片只能定时发送寻卡命令探测
+#define RFID_PROBE_INTERVAL_MS  100
+
+// 卡号键：定长12字节，首字节为UID长度，未用字节清零
+// 可直接按字节比较和散列，识别路径上不做字符串格式化
+typedef struct __attribute__((packed)) {
+  uint8_t size;
+  uint8_t bytes[RFID_UID_MAX_SIZE];
+  uint8_t reserved;
+} CardUid;
+
 /**
  * RFID初始化
  */
@@ -14,6 +31,13 @@ void rfid_init();
  */
 bool rfid_check_card();
 
+/**
+ * 探测读卡区，有卡时读取卡号并投递BUS_EVENT_CARD
+ * 卡号由rfid_get_card_uid获取，处理完成后调用rfid_halt_card
+ * @return 是否检测到卡
+ */
+bool rfid_probe();
+
 /**
  * 获取卡号
  * @param cardId 卡号缓冲区
@@ -22,6 +46,47 @@ bool rfid_check_card();
  */
 int rfid_get_card_id(byte *cardId, int len);
 
+/**
+ * 获取卡号键
+ * @param uid 卡号键
+ * @return 是否成功
+ */
+bool rfid_get_card_uid(CardUid *uid);
+
+/**
+ * 由原始字节构造卡号键
+ * @param uid 卡号键
+ * @param bytes UID字节
+ * @param size UID长度（4/7/10）
+ * @return 是否成功
+ */
+bool rfid_uid_from_bytes(CardUid *uid, const byte *bytes, uint8_t size);
+
+/**
+ * 解析十六进制卡号
+ * @param uid 卡号键
+ * @param hex 十六进制字符串
+ * @return 是否成功
+ */
+bool rfid_uid_from_hex(CardUid *uid, const char *hex);
+
+/**
+ * 格式化卡号为十六进制字符串（仅用于日志和显示）
+ * @param uid 卡号键
+ * @param buffer 缓冲区
+ * @param bufferSize 缓冲区大小
+ * @return 卡号字符串
+ */
+char* rfid_uid_to_hex(const CardUid *uid, char *buffer, size_t bufferSize);
+
+/**
+ * 比较卡号键
+ * @param a 卡号键
+ * @param b 卡号键
+ * @return 是否相同
+ */
+bool rfid_uid_equals(const CardUid *a, const CardUid *b);
+
 /**
  * 获取卡号字符串
  * @param buffer 缓冲区
@@ -1,25 +1,84 @@
 #include <Arduino.h>
 
+// 头文件包含
+#include "drivers/sensor_driver.h"
+#include "drivers/sensor_input.h"
+#include "modules/event_bus.h"
+
 // 传感器引脚定义
 #define DOOR_SENSOR_PIN    34
 #define TAMPER_SENSOR_PIN  35
 
+// 门磁：前沿立即生效，50ms内的抖动忽略
+#define DOOR_SETTLE_US     50000
+
+// 防拆：静默20ms后确认；期间出现不短于500us的触发脉冲也上报
+#define TAMPER_SETTLE_US     20000
+#define TAMPER_MIN_PULSE_US  500
+
+// 边沿队列长度（门磁抖动一次约十几个边沿）
+#define SENSOR_EDGE_QUEUE_LENGTH  64
+
+// 边沿（中断服务程序写入）
+typedef struct {
+  uint8_t sensor;
+  uint8_t level;
+  uint32_t timeUs;
+} SensorEdge;
+
 // 传感器状态
 bool sensorInitialized = false;
-bool doorOpen = false;
-bool tamperDetected = false;
+volatile bool sensorDoorOpen = false;
+volatile bool sensorTamperActive = false;
+
+// 边沿消抖（只在传感器任务中访问）
+SensorInput sensorInputs[SENSOR_COUNT];
+QueueHandle_t sensorEdgeQueue = NULL;
+
+// 统计
+volatile uint32_t sensorEdgesDropped = 0;
+SensorStats sensorStats;
+
+static const char *sensor_name(SensorType sensor) {
+  return sensor == SENSOR_DOOR ? "门磁" : "防拆";
+}
 
-// 状态变化时间
-unsigned long doorChangeTime = 0;
-unsigned long tamperChangeTime = 0;
+/**
+ * 边沿入队（中断服务程序中调用）
+ */
+static void IRAM_ATTR sensor_push_edge(SensorType sensor, int pin) {
+  SensorEdge edge;
+  edge.sensor = sensor;
+  edge.level = digitalRead(pin) == LOW;
+  edge.timeUs = micros();
 
-// 消抖时间
-#define DEBOUNCE_TIME  50
+  BaseType_t woken = pdFALSE;
+  if (xQueueSendFromISR(sensorEdgeQueue, &edge, &woken) != pdTRUE) {
+    sensorEdgesDropped++;
+  }
+  if (woken) {
+    portYIELD_FROM_ISR();
+  }
+}
+
+static void IRAM_ATTR sensor_door_isr() {
+  sensor_push_edge(SENSOR_DOOR, DOOR_SENSOR_PIN);
+}
+
+static void IRAM_ATTR sensor_tamper_isr() {
+  sensor_push_edge(SENSOR_TAMPER, TAMPER_SENSOR_PIN);
+}
 
 /**
  * 传感器初始化
  */
 void sensor_init() {
+  sensorEdgeQueue = xQueueCreate(SENSOR_EDGE_QUEUE_LENGTH, sizeof(SensorEdge));
+  if (!sensorEdgeQueue) {
+    Serial.println("传感器驱动初始化失败");
+    return;
+  }
+
   // 初始化门磁传感器
   pinMode(DOOR_SENSOR_PIN, INPUT_PULLUP);
   
@@ -27,63 +86,110 @@ void sensor_init() {
   pinMode(TAMPER_SENSOR_PIN, INPUT_PULLUP);
   
   // 读取初始状态
-  doorOpen = !digitalRead(DOOR_SENSOR_PIN);
-  tamperDetected = !digitalRead(TAMPER_SENSOR_PIN);
+  sensorDoorOpen = !digitalRead(DOOR_SENSOR_PIN);
+  sensorTamperActive = !digitalRead(TAMPER_SENSOR_PIN);
+  sensor_input_init(&sensorInputs[SENSOR_DOOR], sensorDoorOpen, DOOR_SETTLE_US, 0, true);
+  sensor_input_init(&sensorInputs[SENSOR_TAMPER], sensorTamperActive, TAMPER_SETTLE_US, TAMPER_MIN_PULSE_US, false);
+  memset(&sensorStats, 0, sizeof(sensorStats));
+
+  // 两个方向的边沿都由中断记录，消抖在传感器任务中进行
+  attachInterrupt(digitalPinToInterrupt(DOOR_SENSOR_PIN), sensor_door_isr, CHANGE);
+  attachInterrupt(digitalPinToInterrupt(TAMPER_SENSOR_PIN), sensor_tamper_isr, CHANGE);
   
   sensorInitialized = true;
   Serial.println("传感器驱动初始化完成");
-  Serial.printf("门状态: %s\n", doorOpen ? "打开" : "关闭");
-  Serial.printf("防拆状态: %s\n", tamperDetected ? "触发" : "正常");
+  Serial.printf("门状态: %s\n", sensorDoorOpen ? "打开" : "关闭");
+  Serial.printf("防拆状态: %s\n", sensorTamperActive ? "触发" : "正常");
 }
 
 /**
- * 检查门状态
- * @return 是否打开
+ * 应用并发布一次状态变化
  */
-bool sensor_check_door_status() {
-  if (!sensorInitialized) {
-    return doorOpen;
+static void sensor_publish(SensorType sensor, const SensorChange *change, uint32_t nowUs) {
+  if (sensor == SENSOR_DOOR) {
+    sensorDoorOpen = change->active;
+  } else {
+    sensorTamperActive = change->active && !change->pulse;
+    if (change->active) {
+      sensorStats.tamperTriggers++;
+    }
   }
-  
-  bool currentState = !digitalRead(DOOR_SENSOR_PIN);
-  unsigned long currentTime = millis();
-  
-  // 消抖
-  if (currentState != doorOpen) {
-    if (currentTime - doorChangeTime > DEBOUNCE_TIME) {
-      doorOpen = currentState;
-      doorChangeTime = currentTime;
-      
-      Serial.printf("门状态变化: %s\n", doorOpen ? "打开" : "关闭");
+
+  uint32_t latency = nowUs - change->timestampUs;
+  sensorStats.events[sensor]++;
+  if (latency > sensorStats.maxLatencyUs[sensor]) {
+    sensorStats.maxLatencyUs[sensor] = latency;
+  }
+
+  // 事件时间按边沿时间折算到millis（micros约71分钟回绕，不能直接换算）
+  BusEvent event = {};
+  event.type = sensor == SENSOR_DOOR ? BUS_EVENT_DOOR : BUS_EVENT_TAMPER;
+  event.active = change->active;
+  event.pulse = change->pulse;
+  event.timestamp = millis() - latency / 1000;
+  event_bus_post(&event);
+
+  if (change->pulse) {
+    Serial.printf("%s脉冲（已恢复），延迟%uus\n", sensor_name(sensor), latency);
+  } else if (sensor == SENSOR_DOOR) {
+    Serial.printf("门状态变化: %s，延迟%uus\n", change->active ? "打开" : "关闭", latency);
+  } else {
+    Serial.printf("防拆状态变化: %s，延迟%uus\n", change->active ? "触发" : "正常", latency);
+  }
+}
+
+/**
+ * 传感器任务
+ * 阻塞等待中断记录的边沿，静默期结束时确认状态并投递到事件总线；无边沿时不运行
+ * @param pvParameters 未使用
+ */
+void sensor_task(void *pvParameters) {
+  while (1) {
+    uint32_t now = micros();
+    uint32_t wait = SENSOR_INPUT_IDLE;
+    for (int i = 0; i < SENSOR_COUNT; i++) {
+      uint32_t inputWait = sensor_input_wait(&sensorInputs[i], now);
+      wait = inputWait < wait ? inputWait : wait;
+    }
+
+    // 等待到最早的静默期结束（向上取整到tick）
+    TickType_t ticks = portMAX_DELAY;
+    if (wait != SENSOR_INPUT_IDLE) {
+      ticks = (wait + portTICK_PERIOD_MS * 1000 - 1) / (portTICK_PERIOD_MS * 1000);
+    }
+
+    SensorEdge edge;
+    if (xQueueReceive(sensorEdgeQueue, &edge, ticks) == pdTRUE) {
+      do {
+        sensor_input_edge(&sensorInputs[edge.sensor], edge.level, edge.timeUs);
+        sensorStats.edges++;
+      } while (xQueueReceive(sensorEdgeQueue, &edge, 0) == pdTRUE);
+    }
+
+    now = micros();
+    for (int i = 0; i < SENSOR_COUNT; i++) {
+      SensorChange change;
+      while (sensor_input_settle(&sensorInputs[i], now, &change)) {
+        sensor_publish((SensorType)i, &change, now);
+      }
     }
   }
-  
-  return doorOpen;
 }
 
 /**
- * 检查防拆状态
+ * 检查门状态（中断驱动更新，直接返回消抖后的状态）
+ * @return 是否打开
+ */
+bool sensor_check_door_status() {
+  return sensorDoorOpen;
+}
+
+/**
+ * 检查防拆状态（中断驱动更新，直接返回消抖后的状态）
  * @return 是否触发
  */
 bool sensor_check_tamper_status() {
-  if (!sensorInitialized) {
-    return tamperDetected;
-  }
-  
-  bool currentState = !digitalRead(TAMPER_SENSOR_PIN);
-  unsigned long currentTime = millis();
-  
-  // 消抖
-  if (currentState != tamperDetected) {
-    if (currentTime - tamperChangeTime > DEBOUNCE_TIME) {
-      tamperDetected = currentState;
-      tamperChangeTime = currentTime;
-      
-      Serial.printf("防拆状态变化: %s\n", tamperDetected ? "触发" : "正常");
-    }
-  }
-  
-  return tamperDetected;
+  return sensorTamperActive;
 }
 
 /**
@@ -91,7 +197,7 @@ bool sensor_check_tamper_status() {
  * @return 门状态
  */
 bool sensor_get_door_status() {
-  return doorOpen;
+  return sensorDoorOpen;
 }
 
 /**
@@ -99,7 +205,15 @@ bool sensor_get_door_status() {
  * @return 防拆状态
  */
 bool sensor_get_tamper_status() {
-  return tamperDetected;
+  return sensorTamperActive;
+}
+
+/**
+ * 获取防拆触发次数（含已恢复的脉冲）
+ * @return 次数
+ */
+uint32_t sensor_get_tamper_count() {
+  return sensorStats.tamperTriggers;
 }
 
 /**
@@ -107,18 +221,16 @@ bool sensor_get_tamper_status() {
  * @return 是否有报警
  */
 bool sensor_check_alarm_status() {
-  if (!sensorInitialized) {
-    return false;
-  }
-  
-  // 检查门状态
-  sensor_check_door_status();
-  
-  // 检查防拆状态
-  sensor_check_tamper_status();
-  
-  // 返回报警状态
-  return tamperDetected;
+  return sensorTamperActive;
+}
+
+/**
+ * 获取传感器统计
+ * @param stats 统计
+ */
+void sensor_get_stats(SensorStats *stats) {
+  *stats = sensorStats;
+  stats->edgesDropped = sensorEdgesDropped;
 }
 
 /**
@@ -156,5 +268,8 @@ void sensor_test() {
     delay(1000);
   }
   
-  Serial.println("传感器测试完成");
+  SensorStats stats;
+  sensor_get_stats(&stats);
+  Serial.printf("传感器测试完成（边沿%u个，丢弃%u个，门磁事件%u个，防拆事件%u个）\n", stats.edges,
+                stats.edgesDropped, stats.events[SENSOR_DOOR], stats.events[SENSOR_TAMPER]);
 }
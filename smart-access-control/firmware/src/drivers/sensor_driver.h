@@ -3,19 +3,42 @@
 
 #include <Arduino.h>
 
+// 传感器
+typedef enum {
+  SENSOR_DOOR,
+  SENSOR_TAMPER,
+  SENSOR_COUNT
+} SensorType;
+
+// 传感器统计
+typedef struct {
+  uint32_t edges;                        // 中断记录的边沿数
+  uint32_t edgesDropped;                 // 边沿队列满丢弃的边沿数
+  uint32_t events[SENSOR_COUNT];         // 状态变化事件数
+  uint32_t maxLatencyUs[SENSOR_COUNT];   // 边沿到发布事件的最大延迟(us)
+  uint32_t tamperTriggers;               // 防拆触发次数（含已恢复的脉冲）
+} SensorStats;
+
 /**
  * 传感器初始化
  */
 void sensor_init();
 
 /**
- * 检查门状态
+ * 传感器任务
+ * 处理中断记录的边沿，消抖后投递到事件总线（BUS_EVENT_DOOR/BUS_EVENT_TAMPER）；无边沿时阻塞
+ * @param pvParameters 未使用
+ */
+void sensor_task(void *pvParameters);
+
+/**
+ * 检查门状态（中断驱动更新，直接返回消抖后的状态）
  * @return 是否打开
  */
 bool sensor_check_door_status();
 
 /**
- * 检查防拆状态
+ * 检查防拆状态（中断驱动更新，直接返回消抖后的状态）
  * @return 是否触发
  */
 bool sensor_check_tamper_status();
@@ -32,12 +55,24 @@ bool sensor_get_door_status();
  */
 bool sensor_get_tamper_status();
 
+/**
+ * 获取防拆触发次数（含已恢复的脉冲）
+ * @return 次数
+ */
+uint32_t sensor_get_tamper_count();
+
 /**
  * 检查报警状态
  * @return 是否有报警
  */
 bool sensor_check_alarm_status();
 
+/**
+ * 获取传感器统计
+ * @param stats 统计
+ */
+void sensor_get_stats(SensorStats *stats);
+
 /**
  * 检查传感器状态
  * @return 是否初始化成功
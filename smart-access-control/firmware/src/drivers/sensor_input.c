@@ -0,0 +1,109 @@
+#include <string.h>
+
+// 头文件包含
+#include "drivers/sensor_input.h"
+
+/**
+ * 输入初始化
+ * @param input 输入状态
+ * @param level 当前电平
+ * @param settleUs 静默时间(us)
+ * @param minPulseUs 脉冲最小宽度(us)
+ * @param leading 是否前沿模式
+ */
+void sensor_input_init(SensorInput *input, bool level, uint32_t settleUs, uint32_t minPulseUs, bool leading) {
+  memset(input, 0, sizeof(*input));
+  input->settleUs = settleUs;
+  input->minPulseUs = minPulseUs;
+  input->leading = leading;
+  input->stable = level;
+  input->level = level;
+}
+
+/**
+ * 记录一个边沿
+ * @param input 输入状态
+ * @param level 边沿后的电平
+ * @param timeUs 边沿时间(us)
+ */
+void sensor_input_edge(SensorInput *input, bool level, uint32_t timeUs) {
+  input->edges++;
+
+  if (!input->pending) {
+    input->pending = true;
+    input->burstStartUs = timeUs;
+
+    // 前沿模式：第一个边沿立即生效，后续抖动在静默期内忽略
+    if (input->leading && level != input->stable) {
+      input->stable = level;
+      input->ready.active = level;
+      input->ready.pulse = false;
+      input->ready.timestampUs = timeUs;
+      input->readyCount = 1;
+    }
+  }
+
+  // 有效脉冲：稳定状态无效时，有效电平保持不少于 minPulseUs 后恢复
+  if (level && !input->level) {
+    input->activeStartUs = timeUs;
+  } else if (!level && input->level && input->minPulseUs > 0 && !input->stable &&
+             timeUs - input->activeStartUs >= input->minPulseUs) {
+    input->pulse = true;
+  }
+
+  input->level = level;
+  input->lastEdgeUs = timeUs;
+}
+
+/**
+ * 取出状态变化
+ * @param input 输入状态
+ * @param nowUs 当前时间(us)
+ * @param change 输出变化
+ * @return 是否有变化
+ */
+bool sensor_input_settle(SensorInput *input, uint32_t nowUs, SensorChange *change) {
+  if (input->readyCount > 0) {
+    input->readyCount = 0;
+    *change = input->ready;
+    return true;
+  }
+  if (!input->pending || nowUs - input->lastEdgeUs < input->settleUs) {
+    return false;
+  }
+  input->pending = false;
+
+  bool pulse = input->pulse;
+  input->pulse = false;
+  if (input->level != input->stable) {
+    input->stable = input->level;
+    change->active = input->level;
+    change->pulse = false;
+    change->timestampUs = input->burstStartUs;
+    return true;
+  }
+  if (pulse) {
+    change->active = true;
+    change->pulse = true;
+    change->timestampUs = input->burstStartUs;
+    return true;
+  }
+  return false;
+}
+
+/**
+ * 距下一次需要调用 sensor_input_settle 的时间
+ * @param input 输入状态
+ * @param nowUs 当前时间(us)
+ * @return 时间(us)，SENSOR_INPUT_IDLE表示无待处理的边沿
+ */
+uint32_t sensor_input_wait(const SensorInput *input, uint32_t nowUs) {
+  if (input->readyCount > 0) {
+    return 0;
+  }
+  if (!input->pending) {
+    return SENSOR_INPUT_IDLE;
+  }
+  uint32_t elapsed = nowUs - input->lastEdgeUs;
+  return elapsed >= input->settleUs ? 0 : input->settleUs - elapsed;
+}
@@ -0,0 +1,77 @@
+#ifndef SENSOR_INPUT_H
+#define SENSOR_INPUT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 门磁/防拆输入消抖
+// 中断记录每个边沿的电平和微秒时间戳，延后处理任务把边沿交给本模块：
+//   - 前沿模式（门磁）：一串边沿的第一个边沿立即产生状态变化，静默 settleUs 后电平与之不同再产生一次
+//   - 后沿模式（防拆）：静默 settleUs 后电平与稳定状态不同才产生状态变化；期间出现过宽度不小于 minPulseUs
+//     的有效脉冲但已恢复时产生一次脉冲事件，短暂的防拆触发不会因消抖而丢失
+// 时间戳为微秒（32位，约71分钟回绕，只比较差值）。
+// 本文件不依赖Arduino，可在主机上测试（tools/bench/sensor_bench.c）
+
+// 无待处理的边沿
+#define SENSOR_INPUT_IDLE  UINT32_MAX
+
+// 状态变化
+typedef struct {
+  bool active;            // 新状态（门打开/防拆触发）
+  bool pulse;             // 有效脉冲已恢复（active为true，稳定状态未变）
+  uint32_t timestampUs;   // 变化开始的边沿时间(us)
+} SensorChange;
+
+// 输入状态
+typedef struct {
+  uint32_t settleUs;      // 静默时间(us)
+  uint32_t minPulseUs;    // 脉冲最小宽度(us)，0表示不检测脉冲
+  bool leading;           // 前沿模式
+  bool stable;            // 稳定状态
+  bool level;             // 最近一个边沿后的电平
+  bool pending;           // 等待静默
+  bool pulse;             // 已检测到有效脉冲
+  uint32_t burstStartUs;  // 本串边沿的第一个边沿时间
+  uint32_t lastEdgeUs;    // 最近一个边沿时间
+  uint32_t activeStartUs; // 最近一次变为有效的时间
+  uint8_t readyCount;     // 前沿模式下待取出的变化
+  SensorChange ready;
+  uint32_t edges;         // 边沿数
+} SensorInput;
+
+/**
+ * 输入初始化
+ * @param input 输入状态
+ * @param level 当前电平（有效为true）
+ * @param settleUs 静默时间(us)
+ * @param minPulseUs 脉冲最小宽度(us)，0表示不检测脉冲
+ * @param leading 是否前沿模式
+ */
+void sensor_input_init(SensorInput *input, bool level, uint32_t settleUs, uint32_t minPulseUs, bool leading);
+
+/**
+ * 记录一个边沿
+ * @param input 输入状态
+ * @param level 边沿后的电平
+ * @param timeUs 边沿时间(us)
+ */
+void sensor_input_edge(SensorInput *input, bool level, uint32_t timeUs);
+
+/**
+ * 取出状态变化
+ * @param input 输入状态
+ * @param nowUs 当前时间(us)
+ * @param change 输出变化
+ * @return 是否有变化（有时应继续调用直到返回false）
+ */
+bool sensor_input_settle(SensorInput *input, uint32_t nowUs, SensorChange *change);
+
+/**
+ * 距下一次需要调用 sensor_input_settle 的时间
+ * @param input 输入状态
+ * @param nowUs 当前时间(us)
+ * @return 时间(us)，SENSOR_INPUT_IDLE表示无待处理的边沿
+ */
+uint32_t sensor_input_wait(const SensorInput *input, uint32_t nowUs);
+
+#endif
@@ -0,0 +1,170 @@
+#include <string.h>
+#include <stddef.h>
+
+// 头文件包含
+#include "drivers/tone_sequencer.h"
+
+#define TONE_STEPS(steps) (uint8_t)(sizeof(steps) / sizeof((steps)[0])), steps
+
+// 关锁：短促低音
+static const ToneStep toneLock[] = {
+  {1500, 60}
+};
+
+// 开锁：两声上扬
+static const ToneStep toneAccept[] = {
+  {2000, 80}, {0, 40}, {2600, 120}
+};
+
+// 拒绝访问：两声低音（约0.5秒）
+static const ToneStep toneDeny[] = {
+  {400, 150}, {0, 100}, {400, 250}
+};
+
+// 门长时间未关：每秒一声，直到关门
+static const ToneStep toneHeldOpen[] = {
+  {1000, 200}, {0, 800}
+};
+
+// 连续失败锁定：四声（2秒）
+static const ToneStep toneLockout[] = {
+  {1000, 250}, {0, 250}
+};
+
+// 防拆：高低交替警笛（3秒）
+static const ToneStep toneTamper[] = {
+  {800, 250}, {1200, 250}
+};
+
+static const TonePattern tonePatterns[TONE_PATTERN_COUNT] = {
+  {"lock",      0, 1, TONE_STEPS(toneLock)},
+  {"accept",    1, 1, TONE_STEPS(toneAccept)},
+  {"deny",      2, 1, TONE_STEPS(toneDeny)},
+  {"held_open", 3, TONE_REPEAT_FOREVER, TONE_STEPS(toneHeldOpen)},
+  {"lockout",   4, 4, TONE_STEPS(toneLockout)},
+  {"tamper",    5, 6, TONE_STEPS(toneTamper)},
+};
+
+/**
+ * 获取提示音定义
+ * @param id 提示音
+ * @return 定义
+ */
+const TonePattern *tone_pattern(TonePatternId id) {
+  return id < TONE_PATTERN_COUNT ? &tonePatterns[id] : NULL;
+}
+
+/**
+ * 播放状态初始化
+ * @param sequencer 播放状态
+ */
+void tone_sequencer_init(ToneSequencer *sequencer) {
+  memset(sequencer, 0, sizeof(*sequencer));
+}
+
+/**
+ * 从第一步开始播放
+ */
+static void tone_sequencer_start(ToneSequencer *sequencer, const TonePattern *pattern, uint32_t now) {
+  sequencer->pattern = pattern;
+  sequencer->step = 0;
+  sequencer->played = 0;
+  sequencer->stepStart = now;
+  sequencer->frequency = pattern->steps[0].frequency;
+}
+
+/**
+ * 当前提示音结束：继续被打断的循环提示音或进入空闲
+ */
+static void tone_sequencer_finish(ToneSequencer *sequencer, uint32_t now) {
+  const TonePattern *resume = sequencer->resume;
+  sequencer->resume = NULL;
+  if (resume) {
+    tone_sequencer_start(sequencer, resume, now);
+  } else {
+    sequencer->pattern = NULL;
+    sequencer->frequency = 0;
+  }
+}
+
+/**
+ * 播放提示音
+ * @param sequencer 播放状态
+ * @param id 提示音
+ * @param now 当前时间(ms)
+ * @return 是否开始播放
+ */
+bool tone_sequencer_play(ToneSequencer *sequencer, TonePatternId id, uint32_t now) {
+  const TonePattern *pattern = tone_pattern(id);
+  if (!pattern) {
+    return false;
+  }
+  tone_sequencer_advance(sequencer, now);
+
+  const TonePattern *current = sequencer->pattern;
+  if (current == pattern && pattern->repeat == TONE_REPEAT_FOREVER) {
+    return true;
+  }
+  if (current && current->priority > pattern->priority) {
+    // 循环提示音排在后面，当前提示音结束后播放
+    if (pattern->repeat == TONE_REPEAT_FOREVER &&
+        (!sequencer->resume || sequencer->resume->priority <= pattern->priority)) {
+      sequencer->resume = pattern;
+    }
+    return false;
+  }
+
+  // 打断当前提示音；被打断的循环提示音稍后继续
+  if (current && current->repeat == TONE_REPEAT_FOREVER && current != pattern &&
+      (!sequencer->resume || sequencer->resume->priority <= current->priority)) {
+    sequencer->resume = current;
+  }
+  tone_sequencer_start(sequencer, pattern, now);
+  return true;
+}
+
+/**
+ * 停止提示音
+ * @param sequencer 播放状态
+ * @param id 提示音
+ * @param now 当前时间(ms)
+ */
+void tone_sequencer_stop(ToneSequencer *sequencer, TonePatternId id, uint32_t now) {
+  const TonePattern *pattern = tone_pattern(id);
+  tone_sequencer_advance(sequencer, now);
+  if (sequencer->resume == pattern) {
+    sequencer->resume = NULL;
+  }
+  if (sequencer->pattern == pattern) {
+    tone_sequencer_finish(sequencer, now);
+  }
+}
+
+/**
+ * 推进到当前时间
+ * @param sequencer 播放状态
+ * @param now 当前时间(ms)
+ * @return 距下一次变化的时间(ms)，TONE_IDLE表示空闲
+ */
+int32_t tone_sequencer_advance(ToneSequencer *sequencer, uint32_t now) {
+  while (sequencer->pattern) {
+    const TonePattern *pattern = sequencer->pattern;
+    uint32_t stepEnd = sequencer->stepStart + pattern->steps[sequencer->step].duration;
+    if ((int32_t)(now - stepEnd) < 0) {
+      return (int32_t)(stepEnd - now);
+    }
+
+    // 步骤按计划时间衔接，调用晚了也不累积误差
+    sequencer->stepStart = stepEnd;
+    if (++sequencer->step >= pattern->stepCount) {
+      sequencer->step = 0;
+      sequencer->played++;
+      if (pattern->repeat != TONE_REPEAT_FOREVER && sequencer->played >= pattern->repeat) {
+        tone_sequencer_finish(sequencer, stepEnd);
+        continue;
+      }
+    }
+    sequencer->frequency = pattern->steps[sequencer->step].frequency;
+  }
+  return TONE_IDLE;
+}
@@ -0,0 +1,94 @@
+#ifndef TONE_SEQUENCER_H
+#define TONE_SEQUENCER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 蜂鸣器提示音序列
+// 每种提示音是一组（频率, 时长）步骤，可重复若干次或一直重复到停止。提示音有优先级：
+// 高优先级打断低优先级，低优先级在高优先级播放期间被拒绝；被打断的循环提示音（门长时间未关）
+// 在打断它的提示音结束后继续播放。本模块只计算时间线，驱动按返回的等待时间设置定时器和PWM频率。
+// 本文件不依赖Arduino，可在主机上测试（tools/bench/tone_bench.c）
+
+// 提示音
+typedef enum {
+  TONE_PATTERN_LOCK,        // 关锁
+  TONE_PATTERN_ACCEPT,      // 开锁
+  TONE_PATTERN_DENY,        // 拒绝访问
+  TONE_PATTERN_HELD_OPEN,   // 门长时间未关（循环，直到停止）
+  TONE_PATTERN_LOCKOUT,     // 连续失败锁定
+  TONE_PATTERN_TAMPER,      // 防拆
+  TONE_PATTERN_COUNT
+} TonePatternId;
+
+// 一直重复到停止
+#define TONE_REPEAT_FOREVER  0
+
+// 无提示音播放
+#define TONE_IDLE  -1
+
+// 步骤
+typedef struct {
+  uint16_t frequency;   // 频率(Hz)，0为静音
+  uint16_t duration;    // 时长(ms)
+} ToneStep;
+
+// 提示音定义
+typedef struct {
+  const char *name;
+  uint8_t priority;     // 数值大的优先
+  uint8_t repeat;       // 播放次数，TONE_REPEAT_FOREVER表示一直重复
+  uint8_t stepCount;
+  const ToneStep *steps;
+} TonePattern;
+
+// 播放状态
+typedef struct {
+  const TonePattern *pattern;   // 正在播放，NULL表示空闲
+  uint8_t step;
+  uint8_t played;               // 已播放完的遍数
+  uint32_t stepStart;           // 当前步骤开始时间(ms)
+  const TonePattern *resume;    // 被打断的循环提示音
+  uint16_t frequency;           // 当前输出频率(Hz)，0为静音
+} ToneSequencer;
+
+/**
+ * 获取提示音定义
+ * @param id 提示音
+ * @return 定义
+ */
+const TonePattern *tone_pattern(TonePatternId id);
+
+/**
+ * 播放状态初始化
+ * @param sequencer 播放状态
+ */
+void tone_sequencer_init(ToneSequencer *sequencer);
+
+/**
+ * 播放提示音
+ * 正在播放更高优先级的提示音时拒绝；同一循环提示音正在播放时不重新开始
+ * @param sequencer 播放状态
+ * @param id 提示音
+ * @param now 当前时间(ms)
+ * @return 是否开始播放
+ */
+bool tone_sequencer_play(ToneSequencer *sequencer, TonePatternId id, uint32_t now);
+
+/**
+ * 停止提示音（正在播放或等待继续播放的）
+ * @param sequencer 播放状态
+ * @param id 提示音
+ * @param now 当前时间(ms)
+ */
+void tone_sequencer_stop(ToneSequencer *sequencer, TonePatternId id, uint32_t now);
+
+/**
+ * 推进到当前时间
+ * @param sequencer 播放状态（frequency 为当前应输出的频率）
+ * @param now 当前时间(ms)
+ * @return 距下一次变化的时间(ms)，TONE_IDLE表示空闲
+ */
+int32_t tone_sequencer_advance(ToneSequencer *sequencer, uint32_t now);
+
+#endif
@@ -9,6 +9,7 @@
 #include "drivers/camera_driver.h"
 #include "drivers/keypad_driver.h"
 #include "drivers/lock_driver.h"
+#include "drivers/buzzer_driver.h"
 #include "drivers/sensor_driver.h"
 
 #include "modules/access_control.h"
@@ -16,6 +17,13 @@
 #include "modules/communication.h"
 #include "modules/security.h"
 #include "modules/storage.h"
+#include "modules/user_sync.h"
+#include "modules/schedule.h"
+#include "modules/enrollment.h"
+#include "modules/face_sync.h"
+#include "modules/event_capture.h"
+#include "modules/event_bus.h"
+#include "modules/access_trace.h"
 
 // 全局变量
 WiFiClient espClient;
@@ -33,6 +41,53 @@ bool isOnline = false;
 TaskHandle_t accessControlTaskHandle;
 TaskHandle_t communicationTaskHandle;
 TaskHandle_t securityTaskHandle;
+TaskHandle_t eventCaptureTaskHandle;
+TaskHandle_t sensorTaskHandle;
+
+// 状态上报周期(ms)
+#define STATUS_PUBLISH_INTERVAL  5000
+
+// 安全检查周期(ms)
+#define SECURITY_CHECK_INTERVAL  10000
+
+// MQTT连接无数据时循环任务的等待时间(ms)
+#define MQTT_WAIT_INTERVAL  1000
+
+// 初始化完成前任务等待事件的时间(ms)，避免按0超时空转占满核0
+#define SYSTEM_READY_WAIT  10
+
+// 任务函数
+void access_control_task(void *pvParameters);
+void communication_task(void *pvParameters);
+void security_task(void *pvParameters);
+
+// 串口命令缓冲区
+#define SERIAL_COMMAND_SIZE  32
+char serialCommand[SERIAL_COMMAND_SIZE];
+int serialCommandLength = 0;
+
+// 串口命令（按行读取，不等待）
+void handle_serial_command() {
+  while (Serial.available()) {
+    char c = Serial.read();
+    if (c != '\n' && c != '\r') {
+      if (serialCommandLength < SERIAL_COMMAND_SIZE - 1) {
+        serialCommand[serialCommandLength++] = c;
+      }
+      continue;
+    }
+    if (serialCommandLength == 0) {
+      continue;
+    }
+    serialCommand[serialCommandLength] = '\0';
+    serialCommandLength = 0;
+
+    // 打印访问延迟跟踪
+    if (strcmp(serialCommand, "trace") == 0) {
+      access_trace_print();
+    }
+  }
+}
 
 // 初始化函数
 void setup() {
@@ -40,6 +95,12 @@ void setup() {
   Serial.begin(115200);
   Serial.println("\n智能门禁控制器初始化...");
 
+  // 初始化事件总线（驱动中断投递事件）
+  event_bus_init();
+
+  // 初始化访问延迟跟踪（未开启时为空）
+  access_trace_init();
+
   // 初始化存储
   storage_init();
   Serial.println("✓ 存储初始化完成");
@@ -53,12 +114,18 @@ void setup() {
   fingerprint_init();
   camera_init();
   keypad_init();
+  buzzer_init();
   lock_init();
   Serial.println("✓ 驱动初始化完成");
 
   // 初始化模块
   access_control_init();
   identity_init();
+  user_sync_init();
+  schedule_init();
+  enrollment_init();
+  face_sync_init();
+  event_capture_init();
   communication_init(&mqttClient);
   security_init();
   Serial.println("✓ 模块初始化完成");
@@ -102,6 +169,28 @@ void setup() {
     1
   );
 
+  // 门磁/防拆边沿消抖（最高优先级，只在有边沿时运行）
+  xTaskCreatePinnedToCore(
+    sensor_task,
+    "SensorTask",
+    4096,
+    NULL,
+    6,
+    &sensorTaskHandle,
+    0
+  );
+
+  // 事件录像（最低优先级，不影响识别和通信）
+  xTaskCreatePinnedToCore(
+    event_capture_task,
+    "EventCaptureTask",
+    4096,
+    NULL,
+    2,
+    &eventCaptureTaskHandle,
+    1
+  );
+
   systemReady = true;
   Serial.println("\n✅ 智能门禁控制器初始化完成！");
   Serial.printf("设备ID: %s\n", deviceId);
@@ -123,101 +212,115 @@ void loop() {
       communication_publish_status(&mqttClient, deviceId, "offline");
     }
 
-    // MQTT重连
+    // MQTT重连与循环持客户端锁（回调中的同步上报、指纹进度在本任务内嵌套获取）
+    communication_lock();
     if (!mqttClient.connected()) {
       communication_connect_mqtt(&mqttClient, deviceId);
     }
 
     // MQTT循环
     mqttClient.loop();
+    communication_unlock();
+
+    // 串口命令
+    handle_serial_command();
   }
 
-  // 延迟
-  delay(1000);
+  // 等待MQTT数据到达（无数据时最多等待1秒后检查连接）
+  communication_wait_mqtt(&espClient, MQTT_WAIT_INTERVAL);
 }
 
 // 访问控制任务
+// 阻塞等待读卡、指纹触摸、按键、门磁事件；寻卡、指纹流水线、人脸检测、多因素会话超时按到时时间唤醒
 void access_control_task(void *pvParameters) {
   while (1) {
+    BusEvent event;
+    uint32_t wait = systemReady ? identity_next_wait() : SYSTEM_READY_WAIT;
+    if (event_bus_wait(BUS_QUEUE_ACCESS, &event, wait)) {
+      do {
+        if (systemReady) {
+          access_control_handle_event(&event);
+          identity_handle_event(&event);
+        }
+      } while (event_bus_wait(BUS_QUEUE_ACCESS, &event, 0));
+    }
+
     if (systemReady) {
-      // 检查识别请求
+      // 到时的识别工作
       identity_check();
 
-      // 检查门状态
-      sensor_check_door_status();
+      // 推进指纹录入和模板备份/恢复
+      enrollment_poll();
 
-      // 检查报警状态
-      sensor_check_alarm_status();
+      // 应用后台下发的人脸特征变更
+      face_sync_poll();
     }
-
-    // 任务延迟
-    vTaskDelay(pdMS_TO_TICKS(100));
   }
 }
 
 // 通信任务
+// 阻塞等待MQTT命令；状态上报和事件录像上传按周期进行
 void communication_task(void *pvParameters) {
   PubSubClient *client = (PubSubClient *)pvParameters;
+  unsigned long nextPublish = millis();
 
   while (1) {
-    if (systemReady && client->connected()) {
+    long wait = (long)(nextPublish - millis());
+    BusEvent event;
+    if (event_bus_wait(BUS_QUEUE_COMMUNICATION, &event, wait > 0 ? wait : 0)) {
+      communication_handle_command(client, &event);
+      continue;
+    }
+    nextPublish = millis() + STATUS_PUBLISH_INTERVAL;
+
+    // 读出访问延迟跟踪点（环形缓冲区满前）
+    access_trace_collect();
+
+    if (systemReady && communication_connected(client)) {
       // 发布设备状态
       communication_publish_device_status(client, deviceId);
 
       // 发布传感器数据
       communication_publish_sensor_data(client, deviceId);
-    }
 
-    // 任务延迟
-    vTaskDelay(pdMS_TO_TICKS(5000));
+      // 上传冻结完成的事件录像
+      event_capture_upload(client, deviceId);
+    }
   }
 }
 
 // 安全任务
+// 阻塞等待门磁、防拆事件；门长时间未关按到时时间唤醒，锁定到期、网络检查和数据同步按周期进行
 void security_task(void *pvParameters) {
-  while (1) {
-    if (systemReady) {
-      // 安全检查
-      security_check();
+  unsigned long nextCheck = millis();
 
-      // 数据同步
-      storage_sync();
+  while (1) {
+    long checkWait = (long)(nextCheck - millis());
+    uint32_t wait = checkWait > 0 ? checkWait : 0;
+    uint32_t doorWait = security_next_wait();
+    if (doorWait < wait) {
+      wait = doorWait;
+    }
+    BusEvent event;
+    if (event_bus_wait(BUS_QUEUE_SECURITY, &event, systemReady ? wait : SYSTEM_READY_WAIT) && systemReady) {
+      security_handle_event(&event);
     }
 
-    // 任务延迟
-    vTaskDelay(pdMS_TO_TICKS(10000));
-  }
-}
-
-// MQTT回调函数
-void mqtt_callback(char *topic, byte *payload, unsigned int length) {
-  Serial.printf("收到消息: %s\n", topic);
+    if (!systemReady) {
+      continue;
+    }
 
-  // 解析消息
-  DynamicJsonDocument doc(1024);
-  DeserializationError error = deserializeJson(doc, payload, length);
+    // 门长时间未关
+    security_poll();
 
-  if (error) {
-    Serial.printf("JSON解析错误: %s\n", error.c_str());
-    return;
-  }
+    if ((long)(millis() - nextCheck) >= 0) {
+      nextCheck = millis() + SECURITY_CHECK_INTERVAL;
 
-  // 处理远程开门命令
-  if (strcmp(topic, "access-control/commands/open") == 0) {
-    const char *targetDevice = doc["device_id"];
-    if (strcmp(targetDevice, deviceId) == 0) {
-      Serial.println("🔓 收到远程开门命令");
-      access_control_open_door();
-      communication_publish_event(&mqttClient, deviceId, "remote_open", "远程开门成功");
-    }
-  }
+      // 安全检查
+      security_check();
 
-  // 处理配置更新命令
-  if (strcmp(topic, "access-control/commands/config") == 0) {
-    const char *targetDevice = doc["device_id"];
-    if (strcmp(targetDevice, deviceId) == 0) {
-      Serial.println("⚙️ 收到配置更新命令");
-      // 处理配置更新
+      // 数据同步
+      storage_sync();
     }
   }
 }
@@ -2,9 +2,14 @@
 
 // 头文件包含
 #include "drivers/lock_driver.h"
+#include "drivers/buzzer_driver.h"
 #include "drivers/sensor_driver.h"
 #include "modules/identity.h"
 #include "modules/communication.h"
+#include "modules/schedule.h"
+#include "modules/event_capture.h"
+#include "modules/event_bus.h"
+#include "modules/access_trace.h"
 
 // 门禁控制状态
 bool accessControlInitialized = false;
@@ -20,18 +25,40 @@ void access_control_init() {
   Serial.println("门禁控制模块初始化完成");
 }
 
+/**
+ * 处理事件总线事件（访问控制任务中调用）
+ * @param event 事件
+ */
+void access_control_handle_event(const BusEvent *event) {
+  if (event->type == BUS_EVENT_DOOR) {
+    // 开锁期间门打开后又关上时提前关锁
+    lock_door_changed(event->active);
+  }
+}
+
 /**
  * 开锁
  * @param userId 用户ID
+ * @param scheduleId 用户时间表ID
  * @param method 识别方式
+ * @param card 卡号键，非刷卡方式为NULL
  * @return 是否成功
  */
-bool access_control_open_door(int userId, const char *method) {
+bool access_control_open_door(int userId, uint8_t scheduleId, const char *method, const CardUid *card) {
   if (!accessControlInitialized) {
     return false;
   }
   
-  // 开锁
+  // 时间表检查（预编译位图，一次位测试）
+  if (!schedule_is_allowed(scheduleId)) {
+    Serial.printf("用户 %d 不在允许时段（时间表 %d）\n", userId, scheduleId);
+    buzzer_play(TONE_PATTERN_DENY);
+    communication_publish_access_record(userId, method, "out_of_schedule", card);
+    ACCESS_TRACE(ACCESS_TRACE_RECORD);
+    return false;
+  }
+  
+  // 开锁（立即返回，由锁驱动定时关锁；开锁期间再次通过重新计时）
   bool success = lock_unlock(UNLOCK_DURATION);
   
   if (success) {
@@ -39,7 +66,8 @@ bool access_control_open_door(int userId, const char *method) {
     Serial.printf("用户 %d 通过 %s 方式开门\n", userId, method);
     
     // 发送门禁记录
-    communication_publish_access_record(userId, method, "success");
+    communication_publish_access_record(userId, method, "success", card);
+    ACCESS_TRACE(ACCESS_TRACE_RECORD);
   }
   
   return success;
@@ -49,8 +77,9 @@ bool access_control_open_door(int userId, const char *method) {
  * 拒绝访问
  * @param userId 用户ID
  * @param method 识别方式
+ * @param card 卡号键，非刷卡方式为NULL
  */
-void access_control_deny_access(int userId, const char *method) {
+void access_control_deny_access(int userId, const char *method, const CardUid *card) {
   if (!accessControlInitialized) {
     return;
   }
@@ -58,11 +87,15 @@ void access_control_deny_access(int userId, const char *method) {
   // 记录拒绝事件
   Serial.printf("用户 %d 通过 %s 方式访问被拒绝\n", userId, method);
   
-  // 蜂鸣器报警
-  lock_buzzer_alarm(500, 2000);
+  // 蜂鸣器提示（不等待）
+  buzzer_play(TONE_PATTERN_DENY);
+  
+  // 冻结拒绝前后的摄像头画面
+  event_capture_trigger(EVENT_CAPTURE_DENY);
   
   // 发送门禁记录
-  communication_publish_access_record(userId, method, "failed");
+  communication_publish_access_record(userId, method, "failed", card);
+  ACCESS_TRACE(ACCESS_TRACE_RECORD);
 }
 
 /**
@@ -82,7 +115,7 @@ bool access_control_remote_open() {
     Serial.println("远程开门指令执行成功");
     
     // 发送门禁记录
-    communication_publish_access_record(0, "remote", "success");
+    communication_publish_access_record(0, "remote", "success", NULL);
   }
   
   return success;
@@ -151,7 +184,7 @@ void access_control_test() {
   
   // 测试开锁
   Serial.println("测试开锁...");
-  access_control_open_door(1, "test");
+  access_control_open_door(1, SCHEDULE_ALWAYS, "test", NULL);
   
   // 测试状态检查
   Serial.println("测试状态检查...");
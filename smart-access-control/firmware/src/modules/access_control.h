@@ -2,26 +2,38 @@
 #define ACCESS_CONTROL_H
 
 #include <Arduino.h>
+#include "drivers/rfid_driver.h"
+#include "modules/event_bus.h"
 
 /**
  * 门禁控制初始化
  */
 void access_control_init();
 
+/**
+ * 处理事件总线事件（门磁）
+ * @param event 事件
+ */
+void access_control_handle_event(const BusEvent *event);
+
 /**
  * 开锁
+ * 用户时间表不允许当前时段时拒绝访问
  * @param userId 用户ID
+ * @param scheduleId 用户时间表ID
  * @param method 识别方式
+ * @param card 卡号键，非刷卡方式为NULL
  * @return 是否成功
  */
-bool access_control_open_door(int userId, const char *method);
+bool access_control_open_door(int userId, uint8_t scheduleId, const char *method, const CardUid *card);
 
 /**
  * 拒绝访问
  * @param userId 用户ID
  * @param method 识别方式
+ * @param card 卡号键，非刷卡方式为NULL
  */
-void access_control_deny_access(int userId, const char *method);
+void access_control_deny_access(int userId, const char *method, const CardUid *card);
 
 /**
  * 远程开门
@@ -0,0 +1,171 @@
+#include <Arduino.h>
+#include <PubSubClient.h>
+#include <ArduinoJson.h>
+
+// 头文件包含
+#include "modules/access_trace.h"
+#include "modules/communication.h"
+
+#if ACCESS_TRACE_ENABLED
+
+// 开销测量的跟踪点数
+#define ACCESS_TRACE_CALIBRATION_POINTS  256
+
+// 每次从环形缓冲区读出的跟踪点数
+#define ACCESS_TRACE_DRAIN_BATCH  32
+
+// 各阶段在导出中的名称（与上一阶段的间隔）
+static const char *const accessTraceStageNames[ACCESS_TRACE_STAGE_COUNT] = {
+  "present", "select", "queue", "lookup", "decision", "relay", "record"
+};
+
+// 跟踪点（跟踪点所在任务写入，通信任务读出）
+TraceRing accessTraceRings[portNUM_PROCESSORS];
+uint16_t accessTraceCurrent = 0;
+uint16_t accessTraceNext = 0;
+
+// 串联状态和直方图（读出和导出互斥访问）
+SemaphoreHandle_t accessTraceMutex = NULL;
+TraceChain accessTraceChains[portNUM_PROCESSORS];
+TraceHistogram accessTraceSegments[ACCESS_TRACE_STAGE_COUNT];
+TraceHistogram accessTraceTotal;
+
+// 每个跟踪点的开销(周期)
+uint32_t accessTracePointCycles = 0;
+
+/**
+ * 访问跟踪初始化（测量每个跟踪点的开销）
+ */
+void access_trace_init() {
+  accessTraceMutex = xSemaphoreCreateMutex();
+  for (int i = 0; i < portNUM_PROCESSORS; i++) {
+    trace_ring_init(&accessTraceRings[i]);
+    trace_chain_init(&accessTraceChains[i]);
+  }
+  memset(accessTraceSegments, 0, sizeof(accessTraceSegments));
+  memset(&accessTraceTotal, 0, sizeof(accessTraceTotal));
+
+  // 写入临时环形缓冲区测量开销，不影响统计
+  TraceRing *scratch = (TraceRing *)malloc(sizeof(TraceRing));
+  if (scratch) {
+    trace_ring_init(scratch);
+    uint32_t start = ESP.getCycleCount();
+    for (int i = 0; i < ACCESS_TRACE_CALIBRATION_POINTS; i++) {
+      trace_ring_push(scratch, ESP.getCycleCount(), 1, ACCESS_TRACE_RELAY);
+    }
+    accessTracePointCycles = (ESP.getCycleCount() - start) / ACCESS_TRACE_CALIBRATION_POINTS;
+    free(scratch);
+  }
+
+  Serial.printf("访问跟踪初始化完成（每个跟踪点%u个周期，约%uns）\n", accessTracePointCycles,
+               accessTracePointCycles * 1000 / ESP.getCpuFreqMHz());
+}
+
+/**
+ * 读出跟踪点并计入直方图（调用方持有互斥锁）
+ */
+static void access_trace_drain() {
+  uint32_t cyclesPerUs = ESP.getCpuFreqMHz();
+  TracePoint points[ACCESS_TRACE_DRAIN_BATCH];
+  for (int core = 0; core < portNUM_PROCESSORS; core++) {
+    int count;
+    do {
+      count = trace_ring_drain(&accessTraceRings[core], points, ACCESS_TRACE_DRAIN_BATCH);
+      for (int i = 0; i < count; i++) {
+        trace_chain_feed(&accessTraceChains[core], &points[i], ACCESS_TRACE_PRESENT, ACCESS_TRACE_RELAY,
+                         cyclesPerUs, accessTraceSegments, &accessTraceTotal);
+      }
+    } while (count == ACCESS_TRACE_DRAIN_BATCH);
+  }
+}
+
+/**
+ * 读出跟踪点并计入直方图（通信任务定期调用，环形缓冲区满前读出）
+ */
+void access_trace_collect() {
+  if (!accessTraceMutex) {
+    return;
+  }
+
+  xSemaphoreTake(accessTraceMutex, portMAX_DELAY);
+  access_trace_drain();
+  xSemaphoreGive(accessTraceMutex);
+}
+
+/**
+ * 被覆盖的跟踪点总数（调用方持有互斥锁）
+ */
+static uint32_t access_trace_dropped() {
+  uint32_t dropped = 0;
+  for (int core = 0; core < portNUM_PROCESSORS; core++) {
+    dropped += accessTraceRings[core].dropped;
+  }
+  return dropped;
+}
+
+static void access_trace_add_histogram(JsonObject object, const TraceHistogram *histogram) {
+  object["count"] = histogram->count;
+  object["p50_us"] = trace_histogram_percentile(histogram, 50);
+  object["p99_us"] = trace_histogram_percentile(histogram, 99);
+  object["max_us"] = histogram->maxUs;
+}
+
+/**
+ * 发布各阶段延迟
+ * @param client MQTT客户端
+ * @param deviceId 设备ID
+ */
+void access_trace_publish(PubSubClient *client, const char *deviceId) {
+  if (!accessTraceMutex || !communication_connected(client)) {
+    return;
+  }
+
+  DynamicJsonDocument doc(1536);
+  doc["device_id"] = deviceId;
+  doc["point_cycles"] = accessTracePointCycles;
+
+  xSemaphoreTake(accessTraceMutex, portMAX_DELAY);
+  access_trace_drain();
+  doc["dropped"] = access_trace_dropped();
+  JsonObject stages = doc.createNestedObject("stages");
+  for (int stage = ACCESS_TRACE_SELECTED; stage < ACCESS_TRACE_STAGE_COUNT; stage++) {
+    access_trace_add_histogram(stages.createNestedObject(accessTraceStageNames[stage]),
+                               &accessTraceSegments[stage]);
+  }
+  access_trace_add_histogram(doc.createNestedObject("card_to_relay"), &accessTraceTotal);
+  xSemaphoreGive(accessTraceMutex);
+
+  doc["timestamp"] = millis();
+
+  char payload[1024];
+  size_t length = serializeJson(doc, payload, sizeof(payload));
+  communication_lock();
+  client->publish(ACCESS_TRACE_TOPIC, (const uint8_t *)payload, length);
+  communication_unlock();
+  Serial.println("发布访问延迟跟踪");
+}
+
+/**
+ * 串口打印各阶段延迟
+ */
+void access_trace_print() {
+  if (!accessTraceMutex) {
+    return;
+  }
+
+  xSemaphoreTake(accessTraceMutex, portMAX_DELAY);
+  access_trace_drain();
+  Serial.printf("访问延迟跟踪（us，每个跟踪点%u个周期，丢弃%u个跟踪点）\n", accessTracePointCycles,
+               access_trace_dropped());
+  for (int stage = ACCESS_TRACE_SELECTED; stage <= ACCESS_TRACE_STAGE_COUNT; stage++) {
+    const TraceHistogram *histogram = stage < ACCESS_TRACE_STAGE_COUNT ? &accessTraceSegments[stage]
+                                                                       : &accessTraceTotal;
+    Serial.printf("  %-14s n=%-6u p50=%-8u p99=%-8u max=%u\n",
+                 stage < ACCESS_TRACE_STAGE_COUNT ? accessTraceStageNames[stage] : "card_to_relay",
+                 histogram->count, trace_histogram_percentile(histogram, 50),
+                 trace_histogram_percentile(histogram, 99), histogram->maxUs);
+  }
+  xSemaphoreGive(accessTraceMutex);
+}
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef ACCESS_TRACE_H
+#define ACCESS_TRACE_H
+
+#include <Arduino.h>
+#include <PubSubClient.h>
+#include "modules/trace_ring.h"
+
+// 刷卡到继电器动作的延迟跟踪
+// 刷卡路径上各阶段打跟踪点（CPU周期计数），写入当前核的无锁环形缓冲区；
+// 通信任务定期读出并按跟踪编号串联，统计各阶段与上一阶段的间隔（p50/p99/最大值）。
+// 读卡事件带跟踪编号，访问控制任务取出事件后恢复为当前跟踪，处理完该卡即结束；
+// 其他识别方式、远程开门（在其他核上）不属于任何跟踪，跟踪点不计入。
+// 按需导出：MQTT命令 {"command": "get_trace"} 发布到 access-control/trace，串口输入 trace 打印。
+// 编译选项 ACCESS_TRACE_ENABLED 为0（默认）时跟踪点和导出全部编译为空（platformio.ini 构建选项中开启）。
+#define ACCESS_TRACE_TOPIC  "access-control/trace"
+
+#ifndef ACCESS_TRACE_ENABLED
+#define ACCESS_TRACE_ENABLED  0
+#endif
+
+// 跟踪阶段（按刷卡路径顺序）
+typedef enum {
+  ACCESS_TRACE_PRESENT,    // 寻卡发现卡片
+  ACCESS_TRACE_SELECTED,   // 防冲突、选卡完成，读卡事件投递
+  ACCESS_TRACE_DEQUEUED,   // 访问控制任务取出读卡事件
+  ACCESS_TRACE_LOOKUP,     // 卡号过滤、用户查找完成
+  ACCESS_TRACE_DECISION,   // 多因素认证判定完成
+  ACCESS_TRACE_RELAY,      // 时间表检查通过，继电器动作
+  ACCESS_TRACE_RECORD,     // 门禁记录发布完成
+  ACCESS_TRACE_STAGE_COUNT
+} AccessTraceStage;
+
+#if ACCESS_TRACE_ENABLED
+
+// 每个核的跟踪点环形缓冲区
+extern TraceRing accessTraceRings[portNUM_PROCESSORS];
+
+// 当前跟踪编号（访问控制任务写入，0表示不跟踪）
+extern uint16_t accessTraceCurrent;
+extern uint16_t accessTraceNext;
+
+/**
+ * 写入跟踪点
+ * @param trace 跟踪编号，0时不写入
+ * @param stage 阶段
+ */
+static inline void access_trace_point(uint16_t trace, uint8_t stage) {
+  if (trace) {
+    trace_ring_push(&accessTraceRings[xPortGetCoreID()], ESP.getCycleCount(), trace, stage);
+  }
+}
+
+/**
+ * 开始新的跟踪（寻卡发现卡片时调用）
+ * @return 跟踪编号
+ */
+static inline uint16_t access_trace_begin() {
+  if (++accessTraceNext == 0) {
+    accessTraceNext = 1;
+  }
+  access_trace_point(accessTraceNext, ACCESS_TRACE_PRESENT);
+  return accessTraceNext;
+}
+
+#define ACCESS_TRACE_BEGIN()               access_trace_begin()
+#define ACCESS_TRACE_POINT(trace, stage)   access_trace_point((trace), (stage))
+#define ACCESS_TRACE_RESUME(trace)         (accessTraceCurrent = (trace))
+#define ACCESS_TRACE(stage)                access_trace_point(accessTraceCurrent, (stage))
+#define ACCESS_TRACE_END()                 (accessTraceCurrent = 0)
+
+/**
+ * 访问跟踪初始化（测量每个跟踪点的开销）
+ */
+void access_trace_init();
+
+/**
+ * 读出跟踪点并计入直方图（通信任务定期调用，环形缓冲区满前读出）
+ */
+void access_trace_collect();
+
+/**
+ * 发布各阶段延迟
+ * @param client MQTT客户端
+ * @param deviceId 设备ID
+ */
+void access_trace_publish(PubSubClient *client, const char *deviceId);
+
+/**
+ * 串口打印各阶段延迟
+ */
+void access_trace_print();
+
+#else
+
+#define ACCESS_TRACE_BEGIN()               ((uint16_t)0)
+#define ACCESS_TRACE_POINT(trace, stage)   ((void)(trace))
+#define ACCESS_TRACE_RESUME(trace)         ((void)(trace))
+#define ACCESS_TRACE(stage)                ((void)0)
+#define ACCESS_TRACE_END()                 ((void)0)
+
+static inline void access_trace_init() {}
+static inline void access_trace_collect() {}
+static inline void access_trace_publish(PubSubClient *client, const char *deviceId) {}
+static inline void access_trace_print() {}
+
+#endif
+
+#endif
@@ -0,0 +1,191 @@
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <math.h>
+
+// 头文件包含
+#include "modules/bloom_filter.h"
+#include "modules/credential_index.h"
+
+// 最小计数器数量
+#define BLOOM_FILTER_MIN_SIZE  64
+
+/**
+ * 读取计数器
+ * 发布后的过滤器由写者原地增减、读者不加锁查询，计数器字节按原子方式访问
+ */
+static uint8_t bloom_filter_get(const BloomFilter *filter, uint32_t i) {
+  return (__atomic_load_n(&filter->counters[i >> 1], __ATOMIC_RELAXED) >> ((i & 1) * 4)) & 0x0F;
+}
+
+/**
+ * 写入计数器（写者之间由调用方互斥）
+ */
+static void bloom_filter_set(BloomFilter *filter, uint32_t i, uint8_t value) {
+  uint8_t shift = (i & 1) * 4;
+  uint8_t byte = __atomic_load_n(&filter->counters[i >> 1], __ATOMIC_RELAXED);
+  __atomic_store_n(&filter->counters[i >> 1], (uint8_t)((byte & ~(0x0F << shift)) | (value << shift)), __ATOMIC_RELAXED);
+}
+
+/**
+ * 将32位哈希映射到[0, size)（乘法取高位，避免取模）
+ */
+static uint32_t bloom_filter_reduce(uint32_t hash, uint32_t size) {
+  return (uint32_t)(((uint64_t)hash * size) >> 32);
+}
+
+/**
+ * 计算两个基础哈希，第i个哈希为 h1 + i * h2（双重散列）
+ */
+static void bloom_filter_hash(const void *key, size_t length, uint32_t *h1, uint32_t *h2) {
+  *h1 = credential_hash_bytes(key, length);
+  *h2 = credential_hash_int(*h1 ^ 0x9E3779B9) | 1;
+}
+
+/**
+ * 初始化过滤器
+ * @param filter 过滤器
+ * @param expectedCount 预计键数量
+ * @param falsePositiveRate 目标误判率（0~1）
+ * @return 是否成功
+ */
+bool bloom_filter_init(BloomFilter *filter, uint32_t expectedCount, float falsePositiveRate) {
+  memset(filter, 0, sizeof(BloomFilter));
+
+  if (expectedCount == 0) {
+    expectedCount = 1;
+  }
+  if (falsePositiveRate <= 0.0f || falsePositiveRate >= 1.0f) {
+    return false;
+  }
+
+  // m = -n·ln(p) / ln(2)^2，向上取偶数
+  float bits = -(float)expectedCount * logf(falsePositiveRate) / (M_LN2 * M_LN2);
+  uint32_t size = (uint32_t)ceilf(bits);
+  if (size < BLOOM_FILTER_MIN_SIZE) {
+    size = BLOOM_FILTER_MIN_SIZE;
+  }
+  size = (size + 1) & ~1u;
+
+  // k = m/n·ln(2)
+  int hashCount = (int)lroundf((float)size / expectedCount * M_LN2);
+  if (hashCount < 1) {
+    hashCount = 1;
+  }
+  if (hashCount > BLOOM_FILTER_MAX_HASHES) {
+    hashCount = BLOOM_FILTER_MAX_HASHES;
+  }
+
+  size_t bytes = size / 2;
+  if (psramFound()) {
+    filter->counters = (uint8_t *)heap_caps_calloc(bytes, 1, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    filter->inPsram = (filter->counters != NULL);
+  }
+  if (!filter->counters) {
+    filter->counters = (uint8_t *)calloc(bytes, 1);
+  }
+  if (!filter->counters) {
+    return false;
+  }
+
+  filter->size = size;
+  filter->hashCount = hashCount;
+  filter->capacity = expectedCount;
+  return true;
+}
+
+/**
+ * 释放过滤器
+ * @param filter 过滤器
+ */
+void bloom_filter_free(BloomFilter *filter) {
+  free(filter->counters);
+  memset(filter, 0, sizeof(BloomFilter));
+}
+
+/**
+ * 加入键
+ * @param filter 过滤器
+ * @param key 键
+ * @param length 键长度
+ */
+void bloom_filter_add(BloomFilter *filter, const void *key, size_t length) {
+  if (!filter->counters) {
+    return;
+  }
+
+  uint32_t h1, h2;
+  bloom_filter_hash(key, length, &h1, &h2);
+
+  for (uint8_t i = 0; i < filter->hashCount; i++) {
+    uint32_t pos = bloom_filter_reduce(h1 + i * h2, filter->size);
+    uint8_t value = bloom_filter_get(filter, pos);
+    if (value < BLOOM_FILTER_COUNTER_MAX) {
+      bloom_filter_set(filter, pos, value + 1);
+      if (value + 1 == BLOOM_FILTER_COUNTER_MAX) {
+        filter->saturated++;
+      }
+    }
+  }
+
+  filter->count++;
+}
+
+/**
+ * 删除键
+ * @param filter 过滤器
+ * @param key 键
+ * @param length 键长度
+ */
+void bloom_filter_remove(BloomFilter *filter, const void *key, size_t length) {
+  if (!filter->counters || filter->count == 0) {
+    return;
+  }
+
+  uint32_t h1, h2;
+  bloom_filter_hash(key, length, &h1, &h2);
+
+  for (uint8_t i = 0; i < filter->hashCount; i++) {
+    uint32_t pos = bloom_filter_reduce(h1 + i * h2, filter->size);
+    uint8_t value = bloom_filter_get(filter, pos);
+    // 饱和计数器无法确定真实值，保持不变（只会增加误判，不会漏判）
+    if (value > 0 && value < BLOOM_FILTER_COUNTER_MAX) {
+      bloom_filter_set(filter, pos, value - 1);
+    }
+  }
+
+  filter->count--;
+}
+
+/**
+ * 查询键是否可能存在
+ * @param filter 过滤器
+ * @param key 键
+ * @param length 键长度
+ * @return false表示一定不存在，true表示可能存在
+ */
+bool bloom_filter_may_contain(const BloomFilter *filter, const void *key, size_t length) {
+  if (!filter->counters) {
+    return true;
+  }
+
+  uint32_t h1, h2;
+  bloom_filter_hash(key, length, &h1, &h2);
+
+  for (uint8_t i = 0; i < filter->hashCount; i++) {
+    if (bloom_filter_get(filter, bloom_filter_reduce(h1 + i * h2, filter->size)) == 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * 是否需要重建
+ * @param filter 过滤器
+ * @param extra 即将加入的键数量
+ * @return 是否需要按当前键集合重建
+ */
+bool bloom_filter_needs_rebuild(const BloomFilter *filter, uint32_t extra) {
+  return !filter->counters || filter->count + extra > filter->capacity || filter->saturated > 0;
+}
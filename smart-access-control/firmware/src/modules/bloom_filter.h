@@ -0,0 +1,74 @@
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+
+#include <Arduino.h>
+
+// 哈希函数数量上限
+#define BLOOM_FILTER_MAX_HASHES  16
+
+// 计数器饱和值（4位计数器，饱和后不再增减）
+#define BLOOM_FILTER_COUNTER_MAX  15
+
+// 计数型布隆过滤器（4位计数器，支持增量删除）
+typedef struct {
+  uint8_t *counters;      // 每字节两个4位计数器
+  uint32_t size;          // 计数器数量（偶数）
+  uint8_t hashCount;      // 哈希函数数量
+  uint32_t count;         // 已加入的键数量
+  uint32_t capacity;      // 设计键数量（超过后误判率高于目标）
+  uint32_t saturated;     // 已饱和的计数器数量（饱和后删除不再生效）
+  bool inPsram;           // 是否分配在PSRAM中
+} BloomFilter;
+
+/**
+ * 初始化过滤器
+ * 按预计键数量和目标误判率计算计数器数量和哈希函数数量
+ * @param filter 过滤器
+ * @param expectedCount 预计键数量
+ * @param falsePositiveRate 目标误判率（0~1）
+ * @return 是否成功
+ */
+bool bloom_filter_init(BloomFilter *filter, uint32_t expectedCount, float falsePositiveRate);
+
+/**
+ * 释放过滤器
+ * @param filter 过滤器
+ */
+void bloom_filter_free(BloomFilter *filter);
+
+/**
+ * 加入键
+ * @param filter 过滤器
+ * @param key 键
+ * @param length 键长度
+ */
+void bloom_filter_add(BloomFilter *filter, const void *key, size_t length);
+
+/**
+ * 删除键
+ * 只能删除此前加入过的键
+ * @param filter 过滤器
+ * @param key 键
+ * @param length 键长度
+ */
+void bloom_filter_remove(BloomFilter *filter, const void *key, size_t length);
+
+/**
+ * 查询键是否可能存在
+ * @param filter 过滤器
+ * @param key 键
+ * @param length 键长度
+ * @return false表示一定不存在，true表示可能存在
+ */
+bool bloom_filter_may_contain(const BloomFilter *filter, const void *key, size_t length);
+
+/**
+ * 是否需要重建
+ * 再加入extra个键后超过设计键数量，或有计数器饱和（其上的键删除后误判无法消除）
+ * @param filter 过滤器
+ * @param extra 即将加入的键数量
+ * @return 是否需要按当前键集合重建
+ */
+bool bloom_filter_needs_rebuild(const BloomFilter *filter, uint32_t extra);
+
+#endif
@@ -2,10 +2,28 @@
 #include <WiFi.h>
 #include <PubSubClient.h>
 #include <ArduinoJson.h>
+#include <esp_heap_caps.h>
+#include <lwip/sockets.h>
+
+// 头文件包含
+#include "drivers/rfid_driver.h"
+#include "drivers/fingerprint_driver.h"
+#include "modules/communication.h"
+#include "modules/user_db.h"
+#include "modules/user_sync.h"
+#include "modules/schedule.h"
+#include "modules/enrollment.h"
+#include "modules/face_sync.h"
+#include "modules/event_capture.h"
+#include "modules/event_bus.h"
+#include "modules/access_trace.h"
 
 // 通信模块状态
 bool communicationInitialized = false;
 
+// MQTT客户端锁（递归互斥锁，各任务创建前初始化）
+SemaphoreHandle_t mqttMutex = NULL;
+
 // WiFi配置
 const char* ssid = "your-ssid";
 const char* password = "your-password";
@@ -23,11 +41,26 @@ const char* mqttPassword = "password";
 #define MQTT_TOPIC_COMMAND        "access-control/command"
 #define MQTT_TOPIC_SENSOR_DATA    "access-control/sensor"
 
+// 二进制帧每次写入连接的字节数（约一个TCP报文段）
+#define COMMUNICATION_STREAM_WRITE_SIZE  1436
+
+// 代理单条消息上限的最小值（主题不超过128字节时每个分片仍有负载）
+#define COMMUNICATION_MIN_PACKET  512
+
+// 代理单条消息上限（0为不限，二进制帧整条发布）
+size_t communicationMaxPacket = 0;
+
+// 二进制帧上传
+uint32_t communicationTransferId = 0;
+CommunicationUploadStats uploadStats;
+
 /**
  * 通信模块初始化
  * @param client MQTT客户端
  */
 void communication_init(PubSubClient *client) {
+  mqttMutex = xSemaphoreCreateRecursiveMutex();
+
   // 设置回调函数
   client->setCallback(mqtt_callback);
   
@@ -35,6 +68,36 @@ void communication_init(PubSubClient *client) {
   Serial.println("通信模块初始化完成");
 }
 
+/**
+ * 获取MQTT客户端锁
+ */
+void communication_lock() {
+  if (mqttMutex) {
+    xSemaphoreTakeRecursive(mqttMutex, portMAX_DELAY);
+  }
+}
+
+/**
+ * 释放MQTT客户端锁
+ */
+void communication_unlock() {
+  if (mqttMutex) {
+    xSemaphoreGiveRecursive(mqttMutex);
+  }
+}
+
+/**
+ * 检查MQTT是否已连接（持锁查询）
+ * @param client MQTT客户端
+ * @return 是否已连接
+ */
+bool communication_connected(PubSubClient *client) {
+  communication_lock();
+  bool connected = client->connected();
+  communication_unlock();
+  return connected;
+}
+
 /**
  * 连接WiFi
  * @return 是否成功
@@ -52,13 +115,14 @@ bool communication_connect_wifi() {
   }
   
   if (WiFi.status() == WL_CONNECTED) {
-    Serial.println("
-WiFi连接成功");
+    Serial.println("\nWiFi连接成功");
     Serial.printf("IP地址: %s\n", WiFi.localIP().toString().c_str());
+    
+    // NTP校时（时间表判定依赖本地时间）
+    configTzTime(SCHEDULE_TIMEZONE, SCHEDULE_NTP_SERVER);
     return true;
   } else {
-    Serial.println("
-WiFi连接失败");
+    Serial.println("\nWiFi连接失败");
     return false;
   }
 }
@@ -72,24 +136,61 @@ WiFi连接失败");
 bool communication_connect_mqtt(PubSubClient *client, const char *deviceId) {
   Serial.printf("正在连接MQTT服务器: %s\n", mqttServer);
   
+  // 连接、订阅和上线状态一起持锁，其他任务不会在连接建立期间发布
+  communication_lock();
   client->setServer(mqttServer, mqttPort);
+  client->setBufferSize(USER_SYNC_MQTT_BUFFER_SIZE);
   
   // 连接MQTT
-  if (client->connect(deviceId, mqttUser, mqttPassword)) {
+  bool connected = client->connect(deviceId, mqttUser, mqttPassword);
+  if (connected) {
     Serial.println("MQTT连接成功");
     
     // 订阅命令主题
     client->subscribe(MQTT_TOPIC_COMMAND);
     Serial.printf("已订阅主题: %s\n", MQTT_TOPIC_COMMAND);
     
+    // 订阅用户库同步主题并上报版本
+    user_sync_subscribe(client, deviceId);
+    
+    // 订阅指纹管理主题
+    enrollment_subscribe(client, deviceId);
+    
+    // 订阅人脸特征同步主题
+    face_sync_subscribe(client, deviceId);
+    
     // 发布上线状态
     communication_publish_status(client, deviceId, "online");
-    
-    return true;
   } else {
     Serial.println("MQTT连接失败");
-    return false;
   }
+  communication_unlock();
+  return connected;
+}
+
+/**
+ * 等待MQTT连接有数据可读
+ * 循环任务在此阻塞，数据到达时立即返回交给 PubSubClient::loop 处理；未连接时等待超时
+ * @param client 网络连接
+ * @param timeoutMs 超时(ms)
+ */
+void communication_wait_mqtt(WiFiClient *client, uint32_t timeoutMs) {
+  int fd = client->connected() ? client->fd() : -1;
+  if (fd < 0) {
+    delay(timeoutMs);
+    return;
+  }
+  if (client->available() > 0) {
+    return;
+  }
+
+  fd_set readable;
+  FD_ZERO(&readable);
+  FD_SET(fd, &readable);
+  struct timeval timeout;
+  timeout.tv_sec = timeoutMs / 1000;
+  timeout.tv_usec = (timeoutMs % 1000) * 1000;
+  select(fd + 1, &readable, NULL, NULL, &timeout);
 }
 
 /**
@@ -101,9 +202,73 @@ bool communication_connect_mqtt(PubSubClient *client, const char *deviceId) {
 void mqtt_callback(char* topic, byte* payload, unsigned int length) {
   Serial.printf("收到MQTT消息: %s\n", topic);
   
-  // 解析消息
+  // 用户库同步消息
+  if (user_sync_handle_message(topic, payload, length)) {
+    return;
+  }
+  
+  // 指纹录入及模板备份/恢复命令
+  if (enrollment_handle_message(topic, payload, length)) {
+    return;
+  }
+  
+  // 人脸特征增量同步
+  if (face_sync_handle_message(topic, payload, length)) {
+    return;
+  }
+  
+  // 命令交给通信任务处理（回调在循环任务中执行，处理命令期间不再读取连接）
+  if (strcmp(topic, MQTT_TOPIC_COMMAND) == 0) {
+    communication_post_command(payload, length);
+  }
+}
+
+/**
+ * MQTT命令投递到事件总线
+ * 负载复制到堆上，由通信任务处理后释放
+ * @param payload 负载
+ * @param length 长度
+ * @return 是否成功
+ */
+bool communication_post_command(const byte *payload, unsigned int length) {
+  if (length == 0 || length > COMMUNICATION_COMMAND_MAX_SIZE) {
+    Serial.printf("命令长度无效: %u\n", length);
+    return false;
+  }
+
+  BusEvent event = {};
+  event.type = BUS_EVENT_MQTT_COMMAND;
+  event.payload = (char *)malloc(length + 1);
+  if (!event.payload) {
+    return false;
+  }
+  memcpy(event.payload, payload, length);
+  event.payload[length] = '\0';
+  event.length = length;
+
+  if (!event_bus_post(&event)) {
+    Serial.println("命令队列已满，丢弃命令");
+    free(event.payload);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * 处理MQTT命令（通信任务中调用）
+ * @param client MQTT客户端
+ * @param event 命令事件，处理后释放负载
+ */
+void communication_handle_command(PubSubClient *client, BusEvent *event) {
+  if (event->type != BUS_EVENT_MQTT_COMMAND || !event->payload) {
+    return;
+  }
+
+  // 解析消息（按只读输入解析，字符串复制到文档中，负载随即释放）
   DynamicJsonDocument doc(1024);
-  DeserializationError error = deserializeJson(doc, payload, length);
+  DeserializationError error = deserializeJson(doc, (const char *)event->payload, event->length);
+  free(event->payload);
+  event->payload = NULL;
   
   if (error) {
     Serial.printf("JSON解析错误: %s\n", error.c_str());
@@ -111,24 +276,59 @@ void mqtt_callback(char* topic, byte* payload, unsigned int length) {
   }
   
   // 处理命令
-  if (strcmp(topic, MQTT_TOPIC_COMMAND) == 0) {
-    const char* command = doc["command"];
-    const char* deviceId = doc["device_id"];
-    
-    Serial.printf("收到命令: %s, 设备ID: %s\n", command, deviceId);
-    
-    // 处理远程开门命令
-    if (strcmp(command, "open_door") == 0) {
-      // 调用远程开门函数
-      extern bool access_control_remote_open();
-      access_control_remote_open();
+  const char* command = doc["command"];
+  const char* deviceId = doc["device_id"];
+  
+  Serial.printf("收到命令: %s, 设备ID: %s\n", command, deviceId);
+  
+  // 处理远程开门命令
+  if (strcmp(command, "open_door") == 0) {
+    // 调用远程开门函数
+    extern bool access_control_remote_open();
+    access_control_remote_open();
+  }
+  
+  // 处理状态查询命令
+  if (strcmp(command, "get_status") == 0) {
+    // 发布设备状态
+    communication_publish_device_status(client, deviceId);
+  }
+
+  // 处理访问延迟跟踪查询命令 {"command": "get_trace"}
+  if (strcmp(command, "get_trace") == 0) {
+    access_trace_publish(client, deviceId);
+  }
+
+  // 处理认证策略命令 {"command": "set_mfa_policy", "door": 0, "policy": "card+pin", "window_ms": 15000}
+  if (strcmp(command, "set_mfa_policy") == 0) {
+    extern bool identity_set_mfa_policy(int door, const char *policy, uint32_t windowMs);
+    if (!identity_set_mfa_policy(doc["door"] | 0, doc["policy"], doc["window_ms"] | 0)) {
+      Serial.println("认证策略无效");
     }
-    
-    // 处理状态查询命令
-    if (strcmp(command, "get_status") == 0) {
-      // 发布设备状态
-      PubSubClient client(WiFiClient());
-      communication_publish_device_status(&client, deviceId);
+  }
+
+  // 处理门长时间未关阈值命令 {"command": "set_door_held_open", "door": 0, "seconds": 60}
+  if (strcmp(command, "set_door_held_open") == 0) {
+    extern bool security_set_door_held_open(int door, uint32_t heldOpenMs);
+    if (!security_set_door_held_open(doc["door"] | 0, (uint32_t)(doc["seconds"] | 0) * 1000)) {
+      Serial.println("门长时间未关阈值无效");
+    }
+  }
+
+  // 处理代理消息上限命令 {"command": "set_max_packet", "bytes": 8192}，0表示不限
+  if (strcmp(command, "set_max_packet") == 0) {
+    if (!communication_set_max_packet(doc["bytes"] | 0)) {
+      Serial.println("代理消息上限无效");
+    }
+  }
+
+  // 处理指纹识别模式命令 {"command": "set_fingerprint_mode", "mode": "irq" | "poll"}
+  if (strcmp(command, "set_fingerprint_mode") == 0) {
+    const char *mode = doc["mode"] | "";
+    if (strcmp(mode, "irq") == 0) {
+      fingerprint_set_mode(FINGERPRINT_MODE_IRQ);
+    } else if (strcmp(mode, "poll") == 0) {
+      fingerprint_set_mode(FINGERPRINT_MODE_POLL);
     }
   }
 }
@@ -140,10 +340,6 @@ void mqtt_callback(char* topic, byte* payload, unsigned int length) {
  * @param status 状态
  */
 void communication_publish_status(PubSubClient *client, const char *deviceId, const char *status) {
-  if (!client->connected()) {
-    return;
-  }
-  
   DynamicJsonDocument doc(256);
   doc["device_id"] = deviceId;
   doc["status"] = status;
@@ -152,8 +348,12 @@ void communication_publish_status(PubSubClient *client, const char *deviceId, co
   char payload[256];
   serializeJson(doc, payload);
   
-  client->publish(MQTT_TOPIC_STATUS, payload);
-  Serial.printf("发布状态: %s\n", status);
+  communication_lock();
+  if (client->connected()) {
+    client->publish(MQTT_TOPIC_STATUS, payload);
+    Serial.printf("发布状态: %s\n", status);
+  }
+  communication_unlock();
 }
 
 /**
@@ -162,26 +362,90 @@ void communication_publish_status(PubSubClient *client, const char *deviceId, co
  * @param deviceId 设备ID
  */
 void communication_publish_device_status(PubSubClient *client, const char *deviceId) {
-  if (!client->connected()) {
+  if (!communication_connected(client)) {
     return;
   }
   
   extern int lock_get_state();
   extern bool sensor_get_door_status();
   extern bool sensor_get_tamper_status();
+  extern void identity_get_card_filter_stats(uint32_t *, uint32_t *, uint32_t *);
+  extern uint32_t identity_get_db_version();
+  extern void identity_get_face_stats(uint32_t *, uint32_t *, uint32_t *, uint32_t *);
+  extern void identity_get_motion_stats(uint32_t *, uint32_t *, uint32_t *);
+  extern void security_get_door_stats(int, uint32_t *, uint32_t *);
   
-  DynamicJsonDocument doc(256);
+  uint32_t filterQueries, filterSaved, filterFalsePositives;
+  identity_get_card_filter_stats(&filterQueries, &filterSaved, &filterFalsePositives);
+  
+  uint32_t faceCount, faceQueries, faceRecallSamples, faceRecallHits;
+  identity_get_face_stats(&faceCount, &faceQueries, &faceRecallSamples, &faceRecallHits);
+  
+  uint32_t motionIdleFrames, motionActiveFrames, motionActivations;
+  identity_get_motion_stats(&motionIdleFrames, &motionActiveFrames, &motionActivations);
+  
+  uint32_t doorForced, doorHeldOpen;
+  security_get_door_stats(0, &doorForced, &doorHeldOpen);
+  
+  FingerprintStats fingerprintStats;
+  fingerprint_get_stats(&fingerprintStats);
+  
+  EventCaptureStats captureStats;
+  event_capture_get_stats(&captureStats);
+  
+  CommunicationUploadStats upload;
+  communication_get_upload_stats(&upload);
+  
+  DynamicJsonDocument doc(1024);
   doc["device_id"] = deviceId;
   doc["lock_state"] = lock_get_state() == 1 ? "unlocked" : "locked";
   doc["door_state"] = sensor_get_door_status() ? "open" : "closed";
   doc["tamper_state"] = sensor_get_tamper_status() ? "triggered" : "normal";
+  doc["door_forced"] = doorForced;
+  doc["door_held_open"] = doorHeldOpen;
   doc["wifi_rssi"] = WiFi.RSSI();
+  doc["card_filter_queries"] = filterQueries;
+  doc["card_filter_saved"] = filterSaved;
+  doc["card_filter_false_positives"] = filterFalsePositives;
+  doc["db_version"] = identity_get_db_version();
+  doc["fp_mode"] = fingerprintStats.mode == FINGERPRINT_MODE_IRQ ? "irq" : "poll";
+  doc["fp_captures_per_hour"] = fingerprint_captures_per_hour(&fingerprintStats);
+  doc["fp_latency_p50"] = fingerprint_latency_percentile(&fingerprintStats, 50);
+  doc["fp_latency_p99"] = fingerprint_latency_percentile(&fingerprintStats, 99);
+  doc["fp_latency_max"] = fingerprintStats.latencyMaxMs;
+  doc["face_count"] = faceCount;
+  doc["face_queries"] = faceQueries;
+  if (faceRecallSamples > 0) {
+    doc["face_recall"] = (float)faceRecallHits / faceRecallSamples;
+  }
+  if (motionIdleFrames + motionActiveFrames > 0) {
+    doc["motion_idle_frames"] = motionIdleFrames;
+    doc["motion_active_frames"] = motionActiveFrames;
+    doc["motion_active_ratio"] = (float)motionActiveFrames / (motionIdleFrames + motionActiveFrames);
+    doc["motion_activations"] = motionActivations;
+  }
+  if (captureStats.slots > 0) {
+    doc["cam_frames"] = captureStats.captured;
+    doc["cam_frames_dropped"] = captureStats.dropped + captureStats.missed;
+    doc["cam_events"] = captureStats.events;
+    doc["cam_events_dropped"] = captureStats.eventsDropped;
+    doc["cam_uploads_failed"] = captureStats.uploadFailed;
+    doc["cam_slots_peak"] = captureStats.slotsPeak;
+  }
+  if (upload.frames > 0) {
+    doc["upload_frames"] = upload.frames;
+    doc["upload_failures"] = upload.failures;
+    doc["upload_kbps"] = upload.lastMs > 0 ? upload.lastBytes * 8 / upload.lastMs : 0;
+    doc["upload_heap_peak"] = upload.maxHeapPeak;
+  }
   doc["timestamp"] = millis();
   
-  char payload[256];
+  char payload[1024];
   serializeJson(doc, payload);
   
+  communication_lock();
   client->publish(MQTT_TOPIC_STATUS, payload);
+  communication_unlock();
   Serial.println("发布设备状态");
 }
 
@@ -190,25 +454,32 @@ void communication_publish_device_status(PubSubClient *client, const char *devic
  * @param userId 用户ID
  * @param method 识别方式
  * @param result 结果
+ * @param card 卡号键，非刷卡方式为NULL
  */
-void communication_publish_access_record(int userId, const char *method, const char *result) {
-  // 获取MQTT客户端
-  extern PubSubClient mqttClient;
-  if (!mqttClient.connected()) {
-    return;
-  }
-  
+void communication_publish_access_record(int userId, const char *method, const char *result, const CardUid *card) {
   DynamicJsonDocument doc(256);
   doc["user_id"] = userId;
   doc["method"] = method;
   doc["result"] = result;
   doc["timestamp"] = millis();
   
+  // 卡号在发布边界才格式化为十六进制
+  char cardHex[RFID_UID_HEX_SIZE];
+  if (card) {
+    doc["card_uid"] = rfid_uid_to_hex(card, cardHex, sizeof(cardHex));
+  }
+  
   char payload[256];
   serializeJson(doc, payload);
   
-  mqttClient.publish(MQTT_TOPIC_ACCESS_RECORD, payload);
-  Serial.printf("发布门禁记录: 用户=%d, 方式=%s, 结果=%s\n", userId, method, result);
+  // 获取MQTT客户端
+  extern PubSubClient mqttClient;
+  communication_lock();
+  if (mqttClient.connected()) {
+    mqttClient.publish(MQTT_TOPIC_ACCESS_RECORD, payload);
+    Serial.printf("发布门禁记录: 用户=%d, 方式=%s, 结果=%s\n", userId, method, result);
+  }
+  communication_unlock();
 }
 
 /**
@@ -217,12 +488,6 @@ void communication_publish_access_record(int userId, const char *method, const c
  * @param message 报警信息
  */
 void communication_publish_alarm(const char *type, const char *message) {
-  // 获取MQTT客户端
-  extern PubSubClient mqttClient;
-  if (!mqttClient.connected()) {
-    return;
-  }
-  
   DynamicJsonDocument doc(256);
   doc["type"] = type;
   doc["message"] = message;
@@ -231,8 +496,146 @@ void communication_publish_alarm(const char *type, const char *message) {
   char payload[256];
   serializeJson(doc, payload);
   
-  mqttClient.publish(MQTT_TOPIC_ALARM, payload);
-  Serial.printf("发布报警信息: 类型=%s, 信息=%s\n", type, message);
+  // 获取MQTT客户端
+  extern PubSubClient mqttClient;
+  communication_lock();
+  if (mqttClient.connected()) {
+    mqttClient.publish(MQTT_TOPIC_ALARM, payload);
+    Serial.printf("发布报警信息: 类型=%s, 信息=%s\n", type, message);
+  }
+  communication_unlock();
+}
+
+/**
+ * 分段写入负载，每段之后采样内部堆余量
+ */
+static bool communication_stream(PubSubClient *client, const uint8_t *data, size_t length, size_t *heapMin) {
+  for (size_t offset = 0; offset < length; offset += COMMUNICATION_STREAM_WRITE_SIZE) {
+    size_t size = length - offset < COMMUNICATION_STREAM_WRITE_SIZE ? length - offset : COMMUNICATION_STREAM_WRITE_SIZE;
+    if (client->write(data + offset, size) != size) {
+      return false;
+    }
+    size_t freeHeap = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    if (freeHeap < *heapMin) {
+      *heapMin = freeHeap;
+    }
+  }
+  return true;
+}
+
+/**
+ * MQTT PUBLISH报文总长度（固定头 + 主题 + 负载，QoS 0）
+ */
+static size_t communication_packet_size(size_t topicLength, size_t payloadLength) {
+  size_t remaining = 2 + topicLength + payloadLength;
+  size_t lengthBytes = remaining < 128 ? 1 : remaining < 16384 ? 2 : remaining < 2097152 ? 3 : 4;
+  return 1 + lengthBytes + remaining;
+}
+
+/**
+ * 发布二进制帧（调用方持有MQTT客户端锁）
+ * @param client MQTT客户端
+ * @param topic 主题
+ * @param data 数据
+ * @param length 长度
+ * @return 是否成功
+ */
+static bool communication_publish_frame_locked(PubSubClient *client, const char *topic, const uint8_t *data,
+                                               size_t length) {
+  if (!client->connected()) {
+    return false;
+  }
+
+  size_t heapBefore = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+  size_t heapMin = heapBefore;
+  unsigned long start = millis();
+  size_t topicLength = strlen(topic);
+
+  // 分片负载上限（报文上限减去报文头、主题和分片头，剩余长度字段按最长4字节预留）
+  size_t chunkSize = length;
+  if (communicationMaxPacket > 0 && communication_packet_size(topicLength, length) > communicationMaxPacket) {
+    size_t overhead = 1 + 4 + 2 + topicLength + sizeof(FrameChunkHeader);
+    if (overhead >= communicationMaxPacket) {
+      uploadStats.failures++;
+      return false;
+    }
+    chunkSize = communicationMaxPacket - overhead;
+  }
+  uint16_t count = chunkSize >= length ? 1 : (length + chunkSize - 1) / chunkSize;
+
+  bool ok = true;
+  if (count == 1) {
+    ok = client->beginPublish(topic, length, false) && communication_stream(client, data, length, &heapMin) &&
+         client->endPublish();
+  } else {
+    FrameChunkHeader header;
+    header.magic = COMMUNICATION_CHUNK_MAGIC;
+    header.transferId = ++communicationTransferId;
+    header.totalLength = length;
+    header.count = count;
+    header.crc32 = user_db_crc32(0, data, length);
+    for (uint16_t i = 0; ok && i < count; i++) {
+      header.index = i;
+      header.offset = (uint32_t)i * chunkSize;
+      size_t size = length - header.offset < chunkSize ? length - header.offset : chunkSize;
+      ok = client->beginPublish(topic, sizeof(header) + size, false) &&
+           client->write((const uint8_t *)&header, sizeof(header)) == sizeof(header) &&
+           communication_stream(client, data + header.offset, size, &heapMin) && client->endPublish();
+    }
+  }
+
+  uint32_t heapPeak = heapBefore - heapMin;
+  if (ok) {
+    uploadStats.frames++;
+    uploadStats.lastBytes = length;
+    uploadStats.lastMs = millis() - start;
+    uploadStats.lastMessages = count;
+    uploadStats.lastHeapPeak = heapPeak;
+  } else {
+    uploadStats.failures++;
+  }
+  if (heapPeak > uploadStats.maxHeapPeak) {
+    uploadStats.maxHeapPeak = heapPeak;
+  }
+  return ok;
+}
+
+/**
+ * 发布二进制帧
+ * beginPublish到endPublish之间其他任务的报文会插入未写完的PUBLISH中，整帧（全部分片）持锁
+ * @param client MQTT客户端
+ * @param topic 主题
+ * @param data 数据
+ * @param length 长度
+ * @return 是否成功
+ */
+bool communication_publish_frame(PubSubClient *client, const char *topic, const uint8_t *data, size_t length) {
+  communication_lock();
+  bool ok = communication_publish_frame_locked(client, topic, data, length);
+  communication_unlock();
+  return ok;
+}
+
+/**
+ * 设置代理单条消息上限
+ * @param maxPacket 上限，0表示不限
+ * @return 是否有效
+ */
+bool communication_set_max_packet(size_t maxPacket) {
+  if (maxPacket > 0 && maxPacket < COMMUNICATION_MIN_PACKET) {
+    return false;
+  }
+  communicationMaxPacket = maxPacket;
+  Serial.printf("代理单条消息上限: %u\n", (unsigned)maxPacket);
+  return true;
+}
+
+/**
+ * 获取二进制帧上传统计
+ * @param stats 统计
+ */
+void communication_get_upload_stats(CommunicationUploadStats *stats) {
+  *stats = uploadStats;
 }
 
 /**
@@ -241,10 +644,6 @@ void communication_publish_alarm(const char *type, const char *message) {
  * @param deviceId 设备ID
  */
 void communication_publish_sensor_data(PubSubClient *client, const char *deviceId) {
-  if (!client->connected()) {
-    return;
-  }
-  
   extern bool sensor_get_door_status();
   extern bool sensor_get_tamper_status();
   
@@ -258,7 +657,11 @@ void communication_publish_sensor_data(PubSubClient *client, const char *deviceI
   char payload[256];
   serializeJson(doc, payload);
   
-  client->publish(MQTT_TOPIC_SENSOR_DATA, payload);
+  communication_lock();
+  if (client->connected()) {
+    client->publish(MQTT_TOPIC_SENSOR_DATA, payload);
+  }
+  communication_unlock();
 }
 
 /**
@@ -269,10 +672,6 @@ void communication_publish_sensor_data(PubSubClient *client, const char *deviceI
  * @param message 事件消息
  */
 void communication_publish_event(PubSubClient *client, const char *deviceId, const char *eventType, const char *message) {
-  if (!client->connected()) {
-    return;
-  }
-  
   DynamicJsonDocument doc(256);
   doc["device_id"] = deviceId;
   doc["event_type"] = eventType;
@@ -282,8 +681,12 @@ void communication_publish_event(PubSubClient *client, const char *deviceId, con
   char payload[256];
   serializeJson(doc, payload);
   
-  client->publish("access-control/event", payload);
-  Serial.printf("发布事件: 类型=%s, 消息=%s\n", eventType, message);
+  communication_lock();
+  if (client->connected()) {
+    client->publish("access-control/event", payload);
+    Serial.printf("发布事件: 类型=%s, 消息=%s\n", eventType, message);
+  }
+  communication_unlock();
 }
 
 /**
@@ -316,12 +719,35 @@ void communication_test(PubSubClient *client) {
   
   // 测试MQTT连接
   Serial.println("测试MQTT连接...");
-  Serial.printf("MQTT状态: %s\n", client->connected() ? "已连接" : "未连接");
+  bool connected = communication_connected(client);
+  Serial.printf("MQTT状态: %s\n", connected ? "已连接" : "未连接");
   
   // 测试发布消息
-  if (client->connected()) {
+  if (connected) {
     Serial.println("测试发布消息...");
     communication_publish_event(client, "test-device", "test", "通信模块测试消息");
+    
+    // 测试二进制帧流式发布（30KB，整条及按4KB代理上限分片），统计吞吐量和堆占用
+    Serial.println("测试二进制帧发布...");
+    const size_t imageSize = 30 * 1024;
+    uint8_t *image = (uint8_t *)heap_caps_malloc(imageSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (image) {
+      for (size_t i = 0; i < imageSize; i++) {
+        image[i] = i * 31 + (i >> 8);
+      }
+      size_t savedMaxPacket = communicationMaxPacket;
+      const size_t maxPackets[] = {0, 4096};
+      for (int i = 0; i < 2; i++) {
+        communicationMaxPacket = maxPackets[i];
+        bool ok = communication_publish_frame(client, "access-control/test/frame", image, imageSize);
+        Serial.printf("  上限%u: %s, %u条消息, %ums, %ukbps, 堆占用峰值%u字节\n", (unsigned)maxPackets[i],
+                      ok ? "成功" : "失败", uploadStats.lastMessages, uploadStats.lastMs,
+                      uploadStats.lastMs > 0 ? uploadStats.lastBytes * 8 / uploadStats.lastMs : 0,
+                      uploadStats.lastHeapPeak);
+      }
+      communicationMaxPacket = savedMaxPacket;
+      free(image);
+    }
   }
   
   Serial.println("通信模块测试完成");
@@ -3,6 +3,37 @@
 
 #include <Arduino.h>
 #include <PubSubClient.h>
+#include <WiFiClient.h>
+#include "drivers/rfid_driver.h"
+#include "modules/event_bus.h"
+
+// MQTT命令负载上限(字节)
+#define COMMUNICATION_COMMAND_MAX_SIZE  1024
+
+// 二进制帧分片头（小端，代理限制单条消息大小时每条分片负载以此开头）
+// 接收方按transferId收齐count个分片，按offset拼接后校验crc32；整条发布的帧没有分片头
+#define COMMUNICATION_CHUNK_MAGIC  0x4B4E4843  // "CHNK"
+
+typedef struct __attribute__((packed)) {
+  uint32_t magic;
+  uint32_t transferId;    // 传输编号（设备内递增）
+  uint32_t totalLength;   // 帧总长度
+  uint32_t offset;        // 本分片在帧中的偏移
+  uint16_t index;         // 分片序号
+  uint16_t count;         // 分片总数
+  uint32_t crc32;         // 整帧CRC32
+} FrameChunkHeader;
+
+// 二进制帧上传统计
+typedef struct {
+  uint32_t frames;         // 上传成功的帧数
+  uint32_t failures;       // 上传失败的帧数
+  uint32_t lastBytes;      // 最近一帧的字节数
+  uint32_t lastMs;         // 最近一帧的耗时(ms)
+  uint16_t lastMessages;   // 最近一帧的消息数（未分片为1）
+  uint32_t lastHeapPeak;   // 最近一帧发送期间内部堆的最大占用(字节)
+  uint32_t maxHeapPeak;    // 历次发送的最大堆占用(字节)
+} CommunicationUploadStats;
 
 /**
  * 通信模块初始化
@@ -10,6 +41,25 @@
  */
 void communication_init(PubSubClient *client);
 
+/**
+ * 获取MQTT客户端锁
+ * PubSubClient不可重入：循环任务、访问控制任务、通信任务、安全任务调用客户端（connected、publish、loop等）前都须持有，
+ * beginPublish到endPublish之间不释放；同一任务可嵌套获取（loop回调中的发布）
+ */
+void communication_lock();
+
+/**
+ * 释放MQTT客户端锁
+ */
+void communication_unlock();
+
+/**
+ * 检查MQTT是否已连接（持锁查询）
+ * @param client MQTT客户端
+ * @return 是否已连接
+ */
+bool communication_connected(PubSubClient *client);
+
 /**
  * 连接WiFi
  * @return 是否成功
@@ -24,6 +74,36 @@ bool communication_connect_wifi();
  */
 bool communication_connect_mqtt(PubSubClient *client, const char *deviceId);
 
+/**
+ * 等待MQTT连接有数据可读（循环任务中调用）
+ * @param client 网络连接
+ * @param timeoutMs 超时(ms)
+ */
+void communication_wait_mqtt(WiFiClient *client, uint32_t timeoutMs);
+
+/**
+ * MQTT回调函数
+ * @param topic 主题
+ * @param payload 负载
+ * @param length 长度
+ */
+void mqtt_callback(char* topic, byte* payload, unsigned int length);
+
+/**
+ * MQTT命令投递到事件总线（MQTT回调中调用）
+ * @param payload 负载
+ * @param length 长度
+ * @return 是否成功
+ */
+bool communication_post_command(const byte *payload, unsigned int length);
+
+/**
+ * 处理MQTT命令（通信任务中调用）
+ * @param client MQTT客户端
+ * @param event 命令事件，处理后释放负载
+ */
+void communication_handle_command(PubSubClient *client, BusEvent *event);
+
 /**
  * 发布状态
  * @param client MQTT客户端
@@ -44,8 +124,9 @@ void communication_publish_device_status(PubSubClient *client, const char *devic
  * @param userId 用户ID
  * @param method 识别方式
  * @param result 结果
+ * @param card 卡号键，非刷卡方式为NULL
  */
-void communication_publish_access_record(int userId, const char *method, const char *result);
+void communication_publish_access_record(int userId, const char *method, const char *result, const CardUid *card);
 
 /**
  * 发布报警信息
@@ -54,6 +135,31 @@ void communication_publish_access_record(int userId, const char *method, const c
  */
 void communication_publish_alarm(const char *type, const char *message);
 
+/**
+ * 发布二进制帧（如JPEG）
+ * 负载直接从调用方缓冲区分段写入连接，不经过MQTT客户端缓冲区；
+ * 设置了代理单条消息上限且帧超出时分成多条消息，每条负载前加FrameChunkHeader
+ * @param client MQTT客户端
+ * @param topic 主题
+ * @param data 数据
+ * @param length 长度
+ * @return 是否成功
+ */
+bool communication_publish_frame(PubSubClient *client, const char *topic, const uint8_t *data, size_t length);
+
+/**
+ * 设置代理单条消息上限（MQTT报文总字节数）
+ * @param maxPacket 上限，0表示不限（帧整条发布）
+ * @return 是否有效（过小无法容纳分片头时无效）
+ */
+bool communication_set_max_packet(size_t maxPacket);
+
+/**
+ * 获取二进制帧上传统计
+ * @param stats 统计
+ */
+void communication_get_upload_stats(CommunicationUploadStats *stats);
+
 /**
  * 发布传感器数据
  * @param client MQTT客户端
@@ -0,0 +1,346 @@
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+
+// 头文件包含
+#include "modules/credential_index.h"
+
+// FNV-1a参数
+#define FNV_OFFSET_BASIS  2166136261u
+#define FNV_PRIME         16777619u
+
+/**
+ * 分配槽位数组
+ * PSRAM可用时优先分配在PSRAM中，失败再回退到内部RAM
+ * @param capacity 槽位数量
+ * @param inPsram 是否分配在PSRAM中
+ * @return 槽位数组，NULL表示失败
+ */
+static CredentialSlot *credential_index_alloc(uint32_t capacity, bool *inPsram) {
+  size_t size = capacity * sizeof(CredentialSlot);
+  CredentialSlot *slots = NULL;
+
+  *inPsram = false;
+  if (psramFound()) {
+    slots = (CredentialSlot *)heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    *inPsram = (slots != NULL);
+  }
+
+  if (!slots) {
+    slots = (CredentialSlot *)malloc(size);
+  }
+
+  if (slots) {
+    // 全部置为空槽（value = -1）
+    memset(slots, 0xFF, size);
+  }
+
+  return slots;
+}
+
+/**
+ * 在槽位数组中放置条目
+ * @param slots 槽位数组
+ * @param capacity 槽位数量
+ * @param hash 哈希值
+ * @param value 用户表下标
+ * @param limit 探测长度上限
+ * @param probe 实际探测长度
+ * @return 是否在探测长度上限内放置成功
+ */
+static bool credential_index_place(CredentialSlot *slots, uint32_t capacity,
+                                   uint32_t hash, int32_t value, uint32_t limit, uint32_t *probe) {
+  uint32_t mask = capacity - 1;
+  uint32_t pos = hash & mask;
+
+  for (uint32_t d = 0; d < limit && d < capacity; d++) {
+    CredentialSlot *slot = &slots[(pos + d) & mask];
+    if (slot->value == CREDENTIAL_INDEX_EMPTY) {
+      slot->hash = hash;
+      slot->value = value;
+      *probe = d + 1;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * 探测长度上限
+ * 容量已足够稀疏时不再限制：剩余的长探测链来自相同哈希，扩容无法缩短
+ * @param capacity 槽位数量
+ * @param count 条目数量（含待插入条目）
+ * @return 探测长度上限
+ */
+static uint32_t credential_index_probe_limit(uint32_t capacity, uint32_t count) {
+  return capacity < count * CREDENTIAL_INDEX_MAX_SPARSITY ? CREDENTIAL_INDEX_MAX_PROBE : capacity;
+}
+
+/**
+ * 扩容并重新散列
+ * 若新容量下仍有条目超过探测长度上限，则继续加倍，直到容量足够稀疏
+ * @param index 索引
+ * @param newCapacity 新容量
+ * @return 是否成功
+ */
+static bool credential_index_rehash(CredentialIndex *index, uint32_t newCapacity) {
+  while (true) {
+    uint32_t limit = credential_index_probe_limit(newCapacity, index->count + 1);
+    bool inPsram;
+    CredentialSlot *slots = credential_index_alloc(newCapacity, &inPsram);
+    if (!slots) {
+      return false;
+    }
+
+    uint32_t maxProbe = 0;
+    bool placed = true;
+    for (uint32_t i = 0; i < index->capacity && placed; i++) {
+      CredentialSlot *old = &index->slots[i];
+      if (old->value == CREDENTIAL_INDEX_EMPTY) {
+        continue;
+      }
+
+      uint32_t probe;
+      placed = credential_index_place(slots, newCapacity, old->hash, old->value, limit, &probe);
+      if (placed && probe > maxProbe) {
+        maxProbe = probe;
+      }
+    }
+
+    if (placed) {
+      free(index->slots);
+      index->slots = slots;
+      index->capacity = newCapacity;
+      index->maxProbe = maxProbe;
+      index->inPsram = inPsram;
+      return true;
+    }
+
+    free(slots);
+    newCapacity <<= 1;
+  }
+}
+
+/**
+ * 初始化索引
+ * @param index 索引
+ * @param expectedCount 预计条目数量
+ * @return 是否成功
+ */
+bool credential_index_init(CredentialIndex *index, uint32_t expectedCount) {
+  // 装载因子不超过1/2
+  uint32_t capacity = CREDENTIAL_INDEX_MIN_CAPACITY;
+  while (capacity < expectedCount * 2) {
+    capacity <<= 1;
+  }
+
+  index->slots = credential_index_alloc(capacity, &index->inPsram);
+  if (!index->slots) {
+    index->capacity = 0;
+    return false;
+  }
+
+  index->capacity = capacity;
+  index->count = 0;
+  index->maxProbe = 0;
+  return true;
+}
+
+/**
+ * 释放索引
+ * @param index 索引
+ */
+void credential_index_free(CredentialIndex *index) {
+  free(index->slots);
+  index->slots = NULL;
+  index->capacity = 0;
+  index->count = 0;
+  index->maxProbe = 0;
+}
+
+/**
+ * 复制索引
+ * @param dest 目标索引（未初始化）
+ * @param source 源索引
+ * @return 是否成功
+ */
+bool credential_index_clone(CredentialIndex *dest, const CredentialIndex *source) {
+  dest->slots = credential_index_alloc(source->capacity, &dest->inPsram);
+  if (!dest->slots) {
+    dest->capacity = 0;
+    return false;
+  }
+
+  memcpy(dest->slots, source->slots, source->capacity * sizeof(CredentialSlot));
+  dest->capacity = source->capacity;
+  dest->count = source->count;
+  dest->maxProbe = source->maxProbe;
+  return true;
+}
+
+/**
+ * 插入条目
+ * @param index 索引
+ * @param hash 凭证哈希值
+ * @param value 用户表下标
+ * @return 是否成功
+ */
+bool credential_index_insert(CredentialIndex *index, uint32_t hash, int32_t value) {
+  if (!index->slots || value == CREDENTIAL_INDEX_EMPTY) {
+    return false;
+  }
+
+  // 保持装载因子不超过1/2
+  if ((index->count + 1) * 2 > index->capacity) {
+    if (!credential_index_rehash(index, index->capacity << 1)) {
+      return false;
+    }
+  }
+
+  uint32_t probe;
+  while (!credential_index_place(index->slots, index->capacity, hash, value,
+                                 credential_index_probe_limit(index->capacity, index->count + 1), &probe)) {
+    // 探测链过长，扩容后重试
+    if (!credential_index_rehash(index, index->capacity << 1)) {
+      return false;
+    }
+  }
+
+  if (probe > index->maxProbe) {
+    index->maxProbe = probe;
+  }
+  index->count++;
+
+  return true;
+}
+
+/**
+ * 删除条目
+ * @param index 索引
+ * @param hash 凭证哈希值
+ * @param value 用户表下标
+ * @return 是否找到并删除
+ */
+bool credential_index_remove(CredentialIndex *index, uint32_t hash, int32_t value) {
+  if (!index->slots) {
+    return false;
+  }
+
+  uint32_t mask = index->capacity - 1;
+  uint32_t pos = hash & mask;
+  uint32_t hole = 0;
+  bool found = false;
+
+  for (uint32_t d = 0; d < index->maxProbe; d++) {
+    CredentialSlot *slot = &index->slots[(pos + d) & mask];
+    if (slot->value == CREDENTIAL_INDEX_EMPTY) {
+      break;
+    }
+    if (slot->hash == hash && slot->value == value) {
+      hole = (pos + d) & mask;
+      found = true;
+      break;
+    }
+  }
+
+  if (!found) {
+    return false;
+  }
+
+  // 向后移位：把后续仍可前移的条目填入空洞，保证探测链不断开
+  uint32_t next = hole;
+  while (true) {
+    next = (next + 1) & mask;
+    CredentialSlot *slot = &index->slots[next];
+    if (slot->value == CREDENTIAL_INDEX_EMPTY) {
+      break;
+    }
+
+    uint32_t home = slot->hash & mask;
+    bool movable = (next > hole) ? (home <= hole || home > next)
+                                 : (home <= hole && home > next);
+    if (movable) {
+      index->slots[hole] = *slot;
+      hole = next;
+    }
+  }
+
+  index->slots[hole].value = CREDENTIAL_INDEX_EMPTY;
+  index->count--;
+
+  return true;
+}
+
+/**
+ * 查找条目
+ * @param index 索引
+ * @param hash 凭证哈希值
+ * @param match 匹配回调
+ * @param key 查找键
+ * @param context 回调上下文
+ * @return 用户表下标，CREDENTIAL_INDEX_EMPTY表示未找到
+ */
+int32_t credential_index_find(const CredentialIndex *index, uint32_t hash,
+                              CredentialMatchFn match, const void *key, void *context) {
+  if (!index->slots) {
+    return CREDENTIAL_INDEX_EMPTY;
+  }
+
+  uint32_t mask = index->capacity - 1;
+  uint32_t pos = hash & mask;
+
+  // 探测次数不超过maxProbe（哈希各不相同时 <= CREDENTIAL_INDEX_MAX_PROBE）
+  for (uint32_t d = 0; d < index->maxProbe; d++) {
+    const CredentialSlot *slot = &index->slots[(pos + d) & mask];
+    if (slot->value == CREDENTIAL_INDEX_EMPTY) {
+      break;
+    }
+    if (slot->hash == hash && match(slot->value, key, context)) {
+      return slot->value;
+    }
+  }
+
+  return CREDENTIAL_INDEX_EMPTY;
+}
+
+/**
+ * 计算字节串哈希（FNV-1a）
+ * @param data 数据
+ * @param length 长度
+ * @return 哈希值
+ */
+uint32_t credential_hash_bytes(const void *data, size_t length) {
+  const uint8_t *bytes = (const uint8_t *)data;
+  uint32_t hash = FNV_OFFSET_BASIS;
+
+  for (size_t i = 0; i < length; i++) {
+    hash ^= bytes[i];
+    hash *= FNV_PRIME;
+  }
+
+  // 末尾混合，改善低位分布（槽位取低位）
+  return credential_hash_int(hash);
+}
+
+/**
+ * 计算字符串哈希
+ * @param str 字符串
+ * @return 哈希值
+ */
+uint32_t credential_hash_string(const char *str) {
+  return credential_hash_bytes(str, strlen(str));
+}
+
+/**
+ * 计算整数哈希（murmur3 finalizer）
+ * @param value 整数
+ * @return 哈希值
+ */
+uint32_t credential_hash_int(uint32_t value) {
+  value ^= value >> 16;
+  value *= 0x85ebca6bu;
+  value ^= value >> 13;
+  value *= 0xc2b2ae35u;
+  value ^= value >> 16;
+  return value;
+}
@@ -0,0 +1,122 @@
+#ifndef CREDENTIAL_INDEX_H
+#define CREDENTIAL_INDEX_H
+
+#include <Arduino.h>
+
+// 最大探测长度（哈希各不相同时查找的比较次数上界），超过时扩容
+#define CREDENTIAL_INDEX_MAX_PROBE  16
+
+// 容量达到条目数的此倍数后不再因探测过长而扩容，条目共用一条更长的探测链
+// （多个条目哈希相同时扩容无济于事，例如多个用户使用同一密码）
+#define CREDENTIAL_INDEX_MAX_SPARSITY  8
+
+// 初始最小容量
+#define CREDENTIAL_INDEX_MIN_CAPACITY  16
+
+// 空槽位标记
+#define CREDENTIAL_INDEX_EMPTY  (-1)
+
+// 索引槽位
+typedef struct {
+  uint32_t hash;    // 凭证哈希值
+  int32_t value;    // 用户表下标，CREDENTIAL_INDEX_EMPTY表示空槽
+} CredentialSlot;
+
+// 开放寻址哈希索引（线性探测）
+typedef struct {
+  CredentialSlot *slots;
+  uint32_t capacity;    // 槽位数量，2的幂
+  uint32_t count;       // 已用槽位数量
+  uint32_t maxProbe;    // 当前最长探测距离
+  bool inPsram;         // 槽位是否分配在PSRAM中
+} CredentialIndex;
+
+/**
+ * 凭证匹配回调
+ * 哈希命中后由调用方确认真实凭证是否一致
+ * @param value 槽位中保存的用户表下标
+ * @param key 查找键
+ * @param context 调用方上下文
+ * @return 是否匹配
+ */
+typedef bool (*CredentialMatchFn)(int32_t value, const void *key, void *context);
+
+/**
+ * 初始化索引
+ * 装载因子不超过1/2，PSRAM可用时槽位分配在PSRAM中
+ * @param index 索引
+ * @param expectedCount 预计条目数量
+ * @return 是否成功
+ */
+bool credential_index_init(CredentialIndex *index, uint32_t expectedCount);
+
+/**
+ * 释放索引
+ * @param index 索引
+ */
+void credential_index_free(CredentialIndex *index);
+
+/**
+ * 复制索引
+ * 用于写时复制：在副本上修改，不影响正在读取源索引的任务
+ * @param dest 目标索引（未初始化）
+ * @param source 源索引
+ * @return 是否成功
+ */
+bool credential_index_clone(CredentialIndex *dest, const CredentialIndex *source);
+
+/**
+ * 插入条目
+ * 探测距离超过CREDENTIAL_INDEX_MAX_PROBE时自动扩容并重新散列，
+ * 容量达到条目数的CREDENTIAL_INDEX_MAX_SPARSITY倍后改为沿探测链放到下一个空槽
+ * @param index 索引
+ * @param hash 凭证哈希值
+ * @param value 用户表下标
+ * @return 是否成功
+ */
+bool credential_index_insert(CredentialIndex *index, uint32_t hash, int32_t value);
+
+/**
+ * 删除条目（向后移位删除，不留墓碑）
+ * @param index 索引
+ * @param hash 凭证哈希值
+ * @param value 用户表下标
+ * @return 是否找到并删除
+ */
+bool credential_index_remove(CredentialIndex *index, uint32_t hash, int32_t value);
+
+/**
+ * 查找条目
+ * @param index 索引
+ * @param hash 凭证哈希值
+ * @param match 匹配回调
+ * @param key 查找键
+ * @param context 回调上下文
+ * @return 用户表下标，CREDENTIAL_INDEX_EMPTY表示未找到
+ */
+int32_t credential_index_find(const CredentialIndex *index, uint32_t hash,
+                              CredentialMatchFn match, const void *key, void *context);
+
+/**
+ * 计算字节串哈希（FNV-1a）
+ * @param data 数据
+ * @param length 长度
+ * @return 哈希值
+ */
+uint32_t credential_hash_bytes(const void *data, size_t length);
+
+/**
+ * 计算字符串哈希
+ * @param str 字符串
+ * @return 哈希值
+ */
+uint32_t credential_hash_string(const char *str);
+
+/**
+ * 计算整数哈希
+ * @param value 整数
+ * @return 哈希值
+ */
+uint32_t credential_hash_int(uint32_t value);
+
+#endif
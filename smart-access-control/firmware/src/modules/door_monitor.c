@@ -0,0 +1,105 @@
+#include <string.h>
+
+// 头文件包含
+#include "modules/door_monitor.h"
+
+/**
+ * 单门初始化
+ * @param door 单门状态
+ * @param heldOpenMs 门长时间未关阈值(ms)
+ * @param locked 当前锁状态
+ * @param open 当前门状态
+ * @param now 当前时间(ms)
+ */
+void door_monitor_init(DoorMonitor *door, uint32_t heldOpenMs, bool locked, bool open, uint32_t now) {
+  memset(door, 0, sizeof(*door));
+  door->heldOpenMs = heldOpenMs > 0 ? heldOpenMs : DOOR_HELD_OPEN_DEFAULT_MS;
+  door->locked = locked;
+  door->lockChangedAt = now - DOOR_RELOCK_GRACE_MS;
+  door->open = open;
+  door->openedAt = now;
+}
+
+/**
+ * 设置门长时间未关阈值
+ * @param door 单门状态
+ * @param heldOpenMs 阈值(ms)
+ * @return 是否有效
+ */
+bool door_monitor_set_held_open(DoorMonitor *door, uint32_t heldOpenMs) {
+  if (heldOpenMs < DOOR_HELD_OPEN_MIN_MS || heldOpenMs > DOOR_HELD_OPEN_MAX_MS) {
+    return false;
+  }
+  door->heldOpenMs = heldOpenMs;
+  return true;
+}
+
+/**
+ * 锁状态变化
+ * @param door 单门状态
+ * @param locked 是否关锁
+ * @param now 当前时间(ms)
+ */
+void door_monitor_lock(DoorMonitor *door, bool locked, uint32_t now) {
+  if (locked != door->locked) {
+    door->locked = locked;
+    door->lockChangedAt = now;
+  }
+}
+
+/**
+ * 门状态变化
+ * @param door 单门状态
+ * @param open 门是否打开
+ * @param now 当前时间(ms)
+ * @return 判断结果
+ */
+uint8_t door_monitor_door(DoorMonitor *door, bool open, uint32_t now) {
+  if (open == door->open) {
+    return 0;
+  }
+  door->open = open;
+
+  if (!open) {
+    bool alarmed = door->heldAlarmed;
+    door->heldAlarmed = false;
+    return alarmed ? DOOR_ACTION_HELD_OPEN_CLEAR : 0;
+  }
+
+  // 门磁事件可能晚于之后的锁状态变化处理（按边沿时间判断），锁状态变化晚于开门时不算
+  door->openedAt = now;
+  if (door->locked && (int32_t)(now - door->lockChangedAt) >= DOOR_RELOCK_GRACE_MS) {
+    door->forcedCount++;
+    return DOOR_ACTION_FORCED;
+  }
+  return 0;
+}
+
+/**
+ * 到时判断
+ * @param door 单门状态
+ * @param now 当前时间(ms)
+ * @return 判断结果
+ */
+uint8_t door_monitor_poll(DoorMonitor *door, uint32_t now) {
+  if (door->open && !door->heldAlarmed && now - door->openedAt >= door->heldOpenMs) {
+    door->heldAlarmed = true;
+    door->heldOpenCount++;
+    return DOOR_ACTION_HELD_OPEN;
+  }
+  return 0;
+}
+
+/**
+ * 距下一次到时判断的时间
+ * @param door 单门状态
+ * @param now 当前时间(ms)
+ * @return 时间(ms)，DOOR_MONITOR_NONE表示无需定时
+ */
+uint32_t door_monitor_deadline(const DoorMonitor *door, uint32_t now) {
+  if (!door->open || door->heldAlarmed) {
+    return DOOR_MONITOR_NONE;
+  }
+  uint32_t elapsed = now - door->openedAt;
+  return elapsed >= door->heldOpenMs ? 0 : door->heldOpenMs - elapsed;
+}
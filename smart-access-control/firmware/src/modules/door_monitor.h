@@ -0,0 +1,99 @@
+#ifndef DOOR_MONITOR_H
+#define DOOR_MONITOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 门状态关联：把锁状态和门磁状态对照，判断强行开门和门长时间未关
+//   - 强行开门：锁处于关锁状态时门被打开（关锁后短暂宽限期内打开不算，开门时恰好关锁的情况）
+//   - 门长时间未关：门打开超过该门的阈值；门关上时解除
+// 门磁边沿和锁状态变化到来时立即判断，门长时间未关由调用方按 door_monitor_deadline 设置定时器。
+// 状态机不读取时钟、不阻塞，由调用方传入毫秒时间戳。
+// 本文件不依赖Arduino，可在主机上按时间线测试（tools/bench/door_monitor_bench.c）
+
+// 门数量（本控制器使用门0）
+#define DOOR_MONITOR_MAX_DOORS  4
+
+// 默认门长时间未关阈值(ms)
+#define DOOR_HELD_OPEN_DEFAULT_MS  30000
+
+// 阈值范围(ms)
+#define DOOR_HELD_OPEN_MIN_MS  5000
+#define DOOR_HELD_OPEN_MAX_MS  3600000
+
+// 关锁后的宽限期(ms)：期间打开门不算强行开门
+#define DOOR_RELOCK_GRACE_MS  1000
+
+// 无待定时的判断
+#define DOOR_MONITOR_NONE  UINT32_MAX
+
+// 判断结果（位掩码）
+#define DOOR_ACTION_FORCED          0x01   // 强行开门
+#define DOOR_ACTION_HELD_OPEN       0x02   // 门长时间未关
+#define DOOR_ACTION_HELD_OPEN_CLEAR 0x04   // 长时间未关的门已关上
+
+// 单门状态
+typedef struct {
+  uint32_t heldOpenMs;     // 门长时间未关阈值
+  bool locked;             // 锁状态
+  uint32_t lockChangedAt;  // 锁状态变化时间
+  bool open;               // 门状态
+  uint32_t openedAt;       // 门打开时间
+  bool heldAlarmed;        // 本次打开已报门长时间未关
+  uint32_t forcedCount;    // 强行开门次数
+  uint32_t heldOpenCount;  // 门长时间未关次数
+} DoorMonitor;
+
+/**
+ * 单门初始化
+ * @param door 单门状态
+ * @param heldOpenMs 门长时间未关阈值(ms)，0表示默认值
+ * @param locked 当前锁状态
+ * @param open 当前门状态
+ * @param now 当前时间(ms)
+ */
+void door_monitor_init(DoorMonitor *door, uint32_t heldOpenMs, bool locked, bool open, uint32_t now);
+
+/**
+ * 设置门长时间未关阈值
+ * 门已打开时从打开时间起按新阈值计算
+ * @param door 单门状态
+ * @param heldOpenMs 阈值(ms)
+ * @return 是否有效
+ */
+bool door_monitor_set_held_open(DoorMonitor *door, uint32_t heldOpenMs);
+
+/**
+ * 锁状态变化
+ * @param door 单门状态
+ * @param locked 是否关锁
+ * @param now 当前时间(ms)
+ */
+void door_monitor_lock(DoorMonitor *door, bool locked, uint32_t now);
+
+/**
+ * 门状态变化
+ * @param door 单门状态
+ * @param open 门是否打开
+ * @param now 当前时间(ms)
+ * @return 判断结果（DOOR_ACTION_*）
+ */
+uint8_t door_monitor_door(DoorMonitor *door, bool open, uint32_t now);
+
+/**
+ * 到时判断（门长时间未关）
+ * @param door 单门状态
+ * @param now 当前时间(ms)
+ * @return 判断结果（DOOR_ACTION_*）
+ */
+uint8_t door_monitor_poll(DoorMonitor *door, uint32_t now);
+
+/**
+ * 距下一次到时判断的时间
+ * @param door 单门状态
+ * @param now 当前时间(ms)
+ * @return 时间(ms)，DOOR_MONITOR_NONE表示无需定时
+ */
+uint32_t door_monitor_deadline(const DoorMonitor *door, uint32_t now);
+
+#endif
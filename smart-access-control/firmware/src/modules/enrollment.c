@@ -0,0 +1,509 @@
+#include <Arduino.h>
+#include <PubSubClient.h>
+#include <ArduinoJson.h>
+#include <SD.h>
+
+// 头文件包含
+#include "modules/enrollment.h"
+#include "modules/storage.h"
+#include "modules/security.h"
+#include "modules/communication.h"
+#include "drivers/fingerprint_driver.h"
+
+// 模板镜像文件（SD卡可拆卸，以设备密钥认证，防止替换或植入模板）
+#define ENROLLMENT_MIRROR_MAGIC  0x32505446  // "FTP2"
+
+// 模板镜像文件头
+typedef struct __attribute__((packed)) {
+  uint32_t magic;
+  uint16_t id;
+  uint16_t length;
+  uint8_t mac[SECURITY_MAC_SIZE];   // HMAC(设备密钥, magic || id || length || 模板)
+} EnrollmentMirrorHeader;
+
+// 参与认证的文件头部分
+#define ENROLLMENT_MIRROR_SIGNED  offsetof(EnrollmentMirrorHeader, mac)
+
+// 命令
+typedef enum {
+  ENROLLMENT_OP_NONE,
+  ENROLLMENT_OP_ENROLL,
+  ENROLLMENT_OP_DELETE,
+  ENROLLMENT_OP_BACKUP,
+  ENROLLMENT_OP_RESTORE
+} EnrollmentOp;
+
+// 待处理命令
+typedef struct {
+  uint8_t op;
+  uint16_t id;
+} EnrollmentRequest;
+
+// MQTT客户端
+PubSubClient *enrollmentClient = NULL;
+
+// 设备ID及定向主题
+char enrollmentDeviceId[64] = "";
+char enrollmentDeviceTopic[128] = "";
+
+// 命令队列（MQTT回调写入，访问控制任务读取）
+QueueHandle_t enrollmentQueue = NULL;
+volatile bool enrollmentCancel = false;
+
+// 进行中的操作
+EnrollmentOp enrollmentOp = ENROLLMENT_OP_NONE;
+uint16_t enrollmentId = 0;                 // 录入的模板号或批量操作的当前模板号
+uint16_t enrollmentDone = 0;
+uint16_t enrollmentFailed = 0;
+FingerprintPrompt enrollmentPrompt = FINGERPRINT_PROMPT_NONE;
+unsigned long enrollmentProgressMillis = 0;
+
+// 批量写入：镜像目录及已读出待写入的模板
+File enrollmentDir;
+uint8_t enrollmentTemplate[FINGERPRINT_TEMPLATE_MAX];
+uint16_t enrollmentTemplateLength = 0;
+bool enrollmentTemplatePending = false;
+
+static const char *enrollment_op_name(EnrollmentOp op) {
+  switch (op) {
+    case ENROLLMENT_OP_ENROLL:
+      return "enroll";
+    case ENROLLMENT_OP_DELETE:
+      return "delete";
+    case ENROLLMENT_OP_BACKUP:
+      return "backup";
+    case ENROLLMENT_OP_RESTORE:
+      return "restore";
+    default:
+      return "none";
+  }
+}
+
+static const char *enrollment_prompt_name(FingerprintPrompt prompt) {
+  switch (prompt) {
+    case FINGERPRINT_PROMPT_PLACE:
+      return "place_finger";
+    case FINGERPRINT_PROMPT_LIFT:
+      return "lift_finger";
+    case FINGERPRINT_PROMPT_PLACE_AGAIN:
+      return "place_again";
+    case FINGERPRINT_PROMPT_RETRY:
+      return "retry";
+    default:
+      return "running";
+  }
+}
+
+/**
+ * 上报进度
+ * @param state 状态
+ * @param error 模块确认码（失败时）
+ */
+static void enrollment_publish(const char *state, uint8_t error) {
+  Serial.printf("指纹%s: 模板%u %s（完成%u，失败%u）\n", enrollment_op_name(enrollmentOp), enrollmentId, state,
+                enrollmentDone, enrollmentFailed);
+  enrollmentProgressMillis = millis();
+
+  if (!enrollmentClient) {
+    return;
+  }
+
+  StaticJsonDocument<256> doc;
+  doc["device_id"] = enrollmentDeviceId;
+  doc["operation"] = enrollment_op_name(enrollmentOp);
+  doc["id"] = enrollmentId;
+  doc["state"] = state;
+  if (error != FINGERPRINT_ACK_OK) {
+    doc["error"] = error;
+  }
+  if (enrollmentOp == ENROLLMENT_OP_BACKUP || enrollmentOp == ENROLLMENT_OP_RESTORE) {
+    doc["done"] = enrollmentDone;
+    doc["failed"] = enrollmentFailed;
+  }
+
+  char payload[256];
+  size_t length = serializeJson(doc, payload, sizeof(payload));
+  communication_lock();
+  if (enrollmentClient->connected()) {
+    enrollmentClient->publish(ENROLLMENT_TOPIC_PROGRESS, (const uint8_t *)payload, length);
+  }
+  communication_unlock();
+}
+
+/**
+ * 结束当前操作
+ */
+static void enrollment_complete(const char *state, uint8_t error) {
+  enrollment_publish(state, error);
+  if (enrollmentDir) {
+    enrollmentDir.close();
+  }
+  enrollmentTemplatePending = false;
+  enrollmentOp = ENROLLMENT_OP_NONE;
+}
+
+static void enrollment_mirror_path(uint16_t id, char *path, size_t size) {
+  snprintf(path, size, "%s/%u.tpl", ENROLLMENT_MIRROR_DIR, id);
+}
+
+/**
+ * 写入模板镜像
+ * @param id 模板号
+ * @param data 模板
+ * @param length 长度
+ * @return 是否成功
+ */
+static bool enrollment_write_mirror(uint16_t id, const uint8_t *data, uint16_t length) {
+  if (!storage_is_initialized()) {
+    return false;
+  }
+
+  EnrollmentMirrorHeader header;
+  header.magic = ENROLLMENT_MIRROR_MAGIC;
+  header.id = id;
+  header.length = length;
+  security_mac((const uint8_t *)&header, ENROLLMENT_MIRROR_SIGNED, data, length, header.mac);
+
+  char path[48];
+  enrollment_mirror_path(id, path, sizeof(path));
+  File file = SD.open(path, FILE_WRITE);
+  if (!file) {
+    return false;
+  }
+  bool ok = file.write((const uint8_t *)&header, sizeof(header)) == sizeof(header) &&
+            file.write(data, length) == length;
+  file.close();
+  if (!ok) {
+    SD.remove(path);
+  }
+  return ok;
+}
+
+/**
+ * 从镜像文件名（<模板号>.tpl）解析模板号
+ * @param name 文件名（可含目录）
+ * @param id 模板号
+ * @return 是否符合命名
+ */
+static bool enrollment_mirror_name_id(const char *name, uint16_t *id) {
+  const char *slash = strrchr(name, '/');
+  const char *base = slash ? slash + 1 : name;
+
+  uint32_t value = 0;
+  const char *p = base;
+  while (*p >= '0' && *p <= '9' && value <= 0xFFFF) {
+    value = value * 10 + (*p - '0');
+    p++;
+  }
+  if (p == base || value > 0xFFFF || strcmp(p, ".tpl") != 0) {
+    return false;
+  }
+
+  *id = (uint16_t)value;
+  return true;
+}
+
+/**
+ * 读取模板镜像到enrollmentTemplate
+ * 认证码不符或文件头中的模板号与文件名不一致时拒绝
+ * @param file 镜像文件
+ * @param id 模板号
+ * @return 是否有效
+ */
+static bool enrollment_read_mirror(File &file, uint16_t *id) {
+  uint16_t nameId;
+  if (!enrollment_mirror_name_id(file.name(), &nameId)) {
+    return false;
+  }
+
+  EnrollmentMirrorHeader header;
+  if (file.read((uint8_t *)&header, sizeof(header)) != sizeof(header) || header.magic != ENROLLMENT_MIRROR_MAGIC ||
+      header.id != nameId || header.length == 0 || header.length > FINGERPRINT_TEMPLATE_MAX) {
+    return false;
+  }
+  if (file.read(enrollmentTemplate, header.length) != header.length ||
+      !security_mac_verify((const uint8_t *)&header, ENROLLMENT_MIRROR_SIGNED, enrollmentTemplate, header.length,
+                           header.mac)) {
+    return false;
+  }
+
+  *id = header.id;
+  enrollmentTemplateLength = header.length;
+  return true;
+}
+
+/**
+ * 开始批量操作的下一个模板
+ * 模块忙时保留进度，下次调用重试
+ */
+static void enrollment_next() {
+  if (enrollmentOp == ENROLLMENT_OP_BACKUP) {
+    uint16_t capacity = fingerprint_get_capacity();
+    if (enrollmentId >= capacity) {
+      enrollment_complete("done", FINGERPRINT_ACK_OK);
+      return;
+    }
+    fingerprint_start_upload(enrollmentId);
+    return;
+  }
+
+  // 批量写入：依次读取镜像目录中的文件
+  while (!enrollmentTemplatePending) {
+    File file = enrollmentDir.openNextFile();
+    if (!file) {
+      enrollment_complete("done", FINGERPRINT_ACK_OK);
+      return;
+    }
+    if (!file.isDirectory()) {
+      if (enrollment_read_mirror(file, &enrollmentId)) {
+        enrollmentTemplatePending = true;
+      } else {
+        Serial.printf("模板镜像无效: %s\n", file.name());
+        enrollmentFailed++;
+      }
+    }
+    file.close();
+  }
+
+  if (fingerprint_start_download(enrollmentId, enrollmentTemplate, enrollmentTemplateLength)) {
+    enrollmentTemplatePending = false;
+  }
+}
+
+/**
+ * 开始一条命令
+ * @param request 命令
+ * @return 是否已处理（模块忙时返回false，命令留在队列中）
+ */
+static bool enrollment_start(const EnrollmentRequest *request) {
+  if (!fingerprint_is_initialized()) {
+    enrollmentOp = (EnrollmentOp)request->op;
+    enrollmentId = request->id;
+    enrollment_complete("failed", FINGERPRINT_ACK_TIMEOUT);
+    return true;
+  }
+
+  enrollmentDone = 0;
+  enrollmentFailed = 0;
+
+  if ((request->op == ENROLLMENT_OP_ENROLL || request->op == ENROLLMENT_OP_DELETE) &&
+      request->id >= fingerprint_get_capacity()) {
+    enrollmentOp = (EnrollmentOp)request->op;
+    enrollmentId = request->id;
+    enrollment_complete("failed", FINGERPRINT_ACK_PACKET_ERROR);
+    return true;
+  }
+
+  switch (request->op) {
+    case ENROLLMENT_OP_ENROLL:
+      if (!fingerprint_start_enroll(request->id)) {
+        return false;
+      }
+      enrollmentOp = ENROLLMENT_OP_ENROLL;
+      enrollmentId = request->id;
+      enrollmentPrompt = FINGERPRINT_PROMPT_NONE;
+      return true;
+
+    case ENROLLMENT_OP_DELETE: {
+      if (fingerprint_is_busy()) {
+        return false;
+      }
+      enrollmentOp = ENROLLMENT_OP_DELETE;
+      enrollmentId = request->id;
+      bool ok = fingerprint_delete(request->id);
+      char path[48];
+      enrollment_mirror_path(request->id, path, sizeof(path));
+      if (storage_is_initialized() && SD.exists(path)) {
+        SD.remove(path);
+      }
+      enrollment_complete(ok ? "done" : "failed", ok ? FINGERPRINT_ACK_OK : FINGERPRINT_ACK_NOT_FOUND);
+      return true;
+    }
+
+    case ENROLLMENT_OP_BACKUP:
+      enrollmentOp = ENROLLMENT_OP_BACKUP;
+      enrollmentId = 0;
+      enrollment_publish("running", FINGERPRINT_ACK_OK);
+      enrollment_next();
+      return true;
+
+    case ENROLLMENT_OP_RESTORE:
+      enrollmentOp = ENROLLMENT_OP_RESTORE;
+      enrollmentId = 0;
+      enrollmentDir = storage_is_initialized() ? SD.open(ENROLLMENT_MIRROR_DIR) : File();
+      if (!enrollmentDir) {
+        enrollment_complete("failed", FINGERPRINT_ACK_NOT_FOUND);
+        return true;
+      }
+      enrollment_publish("running", FINGERPRINT_ACK_OK);
+      enrollment_next();
+      return true;
+
+    default:
+      return true;
+  }
+}
+
+/**
+ * 处理结束的作业
+ * @param job 作业
+ */
+static void enrollment_job_finished(const FingerprintJob *job) {
+  bool done = job->state == FINGERPRINT_JOB_DONE;
+  uint8_t error = job->error;
+
+  if (enrollmentOp == ENROLLMENT_OP_ENROLL) {
+    bool mirrored = done && enrollment_write_mirror(enrollmentId, job->templateData, job->templateLength);
+    fingerprint_finish_job();
+    if (done && !mirrored) {
+      // 模板已存入模块，镜像失败不影响使用，可稍后备份
+      enrollment_complete("stored", FINGERPRINT_ACK_OK);
+    } else {
+      enrollment_complete(done ? "done" : "failed", error);
+    }
+    return;
+  }
+
+  if (enrollmentOp == ENROLLMENT_OP_BACKUP) {
+    if (done && enrollment_write_mirror(enrollmentId, job->templateData, job->templateLength)) {
+      enrollmentDone++;
+    } else if (done || error != FINGERPRINT_ACK_EMPTY_PAGE) {
+      enrollmentFailed++;
+    }
+    enrollmentId++;
+  } else if (done) {
+    enrollmentDone++;
+  } else {
+    enrollmentFailed++;
+  }
+
+  fingerprint_finish_job();
+  if (millis() - enrollmentProgressMillis >= ENROLLMENT_PROGRESS_INTERVAL) {
+    enrollment_publish("running", FINGERPRINT_ACK_OK);
+  }
+  enrollment_next();
+}
+
+/**
+ * 指纹管理初始化
+ */
+void enrollment_init() {
+  enrollmentQueue = xQueueCreate(ENROLLMENT_QUEUE_LENGTH, sizeof(EnrollmentRequest));
+
+  if (storage_is_initialized() && !SD.exists(ENROLLMENT_MIRROR_DIR)) {
+    SD.mkdir(ENROLLMENT_MIRROR_DIR);
+  }
+  Serial.println("指纹管理初始化完成");
+}
+
+/**
+ * 订阅指纹管理主题
+ * @param client MQTT客户端
+ * @param deviceId 设备ID
+ */
+void enrollment_subscribe(PubSubClient *client, const char *deviceId) {
+  enrollmentClient = client;
+  strlcpy(enrollmentDeviceId, deviceId, sizeof(enrollmentDeviceId));
+  snprintf(enrollmentDeviceTopic, sizeof(enrollmentDeviceTopic), "%s%s", ENROLLMENT_TOPIC_DEVICE, deviceId);
+
+  client->subscribe(enrollmentDeviceTopic);
+  Serial.printf("已订阅主题: %s\n", enrollmentDeviceTopic);
+}
+
+/**
+ * 处理指纹管理消息
+ * @param topic 主题
+ * @param payload 负载
+ * @param length 长度
+ * @return 是否为指纹管理消息
+ */
+bool enrollment_handle_message(const char *topic, byte *payload, unsigned int length) {
+  if (enrollmentDeviceTopic[0] == '\0' || strcmp(topic, enrollmentDeviceTopic) != 0) {
+    return false;
+  }
+
+  StaticJsonDocument<256> doc;
+  DeserializationError error = deserializeJson(doc, payload, length);
+  if (error) {
+    Serial.printf("指纹管理消息解析错误: %s\n", error.c_str());
+    return true;
+  }
+
+  const char *command = doc["command"] | "";
+  EnrollmentRequest request = {ENROLLMENT_OP_NONE, (uint16_t)(doc["id"] | 0)};
+  if (strcmp(command, "cancel") == 0) {
+    // 取消进行中的操作并丢弃排队的命令
+    xQueueReset(enrollmentQueue);
+    enrollmentCancel = true;
+    return true;
+  } else if (strcmp(command, "enroll") == 0) {
+    request.op = ENROLLMENT_OP_ENROLL;
+  } else if (strcmp(command, "delete") == 0) {
+    request.op = ENROLLMENT_OP_DELETE;
+  } else if (strcmp(command, "backup") == 0) {
+    request.op = ENROLLMENT_OP_BACKUP;
+  } else if (strcmp(command, "restore") == 0) {
+    request.op = ENROLLMENT_OP_RESTORE;
+  } else {
+    Serial.printf("未知指纹管理命令: %s\n", command);
+    return true;
+  }
+
+  if (!enrollmentQueue || xQueueSend(enrollmentQueue, &request, 0) != pdTRUE) {
+    Serial.println("指纹管理命令队列已满");
+  }
+  return true;
+}
+
+/**
+ * 推进指纹管理操作
+ */
+void enrollment_poll() {
+  if (!enrollmentQueue) {
+    return;
+  }
+
+  if (enrollmentCancel) {
+    enrollmentCancel = false;
+    if (enrollmentOp != ENROLLMENT_OP_NONE) {
+      if (fingerprint_get_job()->type != FINGERPRINT_JOB_NONE) {
+        fingerprint_finish_job();
+      }
+      enrollment_complete("cancelled", FINGERPRINT_ACK_OK);
+    }
+  }
+
+  if (enrollmentOp == ENROLLMENT_OP_NONE) {
+    EnrollmentRequest request;
+    if (xQueuePeek(enrollmentQueue, &request, 0) == pdTRUE && enrollment_start(&request)) {
+      xQueueReceive(enrollmentQueue, &request, 0);
+    }
+    return;
+  }
+
+  const FingerprintJob *job = fingerprint_get_job();
+  if (job->type == FINGERPRINT_JOB_NONE) {
+    // 批量操作上一次开始时模块忙
+    enrollment_next();
+    return;
+  }
+
+  if (fingerprint_job_running(job)) {
+    if (enrollmentOp == ENROLLMENT_OP_ENROLL && job->prompt != enrollmentPrompt &&
+        job->prompt != FINGERPRINT_PROMPT_NONE) {
+      enrollmentPrompt = job->prompt;
+      enrollment_publish(enrollment_prompt_name(job->prompt), FINGERPRINT_ACK_OK);
+    }
+    return;
+  }
+
+  enrollment_job_finished(job);
+}
+
+/**
+ * 判断是否有进行中的指纹管理操作
+ * @return 是否进行中
+ */
+bool enrollment_is_active() {
+  return enrollmentOp != ENROLLMENT_OP_NONE;
+}
@@ -0,0 +1,62 @@
+#ifndef ENROLLMENT_H
+#define ENROLLMENT_H
+
+#include <Arduino.h>
+#include <PubSubClient.h>
+
+// 指纹管理主题
+// 后台定向下发命令，后接设备ID：
+//   {"command": "enroll", "id": 7}   录入（两次按压），完成后镜像到SD卡
+//   {"command": "delete", "id": 7}   删除模块中的模板及镜像
+//   {"command": "backup"}             读出模块中全部模板镜像到SD卡
+//   {"command": "restore"}            将SD卡镜像全部写入模块（更换模块后）
+//   {"command": "cancel"}             取消进行中的操作
+#define ENROLLMENT_TOPIC_DEVICE    "access-control/fingerprint/device/"
+// 设备上报进度：{"device_id", "operation", "id", "state", "error", "done", "failed"}
+#define ENROLLMENT_TOPIC_PROGRESS  "access-control/fingerprint/progress"
+
+// 模板镜像目录，文件名为 <模板号>.tpl
+#define ENROLLMENT_MIRROR_DIR  "/fingerprints"
+
+// 待处理命令数量上限
+#define ENROLLMENT_QUEUE_LENGTH  8
+
+// 批量操作进度上报间隔(ms)
+#define ENROLLMENT_PROGRESS_INTERVAL  1000
+
+/**
+ * 指纹管理初始化
+ * 须在存储和指纹模块之后调用
+ */
+void enrollment_init();
+
+/**
+ * 订阅指纹管理主题
+ * MQTT连接成功后调用
+ * @param client MQTT客户端
+ * @param deviceId 设备ID
+ */
+void enrollment_subscribe(PubSubClient *client, const char *deviceId);
+
+/**
+ * 处理指纹管理消息（MQTT回调中调用，只入队不访问模块）
+ * @param topic 主题
+ * @param payload 负载
+ * @param length 长度
+ * @return 是否为指纹管理消息
+ */
+bool enrollment_handle_message(const char *topic, byte *payload, unsigned int length);
+
+/**
+ * 推进指纹管理操作
+ * 在访问控制任务中fingerprint_check之后调用，不阻塞
+ */
+void enrollment_poll();
+
+/**
+ * 判断是否有进行中的指纹管理操作
+ * @return 是否进行中
+ */
+bool enrollment_is_active();
+
+#endif
@@ -0,0 +1,155 @@
+#include <Arduino.h>
+
+// 头文件包含
+#include "modules/event_bus.h"
+
+#define BUS_ROUTE(queue)  (1u << (queue))
+
+// 各类事件投递到的队列
+static const uint8_t eventBusRoutes[BUS_EVENT_TYPE_COUNT] = {
+  BUS_ROUTE(BUS_QUEUE_ACCESS),                                // BUS_EVENT_CARD
+  BUS_ROUTE(BUS_QUEUE_ACCESS),                                // BUS_EVENT_TOUCH
+  BUS_ROUTE(BUS_QUEUE_ACCESS),                                // BUS_EVENT_KEY
+  BUS_ROUTE(BUS_QUEUE_ACCESS) | BUS_ROUTE(BUS_QUEUE_SECURITY), // BUS_EVENT_DOOR
+  BUS_ROUTE(BUS_QUEUE_SECURITY),                              // BUS_EVENT_TAMPER
+  BUS_ROUTE(BUS_QUEUE_COMMUNICATION),                         // BUS_EVENT_MQTT_COMMAND（负载只能有一个所有者）
+};
+
+// 处理任务队列
+QueueHandle_t eventBusQueues[BUS_QUEUE_COUNT];
+bool eventBusReady = false;
+
+// 统计（中断和多个任务写入）
+portMUX_TYPE eventBusMux = portMUX_INITIALIZER_UNLOCKED;
+EventBusStats eventBusStats;
+
+/**
+ * 事件总线初始化
+ * @return 是否成功
+ */
+bool event_bus_init() {
+  for (int i = 0; i < BUS_QUEUE_COUNT; i++) {
+    eventBusQueues[i] = xQueueCreate(EVENT_BUS_QUEUE_LENGTH, sizeof(BusEvent));
+    if (!eventBusQueues[i]) {
+      Serial.println("事件总线初始化失败");
+      return false;
+    }
+  }
+  memset(&eventBusStats, 0, sizeof(eventBusStats));
+
+  eventBusReady = true;
+  Serial.println("事件总线初始化完成");
+  return true;
+}
+
+/**
+ * 投递事件（任务中调用，不等待）
+ * @param event 事件
+ * @return 是否全部投递成功
+ */
+bool event_bus_post(BusEvent *event) {
+  if (!eventBusReady || event->type >= BUS_EVENT_TYPE_COUNT) {
+    return false;
+  }
+  if (event->timestamp == 0) {
+    event->timestamp = millis();
+  }
+  event->postedUs = micros();
+
+  uint8_t route = eventBusRoutes[event->type];
+  bool ok = true;
+  for (int i = 0; i < BUS_QUEUE_COUNT; i++) {
+    if (route & BUS_ROUTE(i)) {
+      ok &= xQueueSend(eventBusQueues[i], event, 0) == pdTRUE;
+    }
+  }
+
+  portENTER_CRITICAL(&eventBusMux);
+  eventBusStats.posted[event->type]++;
+  eventBusStats.dropped[event->type] += !ok;
+  portEXIT_CRITICAL(&eventBusMux);
+  return ok;
+}
+
+/**
+ * 投递事件（中断服务程序中调用）
+ * @param event 事件
+ * @return 是否全部投递成功
+ */
+bool IRAM_ATTR event_bus_post_from_isr(BusEvent *event) {
+  if (!eventBusReady || event->type >= BUS_EVENT_TYPE_COUNT) {
+    return false;
+  }
+  if (event->timestamp == 0) {
+    event->timestamp = millis();
+  }
+  event->postedUs = micros();
+
+  uint8_t route = eventBusRoutes[event->type];
+  bool ok = true;
+  BaseType_t woken = pdFALSE;
+  for (int i = 0; i < BUS_QUEUE_COUNT; i++) {
+    if (route & BUS_ROUTE(i)) {
+      ok &= xQueueSendFromISR(eventBusQueues[i], event, &woken) == pdTRUE;
+    }
+  }
+
+  portENTER_CRITICAL_ISR(&eventBusMux);
+  eventBusStats.posted[event->type]++;
+  eventBusStats.dropped[event->type] += !ok;
+  portEXIT_CRITICAL_ISR(&eventBusMux);
+
+  if (woken) {
+    portYIELD_FROM_ISR();
+  }
+  return ok;
+}
+
+/**
+ * 等待事件
+ * @param queue 处理任务队列
+ * @param event 事件
+ * @param timeoutMs 超时(ms)
+ * @return 是否取到事件
+ */
+bool event_bus_wait(BusQueue queue, BusEvent *event, uint32_t timeoutMs) {
+  if (!eventBusReady) {
+    vTaskDelay(pdMS_TO_TICKS(timeoutMs == EVENT_BUS_WAIT_FOREVER ? 1000 : timeoutMs));
+    return false;
+  }
+
+  // 向上取整到tick，不早于调用方的到时时间返回
+  TickType_t ticks = portMAX_DELAY;
+  if (timeoutMs != EVENT_BUS_WAIT_FOREVER) {
+    ticks = (timeoutMs + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS;
+  }
+
+  UBaseType_t depth = uxQueueMessagesWaiting(eventBusQueues[queue]);
+  bool received = xQueueReceive(eventBusQueues[queue], event, ticks) == pdTRUE;
+  uint32_t latency = received ? micros() - event->postedUs : 0;
+
+  portENTER_CRITICAL(&eventBusMux);
+  if (received) {
+    eventBusStats.received[queue]++;
+    if (latency > eventBusStats.maxLatencyUs[queue]) {
+      eventBusStats.maxLatencyUs[queue] = latency;
+    }
+  } else if (timeoutMs > 0) {
+    eventBusStats.timeouts[queue]++;
+  }
+  if (depth > eventBusStats.peak[queue]) {
+    eventBusStats.peak[queue] = depth;
+  }
+  portEXIT_CRITICAL(&eventBusMux);
+  return received;
+}
+
+/**
+ * 获取事件总线统计
+ * @param stats 统计
+ */
+void event_bus_get_stats(EventBusStats *stats) {
+  portENTER_CRITICAL(&eventBusMux);
+  *stats = eventBusStats;
+  portEXIT_CRITICAL(&eventBusMux);
+}
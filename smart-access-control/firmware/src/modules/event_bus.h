@@ -0,0 +1,101 @@
+#ifndef EVENT_BUS_H
+#define EVENT_BUS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 事件总线
+// 驱动（中断、定时器、传感器任务）和MQTT回调把事件投递到总线，按类型路由到处理任务各自的队列：
+//   读卡、指纹触摸、按键         -> 访问控制任务
+//   门磁                         -> 访问控制任务（开锁期间关门提前关锁）、安全任务（强行开门、门长时间未关）
+//   防拆                         -> 安全任务
+//   MQTT命令                     -> 通信任务
+// 处理任务阻塞在自己的队列上，没有事件时不运行；定时工作（状态上报、锁定到期、门长时间未关）由等待超时承担。
+// 本头文件不依赖Arduino，主机仿真见 tools/bench/event_bus_bench.c
+
+// 事件类型
+typedef enum {
+  BUS_EVENT_CARD,          // 读卡区有卡
+  BUS_EVENT_TOUCH,         // 指纹触摸
+  BUS_EVENT_KEY,           // 按键按下/抬起
+  BUS_EVENT_DOOR,          // 门磁变化
+  BUS_EVENT_TAMPER,        // 防拆变化
+  BUS_EVENT_MQTT_COMMAND,  // MQTT命令
+  BUS_EVENT_TYPE_COUNT
+} BusEventType;
+
+// 处理任务队列
+typedef enum {
+  BUS_QUEUE_ACCESS,         // 访问控制任务
+  BUS_QUEUE_SECURITY,       // 安全任务
+  BUS_QUEUE_COMMUNICATION,  // 通信任务
+  BUS_QUEUE_COUNT
+} BusQueue;
+
+// 每个队列的长度
+#define EVENT_BUS_QUEUE_LENGTH  16
+
+// 一直等待
+#define EVENT_BUS_WAIT_FOREVER  UINT32_MAX
+
+// 事件（定长，按值入队）
+typedef struct {
+  uint8_t type;            // BusEventType
+  bool active;             // 按键按下、门打开、防拆触发
+  bool pulse;              // 防拆短暂触发后已恢复
+  char key;                // 按键
+  uint32_t timestamp;      // 发生时间(ms)
+  uint32_t postedUs;       // 投递时间(us)
+  char *payload;           // MQTT命令负载（投递方在堆上复制并以'\0'结尾，处理方释放）
+  uint16_t length;         // 负载长度
+  uint16_t trace;          // 读卡事件的访问延迟跟踪编号（modules/access_trace.h）
+} BusEvent;
+
+// 事件总线统计
+typedef struct {
+  uint32_t posted[BUS_EVENT_TYPE_COUNT];    // 投递的事件数
+  uint32_t dropped[BUS_EVENT_TYPE_COUNT];   // 队列满丢弃的事件数
+  uint32_t received[BUS_QUEUE_COUNT];       // 处理任务取出的事件数
+  uint32_t timeouts[BUS_QUEUE_COUNT];       // 等待超时次数（定时工作）
+  uint32_t maxLatencyUs[BUS_QUEUE_COUNT];   // 投递到取出的最大延迟(us)
+  uint8_t peak[BUS_QUEUE_COUNT];            // 队列最大深度
+} EventBusStats;
+
+/**
+ * 事件总线初始化
+ * 须在投递事件的驱动初始化之前调用
+ * @return 是否成功
+ */
+bool event_bus_init();
+
+/**
+ * 投递事件（任务中调用，不等待）
+ * 按类型投递到对应的队列；MQTT命令投递失败时由调用方释放负载
+ * @param event 事件（type、数据字段已填写，timestamp为0时取当前时间）
+ * @return 是否全部投递成功
+ */
+bool event_bus_post(BusEvent *event);
+
+/**
+ * 投递事件（中断服务程序中调用）
+ * @param event 事件
+ * @return 是否全部投递成功
+ */
+bool event_bus_post_from_isr(BusEvent *event);
+
+/**
+ * 等待事件
+ * @param queue 处理任务队列
+ * @param event 事件
+ * @param timeoutMs 超时(ms)，EVENT_BUS_WAIT_FOREVER表示一直等待，0表示不等待
+ * @return 是否取到事件（false为超时）
+ */
+bool event_bus_wait(BusQueue queue, BusEvent *event, uint32_t timeoutMs);
+
+/**
+ * 获取事件总线统计
+ * @param stats 统计
+ */
+void event_bus_get_stats(EventBusStats *stats);
+
+#endif
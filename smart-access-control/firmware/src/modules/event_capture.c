@@ -0,0 +1,238 @@
+#include <Arduino.h>
+#include <PubSubClient.h>
+#include <ArduinoJson.h>
+#include "esp_camera.h"
+
+// 头文件包含
+#include "drivers/camera_driver.h"
+#include "modules/event_capture.h"
+#include "modules/frame_ring.h"
+#include "modules/communication.h"
+
+// 摄像头驱动采集需要保留的帧缓冲区数
+#define EVENT_CAPTURE_DRIVER_FBS  2
+
+// 事件录像状态
+bool eventCaptureReady = false;
+
+// 环形缓冲区（录像任务写入，访问控制/安全/通信任务读取，互斥访问）
+FrameRing eventRing;
+SemaphoreHandle_t eventRingMutex = NULL;
+
+// 统计
+uint32_t eventCaptureMissed = 0;
+uint32_t eventCaptureUploaded = 0;
+uint32_t eventCaptureUploadFailed = 0;
+
+static const char *event_capture_type_name(uint8_t type) {
+  switch (type) {
+    case EVENT_CAPTURE_DENY:    return "deny";
+    case EVENT_CAPTURE_LOCKOUT: return "lockout";
+    case EVENT_CAPTURE_TAMPER:  return "tamper";
+    case EVENT_CAPTURE_FORCED:  return "forced";
+    default:                    return "unknown";
+  }
+}
+
+/**
+ * 帧缓冲区引用全部释放后还给驱动
+ */
+static void event_capture_release_frame(void *frame) {
+  camera_release_fb((camera_fb_t *)frame);
+}
+
+/**
+ * 事件录像初始化
+ */
+void event_capture_init() {
+  int slots = camera_get_fb_count() - EVENT_CAPTURE_DRIVER_FBS;
+  if (slots < FRAME_RING_PRE_FRAMES + 1) {
+    Serial.println("摄像头帧缓冲区不足，不录像");
+    return;
+  }
+
+  eventRingMutex = xSemaphoreCreateMutex();
+  if (!eventRingMutex) {
+    return;
+  }
+  frame_ring_init(&eventRing, slots, event_capture_release_frame);
+
+  eventCaptureReady = true;
+  Serial.printf("事件录像初始化完成（帧槽%u个，事件前%d帧/后%d帧）\n", eventRing.slotCount, FRAME_RING_PRE_FRAMES,
+               FRAME_RING_POST_FRAMES);
+}
+
+/**
+ * 事件录像任务
+ * @param pvParameters 未使用
+ */
+void event_capture_task(void *pvParameters) {
+  while (1) {
+    if (eventCaptureReady) {
+      camera_fb_t *fb = NULL;
+      if (!camera_capture(&fb)) {
+        eventCaptureMissed++;
+      } else {
+        xSemaphoreTake(eventRingMutex, portMAX_DELAY);
+        bool kept = frame_ring_push(&eventRing, fb, millis());
+        xSemaphoreGive(eventRingMutex);
+        if (!kept) {
+          camera_release_fb(fb);
+        }
+      }
+    }
+
+    vTaskDelay(pdMS_TO_TICKS(EVENT_CAPTURE_INTERVAL_MS));
+  }
+}
+
+/**
+ * 触发事件录像
+ * @param type 事件类型
+ */
+void event_capture_trigger(EventCaptureType type) {
+  if (!eventCaptureReady) {
+    return;
+  }
+
+  xSemaphoreTake(eventRingMutex, portMAX_DELAY);
+  int event = frame_ring_freeze(&eventRing, type, millis());
+  uint32_t id = event == FRAME_RING_NONE ? 0 : eventRing.events[event].id;
+  xSemaphoreGive(eventRingMutex);
+
+  if (event == FRAME_RING_NONE) {
+    Serial.printf("事件录像已满，丢弃事件: %s\n", event_capture_type_name(type));
+  } else {
+    Serial.printf("事件录像%u: %s\n", id, event_capture_type_name(type));
+  }
+}
+
+/**
+ * 上传冻结完成的事件
+ * 事件持有的帧在上传期间不会归还驱动，无需复制；上传失败的事件也释放，保证内存上限
+ * @param client MQTT客户端
+ * @param deviceId 设备ID
+ */
+void event_capture_upload(PubSubClient *client, const char *deviceId) {
+  if (!eventCaptureReady || !communication_connected(client)) {
+    return;
+  }
+
+  xSemaphoreTake(eventRingMutex, portMAX_DELAY);
+  int index = frame_ring_take_ready(&eventRing, millis());
+  FrameEvent event;
+  camera_fb_t *frames[FRAME_RING_EVENT_FRAMES];
+  uint32_t timestamps[FRAME_RING_EVENT_FRAMES];
+  if (index != FRAME_RING_NONE) {
+    event = eventRing.events[index];
+    for (int i = 0; i < event.count; i++) {
+      frames[i] = (camera_fb_t *)eventRing.slots[event.slots[i]].frame;
+      timestamps[i] = eventRing.slots[event.slots[i]].timestamp;
+    }
+  }
+  xSemaphoreGive(eventRingMutex);
+  if (index == FRAME_RING_NONE) {
+    return;
+  }
+
+  // 事件描述
+  DynamicJsonDocument doc(1536);
+  doc["device_id"] = deviceId;
+  doc["event_id"] = event.id;
+  doc["type"] = event_capture_type_name(event.type);
+  doc["timestamp"] = event.timestamp;
+  doc["pre_frames"] = event.preCount;
+  doc["dropped"] = event.dropped;
+  JsonArray list = doc.createNestedArray("frames");
+  for (int i = 0; i < event.count; i++) {
+    JsonObject frame = list.createNestedObject();
+    frame["index"] = i;
+    frame["offset_ms"] = (int32_t)(timestamps[i] - event.timestamp);
+    frame["size"] = frames[i]->len;
+  }
+
+  char payload[1024];
+  size_t length = serializeJson(doc, payload, sizeof(payload));
+  communication_lock();
+  bool ok = client->publish(EVENT_CAPTURE_TOPIC_EVENT, (const uint8_t *)payload, length);
+  communication_unlock();
+
+  // 逐帧直接从帧缓冲区发送
+  char topic[128];
+  for (int i = 0; ok && i < event.count; i++) {
+    snprintf(topic, sizeof(topic), "%s/%s/%u/%d", EVENT_CAPTURE_TOPIC_FRAME, deviceId, event.id, i);
+    ok = communication_publish_frame(client, topic, frames[i]->buf, frames[i]->len);
+  }
+
+  xSemaphoreTake(eventRingMutex, portMAX_DELAY);
+  frame_ring_finish(&eventRing, index);
+  xSemaphoreGive(eventRingMutex);
+
+  if (ok) {
+    eventCaptureUploaded++;
+  } else {
+    eventCaptureUploadFailed++;
+  }
+  Serial.printf("事件录像%u上传%s: %s, %d帧\n", event.id, ok ? "完成" : "失败", event_capture_type_name(event.type),
+               event.count);
+}
+
+/**
+ * 获取最新一帧
+ * @param fb 帧缓冲区
+ * @return 是否成功
+ */
+bool event_capture_acquire(camera_fb_t **fb) {
+  if (!eventCaptureReady) {
+    return camera_capture(fb);
+  }
+
+  xSemaphoreTake(eventRingMutex, portMAX_DELAY);
+  int slot = frame_ring_acquire_latest(&eventRing);
+  *fb = slot == FRAME_RING_NONE ? NULL : (camera_fb_t *)eventRing.slots[slot].frame;
+  xSemaphoreGive(eventRingMutex);
+  return *fb != NULL;
+}
+
+/**
+ * 释放event_capture_acquire获取的帧
+ * @param fb 帧缓冲区
+ */
+void event_capture_release(camera_fb_t *fb) {
+  if (!eventCaptureReady) {
+    camera_release_fb(fb);
+    return;
+  }
+
+  xSemaphoreTake(eventRingMutex, portMAX_DELAY);
+  for (int i = 0; i < eventRing.slotCount; i++) {
+    if (eventRing.slots[i].frame == fb) {
+      frame_ring_release(&eventRing, i);
+      break;
+    }
+  }
+  xSemaphoreGive(eventRingMutex);
+}
+
+/**
+ * 获取事件录像统计
+ * @param stats 统计
+ */
+void event_capture_get_stats(EventCaptureStats *stats) {
+  memset(stats, 0, sizeof(*stats));
+  if (!eventCaptureReady) {
+    return;
+  }
+
+  xSemaphoreTake(eventRingMutex, portMAX_DELAY);
+  stats->captured = eventRing.stats.captured;
+  stats->dropped = eventRing.stats.dropped;
+  stats->events = eventRing.stats.events;
+  stats->eventsDropped = eventRing.stats.eventsDropped;
+  stats->slots = eventRing.slotCount;
+  stats->slotsPeak = eventRing.stats.slotsPeak;
+  xSemaphoreGive(eventRingMutex);
+  stats->missed = eventCaptureMissed;
+  stats->uploaded = eventCaptureUploaded;
+  stats->uploadFailed = eventCaptureUploadFailed;
+}
@@ -0,0 +1,86 @@
+#ifndef EVENT_CAPTURE_H
+#define EVENT_CAPTURE_H
+
+#include <Arduino.h>
+#include <PubSubClient.h>
+#include "esp_camera.h"
+
+// 事件录像：摄像头持续出帧进入环形缓冲区，拒绝访问、锁定、防拆、强行开门时冻结前后若干帧并在后台上传
+// 上传先发事件描述，再逐帧发送JPEG：
+//   access-control/snapshot/event  {"device_id", "event_id", "type", "timestamp", "frames": [{"index", "offset_ms", "size"}], "pre_frames", "dropped"}
+//   access-control/snapshot/frame/<设备ID>/<事件编号>/<帧序号>  JPEG原始数据
+#define EVENT_CAPTURE_TOPIC_EVENT  "access-control/snapshot/event"
+#define EVENT_CAPTURE_TOPIC_FRAME  "access-control/snapshot/frame"
+
+// 出帧间隔(ms)
+#define EVENT_CAPTURE_INTERVAL_MS  250
+
+// 事件类型
+typedef enum {
+  EVENT_CAPTURE_DENY,
+  EVENT_CAPTURE_LOCKOUT,
+  EVENT_CAPTURE_TAMPER,
+  EVENT_CAPTURE_FORCED
+} EventCaptureType;
+
+// 统计
+typedef struct {
+  uint32_t captured;         // 进入缓冲区的帧数
+  uint32_t dropped;          // 帧槽被事件占满丢弃的帧数
+  uint32_t missed;           // 驱动取帧超时次数
+  uint32_t events;           // 冻结的事件数
+  uint32_t eventsDropped;    // 事件槽已满丢弃的事件数
+  uint32_t uploaded;         // 上传完成的事件数
+  uint32_t uploadFailed;     // 上传失败的事件数
+  uint8_t slots;             // 帧槽数
+  uint8_t slotsPeak;         // 帧槽占用峰值
+} EventCaptureStats;
+
+/**
+ * 事件录像初始化
+ * 须在摄像头初始化之后调用，摄像头帧缓冲区不足时不录像
+ */
+void event_capture_init();
+
+/**
+ * 事件录像任务（持续取帧放入环形缓冲区）
+ * @param pvParameters 未使用
+ */
+void event_capture_task(void *pvParameters);
+
+/**
+ * 触发事件录像
+ * 冻结触发前的帧并继续采集之后的帧，任意任务中调用
+ * @param type 事件类型
+ */
+void event_capture_trigger(EventCaptureType type);
+
+/**
+ * 上传冻结完成的事件
+ * 在通信任务中调用，每次最多上传一个事件
+ * @param client MQTT客户端
+ * @param deviceId 设备ID
+ */
+void event_capture_upload(PubSubClient *client, const char *deviceId);
+
+/**
+ * 获取最新一帧（引用计数，不复制，用完须调用event_capture_release）
+ * 未录像时直接从摄像头取帧
+ * @param fb 帧缓冲区
+ * @return 是否成功
+ */
+bool event_capture_acquire(camera_fb_t **fb);
+
+/**
+ * 释放event_capture_acquire获取的帧
+ * @param fb 帧缓冲区
+ */
+void event_capture_release(camera_fb_t *fb);
+
+/**
+ * 获取事件录像统计
+ * @param stats 统计
+ */
+void event_capture_get_stats(EventCaptureStats *stats);
+
+#endif
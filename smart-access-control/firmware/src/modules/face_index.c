@@ -0,0 +1,585 @@
+#include <string.h>
+#include <math.h>
+
+// 头文件包含
+#include "modules/face_index.h"
+
+// 候选节点
+typedef struct {
+  int32_t score;
+  uint16_t node;
+} FaceIndexCandidate;
+
+// 候选列表（按分数从高到低）
+typedef struct {
+  int count;
+  int capacity;
+  FaceIndexCandidate items[FACE_INDEX_EF_MAX];
+} FaceIndexList;
+
+// 搜索用的候选和结果列表（任务栈较小，放在静态区；索引只在访问控制任务中使用）
+static FaceIndexList faceIndexCandidates;
+static FaceIndexList faceIndexResults;
+
+/**
+ * 上层邻居表数量上限
+ * 节点层数按1/M的概率逐层递减，平均每个节点约1/(M-1)个上层邻居表，按1/4预留
+ */
+static uint32_t face_index_upper_capacity(uint32_t capacity) {
+  return capacity / 4 + 16;
+}
+
+static uint32_t face_index_clamp_capacity(uint32_t capacity) {
+  return capacity > FACE_INDEX_MAX_NODES ? FACE_INDEX_MAX_NODES : capacity;
+}
+
+/**
+ * 计算索引所需内存
+ * @param capacity 节点数上限
+ * @return 字节数
+ */
+size_t face_index_memory_size(uint32_t capacity) {
+  capacity = face_index_clamp_capacity(capacity);
+  size_t size = (size_t)capacity * sizeof(FaceEmbedding) +
+                (size_t)capacity * (sizeof(uint32_t) * 2 + sizeof(uint16_t) * (FACE_INDEX_M0 + 1) + 1) +
+                (size_t)face_index_upper_capacity(capacity) * FACE_INDEX_M * sizeof(uint16_t);
+  return (size + 15) & ~(size_t)15;
+}
+
+/**
+ * 索引初始化
+ * 特征放在最前面保证16字节对齐
+ * @param index 索引
+ * @param memory 内存
+ * @param capacity 节点数上限
+ */
+void face_index_init(FaceIndex *index, void *memory, uint32_t capacity) {
+  capacity = face_index_clamp_capacity(capacity);
+  uint8_t *p = (uint8_t *)memory;
+
+  index->capacity = capacity;
+  index->upperCapacity = face_index_upper_capacity(capacity);
+  index->embeddings = (FaceEmbedding *)p;
+  p += (size_t)capacity * sizeof(FaceEmbedding);
+  index->userIds = (uint32_t *)p;
+  p += (size_t)capacity * sizeof(uint32_t);
+  index->upperOffsets = (uint32_t *)p;
+  p += (size_t)capacity * sizeof(uint32_t);
+  index->layer0 = (uint16_t *)p;
+  p += (size_t)capacity * FACE_INDEX_M0 * sizeof(uint16_t);
+  index->upper = (uint16_t *)p;
+  p += (size_t)index->upperCapacity * FACE_INDEX_M * sizeof(uint16_t);
+  index->visited = (uint16_t *)p;
+  p += (size_t)capacity * sizeof(uint16_t);
+  index->levels = p;
+
+  face_index_clear(index);
+}
+
+/**
+ * 清空索引
+ * @param index 索引
+ */
+void face_index_clear(FaceIndex *index) {
+  index->count = 0;
+  index->upperCount = 0;
+  index->deleted = 0;
+  index->entry = FACE_INDEX_NONE;
+  index->maxLevel = 0;
+  index->visitEpoch = 0;
+  index->random = 0x2545F491;
+  memset(index->visited, 0, (size_t)index->capacity * sizeof(uint16_t));
+}
+
+/**
+ * 随机层号：P(层号≥l) = M^-l
+ */
+static int face_index_random_level(FaceIndex *index) {
+  uint32_t x = index->random;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  index->random = x;
+
+  float u = ((x >> 8) + 1) / 16777216.0f;
+  int level = (int)(-logf(u) / logf((float)FACE_INDEX_M));
+  return level > FACE_INDEX_MAX_LEVEL ? FACE_INDEX_MAX_LEVEL : level;
+}
+
+/**
+ * 节点在某层的邻居表（以FACE_INDEX_NONE结束）
+ */
+static uint16_t *face_index_links(const FaceIndex *index, uint32_t node, int level) {
+  if (level == 0) {
+    return index->layer0 + (size_t)node * FACE_INDEX_M0;
+  }
+  return index->upper + (size_t)(index->upperOffsets[node] + level - 1) * FACE_INDEX_M;
+}
+
+static int face_index_max_links(int level) {
+  return level == 0 ? FACE_INDEX_M0 : FACE_INDEX_M;
+}
+
+/**
+ * 开始新一次搜索（访问标记按轮次区分，轮次回绕时清零）
+ */
+static void face_index_begin_visit(FaceIndex *index) {
+  if (++index->visitEpoch == 0) {
+    memset(index->visited, 0, (size_t)index->capacity * sizeof(uint16_t));
+    index->visitEpoch = 1;
+  }
+}
+
+static bool face_index_visit(FaceIndex *index, uint16_t node) {
+  if (index->visited[node] == index->visitEpoch) {
+    return false;
+  }
+  index->visited[node] = index->visitEpoch;
+  return true;
+}
+
+/**
+ * 插入候选列表，已满且分数不高于末尾时丢弃
+ */
+static void face_index_list_insert(FaceIndexList *list, int32_t score, uint16_t node) {
+  int i = list->count;
+  if (i == list->capacity) {
+    if (score <= list->items[i - 1].score) {
+      return;
+    }
+    i--;
+  } else {
+    list->count++;
+  }
+  while (i > 0 && list->items[i - 1].score < score) {
+    list->items[i] = list->items[i - 1];
+    i--;
+  }
+  list->items[i].score = score;
+  list->items[i].node = node;
+}
+
+/**
+ * 上层贪心搜索：移动到更相似的邻居，直到没有更相似的邻居
+ */
+static FaceIndexCandidate face_index_greedy(const FaceIndex *index, const FaceEmbedding *query,
+                                            FaceIndexCandidate current, int level, uint32_t *scanned) {
+  bool moved = true;
+  while (moved) {
+    moved = false;
+    const uint16_t *links = face_index_links(index, current.node, level);
+    for (int i = 0; i < face_index_max_links(level) && links[i] != FACE_INDEX_NONE; i++) {
+      int32_t score = face_dot(query, &index->embeddings[links[i]]);
+      (*scanned)++;
+      if (score > current.score) {
+        current.score = score;
+        current.node = links[i];
+        moved = true;
+      }
+    }
+  }
+  return current;
+}
+
+/**
+ * 单层搜索：从起点出发扩展最相似的候选，结果保留results->capacity个最相似节点
+ */
+static void face_index_search_layer(FaceIndex *index, const FaceEmbedding *query, FaceIndexCandidate start,
+                                    int level, FaceIndexList *results, uint32_t *scanned) {
+  FaceIndexList *candidates = &faceIndexCandidates;
+  candidates->count = 0;
+  candidates->capacity = results->capacity;
+  results->count = 0;
+
+  face_index_begin_visit(index);
+  face_index_visit(index, start.node);
+  face_index_list_insert(candidates, start.score, start.node);
+  face_index_list_insert(results, start.score, start.node);
+
+  while (candidates->count > 0) {
+    FaceIndexCandidate current = candidates->items[0];
+    candidates->count--;
+    memmove(candidates->items, candidates->items + 1, candidates->count * sizeof(FaceIndexCandidate));
+    if (results->count == results->capacity && current.score < results->items[results->count - 1].score) {
+      break;
+    }
+
+    const uint16_t *links = face_index_links(index, current.node, level);
+    for (int i = 0; i < face_index_max_links(level) && links[i] != FACE_INDEX_NONE; i++) {
+      uint16_t node = links[i];
+      if (!face_index_visit(index, node)) {
+        continue;
+      }
+      int32_t score = face_dot(query, &index->embeddings[node]);
+      (*scanned)++;
+      if (results->count < results->capacity || score > results->items[results->count - 1].score) {
+        face_index_list_insert(results, score, node);
+        face_index_list_insert(candidates, score, node);
+      }
+    }
+  }
+}
+
+/**
+ * 选择邻居
+ * 候选按与目标的分数从高到低排列；候选与已选邻居的相似度高于与目标的相似度时跳过，
+ * 使邻居分布在不同方向，不足max个时再用跳过的候选补足
+ */
+static int face_index_select(const FaceIndex *index, const FaceIndexCandidate *candidates, int count, int max,
+                             uint16_t *selected) {
+  uint8_t skipped[FACE_INDEX_EF_MAX];
+  int selectedCount = 0;
+  for (int c = 0; c < count && selectedCount < max; c++) {
+    const FaceEmbedding *embedding = &index->embeddings[candidates[c].node];
+    skipped[c] = 0;
+    for (int s = 0; s < selectedCount; s++) {
+      if (face_dot(embedding, &index->embeddings[selected[s]]) > candidates[c].score) {
+        skipped[c] = 1;
+        break;
+      }
+    }
+    if (!skipped[c]) {
+      selected[selectedCount++] = candidates[c].node;
+    }
+  }
+  for (int c = 0; c < count && selectedCount < max; c++) {
+    if (skipped[c]) {
+      selected[selectedCount++] = candidates[c].node;
+    }
+  }
+  return selectedCount;
+}
+
+static void face_index_set_links(uint16_t *links, int max, const uint16_t *nodes, int count) {
+  for (int i = 0; i < max; i++) {
+    links[i] = i < count ? nodes[i] : FACE_INDEX_NONE;
+  }
+}
+
+/**
+ * 添加反向连接，邻居表已满时与新邻居一起重新选择
+ */
+static void face_index_connect(FaceIndex *index, uint16_t node, uint16_t neighbour, int level) {
+  uint16_t *links = face_index_links(index, node, level);
+  int max = face_index_max_links(level);
+  int count = 0;
+  while (count < max && links[count] != FACE_INDEX_NONE) {
+    count++;
+  }
+  if (count < max) {
+    links[count] = neighbour;
+    return;
+  }
+
+  FaceIndexList *list = &faceIndexCandidates;
+  list->count = 0;
+  list->capacity = max + 1;
+  const FaceEmbedding *embedding = &index->embeddings[node];
+  for (int i = 0; i < max; i++) {
+    face_index_list_insert(list, face_dot(embedding, &index->embeddings[links[i]]), links[i]);
+  }
+  face_index_list_insert(list, face_dot(embedding, &index->embeddings[neighbour]), neighbour);
+
+  uint16_t selected[FACE_INDEX_M0];
+  int selectedCount = face_index_select(index, list->items, list->count, max, selected);
+  face_index_set_links(links, max, selected, selectedCount);
+}
+
+/**
+ * 插入特征
+ * 从入口节点逐层贪心下降到新节点的层号，再在每层搜索候选、选择邻居并建立双向连接
+ * @param index 索引
+ * @param userId 用户ID
+ * @param embedding 特征
+ * @return 是否成功
+ */
+bool face_index_add(FaceIndex *index, uint32_t userId, const FaceEmbedding *embedding) {
+  if (userId == 0 || index->count >= index->capacity) {
+    return false;
+  }
+
+  uint16_t node = (uint16_t)index->count;
+  int level = face_index_random_level(index);
+  if (index->upperCount + level > index->upperCapacity) {
+    level = 0;
+  }
+  index->userIds[node] = userId;
+  index->levels[node] = (uint8_t)level;
+  index->upperOffsets[node] = index->upperCount;
+  index->upperCount += level;
+  index->embeddings[node] = *embedding;
+  for (int l = 0; l <= level; l++) {
+    face_index_set_links(face_index_links(index, node, l), face_index_max_links(l), NULL, 0);
+  }
+  index->count++;
+
+  if (index->entry == FACE_INDEX_NONE) {
+    index->entry = node;
+    index->maxLevel = (uint8_t)level;
+    return true;
+  }
+
+  uint32_t scanned = 0;
+  FaceIndexCandidate current = {face_dot(embedding, &index->embeddings[index->entry]), index->entry};
+  for (int l = index->maxLevel; l > level; l--) {
+    current = face_index_greedy(index, embedding, current, l, &scanned);
+  }
+
+  FaceIndexList *results = &faceIndexResults;
+  results->capacity = FACE_INDEX_EF_CONSTRUCTION;
+  for (int l = level < index->maxLevel ? level : index->maxLevel; l >= 0; l--) {
+    face_index_search_layer(index, embedding, current, l, results, &scanned);
+    uint16_t selected[FACE_INDEX_M];
+    int selectedCount = face_index_select(index, results->items, results->count, FACE_INDEX_M, selected);
+    face_index_set_links(face_index_links(index, node, l), face_index_max_links(l), selected, selectedCount);
+    for (int i = 0; i < selectedCount; i++) {
+      face_index_connect(index, selected[i], node, l);
+    }
+    current = results->items[0];
+  }
+
+  if (level > index->maxLevel) {
+    index->maxLevel = (uint8_t)level;
+    index->entry = node;
+  }
+  return true;
+}
+
+/**
+ * 删除用户的全部特征
+ * @param index 索引
+ * @param userId 用户ID
+ * @return 删除的特征数
+ */
+uint32_t face_index_remove(FaceIndex *index, uint32_t userId) {
+  if (userId == 0) {
+    return 0;
+  }
+  uint32_t removed = 0;
+  for (uint32_t i = 0; i < index->count; i++) {
+    if (index->userIds[i] == userId) {
+      index->userIds[i] = 0;
+      removed++;
+    }
+  }
+  index->deleted += removed;
+  return removed;
+}
+
+/**
+ * 近似最近邻查询
+ * 候选集按相似度降序排列，第一个未删除节点为最高分，其后第一个其他用户的节点为次高分
+ * @param index 索引
+ * @param query 待比对特征
+ * @param ef 候选集大小
+ * @param threshold 点积阈值
+ * @param margin 点积领先幅度
+ * @param match 结果
+ * @return 是否匹配
+ */
+bool face_index_search(FaceIndex *index, const FaceEmbedding *query, int ef, int32_t threshold, int32_t margin,
+                       FaceMatch *match) {
+  match->index = -1;
+  match->userId = 0;
+  match->score = 0;
+  match->runnerUp = INT32_MIN;
+  match->scanned = 0;
+  if (index->entry == FACE_INDEX_NONE) {
+    return false;
+  }
+  if (ef < 1) {
+    ef = 1;
+  } else if (ef > FACE_INDEX_EF_MAX) {
+    ef = FACE_INDEX_EF_MAX;
+  }
+
+  uint32_t scanned = 1;
+  FaceIndexCandidate current = {face_dot(query, &index->embeddings[index->entry]), index->entry};
+  for (int l = index->maxLevel; l > 0; l--) {
+    current = face_index_greedy(index, query, current, l, &scanned);
+  }
+  FaceIndexList *results = &faceIndexResults;
+  results->capacity = ef;
+  face_index_search_layer(index, query, current, 0, results, &scanned);
+  match->scanned = scanned;
+
+  // 已删除节点只作为搜索路径
+  int bestNode = -1;
+  for (int i = 0; i < results->count; i++) {
+    uint16_t node = results->items[i].node;
+    if (index->userIds[node] == 0) {
+      continue;
+    }
+    if (bestNode < 0) {
+      bestNode = node;
+      match->userId = index->userIds[node];
+      match->score = results->items[i].score;
+    } else if (index->userIds[node] != match->userId) {
+      match->runnerUp = results->items[i].score;
+      break;
+    }
+  }
+  if (bestNode < 0) {
+    return false;
+  }
+  match->index = face_match_accept(match, threshold, margin) ? bestNode : -1;
+  return match->index >= 0;
+}
+
+/**
+ * 精确查询
+ * @param index 索引
+ * @param query 待比对特征
+ * @param threshold 点积阈值
+ * @param margin 点积领先幅度
+ * @param match 结果
+ * @return 是否匹配
+ */
+bool face_index_exact(const FaceIndex *index, const FaceEmbedding *query, int32_t threshold, int32_t margin,
+                      FaceMatch *match) {
+  int32_t best = INT32_MIN;
+  int32_t runnerUp = INT32_MIN;
+  int bestIndex = -1;
+  for (uint32_t i = 0; i < index->count; i++) {
+    if (index->userIds[i] == 0) {
+      continue;
+    }
+    int32_t score = face_dot(query, &index->embeddings[i]);
+    if (score > best) {
+      // 最高分换成其他用户时，原最高分即其他用户的最高分
+      if (bestIndex >= 0 && index->userIds[i] != index->userIds[bestIndex]) {
+        runnerUp = best;
+      }
+      best = score;
+      bestIndex = (int)i;
+    } else if (score > runnerUp && index->userIds[i] != index->userIds[bestIndex]) {
+      runnerUp = score;
+    }
+  }
+
+  match->scanned = index->count - index->deleted;
+  match->runnerUp = runnerUp;
+  if (bestIndex < 0) {
+    match->index = -1;
+    match->userId = 0;
+    match->score = 0;
+    return false;
+  }
+  match->userId = index->userIds[bestIndex];
+  match->score = best;
+  match->index = face_match_accept(match, threshold, margin) ? bestIndex : -1;
+  return match->index >= 0;
+}
+
+/**
+ * 由特征库建立索引
+ * @param index 索引
+ * @param gallery 特征库
+ * @return 插入的特征数
+ */
+uint32_t face_index_add_gallery(FaceIndex *index, const FaceGallery *gallery) {
+  uint32_t added = 0;
+  for (uint32_t i = 0; i < gallery->count; i++) {
+    added += face_index_add(index, gallery->userIds[i], &gallery->embeddings[i]);
+  }
+  return added;
+}
+
+static bool face_index_write(FaceIndexWrite write, void *context, const void *data, size_t length) {
+  return length == 0 || write(context, data, length);
+}
+
+static bool face_index_read(FaceIndexRead read, void *context, void *data, size_t length) {
+  return length == 0 || read(context, data, length);
+}
+
+/**
+ * 保存索引
+ * @param index 索引
+ * @param write 写回调
+ * @param context 回调参数
+ * @return 是否成功
+ */
+bool face_index_save(const FaceIndex *index, FaceIndexWrite write, void *context) {
+  FaceIndexHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = FACE_INDEX_MAGIC;
+  header.formatVersion = FACE_INDEX_FORMAT_VERSION;
+  header.dimension = FACE_EMBEDDING_DIM;
+  header.m = FACE_INDEX_M;
+  header.m0 = FACE_INDEX_M0;
+  header.maxLevel = index->maxLevel;
+  header.count = index->count;
+  header.upperCount = index->upperCount;
+  header.entry = index->entry;
+
+  return face_index_write(write, context, &header, sizeof(header)) &&
+         face_index_write(write, context, index->userIds, (size_t)index->count * sizeof(uint32_t)) &&
+         face_index_write(write, context, index->levels, index->count) &&
+         face_index_write(write, context, index->embeddings, (size_t)index->count * sizeof(FaceEmbedding)) &&
+         face_index_write(write, context, index->layer0, (size_t)index->count * FACE_INDEX_M0 * sizeof(uint16_t)) &&
+         face_index_write(write, context, index->upper, (size_t)index->upperCount * FACE_INDEX_M * sizeof(uint16_t));
+}
+
+/**
+ * 检查邻居表中的节点号
+ */
+static bool face_index_check_links(const uint16_t *links, size_t length, uint32_t count) {
+  for (size_t i = 0; i < length; i++) {
+    if (links[i] != FACE_INDEX_NONE && links[i] >= count) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * 载入索引
+ * 上层邻居表序号按层号累加恢复，并检查层号、邻居节点号和入口节点
+ * @param index 索引
+ * @param header 文件头
+ * @param read 读回调
+ * @param context 回调参数
+ * @return 是否成功
+ */
+bool face_index_load(FaceIndex *index, const FaceIndexHeader *header, FaceIndexRead read, void *context) {
+  face_index_clear(index);
+  if (header->magic != FACE_INDEX_MAGIC || header->formatVersion != FACE_INDEX_FORMAT_VERSION ||
+      header->dimension != FACE_EMBEDDING_DIM || header->m != FACE_INDEX_M || header->m0 != FACE_INDEX_M0 ||
+      header->maxLevel > FACE_INDEX_MAX_LEVEL || header->count > index->capacity ||
+      header->upperCount > index->upperCapacity) {
+    return false;
+  }
+
+  uint32_t count = header->count;
+  bool ok = face_index_read(read, context, index->userIds, (size_t)count * sizeof(uint32_t)) &&
+            face_index_read(read, context, index->levels, count) &&
+            face_index_read(read, context, index->embeddings, (size_t)count * sizeof(FaceEmbedding)) &&
+            face_index_read(read, context, index->layer0, (size_t)count * FACE_INDEX_M0 * sizeof(uint16_t)) &&
+            face_index_read(read, context, index->upper, (size_t)header->upperCount * FACE_INDEX_M * sizeof(uint16_t));
+
+  uint32_t offset = 0;
+  uint32_t deleted = 0;
+  for (uint32_t i = 0; ok && i < count; i++) {
+    ok = index->levels[i] <= header->maxLevel;
+    index->upperOffsets[i] = offset;
+    offset += index->levels[i];
+    deleted += index->userIds[i] == 0;
+  }
+  ok = ok && offset == header->upperCount &&
+       face_index_check_links(index->layer0, (size_t)count * FACE_INDEX_M0, count) &&
+       face_index_check_links(index->upper, (size_t)header->upperCount * FACE_INDEX_M, count) &&
+       (count == 0 ? header->entry == FACE_INDEX_NONE
+                   : header->entry < count && index->levels[header->entry] == header->maxLevel);
+  if (!ok) {
+    face_index_clear(index);
+    return false;
+  }
+
+  index->count = count;
+  index->upperCount = header->upperCount;
+  index->deleted = deleted;
+  index->entry = header->entry;
+  index->maxLevel = header->maxLevel;
+  return true;
+}
@@ -0,0 +1,169 @@
+#ifndef FACE_INDEX_H
+#define FACE_INDEX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "modules/face_match.h"
+
+// 人脸特征近似最近邻索引（HNSW分层图）
+// 大规模特征库逐个比对耗时随人数线性增长，图索引只比对搜索路径上的几百个特征；
+// 支持逐个插入（后台登记人脸后增量下发），删除为标记删除。
+// 本文件不依赖Arduino，可在主机上编译测试（tools/bench/face_index_bench.c）
+
+// 上层每个节点的邻居数及第0层邻居数
+#define FACE_INDEX_M   16
+#define FACE_INDEX_M0  32
+
+// 层数上限
+#define FACE_INDEX_MAX_LEVEL  7
+
+// 插入和查询时的候选集大小
+#define FACE_INDEX_EF_CONSTRUCTION  64
+#define FACE_INDEX_EF_SEARCH        32
+#define FACE_INDEX_EF_MAX           128
+
+// 节点数上限（邻居表使用16位节点号）
+#define FACE_INDEX_MAX_NODES  65535
+#define FACE_INDEX_NONE       0xFFFF
+
+// 索引文件（SD卡）
+#define FACE_INDEX_FILE     "/faces.idx"
+#define FACE_INDEX_TMP_FILE "/faces.idx.tmp"
+#define FACE_INDEX_MAGIC    0x58444946  // "FIDX"
+#define FACE_INDEX_FORMAT_VERSION  1
+
+// 索引文件头，之后依次为：
+//   count个uint32用户ID（0表示已删除）、count个uint8层号、count个特征、
+//   count×FACE_INDEX_M0个uint16第0层邻居、upperCount×FACE_INDEX_M个uint16上层邻居
+typedef struct __attribute__((packed)) {
+  uint32_t magic;
+  uint16_t formatVersion;
+  uint16_t dimension;
+  uint8_t m;
+  uint8_t m0;
+  uint8_t maxLevel;
+  uint8_t reserved;
+  uint32_t count;
+  uint32_t upperCount;       // 上层邻居表数量
+  uint16_t entry;            // 入口节点
+  uint16_t reserved2;
+  uint32_t crc32;            // 头之后全部数据的CRC32
+} FaceIndexHeader;
+
+// 索引（各数组由face_index_init在调用方提供的内存中划分）
+typedef struct {
+  uint32_t capacity;
+  uint32_t upperCapacity;    // 上层邻居表数量上限
+  uint32_t count;            // 节点数（含已删除）
+  uint32_t upperCount;
+  uint32_t deleted;          // 已删除节点数
+  uint16_t entry;
+  uint8_t maxLevel;
+  uint16_t visitEpoch;
+  uint32_t random;
+  uint32_t *userIds;
+  uint8_t *levels;
+  uint32_t *upperOffsets;    // 节点第1层邻居表在上层邻居表中的序号，由层号累加得出
+  FaceEmbedding *embeddings;
+  uint16_t *layer0;
+  uint16_t *upper;
+  uint16_t *visited;         // 搜索时的访问标记（不保存）
+} FaceIndex;
+
+// 保存/载入的数据读写回调
+typedef bool (*FaceIndexWrite)(void *context, const void *data, size_t length);
+typedef bool (*FaceIndexRead)(void *context, void *data, size_t length);
+
+/**
+ * 计算索引所需内存
+ * @param capacity 节点数上限
+ * @return 字节数（按16字节对齐分配）
+ */
+size_t face_index_memory_size(uint32_t capacity);
+
+/**
+ * 索引初始化
+ * @param index 索引
+ * @param memory 内存（face_index_memory_size字节，16字节对齐）
+ * @param capacity 节点数上限（不超过FACE_INDEX_MAX_NODES）
+ */
+void face_index_init(FaceIndex *index, void *memory, uint32_t capacity);
+
+/**
+ * 清空索引
+ * @param index 索引
+ */
+void face_index_clear(FaceIndex *index);
+
+/**
+ * 插入特征
+ * @param index 索引
+ * @param userId 用户ID（非0）
+ * @param embedding 特征
+ * @return 是否成功（已满时失败）
+ */
+bool face_index_add(FaceIndex *index, uint32_t userId, const FaceEmbedding *embedding);
+
+/**
+ * 删除用户的全部特征（标记删除，节点仍用于搜索路径）
+ * @param index 索引
+ * @param userId 用户ID
+ * @return 删除的特征数
+ */
+uint32_t face_index_remove(FaceIndex *index, uint32_t userId);
+
+/**
+ * 近似最近邻查询
+ * @param index 索引
+ * @param query 待比对特征
+ * @param ef 候选集大小（越大召回率越高、越慢）
+ * @param threshold 点积阈值
+ * @param margin 点积领先幅度（与候选集中其他用户的最高分比较）
+ * @param match 结果（最佳未删除节点，未达到阈值或领先不足时index为-1）
+ * @return 是否匹配
+ */
+bool face_index_search(FaceIndex *index, const FaceEmbedding *query, int ef, int32_t threshold, int32_t margin,
+                       FaceMatch *match);
+
+/**
+ * 精确查询（逐个比对，用于统计近似查询的召回率）
+ * @param index 索引
+ * @param query 待比对特征
+ * @param threshold 点积阈值
+ * @param margin 点积领先幅度
+ * @param match 结果
+ * @return 是否匹配
+ */
+bool face_index_exact(const FaceIndex *index, const FaceEmbedding *query, int32_t threshold, int32_t margin,
+                      FaceMatch *match);
+
+/**
+ * 由特征库建立索引（旧格式特征库迁移）
+ * @param index 索引
+ * @param gallery 特征库
+ * @return 插入的特征数
+ */
+uint32_t face_index_add_gallery(FaceIndex *index, const FaceGallery *gallery);
+
+/**
+ * 保存索引（头中CRC为0，由调用方按写出的数据计算后回填）
+ * @param index 索引
+ * @param write 写回调
+ * @param context 回调参数
+ * @return 是否成功
+ */
+bool face_index_save(const FaceIndex *index, FaceIndexWrite write, void *context);
+
+/**
+ * 载入索引（文件头由调用方读出，CRC由调用方按读入的数据校验，不一致时应清空索引）
+ * @param index 已初始化的索引
+ * @param header 文件头
+ * @param read 读回调
+ * @param context 回调参数
+ * @return 是否成功（格式、容量或邻居表无效时失败并清空索引）
+ */
+bool face_index_load(FaceIndex *index, const FaceIndexHeader *header, FaceIndexRead read, void *context);
+
+#endif
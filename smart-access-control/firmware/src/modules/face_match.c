@@ -0,0 +1,372 @@
+#include <string.h>
+#include <math.h>
+
+// 头文件包含
+#include "modules/face_match.h"
+
+// 裁剪区域最小边长（像素）
+#define FACE_MIN_BOX_SIZE  16
+
+// 梯度方向范围（无符号方向）
+#define FACE_PI  3.14159265f
+
+// 归一化后的灰度标准差
+#define FACE_NORMALIZED_STDDEV  48
+
+// 对齐：梯度幅值（|gx|+|gy|）低于该值的像素视为噪声不参与计算
+#define FACE_ALIGN_MIN_GRADIENT  24
+// 对齐：引导框最大平移量为边长的1/FACE_ALIGN_MAX_SHIFT_DIV
+#define FACE_ALIGN_MAX_SHIFT_DIV  6
+// 对齐：迭代次数上限（框内的噪声和背景把质心拉向框中心，需迭代收敛）
+#define FACE_ALIGN_PASSES  4
+
+/**
+ * 将人脸区域平移到梯度能量质心处
+ * 人脸轮廓左右、上下大致对称，质心即人脸中心；隔行隔列采样，迭代到不再移动
+ * @param gray 灰度图像
+ * @param width 图像宽度
+ * @param height 图像高度
+ * @param box 人脸区域（原地修改）
+ */
+static void face_align(const uint8_t *gray, int width, int height, FaceBox *box) {
+  const int originX = box->x;
+  const int originY = box->y;
+  const int maxX = box->width / FACE_ALIGN_MAX_SHIFT_DIV;
+  const int maxY = box->height / FACE_ALIGN_MAX_SHIFT_DIV;
+
+  for (int pass = 0; pass < FACE_ALIGN_PASSES; pass++) {
+    int x0 = box->x < 1 ? 1 : box->x;
+    int y0 = box->y < 1 ? 1 : box->y;
+    int x1 = box->x + box->width > width - 1 ? width - 1 : box->x + box->width;
+    int y1 = box->y + box->height > height - 1 ? height - 1 : box->y + box->height;
+
+    int64_t sumX = 0;
+    int64_t sumY = 0;
+    int64_t total = 0;
+    for (int y = y0; y < y1; y += 2) {
+      const uint8_t *line = gray + y * width;
+      for (int x = x0; x < x1; x += 2) {
+        int gx = line[x + 1] - line[x - 1];
+        int gy = line[x + width] - line[x - width];
+        int magnitude = (gx < 0 ? -gx : gx) + (gy < 0 ? -gy : gy);
+        if (magnitude < FACE_ALIGN_MIN_GRADIENT) {
+          continue;
+        }
+        sumX += (int64_t)x * magnitude;
+        sumY += (int64_t)y * magnitude;
+        total += magnitude;
+      }
+    }
+    if (total == 0) {
+      return;
+    }
+
+    int newX = (int)(sumX / total) - box->width / 2;
+    int newY = (int)(sumY / total) - box->height / 2;
+    newX = newX < originX - maxX ? originX - maxX : (newX > originX + maxX ? originX + maxX : newX);
+    newY = newY < originY - maxY ? originY - maxY : (newY > originY + maxY ? originY + maxY : newY);
+    if (newX == box->x && newY == box->y) {
+      return;
+    }
+    box->x = newX;
+    box->y = newY;
+  }
+}
+
+/**
+ * 计算引导框
+ * @param width 画面宽度
+ * @param height 画面高度
+ * @param box 人脸区域
+ */
+void face_guide_box(int width, int height, FaceBox *box) {
+  box->width = width / FACE_GUIDE_WIDTH_DIV;
+  box->height = height * FACE_GUIDE_HEIGHT_NUM / FACE_GUIDE_HEIGHT_DEN;
+  box->x = (width - box->width) / 2;
+  box->y = (height - box->height) / 2;
+}
+
+/**
+ * 裁剪并归一化人脸区域
+ * @param gray 灰度图像
+ * @param width 图像宽度
+ * @param height 图像高度
+ * @param box 人脸区域
+ * @param crop 输出（FACE_CROP_SIZE²字节）
+ * @return 是否有效
+ */
+bool face_crop(const uint8_t *gray, int width, int height, const FaceBox *box, uint8_t *crop) {
+  FaceBox aligned = *box;
+  face_align(gray, width, height, &aligned);
+
+  int x0 = aligned.x < 0 ? 0 : aligned.x;
+  int y0 = aligned.y < 0 ? 0 : aligned.y;
+  int x1 = aligned.x + aligned.width > width ? width : aligned.x + aligned.width;
+  int y1 = aligned.y + aligned.height > height ? height : aligned.y + aligned.height;
+  if (x1 - x0 < FACE_MIN_BOX_SIZE || y1 - y0 < FACE_MIN_BOX_SIZE) {
+    return false;
+  }
+
+  // 区域平均缩放：每个目标像素取对应源区域的均值（同时抑制传感器噪声）
+  int boxWidth = x1 - x0;
+  int boxHeight = y1 - y0;
+  uint32_t sum = 0;
+  uint32_t sumSquares = 0;
+  for (int y = 0; y < FACE_CROP_SIZE; y++) {
+    int top = y0 + y * boxHeight / FACE_CROP_SIZE;
+    int bottom = y0 + (y + 1) * boxHeight / FACE_CROP_SIZE;
+    if (bottom <= top) {
+      bottom = top + 1;
+    }
+    for (int x = 0; x < FACE_CROP_SIZE; x++) {
+      int left = x0 + x * boxWidth / FACE_CROP_SIZE;
+      int right = x0 + (x + 1) * boxWidth / FACE_CROP_SIZE;
+      if (right <= left) {
+        right = left + 1;
+      }
+      uint32_t area = 0;
+      for (int row = top; row < bottom; row++) {
+        const uint8_t *line = gray + row * width;
+        for (int column = left; column < right; column++) {
+          area += line[column];
+        }
+      }
+      uint32_t count = (uint32_t)((bottom - top) * (right - left));
+      uint8_t value = (uint8_t)((area + count / 2) / count);
+      crop[y * FACE_CROP_SIZE + x] = value;
+      sum += value;
+      sumSquares += value * value;
+    }
+  }
+
+  // 对比度拉伸：均值128，标准差FACE_NORMALIZED_STDDEV
+  const uint32_t pixels = FACE_CROP_SIZE * FACE_CROP_SIZE;
+  int32_t mean = sum / pixels;
+  int32_t variance = (int32_t)(sumSquares / pixels) - mean * mean;
+  if (variance < FACE_MIN_CONTRAST * FACE_MIN_CONTRAST) {
+    return false;
+  }
+  int32_t gain = (int32_t)((FACE_NORMALIZED_STDDEV << 16) / sqrtf((float)variance));
+  for (uint32_t i = 0; i < pixels; i++) {
+    int32_t value = 128 + (((crop[i] - mean) * gain) >> 16);
+    crop[i] = value < 0 ? 0 : (value > 255 ? 255 : value);
+  }
+  return true;
+}
+
+/**
+ * 计算特征（梯度方向直方图）
+ * 每个像素的梯度按无符号方向（0~180°）分到FACE_BINS个方向，幅值按位置双线性分摊到相邻单元，
+ * 降低残余平移的影响。幅值开方压缩后减去均值使不同人脸的特征近似正交，最后L2归一化并量化
+ * @param crop 归一化人脸图像
+ * @param embedding 特征
+ */
+void face_embed(const uint8_t *crop, FaceEmbedding *embedding) {
+  float histogram[FACE_EMBEDDING_DIM];
+  memset(histogram, 0, sizeof(histogram));
+
+  for (int y = 0; y < FACE_CROP_SIZE; y++) {
+    int up = y > 0 ? y - 1 : y;
+    int down = y < FACE_CROP_SIZE - 1 ? y + 1 : y;
+    // 像素中心相对单元中心的位置
+    float cy = (y + 0.5f) / FACE_CELL_SIZE - 0.5f;
+    int cell0y = (int)floorf(cy);
+    float wy = cy - cell0y;
+    for (int x = 0; x < FACE_CROP_SIZE; x++) {
+      int left = x > 0 ? x - 1 : x;
+      int right = x < FACE_CROP_SIZE - 1 ? x + 1 : x;
+      int gx = crop[y * FACE_CROP_SIZE + right] - crop[y * FACE_CROP_SIZE + left];
+      int gy = crop[down * FACE_CROP_SIZE + x] - crop[up * FACE_CROP_SIZE + x];
+      if (gx == 0 && gy == 0) {
+        continue;
+      }
+
+      float angle = atan2f((float)gy, (float)gx);
+      if (angle < 0) {
+        angle += FACE_PI;
+      }
+      int bin = (int)(angle * FACE_BINS / FACE_PI);
+      if (bin >= FACE_BINS) {
+        bin = 0;
+      }
+      float magnitude = sqrtf((float)(gx * gx + gy * gy));
+
+      float cx = (x + 0.5f) / FACE_CELL_SIZE - 0.5f;
+      int cell0x = (int)floorf(cx);
+      float wx = cx - cell0x;
+      for (int j = 0; j < 2; j++) {
+        int cellY = cell0y + j;
+        if (cellY < 0 || cellY >= FACE_CELLS) {
+          continue;
+        }
+        for (int i = 0; i < 2; i++) {
+          int cellX = cell0x + i;
+          if (cellX < 0 || cellX >= FACE_CELLS) {
+            continue;
+          }
+          float weight = (i ? wx : 1 - wx) * (j ? wy : 1 - wy);
+          histogram[(cellY * FACE_CELLS + cellX) * FACE_BINS + bin] += magnitude * weight;
+        }
+      }
+    }
+  }
+
+  // 幅值开方压缩，避免人脸轮廓等强边缘淹没五官细节；再求均值
+  float mean = 0;
+  for (int i = 0; i < FACE_EMBEDDING_DIM; i++) {
+    histogram[i] = sqrtf(histogram[i]);
+    mean += histogram[i];
+  }
+
+  // 去均值后L2归一化并量化
+  mean /= FACE_EMBEDDING_DIM;
+  float norm = 0;
+  for (int i = 0; i < FACE_EMBEDDING_DIM; i++) {
+    histogram[i] -= mean;
+    norm += histogram[i] * histogram[i];
+  }
+  float scale = norm > 0 ? FACE_SCALE / sqrtf(norm) : 0;
+  for (int i = 0; i < FACE_EMBEDDING_DIM; i++) {
+    embedding->values[i] = (int8_t)lrintf(histogram[i] * scale);
+  }
+}
+
+/**
+ * int8点积
+ * 固定长度、16字节对齐的单累加器循环：主机编译器（-O2起）向量化为SIMD乘加，
+ * ESP32上编译为顺序乘加
+ * @param a 特征
+ * @param b 特征
+ * @return 点积
+ */
+int32_t face_dot(const FaceEmbedding *a, const FaceEmbedding *b) {
+  const int8_t *x = (const int8_t *)__builtin_assume_aligned(a->values, 16);
+  const int8_t *y = (const int8_t *)__builtin_assume_aligned(b->values, 16);
+  int32_t sum = 0;
+  for (int i = 0; i < FACE_EMBEDDING_DIM; i++) {
+    sum += x[i] * y[i];
+  }
+  return sum;
+}
+
+/**
+ * 余弦相似度阈值（或领先幅度）换算为点积
+ * @param permille 余弦相似度（千分比）
+ * @return 点积阈值
+ */
+int32_t face_threshold(uint32_t permille) {
+  return (int32_t)(permille * FACE_SCALE * FACE_SCALE / 1000);
+}
+
+/**
+ * 特征库初始化
+ * @param gallery 特征库
+ * @param userIds 用户ID存储
+ * @param embeddings 特征存储
+ * @param capacity 容量
+ */
+void face_gallery_init(FaceGallery *gallery, uint32_t *userIds, FaceEmbedding *embeddings, uint32_t capacity) {
+  gallery->count = 0;
+  gallery->capacity = capacity;
+  gallery->userIds = userIds;
+  gallery->embeddings = embeddings;
+}
+
+/**
+ * 添加特征
+ * @param gallery 特征库
+ * @param userId 用户ID
+ * @param embedding 特征
+ * @return 是否成功
+ */
+bool face_gallery_add(FaceGallery *gallery, uint32_t userId, const FaceEmbedding *embedding) {
+  if (gallery->count >= gallery->capacity) {
+    return false;
+  }
+
+  gallery->userIds[gallery->count] = userId;
+  gallery->embeddings[gallery->count] = *embedding;
+  gallery->count++;
+  return true;
+}
+
+/**
+ * 判断最高分是否可以接受
+ * @param match 比对结果
+ * @param threshold 点积阈值
+ * @param margin 点积领先幅度
+ * @return 是否接受
+ */
+bool face_match_accept(const FaceMatch *match, int32_t threshold, int32_t margin) {
+  if (match->score < threshold) {
+    return false;
+  }
+  return match->runnerUp == INT32_MIN || (int64_t)match->score - match->runnerUp >= margin;
+}
+
+/**
+ * 比对
+ * 同一用户可登记多个特征，领先幅度只与其他用户比较
+ * @param gallery 特征库
+ * @param query 待比对特征
+ * @param threshold 点积阈值
+ * @param margin 点积领先幅度
+ * @param match 结果
+ * @return 是否匹配
+ */
+bool face_gallery_match(const FaceGallery *gallery, const FaceEmbedding *query, int32_t threshold, int32_t margin,
+                        FaceMatch *match) {
+  int32_t best = INT32_MIN;
+  int32_t runnerUp = INT32_MIN;
+  uint32_t bestIndex = 0;
+  for (uint32_t i = 0; i < gallery->count; i++) {
+    int32_t score = face_dot(query, &gallery->embeddings[i]);
+    if (score > best) {
+      // 最高分换成其他用户时，原最高分即其他用户的最高分
+      if (best != INT32_MIN && gallery->userIds[i] != gallery->userIds[bestIndex]) {
+        runnerUp = best;
+      }
+      best = score;
+      bestIndex = i;
+    } else if (score > runnerUp && gallery->userIds[i] != gallery->userIds[bestIndex]) {
+      runnerUp = score;
+    }
+  }
+
+  match->userId = gallery->count ? gallery->userIds[bestIndex] : 0;
+  match->score = gallery->count ? best : 0;
+  match->runnerUp = runnerUp;
+  match->scanned = gallery->count;
+  match->index = gallery->count && face_match_accept(match, threshold, margin) ? (int)bestIndex : -1;
+  return match->index >= 0;
+}
+
+/**
+ * 解析特征库文件
+ * @param data 文件内容（16字节对齐）
+ * @param size 长度
+ * @param gallery 特征库
+ * @return 是否有效
+ */
+bool face_gallery_parse(uint8_t *data, size_t size, FaceGallery *gallery) {
+  if (size < sizeof(FaceGalleryHeader) || ((uintptr_t)data & 15) != 0) {
+    return false;
+  }
+
+  const FaceGalleryHeader *header = (const FaceGalleryHeader *)data;
+  if (header->magic != FACE_GALLERY_MAGIC || header->formatVersion != FACE_GALLERY_FORMAT_VERSION ||
+      header->dimension != FACE_EMBEDDING_DIM) {
+    return false;
+  }
+
+  size_t offset = FACE_GALLERY_EMBEDDINGS_OFFSET(header->count);
+  if (header->count > (size - sizeof(FaceGalleryHeader)) / (sizeof(FaceEmbedding) + 4) ||
+      offset + (size_t)header->count * sizeof(FaceEmbedding) != size) {
+    return false;
+  }
+
+  face_gallery_init(gallery, (uint32_t *)(data + sizeof(FaceGalleryHeader)), (FaceEmbedding *)(data + offset),
+                    header->count);
+  gallery->count = header->count;
+  return true;
+}
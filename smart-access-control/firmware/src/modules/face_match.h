@@ -0,0 +1,177 @@
+#ifndef FACE_MATCH_H
+#define FACE_MATCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// 人脸比对：灰度人脸区域裁剪归一化 → 紧凑int8特征 → 与已登记特征做点积比对
+// 本文件不依赖Arduino，可在主机上编译测试（tools/bench/face_bench.c）
+
+// 裁剪后的人脸图像边长（像素）
+#define FACE_CROP_SIZE  32
+
+// 特征：4×4个8×8像素单元，每个单元8个梯度方向，共128维，L2归一化后量化为int8
+#define FACE_CELLS       4
+#define FACE_CELL_SIZE   (FACE_CROP_SIZE / FACE_CELLS)
+#define FACE_BINS        8
+#define FACE_EMBEDDING_DIM  (FACE_CELLS * FACE_CELLS * FACE_BINS)
+
+// 量化比例：归一化特征乘以该值，两个特征的点积约为 余弦相似度 × FACE_SCALE²
+#define FACE_SCALE  127
+
+// 人脸区域灰度标准差下限，低于该值视为无人脸（空画面或遮挡）
+#define FACE_MIN_CONTRAST  12
+
+// 默认匹配阈值与领先幅度（余弦相似度，千分比）
+// 梯度直方图特征非负，不同人之间的相似度也在0.8以上，只靠阈值无法区分；最高分还须高出其他用户的最高分
+// 取值来自 face_bench 的误识率/拒识率曲线：误识率不超过1%的最低阈值再留一档余量
+#define FACE_DEFAULT_THRESHOLD_PERMILLE  950
+#define FACE_DEFAULT_MARGIN_PERMILLE     30
+
+// 引导框：画面中央，宽为画面宽度的1/2，高为画面高度的2/3
+#define FACE_GUIDE_WIDTH_DIV   2
+#define FACE_GUIDE_HEIGHT_NUM  2
+#define FACE_GUIDE_HEIGHT_DEN  3
+
+// 特征库文件（SD卡）
+#define FACE_GALLERY_FILE   "/faces.bin"
+#define FACE_GALLERY_MAGIC  0x45434146  // "FACE"
+#define FACE_GALLERY_FORMAT_VERSION  1
+
+// 人脸区域
+typedef struct {
+  int x;
+  int y;
+  int width;
+  int height;
+} FaceBox;
+
+// 特征（16字节对齐，便于向量化读取）
+typedef struct {
+  int8_t values[FACE_EMBEDDING_DIM];
+} __attribute__((aligned(16))) FaceEmbedding;
+
+// 特征库文件头，之后为count个uint32用户ID（补齐到16字节）及count个特征
+typedef struct __attribute__((packed)) {
+  uint32_t magic;
+  uint16_t formatVersion;
+  uint16_t dimension;
+  uint32_t count;
+  uint32_t crc32;            // 头之后全部数据的CRC32
+} FaceGalleryHeader;
+
+// 特征区偏移
+#define FACE_GALLERY_EMBEDDINGS_OFFSET(count)  (sizeof(FaceGalleryHeader) + (((count) * 4 + 15) & ~(size_t)15))
+
+// 特征库（特征连续存放，顺序扫描）
+typedef struct {
+  uint32_t count;
+  uint32_t capacity;
+  uint32_t *userIds;
+  FaceEmbedding *embeddings;
+} FaceGallery;
+
+// 比对结果
+typedef struct {
+  int index;                 // 特征库下标，-1表示未匹配
+  uint32_t userId;           // 最高分的用户（未匹配时也给出）
+  int32_t score;             // 最高点积
+  int32_t runnerUp;          // 其他用户的最高点积，无其他用户时为INT32_MIN
+  uint32_t scanned;          // 比对次数
+} FaceMatch;
+
+/**
+ * 计算引导框（用户按屏幕提示将人脸置于画面中央）
+ * @param width 画面宽度
+ * @param height 画面高度
+ * @param box 人脸区域
+ */
+void face_guide_box(int width, int height, FaceBox *box);
+
+/**
+ * 裁剪并归一化人脸区域
+ * 先将区域平移到框内梯度能量质心（补偿人脸在引导框内的偏移），
+ * 区域平均缩放到FACE_CROP_SIZE×FACE_CROP_SIZE，再按均值和标准差拉伸对比度
+ * @param gray 灰度图像
+ * @param width 图像宽度
+ * @param height 图像高度
+ * @param box 人脸区域（超出图像部分截断）
+ * @param crop 输出（FACE_CROP_SIZE²字节）
+ * @return 是否有效（区域过小或对比度不足时返回false）
+ */
+bool face_crop(const uint8_t *gray, int width, int height, const FaceBox *box, uint8_t *crop);
+
+/**
+ * 计算特征（梯度方向直方图）
+ * @param crop 归一化人脸图像
+ * @param embedding 特征
+ */
+void face_embed(const uint8_t *crop, FaceEmbedding *embedding);
+
+/**
+ * int8点积
+ * @param a 特征
+ * @param b 特征
+ * @return 点积
+ */
+int32_t face_dot(const FaceEmbedding *a, const FaceEmbedding *b);
+
+/**
+ * 余弦相似度阈值（或领先幅度）换算为点积
+ * @param permille 余弦相似度（千分比）
+ * @return 点积阈值
+ */
+int32_t face_threshold(uint32_t permille);
+
+/**
+ * 特征库初始化
+ * @param gallery 特征库
+ * @param userIds 用户ID存储
+ * @param embeddings 特征存储
+ * @param capacity 容量
+ */
+void face_gallery_init(FaceGallery *gallery, uint32_t *userIds, FaceEmbedding *embeddings, uint32_t capacity);
+
+/**
+ * 添加特征
+ * @param gallery 特征库
+ * @param userId 用户ID
+ * @param embedding 特征
+ * @return 是否成功（已满时失败）
+ */
+bool face_gallery_add(FaceGallery *gallery, uint32_t userId, const FaceEmbedding *embedding);
+
+/**
+ * 判断最高分是否可以接受
+ * @param match 比对结果（score、runnerUp）
+ * @param threshold 点积阈值
+ * @param margin 领先其他用户最高分的点积幅度
+ * @return 是否接受
+ */
+bool face_match_accept(const FaceMatch *match, int32_t threshold, int32_t margin);
+
+/**
+ * 比对
+ * 全量扫描取最高分；最高分达到阈值且领先其他用户的最高分至少margin时匹配，否则index为-1
+ * @param gallery 特征库
+ * @param query 待比对特征
+ * @param threshold 点积阈值
+ * @param margin 点积领先幅度
+ * @param match 结果
+ * @return 是否匹配
+ */
+bool face_gallery_match(const FaceGallery *gallery, const FaceEmbedding *query, int32_t threshold, int32_t margin,
+                        FaceMatch *match);
+
+/**
+ * 解析特征库文件（CRC由加载方用user_db_crc32校验）
+ * 用户ID和特征直接引用文件数据，不复制（容量等于数量）
+ * @param data 文件内容（16字节对齐）
+ * @param size 长度
+ * @param gallery 特征库
+ * @return 是否有效
+ */
+bool face_gallery_parse(uint8_t *data, size_t size, FaceGallery *gallery);
+
+#endif
@@ -0,0 +1,250 @@
+#include <Arduino.h>
+#include <PubSubClient.h>
+#include <ArduinoJson.h>
+#include <SD.h>
+#include <mbedtls/base64.h>
+
+// 头文件包含
+#include "modules/face_sync.h"
+#include "modules/face_match.h"
+#include "modules/identity.h"
+#include "modules/user_db.h"
+#include "modules/storage.h"
+#include "modules/communication.h"
+
+// 变更记录（队列和增量日志共用）
+#define FACE_SYNC_RECORD_MAGIC  0x43595346  // "FSYC"
+#define FACE_SYNC_OP_ADD        1
+#define FACE_SYNC_OP_DELETE     2
+
+typedef struct __attribute__((packed)) {
+  uint32_t magic;
+  uint8_t op;
+  uint8_t reserved[3];
+  uint32_t userId;
+  uint32_t methodId;      // access_methods记录ID（上报用）
+  int8_t embedding[FACE_EMBEDDING_DIM];
+  uint32_t crc32;         // 之前全部字段的CRC32
+} FaceSyncRecord;
+
+// MQTT客户端
+PubSubClient *faceSyncClient = NULL;
+char faceSyncDeviceId[64] = "";
+
+// 变更队列（MQTT回调写入，访问控制任务读取）
+QueueHandle_t faceSyncQueue = NULL;
+
+// 增量日志条数
+uint32_t faceSyncJournalEntries = 0;
+
+static const char *face_sync_op_name(uint8_t op) {
+  return op == FACE_SYNC_OP_ADD ? "add" : "delete";
+}
+
+static uint32_t face_sync_record_crc(const FaceSyncRecord *record) {
+  return user_db_crc32(0, (const uint8_t *)record, offsetof(FaceSyncRecord, crc32));
+}
+
+/**
+ * 应用一条变更
+ * @return 是否成功
+ */
+static bool face_sync_apply(const FaceSyncRecord *record) {
+  if (record->op == FACE_SYNC_OP_DELETE) {
+    identity_remove_faces(record->userId);
+    return true;
+  }
+  FaceEmbedding embedding;
+  memcpy(embedding.values, record->embedding, sizeof(embedding.values));
+  return identity_add_face(record->userId, &embedding);
+}
+
+/**
+ * 重写索引文件并清空日志
+ */
+static void face_sync_compact() {
+  if (identity_save_faces()) {
+    SD.remove(FACE_SYNC_JOURNAL_FILE);
+    faceSyncJournalEntries = 0;
+  }
+}
+
+/**
+ * 追加日志，写入失败或达到条数上限时重写索引文件
+ */
+static void face_sync_append_journal(const FaceSyncRecord *record) {
+  if (!storage_is_initialized()) {
+    return;
+  }
+
+  File file = SD.open(FACE_SYNC_JOURNAL_FILE, FILE_APPEND);
+  bool ok = file && file.write((const uint8_t *)record, sizeof(*record)) == sizeof(*record);
+  if (file) {
+    file.close();
+  }
+  faceSyncJournalEntries++;
+
+  // 写入失败留下的残缺记录由重写覆盖
+  if (!ok || faceSyncJournalEntries >= FACE_SYNC_JOURNAL_MAX_ENTRIES) {
+    face_sync_compact();
+  }
+}
+
+/**
+ * 重放增量日志
+ * @return 日志是否需要重写（存在残缺记录）
+ */
+static bool face_sync_replay_journal() {
+  File file = SD.open(FACE_SYNC_JOURNAL_FILE, FILE_READ);
+  if (!file) {
+    return false;
+  }
+
+  bool rewrite = false;
+  while (file.available()) {
+    FaceSyncRecord record;
+    if (file.read((uint8_t *)&record, sizeof(record)) != sizeof(record) ||
+        record.magic != FACE_SYNC_RECORD_MAGIC || record.crc32 != face_sync_record_crc(&record)) {
+      // 掉电造成的残缺记录，丢弃其后全部内容
+      rewrite = true;
+      break;
+    }
+    face_sync_apply(&record);
+    faceSyncJournalEntries++;
+  }
+  file.close();
+
+  Serial.printf("人脸特征日志重放: 记录=%u\n", faceSyncJournalEntries);
+  return rewrite;
+}
+
+/**
+ * 上报结果
+ */
+static void face_sync_report(const FaceSyncRecord *record, bool ok) {
+  uint32_t count, queries, recallSamples, recallHits;
+  identity_get_face_stats(&count, &queries, &recallSamples, &recallHits);
+  Serial.printf("人脸特征%s: 用户%u %s（共%u个）\n", face_sync_op_name(record->op), record->userId,
+                ok ? "成功" : "失败", count);
+
+  if (!faceSyncClient) {
+    return;
+  }
+
+  StaticJsonDocument<256> doc;
+  doc["device_id"] = faceSyncDeviceId;
+  doc["op"] = face_sync_op_name(record->op);
+  doc["user_id"] = record->userId;
+  if (record->methodId) {
+    doc["method_id"] = record->methodId;
+  }
+  doc["result"] = ok ? "ok" : "failed";
+  doc["face_count"] = count;
+
+  char payload[256];
+  size_t length = serializeJson(doc, payload, sizeof(payload));
+  communication_lock();
+  if (faceSyncClient->connected()) {
+    faceSyncClient->publish(FACE_SYNC_TOPIC_REPORT, (const uint8_t *)payload, length);
+  }
+  communication_unlock();
+}
+
+/**
+ * 解析Base64特征（每个分量一个字节，补码）
+ */
+static bool face_sync_parse_embedding(const char *text, int8_t *values) {
+  size_t length = 0;
+  return mbedtls_base64_decode((unsigned char *)values, FACE_EMBEDDING_DIM, &length, (const unsigned char *)text,
+                               strlen(text)) == 0 &&
+         length == FACE_EMBEDDING_DIM;
+}
+
+/**
+ * 人脸特征同步初始化
+ */
+void face_sync_init() {
+  faceSyncQueue = xQueueCreate(FACE_SYNC_QUEUE_LENGTH, sizeof(FaceSyncRecord));
+
+  if (storage_is_initialized() && face_sync_replay_journal()) {
+    face_sync_compact();
+  }
+  Serial.println("人脸特征同步初始化完成");
+}
+
+/**
+ * 订阅人脸特征同步主题
+ * @param client MQTT客户端
+ * @param deviceId 设备ID
+ */
+void face_sync_subscribe(PubSubClient *client, const char *deviceId) {
+  faceSyncClient = client;
+  strncpy(faceSyncDeviceId, deviceId, sizeof(faceSyncDeviceId) - 1);
+  client->subscribe(FACE_SYNC_TOPIC_DELTA);
+}
+
+/**
+ * 处理人脸特征同步消息
+ * @param topic 主题
+ * @param payload 负载
+ * @param length 长度
+ * @return 是否为人脸特征同步消息
+ */
+bool face_sync_handle_message(const char *topic, byte *payload, unsigned int length) {
+  if (strcmp(topic, FACE_SYNC_TOPIC_DELTA) != 0) {
+    return false;
+  }
+
+  StaticJsonDocument<512> doc;
+  DeserializationError error = deserializeJson(doc, payload, length);
+  if (error) {
+    Serial.printf("人脸特征同步消息解析错误: %s\n", error.c_str());
+    return true;
+  }
+
+  FaceSyncRecord record;
+  memset(&record, 0, sizeof(record));
+  record.magic = FACE_SYNC_RECORD_MAGIC;
+  record.userId = doc["user_id"] | 0;
+  record.methodId = doc["method_id"] | 0;
+  const char *op = doc["op"] | "";
+  if (strcmp(op, "add") == 0) {
+    record.op = FACE_SYNC_OP_ADD;
+    if (!face_sync_parse_embedding(doc["embedding"] | "", record.embedding)) {
+      Serial.printf("人脸特征格式错误: 用户%u\n", record.userId);
+      return true;
+    }
+  } else if (strcmp(op, "delete") == 0) {
+    record.op = FACE_SYNC_OP_DELETE;
+  } else {
+    Serial.printf("未知人脸特征操作: %s\n", op);
+    return true;
+  }
+  if (record.userId == 0) {
+    Serial.println("人脸特征同步消息缺少用户ID");
+    return true;
+  }
+  record.crc32 = face_sync_record_crc(&record);
+
+  if (!faceSyncQueue || xQueueSend(faceSyncQueue, &record, 0) != pdTRUE) {
+    Serial.println("人脸特征同步队列已满");
+  }
+  return true;
+}
+
+/**
+ * 应用排队的变更
+ * 每次只应用一条（插入需要一次图搜索），不影响识别响应
+ */
+void face_sync_poll() {
+  FaceSyncRecord record;
+  if (!faceSyncQueue || xQueueReceive(faceSyncQueue, &record, 0) != pdTRUE) {
+    return;
+  }
+
+  bool ok = face_sync_apply(&record);
+  if (ok) {
+    face_sync_append_journal(&record);
+  }
+  face_sync_report(&record, ok);
+}
@@ -0,0 +1,53 @@
+#ifndef FACE_SYNC_H
+#define FACE_SYNC_H
+
+#include <Arduino.h>
+#include <PubSubClient.h>
+
+// 人脸特征增量同步
+// 后台在access_methods中登记人脸（method_type = face，method_value为128字节int8特征的Base64）后广播：
+//   {"op": "add", "user_id": 7, "method_id": 12, "embedding": "<172个Base64字符>"}
+//   {"op": "delete", "user_id": 7}      删除用户的全部人脸特征
+#define FACE_SYNC_TOPIC_DELTA   "access-control/face/delta"
+// 设备上报结果：{"device_id", "op", "user_id", "method_id", "result", "face_count"}
+#define FACE_SYNC_TOPIC_REPORT  "access-control/face/report"
+
+// 增量日志（索引文件之后的变更，启动时重放）
+#define FACE_SYNC_JOURNAL_FILE  "/faces.journal"
+
+// 日志条数达到该值时重写索引文件并清空日志
+#define FACE_SYNC_JOURNAL_MAX_ENTRIES  256
+
+// 待处理变更数量上限
+#define FACE_SYNC_QUEUE_LENGTH  16
+
+/**
+ * 人脸特征同步初始化
+ * 重放SD卡上的增量日志，须在存储和身份识别模块之后调用
+ */
+void face_sync_init();
+
+/**
+ * 订阅人脸特征同步主题
+ * MQTT连接成功后调用
+ * @param client MQTT客户端
+ * @param deviceId 设备ID
+ */
+void face_sync_subscribe(PubSubClient *client, const char *deviceId);
+
+/**
+ * 处理人脸特征同步消息（MQTT回调中调用，只入队不访问索引）
+ * @param topic 主题
+ * @param payload 负载
+ * @param length 长度
+ * @return 是否为人脸特征同步消息
+ */
+bool face_sync_handle_message(const char *topic, byte *payload, unsigned int length);
+
+/**
+ * 应用排队的变更
+ * 在访问控制任务中调用（与人脸识别同一任务，索引无需加锁）
+ */
+void face_sync_poll();
+
+#endif
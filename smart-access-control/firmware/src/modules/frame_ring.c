@@ -0,0 +1,223 @@
+#include <string.h>
+
+// 头文件包含
+#include "modules/frame_ring.h"
+
+/**
+ * 释放一个引用，引用全部释放后归还帧缓冲区
+ */
+static void frame_ring_unref(FrameRing *ring, int slot) {
+  FrameSlot *s = &ring->slots[slot];
+  if (--s->refs == 0) {
+    ring->release(s->frame);
+    s->frame = NULL;
+    ring->stats.slotsInUse--;
+  }
+}
+
+/**
+ * 环形窗口中最旧或最新的帧槽
+ */
+static int frame_ring_live_slot(const FrameRing *ring, bool newest) {
+  int found = FRAME_RING_NONE;
+  for (int i = 0; i < ring->slotCount; i++) {
+    const FrameSlot *s = &ring->slots[i];
+    if (s->frame && s->live &&
+        (found == FRAME_RING_NONE ||
+         (newest ? s->sequence > ring->slots[found].sequence : s->sequence < ring->slots[found].sequence))) {
+      found = i;
+    }
+  }
+  return found;
+}
+
+/**
+ * 采集中的事件计入一帧（slot为FRAME_RING_NONE表示该帧被丢弃）
+ */
+static void frame_ring_collect(FrameRing *ring, int slot) {
+  for (int i = 0; i < FRAME_RING_MAX_EVENTS; i++) {
+    FrameEvent *event = &ring->events[i];
+    if (event->state != FRAME_EVENT_COLLECTING) {
+      continue;
+    }
+    if (slot == FRAME_RING_NONE) {
+      event->dropped++;
+    } else {
+      ring->slots[slot].refs++;
+      event->slots[event->count++] = slot;
+    }
+    if (--event->postRemaining == 0) {
+      event->state = FRAME_EVENT_READY;
+    }
+  }
+}
+
+/**
+ * 环形缓冲区初始化
+ * @param ring 环形缓冲区
+ * @param slotCount 帧槽数（不超过FRAME_RING_MAX_SLOTS）
+ * @param release 帧缓冲区归还回调
+ */
+void frame_ring_init(FrameRing *ring, uint8_t slotCount, FrameRingRelease release) {
+  memset(ring, 0, sizeof(*ring));
+  ring->slotCount = slotCount < FRAME_RING_MAX_SLOTS ? slotCount : FRAME_RING_MAX_SLOTS;
+  ring->release = release;
+}
+
+/**
+ * 加入新帧
+ * @param ring 环形缓冲区
+ * @param frame 帧缓冲区
+ * @param timestamp 采集时间(ms)
+ * @return 是否接收
+ */
+bool frame_ring_push(FrameRing *ring, void *frame, uint32_t timestamp) {
+  int slot = FRAME_RING_NONE;
+  for (int i = 0; i < ring->slotCount && slot == FRAME_RING_NONE; i++) {
+    if (!ring->slots[i].frame) {
+      slot = i;
+    }
+  }
+
+  // 窗口已满时最旧的帧移出窗口；它仍被事件引用而又没有空槽时丢弃新帧，保留窗口
+  if (ring->liveCount >= FRAME_RING_PRE_FRAMES) {
+    int oldest = frame_ring_live_slot(ring, false);
+    if (slot != FRAME_RING_NONE || ring->slots[oldest].refs == 1) {
+      ring->slots[oldest].live = false;
+      ring->liveCount--;
+      frame_ring_unref(ring, oldest);
+      if (slot == FRAME_RING_NONE) {
+        slot = oldest;
+      }
+    }
+  }
+
+  if (slot == FRAME_RING_NONE) {
+    ring->stats.dropped++;
+    frame_ring_collect(ring, FRAME_RING_NONE);
+    return false;
+  }
+
+  FrameSlot *s = &ring->slots[slot];
+  s->frame = frame;
+  s->sequence = ++ring->sequence;
+  s->timestamp = timestamp;
+  s->refs = 1;
+  s->live = true;
+  ring->liveCount++;
+  ring->stats.captured++;
+  if (++ring->stats.slotsInUse > ring->stats.slotsPeak) {
+    ring->stats.slotsPeak = ring->stats.slotsInUse;
+  }
+
+  frame_ring_collect(ring, slot);
+  return true;
+}
+
+/**
+ * 冻结事件
+ * @param ring 环形缓冲区
+ * @param type 事件类型
+ * @param timestamp 触发时间(ms)
+ * @return 事件序号，事件槽已满时为FRAME_RING_NONE
+ */
+int frame_ring_freeze(FrameRing *ring, uint8_t type, uint32_t timestamp) {
+  int index = FRAME_RING_NONE;
+  for (int i = 0; i < FRAME_RING_MAX_EVENTS && index == FRAME_RING_NONE; i++) {
+    if (ring->events[i].state == FRAME_EVENT_FREE) {
+      index = i;
+    }
+  }
+  if (index == FRAME_RING_NONE) {
+    ring->stats.eventsDropped++;
+    return FRAME_RING_NONE;
+  }
+
+  FrameEvent *event = &ring->events[index];
+  memset(event, 0, sizeof(*event));
+  event->type = type;
+  event->id = ++ring->eventId;
+  event->timestamp = timestamp;
+
+  // 按帧序号从旧到新引用窗口中的帧
+  uint32_t after = 0;
+  for (int n = 0; n < ring->liveCount; n++) {
+    int next = FRAME_RING_NONE;
+    for (int i = 0; i < ring->slotCount; i++) {
+      const FrameSlot *s = &ring->slots[i];
+      if (s->frame && s->live && s->sequence > after &&
+          (next == FRAME_RING_NONE || s->sequence < ring->slots[next].sequence)) {
+        next = i;
+      }
+    }
+    ring->slots[next].refs++;
+    event->slots[event->count++] = next;
+    after = ring->slots[next].sequence;
+  }
+  event->preCount = event->count;
+  event->postRemaining = FRAME_RING_POST_FRAMES;
+  event->state = FRAME_EVENT_COLLECTING;
+  ring->stats.events++;
+  return index;
+}
+
+/**
+ * 取出一个待上传的事件
+ * @param ring 环形缓冲区
+ * @param now 当前时间(ms)
+ * @return 事件序号，没有时为FRAME_RING_NONE
+ */
+int frame_ring_take_ready(FrameRing *ring, uint32_t now) {
+  int found = FRAME_RING_NONE;
+  for (int i = 0; i < FRAME_RING_MAX_EVENTS; i++) {
+    FrameEvent *event = &ring->events[i];
+    if (event->state == FRAME_EVENT_COLLECTING && now - event->timestamp >= FRAME_RING_POST_TIMEOUT_MS) {
+      event->state = FRAME_EVENT_READY;
+    }
+    if (event->state == FRAME_EVENT_READY && (found == FRAME_RING_NONE || event->id < ring->events[found].id)) {
+      found = i;
+    }
+  }
+  if (found != FRAME_RING_NONE) {
+    ring->events[found].state = FRAME_EVENT_UPLOADING;
+  }
+  return found;
+}
+
+/**
+ * 事件上传结束，释放事件持有的帧
+ * @param ring 环形缓冲区
+ * @param event 事件序号
+ */
+void frame_ring_finish(FrameRing *ring, int event) {
+  FrameEvent *e = &ring->events[event];
+  for (int i = 0; i < e->count; i++) {
+    frame_ring_unref(ring, e->slots[i]);
+  }
+  e->count = 0;
+  e->state = FRAME_EVENT_FREE;
+}
+
+/**
+ * 引用最新一帧
+ * @param ring 环形缓冲区
+ * @return 帧槽序号，没有帧时为FRAME_RING_NONE
+ */
+int frame_ring_acquire_latest(FrameRing *ring) {
+  int slot = frame_ring_live_slot(ring, true);
+  if (slot != FRAME_RING_NONE) {
+    ring->slots[slot].refs++;
+  }
+  return slot;
+}
+
+/**
+ * 释放帧槽引用
+ * @param ring 环形缓冲区
+ * @param slot 帧槽序号
+ */
+void frame_ring_release(FrameRing *ring, int slot) {
+  if (slot != FRAME_RING_NONE) {
+    frame_ring_unref(ring, slot);
+  }
+}
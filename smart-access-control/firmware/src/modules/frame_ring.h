@@ -0,0 +1,140 @@
+#ifndef FRAME_RING_H
+#define FRAME_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 事件录像帧环形缓冲区
+// 帧槽直接持有摄像头驱动的帧缓冲区（PSRAM中的JPEG），不复制数据；
+// 环形窗口、冻结的事件和读取者各持有一个引用，引用全部释放后才把帧缓冲区还给驱动。
+// 帧槽数固定，内存上限为帧槽数×驱动帧缓冲区大小；帧槽被事件占满时新帧直接丢弃并计数。
+// 本文件不依赖Arduino，可在主机上编译测试（tools/bench/frame_ring_bench.c）
+
+// 帧槽数上限（摄像头驱动需额外保留帧缓冲区用于采集）
+#define FRAME_RING_MAX_SLOTS  24
+
+// 事件前保留帧数（环形窗口长度）及事件后采集帧数
+#define FRAME_RING_PRE_FRAMES   6
+#define FRAME_RING_POST_FRAMES  6
+#define FRAME_RING_EVENT_FRAMES (FRAME_RING_PRE_FRAMES + FRAME_RING_POST_FRAMES)
+
+// 同时冻结（采集中或待上传）的事件数
+#define FRAME_RING_MAX_EVENTS  2
+
+// 事件后采集超时(ms)，摄像头停止出帧时事件也能结束
+#define FRAME_RING_POST_TIMEOUT_MS  5000
+
+#define FRAME_RING_NONE  -1
+
+// 帧槽
+typedef struct {
+  void *frame;            // 帧缓冲区，NULL表示空槽
+  uint32_t sequence;      // 帧序号
+  uint32_t timestamp;     // 采集时间(ms)
+  uint8_t refs;           // 引用计数
+  bool live;              // 是否在环形窗口中
+} FrameSlot;
+
+// 事件状态
+typedef enum {
+  FRAME_EVENT_FREE,
+  FRAME_EVENT_COLLECTING,  // 采集事件后的帧
+  FRAME_EVENT_READY,       // 待上传
+  FRAME_EVENT_UPLOADING
+} FrameEventState;
+
+// 冻结的事件
+typedef struct {
+  FrameEventState state;
+  uint8_t type;             // 事件类型（调用方定义）
+  uint32_t id;              // 事件编号
+  uint32_t timestamp;       // 触发时间(ms)
+  uint8_t count;            // 帧数
+  uint8_t preCount;         // 其中触发前的帧数
+  uint8_t postRemaining;    // 还需采集的事件后帧数
+  uint8_t dropped;          // 事件后因帧槽不足丢弃的帧数
+  uint8_t slots[FRAME_RING_EVENT_FRAMES];
+} FrameEvent;
+
+// 统计
+typedef struct {
+  uint32_t captured;         // 进入环形缓冲区的帧数
+  uint32_t dropped;          // 帧槽不足丢弃的帧数
+  uint32_t events;           // 冻结的事件数
+  uint32_t eventsDropped;    // 事件槽不足丢弃的事件数
+  uint8_t slotsInUse;        // 当前占用的帧槽数
+  uint8_t slotsPeak;         // 帧槽占用峰值
+} FrameRingStats;
+
+// 帧缓冲区归还回调
+typedef void (*FrameRingRelease)(void *frame);
+
+// 环形缓冲区（非线程安全，调用方加锁）
+typedef struct {
+  FrameSlot slots[FRAME_RING_MAX_SLOTS];
+  FrameEvent events[FRAME_RING_MAX_EVENTS];
+  uint8_t slotCount;
+  uint8_t liveCount;
+  uint32_t sequence;
+  uint32_t eventId;
+  FrameRingRelease release;
+  FrameRingStats stats;
+} FrameRing;
+
+/**
+ * 环形缓冲区初始化
+ * @param ring 环形缓冲区
+ * @param slotCount 帧槽数（不超过FRAME_RING_MAX_SLOTS）
+ * @param release 帧缓冲区归还回调
+ */
+void frame_ring_init(FrameRing *ring, uint8_t slotCount, FrameRingRelease release);
+
+/**
+ * 加入新帧
+ * 环形窗口已满时最旧的帧移出窗口；没有空槽时不接收
+ * @param ring 环形缓冲区
+ * @param frame 帧缓冲区
+ * @param timestamp 采集时间(ms)
+ * @return 是否接收（false时由调用方归还帧缓冲区）
+ */
+bool frame_ring_push(FrameRing *ring, void *frame, uint32_t timestamp);
+
+/**
+ * 冻结事件：引用环形窗口中的帧，并继续采集之后的FRAME_RING_POST_FRAMES帧
+ * @param ring 环形缓冲区
+ * @param type 事件类型
+ * @param timestamp 触发时间(ms)
+ * @return 事件序号，事件槽已满时为FRAME_RING_NONE
+ */
+int frame_ring_freeze(FrameRing *ring, uint8_t type, uint32_t timestamp);
+
+/**
+ * 取出一个待上传的事件（状态改为上传中，采集超时的事件视为采集完成）
+ * @param ring 环形缓冲区
+ * @param now 当前时间(ms)
+ * @return 事件序号，没有时为FRAME_RING_NONE
+ */
+int frame_ring_take_ready(FrameRing *ring, uint32_t now);
+
+/**
+ * 事件上传结束，释放事件持有的帧
+ * @param ring 环形缓冲区
+ * @param event 事件序号
+ */
+void frame_ring_finish(FrameRing *ring, int event);
+
+/**
+ * 引用最新一帧（识别等读取者使用，不复制）
+ * @param ring 环形缓冲区
+ * @return 帧槽序号，没有帧时为FRAME_RING_NONE
+ */
+int frame_ring_acquire_latest(FrameRing *ring);
+
+/**
+ * 释放帧槽引用
+ * @param ring 环形缓冲区
+ * @param slot 帧槽序号
+ */
+void frame_ring_release(FrameRing *ring, int slot);
+
+#endif
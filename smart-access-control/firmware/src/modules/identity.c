@@ -1,4 +1,6 @@
 #include <Arduino.h>
+#include <SD.h>
+#include <esp_heap_caps.h>
 
 // 头文件包含
 #include "drivers/rfid_driver.h"
@@ -6,44 +8,303 @@
 #include "drivers/camera_driver.h"
 #include "drivers/keypad_driver.h"
 #include "modules/access_control.h"
+#include "modules/user_db.h"
+#include "modules/user_snapshot.h"
+#include "modules/schedule.h"
+#include "modules/mfa.h"
+#include "modules/face_match.h"
+#include "modules/face_index.h"
+#include "modules/event_capture.h"
+#include "modules/motion_gate.h"
+#include "modules/storage.h"
+#include "modules/access_trace.h"
 
 // 身份识别状态
 bool identityInitialized = false;
 
+// 本控制器读头所在的门
+#define IDENTITY_DOOR 0
+
+// 密码输入空闲超时(ms)
+#define PASSWORD_IDLE_TIMEOUT 10000
+
+// 指纹流水线等待应答时的检查间隔(ms)，应答到达后立即发送下一条指令
+#define FINGERPRINT_BUSY_INTERVAL 2
+
+// 下一次寻卡时间
+unsigned long rfidNextMillis = 0;
+
+// 多因素认证状态（各门策略及进行中的会话）
+MfaDoor mfaDoors[MFA_MAX_DOORS];
+
+// 会话中的卡号（门禁记录使用）
+CardUid mfaCard;
+bool mfaHasCard = false;
+
+// 人脸比对间隔(ms)，比对成功后间隔更长，避免同一人重复提交
+#define FACE_CHECK_INTERVAL  1000
+#define FACE_MATCH_HOLDOFF   5000
+
+// 灰度图像缓冲区（QVGA JPEG按1/2解码为160×120）
+#define FACE_GRAY_BUFFER_SIZE  (160 * 120)
+
+// 运动检测分级：平时QQVGA（解码为80×60）只做帧差，检测到运动后切换到QVGA并运行人脸识别
+#define MOTION_FRAMESIZE_IDLE    FRAMESIZE_QQVGA
+#define MOTION_FRAMESIZE_ACTIVE  FRAMESIZE_QVGA
+#define MOTION_JPEG_QUALITY      12
+#define MOTION_CHECK_INTERVAL    500
+
+// 人脸识别所需的最小灰度图宽度（切换分辨率后仍可能取到低分辨率帧）
+#define FACE_MIN_GRAY_WIDTH  160
+
+// 人脸特征索引容量（约210字节/个，4MB PSRAM模组），内存不足时逐次减半
+#define FACE_INDEX_CAPACITY      8192
+#define FACE_INDEX_MIN_CAPACITY  1024
+
+// 每隔若干次查询同时做一次精确查询，统计近似查询的召回率
+#define FACE_RECALL_SAMPLE_INTERVAL  16
+
+// 人脸特征索引（PSRAM）
+FaceIndex faceIndex;
+void *faceIndexMemory = NULL;
+uint8_t *faceGray = NULL;
+bool faceReady = false;
+int32_t faceThreshold = 0;
+int32_t faceMargin = 0;
+unsigned long faceNextMillis = 0;
+
+// 运动检测（与人脸识别在同一任务中）
+MotionGate motionGate;
+unsigned long motionNextMillis = 0;
+
+// 人脸查询统计
+uint32_t faceQueries = 0;
+uint32_t faceRecallSamples = 0;
+uint32_t faceRecallHits = 0;
+
 // 识别方式定义
 #define ID_METHOD_CARD      "card"
 #define ID_METHOD_FINGER    "finger"
 #define ID_METHOD_FACE      "face"
 #define ID_METHOD_PASSWORD  "password"
 
-// 用户数据结构
-typedef struct {
-  int id;
-  char name[50];
-  char cardId[20];
-  int fingerprintId;
-  char password[20];
-  bool enabled;
-} User;
-
-// 模拟用户数据
+// 内置用户数据（闪存用户库不可用时作为初始快照）
 User users[] = {
-  {1, "管理员", "12345678", 1, "123456", true},
-  {2, "张三", "87654321", 2, "654321", true},
-  {3, "李四", "11223344", 3, "111111", true},
-  {4, "王五", "44332211", 4, "222222", true},
-  {5, "赵六", "55667788", 5, "333333", true}
+  {1, "管理员", {4, {0x12, 0x34, 0x56, 0x78}, 0}, 1, "123456", true, SCHEDULE_ALWAYS},
+  {2, "张三", {4, {0x87, 0x65, 0x43, 0x21}, 0}, 2, "654321", true, SCHEDULE_ALWAYS},
+  {3, "李四", {4, {0x11, 0x22, 0x33, 0x44}, 0}, 3, "111111", true, SCHEDULE_ALWAYS},
+  {4, "王五", {4, {0x44, 0x33, 0x22, 0x11}, 0}, 4, "222222", true, SCHEDULE_ALWAYS},
+  {5, "赵六", {4, {0x55, 0x66, 0x77, 0x88}, 0}, 5, "333333", true, SCHEDULE_ALWAYS}
 };
 
 #define USER_COUNT (sizeof(users) / sizeof(User))
 
+/**
+ * 处理多因素判定
+ * @param decision 判定
+ */
+static void identity_handle_decision(const MfaDecision *decision) {
+  const char *method = mfa_method_name(decision->factors);
+  const CardUid *card = mfaHasCard ? &mfaCard : NULL;
+
+  if (decision->result == MFA_RESULT_GRANT) {
+    // 验证通过
+    access_control_open_door(decision->userId, decision->scheduleId, method, card);
+  } else if (decision->result == MFA_RESULT_DENY) {
+    // 验证失败
+    static const char *const reasons[] = {"", "凭证无效", "该门不接受此方式", "凭证不属于同一用户", "验证超时"};
+    Serial.printf("多因素验证失败: %s\n", reasons[decision->reason]);
+    access_control_deny_access(decision->userId, method, card);
+  }
+
+  mfaHasCard = false;
+}
+
+/**
+ * 提交识别结果到多因素认证
+ * @param factor 因素
+ * @param userId 用户ID，0表示未匹配
+ * @param scheduleId 用户时间表ID
+ * @param card 卡号键，非刷卡方式为NULL
+ */
+static void identity_submit_factor(MfaFactor factor, int userId, uint8_t scheduleId, const CardUid *card) {
+  MfaDoor *door = &mfaDoors[IDENTITY_DOOR];
+  if (!mfa_is_pending(door)) {
+    mfaHasCard = false;
+  }
+  if (card) {
+    mfaCard = *card;
+    mfaHasCard = true;
+  }
+
+  MfaDecision decision = mfa_submit(door, factor, userId, scheduleId, millis());
+  ACCESS_TRACE(ACCESS_TRACE_DECISION);
+  if (decision.result == MFA_RESULT_PENDING) {
+    // 等待其余因素，期间继续响应其他读头
+    Serial.printf("用户 %d 已通过 %s，请在 %u 秒内完成其余验证（策略: %s）\n",
+                 decision.userId, mfa_method_name(decision.factors),
+                 (unsigned)(door->windowMs / 1000), mfa_policy_name(door->policy));
+    return;
+  }
+
+  identity_handle_decision(&decision);
+}
+
+// 索引文件读写（累计头之后数据的CRC32）
+typedef struct {
+  File *file;
+  size_t skip;            // 尚未写完的文件头字节数，不计入CRC
+  uint32_t crc;
+} FaceIndexFile;
+
+static bool identity_face_read(void *context, void *data, size_t length) {
+  FaceIndexFile *indexFile = (FaceIndexFile *)context;
+  if (indexFile->file->read((uint8_t *)data, length) != length) {
+    return false;
+  }
+  indexFile->crc = user_db_crc32(indexFile->crc, (const uint8_t *)data, length);
+  return true;
+}
+
+static bool identity_face_write(void *context, const void *data, size_t length) {
+  FaceIndexFile *indexFile = (FaceIndexFile *)context;
+  if (indexFile->file->write((const uint8_t *)data, length) != length) {
+    return false;
+  }
+  size_t skip = length < indexFile->skip ? length : indexFile->skip;
+  indexFile->skip -= skip;
+  indexFile->crc = user_db_crc32(indexFile->crc, (const uint8_t *)data + skip, length - skip);
+  return true;
+}
+
+/**
+ * 分配人脸特征索引（PSRAM优先，不足时减小容量）
+ * @return 是否成功
+ */
+static bool identity_alloc_faces() {
+  for (uint32_t capacity = FACE_INDEX_CAPACITY; capacity >= FACE_INDEX_MIN_CAPACITY; capacity /= 2) {
+    size_t size = face_index_memory_size(capacity);
+    void *memory = heap_caps_aligned_alloc(16, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (memory) {
+      face_index_init(&faceIndex, memory, capacity);
+      faceIndexMemory = memory;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * 载入人脸特征索引文件
+ * @return 是否成功
+ */
+static bool identity_load_face_index() {
+  if (!SD.exists(FACE_INDEX_FILE)) {
+    return false;
+  }
+  File file = SD.open(FACE_INDEX_FILE, FILE_READ);
+  if (!file) {
+    return false;
+  }
+
+  FaceIndexHeader header;
+  FaceIndexFile indexFile = {&file, 0, 0};
+  bool ok = file.read((uint8_t *)&header, sizeof(header)) == sizeof(header) &&
+            face_index_load(&faceIndex, &header, identity_face_read, &indexFile) &&
+            indexFile.crc == header.crc32;
+  file.close();
+  if (!ok) {
+    face_index_clear(&faceIndex);
+    Serial.println("人脸特征索引无效");
+  }
+  return ok;
+}
+
+/**
+ * 由特征库文件建立索引（旧格式迁移，建立后保存为索引文件）
+ * @return 是否成功
+ */
+static bool identity_import_face_gallery() {
+  if (!SD.exists(FACE_GALLERY_FILE)) {
+    return false;
+  }
+  File file = SD.open(FACE_GALLERY_FILE, FILE_READ);
+  if (!file) {
+    return false;
+  }
+  size_t size = file.size();
+  uint8_t *data = (uint8_t *)heap_caps_aligned_alloc(16, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (!data) {
+    data = (uint8_t *)heap_caps_aligned_alloc(16, size, MALLOC_CAP_8BIT);
+  }
+  bool ok = data && file.read(data, size) == size;
+  file.close();
+
+  // 头之后全部数据的CRC32
+  FaceGallery gallery;
+  const FaceGalleryHeader *header = (const FaceGalleryHeader *)data;
+  ok = ok && size >= sizeof(FaceGalleryHeader) &&
+       user_db_crc32(0, data + sizeof(FaceGalleryHeader), size - sizeof(FaceGalleryHeader)) == header->crc32 &&
+       face_gallery_parse(data, size, &gallery);
+  if (!ok) {
+    Serial.println("人脸特征库无效");
+    free(data);
+    return false;
+  }
+
+  uint32_t added = face_index_add_gallery(&faceIndex, &gallery);
+  Serial.printf("人脸特征库导入索引: %u/%u个\n", added, gallery.count);
+  free(data);
+  return identity_save_faces();
+}
+
 /**
  * 身份识别初始化
  */
 void identity_init() {
+  // 默认单因素，策略由后台下发
+  for (int i = 0; i < MFA_MAX_DOORS; i++) {
+    mfa_door_init(&mfaDoors[i], MFA_POLICY_ANY_ONE, MFA_DEFAULT_WINDOW_MS);
+  }
+
+  // 挂载闪存用户库，失败时使用内置用户数据
+  if (user_db_mount()) {
+    Serial.printf("使用闪存用户库，用户数量: %u\n", user_db_get_user_count());
+  } else {
+    Serial.println("闪存用户库不可用，使用内置用户数据");
+  }
+
+  // 建立初始快照（凭证索引和卡号过滤器）
+  if (!user_snapshot_init(users, USER_COUNT)) {
+    Serial.println("用户库快照建立失败");
+    return;
+  }
+
+  // 人脸特征索引及灰度图像缓冲区（无索引文件时由旧格式特征库导入，之后由后台增量下发）
+  faceThreshold = face_threshold(FACE_DEFAULT_THRESHOLD_PERMILLE);
+  faceMargin = face_threshold(FACE_DEFAULT_MARGIN_PERMILLE);
+  if (identity_alloc_faces()) {
+    if (storage_is_initialized() && !identity_load_face_index()) {
+      identity_import_face_gallery();
+    }
+    faceGray = (uint8_t *)malloc(FACE_GRAY_BUFFER_SIZE);
+    faceReady = faceGray != NULL;
+    motion_gate_init(&motionGate);
+    camera_set_params(MOTION_FRAMESIZE_IDLE, MOTION_JPEG_QUALITY);
+    Serial.printf("人脸特征索引: %u个（容量%u）\n", faceIndex.count - faceIndex.deleted, faceIndex.capacity);
+  }
+
   identityInitialized = true;
   Serial.println("身份识别模块初始化完成");
-  Serial.printf("当前用户数量: %d\n", USER_COUNT);
+
+  const UserSnapshot *snapshot = user_snapshot_read_lock();
+  Serial.printf("用户库版本: %u, 覆盖层用户: %u\n", snapshot->version, snapshot->userCount);
+  Serial.printf("凭证索引: 卡=%u/%u, 指纹=%u/%u, 密码=%u/%u, 位置=%s\n",
+               snapshot->cardIndex.count, snapshot->cardIndex.capacity,
+               snapshot->fingerprintIndex.count, snapshot->fingerprintIndex.capacity,
+               snapshot->passwordIndex.count, snapshot->passwordIndex.capacity,
+               snapshot->cardIndex.inPsram ? "PSRAM" : "内部RAM");
+  user_snapshot_read_unlock();
 }
 
 /**
@@ -54,43 +315,100 @@ void identity_check() {
     return;
   }
   
-  // 检查RFID卡
-  if (rfid_check_card()) {
-    identity_check_card();
+  // 多因素会话超时
+  MfaDecision decision = mfa_poll(&mfaDoors[IDENTITY_DOOR], millis());
+  if (decision.result == MFA_RESULT_DENY) {
+    identity_handle_decision(&decision);
   }
   
-  // 检查指纹
+  // 寻卡（有卡时投递读卡事件）
+  if ((long)(millis() - rfidNextMillis) >= 0) {
+    rfidNextMillis = millis() + RFID_PROBE_INTERVAL_MS;
+    rfid_probe();
+  }
+  
+  // 推进指纹流水线（轮询模式定时采集，中断模式等待应答）
   if (fingerprint_check()) {
     identity_check_fingerprint();
   }
   
-  // 检查密码
-  char key = keypad_scan();
-  if (key) {
-    identity_check_password();
+  // 检查人脸（引导框内有人脸且与特征库匹配时提交）
+  identity_check_face();
+}
+
+/**
+ * 处理事件总线事件
+ * @param event 事件
+ */
+void identity_handle_event(const BusEvent *event) {
+  if (!identityInitialized) {
+    return;
+  }
+  
+  switch (event->type) {
+    case BUS_EVENT_CARD:
+      // 该卡的处理过程（查找、判定、开锁、记录）计入读卡事件的跟踪
+      ACCESS_TRACE_RESUME(event->trace);
+      ACCESS_TRACE(ACCESS_TRACE_DEQUEUED);
+      identity_check_card();
+      ACCESS_TRACE_END();
+      break;
+    case BUS_EVENT_TOUCH:
+      // 触摸后立即发起采集
+      if (fingerprint_check()) {
+        identity_check_fingerprint();
+      }
+      break;
+    case BUS_EVENT_KEY:
+      // 检查密码（按#结束输入）
+      identity_check_password();
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+ * 距下一次到时工作的时间
+ * @return 时间(ms)
+ */
+uint32_t identity_next_wait() {
+  if (fingerprint_is_busy()) {
+    return FINGERPRINT_BUSY_INTERVAL;
+  }
+  
+  unsigned long now = millis();
+  long wait = (long)(rfidNextMillis - now);
+  
+  // 人脸运动检测
+  if (faceReady && faceIndex.count > faceIndex.deleted && camera_is_initialized()) {
+    long motionWait = (long)(motionNextMillis - now);
+    wait = motionWait < wait ? motionWait : wait;
   }
   
-  // 检查人脸（暂未实现）
-  // identity_check_face();
+  // 多因素会话超时
+  const MfaDoor *door = &mfaDoors[IDENTITY_DOOR];
+  if (door->factors) {
+    long sessionWait = (long)(door->startedAt + door->windowMs - now);
+    wait = sessionWait < wait ? sessionWait : wait;
+  }
+  return wait > 0 ? wait : 0;
 }
 
 /**
  * 检查卡片识别
  */
 void identity_check_card() {
-  char cardId[20];
-  if (rfid_get_card_id_string(cardId, sizeof(cardId))) {
-    Serial.printf("检测到卡片: %s\n", cardId);
+  CardUid card;
+  if (rfid_get_card_uid(&card)) {
+    char cardHex[RFID_UID_HEX_SIZE];
+    Serial.printf("检测到卡片: %s\n", rfid_uid_to_hex(&card, cardHex, sizeof(cardHex)));
     
     // 查找用户
-    int userId = identity_find_user_by_card(cardId);
-    if (userId > 0) {
-      // 验证通过
-      access_control_open_door(userId, ID_METHOD_CARD);
-    } else {
-      // 验证失败
-      access_control_deny_access(0, ID_METHOD_CARD);
-    }
+    uint8_t scheduleId = SCHEDULE_ALWAYS;
+    int userId = identity_find_user_by_card(&card, &scheduleId);
+    ACCESS_TRACE(ACCESS_TRACE_LOOKUP);
+    identity_submit_factor(MFA_FACTOR_CARD, userId, scheduleId, &card);
     
     // 休眠卡
     rfid_halt_card();
@@ -106,89 +424,248 @@ void identity_check_fingerprint() {
     Serial.printf("检测到指纹: ID=%d\n", fingerprintId);
     
     // 查找用户
-    int userId = identity_find_user_by_fingerprint(fingerprintId);
-    if (userId > 0) {
-      // 验证通过
-      access_control_open_door(userId, ID_METHOD_FINGER);
-    } else {
-      // 验证失败
-      access_control_deny_access(0, ID_METHOD_FINGER);
-    }
+    uint8_t scheduleId = SCHEDULE_ALWAYS;
+    int userId = identity_find_user_by_fingerprint(fingerprintId, &scheduleId);
+    identity_submit_factor(MFA_FACTOR_FINGER, userId, scheduleId, NULL);
+  } else {
+    // 指纹库中无此指纹
+    Serial.println("指纹未登记");
+    identity_submit_factor(MFA_FACTOR_FINGER, 0, SCHEDULE_ALWAYS, NULL);
   }
 }
 
 /**
  * 检查密码识别
+ * 按#结束输入，输入过程中不阻塞刷卡和指纹
  */
 void identity_check_password() {
-  Serial.println("请输入密码，按#结束");
-  
   char password[20];
-  int length = keypad_get_password(password, sizeof(password), 30000);
+  int length = keypad_poll_password(password, sizeof(password), PASSWORD_IDLE_TIMEOUT);
   
   if (length > 0) {
-    Serial.printf("输入密码: %s\n", password);
+    Serial.println("密码输入完成");
     
-    // 查找用户
-    int userId = identity_find_user_by_password(password);
-    if (userId > 0) {
-      // 验证通过
-      access_control_open_door(userId, ID_METHOD_PASSWORD);
+    // 已有卡或指纹等待密码时按该用户校验（密码可能多人共用），否则全局查找
+    const MfaDoor *door = &mfaDoors[IDENTITY_DOOR];
+    uint8_t scheduleId = SCHEDULE_ALWAYS;
+    int userId = 0;
+    if (mfa_is_pending(door) && identity_check_user_password(door->userId, password)) {
+      userId = door->userId;
+      scheduleId = door->scheduleId;
     } else {
-      // 验证失败
-      access_control_deny_access(0, ID_METHOD_PASSWORD);
+      userId = identity_find_user_by_password(password, &scheduleId);
     }
+    identity_submit_factor(MFA_FACTOR_PIN, userId, scheduleId, NULL);
   }
 }
 
 /**
- * 检查人脸识别（暂未实现）
+ * 检查人脸识别
+ * 取帧 → 灰度 → 运动检测；全分辨率级再裁剪引导框并归一化 → 特征 → 索引近似最近邻查询
+ * 引导框内对比度不足或未匹配时不提交，画面中可能只有背景
  */
 void identity_check_face() {
-  // 暂未实现
-  // 后续可集成OpenCV或其他人脸识别库
+  if (!faceReady || faceIndex.count == faceIndex.deleted || !camera_is_initialized() ||
+      (long)(millis() - motionNextMillis) < 0) {
+    return;
+  }
+  motionNextMillis = millis() + MOTION_CHECK_INTERVAL;
+
+  // 与事件录像共用最新一帧（引用计数，不复制）
+  camera_fb_t *fb = NULL;
+  if (!event_capture_acquire(&fb)) {
+    return;
+  }
+  int width = 0;
+  int height = 0;
+  bool converted = camera_fb_to_gray(fb, faceGray, FACE_GRAY_BUFFER_SIZE, &width, &height);
+  event_capture_release(fb);
+  if (!converted) {
+    return;
+  }
+
+  // 运动检测，级别变化时切换摄像头分辨率
+  if (motion_gate_feed(&motionGate, faceGray, width, height, millis())) {
+    bool active = motionGate.tier == MOTION_TIER_ACTIVE;
+    camera_set_params(active ? MOTION_FRAMESIZE_ACTIVE : MOTION_FRAMESIZE_IDLE, MOTION_JPEG_QUALITY);
+    Serial.printf("运动检测: %s（变化格子%u）\n", active ? "切换到人脸识别" : "无运动，回到低分辨率",
+                  motionGate.changedCells);
+  }
+  if (motionGate.tier != MOTION_TIER_ACTIVE || width < FACE_MIN_GRAY_WIDTH ||
+      (long)(millis() - faceNextMillis) < 0) {
+    return;
+  }
+  faceNextMillis = millis() + FACE_CHECK_INTERVAL;
+
+  // 人脸不能单独开门：门策略不接受人脸时不比对，经过的人不会产生拒绝记录
+  if (!mfa_accepts(&mfaDoors[IDENTITY_DOOR], MFA_FACTOR_FACE)) {
+    return;
+  }
+
+  FaceBox box;
+  uint8_t crop[FACE_CROP_SIZE * FACE_CROP_SIZE];
+  face_guide_box(width, height, &box);
+  if (!face_crop(faceGray, width, height, &box, crop)) {
+    return;
+  }
+
+  FaceEmbedding embedding;
+  FaceMatch match;
+  face_embed(crop, &embedding);
+  bool matched = face_index_search(&faceIndex, &embedding, FACE_INDEX_EF_SEARCH, faceThreshold, faceMargin, &match);
+
+  // 抽样与精确查询对比，统计召回率
+  if (++faceQueries % FACE_RECALL_SAMPLE_INTERVAL == 0) {
+    FaceMatch exact;
+    face_index_exact(&faceIndex, &embedding, faceThreshold, faceMargin, &exact);
+    faceRecallSamples++;
+    faceRecallHits += exact.userId == match.userId;
+  }
+  if (!matched) {
+    return;
+  }
+  Serial.printf("检测到人脸: 用户%u, 相似度%d‰, 比对%u个\n", match.userId,
+               (int)(match.score * 1000 / (FACE_SCALE * FACE_SCALE)), match.scanned);
+  faceNextMillis = millis() + FACE_MATCH_HOLDOFF;
+
+  // 特征库中的用户已删除或禁用时按无效凭证处理
+  User user;
+  int userId = 0;
+  uint8_t scheduleId = SCHEDULE_ALWAYS;
+  if (identity_get_user(match.userId, &user) && user.enabled) {
+    userId = user.id;
+    scheduleId = user.scheduleId;
+  }
+  identity_submit_factor(MFA_FACTOR_FACE, userId, scheduleId, NULL);
+}
+
+/**
+ * 登记人脸特征
+ * @param userId 用户ID
+ * @param embedding 特征
+ * @return 是否成功
+ */
+bool identity_add_face(uint32_t userId, const FaceEmbedding *embedding) {
+  return faceIndexMemory && face_index_add(&faceIndex, userId, embedding);
+}
+
+/**
+ * 删除用户的人脸特征
+ * @param userId 用户ID
+ * @return 删除的特征数
+ */
+uint32_t identity_remove_faces(uint32_t userId) {
+  return faceIndexMemory ? face_index_remove(&faceIndex, userId) : 0;
+}
+
+/**
+ * 保存人脸特征索引
+ * 先写临时文件并回填CRC再替换，写入中途掉电不会损坏原索引
+ * @return 是否成功
+ */
+bool identity_save_faces() {
+  if (!faceIndexMemory || !storage_is_initialized()) {
+    return false;
+  }
+
+  File file = SD.open(FACE_INDEX_TMP_FILE, FILE_WRITE);
+  if (!file) {
+    Serial.println("人脸特征索引保存失败: 无法创建文件");
+    return false;
+  }
+  FaceIndexFile indexFile = {&file, sizeof(FaceIndexHeader), 0};
+  bool ok = face_index_save(&faceIndex, identity_face_write, &indexFile) &&
+            file.seek(offsetof(FaceIndexHeader, crc32)) &&
+            file.write((const uint8_t *)&indexFile.crc, sizeof(indexFile.crc)) == sizeof(indexFile.crc);
+  file.close();
+
+  if (!ok) {
+    SD.remove(FACE_INDEX_TMP_FILE);
+    Serial.println("人脸特征索引保存失败: 写入错误");
+    return false;
+  }
+  SD.remove(FACE_INDEX_FILE);
+  SD.rename(FACE_INDEX_TMP_FILE, FACE_INDEX_FILE);
+  Serial.printf("人脸特征索引已保存: %u个\n", faceIndex.count - faceIndex.deleted);
+  return true;
+}
+
+/**
+ * 获取人脸识别统计
+ * @param count 已登记特征数
+ * @param queries 查询次数
+ * @param recallSamples 与精确查询对比的次数
+ * @param recallHits 与精确查询结果一致的次数
+ */
+void identity_get_face_stats(uint32_t *count, uint32_t *queries, uint32_t *recallSamples, uint32_t *recallHits) {
+  *count = faceIndexMemory ? faceIndex.count - faceIndex.deleted : 0;
+  *queries = faceQueries;
+  *recallSamples = faceRecallSamples;
+  *recallHits = faceRecallHits;
+}
+
+/**
+ * 获取运动检测统计
+ * @param idleFrames 低分辨率级处理的帧数（只做运动检测）
+ * @param activeFrames 全分辨率级处理的帧数（运动检测 + 人脸识别）
+ * @param activations 切换到全分辨率的次数
+ */
+void identity_get_motion_stats(uint32_t *idleFrames, uint32_t *activeFrames, uint32_t *activations) {
+  *idleFrames = motionGate.frames[MOTION_TIER_IDLE];
+  *activeFrames = motionGate.frames[MOTION_TIER_ACTIVE];
+  *activations = motionGate.activations;
 }
 
 /**
  * 根据卡号查找用户
- * @param cardId 卡号
+ * @param card 卡号键
+ * @param scheduleId 时间表ID（可为NULL）
  * @return 用户ID，0表示未找到
  */
-int identity_find_user_by_card(const char *cardId) {
-  for (int i = 0; i < USER_COUNT; i++) {
-    if (users[i].enabled && strcmp(users[i].cardId, cardId) == 0) {
-      return users[i].id;
-    }
-  }
-  return 0;
+int identity_find_user_by_card(const CardUid *card, uint8_t *scheduleId) {
+  const UserSnapshot *snapshot = user_snapshot_read_lock();
+  int userId = user_snapshot_find_card(snapshot, card, scheduleId);
+  user_snapshot_read_unlock();
+  return userId;
 }
 
 /**
  * 根据指纹ID查找用户
  * @param fingerprintId 指纹ID
+ * @param scheduleId 时间表ID（可为NULL）
  * @return 用户ID，0表示未找到
  */
-int identity_find_user_by_fingerprint(int fingerprintId) {
-  for (int i = 0; i < USER_COUNT; i++) {
-    if (users[i].enabled && users[i].fingerprintId == fingerprintId) {
-      return users[i].id;
-    }
-  }
-  return 0;
+int identity_find_user_by_fingerprint(int fingerprintId, uint8_t *scheduleId) {
+  const UserSnapshot *snapshot = user_snapshot_read_lock();
+  int userId = user_snapshot_find_fingerprint(snapshot, fingerprintId, scheduleId);
+  user_snapshot_read_unlock();
+  return userId;
 }
 
 /**
  * 根据密码查找用户
  * @param password 密码
+ * @param scheduleId 时间表ID（可为NULL）
  * @return 用户ID，0表示未找到
  */
-int identity_find_user_by_password(const char *password) {
-  for (int i = 0; i < USER_COUNT; i++) {
-    if (users[i].enabled && strcmp(users[i].password, password) == 0) {
-      return users[i].id;
-    }
-  }
-  return 0;
+int identity_find_user_by_password(const char *password, uint8_t *scheduleId) {
+  const UserSnapshot *snapshot = user_snapshot_read_lock();
+  int userId = user_snapshot_find_password(snapshot, password, scheduleId);
+  user_snapshot_read_unlock();
+  return userId;
+}
+
+/**
+ * 校验指定用户的密码
+ * @param userId 用户ID
+ * @param password 密码
+ * @return 用户生效且密码属于该用户
+ */
+bool identity_check_user_password(int userId, const char *password) {
+  const UserSnapshot *snapshot = user_snapshot_read_lock();
+  bool matched = user_snapshot_check_password(snapshot, userId, password);
+  user_snapshot_read_unlock();
+  return matched;
 }
 
 /**
@@ -198,13 +675,25 @@ int identity_find_user_by_password(const char *password) {
  * @return 是否找到
  */
 bool identity_get_user(int userId, User *user) {
-  for (int i = 0; i < USER_COUNT; i++) {
-    if (users[i].id == userId) {
-      *user = users[i];
-      return true;
-    }
+  const UserSnapshot *snapshot = user_snapshot_read_lock();
+  bool found = user_snapshot_get_user(snapshot, userId, user);
+  user_snapshot_read_unlock();
+  return found;
+}
+
+/**
+ * 提交单条更新
+ */
+static bool identity_apply_update(IdentityUpdateType type, int userId, const User *user) {
+  IdentityUpdate update;
+  memset(&update, 0, sizeof(update));
+  update.type = type;
+  if (user) {
+    update.user = *user;
   }
-  return false;
+  update.user.id = userId;
+
+  return user_snapshot_apply(&update, 1, 0) == 1;
 }
 
 /**
@@ -213,9 +702,10 @@ bool identity_get_user(int userId, User *user) {
  * @return 是否成功
  */
 bool identity_add_user(User *user) {
-  // 暂未实现
-  // 后续可实现用户管理功能
-  return false;
+  if (!identityInitialized || !user || user->id <= 0) {
+    return false;
+  }
+  return identity_apply_update(IDENTITY_UPDATE_ADD, user->id, user);
 }
 
 /**
@@ -224,9 +714,10 @@ bool identity_add_user(User *user) {
  * @return 是否成功
  */
 bool identity_delete_user(int userId) {
-  // 暂未实现
-  // 后续可实现用户管理功能
-  return false;
+  if (!identityInitialized) {
+    return false;
+  }
+  return identity_apply_update(IDENTITY_UPDATE_DELETE, userId, NULL);
 }
 
 /**
@@ -236,13 +727,97 @@ bool identity_delete_user(int userId) {
  * @return 是否成功
  */
 bool identity_set_user_enabled(int userId, bool enabled) {
-  for (int i = 0; i < USER_COUNT; i++) {
-    if (users[i].id == userId) {
-      users[i].enabled = enabled;
-      return true;
-    }
+  if (!identityInitialized) {
+    return false;
   }
-  return false;
+  return identity_apply_update(enabled ? IDENTITY_UPDATE_ENABLE : IDENTITY_UPDATE_DISABLE, userId, NULL);
+}
+
+/**
+ * 批量更新用户库
+ * @param updates 更新列表
+ * @param count 更新条数
+ * @param version 新版本号，0表示沿用当前版本
+ * @return 成功应用的条数，-1表示失败
+ */
+int identity_apply_updates(const IdentityUpdate *updates, int count, uint32_t version) {
+  if (!identityInitialized) {
+    return -1;
+  }
+  return user_snapshot_apply(updates, count, version);
+}
+
+/**
+ * 以完整用户列表替换用户库（全量同步）
+ * @param users 用户列表
+ * @param count 用户数量
+ * @param version 新版本号
+ * @return 是否成功
+ */
+bool identity_replace_users(const User *users, int count, uint32_t version) {
+  if (!identityInitialized) {
+    return false;
+  }
+  return user_snapshot_replace(users, count, version);
+}
+
+/**
+ * 获取用户库版本
+ * @return 版本号
+ */
+uint32_t identity_get_db_version() {
+  if (!identityInitialized) {
+    return 0;
+  }
+
+  const UserSnapshot *snapshot = user_snapshot_read_lock();
+  uint32_t version = snapshot->version;
+  user_snapshot_read_unlock();
+  return version;
+}
+
+/**
+ * 获取卡号过滤器统计
+ * @param queries 查询次数
+ * @param saved 过滤器直接拒绝、节省的完整查找次数
+ * @param falsePositives 误判次数
+ */
+void identity_get_card_filter_stats(uint32_t *queries, uint32_t *saved, uint32_t *falsePositives) {
+  user_snapshot_get_filter_stats(queries, saved, falsePositives);
+}
+
+/**
+ * 设置门的多因素认证策略
+ * 进行中的会话作废
+ * @param door 门编号
+ * @param policy 策略名称（any / card / card+pin / finger+pin / any_two）
+ * @param windowMs 关联窗口(ms)，0表示默认值
+ * @return 是否成功
+ */
+bool identity_set_mfa_policy(int door, const char *policy, uint32_t windowMs) {
+  MfaPolicy value;
+  if (door < 0 || door >= MFA_MAX_DOORS || !mfa_policy_from_name(policy, &value)) {
+    return false;
+  }
+
+  mfa_door_init(&mfaDoors[door], value, windowMs);
+  if (door == IDENTITY_DOOR) {
+    mfaHasCard = false;
+  }
+  Serial.printf("门 %d 认证策略: %s, 窗口: %u ms\n", door, mfa_policy_name(value), mfaDoors[door].windowMs);
+  return true;
+}
+
+/**
+ * 获取门的多因素认证策略
+ * @param door 门编号
+ * @return 策略名称
+ */
+const char *identity_get_mfa_policy(int door) {
+  if (door < 0 || door >= MFA_MAX_DOORS) {
+    return "unknown";
+  }
+  return mfa_policy_name(mfaDoors[door].policy);
 }
 
 /**
@@ -265,12 +840,20 @@ void identity_test() {
   Serial.println("身份识别模块测试开始...");
   
   // 打印用户信息
-  Serial.println("当前用户列表:");
-  for (int i = 0; i < USER_COUNT; i++) {
+  Serial.println("当前用户列表（覆盖层）:");
+  const UserSnapshot *snapshot = user_snapshot_read_lock();
+  for (uint32_t i = 0; i < snapshot->userCount; i++) {
+    const SnapshotUser *record = &snapshot->users[i];
+    if (record->deleted || record->inheritImage) {
+      continue;
+    }
+    char cardHex[RFID_UID_HEX_SIZE];
     Serial.printf("ID: %d, 姓名: %s, 卡号: %s, 指纹ID: %d, 状态: %s\n", 
-                 users[i].id, users[i].name, users[i].cardId, 
-                 users[i].fingerprintId, users[i].enabled ? "启用" : "禁用");
+                 record->user.id, record->user.name,
+                 rfid_uid_to_hex(&record->user.card, cardHex, sizeof(cardHex)), 
+                 record->user.fingerprintId, record->user.enabled ? "启用" : "禁用");
   }
+  user_snapshot_read_unlock();
   
   Serial.println("身份识别模块测试完成");
 }
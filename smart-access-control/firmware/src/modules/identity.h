@@ -2,6 +2,34 @@
 #define IDENTITY_H
 
 #include <Arduino.h>
+#include "drivers/rfid_driver.h"
+#include "modules/face_match.h"
+#include "modules/event_bus.h"
+
+// 用户数据结构
+typedef struct {
+  int id;
+  char name[50];
+  CardUid card;
+  int fingerprintId;
+  char password[20];
+  bool enabled;
+  uint8_t scheduleId;   // 时间表ID，0表示不限时间
+} User;
+
+// 用户库更新类型
+typedef enum {
+  IDENTITY_UPDATE_ADD,        // 新增或整体替换用户
+  IDENTITY_UPDATE_ENABLE,     // 启用用户
+  IDENTITY_UPDATE_DISABLE,    // 禁用用户
+  IDENTITY_UPDATE_DELETE      // 删除用户
+} IdentityUpdateType;
+
+// 用户库更新（启用/禁用/删除只使用user.id）
+typedef struct {
+  IdentityUpdateType type;
+  User user;
+} IdentityUpdate;
 
 /**
  * 身份识别初始化
@@ -9,10 +37,23 @@
 void identity_init();
 
 /**
- * 检查识别请求
+ * 检查识别请求（到时工作：多因素会话超时、寻卡、指纹流水线、人脸）
+ * 各识别方式的结果按门的多因素认证策略关联判定，不阻塞
  */
 void identity_check();
 
+/**
+ * 处理事件总线事件（读卡、指纹触摸、按键）
+ * @param event 事件
+ */
+void identity_handle_event(const BusEvent *event);
+
+/**
+ * 距下一次到时工作的时间
+ * @return 时间(ms)
+ */
+uint32_t identity_next_wait();
+
 /**
  * 检查卡片识别
  */
@@ -25,6 +66,7 @@ void identity_check_fingerprint();
 
 /**
  * 检查密码识别
+ * 非阻塞，每次调用扫描一次键盘
  */
 void identity_check_password();
 
@@ -33,26 +75,99 @@ void identity_check_password();
  */
 void identity_check_face();
 
+/**
+ * 登记人脸特征（插入索引，不保存）
+ * 与identity_check_face在同一任务中调用
+ * @param userId 用户ID
+ * @param embedding 特征
+ * @return 是否成功（索引已满或不可用时失败）
+ */
+bool identity_add_face(uint32_t userId, const FaceEmbedding *embedding);
+
+/**
+ * 删除用户的人脸特征（不保存）
+ * @param userId 用户ID
+ * @return 删除的特征数
+ */
+uint32_t identity_remove_faces(uint32_t userId);
+
+/**
+ * 保存人脸特征索引到SD卡
+ * @return 是否成功
+ */
+bool identity_save_faces();
+
+/**
+ * 获取人脸识别统计
+ * @param count 已登记特征数
+ * @param queries 查询次数
+ * @param recallSamples 与精确查询对比的次数
+ * @param recallHits 与精确查询结果一致的次数
+ */
+void identity_get_face_stats(uint32_t *count, uint32_t *queries, uint32_t *recallSamples, uint32_t *recallHits);
+
+/**
+ * 获取运动检测统计
+ * @param idleFrames 低分辨率级处理的帧数（只做运动检测）
+ * @param activeFrames 全分辨率级处理的帧数（运动检测 + 人脸识别）
+ * @param activations 切换到全分辨率的次数
+ */
+void identity_get_motion_stats(uint32_t *idleFrames, uint32_t *activeFrames, uint32_t *activations);
+
 /**
  * 根据卡号查找用户
- * @param cardId 卡号
+ * @param card 卡号键
+ * @param scheduleId 命中时写入用户的时间表ID（可为NULL）
  * @return 用户ID，0表示未找到
  */
-int identity_find_user_by_card(const char *cardId);
+int identity_find_user_by_card(const CardUid *card, uint8_t *scheduleId);
 
 /**
  * 根据指纹ID查找用户
  * @param fingerprintId 指纹ID
+ * @param scheduleId 命中时写入用户的时间表ID（可为NULL）
  * @return 用户ID，0表示未找到
  */
-int identity_find_user_by_fingerprint(int fingerprintId);
+int identity_find_user_by_fingerprint(int fingerprintId, uint8_t *scheduleId);
 
 /**
  * 根据密码查找用户
  * @param password 密码
+ * @param scheduleId 命中时写入用户的时间表ID（可为NULL）
  * @return 用户ID，0表示未找到
  */
-int identity_find_user_by_password(const char *password);
+int identity_find_user_by_password(const char *password, uint8_t *scheduleId);
+
+/**
+ * 校验指定用户的密码
+ * 多人共用同一密码时，卡或指纹之后的密码按已识别的用户确认
+ * @param userId 用户ID
+ * @param password 密码
+ * @return 用户生效且密码属于该用户
+ */
+bool identity_check_user_password(int userId, const char *password);
+
+/**
+ * 获取用户信息
+ * @param userId 用户ID
+ * @param user 用户信息
+ * @return 是否找到
+ */
+bool identity_get_user(int userId, User *user);
+
+/**
+ * 添加用户（同ID用户存在时整体替换）
+ * @param user 用户信息
+ * @return 是否成功
+ */
+bool identity_add_user(User *user);
+
+/**
+ * 删除用户
+ * @param userId 用户ID
+ * @return 是否成功
+ */
+bool identity_delete_user(int userId);
 
 /**
  * 启用/禁用用户
@@ -62,6 +177,57 @@ int identity_find_user_by_password(const char *password);
  */
 bool identity_set_user_enabled(int userId, bool enabled);
 
+/**
+ * 批量更新用户库
+ * 整批生成新快照后一次性发布，识别过程中不会看到半批更新
+ * @param updates 更新列表
+ * @param count 更新条数
+ * @param version 新版本号，0表示沿用当前版本
+ * @return 成功应用的条数，-1表示失败
+ */
+int identity_apply_updates(const IdentityUpdate *updates, int count, uint32_t version);
+
+/**
+ * 以完整用户列表替换用户库（全量同步）
+ * 替换后不再使用闪存用户库中的用户
+ * @param users 用户列表
+ * @param count 用户数量
+ * @param version 新版本号
+ * @return 是否成功
+ */
+bool identity_replace_users(const User *users, int count, uint32_t version);
+
+/**
+ * 获取用户库版本
+ * @return 版本号
+ */
+uint32_t identity_get_db_version();
+
+/**
+ * 获取卡号过滤器统计
+ * @param queries 查询次数
+ * @param saved 过滤器直接拒绝、节省的完整查找次数
+ * @param falsePositives 误判次数
+ */
+void identity_get_card_filter_stats(uint32_t *queries, uint32_t *saved, uint32_t *falsePositives);
+
+/**
+ * 设置门的多因素认证策略
+ * 进行中的会话作废
+ * @param door 门编号
+ * @param policy 策略名称（any / card / card+pin / finger+pin / any_two）
+ * @param windowMs 关联窗口(ms)，0表示默认值
+ * @return 是否成功
+ */
+bool identity_set_mfa_policy(int door, const char *policy, uint32_t windowMs);
+
+/**
+ * 获取门的多因素认证策略
+ * @param door 门编号
+ * @return 策略名称
+ */
+const char *identity_get_mfa_policy(int door);
+
 /**
  * 检查身份识别状态
  * @return 是否初始化成功
@@ -0,0 +1,202 @@
+#include <string.h>
+
+// 头文件包含
+#include "modules/mfa.h"
+
+// 策略名称
+static const char *const mfaPolicyNames[MFA_POLICY_COUNT] = {
+  "any", "card", "card+pin", "finger+pin", "any_two"
+};
+
+// 各策略接受的因素（人脸误识率远高于其余因素，只在与其他因素组合的any_two中接受）
+static const uint8_t mfaPolicyAllowed[MFA_POLICY_COUNT] = {
+  MFA_FACTOR_CARD | MFA_FACTOR_FINGER | MFA_FACTOR_PIN,
+  MFA_FACTOR_CARD,
+  MFA_FACTOR_CARD | MFA_FACTOR_PIN,
+  MFA_FACTOR_FINGER | MFA_FACTOR_PIN,
+  MFA_FACTOR_CARD | MFA_FACTOR_FINGER | MFA_FACTOR_PIN | MFA_FACTOR_FACE
+};
+
+// 因素组合名称（下标为因素掩码，与门禁记录中的单因素名称一致）
+static const char *const mfaMethodNames[16] = {
+  "none", "card", "finger", "card+finger",
+  "password", "card+password", "finger+password", "card+finger+password",
+  "face", "card+face", "finger+face", "card+finger+face",
+  "password+face", "card+password+face", "finger+password+face", "card+finger+password+face"
+};
+
+/**
+ * 统计因素数量
+ */
+static int mfa_factor_count(uint8_t factors) {
+  int count = 0;
+  while (factors) {
+    factors &= factors - 1;
+    count++;
+  }
+  return count;
+}
+
+/**
+ * 判断策略是否已满足
+ */
+static bool mfa_satisfied(MfaPolicy policy, uint8_t factors) {
+  switch (policy) {
+    case MFA_POLICY_ANY_ONE:
+      return factors != 0;
+    case MFA_POLICY_CARD_ONLY:
+      return (factors & MFA_FACTOR_CARD) != 0;
+    case MFA_POLICY_CARD_PIN:
+      return (factors & (MFA_FACTOR_CARD | MFA_FACTOR_PIN)) == (MFA_FACTOR_CARD | MFA_FACTOR_PIN);
+    case MFA_POLICY_FINGER_PIN:
+      return (factors & (MFA_FACTOR_FINGER | MFA_FACTOR_PIN)) == (MFA_FACTOR_FINGER | MFA_FACTOR_PIN);
+    case MFA_POLICY_ANY_TWO:
+      return mfa_factor_count(factors) >= 2;
+    default:
+      return false;
+  }
+}
+
+/**
+ * 生成判定并结束会话
+ */
+static MfaDecision mfa_finish(MfaDoor *door, MfaResult result, MfaReason reason, uint8_t factors) {
+  MfaDecision decision = {result, reason, door->userId, door->scheduleId, factors};
+  door->factors = 0;
+  door->userId = 0;
+  door->scheduleId = 0;
+  return decision;
+}
+
+/**
+ * 门状态初始化
+ * @param door 门
+ * @param policy 策略
+ * @param windowMs 关联窗口(ms)
+ */
+void mfa_door_init(MfaDoor *door, MfaPolicy policy, uint32_t windowMs) {
+  memset(door, 0, sizeof(MfaDoor));
+  door->policy = policy < MFA_POLICY_COUNT ? policy : MFA_POLICY_ANY_ONE;
+  door->windowMs = windowMs ? windowMs : MFA_DEFAULT_WINDOW_MS;
+}
+
+/**
+ * 提交一个因素
+ * @param door 门
+ * @param factor 因素
+ * @param userId 凭证对应的用户ID，0表示未匹配
+ * @param scheduleId 用户时间表ID
+ * @param now 当前时间(ms)
+ * @return 判定
+ */
+MfaDecision mfa_submit(MfaDoor *door, MfaFactor factor, int userId, uint8_t scheduleId, uint32_t now) {
+  // 已超时的会话作废，本次因素开始新会话
+  if (door->factors && now - door->startedAt >= door->windowMs) {
+    mfa_finish(door, MFA_RESULT_NONE, MFA_REASON_NONE, 0);
+  }
+
+  uint8_t factors = door->factors | factor;
+
+  if (!(mfaPolicyAllowed[door->policy] & factor)) {
+    return mfa_finish(door, MFA_RESULT_DENY, MFA_REASON_NOT_ALLOWED, factors);
+  }
+
+  if (userId <= 0) {
+    door->userId = 0;
+    return mfa_finish(door, MFA_RESULT_DENY, MFA_REASON_UNKNOWN, factors);
+  }
+
+  if (door->factors && door->userId != userId) {
+    return mfa_finish(door, MFA_RESULT_DENY, MFA_REASON_USER_MISMATCH, factors);
+  }
+
+  if (!door->factors) {
+    door->userId = userId;
+    door->scheduleId = scheduleId;
+    door->startedAt = now;
+  }
+  door->factors = factors;
+
+  if (mfa_satisfied(door->policy, factors)) {
+    return mfa_finish(door, MFA_RESULT_GRANT, MFA_REASON_NONE, factors);
+  }
+
+  MfaDecision decision = {MFA_RESULT_PENDING, MFA_REASON_NONE, door->userId, door->scheduleId, factors};
+  return decision;
+}
+
+/**
+ * 检查窗口超时
+ * @param door 门
+ * @param now 当前时间(ms)
+ * @return 判定
+ */
+MfaDecision mfa_poll(MfaDoor *door, uint32_t now) {
+  if (!door->factors) {
+    MfaDecision decision = {MFA_RESULT_NONE, MFA_REASON_NONE, 0, 0, 0};
+    return decision;
+  }
+
+  if (now - door->startedAt >= door->windowMs) {
+    return mfa_finish(door, MFA_RESULT_DENY, MFA_REASON_TIMEOUT, door->factors);
+  }
+
+  MfaDecision decision = {MFA_RESULT_PENDING, MFA_REASON_NONE, door->userId, door->scheduleId, door->factors};
+  return decision;
+}
+
+/**
+ * 判断门策略是否接受某因素
+ * @param door 门
+ * @param factor 因素
+ * @return 是否接受
+ */
+bool mfa_accepts(const MfaDoor *door, MfaFactor factor) {
+  return (mfaPolicyAllowed[door->policy] & factor) != 0;
+}
+
+/**
+ * 判断门是否在等待其余因素
+ * @param door 门
+ * @return 是否等待中
+ */
+bool mfa_is_pending(const MfaDoor *door) {
+  return door->factors != 0;
+}
+
+/**
+ * 策略名称转换为策略
+ * @param name 名称
+ * @param policy 策略
+ * @return 是否有效
+ */
+bool mfa_policy_from_name(const char *name, MfaPolicy *policy) {
+  if (!name) {
+    return false;
+  }
+  for (int i = 0; i < MFA_POLICY_COUNT; i++) {
+    if (strcmp(name, mfaPolicyNames[i]) == 0) {
+      *policy = (MfaPolicy)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * 获取策略名称
+ * @param policy 策略
+ * @return 名称
+ */
+const char *mfa_policy_name(MfaPolicy policy) {
+  return policy < MFA_POLICY_COUNT ? mfaPolicyNames[policy] : "unknown";
+}
+
+/**
+ * 获取因素组合名称
+ * @param factors 因素
+ * @return 名称
+ */
+const char *mfa_method_name(uint8_t factors) {
+  return mfaMethodNames[factors & 0x0F];
+}
@@ -0,0 +1,134 @@
+#ifndef MFA_H
+#define MFA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 多因素认证：各识别方式的结果作为事件提交，按门的策略在时间窗口内关联
+// 状态机不读取时钟、不阻塞，由调用方传入毫秒时间戳
+
+// 门数量（本控制器使用门0）
+#define MFA_MAX_DOORS  4
+
+// 默认关联窗口(ms)：第一个因素之后须在窗口内完成其余因素
+#define MFA_DEFAULT_WINDOW_MS  15000
+
+// 认证因素（位掩码）
+typedef enum {
+  MFA_FACTOR_CARD   = 0x01,
+  MFA_FACTOR_FINGER = 0x02,
+  MFA_FACTOR_PIN    = 0x04,
+  MFA_FACTOR_FACE   = 0x08
+} MfaFactor;
+
+// 门策略
+typedef enum {
+  MFA_POLICY_ANY_ONE,      // 任一因素（单因素，兼容原有行为；不接受人脸）
+  MFA_POLICY_CARD_ONLY,    // 仅刷卡
+  MFA_POLICY_CARD_PIN,     // 卡 + 密码
+  MFA_POLICY_FINGER_PIN,   // 指纹 + 密码
+  MFA_POLICY_ANY_TWO,      // 任意两种不同因素（人脸须与其他因素组合）
+  MFA_POLICY_COUNT
+} MfaPolicy;
+
+// 判定结果
+typedef enum {
+  MFA_RESULT_NONE,         // 无事件
+  MFA_RESULT_PENDING,      // 等待其余因素
+  MFA_RESULT_GRANT,        // 通过
+  MFA_RESULT_DENY          // 拒绝
+} MfaResult;
+
+// 拒绝原因
+typedef enum {
+  MFA_REASON_NONE,
+  MFA_REASON_UNKNOWN,          // 凭证未匹配用户
+  MFA_REASON_NOT_ALLOWED,      // 该门策略不接受此因素
+  MFA_REASON_USER_MISMATCH,    // 因素属于不同用户
+  MFA_REASON_TIMEOUT           // 窗口内未完成
+} MfaReason;
+
+// 判定
+typedef struct {
+  MfaResult result;
+  MfaReason reason;
+  int userId;              // 通过或已识别的用户，未知为0
+  uint8_t scheduleId;      // 用户时间表ID
+  uint8_t factors;         // 已提交的因素
+} MfaDecision;
+
+// 单门状态
+typedef struct {
+  MfaPolicy policy;
+  uint32_t windowMs;
+  uint8_t factors;         // 当前会话已提交的因素，0表示空闲
+  int userId;
+  uint8_t scheduleId;
+  uint32_t startedAt;      // 会话第一个因素的时间
+} MfaDoor;
+
+/**
+ * 门状态初始化
+ * @param door 门
+ * @param policy 策略
+ * @param windowMs 关联窗口(ms)
+ */
+void mfa_door_init(MfaDoor *door, MfaPolicy policy, uint32_t windowMs);
+
+/**
+ * 提交一个因素
+ * @param door 门
+ * @param factor 因素
+ * @param userId 凭证对应的用户ID，0表示未匹配
+ * @param scheduleId 用户时间表ID
+ * @param now 当前时间(ms)
+ * @return 判定
+ */
+MfaDecision mfa_submit(MfaDoor *door, MfaFactor factor, int userId, uint8_t scheduleId, uint32_t now);
+
+/**
+ * 检查窗口超时
+ * @param door 门
+ * @param now 当前时间(ms)
+ * @return 超时时为MFA_RESULT_DENY，否则为MFA_RESULT_NONE或MFA_RESULT_PENDING
+ */
+MfaDecision mfa_poll(MfaDoor *door, uint32_t now);
+
+/**
+ * 判断门策略是否接受某因素（不接受时提交即拒绝）
+ * @param door 门
+ * @param factor 因素
+ * @return 是否接受
+ */
+bool mfa_accepts(const MfaDoor *door, MfaFactor factor);
+
+/**
+ * 判断门是否在等待其余因素
+ * @param door 门
+ * @return 是否等待中
+ */
+bool mfa_is_pending(const MfaDoor *door);
+
+/**
+ * 策略名称转换为策略
+ * @param name 名称（any / card / card+pin / finger+pin / any_two）
+ * @param policy 策略
+ * @return 是否有效
+ */
+bool mfa_policy_from_name(const char *name, MfaPolicy *policy);
+
+/**
+ * 获取策略名称
+ * @param policy 策略
+ * @return 名称
+ */
+const char *mfa_policy_name(MfaPolicy policy);
+
+/**
+ * 获取因素组合名称（用于门禁记录的识别方式）
+ * @param factors 因素
+ * @return 名称，如 card、card+password
+ */
+const char *mfa_method_name(uint8_t factors);
+
+#endif
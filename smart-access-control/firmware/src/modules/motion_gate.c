@@ -0,0 +1,95 @@
+#include <string.h>
+#include <stdlib.h>
+
+// 头文件包含
+#include "modules/motion_gate.h"
+
+/**
+ * 运动检测初始化
+ * @param gate 运动检测状态
+ */
+void motion_gate_init(MotionGate *gate) {
+  memset(gate, 0, sizeof(*gate));
+  gate->tier = MOTION_TIER_IDLE;
+}
+
+/**
+ * 灰度图按面积平均缩小为格子图
+ * @param gray 灰度图像
+ * @param width 宽度
+ * @param height 高度
+ * @param grid 输出
+ */
+void motion_gate_downsample(const uint8_t *gray, int width, int height, uint8_t *grid) {
+  for (int gy = 0; gy < MOTION_GRID_HEIGHT; gy++) {
+    int y0 = gy * height / MOTION_GRID_HEIGHT;
+    int y1 = (gy + 1) * height / MOTION_GRID_HEIGHT;
+    for (int gx = 0; gx < MOTION_GRID_WIDTH; gx++) {
+      int x0 = gx * width / MOTION_GRID_WIDTH;
+      int x1 = (gx + 1) * width / MOTION_GRID_WIDTH;
+      uint32_t sum = 0;
+      for (int y = y0; y < y1; y++) {
+        const uint8_t *row = gray + y * width;
+        for (int x = x0; x < x1; x++) {
+          sum += row[x];
+        }
+      }
+      grid[gy * MOTION_GRID_WIDTH + gx] = sum / ((x1 - x0) * (y1 - y0));
+    }
+  }
+}
+
+/**
+ * 变化格子数
+ * 先扣除全部格子的平均变化（自动曝光、灯光渐变使整幅画面一起变亮或变暗）
+ */
+static int motion_gate_changed_cells(const uint8_t *reference, const uint8_t *grid) {
+  int32_t total = 0;
+  for (int i = 0; i < MOTION_GRID_CELLS; i++) {
+    total += grid[i] - reference[i];
+  }
+  int32_t offset = total / MOTION_GRID_CELLS;
+
+  int changed = 0;
+  for (int i = 0; i < MOTION_GRID_CELLS; i++) {
+    changed += abs(grid[i] - reference[i] - offset) > MOTION_CELL_THRESHOLD;
+  }
+  return changed;
+}
+
+/**
+ * 处理一帧
+ * @param gate 运动检测状态
+ * @param gray 灰度图像
+ * @param width 宽度
+ * @param height 高度
+ * @param now 当前时间(ms)
+ * @return 级别是否变化
+ */
+bool motion_gate_feed(MotionGate *gate, const uint8_t *gray, int width, int height, uint32_t now) {
+  gate->frames[gate->tier]++;
+
+  uint8_t grid[MOTION_GRID_CELLS];
+  motion_gate_downsample(gray, width, height, grid);
+
+  // 切换分辨率后的第一帧只作为参考帧（不同分辨率的JPEG解码结果不可直接比较）
+  bool comparable = gate->hasReference && width == gate->referenceWidth && height == gate->referenceHeight;
+  gate->changedCells = comparable ? motion_gate_changed_cells(gate->reference, grid) : 0;
+  memcpy(gate->reference, grid, sizeof(grid));
+  gate->hasReference = true;
+  gate->referenceWidth = width;
+  gate->referenceHeight = height;
+
+  if (gate->changedCells >= MOTION_MIN_CELLS) {
+    gate->lastMotion = now;
+    if (gate->tier == MOTION_TIER_IDLE) {
+      gate->tier = MOTION_TIER_ACTIVE;
+      gate->activations++;
+      return true;
+    }
+  } else if (gate->tier == MOTION_TIER_ACTIVE && now - gate->lastMotion >= MOTION_QUIET_MS) {
+    gate->tier = MOTION_TIER_IDLE;
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,73 @@
+#ifndef MOTION_GATE_H
+#define MOTION_GATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 运动检测分级
+// 平时摄像头以低分辨率出帧，只做帧差运动检测；检测到运动后切换到全分辨率并运行人脸识别，
+// 持续无运动一段时间后回到低分辨率。帧差在固定大小的格子图上计算，与帧分辨率无关。
+// 本文件不依赖Arduino，可在主机上用录制的帧序列测试（tools/bench/motion_gate_bench.c）
+
+// 格子图尺寸（80×60低分辨率灰度图每格4×4像素）
+#define MOTION_GRID_WIDTH   20
+#define MOTION_GRID_HEIGHT  15
+#define MOTION_GRID_CELLS   (MOTION_GRID_WIDTH * MOTION_GRID_HEIGHT)
+
+// 格子平均亮度变化阈值（灰度级，已扣除整幅画面的亮度变化）
+#define MOTION_CELL_THRESHOLD  10
+
+// 变化格子数阈值（约占画面2%）
+#define MOTION_MIN_CELLS  6
+
+// 无运动持续该时间(ms)后回到低分辨率
+#define MOTION_QUIET_MS  5000
+
+// 分级
+typedef enum {
+  MOTION_TIER_IDLE,     // 低分辨率，只做运动检测
+  MOTION_TIER_ACTIVE,   // 全分辨率，运动检测 + 人脸识别
+  MOTION_TIER_COUNT
+} MotionTier;
+
+// 运动检测状态
+typedef struct {
+  MotionTier tier;
+  uint8_t reference[MOTION_GRID_CELLS];   // 上一帧格子图
+  bool hasReference;
+  int referenceWidth;                     // 上一帧分辨率（分辨率变化时重新取参考帧）
+  int referenceHeight;
+  uint32_t lastMotion;                    // 最近一次检测到运动的时间(ms)
+  uint16_t changedCells;                  // 最近一帧的变化格子数
+  uint32_t frames[MOTION_TIER_COUNT];     // 各级处理的帧数
+  uint32_t activations;                   // 切换到全分辨率的次数
+} MotionGate;
+
+/**
+ * 运动检测初始化（低分辨率级）
+ * @param gate 运动检测状态
+ */
+void motion_gate_init(MotionGate *gate);
+
+/**
+ * 灰度图按面积平均缩小为格子图
+ * @param gray 灰度图像
+ * @param width 宽度（不小于MOTION_GRID_WIDTH）
+ * @param height 高度（不小于MOTION_GRID_HEIGHT）
+ * @param grid 输出（MOTION_GRID_CELLS字节）
+ */
+void motion_gate_downsample(const uint8_t *gray, int width, int height, uint8_t *grid);
+
+/**
+ * 处理一帧
+ * 帧计入当前级别后与上一帧比较，检测到运动时切换到全分辨率，无运动超过MOTION_QUIET_MS时回到低分辨率
+ * @param gate 运动检测状态
+ * @param gray 灰度图像
+ * @param width 宽度
+ * @param height 高度
+ * @param now 当前时间(ms)
+ * @return 级别是否变化（调用方据此切换摄像头分辨率）
+ */
+bool motion_gate_feed(MotionGate *gate, const uint8_t *gray, int width, int height, uint32_t now);
+
+#endif
@@ -0,0 +1,173 @@
+#include <Arduino.h>
+#include <SD.h>
+#include <time.h>
+
+// 头文件包含
+#include "modules/schedule.h"
+#include "modules/user_db.h"
+#include "modules/storage.h"
+
+// 早于该时间（2023-01-01）视为尚未校时
+#define SCHEDULE_MIN_VALID_TIME  1672531200
+
+// 时间表状态
+bool scheduleLoaded = false;
+ScheduleTable scheduleTable = {0, 0, 0, NULL, NULL};
+uint8_t *scheduleData = NULL;
+
+// 当前时段缓存（同一分钟内不再换算本地时间）
+uint32_t scheduleCachedMinute = 0;
+uint16_t scheduleCachedSlot = SCHEDULE_SLOT_INVALID;
+
+/**
+ * 公历日期转换为1970-01-01起的天数
+ */
+static int32_t schedule_days_from_civil(int year, unsigned month, unsigned day) {
+  year -= month <= 2;
+  int32_t era = (year >= 0 ? year : year - 399) / 400;
+  uint32_t yearOfEra = (uint32_t)(year - era * 400);
+  uint32_t dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+  uint32_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+  return era * 146097 + (int32_t)dayOfEra - 719468;
+}
+
+/**
+ * 解析时间表文件
+ * @param data 文件内容
+ * @param size 长度
+ * @param table 时间表
+ * @return 是否有效
+ */
+bool schedule_parse(const uint8_t *data, size_t size, ScheduleTable *table) {
+  if (size < sizeof(ScheduleFileHeader)) {
+    return false;
+  }
+
+  const ScheduleFileHeader *header = (const ScheduleFileHeader *)data;
+  if (header->magic != SCHEDULE_MAGIC || header->formatVersion != SCHEDULE_FORMAT_VERSION ||
+      header->headerSize < sizeof(ScheduleFileHeader) || header->headerSize % 4 != 0 ||
+      header->scheduleCount > SCHEDULE_MAX_COUNT) {
+    return false;
+  }
+
+  size_t bitmapSize = (size_t)header->scheduleCount * SCHEDULE_WORDS * sizeof(uint32_t);
+  size_t overrideSize = (size_t)header->overrideCount * sizeof(ScheduleOverride);
+  if (header->headerSize + bitmapSize + overrideSize != size) {
+    return false;
+  }
+
+  uint32_t crc = user_db_crc32(0, data, offsetof(ScheduleFileHeader, crc32));
+  crc = user_db_crc32(crc, data + header->headerSize, size - header->headerSize);
+  if (crc != header->crc32) {
+    return false;
+  }
+
+  const ScheduleOverride *overrides = (const ScheduleOverride *)(data + header->headerSize + bitmapSize);
+  for (uint16_t i = 0; i < header->overrideCount; i++) {
+    if (overrides[i].row >= SCHEDULE_ROWS || (i > 0 && overrides[i - 1].day >= overrides[i].day)) {
+      return false;
+    }
+  }
+
+  table->version = header->tableVersion;
+  table->scheduleCount = header->scheduleCount;
+  table->overrideCount = header->overrideCount;
+  table->bitmaps = (const uint32_t (*)[SCHEDULE_WORDS])(data + header->headerSize);
+  table->overrides = overrides;
+  return true;
+}
+
+/**
+ * 时间表初始化
+ * @return 是否加载成功
+ */
+bool schedule_init() {
+  // 本地时区（NTP校时在WiFi连接后启动）
+  setenv("TZ", SCHEDULE_TIMEZONE, 1);
+  tzset();
+
+  if (!storage_is_initialized()) {
+    Serial.println("存储不可用，仅允许不限时间的用户");
+    return false;
+  }
+
+  File file = SD.open(SCHEDULE_FILE, FILE_READ);
+  if (!file) {
+    Serial.println("未找到时间表文件，仅允许不限时间的用户");
+    return false;
+  }
+
+  size_t size = file.size();
+  uint8_t *data = (uint8_t *)malloc(size);
+  if (!data) {
+    file.close();
+    return false;
+  }
+
+  size_t read = file.read(data, size);
+  file.close();
+
+  if (read != size || !schedule_parse(data, size, &scheduleTable)) {
+    Serial.println("时间表文件无效");
+    free(data);
+    return false;
+  }
+
+  scheduleData = data;
+  scheduleLoaded = true;
+  Serial.printf("时间表已加载: 版本=%u, 时间表=%u, 日期覆盖=%u\n",
+               scheduleTable.version, scheduleTable.scheduleCount, scheduleTable.overrideCount);
+  return true;
+}
+
+/**
+ * 获取当前时段
+ * @return 时段，SCHEDULE_SLOT_INVALID表示时间未同步
+ */
+uint16_t schedule_current_slot() {
+  time_t now = time(NULL);
+  if (now < SCHEDULE_MIN_VALID_TIME) {
+    return SCHEDULE_SLOT_INVALID;
+  }
+
+  uint32_t minute = (uint32_t)(now / 60);
+  if (minute == scheduleCachedMinute) {
+    return scheduleCachedSlot;
+  }
+
+  struct tm local;
+  localtime_r(&now, &local);
+  int32_t day = schedule_days_from_civil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday);
+  uint8_t weekday = (local.tm_wday + 6) % 7;
+
+  scheduleCachedSlot = schedule_slot(&scheduleTable, (uint16_t)day, weekday,
+                                     local.tm_hour * 60 + local.tm_min);
+  scheduleCachedMinute = minute;
+  return scheduleCachedSlot;
+}
+
+/**
+ * 判断当前时间是否允许
+ * @param scheduleId 时间表ID
+ * @return 是否允许
+ */
+bool schedule_is_allowed(uint8_t scheduleId) {
+  if (scheduleId == SCHEDULE_ALWAYS) {
+    return true;
+  }
+
+  uint16_t slot = schedule_current_slot();
+  if (slot == SCHEDULE_SLOT_INVALID) {
+    return false;
+  }
+
+  return schedule_test(&scheduleTable, scheduleId, slot);
+}
+
+/**
+ * 获取时间表版本
+ * @return 版本号，未加载时为0
+ */
+uint32_t schedule_get_version() {
+  return scheduleLoaded ? scheduleTable.version : 0;
+}
@@ -0,0 +1,142 @@
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// 时间表由后台编译为位图（tools/schedule_compiler.py），设备端判定只做一次位测试
+// 每个时间表8行 × 96个15分钟时段：第0~6行为周一至周日，第7行为节假日
+#define SCHEDULE_SLOT_MINUTES   15
+#define SCHEDULE_SLOTS_PER_DAY  96
+#define SCHEDULE_ROWS           8
+#define SCHEDULE_HOLIDAY_ROW    7
+#define SCHEDULE_SLOTS          (SCHEDULE_ROWS * SCHEDULE_SLOTS_PER_DAY)
+#define SCHEDULE_WORDS          (SCHEDULE_SLOTS / 32)
+
+// 时间表ID：0表示不限时间，其余为时间表文件中的下标加1
+#define SCHEDULE_ALWAYS  0
+#define SCHEDULE_MAX_COUNT  255
+
+// 无效时段（时间未同步）
+#define SCHEDULE_SLOT_INVALID  0xFFFF
+
+// 时间表文件（SD卡）
+#define SCHEDULE_FILE  "/schedules.bin"
+#define SCHEDULE_MAGIC  0x44484353  // "SCHD"
+#define SCHEDULE_FORMAT_VERSION  1
+
+// 时区（POSIX TZ）及NTP服务器
+#define SCHEDULE_TIMEZONE    "CST-8"
+#define SCHEDULE_NTP_SERVER  "pool.ntp.org"
+
+// 文件头
+typedef struct __attribute__((packed)) {
+  uint32_t magic;
+  uint16_t formatVersion;
+  uint16_t headerSize;
+  uint32_t tableVersion;     // 时间表版本
+  uint16_t scheduleCount;    // 位图数量（ID 1..scheduleCount）
+  uint16_t overrideCount;    // 日期覆盖条目数量
+  uint32_t crc32;            // 头（不含本字段）及后续全部数据的CRC32
+} ScheduleFileHeader;
+
+// 日期覆盖：节假日使用节假日行，调休工作日使用指定星期行
+typedef struct __attribute__((packed)) {
+  uint16_t day;              // 本地日期，1970-01-01起的天数
+  uint8_t row;               // 使用的位图行（0~7）
+  uint8_t reserved;
+} ScheduleOverride;
+
+// 时间表
+typedef struct {
+  uint32_t version;
+  uint16_t scheduleCount;
+  uint16_t overrideCount;
+  const uint32_t (*bitmaps)[SCHEDULE_WORDS];   // bitmaps[id - 1]
+  const ScheduleOverride *overrides;           // 按day升序
+} ScheduleTable;
+
+/**
+ * 时段位测试
+ * @param table 时间表
+ * @param scheduleId 时间表ID
+ * @param slot 时段（行 × 96 + 当日时段）
+ * @return 是否允许
+ */
+static inline bool schedule_test(const ScheduleTable *table, uint8_t scheduleId, uint16_t slot) {
+  if (scheduleId == SCHEDULE_ALWAYS) {
+    return true;
+  }
+  if (scheduleId > table->scheduleCount || slot >= SCHEDULE_SLOTS) {
+    return false;
+  }
+  return (table->bitmaps[scheduleId - 1][slot >> 5] >> (slot & 31)) & 1;
+}
+
+/**
+ * 计算时段
+ * @param table 时间表
+ * @param day 本地日期（1970-01-01起的天数）
+ * @param weekday 星期（0为周一）
+ * @param minuteOfDay 当日分钟数
+ * @return 时段
+ */
+static inline uint16_t schedule_slot(const ScheduleTable *table, uint16_t day, uint8_t weekday, uint16_t minuteOfDay) {
+  uint8_t row = weekday;
+
+  // 日期覆盖（节假日、调休）
+  uint32_t low = 0;
+  uint32_t high = table->overrideCount;
+  while (low < high) {
+    uint32_t mid = low + (high - low) / 2;
+    if (table->overrides[mid].day < day) {
+      low = mid + 1;
+    } else if (table->overrides[mid].day > day) {
+      high = mid;
+    } else {
+      row = table->overrides[mid].row;
+      break;
+    }
+  }
+
+  return row * SCHEDULE_SLOTS_PER_DAY + minuteOfDay / SCHEDULE_SLOT_MINUTES;
+}
+
+/**
+ * 解析时间表文件
+ * @param data 文件内容（解析后被时间表引用，须保持有效）
+ * @param size 长度
+ * @param table 时间表
+ * @return 是否有效
+ */
+bool schedule_parse(const uint8_t *data, size_t size, ScheduleTable *table);
+
+/**
+ * 时间表初始化
+ * 从SD卡加载时间表并启动NTP校时，须在存储模块之后调用
+ * @return 是否加载成功
+ */
+bool schedule_init();
+
+/**
+ * 获取当前时段
+ * 同一分钟内复用缓存，跨日时重新查找日期覆盖
+ * @return 时段，SCHEDULE_SLOT_INVALID表示时间未同步
+ */
+uint16_t schedule_current_slot();
+
+/**
+ * 判断当前时间是否允许
+ * @param scheduleId 时间表ID
+ * @return 是否允许（时间未同步时只允许SCHEDULE_ALWAYS）
+ */
+bool schedule_is_allowed(uint8_t scheduleId);
+
+/**
+ * 获取时间表版本
+ * @return 版本号，未加载时为0
+ */
+uint32_t schedule_get_version();
+
+#endif
@@ -1,5 +1,14 @@
 #include <Arduino.h>
 #include <WiFi.h>
+#include <mbedtls/sha256.h>
+
+// 头文件包含
+#include "drivers/buzzer_driver.h"
+#include "drivers/lock_driver.h"
+#include "drivers/sensor_driver.h"
+#include "modules/security.h"
+#include "modules/event_capture.h"
+#include "modules/door_monitor.h"
 
 // 安全模块状态
 bool securityInitialized = false;
@@ -14,10 +23,88 @@ ulong lockoutStartTime = 0;
 bool isLockedOut = false;
 bool tamperDetected = false;
 
+// 防拆：已处理的触发次数（与传感器驱动的计数比较，包括已恢复的短暂触发）
+uint32_t securityTamperHandled = 0;
+
+// 门状态关联（本控制器的门磁和锁对应门0）
+// 门磁事件和到时判断在安全任务中进行，锁状态由改变锁状态的任务写入
+#define SECURITY_DOOR 0
+DoorMonitor doorMonitors[DOOR_MONITOR_MAX_DOORS];
+portMUX_TYPE doorMonitorMux = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * 锁状态变化（改变锁状态的任务中调用）
+ * @param locked 是否关锁
+ */
+static void security_lock_changed(bool locked) {
+  portENTER_CRITICAL(&doorMonitorMux);
+  door_monitor_lock(&doorMonitors[SECURITY_DOOR], locked, millis());
+  portEXIT_CRITICAL(&doorMonitorMux);
+}
+
+/**
+ * 处理门报警（安全任务中调用）
+ * @param actions 判断结果（DOOR_ACTION_*）
+ */
+static void security_handle_door_actions(uint8_t actions) {
+  extern void communication_publish_alarm(const char*, const char*);
+  if (actions & DOOR_ACTION_FORCED) {
+    Serial.println("检测到强行开门");
+    buzzer_play(TONE_PATTERN_TAMPER);
+    event_capture_trigger(EVENT_CAPTURE_FORCED);
+    communication_publish_alarm("forced_entry", "门在关锁状态下被打开");
+  }
+  if (actions & DOOR_ACTION_HELD_OPEN) {
+    Serial.println("门长时间未关");
+    buzzer_play(TONE_PATTERN_HELD_OPEN);
+    communication_publish_alarm("door_held_open", "门打开时间超过设定值");
+  }
+  if (actions & DOOR_ACTION_HELD_OPEN_CLEAR) {
+    Serial.println("长时间未关的门已关上");
+    buzzer_stop(TONE_PATTERN_HELD_OPEN);
+    extern void communication_publish_event(PubSubClient*, const char*, const char*, const char*);
+    extern PubSubClient mqttClient;
+    communication_publish_event(&mqttClient, "ESP32-ACCESS-CONTROL-001", "door_held_open_clear", "门已关上");
+  }
+}
+
+/**
+ * 检查防拆状态（触发次数变化说明期间有过触发，包括已恢复的短暂触发）
+ */
+static void security_check_tamper() {
+  bool currentTamper = sensor_check_tamper_status();
+  uint32_t tamperCount = sensor_get_tamper_count();
+  
+  if (tamperCount != securityTamperHandled || (currentTamper && !tamperDetected)) {
+    securityTamperHandled = tamperCount;
+    tamperDetected = true;
+    security_handle_tamper();
+  }
+  if (!currentTamper && tamperDetected) {
+    tamperDetected = false;
+    security_handle_tamper_clear();
+  }
+}
+
 /**
  * 安全模块初始化
  */
 void security_init() {
+  securityTamperHandled = sensor_get_tamper_count();
+
+  // 门状态关联：锁状态变化和门磁事件到来时立即判断
+  uint32_t now = millis();
+  for (int i = 0; i < DOOR_MONITOR_MAX_DOORS; i++) {
+    door_monitor_init(&doorMonitors[i], DOOR_HELD_OPEN_DEFAULT_MS, true, false, now);
+  }
+  door_monitor_init(&doorMonitors[SECURITY_DOOR], DOOR_HELD_OPEN_DEFAULT_MS, lock_get_state() != 1,
+                    sensor_get_door_status(), now);
+  lock_set_callback(security_lock_changed);
+
+  if (strcmp(SECURITY_DEVICE_KEY, "smart-access-control-default-key") == 0) {
+    Serial.println("警告: 未设置设备密钥（SECURITY_DEVICE_KEY），SD卡文件校验使用默认密钥");
+  }
+
   securityInitialized = true;
   Serial.println("安全模块初始化完成");
 }
@@ -33,22 +120,99 @@ void security_check() {
   // 检查锁定状态
   security_check_lockout();
   
-  // 检查防拆状态
-  extern bool sensor_check_tamper_status();
-  bool currentTamper = sensor_check_tamper_status();
-  
-  if (currentTamper && !tamperDetected) {
-    tamperDetected = true;
-    security_handle_tamper();
-  } else if (!currentTamper && tamperDetected) {
-    tamperDetected = false;
-    security_handle_tamper_clear();
-  }
+  // 检查防拆状态（防拆事件丢失时兜底）
+  security_check_tamper();
   
   // 检查网络安全
   security_check_network();
 }
 
+/**
+ * 处理事件总线事件（安全任务中调用）
+ * @param event 事件
+ */
+void security_handle_event(const BusEvent *event) {
+  if (!securityInitialized) {
+    return;
+  }
+  
+  if (event->type == BUS_EVENT_DOOR) {
+    // 按边沿时间判断，门长时间未关从打开时刻起计时
+    portENTER_CRITICAL(&doorMonitorMux);
+    uint8_t actions = door_monitor_door(&doorMonitors[SECURITY_DOOR], event->active, event->timestamp);
+    portEXIT_CRITICAL(&doorMonitorMux);
+    security_handle_door_actions(actions);
+  } else if (event->type == BUS_EVENT_TAMPER) {
+    security_check_tamper();
+  }
+}
+
+/**
+ * 到时判断（门长时间未关，安全任务每次唤醒时调用）
+ */
+void security_poll() {
+  if (!securityInitialized) {
+    return;
+  }
+  
+  portENTER_CRITICAL(&doorMonitorMux);
+  uint8_t actions = door_monitor_poll(&doorMonitors[SECURITY_DOOR], millis());
+  portEXIT_CRITICAL(&doorMonitorMux);
+  security_handle_door_actions(actions);
+}
+
+/**
+ * 距下一次到时判断的时间
+ * @return 时间(ms)，EVENT_BUS_WAIT_FOREVER表示无需定时
+ */
+uint32_t security_next_wait() {
+  portENTER_CRITICAL(&doorMonitorMux);
+  uint32_t wait = door_monitor_deadline(&doorMonitors[SECURITY_DOOR], millis());
+  portEXIT_CRITICAL(&doorMonitorMux);
+  return wait == DOOR_MONITOR_NONE ? EVENT_BUS_WAIT_FOREVER : wait;
+}
+
+/**
+ * 设置门长时间未关阈值
+ * 门已打开时新阈值在安全任务下一次唤醒时生效（不超过安全检查周期）
+ * @param door 门编号
+ * @param heldOpenMs 阈值(ms)
+ * @return 是否成功
+ */
+bool security_set_door_held_open(int door, uint32_t heldOpenMs) {
+  if (door < 0 || door >= DOOR_MONITOR_MAX_DOORS) {
+    return false;
+  }
+
+  portENTER_CRITICAL(&doorMonitorMux);
+  bool ok = door_monitor_set_held_open(&doorMonitors[door], heldOpenMs);
+  portEXIT_CRITICAL(&doorMonitorMux);
+  if (!ok) {
+    return false;
+  }
+
+  Serial.printf("门 %d 长时间未关阈值: %u ms\n", door, heldOpenMs);
+  return true;
+}
+
+/**
+ * 获取门状态关联统计
+ * @param door 门编号
+ * @param forced 强行开门次数
+ * @param heldOpen 门长时间未关次数
+ */
+void security_get_door_stats(int door, uint32_t *forced, uint32_t *heldOpen) {
+  *forced = 0;
+  *heldOpen = 0;
+  if (door < 0 || door >= DOOR_MONITOR_MAX_DOORS) {
+    return;
+  }
+  portENTER_CRITICAL(&doorMonitorMux);
+  *forced = doorMonitors[door].forcedCount;
+  *heldOpen = doorMonitors[door].heldOpenCount;
+  portEXIT_CRITICAL(&doorMonitorMux);
+}
+
 /**
  * 检查锁定状态
  */
@@ -103,9 +267,11 @@ void security_lockout() {
   
   Serial.printf("系统已锁定，持续时间: %d秒\n", LOCKOUT_DURATION / 1000);
   
-  // 蜂鸣器报警
-  extern void lock_buzzer_alarm(unsigned long, unsigned int);
-  lock_buzzer_alarm(2000, 1000);
+  // 蜂鸣器报警（不等待）
+  buzzer_play(TONE_PATTERN_LOCKOUT);
+  
+  // 冻结锁定前后的摄像头画面
+  event_capture_trigger(EVENT_CAPTURE_LOCKOUT);
   
   // 发送报警信息
   extern void communication_publish_alarm(const char*, const char*);
@@ -122,9 +288,11 @@ void security_handle_tamper() {
   
   Serial.println("检测到防拆触发");
   
-  // 蜂鸣器报警
-  extern void lock_buzzer_alarm(unsigned long, unsigned int);
-  lock_buzzer_alarm(3000, 800);
+  // 蜂鸣器报警（不等待）
+  buzzer_play(TONE_PATTERN_TAMPER);
+  
+  // 冻结防拆前后的摄像头画面
+  event_capture_trigger(EVENT_CAPTURE_TAMPER);
   
   // 发送报警信息
   extern void communication_publish_alarm(const char*, const char*);
@@ -202,6 +370,76 @@ byte* security_decrypt(byte *data, int length, byte *key) {
   return decrypted;
 }
 
+/**
+ * 计算消息认证码
+ * @param head 头部（可为NULL）
+ * @param headLength 头部长度
+ * @param data 数据
+ * @param length 数据长度
+ * @param mac 输出认证码
+ */
+void security_mac(const uint8_t *head, size_t headLength, const uint8_t *data, size_t length,
+                  uint8_t mac[SECURITY_MAC_SIZE]) {
+  // 密钥补零到一个分组（64字节），超过一个分组时先取摘要
+  uint8_t pad[64];
+  memset(pad, 0, sizeof(pad));
+  size_t keyLength = strlen(SECURITY_DEVICE_KEY);
+  mbedtls_sha256_context ctx;
+  mbedtls_sha256_init(&ctx);
+  if (keyLength > sizeof(pad)) {
+    mbedtls_sha256_starts_ret(&ctx, 0);
+    mbedtls_sha256_update_ret(&ctx, (const uint8_t *)SECURITY_DEVICE_KEY, keyLength);
+    mbedtls_sha256_finish_ret(&ctx, pad);
+  } else {
+    memcpy(pad, SECURITY_DEVICE_KEY, keyLength);
+  }
+
+  uint8_t inner[SECURITY_MAC_SIZE];
+
+  // H((K ^ ipad) || head || data)
+  for (size_t i = 0; i < sizeof(pad); i++) {
+    pad[i] ^= 0x36;
+  }
+  mbedtls_sha256_starts_ret(&ctx, 0);
+  mbedtls_sha256_update_ret(&ctx, pad, sizeof(pad));
+  if (head && headLength > 0) {
+    mbedtls_sha256_update_ret(&ctx, head, headLength);
+  }
+  mbedtls_sha256_update_ret(&ctx, data, length);
+  mbedtls_sha256_finish_ret(&ctx, inner);
+
+  // H((K ^ opad) || inner)
+  for (size_t i = 0; i < sizeof(pad); i++) {
+    pad[i] ^= 0x36 ^ 0x5C;
+  }
+  mbedtls_sha256_starts_ret(&ctx, 0);
+  mbedtls_sha256_update_ret(&ctx, pad, sizeof(pad));
+  mbedtls_sha256_update_ret(&ctx, inner, sizeof(inner));
+  mbedtls_sha256_finish_ret(&ctx, mac);
+  mbedtls_sha256_free(&ctx);
+}
+
+/**
+ * 校验消息认证码
+ * @param head 头部（可为NULL）
+ * @param headLength 头部长度
+ * @param data 数据
+ * @param length 数据长度
+ * @param mac 待校验的认证码
+ * @return 是否一致
+ */
+bool security_mac_verify(const uint8_t *head, size_t headLength, const uint8_t *data, size_t length,
+                         const uint8_t mac[SECURITY_MAC_SIZE]) {
+  uint8_t expected[SECURITY_MAC_SIZE];
+  security_mac(head, headLength, data, length, expected);
+
+  uint8_t diff = 0;
+  for (int i = 0; i < SECURITY_MAC_SIZE; i++) {
+    diff |= expected[i] ^ mac[i];
+  }
+  return diff == 0;
+}
+
 /**
  * 获取安全状态
  * @param status 状态缓冲区
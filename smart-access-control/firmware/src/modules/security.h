@@ -2,6 +2,16 @@
 #define SECURITY_H
 
 #include <Arduino.h>
+#include "modules/event_bus.h"
+
+// 设备密钥：校验SD卡等可拆卸存储上的文件，不随文件保存
+// 各设备应在构建选项中指定：-D SECURITY_DEVICE_KEY=\"...\"
+#ifndef SECURITY_DEVICE_KEY
+#define SECURITY_DEVICE_KEY  "smart-access-control-default-key"
+#endif
+
+// 消息认证码长度（HMAC-SHA256）
+#define SECURITY_MAC_SIZE  32
 
 /**
  * 安全模块初始化
@@ -13,6 +23,49 @@ void security_init();
  */
 void security_check();
 
+/**
+ * 处理事件总线事件（门磁、防拆）
+ * @param event 事件
+ */
+void security_handle_event(const BusEvent *event);
+
+/**
+ * 到时判断（门长时间未关）
+ */
+void security_poll();
+
+/**
+ * 距下一次到时判断的时间
+ * @return 时间(ms)，EVENT_BUS_WAIT_FOREVER表示无需定时
+ */
+uint32_t security_next_wait();
+
+/**
+ * 设置门长时间未关阈值
+ * @param door 门编号
+ * @param heldOpenMs 阈值(ms)，DOOR_HELD_OPEN_MIN_MS ~ DOOR_HELD_OPEN_MAX_MS
+ * @return 是否成功
+ */
+bool security_set_door_held_open(int door, uint32_t heldOpenMs);
+
+/**
+ * 获取门状态关联统计
+ * @param door 门编号
+ * @param forced 强行开门次数
+ * @param heldOpen 门长时间未关次数
+ */
+void security_get_door_stats(int door, uint32_t *forced, uint32_t *heldOpen);
+
+/**
+ * 检查锁定状态
+ */
+void security_check_lockout();
+
+/**
+ * 检查网络安全
+ */
+void security_check_network();
+
 /**
  * 处理识别失败
  */
@@ -56,6 +109,30 @@ byte* security_encrypt(byte *data, int length, byte *key);
  */
 byte* security_decrypt(byte *data, int length, byte *key);
 
+/**
+ * 计算消息认证码
+ * HMAC-SHA256(设备密钥, head || data)
+ * @param head 头部（可为NULL）
+ * @param headLength 头部长度
+ * @param data 数据
+ * @param length 数据长度
+ * @param mac 输出认证码
+ */
+void security_mac(const uint8_t *head, size_t headLength, const uint8_t *data, size_t length,
+                  uint8_t mac[SECURITY_MAC_SIZE]);
+
+/**
+ * 校验消息认证码（比较时间与内容无关）
+ * @param head 头部（可为NULL）
+ * @param headLength 头部长度
+ * @param data 数据
+ * @param length 数据长度
+ * @param mac 待校验的认证码
+ * @return 是否一致
+ */
+bool security_mac_verify(const uint8_t *head, size_t headLength, const uint8_t *data, size_t length,
+                         const uint8_t mac[SECURITY_MAC_SIZE]);
+
 /**
  * 获取安全状态
  * @param status 状态缓冲区
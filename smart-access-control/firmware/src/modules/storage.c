@@ -13,6 +13,9 @@ bool storageInitialized = false;
 #define CONFIG_FILE "/config.json"
 #define USERS_FILE  "/users.json"
 
+const char* getCardTypeString(uint8_t cardType);
+void getTimestamp(char *buffer, int size);
+
 /**
  * 存储模块初始化
  */
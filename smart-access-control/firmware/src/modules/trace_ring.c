@@ -0,0 +1,170 @@
+#include <string.h>
+
+// 头文件包含
+#include "modules/trace_ring.h"
+
+/**
+ * 延迟所在的桶
+ */
+static int trace_histogram_bucket(uint32_t us) {
+  if (us < 4) {
+    return us;
+  }
+  int exponent = 31 - __builtin_clz(us);
+  int bucket = 4 * (exponent - 1) + ((us >> (exponent - 2)) & 3);
+  return bucket < TRACE_HISTOGRAM_BUCKETS ? bucket : TRACE_HISTOGRAM_BUCKETS - 1;
+}
+
+/**
+ * 桶的上界(us)
+ */
+static uint32_t trace_histogram_upper(int bucket) {
+  if (bucket < 4) {
+    return bucket;
+  }
+  int exponent = bucket / 4 + 1;
+  return ((uint32_t)(5 + bucket % 4) << (exponent - 2)) - 1;
+}
+
+/**
+ * 初始化环形缓冲区
+ * @param ring 环形缓冲区
+ */
+void trace_ring_init(TraceRing *ring) {
+  memset(ring, 0, sizeof(*ring));
+}
+
+/**
+ * 读出跟踪点（只能有一个读取方）
+ * @param ring 环形缓冲区
+ * @param points 输出缓冲区
+ * @param max 输出缓冲区容量
+ * @return 读出的跟踪点数，等于max时可能还有未读的
+ */
+int trace_ring_drain(TraceRing *ring, TracePoint *points, int max) {
+  uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+  if (head - ring->tail > TRACE_RING_SIZE) {
+    ring->dropped += head - ring->tail - TRACE_RING_SIZE;
+    ring->tail = head - TRACE_RING_SIZE;
+  }
+
+  int count = 0;
+  while (ring->tail != head && count < max) {
+    TracePoint *slot = &ring->points[ring->tail & (TRACE_RING_SIZE - 1)];
+    uint32_t expected = ring->tail + 1;
+    uint32_t sequence = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+
+    if (sequence == expected) {
+      TracePoint point = *slot;
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      if (__atomic_load_n(&slot->sequence, __ATOMIC_RELAXED) == expected) {
+        point.sequence = expected;
+        points[count++] = point;
+      } else {
+        ring->dropped++;
+      }
+      ring->tail++;
+      continue;
+    }
+
+    // 序号更新：已被下一圈覆盖
+    if (sequence != 0 && (int32_t)(sequence - expected) > 0) {
+      ring->dropped++;
+      ring->tail++;
+      continue;
+    }
+
+    // 正在写入：写入方领先一圈以上时是覆盖，否则等下次读取
+    uint32_t latest = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    if (latest - ring->tail > TRACE_RING_SIZE) {
+      ring->dropped++;
+      ring->tail++;
+      continue;
+    }
+    break;
+  }
+  return count;
+}
+
+/**
+ * 初始化跟踪串联状态
+ * @param chain 串联状态
+ */
+void trace_chain_init(TraceChain *chain) {
+  memset(chain, 0, sizeof(*chain));
+}
+
+/**
+ * 串联一个跟踪点
+ * @param chain 串联状态
+ * @param point 跟踪点
+ * @param firstStage 起始阶段
+ * @param totalStage 计入端到端延迟的阶段
+ * @param cyclesPerUs 每微秒周期数
+ * @param segments 各阶段直方图（按阶段索引）
+ * @param total 端到端直方图
+ * @return 是否计入
+ */
+bool trace_chain_feed(TraceChain *chain, const TracePoint *point, uint8_t firstStage, uint8_t totalStage,
+                      uint32_t cyclesPerUs, TraceHistogram *segments, TraceHistogram *total) {
+  if (point->trace == 0) {
+    return false;
+  }
+
+  if (point->stage == firstStage) {
+    chain->trace = point->trace;
+    chain->stage = point->stage;
+    chain->startCycles = point->cycles;
+    chain->lastCycles = point->cycles;
+    return true;
+  }
+
+  // 其他核或已结束的跟踪、重复或倒序的阶段
+  if (point->trace != chain->trace || point->stage <= chain->stage) {
+    return false;
+  }
+
+  trace_histogram_record(&segments[point->stage], (point->cycles - chain->lastCycles) / cyclesPerUs);
+  if (point->stage == totalStage) {
+    trace_histogram_record(total, (point->cycles - chain->startCycles) / cyclesPerUs);
+  }
+  chain->stage = point->stage;
+  chain->lastCycles = point->cycles;
+  return true;
+}
+
+/**
+ * 记录一个延迟
+ * @param histogram 直方图
+ * @param us 延迟(us)
+ */
+void trace_histogram_record(TraceHistogram *histogram, uint32_t us) {
+  histogram->buckets[trace_histogram_bucket(us)]++;
+  histogram->count++;
+  if (us > histogram->maxUs) {
+    histogram->maxUs = us;
+  }
+}
+
+/**
+ * 延迟百分位（桶上界，不超过最大值）
+ * @param histogram 直方图
+ * @param percent 百分位(1~100)
+ * @return 延迟(us)，无样本时为0
+ */
+uint32_t trace_histogram_percentile(const TraceHistogram *histogram, uint32_t percent) {
+  if (histogram->count == 0) {
+    return 0;
+  }
+
+  uint32_t target = (uint32_t)(((uint64_t)histogram->count * percent + 99) / 100);
+  uint32_t seen = 0;
+  for (int i = 0; i < TRACE_HISTOGRAM_BUCKETS - 1; i++) {
+    seen += histogram->buckets[i];
+    if (seen >= target) {
+      uint32_t upper = trace_histogram_upper(i);
+      return upper < histogram->maxUs ? upper : histogram->maxUs;
+    }
+  }
+  return histogram->maxUs;
+}
@@ -0,0 +1,122 @@
+#ifndef TRACE_RING_H
+#define TRACE_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 跟踪点环形缓冲区与延迟直方图
+// 跟踪点（周期计数、跟踪编号、阶段）写入无锁环形缓冲区：写入方原子递增写位置占用槽位，
+// 先清序号再写数据、最后写序号发布，同一个核上的多个任务和读取方之间不加锁；
+// 读取方（单个）按序号校验槽位，未写完的等下次读取，被覆盖的计入丢弃。
+// 读出的跟踪点按跟踪编号串联，相邻阶段的周期差计入该阶段的直方图（对数分桶，每倍程4个桶）。
+// 周期计数为32位，单段超过 2^32 个周期（240MHz下约17.9s）时回绕，不适用于长时间的区间。
+// 本文件不依赖Arduino，可在主机上编译测试（tools/bench/trace_ring_bench.c）
+
+// 环形缓冲区槽位数（2的幂）
+#define TRACE_RING_SIZE  128
+
+// 直方图桶数：0~3us各一个桶，之后每倍程4个桶，最后一个桶收容约1s以上的值
+#define TRACE_HISTOGRAM_BUCKETS  80
+
+// 跟踪点
+typedef struct {
+  uint32_t cycles;        // 周期计数
+  uint16_t trace;         // 跟踪编号，0表示不跟踪
+  uint8_t stage;          // 阶段
+  uint32_t sequence;      // 写入序号+1，0表示正在写入
+} TracePoint;
+
+// 环形缓冲区（每个核一个）
+typedef struct {
+  TracePoint points[TRACE_RING_SIZE];
+  uint32_t head;          // 已占用的写入序号（写入方原子递增）
+  uint32_t tail;          // 下一个读取序号（只有读取方访问）
+  uint32_t dropped;       // 读取前被覆盖的跟踪点数（只有读取方访问）
+} TraceRing;
+
+// 延迟直方图(us)
+typedef struct {
+  uint32_t count;
+  uint32_t maxUs;
+  uint32_t buckets[TRACE_HISTOGRAM_BUCKETS];
+} TraceHistogram;
+
+// 跟踪串联状态（每个环形缓冲区一个）
+typedef struct {
+  uint16_t trace;         // 当前跟踪编号
+  uint8_t stage;          // 最近的阶段
+  uint32_t startCycles;   // 起始阶段的周期计数
+  uint32_t lastCycles;    // 最近阶段的周期计数
+} TraceChain;
+
+/**
+ * 写入跟踪点（可在多个任务中同时调用）
+ * @param ring 环形缓冲区
+ * @param cycles 周期计数
+ * @param trace 跟踪编号
+ * @param stage 阶段
+ */
+static inline void trace_ring_push(TraceRing *ring, uint32_t cycles, uint16_t trace, uint8_t stage) {
+  uint32_t index = __atomic_fetch_add(&ring->head, 1, __ATOMIC_RELAXED);
+  TracePoint *point = &ring->points[index & (TRACE_RING_SIZE - 1)];
+  __atomic_store_n(&point->sequence, 0, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  point->cycles = cycles;
+  point->trace = trace;
+  point->stage = stage;
+  __atomic_store_n(&point->sequence, index + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * 初始化环形缓冲区
+ * @param ring 环形缓冲区
+ */
+void trace_ring_init(TraceRing *ring);
+
+/**
+ * 读出跟踪点（只能有一个读取方）
+ * @param ring 环形缓冲区
+ * @param points 输出缓冲区
+ * @param max 输出缓冲区容量
+ * @return 读出的跟踪点数，等于max时可能还有未读的
+ */
+int trace_ring_drain(TraceRing *ring, TracePoint *points, int max);
+
+/**
+ * 初始化跟踪串联状态
+ * @param chain 串联状态
+ */
+void trace_chain_init(TraceChain *chain);
+
+/**
+ * 串联一个跟踪点
+ * 起始阶段开始新的跟踪；同一跟踪中阶段递增的跟踪点计入 segments[阶段]（与上一阶段的间隔），
+ * 到达 totalStage 时另计入 total（与起始阶段的间隔）；其他跟踪点忽略
+ * @param chain 串联状态
+ * @param point 跟踪点
+ * @param firstStage 起始阶段
+ * @param totalStage 计入端到端延迟的阶段
+ * @param cyclesPerUs 每微秒周期数
+ * @param segments 各阶段直方图（按阶段索引）
+ * @param total 端到端直方图
+ * @return 是否计入
+ */
+bool trace_chain_feed(TraceChain *chain, const TracePoint *point, uint8_t firstStage, uint8_t totalStage,
+                      uint32_t cyclesPerUs, TraceHistogram *segments, TraceHistogram *total);
+
+/**
+ * 记录一个延迟
+ * @param histogram 直方图
+ * @param us 延迟(us)
+ */
+void trace_histogram_record(TraceHistogram *histogram, uint32_t us);
+
+/**
+ * 延迟百分位（桶上界，不超过最大值）
+ * @param histogram 直方图
+ * @param percent 百分位(1~100)
+ * @return 延迟(us)，无样本时为0
+ */
+uint32_t trace_histogram_percentile(const TraceHistogram *histogram, uint32_t percent);
+
+#endif
@@ -0,0 +1,403 @@
+#include <Arduino.h>
+#include <esp_partition.h>
+#include <esp_spi_flash.h>
+#include <mbedtls/sha256.h>
+
+// 头文件包含
+#include "modules/user_db.h"
+
+// 用户库状态
+bool userDbMounted = false;
+
+// 映射信息
+const uint8_t *userDbImage = NULL;
+spi_flash_mmap_handle_t userDbMapHandle;
+
+// 半字节CRC32表（多项式0xEDB88320）
+static const uint32_t crcTable[16] = {
+  0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+  0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+  0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+  0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+/**
+ * 获取镜像头
+ */
+static const UserDbHeader *user_db_header() {
+  return (const UserDbHeader *)userDbImage;
+}
+
+/**
+ * 检查分段是否在镜像范围内
+ * @param header 镜像头
+ * @param offset 分段偏移
+ * @param count 条目数量
+ * @param entrySize 条目大小
+ * @return 是否有效
+ */
+static bool user_db_check_section(const UserDbHeader *header, uint32_t offset,
+                                  uint32_t count, size_t entrySize) {
+  if (count == 0) {
+    return true;
+  }
+  if (offset < header->headerSize || offset % USER_DB_PAGE_SIZE != 0) {
+    return false;
+  }
+  return (uint64_t)offset + (uint64_t)count * entrySize <= header->imageSize;
+}
+
+/**
+ * 计算CRC32（与zlib.crc32一致）
+ * @param crc 初始值
+ * @param data 数据
+ * @param length 长度
+ * @return CRC32
+ */
+uint32_t user_db_crc32(uint32_t crc, const uint8_t *data, size_t length) {
+  crc = ~crc;
+  for (size_t i = 0; i < length; i++) {
+    crc = crcTable[(crc ^ data[i]) & 0x0F] ^ (crc >> 4);
+    crc = crcTable[(crc ^ (data[i] >> 4)) & 0x0F] ^ (crc >> 4);
+  }
+  return ~crc;
+}
+
+/**
+ * 校验镜像
+ * @param image 镜像地址
+ * @param size 可用长度
+ * @return 是否有效
+ */
+bool user_db_validate(const uint8_t *image, size_t size) {
+  if (size < sizeof(UserDbHeader)) {
+    return false;
+  }
+
+  const UserDbHeader *header = (const UserDbHeader *)image;
+  if (header->magic != USER_DB_MAGIC) {
+    Serial.println("用户库镜像标识无效");
+    return false;
+  }
+  if (header->formatVersion != USER_DB_FORMAT_VERSION ||
+      header->headerSize != sizeof(UserDbHeader)) {
+    Serial.printf("用户库镜像格式不支持: %d\n", header->formatVersion);
+    return false;
+  }
+  if (header->imageSize > size || header->imageSize < header->headerSize) {
+    Serial.println("用户库镜像长度无效");
+    return false;
+  }
+
+  // 检查分段范围
+  if (!user_db_check_section(header, header->userOffset, header->userCount, sizeof(UserDbUser)) ||
+      !user_db_check_section(header, header->cardOffset, header->cardCount, sizeof(UserDbCardEntry)) ||
+      !user_db_check_section(header, header->fingerprintOffset, header->fingerprintCount,
+                             sizeof(UserDbFingerprintEntry)) ||
+      !user_db_check_section(header, header->passwordOffset, header->passwordCount,
+                             sizeof(UserDbPasswordEntry))) {
+    Serial.println("用户库镜像分段越界");
+    return false;
+  }
+
+  // 校验CRC
+  uint32_t crc = user_db_crc32(0, image, offsetof(UserDbHeader, crc32));
+  crc = user_db_crc32(crc, image + header->headerSize, header->imageSize - header->headerSize);
+  if (crc != header->crc32) {
+    Serial.printf("用户库镜像CRC错误: 0x%08X != 0x%08X\n", crc, header->crc32);
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * 映射并校验用户库分区
+ * @return 是否成功
+ */
+bool user_db_mount() {
+  if (userDbMounted) {
+    return true;
+  }
+
+  const esp_partition_t *partition = esp_partition_find_first(
+      ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)USER_DB_PARTITION_SUBTYPE,
+      USER_DB_PARTITION_LABEL);
+  if (!partition) {
+    Serial.println("未找到用户库分区");
+    return false;
+  }
+
+  // 只读映射整个分区
+  const void *mapped = NULL;
+  esp_err_t err = esp_partition_mmap(partition, 0, partition->size, SPI_FLASH_MMAP_DATA,
+                                     &mapped, &userDbMapHandle);
+  if (err != ESP_OK) {
+    Serial.printf("用户库分区映射失败: %d\n", err);
+    return false;
+  }
+
+  if (!user_db_validate((const uint8_t *)mapped, partition->size)) {
+    spi_flash_munmap(userDbMapHandle);
+    return false;
+  }
+
+  userDbImage = (const uint8_t *)mapped;
+  userDbMounted = true;
+
+  const UserDbHeader *header = user_db_header();
+  Serial.printf("用户库已挂载: 版本=%u, 用户=%u, 卡=%u, 指纹=%u, 密码=%u\n",
+               header->dbVersion, header->userCount, header->cardCount,
+               header->fingerprintCount, header->passwordCount);
+
+  return true;
+}
+
+/**
+ * 解除映射
+ */
+void user_db_unmount() {
+  if (!userDbMounted) {
+    return;
+  }
+
+  userDbMounted = false;
+  userDbImage = NULL;
+  spi_flash_munmap(userDbMapHandle);
+}
+
+/**
+ * 检查用户库是否已挂载
+ * @return 是否已挂载
+ */
+bool user_db_is_mounted() {
+  return userDbMounted;
+}
+
+/**
+ * 获取用户库版本
+ * @return 版本号，未挂载时为0
+ */
+uint32_t user_db_get_version() {
+  return userDbMounted ? user_db_header()->dbVersion : 0;
+}
+
+/**
+ * 获取用户数量
+ * @return 用户数量
+ */
+uint32_t user_db_get_user_count() {
+  return userDbMounted ? user_db_header()->userCount : 0;
+}
+
+/**
+ * 按下标获取用户记录
+ * @param userIndex 用户下标
+ * @return 用户记录，NULL表示越界
+ */
+const UserDbUser *user_db_get_user(uint32_t userIndex) {
+  if (!userDbMounted || userIndex >= user_db_header()->userCount) {
+    return NULL;
+  }
+
+  const UserDbUser *users = (const UserDbUser *)(userDbImage + user_db_header()->userOffset);
+  return &users[userIndex];
+}
+
+/**
+ * 获取卡号条目数量
+ * @return 条目数量
+ */
+uint32_t user_db_get_card_count() {
+  return userDbMounted ? user_db_header()->cardCount : 0;
+}
+
+/**
+ * 按下标获取卡号条目
+ * @param cardIndex 条目下标
+ * @return 卡号条目，NULL表示越界
+ */
+const UserDbCardEntry *user_db_get_card_entry(uint32_t cardIndex) {
+  if (!userDbMounted || cardIndex >= user_db_header()->cardCount) {
+    return NULL;
+  }
+
+  const UserDbCardEntry *entries = (const UserDbCardEntry *)(userDbImage + user_db_header()->cardOffset);
+  return &entries[cardIndex];
+}
+
+/**
+ * 根据用户ID查找用户记录
+ * @param userId 用户ID
+ * @return 用户记录，NULL表示未找到
+ */
+const UserDbUser *user_db_find_user(uint32_t userId) {
+  if (!userDbMounted) {
+    return NULL;
+  }
+
+  const UserDbHeader *header = user_db_header();
+  const UserDbUser *users = (const UserDbUser *)(userDbImage + header->userOffset);
+  uint32_t low = 0;
+  uint32_t high = header->userCount;
+
+  while (low < high) {
+    uint32_t mid = low + (high - low) / 2;
+    if (users[mid].userId < userId) {
+      low = mid + 1;
+    } else if (users[mid].userId > userId) {
+      high = mid;
+    } else {
+      return &users[mid];
+    }
+  }
+
+  return NULL;
+}
+
+/**
+ * 根据卡号查找用户记录
+ * @param card 卡号键
+ * @return 用户记录，NULL表示未找到
+ */
+const UserDbUser *user_db_find_card(const CardUid *card) {
+  if (!userDbMounted) {
+    return NULL;
+  }
+
+  const UserDbHeader *header = user_db_header();
+  const UserDbCardEntry *entries = (const UserDbCardEntry *)(userDbImage + header->cardOffset);
+  uint32_t low = 0;
+  uint32_t high = header->cardCount;
+
+  while (low < high) {
+    uint32_t mid = low + (high - low) / 2;
+    int cmp = memcmp(&entries[mid].card, card, sizeof(CardUid));
+    if (cmp < 0) {
+      low = mid + 1;
+    } else if (cmp > 0) {
+      high = mid;
+    } else {
+      return user_db_get_user(entries[mid].userIndex);
+    }
+  }
+
+  return NULL;
+}
+
+/**
+ * 根据指纹ID查找用户记录
+ * @param fingerprintId 指纹ID
+ * @return 用户记录，NULL表示未找到
+ */
+const UserDbUser *user_db_find_fingerprint(uint32_t fingerprintId) {
+  if (!userDbMounted) {
+    return NULL;
+  }
+
+  const UserDbHeader *header = user_db_header();
+  const UserDbFingerprintEntry *entries =
+      (const UserDbFingerprintEntry *)(userDbImage + header->fingerprintOffset);
+  uint32_t low = 0;
+  uint32_t high = header->fingerprintCount;
+
+  while (low < high) {
+    uint32_t mid = low + (high - low) / 2;
+    if (entries[mid].fingerprintId < fingerprintId) {
+      low = mid + 1;
+    } else if (entries[mid].fingerprintId > fingerprintId) {
+      high = mid;
+    } else {
+      return user_db_get_user(entries[mid].userIndex);
+    }
+  }
+
+  return NULL;
+}
+
+/**
+ * 计算加盐密码摘要
+ */
+static void user_db_password_digest(const UserDbHeader *header, const char *password,
+                                    uint8_t digest[USER_DB_DIGEST_SIZE]) {
+  mbedtls_sha256_context ctx;
+  mbedtls_sha256_init(&ctx);
+  mbedtls_sha256_starts_ret(&ctx, 0);
+  mbedtls_sha256_update_ret(&ctx, header->pinSalt, USER_DB_SALT_SIZE);
+  mbedtls_sha256_update_ret(&ctx, (const uint8_t *)password, strlen(password));
+  mbedtls_sha256_finish_ret(&ctx, digest);
+  mbedtls_sha256_free(&ctx);
+}
+
+/**
+ * 查找第一个摘要不小于digest的密码条目（相同密码的条目相邻）
+ */
+static uint32_t user_db_password_lower_bound(const UserDbHeader *header, const uint8_t *digest) {
+  const UserDbPasswordEntry *entries =
+      (const UserDbPasswordEntry *)(userDbImage + header->passwordOffset);
+  uint32_t low = 0;
+  uint32_t high = header->passwordCount;
+
+  while (low < high) {
+    uint32_t mid = low + (high - low) / 2;
+    if (memcmp(entries[mid].digest, digest, USER_DB_DIGEST_SIZE) < 0) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  return low;
+}
+
+/**
+ * 根据密码查找用户记录
+ * @param password 密码
+ * @return 用户记录，NULL表示未找到（多人共用时为其中之一）
+ */
+const UserDbUser *user_db_find_password(const char *password) {
+  if (!userDbMounted) {
+    return NULL;
+  }
+
+  const UserDbHeader *header = user_db_header();
+  uint8_t digest[USER_DB_DIGEST_SIZE];
+  user_db_password_digest(header, password, digest);
+
+  const UserDbPasswordEntry *entries =
+      (const UserDbPasswordEntry *)(userDbImage + header->passwordOffset);
+  uint32_t i = user_db_password_lower_bound(header, digest);
+  if (i < header->passwordCount && memcmp(entries[i].digest, digest, USER_DB_DIGEST_SIZE) == 0) {
+    return user_db_get_user(entries[i].userIndex);
+  }
+
+  return NULL;
+}
+
+/**
+ * 校验指定用户的密码
+ * @param user 用户记录
+ * @param password 密码
+ * @return 密码是否属于该用户（含多人共用的密码）
+ */
+bool user_db_check_password(const UserDbUser *user, const char *password) {
+  if (!userDbMounted || !user) {
+    return false;
+  }
+
+  const UserDbHeader *header = user_db_header();
+  uint8_t digest[USER_DB_DIGEST_SIZE];
+  user_db_password_digest(header, password, digest);
+
+  const UserDbPasswordEntry *entries =
+      (const UserDbPasswordEntry *)(userDbImage + header->passwordOffset);
+  uint32_t userIndex = user - user_db_get_user(0);
+  for (uint32_t i = user_db_password_lower_bound(header, digest);
+       i < header->passwordCount && memcmp(entries[i].digest, digest, USER_DB_DIGEST_SIZE) == 0; i++) {
+    if (entries[i].userIndex == userIndex) {
+      return true;
+    }
+  }
+
+  return false;
+}
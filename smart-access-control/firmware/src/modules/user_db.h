@@ -0,0 +1,177 @@
+#ifndef USER_DB_H
+#define USER_DB_H
+
+#include <Arduino.h>
+#include "drivers/rfid_driver.h"
+
+// 镜像标识 "UDB1"
+#define USER_DB_MAGIC           0x31424455
+// 镜像格式版本
+#define USER_DB_FORMAT_VERSION  1
+
+// 用户库分区（见partitions.csv）
+#define USER_DB_PARTITION_LABEL    "userdb"
+#define USER_DB_PARTITION_SUBTYPE  0x40
+
+// 凭证页对齐（与闪存扇区一致，便于按页擦写）
+#define USER_DB_PAGE_SIZE  4096
+
+// 密码摘要长度（SHA-256）
+#define USER_DB_DIGEST_SIZE  32
+// 密码加盐长度
+#define USER_DB_SALT_SIZE    16
+
+// 用户标志
+#define USER_DB_FLAG_ENABLED  0x01
+
+// 镜像头（所有字段小端序）
+// CRC覆盖头部crc32字段之前的部分和头部之后的全部数据
+typedef struct __attribute__((packed)) {
+  uint32_t magic;
+  uint16_t formatVersion;
+  uint16_t headerSize;
+  uint32_t dbVersion;           // 用户库版本，由后台递增
+  uint32_t imageSize;           // 镜像总长度
+  uint32_t userCount;
+  uint32_t userOffset;          // UserDbUser[]，按userId升序
+  uint32_t cardCount;
+  uint32_t cardOffset;          // UserDbCardEntry[]，按卡号键字节序升序
+  uint32_t fingerprintCount;
+  uint32_t fingerprintOffset;   // UserDbFingerprintEntry[]，按指纹ID升序
+  uint32_t passwordCount;
+  uint32_t passwordOffset;      // UserDbPasswordEntry[]，按摘要字节序升序
+  uint8_t pinSalt[USER_DB_SALT_SIZE];
+  uint32_t crc32;
+} UserDbHeader;
+
+// 用户记录
+typedef struct __attribute__((packed)) {
+  uint32_t userId;
+  uint8_t flags;
+  uint8_t scheduleId;   // 时间表ID，0表示不限时间
+  uint8_t reserved[2];
+} UserDbUser;
+
+// 卡号页条目
+typedef struct __attribute__((packed)) {
+  CardUid card;
+  uint32_t userIndex;
+} UserDbCardEntry;
+
+// 指纹页条目
+typedef struct __attribute__((packed)) {
+  uint32_t fingerprintId;
+  uint32_t userIndex;
+} UserDbFingerprintEntry;
+
+// 密码页条目，digest = SHA-256(pinSalt || PIN)
+typedef struct __attribute__((packed)) {
+  uint8_t digest[USER_DB_DIGEST_SIZE];
+  uint32_t userIndex;
+} UserDbPasswordEntry;
+
+/**
+ * 映射并校验用户库分区
+ * 镜像只读映射到地址空间，查找直接访问闪存，不占用与用户数相关的RAM
+ * @return 是否成功
+ */
+bool user_db_mount();
+
+/**
+ * 解除映射
+ */
+void user_db_unmount();
+
+/**
+ * 校验镜像
+ * @param image 镜像地址
+ * @param size 可用长度
+ * @return 是否有效
+ */
+bool user_db_validate(const uint8_t *image, size_t size);
+
+/**
+ * 检查用户库是否已挂载
+ * @return 是否已挂载
+ */
+bool user_db_is_mounted();
+
+/**
+ * 获取用户库版本
+ * @return 版本号，未挂载时为0
+ */
+uint32_t user_db_get_version();
+
+/**
+ * 获取用户数量
+ * @return 用户数量
+ */
+uint32_t user_db_get_user_count();
+
+/**
+ * 按下标获取用户记录
+ * @param userIndex 用户下标
+ * @return 用户记录，NULL表示越界
+ */
+const UserDbUser *user_db_get_user(uint32_t userIndex);
+
+/**
+ * 获取卡号条目数量
+ * @return 条目数量
+ */
+uint32_t user_db_get_card_count();
+
+/**
+ * 按下标获取卡号条目
+ * @param cardIndex 条目下标
+ * @return 卡号条目，NULL表示越界
+ */
+const UserDbCardEntry *user_db_get_card_entry(uint32_t cardIndex);
+
+/**
+ * 根据用户ID查找用户记录
+ * @param userId 用户ID
+ * @return 用户记录，NULL表示未找到
+ */
+const UserDbUser *user_db_find_user(uint32_t userId);
+
+/**
+ * 根据卡号查找用户记录
+ * @param card 卡号键
+ * @return 用户记录，NULL表示未找到
+ */
+const UserDbUser *user_db_find_card(const CardUid *card);
+
+/**
+ * 根据指纹ID查找用户记录
+ * @param fingerprintId 指纹ID
+ * @return 用户记录，NULL表示未找到
+ */
+const UserDbUser *user_db_find_fingerprint(uint32_t fingerprintId);
+
+/**
+ * 根据密码查找用户记录
+ * @param password 密码
+ * @return 用户记录，NULL表示未找到（多人共用时为其中之一）
+ */
+const UserDbUser *user_db_find_password(const char *password);
+
+/**
+ * 校验指定用户的密码
+ * 在摘要相同的条目中查找该用户，多人共用的密码也能确认
+ * @param user 用户记录（user_db_find_user 的返回值）
+ * @param password 密码
+ * @return 密码是否属于该用户
+ */
+bool user_db_check_password(const UserDbUser *user, const char *password);
+
+/**
+ * 计算CRC32（与zlib.crc32一致）
+ * @param crc 初始值
+ * @param data 数据
+ * @param length 长度
+ * @return CRC32
+ */
+uint32_t user_db_crc32(uint32_t crc, const uint8_t *data, size_t length);
+
+#endif
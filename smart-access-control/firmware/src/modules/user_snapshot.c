@@ -0,0 +1,950 @@
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+
+// 头文件包含
+#include "modules/user_snapshot.h"
+#include "modules/user_db.h"
+
+// 卡号过滤器：未登记的卡不进入完整查找
+// 建立时按现有卡数的1/2（至少256张）预留增长余量，超出后重建
+#define CARD_FILTER_FALSE_POSITIVE_RATE  0.01f
+#define CARD_FILTER_HEADROOM             256
+#define CARD_FILTER_GROWTH_DIVISOR       2
+
+// 覆盖层最小容量
+#define SNAPSHOT_MIN_CAPACITY  16
+
+// 读者登记槽
+// epoch为0表示不在读临界区，否则为进入时的全局纪元
+typedef struct {
+  TaskHandle_t task;
+  uint32_t epoch;
+  uint32_t depth;
+} SnapshotReader;
+
+// 待回收快照
+typedef struct {
+  UserSnapshot *snapshot;
+  BloomFilter *cardFilter;  // 随快照回收的旧过滤器，NULL表示过滤器仍在使用
+  uint32_t epoch;           // 退役时的全局纪元
+} RetiredSnapshot;
+
+// 当前快照（原子指针）
+UserSnapshot *currentSnapshot = NULL;
+
+// 全局纪元，每次发布递增
+uint32_t snapshotEpoch = 1;
+
+SnapshotReader snapshotReaders[USER_SNAPSHOT_MAX_READERS];
+
+// 登记槽耗尽时的读者计数（共用，不区分纪元）；不为0时不回收任何旧快照
+uint32_t snapshotOverflowReaders = 0;
+uint32_t snapshotReaderOverflows = 0;
+RetiredSnapshot retiredSnapshots[USER_SNAPSHOT_MAX_RETIRED];
+
+// 写者互斥（只在写者之间互斥，读者从不等待）
+SemaphoreHandle_t snapshotWriterMutex = NULL;
+
+// 发布与回收统计
+uint32_t snapshotPublished = 0;
+uint32_t snapshotReclaimed = 0;
+uint32_t snapshotRetireWaits = 0;
+
+// 卡号过滤器统计
+// 过滤器不随快照复制：发布前加入新卡，发布后删除旧卡，读者最多看到多余的误判
+uint32_t cardFilterQueries = 0;
+uint32_t cardFilterRejected = 0;
+uint32_t cardFilterFalsePositives = 0;
+
+/**
+ * 分配覆盖层用户数组（PSRAM优先）
+ */
+static SnapshotUser *user_snapshot_alloc_users(uint32_t capacity) {
+  size_t size = capacity * sizeof(SnapshotUser);
+  SnapshotUser *users = NULL;
+
+  if (psramFound()) {
+    users = (SnapshotUser *)heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  }
+  if (!users) {
+    users = (SnapshotUser *)malloc(size);
+  }
+
+  return users;
+}
+
+/**
+ * 释放快照
+ */
+static void user_snapshot_free(UserSnapshot *snapshot) {
+  if (!snapshot) {
+    return;
+  }
+
+  free(snapshot->users);
+  credential_index_free(&snapshot->userIdIndex);
+  credential_index_free(&snapshot->cardIndex);
+  credential_index_free(&snapshot->fingerprintIndex);
+  credential_index_free(&snapshot->passwordIndex);
+  free(snapshot);
+}
+
+/**
+ * 释放卡号过滤器
+ */
+static void user_snapshot_free_filter(BloomFilter *filter) {
+  if (!filter) {
+    return;
+  }
+
+  bloom_filter_free(filter);
+  free(filter);
+}
+
+/**
+ * 用户ID匹配回调
+ */
+static bool user_snapshot_match_user_id(int32_t value, const void *key, void *context) {
+  const UserSnapshot *snapshot = (const UserSnapshot *)context;
+  return snapshot->users[value].user.id == *(const int *)key;
+}
+
+/**
+ * 卡号匹配回调
+ */
+static bool user_snapshot_match_card(int32_t value, const void *key, void *context) {
+  const UserSnapshot *snapshot = (const UserSnapshot *)context;
+  return rfid_uid_equals(&snapshot->users[value].user.card, (const CardUid *)key);
+}
+
+/**
+ * 指纹ID匹配回调
+ */
+static bool user_snapshot_match_fingerprint(int32_t value, const void *key, void *context) {
+  const UserSnapshot *snapshot = (const UserSnapshot *)context;
+  return snapshot->users[value].user.fingerprintId == *(const int *)key;
+}
+
+/**
+ * 密码匹配回调
+ */
+static bool user_snapshot_match_password(int32_t value, const void *key, void *context) {
+  const UserSnapshot *snapshot = (const UserSnapshot *)context;
+  return strcmp(snapshot->users[value].user.password, (const char *)key) == 0;
+}
+
+/**
+ * 查找覆盖层记录
+ * @return 覆盖层下标，CREDENTIAL_INDEX_EMPTY表示无记录
+ */
+static int32_t user_snapshot_find_record(const UserSnapshot *snapshot, int userId) {
+  return credential_index_find(&snapshot->userIdIndex, credential_hash_int(userId),
+                               user_snapshot_match_user_id, &userId, (void *)snapshot);
+}
+
+/**
+ * 查找快照可见的闪存用户
+ */
+static const UserDbUser *user_snapshot_image_user(const UserSnapshot *snapshot, int userId) {
+  return snapshot->imageMasked ? NULL : user_db_find_user(userId);
+}
+
+/**
+ * 将覆盖层记录的凭证加入索引
+ */
+static bool user_snapshot_index_record(UserSnapshot *snapshot, int32_t i) {
+  const SnapshotUser *record = &snapshot->users[i];
+  if (record->deleted || record->inheritImage) {
+    return true;
+  }
+
+  const User *user = &record->user;
+  if (user->card.size > 0 &&
+      !credential_index_insert(&snapshot->cardIndex, credential_hash_bytes(&user->card, sizeof(CardUid)), i)) {
+    return false;
+  }
+  if (user->fingerprintId > 0 &&
+      !credential_index_insert(&snapshot->fingerprintIndex, credential_hash_int(user->fingerprintId), i)) {
+    return false;
+  }
+  if (user->password[0] != '\0' &&
+      !credential_index_insert(&snapshot->passwordIndex, credential_hash_string(user->password), i)) {
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * 将覆盖层记录的凭证移出索引
+ */
+static void user_snapshot_unindex_record(UserSnapshot *snapshot, int32_t i) {
+  const SnapshotUser *record = &snapshot->users[i];
+  if (record->deleted || record->inheritImage) {
+    return;
+  }
+
+  const User *user = &record->user;
+  if (user->card.size > 0) {
+    credential_index_remove(&snapshot->cardIndex, credential_hash_bytes(&user->card, sizeof(CardUid)), i);
+  }
+  if (user->fingerprintId > 0) {
+    credential_index_remove(&snapshot->fingerprintIndex, credential_hash_int(user->fingerprintId), i);
+  }
+  if (user->password[0] != '\0') {
+    credential_index_remove(&snapshot->passwordIndex, credential_hash_string(user->password), i);
+  }
+}
+
+/**
+ * 追加覆盖层记录
+ * @return 覆盖层下标，-1表示失败
+ */
+static int32_t user_snapshot_append_record(UserSnapshot *snapshot, int userId) {
+  if (snapshot->userCount >= snapshot->userCapacity) {
+    return -1;
+  }
+
+  int32_t i = snapshot->userCount;
+  memset(&snapshot->users[i], 0, sizeof(SnapshotUser));
+  snapshot->users[i].user.id = userId;
+
+  if (!credential_index_insert(&snapshot->userIdIndex, credential_hash_int(userId), i)) {
+    return -1;
+  }
+
+  snapshot->userCount++;
+  return i;
+}
+
+/**
+ * 闪存用户库中的用户在快照下是否启用
+ */
+static bool user_snapshot_image_enabled(const UserSnapshot *snapshot, const UserDbUser *user) {
+  int32_t i = user_snapshot_find_record(snapshot, user->userId);
+  if (i == CREDENTIAL_INDEX_EMPTY) {
+    return (user->flags & USER_DB_FLAG_ENABLED) != 0;
+  }
+
+  // 覆盖层记录优先：删除或替换都会屏蔽闪存中的凭证
+  const SnapshotUser *record = &snapshot->users[i];
+  return !record->deleted && record->inheritImage && record->user.enabled;
+}
+
+/**
+ * 对用户在快照下生效的每张卡执行操作
+ */
+static void user_snapshot_for_each_card(const UserSnapshot *snapshot, int userId,
+                                        void (*visit)(const CardUid *card, void *context), void *context) {
+  int32_t i = user_snapshot_find_record(snapshot, userId);
+  if (i != CREDENTIAL_INDEX_EMPTY) {
+    const SnapshotUser *record = &snapshot->users[i];
+    if (record->deleted || !record->user.enabled) {
+      return;
+    }
+    if (!record->inheritImage) {
+      if (record->user.card.size > 0) {
+        visit(&record->user.card, context);
+      }
+      return;
+    }
+  }
+
+  const UserDbUser *user = user_snapshot_image_user(snapshot, userId);
+  if (!user || (i == CREDENTIAL_INDEX_EMPTY && !(user->flags & USER_DB_FLAG_ENABLED))) {
+    return;
+  }
+
+  // 闪存卡号页按卡号排序，需扫描找出该用户的卡（仅写者路径）
+  uint32_t userIndex = user - user_db_get_user(0);
+  uint32_t cardCount = user_db_get_card_count();
+  for (uint32_t c = 0; c < cardCount; c++) {
+    const UserDbCardEntry *entry = user_db_get_card_entry(c);
+    if (entry->userIndex == userIndex) {
+      visit(&entry->card, context);
+    }
+  }
+}
+
+/**
+ * 对快照下所有生效的卡执行操作
+ */
+static void user_snapshot_for_each_live_card(const UserSnapshot *snapshot,
+                                             void (*visit)(const CardUid *card, void *context), void *context) {
+  for (uint32_t i = 0; i < snapshot->userCount; i++) {
+    const SnapshotUser *record = &snapshot->users[i];
+    if (!record->deleted && !record->inheritImage && record->user.enabled && record->user.card.size > 0) {
+      visit(&record->user.card, context);
+    }
+  }
+
+  if (snapshot->imageMasked) {
+    return;
+  }
+
+  uint32_t cardCount = user_db_get_card_count();
+  for (uint32_t c = 0; c < cardCount; c++) {
+    const UserDbCardEntry *entry = user_db_get_card_entry(c);
+    const UserDbUser *user = user_db_get_user(entry->userIndex);
+    if (user && user_snapshot_image_enabled(snapshot, user)) {
+      visit(&entry->card, context);
+    }
+  }
+}
+
+/**
+ * 卡号加入过滤器
+ */
+static void user_snapshot_filter_add(const CardUid *card, void *context) {
+  bloom_filter_add((BloomFilter *)context, card, sizeof(CardUid));
+}
+
+/**
+ * 卡号移出过滤器
+ */
+static void user_snapshot_filter_remove(const CardUid *card, void *context) {
+  bloom_filter_remove((BloomFilter *)context, card, sizeof(CardUid));
+}
+
+/**
+ * 卡号计数
+ */
+static void user_snapshot_count_card(const CardUid *card, void *context) {
+  (void)card;
+  (*(uint32_t *)context)++;
+}
+
+/**
+ * 按快照中生效的卡建立卡号过滤器
+ * @return 过滤器，NULL表示失败（所有卡都走完整查找）
+ */
+static BloomFilter *user_snapshot_build_filter(const UserSnapshot *snapshot) {
+  uint32_t cardCount = 0;
+  user_snapshot_for_each_live_card(snapshot, user_snapshot_count_card, &cardCount);
+
+  uint32_t headroom = cardCount / CARD_FILTER_GROWTH_DIVISOR;
+  if (headroom < CARD_FILTER_HEADROOM) {
+    headroom = CARD_FILTER_HEADROOM;
+  }
+
+  BloomFilter *filter = (BloomFilter *)malloc(sizeof(BloomFilter));
+  if (!filter || !bloom_filter_init(filter, cardCount + headroom, CARD_FILTER_FALSE_POSITIVE_RATE)) {
+    free(filter);
+    Serial.println("卡号过滤器建立失败");
+    return NULL;
+  }
+
+  user_snapshot_for_each_live_card(snapshot, user_snapshot_filter_add, filter);
+  Serial.printf("卡号过滤器: 计数器=%u, 哈希=%d, 卡=%u/%u\n",
+               filter->size, filter->hashCount, filter->count, filter->capacity);
+  return filter;
+}
+
+/**
+ * 复制快照，并为extra条新记录预留空间
+ */
+static UserSnapshot *user_snapshot_clone(const UserSnapshot *source, uint32_t extra) {
+  UserSnapshot *snapshot = (UserSnapshot *)calloc(1, sizeof(UserSnapshot));
+  if (!snapshot) {
+    return NULL;
+  }
+
+  uint32_t capacity = source->userCapacity;
+  while (capacity < source->userCount + extra) {
+    capacity <<= 1;
+  }
+
+  snapshot->version = source->version;
+  snapshot->imageMasked = source->imageMasked;
+  snapshot->userCount = source->userCount;
+  snapshot->userCapacity = capacity;
+  snapshot->users = user_snapshot_alloc_users(capacity);
+
+  if (!snapshot->users ||
+      !credential_index_clone(&snapshot->userIdIndex, &source->userIdIndex) ||
+      !credential_index_clone(&snapshot->cardIndex, &source->cardIndex) ||
+      !credential_index_clone(&snapshot->fingerprintIndex, &source->fingerprintIndex) ||
+      !credential_index_clone(&snapshot->passwordIndex, &source->passwordIndex)) {
+    user_snapshot_free(snapshot);
+    return NULL;
+  }
+
+  memcpy(snapshot->users, source->users, source->userCount * sizeof(SnapshotUser));
+  return snapshot;
+}
+
+/**
+ * 应用单条更新
+ * @return 1表示已应用，0表示跳过（用户不存在等），-1表示内存不足
+ */
+static int user_snapshot_apply_one(UserSnapshot *snapshot, const IdentityUpdate *update) {
+  int userId = update->user.id;
+  int32_t i = user_snapshot_find_record(snapshot, userId);
+  bool inImage = user_snapshot_image_user(snapshot, userId) != NULL;
+
+  switch (update->type) {
+    case IDENTITY_UPDATE_ADD:
+      // 新增或整体替换
+      if (i != CREDENTIAL_INDEX_EMPTY) {
+        user_snapshot_unindex_record(snapshot, i);
+      } else if ((i = user_snapshot_append_record(snapshot, userId)) < 0) {
+        return -1;
+      }
+      snapshot->users[i].user = update->user;
+      snapshot->users[i].inheritImage = false;
+      snapshot->users[i].deleted = false;
+      return user_snapshot_index_record(snapshot, i) ? 1 : -1;
+
+    case IDENTITY_UPDATE_ENABLE:
+    case IDENTITY_UPDATE_DISABLE:
+      if (i != CREDENTIAL_INDEX_EMPTY) {
+        if (snapshot->users[i].deleted) {
+          return 0;
+        }
+      } else if (!inImage) {
+        return 0;
+      } else {
+        // 闪存用户：只覆盖启用状态
+        if ((i = user_snapshot_append_record(snapshot, userId)) < 0) {
+          return -1;
+        }
+        snapshot->users[i].inheritImage = true;
+      }
+      snapshot->users[i].user.enabled = (update->type == IDENTITY_UPDATE_ENABLE);
+      return 1;
+
+    case IDENTITY_UPDATE_DELETE:
+      if (i != CREDENTIAL_INDEX_EMPTY) {
+        if (snapshot->users[i].deleted) {
+          return 0;
+        }
+        user_snapshot_unindex_record(snapshot, i);
+      } else if (!inImage) {
+        return 0;
+      } else if ((i = user_snapshot_append_record(snapshot, userId)) < 0) {
+        return -1;
+      }
+      // 保留删除标记以屏蔽闪存用户库中的记录
+      snapshot->users[i].inheritImage = false;
+      snapshot->users[i].deleted = true;
+      snapshot->users[i].user.enabled = false;
+      return 1;
+  }
+
+  return 0;
+}
+
+/**
+ * 检查纪元之前进入的读者是否都已退出
+ */
+static bool user_snapshot_quiescent(uint32_t epoch) {
+  if (__atomic_load_n(&snapshotOverflowReaders, __ATOMIC_SEQ_CST) != 0) {
+    return false;
+  }
+  for (int i = 0; i < USER_SNAPSHOT_MAX_READERS; i++) {
+    uint32_t readerEpoch = __atomic_load_n(&snapshotReaders[i].epoch, __ATOMIC_SEQ_CST);
+    if (readerEpoch != 0 && readerEpoch < epoch) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * 回收旧快照（调用方持有写者互斥）
+ */
+static void user_snapshot_reclaim_locked() {
+  for (int i = 0; i < USER_SNAPSHOT_MAX_RETIRED; i++) {
+    RetiredSnapshot *retired = &retiredSnapshots[i];
+    if (retired->snapshot && user_snapshot_quiescent(retired->epoch)) {
+      user_snapshot_free(retired->snapshot);
+      user_snapshot_free_filter(retired->cardFilter);
+      retired->snapshot = NULL;
+      retired->cardFilter = NULL;
+      __atomic_fetch_add(&snapshotReclaimed, 1, __ATOMIC_RELAXED);
+    }
+  }
+}
+
+/**
+ * 退役旧快照
+ * 待回收队列已满时等待读者退出（只阻塞写者）
+ * @param snapshot 旧快照
+ * @param epoch 退役时的全局纪元
+ * @param cardFilter 已被替换的过滤器（更早的快照同样在此纪元前退役，可一并回收），NULL表示无
+ */
+static void user_snapshot_retire(UserSnapshot *snapshot, uint32_t epoch, BloomFilter *cardFilter) {
+  __atomic_fetch_add(&snapshotPublished, 1, __ATOMIC_RELAXED);
+
+  while (true) {
+    user_snapshot_reclaim_locked();
+
+    for (int i = 0; i < USER_SNAPSHOT_MAX_RETIRED; i++) {
+      if (!retiredSnapshots[i].snapshot) {
+        retiredSnapshots[i].snapshot = snapshot;
+        retiredSnapshots[i].cardFilter = cardFilter;
+        retiredSnapshots[i].epoch = epoch;
+        return;
+      }
+    }
+
+    __atomic_fetch_add(&snapshotRetireWaits, 1, __ATOMIC_RELAXED);
+    vTaskDelay(1);
+  }
+}
+
+/**
+ * 获取当前任务的读者登记槽
+ * @param allocate 未登记时是否分配
+ * @return 登记槽，NULL表示无可用槽
+ */
+static SnapshotReader *user_snapshot_reader(bool allocate) {
+  TaskHandle_t self = xTaskGetCurrentTaskHandle();
+
+  for (int i = 0; i < USER_SNAPSHOT_MAX_READERS; i++) {
+    if (__atomic_load_n(&snapshotReaders[i].task, __ATOMIC_ACQUIRE) == self) {
+      return &snapshotReaders[i];
+    }
+  }
+
+  if (!allocate) {
+    return NULL;
+  }
+
+  for (int i = 0; i < USER_SNAPSHOT_MAX_READERS; i++) {
+    TaskHandle_t expected = NULL;
+    if (__atomic_compare_exchange_n(&snapshotReaders[i].task, &expected, self, false,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+      return &snapshotReaders[i];
+    }
+  }
+
+  return NULL;
+}
+
+/**
+ * 以用户列表创建快照
+ * @param users 用户列表
+ * @param count 用户数量
+ * @return 快照，NULL表示内存不足
+ */
+static UserSnapshot *user_snapshot_create(const User *users, uint32_t count) {
+  UserSnapshot *snapshot = (UserSnapshot *)calloc(1, sizeof(UserSnapshot));
+  if (!snapshot) {
+    return NULL;
+  }
+
+  snapshot->userCapacity = SNAPSHOT_MIN_CAPACITY;
+  while (snapshot->userCapacity < count) {
+    snapshot->userCapacity <<= 1;
+  }
+  snapshot->users = user_snapshot_alloc_users(snapshot->userCapacity);
+
+  if (!snapshot->users ||
+      !credential_index_init(&snapshot->userIdIndex, count) ||
+      !credential_index_init(&snapshot->cardIndex, count) ||
+      !credential_index_init(&snapshot->fingerprintIndex, count) ||
+      !credential_index_init(&snapshot->passwordIndex, count)) {
+    user_snapshot_free(snapshot);
+    return NULL;
+  }
+
+  for (uint32_t n = 0; n < count; n++) {
+    // 重复ID以最后一条为准
+    int32_t i = user_snapshot_find_record(snapshot, users[n].id);
+    if (i != CREDENTIAL_INDEX_EMPTY) {
+      user_snapshot_unindex_record(snapshot, i);
+    } else {
+      i = user_snapshot_append_record(snapshot, users[n].id);
+    }
+    if (i < 0) {
+      user_snapshot_free(snapshot);
+      return NULL;
+    }
+    snapshot->users[i].user = users[n];
+    if (!user_snapshot_index_record(snapshot, i)) {
+      user_snapshot_free(snapshot);
+      return NULL;
+    }
+  }
+
+  return snapshot;
+}
+
+/**
+ * 建立初始快照
+ * @param builtinUsers 内置用户
+ * @param builtinCount 内置用户数量
+ * @return 是否成功
+ */
+bool user_snapshot_init(const User *builtinUsers, int builtinCount) {
+  snapshotWriterMutex = xSemaphoreCreateMutex();
+  if (!snapshotWriterMutex) {
+    return false;
+  }
+
+  // 闪存用户库可用时不载入内置用户
+  uint32_t count = user_db_is_mounted() ? 0 : builtinCount;
+
+  UserSnapshot *snapshot = user_snapshot_create(builtinUsers, count);
+  if (!snapshot) {
+    return false;
+  }
+  snapshot->version = user_db_get_version();
+  snapshot->cardFilter = user_snapshot_build_filter(snapshot);
+
+  __atomic_store_n(&currentSnapshot, snapshot, __ATOMIC_SEQ_CST);
+  return true;
+}
+
+/**
+ * 进入读临界区并获取当前快照
+ * @return 当前快照
+ */
+const UserSnapshot *user_snapshot_read_lock() {
+  SnapshotReader *reader = user_snapshot_reader(true);
+  if (!reader) {
+    // 登记槽耗尽时计入共用计数（仍不等待写者），期间写者暂停回收
+    if (__atomic_fetch_add(&snapshotReaderOverflows, 1, __ATOMIC_RELAXED) == 0) {
+      Serial.printf("用户快照读者登记槽耗尽（%d个），请增大USER_SNAPSHOT_MAX_READERS\n", USER_SNAPSHOT_MAX_READERS);
+    }
+    __atomic_fetch_add(&snapshotOverflowReaders, 1, __ATOMIC_SEQ_CST);
+    return __atomic_load_n(&currentSnapshot, __ATOMIC_SEQ_CST);
+  }
+
+  // 先公布进入纪元，再读取快照指针
+  if (reader->depth++ == 0) {
+    __atomic_store_n(&reader->epoch, __atomic_load_n(&snapshotEpoch, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+  }
+
+  return __atomic_load_n(&currentSnapshot, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * 退出读临界区
+ */
+void user_snapshot_read_unlock() {
+  SnapshotReader *reader = user_snapshot_reader(false);
+  if (!reader) {
+    __atomic_fetch_sub(&snapshotOverflowReaders, 1, __ATOMIC_SEQ_CST);
+    return;
+  }
+
+  // 最外层退出时释放登记槽，已删除的任务不会长期占用
+  if (--reader->depth == 0) {
+    __atomic_store_n(&reader->epoch, 0, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&reader->task, (TaskHandle_t)NULL, __ATOMIC_RELEASE);
+  }
+}
+
+/**
+ * 批量应用更新并发布新快照（写者）
+ * @param updates 更新列表
+ * @param count 更新条数
+ * @param version 新版本号，0表示沿用当前版本
+ * @return 成功应用的条数，-1表示失败
+ */
+int user_snapshot_apply(const IdentityUpdate *updates, int count, uint32_t version) {
+  if (count < 0 || count > USER_SNAPSHOT_MAX_BATCH || !snapshotWriterMutex) {
+    return -1;
+  }
+
+  xSemaphoreTake(snapshotWriterMutex, portMAX_DELAY);
+
+  UserSnapshot *old = currentSnapshot;
+  UserSnapshot *next = user_snapshot_clone(old, count);
+  if (!next) {
+    xSemaphoreGive(snapshotWriterMutex);
+    Serial.println("用户库快照复制失败");
+    return -1;
+  }
+
+  int applied = 0;
+  for (int i = 0; i < count; i++) {
+    int result = user_snapshot_apply_one(next, &updates[i]);
+    if (result < 0) {
+      user_snapshot_free(next);
+      xSemaphoreGive(snapshotWriterMutex);
+      Serial.println("用户库更新失败: 内存不足");
+      return -1;
+    }
+    applied += result;
+  }
+
+  if (version != 0) {
+    next->version = version;
+  }
+
+  // 过滤器容量不足或有计数器饱和时按新快照重建，否则发布前把新生效的卡加入过滤器
+  BloomFilter *filter = old->cardFilter;
+  bool rebuild = !filter || bloom_filter_needs_rebuild(filter, count);
+  if (rebuild) {
+    next->cardFilter = user_snapshot_build_filter(next);
+  } else {
+    next->cardFilter = filter;
+    for (int i = 0; i < count; i++) {
+      bool repeated = false;
+      for (int j = 0; j < i && !repeated; j++) {
+        repeated = (updates[j].user.id == updates[i].user.id);
+      }
+      if (!repeated) {
+        user_snapshot_for_each_card(next, updates[i].user.id, user_snapshot_filter_add, filter);
+      }
+    }
+  }
+
+  // 原子替换快照指针，之后进入的读者只会看到新快照
+  __atomic_store_n(&currentSnapshot, next, __ATOMIC_SEQ_CST);
+  uint32_t retireEpoch = __atomic_add_fetch(&snapshotEpoch, 1, __ATOMIC_SEQ_CST);
+
+  // 发布后把旧快照中生效的卡移出过滤器（新旧都有的卡计数不变）
+  for (int i = 0; i < count && !rebuild; i++) {
+    bool repeated = false;
+    for (int j = 0; j < i && !repeated; j++) {
+      repeated = (updates[j].user.id == updates[i].user.id);
+    }
+    if (!repeated) {
+      user_snapshot_for_each_card(old, updates[i].user.id, user_snapshot_filter_remove, filter);
+    }
+  }
+
+  user_snapshot_retire(old, retireEpoch, rebuild ? filter : NULL);
+  xSemaphoreGive(snapshotWriterMutex);
+
+  return applied;
+}
+
+/**
+ * 以完整用户列表替换用户库并发布新快照（写者）
+ * @param users 用户列表
+ * @param count 用户数量
+ * @param version 新版本号
+ * @return 是否成功
+ */
+bool user_snapshot_replace(const User *users, int count, uint32_t version) {
+  if (count < 0 || !snapshotWriterMutex) {
+    return false;
+  }
+
+  UserSnapshot *next = user_snapshot_create(users, count);
+  if (!next) {
+    Serial.println("用户库全量替换失败: 内存不足");
+    return false;
+  }
+  next->version = version;
+  next->imageMasked = true;
+
+  // 卡的集合整体替换：按新用户列表重建过滤器，旧过滤器随旧快照回收
+  next->cardFilter = user_snapshot_build_filter(next);
+
+  xSemaphoreTake(snapshotWriterMutex, portMAX_DELAY);
+
+  UserSnapshot *old = currentSnapshot;
+  __atomic_store_n(&currentSnapshot, next, __ATOMIC_SEQ_CST);
+  uint32_t retireEpoch = __atomic_add_fetch(&snapshotEpoch, 1, __ATOMIC_SEQ_CST);
+
+  user_snapshot_retire(old, retireEpoch, old->cardFilter);
+  xSemaphoreGive(snapshotWriterMutex);
+
+  return true;
+}
+
+/**
+ * 回收已无读者引用的旧快照
+ */
+void user_snapshot_reclaim() {
+  if (!snapshotWriterMutex) {
+    return;
+  }
+
+  xSemaphoreTake(snapshotWriterMutex, portMAX_DELAY);
+  user_snapshot_reclaim_locked();
+  xSemaphoreGive(snapshotWriterMutex);
+}
+
+/**
+ * 覆盖层命中结果
+ */
+static int user_snapshot_overlay_result(const User *user, uint8_t *scheduleId) {
+  if (!user->enabled) {
+    return 0;
+  }
+  if (scheduleId) {
+    *scheduleId = user->scheduleId;
+  }
+  return user->id;
+}
+
+/**
+ * 闪存用户库命中结果
+ */
+static int user_snapshot_image_result(const UserSnapshot *snapshot, const UserDbUser *user, uint8_t *scheduleId) {
+  if (!user || !user_snapshot_image_enabled(snapshot, user)) {
+    return 0;
+  }
+  if (scheduleId) {
+    *scheduleId = user->scheduleId;
+  }
+  return user->userId;
+}
+
+/**
+ * 查找卡号（不经过过滤器）
+ * @param known 输出：是否有该卡的记录（含已禁用用户的卡）
+ */
+static int user_snapshot_lookup_card(const UserSnapshot *snapshot, const CardUid *card, uint8_t *scheduleId,
+                                     bool *known) {
+  int32_t i = credential_index_find(&snapshot->cardIndex, credential_hash_bytes(card, sizeof(CardUid)),
+                                    user_snapshot_match_card, card, (void *)snapshot);
+  if (i != CREDENTIAL_INDEX_EMPTY) {
+    *known = true;
+    return user_snapshot_overlay_result(&snapshot->users[i].user, scheduleId);
+  }
+
+  // 闪存用户库：直接在映射的卡号页上二分查找
+  const UserDbUser *user = snapshot->imageMasked ? NULL : user_db_find_card(card);
+  *known = (user != NULL);
+  return user_snapshot_image_result(snapshot, user, scheduleId);
+}
+
+/**
+ * 根据卡号查找用户
+ * @param snapshot 快照
+ * @param card 卡号键
+ * @param scheduleId 时间表ID（可为NULL）
+ * @return 用户ID，0表示未找到或已禁用
+ */
+int user_snapshot_find_card(const UserSnapshot *snapshot, const CardUid *card, uint8_t *scheduleId) {
+  __atomic_fetch_add(&cardFilterQueries, 1, __ATOMIC_RELAXED);
+
+  // 过滤器判定不存在的卡直接拒绝
+  if (snapshot->cardFilter && !bloom_filter_may_contain(snapshot->cardFilter, card, sizeof(CardUid))) {
+    __atomic_fetch_add(&cardFilterRejected, 1, __ATOMIC_RELAXED);
+    return 0;
+  }
+
+  // 误判只统计过滤器放行但没有该卡记录的情况，已禁用用户的卡不算
+  bool known;
+  int userId = user_snapshot_lookup_card(snapshot, card, scheduleId, &known);
+  if (snapshot->cardFilter && !known) {
+    __atomic_fetch_add(&cardFilterFalsePositives, 1, __ATOMIC_RELAXED);
+  }
+
+  return userId;
+}
+
+/**
+ * 根据指纹ID查找用户
+ * @param snapshot 快照
+ * @param fingerprintId 指纹ID
+ * @param scheduleId 时间表ID（可为NULL）
+ * @return 用户ID，0表示未找到或已禁用
+ */
+int user_snapshot_find_fingerprint(const UserSnapshot *snapshot, int fingerprintId, uint8_t *scheduleId) {
+  int32_t i = credential_index_find(&snapshot->fingerprintIndex, credential_hash_int(fingerprintId),
+                                    user_snapshot_match_fingerprint, &fingerprintId, (void *)snapshot);
+  if (i != CREDENTIAL_INDEX_EMPTY) {
+    return user_snapshot_overlay_result(&snapshot->users[i].user, scheduleId);
+  }
+
+  const UserDbUser *user = snapshot->imageMasked ? NULL : user_db_find_fingerprint(fingerprintId);
+  return user_snapshot_image_result(snapshot, user, scheduleId);
+}
+
+/**
+ * 根据密码查找用户
+ * @param snapshot 快照
+ * @param password 密码
+ * @param scheduleId 时间表ID（可为NULL）
+ * @return 用户ID，0表示未找到或已禁用
+ */
+int user_snapshot_find_password(const UserSnapshot *snapshot, const char *password, uint8_t *scheduleId) {
+  int32_t i = credential_index_find(&snapshot->passwordIndex, credential_hash_string(password),
+                                    user_snapshot_match_password, password, (void *)snapshot);
+  if (i != CREDENTIAL_INDEX_EMPTY) {
+    return user_snapshot_overlay_result(&snapshot->users[i].user, scheduleId);
+  }
+
+  const UserDbUser *user = snapshot->imageMasked ? NULL : user_db_find_password(password);
+  return user_snapshot_image_result(snapshot, user, scheduleId);
+}
+
+/**
+ * 校验指定用户的密码
+ * @param snapshot 快照
+ * @param userId 用户ID
+ * @param password 密码
+ * @return 用户生效且密码属于该用户（含多人共用的密码）
+ */
+bool user_snapshot_check_password(const UserSnapshot *snapshot, int userId, const char *password) {
+  int32_t i = user_snapshot_find_record(snapshot, userId);
+  if (i != CREDENTIAL_INDEX_EMPTY) {
+    const SnapshotUser *record = &snapshot->users[i];
+    if (record->deleted) {
+      return false;
+    }
+    if (!record->inheritImage) {
+      return record->user.enabled && record->user.password[0] != '\0' &&
+             strcmp(record->user.password, password) == 0;
+    }
+  }
+
+  const UserDbUser *user = user_snapshot_image_user(snapshot, userId);
+  return user && user_snapshot_image_enabled(snapshot, user) && user_db_check_password(user, password);
+}
+
+/**
+ * 获取用户信息
+ * @param snapshot 快照
+ * @param userId 用户ID
+ * @param user 用户信息
+ * @return 是否找到
+ */
+bool user_snapshot_get_user(const UserSnapshot *snapshot, int userId, User *user) {
+  int32_t i = user_snapshot_find_record(snapshot, userId);
+  if (i != CREDENTIAL_INDEX_EMPTY) {
+    const SnapshotUser *record = &snapshot->users[i];
+    if (record->deleted) {
+      return false;
+    }
+    if (!record->inheritImage) {
+      *user = record->user;
+      return true;
+    }
+  }
+
+  const UserDbUser *imageUser = user_snapshot_image_user(snapshot, userId);
+  if (!imageUser) {
+    return false;
+  }
+
+  memset(user, 0, sizeof(User));
+  user->id = userId;
+  user->enabled = user_snapshot_image_enabled(snapshot, imageUser);
+  user->scheduleId = imageUser->scheduleId;
+  return true;
+}
+
+/**
+ * 获取卡号过滤器统计
+ * @param queries 查询次数
+ * @param saved 过滤器直接拒绝、节省的完整查找次数
+ * @param falsePositives 误判次数
+ */
+void user_snapshot_get_filter_stats(uint32_t *queries, uint32_t *saved, uint32_t *falsePositives) {
+  *queries = __atomic_load_n(&cardFilterQueries, __ATOMIC_RELAXED);
+  *saved = __atomic_load_n(&cardFilterRejected, __ATOMIC_RELAXED);
+  *falsePositives = __atomic_load_n(&cardFilterFalsePositives, __ATOMIC_RELAXED);
+}
+
+/**
+ * 获取快照发布与回收统计
+ * @param published 发布次数（每次发布退役一个旧快照）
+ * @param reclaimed 已回收的旧快照数量
+ * @param retireWaits 待回收队列满、写者等待读者退出的次数
+ */
+void user_snapshot_get_reclaim_stats(uint32_t *published, uint32_t *reclaimed, uint32_t *retireWaits) {
+  *published = __atomic_load_n(&snapshotPublished, __ATOMIC_RELAXED);
+  *reclaimed = __atomic_load_n(&snapshotReclaimed, __ATOMIC_RELAXED);
+  *retireWaits = __atomic_load_n(&snapshotRetireWaits, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,151 @@
+#ifndef USER_SNAPSHOT_H
+#define USER_SNAPSHOT_H
+
+#include <Arduino.h>
+#include "modules/identity.h"
+#include "modules/credential_index.h"
+#include "modules/bloom_filter.h"
+
+// 读者登记槽数量（处于读临界区的任务各占一个，退出时释放）
+// 固件共5个任务加loop和esp_timer任务；耗尽时读者改用共用计数（打印一次告警），期间暂停回收旧快照
+#define USER_SNAPSHOT_MAX_READERS  8
+
+// 待回收快照数量上限
+#define USER_SNAPSHOT_MAX_RETIRED  4
+
+// 单批更新条数上限
+#define USER_SNAPSHOT_MAX_BATCH    128
+
+// 快照中的用户记录（覆盖层）
+// 覆盖层记录优先于闪存用户库中同ID的用户
+typedef struct {
+  User user;
+  bool inheritImage;   // 仅覆盖启用状态，凭证沿用闪存用户库
+  bool deleted;        // 删除标记，屏蔽闪存用户库中的同一用户
+} SnapshotUser;
+
+// 用户库快照，发布后只读
+typedef struct {
+  uint32_t version;              // 用户库版本
+  bool imageMasked;              // 全量同步后不再使用闪存用户库
+  SnapshotUser *users;           // 覆盖层用户
+  uint32_t userCount;
+  uint32_t userCapacity;
+  CredentialIndex userIdIndex;   // 用户ID -> 覆盖层下标
+  CredentialIndex cardIndex;
+  CredentialIndex fingerprintIndex;
+  CredentialIndex passwordIndex;
+  BloomFilter *cardFilter;       // 卡号过滤器，相邻快照共用，重建后随旧快照回收；NULL表示不过滤
+} UserSnapshot;
+
+/**
+ * 建立初始快照
+ * 闪存用户库已挂载时覆盖层为空，否则载入内置用户
+ * @param builtinUsers 内置用户
+ * @param builtinCount 内置用户数量
+ * @return 是否成功
+ */
+bool user_snapshot_init(const User *builtinUsers, int builtinCount);
+
+/**
+ * 进入读临界区并获取当前快照
+ * 不加锁、不阻塞；退出前快照不会被回收
+ * @return 当前快照
+ */
+const UserSnapshot *user_snapshot_read_lock();
+
+/**
+ * 退出读临界区
+ */
+void user_snapshot_read_unlock();
+
+/**
+ * 批量应用更新并发布新快照（写者）
+ * 基于当前快照复制生成新快照，原子替换后延迟回收旧快照；
+ * 卡号过滤器增量维护，容量不足或计数器饱和时按新快照重建
+ * @param updates 更新列表
+ * @param count 更新条数（不超过USER_SNAPSHOT_MAX_BATCH）
+ * @param version 新版本号，0表示沿用当前版本
+ * @return 成功应用的条数，-1表示失败（快照未变化）
+ */
+int user_snapshot_apply(const IdentityUpdate *updates, int count, uint32_t version);
+
+/**
+ * 以完整用户列表替换用户库并发布新快照（写者）
+ * 用于全量同步：新快照不再引用闪存用户库，卡号过滤器按新用户列表重建
+ * @param users 用户列表
+ * @param count 用户数量
+ * @param version 新版本号
+ * @return 是否成功（失败时快照未变化）
+ */
+bool user_snapshot_replace(const User *users, int count, uint32_t version);
+
+/**
+ * 回收已无读者引用的旧快照
+ */
+void user_snapshot_reclaim();
+
+/**
+ * 根据卡号查找用户
+ * @param snapshot 快照
+ * @param card 卡号键
+ * @param scheduleId 命中时写入用户的时间表ID（可为NULL）
+ * @return 用户ID，0表示未找到或已禁用
+ */
+int user_snapshot_find_card(const UserSnapshot *snapshot, const CardUid *card, uint8_t *scheduleId);
+
+/**
+ * 根据指纹ID查找用户
+ * @param snapshot 快照
+ * @param fingerprintId 指纹ID
+ * @param scheduleId 命中时写入用户的时间表ID（可为NULL）
+ * @return 用户ID，0表示未找到或已禁用
+ */
+int user_snapshot_find_fingerprint(const UserSnapshot *snapshot, int fingerprintId, uint8_t *scheduleId);
+
+/**
+ * 根据密码查找用户
+ * @param snapshot 快照
+ * @param password 密码
+ * @param scheduleId 命中时写入用户的时间表ID（可为NULL）
+ * @return 用户ID，0表示未找到或已禁用
+ */
+int user_snapshot_find_password(const UserSnapshot *snapshot, const char *password, uint8_t *scheduleId);
+
+/**
+ * 校验指定用户的密码
+ * 用于卡或指纹之后的密码因素：多人共用同一密码时按已识别的用户确认，不依赖全局查找的结果
+ * @param snapshot 快照
+ * @param userId 用户ID
+ * @param password 密码
+ * @return 用户生效且密码属于该用户
+ */
+bool user_snapshot_check_password(const UserSnapshot *snapshot, int userId, const char *password);
+
+/**
+ * 获取用户信息
+ * 闪存用户库中的用户只有ID和启用状态
+ * @param snapshot 快照
+ * @param userId 用户ID
+ * @param user 用户信息
+ * @return 是否找到
+ */
+bool user_snapshot_get_user(const UserSnapshot *snapshot, int userId, User *user);
+
+/**
+ * 获取卡号过滤器统计
+ * @param queries 查询次数
+ * @param saved 过滤器直接拒绝、节省的完整查找次数
+ * @param falsePositives 误判次数（过滤器放行但没有该卡的记录）
+ */
+void user_snapshot_get_filter_stats(uint32_t *queries, uint32_t *saved, uint32_t *falsePositives);
+
+/**
+ * 获取快照发布与回收统计
+ * @param published 发布次数（每次发布退役一个旧快照）
+ * @param reclaimed 已回收的旧快照数量
+ * @param retireWaits 待回收队列满、写者等待读者退出的次数
+ */
+void user_snapshot_get_reclaim_stats(uint32_t *published, uint32_t *reclaimed, uint32_t *retireWaits);
+
+#endif
@@ -0,0 +1,541 @@
+#include <Arduino.h>
+#include <PubSubClient.h>
+#include <ArduinoJson.h>
+#include <SD.h>
+#include <esp_heap_caps.h>
+
+// 头文件包含
+#include "modules/user_sync.h"
+#include "modules/identity.h"
+#include "modules/user_snapshot.h"
+#include "modules/user_db.h"
+#include "modules/storage.h"
+#include "modules/communication.h"
+
+// 同步消息解析容量（负载就地解析，字符串不复制）
+#define USER_SYNC_JSON_CAPACITY  8192
+
+// 增量日志记录
+#define USER_SYNC_RECORD_MAGIC  0x4E595355  // "USYN"
+#define USER_SYNC_RECORD_FULL   1           // 完整用户列表（User[]）
+#define USER_SYNC_RECORD_DELTA  2           // 增量（IdentityUpdate[]）
+
+// 增量日志记录头
+typedef struct __attribute__((packed)) {
+  uint32_t magic;
+  uint8_t type;
+  uint8_t reserved[3];
+  uint32_t fromVersion;   // 应用前版本（全量记录不使用）
+  uint32_t toVersion;     // 应用后版本
+  uint32_t count;         // 条目数量
+  uint32_t crc32;         // 条目CRC32
+} UserSyncRecordHeader;
+
+// MQTT客户端
+PubSubClient *syncClient = NULL;
+
+// 设备ID及定向主题
+char syncDeviceId[64] = "";
+char syncDeviceTopic[128] = "";
+
+// 全量同步暂存
+User *fullUsers = NULL;
+uint32_t fullCount = 0;
+uint32_t fullCapacity = 0;
+uint32_t fullVersion = 0;
+uint32_t fullNextSeq = 0;
+unsigned long fullLastMillis = 0;
+bool fullActive = false;
+
+/**
+ * 分配缓冲区（PSRAM优先）
+ */
+static void *user_sync_alloc(size_t size) {
+  void *buffer = NULL;
+  if (psramFound()) {
+    buffer = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  }
+  if (!buffer) {
+    buffer = malloc(size);
+  }
+  return buffer;
+}
+
+/**
+ * 写入一条日志记录
+ */
+static bool user_sync_write_record(File &file, uint8_t type, uint32_t fromVersion, uint32_t toVersion,
+                                   const void *entries, size_t entrySize, uint32_t count) {
+  UserSyncRecordHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = USER_SYNC_RECORD_MAGIC;
+  header.type = type;
+  header.fromVersion = fromVersion;
+  header.toVersion = toVersion;
+  header.count = count;
+  header.crc32 = user_db_crc32(0, (const uint8_t *)entries, count * entrySize);
+
+  if (file.write((const uint8_t *)&header, sizeof(header)) != sizeof(header)) {
+    return false;
+  }
+  return file.write((const uint8_t *)entries, count * entrySize) == count * entrySize;
+}
+
+/**
+ * 将当前用户库状态写入文件
+ * 全量同步后写入完整用户列表，否则写入相对闪存用户库的增量
+ */
+static bool user_sync_write_state(File &file) {
+  const UserSnapshot *snapshot = user_snapshot_read_lock();
+  bool ok = true;
+
+  if (snapshot->imageMasked) {
+    User *users = (User *)user_sync_alloc((snapshot->userCount + 1) * sizeof(User));
+    uint32_t count = 0;
+    if (users) {
+      for (uint32_t i = 0; i < snapshot->userCount; i++) {
+        if (!snapshot->users[i].deleted) {
+          users[count++] = snapshot->users[i].user;
+        }
+      }
+      ok = user_sync_write_record(file, USER_SYNC_RECORD_FULL, 0, snapshot->version,
+                                  users, sizeof(User), count);
+      free(users);
+    } else {
+      ok = false;
+    }
+  } else {
+    // 覆盖层记录还原为增量，分批写入（中间批次不改变版本）
+    uint32_t baseVersion = user_db_get_version();
+    IdentityUpdate *updates = (IdentityUpdate *)user_sync_alloc(USER_SNAPSHOT_MAX_BATCH * sizeof(IdentityUpdate));
+    if (updates) {
+      uint32_t i = 0;
+      do {
+        uint32_t count = 0;
+        for (; i < snapshot->userCount && count < USER_SNAPSHOT_MAX_BATCH; i++) {
+          const SnapshotUser *record = &snapshot->users[i];
+          IdentityUpdate *update = &updates[count++];
+          update->user = record->user;
+          if (record->deleted) {
+            update->type = IDENTITY_UPDATE_DELETE;
+          } else if (record->inheritImage) {
+            update->type = record->user.enabled ? IDENTITY_UPDATE_ENABLE : IDENTITY_UPDATE_DISABLE;
+          } else {
+            update->type = IDENTITY_UPDATE_ADD;
+          }
+        }
+        uint32_t toVersion = (i < snapshot->userCount) ? baseVersion : snapshot->version;
+        ok = user_sync_write_record(file, USER_SYNC_RECORD_DELTA, baseVersion, toVersion,
+                                    updates, sizeof(IdentityUpdate), count);
+      } while (ok && i < snapshot->userCount);
+      free(updates);
+    } else {
+      ok = false;
+    }
+  }
+
+  user_snapshot_read_unlock();
+  return ok;
+}
+
+/**
+ * 压缩增量日志
+ * 先写临时文件再替换，写入中途掉电不会损坏原日志
+ */
+static void user_sync_compact_journal() {
+  if (!storage_is_initialized()) {
+    return;
+  }
+
+  File file = SD.open(USER_SYNC_JOURNAL_TMP_FILE, FILE_WRITE);
+  if (!file) {
+    Serial.println("用户库日志压缩失败: 无法创建文件");
+    return;
+  }
+
+  bool ok = user_sync_write_state(file);
+  file.close();
+
+  if (!ok) {
+    SD.remove(USER_SYNC_JOURNAL_TMP_FILE);
+    Serial.println("用户库日志压缩失败: 写入错误");
+    return;
+  }
+
+  SD.remove(USER_SYNC_JOURNAL_FILE);
+  SD.rename(USER_SYNC_JOURNAL_TMP_FILE, USER_SYNC_JOURNAL_FILE);
+  Serial.printf("用户库日志已压缩: 版本=%u\n", identity_get_db_version());
+}
+
+/**
+ * 追加增量记录，超过长度上限时压缩
+ */
+static void user_sync_append_journal(uint32_t fromVersion, uint32_t toVersion,
+                                     const IdentityUpdate *updates, uint32_t count) {
+  if (!storage_is_initialized()) {
+    return;
+  }
+
+  File file = SD.open(USER_SYNC_JOURNAL_FILE, FILE_APPEND);
+  if (!file) {
+    Serial.println("用户库日志写入失败");
+    return;
+  }
+
+  bool ok = user_sync_write_record(file, USER_SYNC_RECORD_DELTA, fromVersion, toVersion,
+                                   updates, sizeof(IdentityUpdate), count);
+  size_t size = file.size();
+  file.close();
+
+  // 写入失败留下的残缺记录由压缩覆盖
+  if (!ok || size > USER_SYNC_JOURNAL_MAX_SIZE) {
+    user_sync_compact_journal();
+  }
+}
+
+/**
+ * 重放增量日志
+ * @return 日志是否需要重写（存在损坏或过期记录）
+ */
+static bool user_sync_replay_journal() {
+  File file = SD.open(USER_SYNC_JOURNAL_FILE, FILE_READ);
+  if (!file) {
+    return false;
+  }
+
+  bool rewrite = false;
+  int replayed = 0;
+
+  while (file.available()) {
+    UserSyncRecordHeader header;
+    if (file.read((uint8_t *)&header, sizeof(header)) != sizeof(header) ||
+        header.magic != USER_SYNC_RECORD_MAGIC ||
+        (header.type != USER_SYNC_RECORD_FULL && header.type != USER_SYNC_RECORD_DELTA) ||
+        (header.type == USER_SYNC_RECORD_DELTA && header.count > USER_SNAPSHOT_MAX_BATCH) ||
+        (header.type == USER_SYNC_RECORD_FULL && header.count > USER_SYNC_FULL_MAX_USERS)) {
+      rewrite = true;
+      break;
+    }
+
+    size_t entrySize = (header.type == USER_SYNC_RECORD_FULL) ? sizeof(User) : sizeof(IdentityUpdate);
+    size_t size = header.count * entrySize;
+    uint8_t *entries = (uint8_t *)user_sync_alloc(size ? size : 1);
+    if (!entries) {
+      rewrite = true;
+      break;
+    }
+
+    if (file.read(entries, size) != size || user_db_crc32(0, entries, size) != header.crc32) {
+      // 掉电造成的残缺记录，丢弃其后全部内容
+      free(entries);
+      rewrite = true;
+      break;
+    }
+
+    uint32_t version = identity_get_db_version();
+    if (header.type == USER_SYNC_RECORD_FULL && header.toVersion >= version) {
+      identity_replace_users((const User *)entries, header.count, header.toVersion);
+      replayed++;
+    } else if (header.type == USER_SYNC_RECORD_DELTA && header.fromVersion == version) {
+      identity_apply_updates((const IdentityUpdate *)entries, header.count, header.toVersion);
+      replayed++;
+    } else {
+      // 闪存用户库已更新等情况，记录过期
+      rewrite = true;
+    }
+
+    free(entries);
+  }
+
+  file.close();
+  Serial.printf("用户库日志重放: 记录=%d, 版本=%u\n", replayed, identity_get_db_version());
+  return rewrite;
+}
+
+/**
+ * 放弃全量同步暂存
+ */
+static void user_sync_abort_full() {
+  free(fullUsers);
+  fullUsers = NULL;
+  fullCount = 0;
+  fullCapacity = 0;
+  fullActive = false;
+}
+
+/**
+ * 解析用户
+ * {"id", "name", "card", "fingerprint", "password", "enabled", "schedule"}
+ */
+static bool user_sync_parse_user(JsonObject object, User *user) {
+  memset(user, 0, sizeof(User));
+  user->id = object["id"] | 0;
+  if (user->id <= 0) {
+    return false;
+  }
+
+  strlcpy(user->name, object["name"] | "", sizeof(user->name));
+  strlcpy(user->password, object["password"] | "", sizeof(user->password));
+  user->fingerprintId = object["fingerprint"] | 0;
+  user->enabled = object["enabled"] | true;
+  user->scheduleId = object["schedule"] | 0;
+
+  const char *card = object["card"];
+  if (card && card[0] != '\0' && !rfid_uid_from_hex(&user->card, card)) {
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * 处理增量消息
+ * {"type": "delta", "from", "to", "ops": [{"op": "add|enable|disable|delete", "id", ...}]}
+ */
+static void user_sync_handle_delta(JsonDocument &doc) {
+  uint32_t fromVersion = doc["from"] | 0;
+  uint32_t toVersion = doc["to"] | 0;
+  uint32_t version = identity_get_db_version();
+
+  // 重复或过期的增量（广播与定向下发可能重叠）
+  if (toVersion <= version) {
+    return;
+  }
+
+  // 版本不连续，请求后台补齐
+  if (fromVersion != version) {
+    Serial.printf("用户库增量不连续: 本地=%u, 增量=%u->%u\n", version, fromVersion, toVersion);
+    user_sync_report("gap");
+    return;
+  }
+
+  JsonArray ops = doc["ops"];
+  if (ops.isNull()) {
+    Serial.printf("用户库增量缺少操作列表: %u->%u\n", fromVersion, toVersion);
+    user_sync_report("apply_failed");
+    return;
+  }
+  if (ops.size() > USER_SNAPSHOT_MAX_BATCH) {
+    user_sync_report("gap");
+    return;
+  }
+
+  IdentityUpdate *updates = (IdentityUpdate *)user_sync_alloc((ops.size() + 1) * sizeof(IdentityUpdate));
+  if (!updates) {
+    return;
+  }
+
+  // 任一操作无法解析时整批放弃，不推进版本，由后台重发或全量同步（避免丢失禁用/删除）
+  uint32_t count = 0;
+  for (JsonObject op : ops) {
+    const char *type = op["op"] | "";
+    IdentityUpdate *update = &updates[count];
+    memset(update, 0, sizeof(IdentityUpdate));
+    update->user.id = op["id"] | 0;
+
+    bool parsed = true;
+    if (strcmp(type, "add") == 0) {
+      update->type = IDENTITY_UPDATE_ADD;
+      parsed = user_sync_parse_user(op, &update->user);
+    } else if (strcmp(type, "enable") == 0) {
+      update->type = IDENTITY_UPDATE_ENABLE;
+    } else if (strcmp(type, "disable") == 0) {
+      update->type = IDENTITY_UPDATE_DISABLE;
+    } else if (strcmp(type, "delete") == 0) {
+      update->type = IDENTITY_UPDATE_DELETE;
+    } else {
+      parsed = false;
+    }
+
+    if (!parsed || update->user.id <= 0) {
+      Serial.printf("用户库增量操作无效: 第%u项, 操作=%s, 版本=%u->%u\n", count, type, fromVersion, toVersion);
+      free(updates);
+      user_sync_report("apply_failed");
+      return;
+    }
+    count++;
+  }
+
+  // 整批一次发布，成功后再持久化
+  int applied = identity_apply_updates(updates, count, toVersion);
+  if (applied >= 0) {
+    user_sync_append_journal(fromVersion, toVersion, updates, count);
+    Serial.printf("用户库增量已应用: 版本=%u->%u, 操作=%u, 生效=%d\n", fromVersion, toVersion, count, applied);
+    user_sync_report("applied");
+  } else {
+    user_sync_report("apply_failed");
+  }
+
+  free(updates);
+}
+
+/**
+ * 处理全量同步分片
+ * {"type": "full", "to", "seq", "last", "users": [...]}
+ */
+static void user_sync_handle_full(JsonDocument &doc) {
+  uint32_t toVersion = doc["to"] | 0;
+  uint32_t seq = doc["seq"] | 0;
+
+  if (seq == 0) {
+    user_sync_abort_full();
+    fullActive = true;
+    fullVersion = toVersion;
+    fullNextSeq = 0;
+  } else if (!fullActive || toVersion != fullVersion || seq != fullNextSeq) {
+    Serial.printf("全量同步分片错误: 期望=%u, 收到=%u\n", fullNextSeq, seq);
+    user_sync_abort_full();
+    user_sync_report("resync_failed");
+    return;
+  }
+
+  JsonArray users = doc["users"];
+  if (fullCount + users.size() > USER_SYNC_FULL_MAX_USERS) {
+    user_sync_abort_full();
+    user_sync_report("resync_failed");
+    return;
+  }
+
+  // 按需扩容暂存区
+  if (fullCount + users.size() > fullCapacity) {
+    uint32_t capacity = fullCapacity ? fullCapacity : 64;
+    while (capacity < fullCount + users.size()) {
+      capacity <<= 1;
+    }
+    User *grown = (User *)user_sync_alloc(capacity * sizeof(User));
+    if (!grown) {
+      user_sync_abort_full();
+      user_sync_report("resync_failed");
+      return;
+    }
+    if (fullUsers) {
+      memcpy(grown, fullUsers, fullCount * sizeof(User));
+      free(fullUsers);
+    }
+    fullUsers = grown;
+    fullCapacity = capacity;
+  }
+
+  // 任一用户无法解析时放弃本次传输：跳过会在替换时把该用户从设备上删除
+  for (JsonObject object : users) {
+    if (!user_sync_parse_user(object, &fullUsers[fullCount])) {
+      Serial.printf("全量同步用户无效: 分片=%u, 第%u个\n", seq, fullCount);
+      user_sync_abort_full();
+      user_sync_report("resync_failed");
+      return;
+    }
+    fullCount++;
+  }
+
+  fullNextSeq++;
+  fullLastMillis = millis();
+
+  if (!(doc["last"] | false)) {
+    return;
+  }
+
+  // 最后一片到达后一次性替换
+  if (identity_replace_users(fullUsers, fullCount, fullVersion)) {
+    Serial.printf("用户库全量同步完成: 版本=%u, 用户=%u\n", fullVersion, fullCount);
+    user_sync_abort_full();
+    user_sync_compact_journal();
+    user_sync_report("applied");
+  } else {
+    user_sync_abort_full();
+    user_sync_report("resync_failed");
+  }
+}
+
+/**
+ * 用户库同步初始化
+ */
+void user_sync_init() {
+  if (!storage_is_initialized()) {
+    Serial.println("存储不可用，用户库同步不持久化");
+    return;
+  }
+
+  if (user_sync_replay_journal()) {
+    user_sync_compact_journal();
+  }
+}
+
+/**
+ * 订阅同步主题并上报版本
+ * @param client MQTT客户端
+ * @param deviceId 设备ID
+ */
+void user_sync_subscribe(PubSubClient *client, const char *deviceId) {
+  syncClient = client;
+  strlcpy(syncDeviceId, deviceId, sizeof(syncDeviceId));
+  snprintf(syncDeviceTopic, sizeof(syncDeviceTopic), "%s%s", USER_SYNC_TOPIC_DEVICE, deviceId);
+
+  client->subscribe(USER_SYNC_TOPIC_DELTA);
+  client->subscribe(syncDeviceTopic);
+  Serial.printf("已订阅主题: %s, %s\n", USER_SYNC_TOPIC_DELTA, syncDeviceTopic);
+
+  // 重连后重新上报，由后台补齐离线期间的增量
+  user_sync_abort_full();
+  user_sync_report("connect");
+}
+
+/**
+ * 处理同步消息
+ * @param topic 主题
+ * @param payload 负载
+ * @param length 长度
+ * @return 是否为同步消息
+ */
+bool user_sync_handle_message(const char *topic, byte *payload, unsigned int length) {
+  if (strcmp(topic, USER_SYNC_TOPIC_DELTA) != 0 && strcmp(topic, syncDeviceTopic) != 0) {
+    return false;
+  }
+
+  // 全量同步中断超时
+  if (fullActive && millis() - fullLastMillis > USER_SYNC_FULL_TIMEOUT) {
+    Serial.println("全量同步超时");
+    user_sync_abort_full();
+  }
+
+  DynamicJsonDocument doc(USER_SYNC_JSON_CAPACITY);
+  DeserializationError error = deserializeJson(doc, (char *)payload, length);
+  if (error) {
+    Serial.printf("同步消息解析错误: %s\n", error.c_str());
+    return true;
+  }
+
+  const char *type = doc["type"] | "";
+  if (strcmp(type, "delta") == 0) {
+    user_sync_handle_delta(doc);
+  } else if (strcmp(type, "full") == 0) {
+    user_sync_handle_full(doc);
+  }
+
+  return true;
+}
+
+/**
+ * 上报当前用户库版本
+ * @param reason 上报原因
+ */
+void user_sync_report(const char *reason) {
+  if (!syncClient) {
+    return;
+  }
+
+  DynamicJsonDocument doc(256);
+  doc["device_id"] = syncDeviceId;
+  doc["db_version"] = identity_get_db_version();
+  doc["reason"] = reason;
+  doc["timestamp"] = millis();
+
+  char payload[256];
+  serializeJson(doc, payload);
+
+  communication_lock();
+  if (syncClient->connected()) {
+    syncClient->publish(USER_SYNC_TOPIC_REPORT, payload);
+    Serial.printf("上报用户库版本: %u (%s)\n", identity_get_db_version(), reason);
+  }
+  communication_unlock();
+}
@@ -0,0 +1,61 @@
+#ifndef USER_SYNC_H
+#define USER_SYNC_H
+
+#include <Arduino.h>
+#include <PubSubClient.h>
+
+// 同步主题
+// 设备上报版本：{"device_id", "db_version", "reason"}
+#define USER_SYNC_TOPIC_REPORT   "access-control/userdb/report"
+// 后台广播增量（所有设备订阅）
+#define USER_SYNC_TOPIC_DELTA    "access-control/userdb/delta"
+// 后台定向下发（增量补齐或全量同步），后接设备ID
+#define USER_SYNC_TOPIC_DEVICE   "access-control/userdb/device/"
+
+// MQTT缓冲区大小（单条同步消息上限）
+#define USER_SYNC_MQTT_BUFFER_SIZE  4096
+
+// 增量日志文件
+#define USER_SYNC_JOURNAL_FILE      "/userdb.journal"
+#define USER_SYNC_JOURNAL_TMP_FILE  "/userdb.journal.tmp"
+
+// 增量日志超过该长度时压缩为当前状态
+#define USER_SYNC_JOURNAL_MAX_SIZE  (64 * 1024)
+
+// 全量同步分片间隔超时（毫秒）
+#define USER_SYNC_FULL_TIMEOUT  30000
+
+// 全量同步用户数量上限
+#define USER_SYNC_FULL_MAX_USERS  8192
+
+/**
+ * 用户库同步初始化
+ * 重放SD卡上的增量日志，须在存储和身份识别模块之后调用
+ */
+void user_sync_init();
+
+/**
+ * 订阅同步主题并上报版本
+ * MQTT连接成功后调用
+ * @param client MQTT客户端
+ * @param deviceId 设备ID
+ */
+void user_sync_subscribe(PubSubClient *client, const char *deviceId);
+
+/**
+ * 处理同步消息
+ * @param topic 主题
+ * @param payload 负载（就地解析，会被修改）
+ * @param length 长度
+ * @return 是否为同步消息
+ */
+bool user_sync_handle_message(const char *topic, byte *payload, unsigned int length);
+
+/**
+ * 上报当前用户库版本
+ * 后台据此下发增量或全量同步，应用成功后的上报同时作为确认
+ * @param reason 上报原因
+ */
+void user_sync_report(const char *reason);
+
+#endif
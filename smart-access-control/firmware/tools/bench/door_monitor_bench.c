@@ -0,0 +1,224 @@
+/*
+ * 门状态关联主机时间线测试
+ *
+ * 按脚本给出锁状态和门磁变化的时间线（毫秒），检查强行开门、门长时间未关的报警与期望一致：
+ *   - 正常进出：开锁、开门、关门、关锁，不报警
+ *   - 强行开门：关锁状态下开门，立即报警
+ *   - 门长时间未关：到阈值时报警，关门时解除
+ *   - 关锁宽限期：定时关锁后1s内推开门（开门时恰好关锁），不报警
+ *   - 门开着时关锁，关门后再次打开：再次打开为强行开门
+ *   - 踹门回弹：关锁状态下门打开60ms后弹回
+ *   - 单门阈值：阈值设为10s
+ * 事件驱动：门磁边沿和锁状态变化到来时调用 door_monitor.c 判断，门长时间未关按 door_monitor_deadline 定时
+ * （与 security.c 一致；门磁事件本身的延迟见 sensor_bench）。
+ * 与轮询比较：每100ms（访问控制任务周期）或10s（安全任务周期）读取锁和门状态判断。
+ * 统计每个场景的报警、漏报、误报和报警延迟。
+ *
+ * 编译运行（firmware 目录下）:
+ *   cc -O2 -Isrc tools/bench/door_monitor_bench.c src/modules/door_monitor.c -o door_monitor_bench && ./door_monitor_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "modules/door_monitor.h"
+
+// 检查项：事件驱动的报警延迟上限(ms)
+#define MAX_LATENCY_MS  0
+
+#define MAX_STEPS   16
+#define MAX_ALARMS  16
+
+typedef enum {
+  STEP_LOCK,      // 锁状态变化，value=是否关锁
+  STEP_DOOR,      // 门状态变化，value=门是否打开
+} StepType;
+
+typedef struct {
+  uint32_t time;
+  StepType type;
+  bool value;
+} Step;
+
+typedef struct {
+  uint32_t time;
+  uint8_t action;
+} Alarm;
+
+typedef struct {
+  const char *name;
+  uint32_t heldOpenMs;     // 0表示默认
+  uint32_t duration;       // 时间线长度(ms)
+  Step steps[MAX_STEPS];
+  int stepCount;
+  Alarm expected[MAX_ALARMS];
+  int expectedCount;
+} Scenario;
+
+typedef struct {
+  Alarm alarms[MAX_ALARMS];
+  int count;
+} AlarmLog;
+
+static void log_actions(AlarmLog *log, uint8_t actions, uint32_t now) {
+  for (uint8_t bit = DOOR_ACTION_FORCED; bit <= DOOR_ACTION_HELD_OPEN_CLEAR; bit <<= 1) {
+    if ((actions & bit) && log->count < MAX_ALARMS) {
+      log->alarms[log->count].time = now;
+      log->alarms[log->count].action = bit;
+      log->count++;
+    }
+  }
+}
+
+/**
+ * 事件驱动：状态变化时判断，门长时间未关用单次定时器
+ */
+static void run_event(const Scenario *scenario, AlarmLog *log) {
+  DoorMonitor door;
+  door_monitor_init(&door, scenario->heldOpenMs, true, false, 0);
+  memset(log, 0, sizeof(*log));
+
+  uint32_t timer = DOOR_MONITOR_NONE;
+  for (int i = 0; i <= scenario->stepCount; i++) {
+    uint32_t next = i < scenario->stepCount ? scenario->steps[i].time : scenario->duration;
+
+    // 定时器先于下一个变化到时
+    while (timer != DOOR_MONITOR_NONE && timer <= next) {
+      uint32_t now = timer;
+      log_actions(log, door_monitor_poll(&door, now), now);
+      uint32_t wait = door_monitor_deadline(&door, now);
+      timer = wait == DOOR_MONITOR_NONE ? DOOR_MONITOR_NONE : now + wait;
+    }
+    if (i == scenario->stepCount) {
+      break;
+    }
+
+    const Step *step = &scenario->steps[i];
+    if (step->type == STEP_LOCK) {
+      door_monitor_lock(&door, step->value, step->time);
+    } else {
+      log_actions(log, door_monitor_door(&door, step->value, step->time), step->time);
+      uint32_t wait = door_monitor_deadline(&door, step->time);
+      timer = wait == DOOR_MONITOR_NONE ? DOOR_MONITOR_NONE : step->time + wait;
+    }
+  }
+}
+
+/**
+ * 轮询：每个周期读取一次锁和门的当前状态（采样时刻与时间线错开周期的37%）
+ */
+static void run_poll(const Scenario *scenario, uint32_t period, AlarmLog *log) {
+  DoorMonitor door;
+  door_monitor_init(&door, scenario->heldOpenMs, true, false, 0);
+  memset(log, 0, sizeof(*log));
+
+  bool locked = true;
+  bool open = false;
+  int step = 0;
+  for (uint32_t now = period * 37 / 100; now <= scenario->duration; now += period) {
+    while (step < scenario->stepCount && scenario->steps[step].time <= now) {
+      if (scenario->steps[step].type == STEP_LOCK) {
+        locked = scenario->steps[step].value;
+      } else {
+        open = scenario->steps[step].value;
+      }
+      step++;
+    }
+    door_monitor_lock(&door, locked, now);
+    log_actions(log, door_monitor_door(&door, open, now), now);
+    log_actions(log, door_monitor_poll(&door, now), now);
+  }
+}
+
+typedef struct {
+  int alarms;
+  int missed;
+  int spurious;
+  uint32_t latencyMax;
+} Result;
+
+/**
+ * 按顺序匹配期望报警：同类型、不早于期望时间
+ */
+static Result compare(const Scenario *scenario, const AlarmLog *log) {
+  Result result = {log->count, 0, 0, 0};
+  bool used[MAX_ALARMS] = {false};
+  for (int i = 0; i < scenario->expectedCount; i++) {
+    const Alarm *expected = &scenario->expected[i];
+    int match = -1;
+    for (int j = 0; j < log->count; j++) {
+      if (!used[j] && log->alarms[j].action == expected->action && log->alarms[j].time >= expected->time) {
+        match = j;
+        break;
+      }
+    }
+    if (match < 0) {
+      result.missed++;
+      continue;
+    }
+    used[match] = true;
+    uint32_t latency = log->alarms[match].time - expected->time;
+    result.latencyMax = latency > result.latencyMax ? latency : result.latencyMax;
+  }
+  for (int j = 0; j < log->count; j++) {
+    result.spurious += !used[j];
+  }
+  return result;
+}
+
+static void print_result(const char *name, const char *mode, const Result *result) {
+  printf("%-14s %-8s %6d %6d %6d %10u\n", name, mode, result->alarms, result->missed, result->spurious,
+         result->latencyMax);
+}
+
+int main() {
+  Scenario scenarios[] = {
+    {"正常进出", 0, 60000,
+     {{10000, STEP_LOCK, false}, {11500, STEP_DOOR, true}, {14000, STEP_DOOR, false}, {14000, STEP_LOCK, true}}, 4,
+     {}, 0},
+    {"强行开门", 0, 60000,
+     {{10000, STEP_DOOR, true}, {12000, STEP_DOOR, false}}, 2,
+     {{10000, DOOR_ACTION_FORCED}}, 1},
+    {"门长时间未关", 0, 90000,
+     {{10000, STEP_LOCK, false}, {11000, STEP_DOOR, true}, {55000, STEP_DOOR, false}, {55000, STEP_LOCK, true}}, 4,
+     {{41000, DOOR_ACTION_HELD_OPEN}, {55000, DOOR_ACTION_HELD_OPEN_CLEAR}}, 2},
+    {"关锁宽限期", 0, 60000,
+     {{10000, STEP_LOCK, false}, {15000, STEP_LOCK, true}, {15400, STEP_DOOR, true}, {17000, STEP_DOOR, false}}, 4,
+     {}, 0},
+    {"开门时关锁", 0, 60000,
+     {{10000, STEP_LOCK, false}, {11000, STEP_DOOR, true}, {13000, STEP_LOCK, true}, {16000, STEP_DOOR, false},
+      {30000, STEP_DOOR, true}, {31000, STEP_DOOR, false}}, 6,
+     {{30000, DOOR_ACTION_FORCED}}, 1},
+    {"踹门回弹", 0, 60000,
+     {{10030, STEP_DOOR, true}, {10090, STEP_DOOR, false}}, 2,
+     {{10030, DOOR_ACTION_FORCED}}, 1},
+    {"阈值10s", 10000, 60000,
+     {{10000, STEP_LOCK, false}, {11000, STEP_DOOR, true}, {25000, STEP_DOOR, false}, {25000, STEP_LOCK, true}}, 4,
+     {{21000, DOOR_ACTION_HELD_OPEN}, {25000, DOOR_ACTION_HELD_OPEN_CLEAR}}, 2},
+  };
+
+  printf("%-14s %-8s %6s %6s %6s %10s\n", "场景", "方式", "报警", "漏报", "误报", "最大延迟ms");
+  int ok = 1;
+  for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+    const Scenario *scenario = &scenarios[i];
+    AlarmLog log;
+
+    run_event(scenario, &log);
+    Result event = compare(scenario, &log);
+    print_result(scenario->name, "事件", &event);
+    if (event.missed > 0 || event.spurious > 0 || event.latencyMax > MAX_LATENCY_MS) {
+      printf("%s: 未达到要求\n", scenario->name);
+      ok = 0;
+    }
+
+    run_poll(scenario, 100, &log);
+    Result poll100 = compare(scenario, &log);
+    print_result(scenario->name, "轮询100ms", &poll100);
+
+    run_poll(scenario, 10000, &log);
+    Result poll10s = compare(scenario, &log);
+    print_result(scenario->name, "轮询10s", &poll10s);
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,323 @@
+/*
+ * 事件总线与固定周期轮询主机仿真
+ *
+ * 生成一天的门禁流量（时间为微秒）：
+ *   - 300次通行：刷卡60%、指纹25%、密码15%（7个按键，间隔300ms），通过后1.5s开门、5s关门
+ *   - 50条MQTT命令、2次防拆
+ * 每个任务按单个处理者仿真（双核，任务之间不争用），比较三种方式：
+ *   - 轮询：访问控制任务100ms、通信任务5s、安全任务10s固定延迟，循环任务1s处理MQTT，
+ *     触摸、按键、门磁、防拆、命令都在下一次周期到来时才被发现
+ *   - 事件总线：驱动投递事件，处理任务在队列上等待；寻卡、状态上报、安全检查按到时时间进行
+ *   - 事件总线+短寻卡超时：读卡区无卡时MFRC522寻卡等待1ms而不是25ms
+ * 读卡器没有自主寻卡能力（IRQ未接），三种方式都由访问控制任务每100ms寻卡，刷卡延迟相同。
+ * 统计每小时唤醒次数、CPU占用（按下面的耗时估计，占一个核的比例）和各类事件到开始处理的延迟。
+ *
+ * 编译运行（firmware 目录下）:
+ *   cc -O2 -Isrc tools/bench/event_bus_bench.c -o event_bus_bench && ./event_bus_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "modules/event_bus.h"
+
+#define DAY_US  (86400ull * 1000000)
+
+// 耗时估计(us)
+#define WAKE_US              20      // 任务切换、队列操作
+#define RFID_PROBE_SLOW_US   25500   // 无卡寻卡：库函数忙等MFRC522定时器超时（默认25ms）
+#define RFID_PROBE_FAST_US   1500    // 无卡寻卡：定时器缩短到1ms
+#define ACCESS_TICK_US       200     // 其余到时工作（多因素会话、指纹流水线、录入、人脸同步队列）
+#define STATUS_PUBLISH_US    15000   // 设备状态、传感器数据JSON序列化和发布
+#define SECURITY_CHECK_US    2000    // 锁定到期、网络检查、数据同步
+#define LOOP_US              100     // 循环任务检查连接
+
+// 周期(us)
+#define ACCESS_PERIOD_US    100000
+#define COMM_PERIOD_US      5000000
+#define SECURITY_PERIOD_US  10000000
+#define LOOP_PERIOD_US      1000000
+
+// 事件处理耗时(us)
+static const uint32_t serviceUs[BUS_EVENT_TYPE_COUNT] = {
+  20000,   // 刷卡：查找用户、开锁、发布记录
+  3000,    // 触摸：发起采集
+  500,     // 按键
+  500,     // 门磁
+  20000,   // 防拆：报警、冻结录像
+  5000,    // MQTT命令
+};
+
+static const char *const eventNames[BUS_EVENT_TYPE_COUNT] = {"刷卡", "触摸", "按键", "门磁", "防拆", "命令"};
+
+#define MAX_ARRIVALS  8192
+
+typedef struct {
+  uint64_t time;
+  uint8_t type;
+} Arrival;
+
+typedef struct {
+  Arrival items[MAX_ARRIVALS];
+  int count;
+} Arrivals;
+
+// 延迟记录
+typedef struct {
+  uint32_t values[MAX_ARRIVALS];
+  int count;
+} Latencies;
+
+typedef struct {
+  uint64_t wakeups;
+  uint64_t busyUs;
+  Latencies latency[BUS_EVENT_TYPE_COUNT];
+} Result;
+
+static uint32_t randomState = 20240521;
+
+static uint32_t random_next() {
+  randomState = randomState * 1664525u + 1013904223u;
+  return randomState;
+}
+
+static uint64_t random_time() {
+  return ((uint64_t)random_next() << 16 ^ random_next()) % (DAY_US - 60000000ull);
+}
+
+static void add(Arrivals *arrivals, uint64_t time, uint8_t type) {
+  if (arrivals->count < MAX_ARRIVALS) {
+    arrivals->items[arrivals->count].time = time;
+    arrivals->items[arrivals->count].type = type;
+    arrivals->count++;
+  }
+}
+
+static int compare_arrival(const void *a, const void *b) {
+  uint64_t x = ((const Arrival *)a)->time;
+  uint64_t y = ((const Arrival *)b)->time;
+  return x < y ? -1 : x > y;
+}
+
+static int compare_u32(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a;
+  uint32_t y = *(const uint32_t *)b;
+  return x < y ? -1 : x > y;
+}
+
+static void record(Result *result, uint8_t type, uint64_t latency) {
+  Latencies *latencies = &result->latency[type];
+  if (latencies->count < MAX_ARRIVALS) {
+    latencies->values[latencies->count++] = (uint32_t)latency;
+  }
+}
+
+/**
+ * 固定周期轮询：每次唤醒发现此前到达的全部事件，处理完后延迟一个周期
+ */
+static void run_poll(const Arrivals *arrivals, uint64_t period, uint32_t tickUs, Result *result) {
+  int next = 0;
+  uint64_t t = 0;
+  while (t < DAY_US) {
+    result->wakeups++;
+    uint64_t now = t + WAKE_US;
+    for (; next < arrivals->count && arrivals->items[next].time <= t; next++) {
+      const Arrival *arrival = &arrivals->items[next];
+      record(result, arrival->type, now - arrival->time);
+      now += serviceUs[arrival->type];
+    }
+    now += tickUs;
+    result->busyUs += now - t;
+    t = now + period;
+  }
+}
+
+/**
+ * 事件总线：队列上等待事件，超时为下一次到时工作
+ * probed 中的事件类型不唤醒任务，由到时工作（寻卡）发现
+ */
+static void run_bus(const Arrivals *arrivals, uint64_t period, uint32_t tickUs, uint32_t probed, Result *result) {
+  static bool done[MAX_ARRIVALS];
+  memset(done, 0, sizeof(done));
+  int next = 0;
+  uint64_t t = 0;
+  uint64_t deadline = 0;
+  while (1) {
+    while (next < arrivals->count && done[next]) {
+      next++;
+    }
+
+    // 下一个唤醒任务的事件
+    int wake = next;
+    while (wake < arrivals->count && (done[wake] || (probed & (1u << arrivals->items[wake].type)))) {
+      wake++;
+    }
+    uint64_t at = deadline;
+    if (wake < arrivals->count && arrivals->items[wake].time < at) {
+      at = arrivals->items[wake].time;
+    }
+    if (at >= DAY_US) {
+      break;
+    }
+
+    bool idle = at > t;
+    uint64_t start = idle ? at : t;
+    uint64_t now = start + (idle ? WAKE_US : 0);
+    result->wakeups += idle;
+
+    // 到时工作（寻卡发现已到达的卡片）
+    bool timed = deadline <= now;
+    if (timed) {
+      now += tickUs;
+      deadline += period;
+    }
+
+    // 取出全部已到达的事件
+    for (int i = next; i < arrivals->count && arrivals->items[i].time <= now; i++) {
+      const Arrival *arrival = &arrivals->items[i];
+      if (done[i] || ((probed & (1u << arrival->type)) && !timed)) {
+        continue;
+      }
+      record(result, arrival->type, now - arrival->time);
+      now += serviceUs[arrival->type];
+      done[i] = true;
+    }
+    result->busyUs += now - start;
+    t = now;
+  }
+}
+
+static Arrivals accessArrivals;
+static Arrivals securityArrivals;
+static Arrivals commArrivals;
+
+static void generate() {
+  for (int i = 0; i < 300; i++) {
+    uint64_t t = random_time();
+    uint32_t method = random_next() % 100;
+    if (method < 60) {
+      add(&accessArrivals, t, BUS_EVENT_CARD);
+    } else if (method < 85) {
+      add(&accessArrivals, t, BUS_EVENT_TOUCH);
+    } else {
+      for (int k = 0; k < 7; k++) {
+        add(&accessArrivals, t + k * 300000ull, BUS_EVENT_KEY);
+      }
+      t += 6 * 300000ull;
+    }
+    for (int edge = 0; edge < 2; edge++) {
+      uint64_t door = t + (edge ? 5000000ull : 1500000ull);
+      add(&accessArrivals, door, BUS_EVENT_DOOR);
+      add(&securityArrivals, door, BUS_EVENT_DOOR);
+    }
+  }
+  for (int i = 0; i < 2; i++) {
+    add(&securityArrivals, random_time(), BUS_EVENT_TAMPER);
+  }
+  for (int i = 0; i < 50; i++) {
+    add(&commArrivals, random_time(), BUS_EVENT_MQTT_COMMAND);
+  }
+  qsort(accessArrivals.items, accessArrivals.count, sizeof(Arrival), compare_arrival);
+  qsort(securityArrivals.items, securityArrivals.count, sizeof(Arrival), compare_arrival);
+  qsort(commArrivals.items, commArrivals.count, sizeof(Arrival), compare_arrival);
+}
+
+static void merge(Result *total, const Result *part) {
+  total->wakeups += part->wakeups;
+  total->busyUs += part->busyUs;
+  for (int type = 0; type < BUS_EVENT_TYPE_COUNT; type++) {
+    const Latencies *from = &part->latency[type];
+    Latencies *to = &total->latency[type];
+    for (int i = 0; i < from->count && to->count < MAX_ARRIVALS; i++) {
+      to->values[to->count++] = from->values[i];
+    }
+  }
+}
+
+static void print_result(const char *name, Result *result) {
+  printf("%-22s %10.0f %8.2f%%", name, result->wakeups / 24.0, 100.0 * result->busyUs / DAY_US);
+  for (int type = 0; type < BUS_EVENT_TYPE_COUNT; type++) {
+    Latencies *latencies = &result->latency[type];
+    if (latencies->count == 0) {
+      printf("  %18s", "-");
+      continue;
+    }
+    qsort(latencies->values, latencies->count, sizeof(uint32_t), compare_u32);
+    printf("  %5.1f/%5.1f/%6.1f", latencies->values[latencies->count / 2] / 1000.0,
+           latencies->values[latencies->count * 99 / 100] / 1000.0, latencies->values[latencies->count - 1] / 1000.0);
+  }
+  printf("\n");
+}
+
+static Result results[3];
+
+int main() {
+  generate();
+
+  static Arrivals none = {{{0, 0}}, 0};
+  uint32_t probed = 1u << BUS_EVENT_CARD;
+
+  // 轮询
+  Result part;
+  memset(&part, 0, sizeof(part));
+  run_poll(&accessArrivals, ACCESS_PERIOD_US, RFID_PROBE_SLOW_US + ACCESS_TICK_US, &part);
+  merge(&results[0], &part);
+  memset(&part, 0, sizeof(part));
+  run_poll(&securityArrivals, SECURITY_PERIOD_US, SECURITY_CHECK_US, &part);
+  merge(&results[0], &part);
+  memset(&part, 0, sizeof(part));
+  run_poll(&none, COMM_PERIOD_US, STATUS_PUBLISH_US, &part);
+  merge(&results[0], &part);
+  memset(&part, 0, sizeof(part));
+  run_poll(&commArrivals, LOOP_PERIOD_US, LOOP_US, &part);
+  merge(&results[0], &part);
+
+  // 事件总线（循环任务在连接可读时立即返回，命令由通信任务处理，另计一次切换）
+  for (int fast = 0; fast < 2; fast++) {
+    Result *result = &results[1 + fast];
+    uint32_t probeUs = fast ? RFID_PROBE_FAST_US : RFID_PROBE_SLOW_US;
+
+    memset(&part, 0, sizeof(part));
+    run_bus(&accessArrivals, ACCESS_PERIOD_US, probeUs + ACCESS_TICK_US, probed, &part);
+    merge(result, &part);
+    memset(&part, 0, sizeof(part));
+    run_bus(&securityArrivals, SECURITY_PERIOD_US, SECURITY_CHECK_US, 0, &part);
+    merge(result, &part);
+    memset(&part, 0, sizeof(part));
+    run_bus(&commArrivals, COMM_PERIOD_US, STATUS_PUBLISH_US, 0, &part);
+    for (int i = 0; i < part.latency[BUS_EVENT_MQTT_COMMAND].count; i++) {
+      part.latency[BUS_EVENT_MQTT_COMMAND].values[i] += WAKE_US;
+    }
+    part.wakeups += commArrivals.count;
+    merge(result, &part);
+    memset(&part, 0, sizeof(part));
+    run_poll(&none, LOOP_PERIOD_US, LOOP_US, &part);
+    merge(result, &part);
+  }
+
+  printf("各类事件到开始处理的延迟 p50/p99/max (ms)\n");
+  printf("%-22s %10s %9s", "方式", "唤醒/小时", "CPU");
+  for (int type = 0; type < BUS_EVENT_TYPE_COUNT; type++) {
+    printf("  %18s", eventNames[type]);
+  }
+  printf("\n");
+  print_result("轮询", &results[0]);
+  print_result("事件总线", &results[1]);
+  print_result("事件总线+短寻卡超时", &results[2]);
+
+  // 检查项：事件总线下除刷卡外的事件延迟不超过1个处理耗时，CPU占用低于轮询的十分之一
+  int ok = results[2].busyUs * 10 < results[0].busyUs;
+  for (int type = 0; type < BUS_EVENT_TYPE_COUNT; type++) {
+    Latencies *latencies = &results[2].latency[type];
+    if (type != BUS_EVENT_CARD && latencies->count > 0 && latencies->values[latencies->count - 1] > 25000) {
+      printf("%s: 事件总线延迟未达到要求\n", eventNames[type]);
+      ok = 0;
+    }
+  }
+  if (results[2].busyUs * 10 >= results[0].busyUs) {
+    printf("CPU占用未达到要求\n");
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,338 @@
+/*
+ * 人脸特征近似最近邻索引主机测试
+ *
+ * 随机生成特征库（每个身份一个近似正交的随机特征），逐个插入索引；
+ * 查询为已登记特征加扰动（模拟同一人另一次拍摄，与登记特征相似度约0.9）。
+ * 按特征库规模 1k ~ 20k 统计：
+ *   - 插入耗时
+ *   - 近似查询（ef = 16/32/64）的 recall@1（与精确查询最佳结果一致的比例）、平均耗时、平均比对个数
+ *   - 精确查询（逐个比对）的平均耗时
+ *   - 每个特征占用的内存
+ * 然后检查保存后载入的索引查询结果不变、删除的用户不再返回。
+ * 最后统计默认阈值和领先幅度下近似查询的误识率：随机特征之间近似正交，不同人的相似度接近0，
+ * 这里改用含公共分量的特征（不同人之间平均相似度 SHARED_SIMILARITY，接近 face_bench 中合成人脸的冒充者），
+ * 以未登记身份查询统计误识率、认错率及近似查询比精确查询多接受的次数，
+ * 误识率或认错率超过 MAX_FAR_PERCENT 时失败（recall@1 只反映近似查询与精确查询的一致程度，不反映误识）。
+ *
+ * 编译运行（firmware 目录下）:
+ *   cc -O2 -Isrc tools/bench/face_index_bench.c src/modules/face_index.c src/modules/face_match.c -lm -o face_index_bench
+ *   ./face_index_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "modules/face_index.h"
+
+#define MAX_GALLERY  20000
+#define QUERIES      1000
+
+// 查询扰动幅度（相对特征各分量）
+#define QUERY_NOISE  0.45f
+
+// recall@1 下限（默认ef）
+#define MIN_RECALL  0.98
+
+// 误识率统计：特征库规模、未登记身份查询数、不同人之间的平均相似度，及允许的误识率、认错率(%)
+#define FAR_GALLERY        10000
+#define UNENROLLED         1000
+#define SHARED_SIMILARITY  0.84f
+#define MAX_FAR_PERCENT    1
+
+static uint32_t randomState = 1;
+
+static float random_unit() {
+  randomState = randomState * 1664525u + 1013904223u;
+  return (randomState >> 8) / 16777216.0f;
+}
+
+static float random_range(float low, float high) {
+  return low + (high - low) * random_unit();
+}
+
+static double now_seconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void quantize(const float *values, FaceEmbedding *embedding) {
+  float norm = 0;
+  for (int i = 0; i < FACE_EMBEDDING_DIM; i++) {
+    norm += values[i] * values[i];
+  }
+  for (int i = 0; i < FACE_EMBEDDING_DIM; i++) {
+    embedding->values[i] = (int8_t)lrintf(values[i] * FACE_SCALE / sqrtf(norm));
+  }
+}
+
+static void random_embedding(FaceEmbedding *embedding) {
+  float values[FACE_EMBEDDING_DIM];
+  for (int i = 0; i < FACE_EMBEDDING_DIM; i++) {
+    values[i] = random_range(-1, 1);
+  }
+  quantize(values, embedding);
+}
+
+static void random_unit_vector(float *values) {
+  float norm = 0;
+  for (int i = 0; i < FACE_EMBEDDING_DIM; i++) {
+    values[i] = random_range(-1, 1);
+    norm += values[i] * values[i];
+  }
+  for (int i = 0; i < FACE_EMBEDDING_DIM; i++) {
+    values[i] /= sqrtf(norm);
+  }
+}
+
+// 含公共分量的特征：公共分量与个人分量均为单位向量，不同人之间的相似度约为 SHARED_SIMILARITY
+static void shared_embedding(const float *common, const float *individual, FaceEmbedding *embedding) {
+  float values[FACE_EMBEDDING_DIM];
+  for (int i = 0; i < FACE_EMBEDDING_DIM; i++) {
+    values[i] = sqrtf(SHARED_SIMILARITY) * common[i] + sqrtf(1 - SHARED_SIMILARITY) * individual[i];
+  }
+  quantize(values, embedding);
+}
+
+// 个人分量加扰动（同一人另一次拍摄）
+static void noisy_individual(const float *individual, float *values) {
+  float norm = 0;
+  for (int i = 0; i < FACE_EMBEDDING_DIM; i++) {
+    values[i] = individual[i] * sqrtf(FACE_EMBEDDING_DIM / 3.0f) + random_range(-QUERY_NOISE, QUERY_NOISE);
+    norm += values[i] * values[i];
+  }
+  for (int i = 0; i < FACE_EMBEDDING_DIM; i++) {
+    values[i] /= sqrtf(norm);
+  }
+}
+
+static void noisy_copy(const FaceEmbedding *source, FaceEmbedding *embedding) {
+  float values[FACE_EMBEDDING_DIM];
+  for (int i = 0; i < FACE_EMBEDDING_DIM; i++) {
+    values[i] = source->values[i] / (float)FACE_SCALE * sqrtf(FACE_EMBEDDING_DIM / 3.0f) +
+                random_range(-QUERY_NOISE, QUERY_NOISE);
+  }
+  quantize(values, embedding);
+}
+
+// 内存缓冲区读写（模拟SD卡文件）
+typedef struct {
+  uint8_t *data;
+  size_t size;
+  size_t position;
+} Buffer;
+
+static bool buffer_write(void *context, const void *data, size_t length) {
+  Buffer *buffer = (Buffer *)context;
+  if (buffer->position + length > buffer->size) {
+    return false;
+  }
+  memcpy(buffer->data + buffer->position, data, length);
+  buffer->position += length;
+  return true;
+}
+
+static bool buffer_read(void *context, void *data, size_t length) {
+  Buffer *buffer = (Buffer *)context;
+  if (buffer->position + length > buffer->size) {
+    return false;
+  }
+  memcpy(data, buffer->data + buffer->position, length);
+  buffer->position += length;
+  return true;
+}
+
+static void *alloc_index(FaceIndex *index, uint32_t capacity) {
+  void *memory = aligned_alloc(16, face_index_memory_size(capacity));
+  face_index_init(index, memory, capacity);
+  return memory;
+}
+
+int main() {
+  static FaceEmbedding gallery[MAX_GALLERY];
+  static FaceEmbedding queries[QUERIES];
+  static uint32_t targets[QUERIES];
+  static const int efs[] = {16, FACE_INDEX_EF_SEARCH, 64};
+  static const uint32_t sizes[] = {1000, 2000, 5000, 10000, 20000};
+  int32_t threshold = face_threshold(FACE_DEFAULT_THRESHOLD_PERMILLE);
+  int32_t margin = face_threshold(FACE_DEFAULT_MARGIN_PERMILLE);
+
+  for (int i = 0; i < MAX_GALLERY; i++) {
+    random_embedding(&gallery[i]);
+  }
+
+  FaceIndex index;
+  void *memory = alloc_index(&index, MAX_GALLERY);
+  double defaultRecall = 1;
+
+  printf("%-8s %10s %10s %6s %10s %10s %10s %12s\n", "特征库", "插入(ms)", "精确(us)", "ef", "recall@1",
+         "查询(us)", "比对个数", "字节/特征");
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    uint32_t size = sizes[s];
+
+    // 逐个插入（与后台增量下发相同的路径）
+    face_index_clear(&index);
+    double start = now_seconds();
+    for (uint32_t i = 0; i < size; i++) {
+      face_index_add(&index, i + 1, &gallery[i]);
+    }
+    double insertMs = (now_seconds() - start) * 1000;
+
+    // 查询：已登记特征加扰动，精确查询结果作为参考
+    static FaceMatch exact[QUERIES];
+    double similarity = 0;
+    for (int q = 0; q < QUERIES; q++) {
+      targets[q] = (uint32_t)(random_unit() * size);
+      noisy_copy(&gallery[targets[q]], &queries[q]);
+      similarity += face_dot(&queries[q], &gallery[targets[q]]);
+    }
+    start = now_seconds();
+    for (int q = 0; q < QUERIES; q++) {
+      face_index_exact(&index, &queries[q], threshold, margin, &exact[q]);
+    }
+    double exactUs = (now_seconds() - start) * 1e6 / QUERIES;
+
+    size_t bytes = face_index_memory_size(size);
+    for (size_t e = 0; e < sizeof(efs) / sizeof(efs[0]); e++) {
+      int hits = 0;
+      uint64_t scanned = 0;
+      start = now_seconds();
+      for (int q = 0; q < QUERIES; q++) {
+        FaceMatch match;
+        face_index_search(&index, &queries[q], efs[e], threshold, margin, &match);
+        hits += match.userId == exact[q].userId;
+        scanned += match.scanned;
+      }
+      double searchUs = (now_seconds() - start) * 1e6 / QUERIES;
+      double recall = (double)hits / QUERIES;
+      if (efs[e] == FACE_INDEX_EF_SEARCH && recall < defaultRecall) {
+        defaultRecall = recall;
+      }
+      if (e == 0) {
+        printf("%-8u %10.1f %10.1f", size, insertMs, exactUs);
+      } else {
+        printf("%-8s %10s %10s", "", "", "");
+      }
+      printf(" %6d %10.3f %10.1f %10.0f %12.0f\n", efs[e], recall, searchUs, (double)scanned / QUERIES,
+             (double)bytes / size);
+    }
+    if (s == 0) {
+      printf("（查询与登记特征平均相似度 %.3f）\n", similarity / QUERIES / (FACE_SCALE * FACE_SCALE));
+    }
+  }
+
+  // 保存后载入：查询结果不变
+  size_t imageSize = sizeof(FaceIndexHeader) + face_index_memory_size(index.count);
+  Buffer buffer = {malloc(imageSize), imageSize, 0};
+  if (!face_index_save(&index, buffer_write, &buffer)) {
+    fprintf(stderr, "失败: 保存索引\n");
+    return 1;
+  }
+  size_t savedSize = buffer.position;
+  FaceIndex loaded;
+  void *loadedMemory = alloc_index(&loaded, MAX_GALLERY);
+  FaceIndexHeader header;
+  buffer.size = savedSize;
+  buffer.position = 0;
+  if (!buffer_read(&buffer, &header, sizeof(header)) || !face_index_load(&loaded, &header, buffer_read, &buffer)) {
+    fprintf(stderr, "失败: 载入索引\n");
+    return 1;
+  }
+  for (int q = 0; q < QUERIES; q++) {
+    FaceMatch a, b;
+    face_index_search(&index, &queries[q], FACE_INDEX_EF_SEARCH, threshold, margin, &a);
+    face_index_search(&loaded, &queries[q], FACE_INDEX_EF_SEARCH, threshold, margin, &b);
+    if (a.index != b.index || a.score != b.score || a.scanned != b.scanned) {
+      fprintf(stderr, "失败: 载入后查询结果不同\n");
+      return 1;
+    }
+  }
+  printf("\n索引文件 %zu 字节（%u 个特征），载入后查询结果一致\n", savedSize, loaded.count);
+
+  // 损坏的邻居表应被拒绝
+  ((uint16_t *)(buffer.data + savedSize))[-1] = (uint16_t)(loaded.count + 5);
+  buffer.position = sizeof(header);
+  if (face_index_load(&loaded, &header, buffer_read, &buffer)) {
+    fprintf(stderr, "失败: 未检出无效邻居表\n");
+    return 1;
+  }
+
+  // 删除：被删除用户不再返回，其余用户仍可查到
+  uint32_t removedId = targets[0] + 1;
+  face_index_remove(&index, removedId);
+  FaceMatch match;
+  face_index_search(&index, &queries[0], FACE_INDEX_EF_SEARCH, threshold, margin, &match);
+  if (match.userId == removedId) {
+    fprintf(stderr, "失败: 删除的用户仍被返回\n");
+    return 1;
+  }
+  int found = 0;
+  for (int q = 1; q < QUERIES; q++) {
+    if (targets[q] + 1 != removedId) {
+      face_index_search(&index, &queries[q], FACE_INDEX_EF_SEARCH, threshold, margin, &match);
+      found += match.userId == targets[q] + 1;
+    }
+  }
+  printf("删除用户%u后其余查询命中 %d/%d\n", removedId, found, QUERIES - 1);
+
+  // 误识率：含公共分量的特征库，已登记身份的另一次拍摄与未登记身份分别查询
+  static float individuals[FAR_GALLERY][FACE_EMBEDDING_DIM];
+  float common[FACE_EMBEDDING_DIM];
+  float values[FACE_EMBEDDING_DIM];
+  random_unit_vector(common);
+  face_index_clear(&index);
+  for (uint32_t i = 0; i < FAR_GALLERY; i++) {
+    random_unit_vector(individuals[i]);
+    shared_embedding(common, individuals[i], &gallery[i]);
+    face_index_add(&index, i + 1, &gallery[i]);
+  }
+  int accepted = 0;
+  int misidentified = 0;
+  for (int q = 0; q < QUERIES; q++) {
+    uint32_t target = (uint32_t)(random_unit() * FAR_GALLERY);
+    FaceEmbedding query;
+    noisy_individual(individuals[target], values);
+    shared_embedding(common, values, &query);
+    face_index_search(&index, &query, FACE_INDEX_EF_SEARCH, threshold, margin, &match);
+    if (match.index >= 0) {
+      accepted++;
+      misidentified += match.userId != target + 1;
+    }
+  }
+  int falseAccepts = 0;
+  int indexOnly = 0;
+  for (int q = 0; q < UNENROLLED; q++) {
+    FaceEmbedding query;
+    FaceMatch exactMatch;
+    random_unit_vector(values);
+    shared_embedding(common, values, &query);
+    face_index_search(&index, &query, FACE_INDEX_EF_SEARCH, threshold, margin, &match);
+    face_index_exact(&index, &query, threshold, margin, &exactMatch);
+    falseAccepts += match.index >= 0;
+    indexOnly += match.index >= 0 && exactMatch.index < 0;
+  }
+  double farPercent = 100.0 * falseAccepts / UNENROLLED;
+  double misidentifiedPercent = 100.0 * misidentified / QUERIES;
+  printf("\n误识率（阈值%d‰、领先%d‰，%u 个特征，ef=%d）: 已登记接受 %.1f%%，认错 %.2f%%，"
+         "未登记误识 %.2f%%（其中精确查询会拒绝的 %d 次）\n",
+         FACE_DEFAULT_THRESHOLD_PERMILLE, FACE_DEFAULT_MARGIN_PERMILLE, FAR_GALLERY, FACE_INDEX_EF_SEARCH,
+         100.0 * accepted / QUERIES, misidentifiedPercent, farPercent, indexOnly);
+
+  free(buffer.data);
+  free(loadedMemory);
+  free(memory);
+
+  if (defaultRecall < MIN_RECALL) {
+    fprintf(stderr, "失败: ef=%d 时 recall@1 %.3f 低于 %.2f\n", FACE_INDEX_EF_SEARCH, defaultRecall, MIN_RECALL);
+    return 1;
+  }
+  if (farPercent > MAX_FAR_PERCENT || misidentifiedPercent > MAX_FAR_PERCENT) {
+    fprintf(stderr, "失败: 误识率 %.2f%% 或认错率 %.2f%% 超过 %d%%\n", farPercent, misidentifiedPercent,
+            MAX_FAR_PERCENT);
+    return 1;
+  }
+  return 0;
+}
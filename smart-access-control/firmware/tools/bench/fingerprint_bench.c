@@ -0,0 +1,238 @@
+/*
+ * 指纹识别延迟主机仿真
+ *
+ * 用仿真指纹模块（按串口协议收发数据包，按字节计算线路时间）对比按压到出结果的延迟：
+ *   - 原实现：SoftwareSerial 57600，阻塞调用，fingerprint_check 和 fingerprint_identify 各采集一次图像
+ *   - 流水线轮询：硬件UART 115200，fingerprint_protocol.c 流水线只采集一次，空闲时每100ms发起采集
+ *   - 流水线中断：触摸中断唤醒任务后才采集，空闲时不访问模块
+ * 等待应答期间任务每2ms轮询。模块处理时间取数据手册典型值，可按实测修改。
+ * 另按每小时60次按压统计两种模式每小时发出的采集指令数。
+ *
+ * 编译运行（firmware 目录下）:
+ *   cc -O2 -Isrc tools/bench/fingerprint_bench.c src/drivers/fingerprint_protocol.c -o fingerprint_bench && ./fingerprint_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "drivers/fingerprint_protocol.h"
+
+// 模块处理时间(us)
+#define SENSOR_GEN_IMAGE_US    60000
+#define SENSOR_IMAGE_TO_TZ_US  45000
+#define SENSOR_SEARCH_US       35000
+
+// 任务轮询间隔(us)
+#define TASK_PERIOD_US  100000
+#define TASK_BUSY_US    2000
+
+// 中断到任务被唤醒的时间(us)
+#define IRQ_WAKEUP_US  50
+
+#define TOUCHES  20000
+#define TEMPLATE_ID  7
+
+// 每小时统计：按压间隔(s)
+#define HOUR_TOUCH_INTERVAL_S  60
+
+// 仿真模块
+typedef struct {
+  uint32_t baud;
+  double fingerAt;                 // 手指按下时间(us)
+  FingerprintParser parser;
+  uint8_t response[64];
+  size_t responseLength;
+  double responseReadyAt;          // 应答全部到达的时间(us)
+} SimSensor;
+
+static double wire_us(const SimSensor *sensor, size_t bytes) {
+  return bytes * 10.0 * 1e6 / sensor->baud;
+}
+
+/**
+ * 模块接收一条完整指令，计算应答及其到达时间
+ */
+static void sensor_command(SimSensor *sensor, const uint8_t *data, size_t length, double now) {
+  double received = now + wire_us(sensor, length);
+  for (size_t i = 0; i < length; i++) {
+    if (fingerprint_parser_feed(&sensor->parser, data[i]) != 1) {
+      continue;
+    }
+
+    const FingerprintPacket *command = &sensor->parser.packet;
+    uint8_t content[8] = {FINGERPRINT_ACK_OK};
+    uint16_t contentLength = 1;
+    double processing = 0;
+
+    switch (command->content[0]) {
+      case FINGERPRINT_CMD_GEN_IMAGE:
+        processing = SENSOR_GEN_IMAGE_US;
+        if (now < sensor->fingerAt) {
+          content[0] = FINGERPRINT_ACK_NO_FINGER;
+        }
+        break;
+      case FINGERPRINT_CMD_IMAGE_TO_TZ:
+        processing = SENSOR_IMAGE_TO_TZ_US;
+        break;
+      case FINGERPRINT_CMD_SEARCH:
+      case FINGERPRINT_CMD_HIGH_SPEED_SEARCH:
+        processing = SENSOR_SEARCH_US;
+        content[1] = 0;
+        content[2] = TEMPLATE_ID;
+        content[3] = 0;
+        content[4] = 100;
+        contentLength = 5;
+        break;
+    }
+
+    sensor->responseLength = fingerprint_packet_encode(FINGERPRINT_PID_ACK, content, contentLength,
+                                                       sensor->response, sizeof(sensor->response));
+    sensor->responseReadyAt = received + processing + wire_us(sensor, sensor->responseLength);
+  }
+}
+
+/**
+ * 原实现的一次阻塞指令收发，返回确认码
+ */
+static uint8_t blocking_command(SimSensor *sensor, const uint8_t *content, uint16_t length, double *now) {
+  uint8_t packet[32];
+  size_t packetLength = fingerprint_packet_encode(FINGERPRINT_PID_COMMAND, content, length, packet, sizeof(packet));
+  sensor_command(sensor, packet, packetLength, *now);
+  *now = sensor->responseReadyAt;
+  return sensor->response[9];
+}
+
+/**
+ * 原实现：每周期 getImage，有指纹时 fingerprint_identify 再 getImage → image2Tz → fingerFastSearch
+ */
+static double run_blocking(double touchAt, double start) {
+  SimSensor sensor = {57600, touchAt};
+  fingerprint_parser_reset(&sensor.parser);
+
+  const uint8_t genImage[] = {FINGERPRINT_CMD_GEN_IMAGE};
+  const uint8_t imageToTz[] = {FINGERPRINT_CMD_IMAGE_TO_TZ, 1};
+  const uint8_t search[] = {FINGERPRINT_CMD_HIGH_SPEED_SEARCH, 1, 0, 0, 0x00, 0xA3};
+
+  double now = start;
+  for (;;) {
+    if (blocking_command(&sensor, genImage, sizeof(genImage), &now) == FINGERPRINT_ACK_OK) {
+      blocking_command(&sensor, genImage, sizeof(genImage), &now);
+      blocking_command(&sensor, imageToTz, sizeof(imageToTz), &now);
+      blocking_command(&sensor, search, sizeof(search), &now);
+      return now - touchAt;
+    }
+    now += TASK_PERIOD_US;
+  }
+}
+
+/**
+ * 现实现：流水线 + 忙时2ms轮询
+ * @param irq 是否中断模式（按压后才发起采集）
+ * @param until 大于0时运行到该时间并按固定间隔重复按压，返回采集指令数
+ */
+static double run_pipeline(double touchAt, double start, bool irq, double until) {
+  SimSensor sensor = {FINGERPRINT_BAUD_UNIT * FINGERPRINT_BAUD_MAX_N, touchAt};
+  fingerprint_parser_reset(&sensor.parser);
+
+  FingerprintPipeline pipeline;
+  fingerprint_pipeline_init(&pipeline, 300);
+
+  double now = start;
+  double captures = 0;
+  double handled = -1;             // 已处理的按压时间
+  bool armed = false;
+  for (;;) {
+    if (until > 0 && now >= until) {
+      return captures;
+    }
+    if (irq && !armed && sensor.fingerAt <= now && sensor.fingerAt != handled) {
+      // 触摸中断产生的采集任务
+      armed = true;
+      handled = sensor.fingerAt;
+      pipeline.awaitLift = false;
+    }
+
+    uint32_t ms = (uint32_t)(now / 1000);
+    bool answered = fingerprint_pipeline_busy(&pipeline);
+    FingerprintEvent event = fingerprint_pipeline_check_timeout(&pipeline, ms);
+
+    if (sensor.responseLength && sensor.responseReadyAt <= now) {
+      size_t length = sensor.responseLength;
+      sensor.responseLength = 0;
+      event = fingerprint_pipeline_receive(&pipeline, sensor.response, length, ms);
+    }
+    bool capture = irq ? armed : !answered;
+    if (event == FINGERPRINT_EVENT_NONE && !fingerprint_pipeline_busy(&pipeline) && capture &&
+        fingerprint_pipeline_start(&pipeline, ms)) {
+      captures++;
+    }
+    if (pipeline.txLength) {
+      sensor_command(&sensor, pipeline.tx, pipeline.txLength, now);
+      pipeline.txLength = 0;
+    }
+
+    if (event == FINGERPRINT_EVENT_MATCH) {
+      if (pipeline.resultId != TEMPLATE_ID) {
+        fprintf(stderr, "识别结果错误: %d\n", pipeline.resultId);
+        exit(1);
+      }
+      if (until <= 0) {
+        return now - touchAt;
+      }
+      // 下一次按压
+      armed = false;
+      sensor.fingerAt += HOUR_TOUCH_INTERVAL_S * 1e6;
+    }
+
+    // 任务等待：忙时2ms，空闲时100ms，中断模式下按压会提前唤醒
+    double next = now + (fingerprint_pipeline_busy(&pipeline) ? TASK_BUSY_US : TASK_PERIOD_US);
+    if (irq && sensor.fingerAt > now && sensor.fingerAt + IRQ_WAKEUP_US < next) {
+      next = sensor.fingerAt + IRQ_WAKEUP_US;
+    }
+    now = next;
+  }
+}
+
+static int compare(const void *a, const void *b) {
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+static void report(const char *name, double *samples) {
+  qsort(samples, TOUCHES, sizeof(double), compare);
+  double sum = 0;
+  for (int i = 0; i < TOUCHES; i++) {
+    sum += samples[i];
+  }
+  printf("%-34s 平均 %6.1f  p50 %6.1f  p99 %6.1f  最大 %6.1f ms\n", name, sum / TOUCHES / 1000,
+         samples[TOUCHES / 2] / 1000, samples[TOUCHES * 99 / 100] / 1000, samples[TOUCHES - 1] / 1000);
+}
+
+int main() {
+  static double before[TOUCHES];
+  static double polled[TOUCHES];
+  static double interrupted[TOUCHES];
+
+  srand(1);
+  for (int i = 0; i < TOUCHES; i++) {
+    // 按压时刻相对轮询周期随机
+    double touchAt = 1e6 + (double)rand() / RAND_MAX * 500000;
+    before[i] = run_blocking(touchAt, 0);
+    polled[i] = run_pipeline(touchAt, 0, false, 0);
+    interrupted[i] = run_pipeline(touchAt, 0, true, 0);
+  }
+
+  printf("按压次数=%d，模块处理: 采集%dms 生成特征%dms 搜索%dms\n", TOUCHES,
+         SENSOR_GEN_IMAGE_US / 1000, SENSOR_IMAGE_TO_TZ_US / 1000, SENSOR_SEARCH_US / 1000);
+  report("原实现（57600，两次采集，阻塞）", before);
+  report("流水线轮询（115200，单次采集）", polled);
+  report("流水线中断（115200，单次采集）", interrupted);
+
+  double hour = 3600 * 1e6;
+  printf("每小时采集指令（每%d秒按压一次）: 轮询 %.0f, 中断 %.0f\n", HOUR_TOUCH_INTERVAL_S,
+         run_pipeline(HOUR_TOUCH_INTERVAL_S * 1e6, 0, false, hour),
+         run_pipeline(HOUR_TOUCH_INTERVAL_S * 1e6, 0, true, hour));
+  return 0;
+}
@@ -0,0 +1,290 @@
+/*
+ * 指纹录入与模板镜像主机仿真
+ *
+ * 用仿真指纹模块（模板库、两个特征缓冲区，按串口协议收发数据包，按字节计算线路时间）驱动
+ * fingerprint_protocol.c 的管理作业，检查：
+ *   - 录入：按压 → 抬起 → 再按压，两次手指不一致时提示重录，模板存储后读出
+ *   - 备份：逐个读出模板（空模板号跳过）
+ *   - 恢复：将备份写入新模块，逐字节比对
+ * 并统计更换模块后批量恢复的耗时。任务循环与驱动一致：等待应答时每2ms，等待按压时每100ms。
+ * 模块处理时间取数据手册典型值，可按实测修改。
+ *
+ * 编译运行（firmware 目录下）:
+ *   cc -O2 -Isrc tools/bench/fingerprint_enroll_bench.c src/drivers/fingerprint_protocol.c -o fingerprint_enroll_bench && ./fingerprint_enroll_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "drivers/fingerprint_protocol.h"
+
+// 模块处理时间(us)
+#define SENSOR_GEN_IMAGE_US    60000
+#define SENSOR_IMAGE_TO_TZ_US  45000
+#define SENSOR_REG_MODEL_US    40000
+#define SENSOR_STORE_US        30000
+#define SENSOR_LOAD_CHAR_US    20000
+
+// 任务轮询间隔(us)
+#define TASK_PERIOD_US  100000
+#define TASK_BUSY_US    2000
+
+#define SENSOR_CAPACITY      300
+#define SENSOR_TEMPLATE_SIZE 512
+#define SENSOR_PACKET_SIZE   128
+#define BULK_TEMPLATES       200
+
+// 仿真模块
+typedef struct {
+  uint32_t baud;
+  FingerprintParser parser;
+  uint8_t library[SENSOR_CAPACITY][SENSOR_TEMPLATE_SIZE];
+  bool used[SENSOR_CAPACITY];
+  uint8_t buffer[2][SENSOR_TEMPLATE_SIZE];  // 特征缓冲区1、2
+  int bufferFinger[2];                      // 缓冲区特征来自哪个手指（合并时比较）
+  int imageFinger;                          // 最近一次采集的手指，0表示无
+  int downloadOffset;                       // 大于等于0时正在接收下载数据
+  const int *script;                        // 按压脚本：每100ms一个值，0表示无手指
+  int scriptLength;
+  uint8_t response[4096];
+  size_t responseLength;
+  double responseReadyAt;
+  uint32_t commands;
+} SimSensor;
+
+static double wire_us(const SimSensor *sensor, size_t bytes) {
+  return bytes * 10.0 * 1e6 / sensor->baud;
+}
+
+static void sensor_init(SimSensor *sensor, uint32_t baud) {
+  memset(sensor, 0, sizeof(SimSensor));
+  sensor->baud = baud;
+  sensor->downloadOffset = -1;
+  fingerprint_parser_reset(&sensor->parser);
+}
+
+static int sensor_finger(const SimSensor *sensor, double now) {
+  int index = (int)(now / 100000);
+  if (!sensor->script || index >= sensor->scriptLength) {
+    return 0;
+  }
+  return sensor->script[index];
+}
+
+// 手指特征：同一手指每次采集的特征相同
+static void sensor_feature(int finger, uint8_t *out) {
+  uint32_t state = 2166136261u ^ (uint32_t)finger;
+  for (int i = 0; i < SENSOR_TEMPLATE_SIZE; i++) {
+    state = state * 1664525u + 1013904223u;
+    out[i] = state >> 24;
+  }
+}
+
+static void sensor_reply(SimSensor *sensor, uint8_t pid, const uint8_t *content, uint16_t length) {
+  sensor->responseLength += fingerprint_packet_encode(pid, content, length, sensor->response + sensor->responseLength,
+                                                      sizeof(sensor->response) - sensor->responseLength);
+}
+
+/**
+ * 模块接收数据，计算应答及其到达时间
+ */
+static void sensor_receive(SimSensor *sensor, const uint8_t *data, size_t length, double now) {
+  double received = now + wire_us(sensor, length);
+  for (size_t i = 0; i < length; i++) {
+    if (fingerprint_parser_feed(&sensor->parser, data[i]) != 1) {
+      continue;
+    }
+    const FingerprintPacket *packet = &sensor->parser.packet;
+
+    // 下载数据包
+    if (sensor->downloadOffset >= 0 && (packet->pid == FINGERPRINT_PID_DATA || packet->pid == FINGERPRINT_PID_END)) {
+      memcpy(sensor->buffer[0] + sensor->downloadOffset, packet->content, packet->length);
+      sensor->downloadOffset += packet->length;
+      if (packet->pid == FINGERPRINT_PID_END) {
+        sensor->downloadOffset = -1;
+      }
+      continue;
+    }
+
+    sensor->commands++;
+    sensor->responseLength = 0;
+    uint8_t code = FINGERPRINT_ACK_OK;
+    double processing = 0;
+    uint16_t page = packet->length >= 4 ? (packet->content[2] << 8) | packet->content[3] : 0;
+    int slot = packet->length >= 2 ? packet->content[1] - 1 : 0;
+
+    switch (packet->content[0]) {
+      case FINGERPRINT_CMD_GEN_IMAGE:
+        processing = SENSOR_GEN_IMAGE_US;
+        sensor->imageFinger = sensor_finger(sensor, now);
+        code = sensor->imageFinger ? FINGERPRINT_ACK_OK : FINGERPRINT_ACK_NO_FINGER;
+        break;
+      case FINGERPRINT_CMD_IMAGE_TO_TZ:
+        processing = SENSOR_IMAGE_TO_TZ_US;
+        sensor_feature(sensor->imageFinger, sensor->buffer[slot]);
+        sensor->bufferFinger[slot] = sensor->imageFinger;
+        break;
+      case FINGERPRINT_CMD_REG_MODEL:
+        processing = SENSOR_REG_MODEL_US;
+        if (sensor->bufferFinger[0] != sensor->bufferFinger[1]) {
+          code = FINGERPRINT_ACK_MISMATCH;
+        } else {
+          memcpy(sensor->buffer[1], sensor->buffer[0], SENSOR_TEMPLATE_SIZE);
+        }
+        break;
+      case FINGERPRINT_CMD_STORE:
+        processing = SENSOR_STORE_US;
+        memcpy(sensor->library[page], sensor->buffer[0], SENSOR_TEMPLATE_SIZE);
+        sensor->used[page] = true;
+        break;
+      case FINGERPRINT_CMD_LOAD_CHAR:
+        processing = SENSOR_LOAD_CHAR_US;
+        if (!sensor->used[page]) {
+          code = FINGERPRINT_ACK_EMPTY_PAGE;
+        } else {
+          memcpy(sensor->buffer[0], sensor->library[page], SENSOR_TEMPLATE_SIZE);
+        }
+        break;
+      case FINGERPRINT_CMD_UP_CHAR:
+        sensor_reply(sensor, FINGERPRINT_PID_ACK, &code, 1);
+        for (int sent = 0; sent < SENSOR_TEMPLATE_SIZE; sent += SENSOR_PACKET_SIZE) {
+          uint8_t pid = sent + SENSOR_PACKET_SIZE >= SENSOR_TEMPLATE_SIZE ? FINGERPRINT_PID_END : FINGERPRINT_PID_DATA;
+          sensor_reply(sensor, pid, sensor->buffer[slot] + sent, SENSOR_PACKET_SIZE);
+        }
+        sensor->responseReadyAt = received + wire_us(sensor, sensor->responseLength);
+        continue;
+      case FINGERPRINT_CMD_DOWN_CHAR:
+        sensor->downloadOffset = 0;
+        break;
+    }
+
+    sensor_reply(sensor, FINGERPRINT_PID_ACK, &code, 1);
+    sensor->responseReadyAt = received + processing + wire_us(sensor, sensor->responseLength);
+  }
+}
+
+/**
+ * 按驱动的任务循环运行作业直到结束
+ * @return 结束时间(us)
+ */
+static double run_job(SimSensor *sensor, FingerprintJob *job, double now, int *prompts) {
+  FingerprintPrompt prompt = FINGERPRINT_PROMPT_NONE;
+  for (;;) {
+    uint32_t ms = (uint32_t)(now / 1000);
+    if (sensor->responseLength && sensor->responseReadyAt <= now) {
+      size_t length = sensor->responseLength;
+      sensor->responseLength = 0;
+      fingerprint_job_receive(job, sensor->response, length, ms);
+    }
+    fingerprint_job_poll(job, ms);
+    if (job->txLength) {
+      sensor_receive(sensor, job->tx, job->txLength, now);
+      job->txLength = 0;
+    }
+
+    if (prompts && job->prompt != prompt && job->prompt != FINGERPRINT_PROMPT_NONE) {
+      prompt = job->prompt;
+      prompts[prompt]++;
+    }
+    if (!fingerprint_job_running(job)) {
+      return now;
+    }
+
+    bool busy = job->waiting || (int32_t)(ms - job->nextAt) >= 0;
+    now += busy ? TASK_BUSY_US : TASK_PERIOD_US;
+  }
+}
+
+static void check(bool condition, const char *message) {
+  if (!condition) {
+    fprintf(stderr, "失败: %s\n", message);
+    exit(1);
+  }
+}
+
+int main() {
+  static SimSensor sensor;
+  static SimSensor replacement;
+  static FingerprintJob job;
+  static uint8_t backup[SENSOR_CAPACITY][FINGERPRINT_TEMPLATE_MAX];
+  static uint16_t backupLength[SENSOR_CAPACITY];
+  uint32_t baud = FINGERPRINT_BAUD_UNIT * FINGERPRINT_BAUD_MAX_N;
+
+  // 录入：手指1按下1s、抬起、误用手指2按下（合并失败）、抬起后手指1按两次
+  static const int script[] = {
+    0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 0, 0,
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 0,
+  };
+  sensor_init(&sensor, baud);
+  sensor.script = script;
+  sensor.scriptLength = sizeof(script) / sizeof(script[0]);
+
+  int prompts[FINGERPRINT_PROMPT_RETRY + 1] = {0};
+  fingerprint_job_enroll(&job, 5, 0);
+  double end = run_job(&sensor, &job, 0, prompts);
+  check(job.state == FINGERPRINT_JOB_DONE, "录入未完成");
+  check(prompts[FINGERPRINT_PROMPT_RETRY] == 1, "手指不一致时未提示重录");
+  check(sensor.used[5] && job.templateLength == SENSOR_TEMPLATE_SIZE &&
+        memcmp(job.templateData, sensor.library[5], SENSOR_TEMPLATE_SIZE) == 0, "录入后读出的模板不一致");
+  printf("录入（含一次重录）: %.1f s，指令 %u 条，提示: 放置%d 抬起%d 再次放置%d 重录%d\n", end / 1e6,
+         sensor.commands, prompts[FINGERPRINT_PROMPT_PLACE], prompts[FINGERPRINT_PROMPT_LIFT],
+         prompts[FINGERPRINT_PROMPT_PLACE_AGAIN], prompts[FINGERPRINT_PROMPT_RETRY]);
+
+  // 无手指时录入超时
+  sensor.script = NULL;
+  fingerprint_job_enroll(&job, 6, 0);
+  run_job(&sensor, &job, 0, NULL);
+  check(job.state == FINGERPRINT_JOB_FAILED && job.error == FINGERPRINT_ACK_TIMEOUT && !sensor.used[6], "录入超时处理错误");
+
+  // 模板库：每隔一个模板号录入一个，共BULK_TEMPLATES个
+  for (int i = 0; i < BULK_TEMPLATES; i++) {
+    int page = i * SENSOR_CAPACITY / BULK_TEMPLATES;
+    sensor_feature(100 + i, sensor.library[page]);
+    sensor.used[page] = true;
+  }
+  sensor.used[5] = false;
+
+  // 备份：读出全部模板号
+  double now = 0;
+  int stored = 0;
+  for (uint16_t page = 0; page < SENSOR_CAPACITY; page++) {
+    fingerprint_job_upload(&job, page, (uint32_t)(now / 1000));
+    now = run_job(&sensor, &job, now, NULL) + TASK_BUSY_US;
+    if (job.state == FINGERPRINT_JOB_DONE) {
+      memcpy(backup[page], job.templateData, job.templateLength);
+      backupLength[page] = job.templateLength;
+      stored++;
+    } else {
+      check(job.error == FINGERPRINT_ACK_EMPTY_PAGE && !sensor.used[page], "读出失败");
+      backupLength[page] = 0;
+    }
+  }
+  check(stored == BULK_TEMPLATES, "备份数量错误");
+  double backupTime = now;
+
+  // 恢复到新模块
+  sensor_init(&replacement, baud);
+  now = 0;
+  for (uint16_t page = 0; page < SENSOR_CAPACITY; page++) {
+    if (!backupLength[page]) {
+      continue;
+    }
+    check(fingerprint_job_download(&job, page, backup[page], backupLength[page], SENSOR_PACKET_SIZE,
+                                   (uint32_t)(now / 1000)), "写入作业无法开始");
+    now = run_job(&replacement, &job, now, NULL) + TASK_BUSY_US;
+    check(job.state == FINGERPRINT_JOB_DONE, "写入失败");
+  }
+  for (int page = 0; page < SENSOR_CAPACITY; page++) {
+    check(replacement.used[page] == sensor.used[page] &&
+          (!sensor.used[page] || memcmp(replacement.library[page], sensor.library[page], SENSOR_TEMPLATE_SIZE) == 0),
+          "恢复后模板不一致");
+  }
+
+  printf("模板 %d 个（%d字节，数据包%d字节），容量 %d，波特率 %u\n", BULK_TEMPLATES, SENSOR_TEMPLATE_SIZE,
+         SENSOR_PACKET_SIZE, SENSOR_CAPACITY, baud);
+  printf("备份（逐个模板号读出）: %.1f s\n", backupTime / 1e6);
+  printf("恢复到新模块: %.1f s（每个 %.0f ms），重新录入约 %.0f min（按上面单次录入时间）\n", now / 1e6,
+         now / 1000 / BULK_TEMPLATES, BULK_TEMPLATES * end / 1e6 / 60);
+  return 0;
+}
@@ -0,0 +1,213 @@
+/*
+ * 事件录像帧环形缓冲区主机测试
+ *
+ * 模拟摄像头以4帧/秒持续出帧、人脸识别每500ms引用最新一帧，
+ * 按场景触发事件（拒绝访问、连续失败后锁定、防拆）并模拟后台上传耗时：
+ *   - 平常：约每分钟一次事件，上传1.5秒
+ *   - 突发：10秒内10次事件（连续拒绝+锁定）
+ *   - 离线：MQTT断开60秒，事件无法上传
+ * 统计进入缓冲区/丢弃的帧数、冻结/丢弃的事件数、帧槽占用峰值（内存上限），
+ * 并检查：同时持有的驱动帧缓冲区不超过帧槽数、事件帧按时间连续且跨越触发时刻、
+ * 全部事件上传后只剩环形窗口中的帧、平常场景不丢帧。
+ *
+ * 编译运行（firmware 目录下）:
+ *   cc -O2 -Isrc tools/bench/frame_ring_bench.c src/modules/frame_ring.c -o frame_ring_bench
+ *   ./frame_ring_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "modules/frame_ring.h"
+
+// 帧槽数（摄像头驱动帧缓冲区数减2）
+#define SLOTS  24
+
+// QVGA JPEG驱动帧缓冲区大小（宽×高/5）
+#define FB_SIZE  (320 * 240 / 5)
+
+#define FRAME_INTERVAL_MS  250
+#define FACE_INTERVAL_MS   500
+
+typedef struct {
+  uint32_t sequence;
+  uint32_t timestamp;
+} FakeFrame;
+
+static int framesOutstanding = 0;
+
+static void release_frame(void *frame) {
+  free(frame);
+  framesOutstanding--;
+}
+
+static uint32_t randomState = 7;
+
+static uint32_t random_next() {
+  randomState = randomState * 1664525u + 1013904223u;
+  return randomState >> 8;
+}
+
+typedef struct {
+  const char *name;
+  uint32_t durationMs;
+  uint32_t uploadMs;          // 每个事件的上传耗时
+  uint32_t offlineFrom;       // 离线区间
+  uint32_t offlineTo;
+  const uint32_t *triggers;   // 触发时刻(ms)
+  int triggerCount;
+  int strict;                 // 是否要求不丢帧、不丢事件
+} Scenario;
+
+/**
+ * 检查事件帧：时间递增、触发前的帧不晚于触发时刻、之后的帧晚于触发时刻
+ */
+static int check_event(const FrameRing *ring, const FrameEvent *event) {
+  uint32_t last = 0;
+  for (int i = 0; i < event->count; i++) {
+    const FrameSlot *slot = &ring->slots[event->slots[i]];
+    const FakeFrame *frame = (const FakeFrame *)slot->frame;
+    if (!frame || frame->sequence != slot->sequence || (i > 0 && slot->sequence <= last)) {
+      return 0;
+    }
+    if ((i < event->preCount) != (slot->timestamp <= event->timestamp)) {
+      return 0;
+    }
+    last = slot->sequence;
+  }
+  return event->preCount <= FRAME_RING_PRE_FRAMES && event->count - event->preCount <= FRAME_RING_POST_FRAMES;
+}
+
+static int run(const Scenario *scenario) {
+  FrameRing ring;
+  frame_ring_init(&ring, SLOTS, release_frame);
+  framesOutstanding = 0;
+
+  int uploading = FRAME_RING_NONE;
+  uint32_t uploadDone = 0;
+  int uploaded = 0;
+  int incomplete = 0;
+  int next = 0;
+  uint32_t sequence = 0;
+
+  for (uint32_t now = 0; now < scenario->durationMs || uploading != FRAME_RING_NONE; now += 50) {
+    bool running = now < scenario->durationMs;
+    if (running && now % FRAME_INTERVAL_MS == 0) {
+      FakeFrame *frame = (FakeFrame *)malloc(sizeof(FakeFrame));
+      frame->sequence = ++sequence;
+      frame->timestamp = now;
+      framesOutstanding++;
+      // 驱动帧序号与缓冲区序号一致（丢弃的帧不占序号）
+      if (!frame_ring_push(&ring, frame, now)) {
+        sequence--;
+        release_frame(frame);
+      }
+    }
+
+    // 识别读取者：引用最新一帧，处理一帧的时间后释放
+    if (running && now % FACE_INTERVAL_MS == 0) {
+      int slot = frame_ring_acquire_latest(&ring);
+      frame_ring_release(&ring, slot);
+    }
+
+    while (running && next < scenario->triggerCount && scenario->triggers[next] <= now) {
+      frame_ring_freeze(&ring, next % 3, now);
+      next++;
+    }
+
+    bool online = now < scenario->offlineFrom || now >= scenario->offlineTo;
+    if (uploading != FRAME_RING_NONE && now >= uploadDone) {
+      frame_ring_finish(&ring, uploading);
+      uploading = FRAME_RING_NONE;
+    }
+    if (uploading == FRAME_RING_NONE && online) {
+      uploading = frame_ring_take_ready(&ring, now);
+      if (uploading != FRAME_RING_NONE) {
+        const FrameEvent *event = &ring.events[uploading];
+        if (!check_event(&ring, event)) {
+          printf("%s: 事件%u帧顺序错误\n", scenario->name, event->id);
+          return 0;
+        }
+        incomplete += event->count < FRAME_RING_EVENT_FRAMES;
+        uploaded++;
+        uploadDone = now + scenario->uploadMs;
+      }
+    }
+
+    if (framesOutstanding > SLOTS) {
+      printf("%s: 持有帧缓冲区 %d 超过帧槽数\n", scenario->name, framesOutstanding);
+      return 0;
+    }
+  }
+
+  // 剩余事件在停止出帧后按超时结束
+  for (int event = frame_ring_take_ready(&ring, scenario->durationMs + FRAME_RING_POST_TIMEOUT_MS);
+       event != FRAME_RING_NONE; event = frame_ring_take_ready(&ring, scenario->durationMs + FRAME_RING_POST_TIMEOUT_MS)) {
+    frame_ring_finish(&ring, event);
+    uploaded++;
+  }
+
+  const FrameRingStats *stats = &ring.stats;
+  printf("%-6s %8u %8u %7.2f%% %6u %8u %8d %8d %8u %10u\n", scenario->name, stats->captured, stats->dropped,
+         100.0 * stats->dropped / (stats->captured + stats->dropped), stats->events, stats->eventsDropped, uploaded,
+         incomplete, stats->slotsPeak, stats->slotsPeak * FB_SIZE);
+
+  if (framesOutstanding != ring.liveCount || framesOutstanding > FRAME_RING_PRE_FRAMES ||
+      stats->slotsInUse != framesOutstanding) {
+    printf("%s: 上传结束后仍持有 %d 帧（窗口 %u 帧）\n", scenario->name, framesOutstanding, ring.liveCount);
+    return 0;
+  }
+  if (scenario->strict && (stats->dropped > 0 || stats->eventsDropped > 0 || incomplete > 0)) {
+    printf("%s: 不应丢帧或丢弃事件\n", scenario->name);
+    return 0;
+  }
+  if ((uint32_t)uploaded != stats->events) {
+    printf("%s: 冻结 %u 个事件，上传 %d 个\n", scenario->name, stats->events, uploaded);
+    return 0;
+  }
+
+  // 清空窗口，全部帧缓冲区归还
+  while (ring.liveCount > 0) {
+    int oldest = FRAME_RING_NONE;
+    for (int i = 0; i < ring.slotCount; i++) {
+      if (ring.slots[i].frame && ring.slots[i].live) {
+        oldest = i;
+      }
+    }
+    ring.slots[oldest].live = false;
+    ring.liveCount--;
+    frame_ring_release(&ring, oldest);
+  }
+  if (framesOutstanding != 0) {
+    printf("%s: 泄漏 %d 帧\n", scenario->name, framesOutstanding);
+    return 0;
+  }
+  return 1;
+}
+
+int main() {
+  static uint32_t normal[60];
+  for (int i = 0; i < 60; i++) {
+    normal[i] = i * 60000 + 10000 + random_next() % 40000;
+  }
+  static const uint32_t burst[] = {20000, 21000, 22000, 23000, 24000, 24100, 26000, 27000, 28000, 29000};
+  static const uint32_t offline[] = {10000, 30000, 50000, 70000, 90000, 110000};
+
+  Scenario scenarios[] = {
+    {"平常", 3600000, 1500, 0, 0, normal, 60, 1},
+    {"突发", 60000, 1500, 0, 0, burst, 10, 0},
+    {"离线", 150000, 1500, 20000, 80000, offline, 6, 0},
+  };
+
+  printf("帧槽 %d，窗口 %d 帧 + 事件后 %d 帧，每帧 %d 字节\n", SLOTS, FRAME_RING_PRE_FRAMES, FRAME_RING_POST_FRAMES,
+         FB_SIZE);
+  printf("%-6s %8s %8s %8s %6s %8s %8s %8s %8s %10s\n", "场景", "接收帧", "丢弃帧", "丢帧率", "事件", "丢弃事件",
+         "上传事件", "帧不全", "槽峰值", "内存峰值");
+
+  int ok = 1;
+  for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+    ok &= run(&scenarios[i]);
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,238 @@
+/*
+ * 键盘扫描消抖主机仿真
+ *
+ * 按1ms步长仿真矩阵键盘：按下和抬起时触点在随机时长（0~抖动上限）内随机通断。
+ * 空闲时不扫描，列电平出现下降沿（任一按键接通）时启动5ms周期扫描，keypad_matrix.c 消抖后产生事件，
+ * 全部按键抬起并稳定后停止扫描，与 keypad_driver.c 的中断 + 定时器流程一致。
+ * 场景：正常按键、长按、快速连按、两键重叠（滚键）、抖动上限超过消抖时间的劣质键盘。
+ * 统计每次按键的事件数（应为恰好一次按下、一次抬起）、出事件延迟、扫描次数，
+ * 并与原实现（访问控制任务每100ms调用一次阻塞扫描：按下后 delay(50) 再等待抬起）比较任务被阻塞的时间。
+ *
+ * 编译运行（firmware 目录下）:
+ *   cc -O2 -Isrc tools/bench/keypad_bench.c src/drivers/keypad_matrix.c -o keypad_bench && ./keypad_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "drivers/keypad_matrix.h"
+
+// 原实现：访问控制任务周期和按下后的消抖延时
+#define LEGACY_TASK_PERIOD_MS  100
+#define LEGACY_DEBOUNCE_MS     50
+
+// 检查项：按下到出事件的延迟上限（抖动 + 消抖 + 一个扫描周期）
+#define MAX_PRESS_LATENCY_MS(bounce)  ((bounce) + (KEYPAD_DEBOUNCE_SCANS + 1) * KEYPAD_SCAN_INTERVAL_MS)
+
+#define MAX_PRESSES  4096
+
+static const char keymap[KEYPAD_KEYS] = {
+  '1', '2', '3', 'A',
+  '4', '5', '6', 'B',
+  '7', '8', '9', 'C',
+  '*', '0', '#', 'D'
+};
+
+static uint32_t randomState = 5;
+
+static uint32_t random_next() {
+  randomState = randomState * 1664525u + 1013904223u;
+  return randomState >> 8;
+}
+
+static int random_range(int low, int high) {
+  return low + (int)(random_next() % (uint32_t)(high - low + 1));
+}
+
+// 一次物理按键
+typedef struct {
+  int key;              // 位序号
+  uint32_t down;        // 按下时间(ms)
+  uint32_t up;          // 抬起时间(ms)
+  int bounceDown;       // 按下抖动时长(ms)
+  int bounceUp;         // 抬起抖动时长(ms)
+  int pressEvents;
+  int releaseEvents;
+  uint32_t pressAt;     // 按下事件产生时间
+  uint32_t releaseAt;   // 抬起事件产生时间
+} Press;
+
+typedef struct {
+  const char *name;
+  int presses;
+  int holdMin, holdMax;     // 按住时长(ms)
+  int gapMin, gapMax;       // 相邻两次按下的间隔(ms)，小于按住时长时两键重叠
+  int bounceMax;            // 抖动上限(ms)
+} Scenario;
+
+static Press presses[MAX_PRESSES];
+
+/**
+ * 触点状态：抖动期间随机通断
+ */
+static bool contact(const Press *press, uint32_t now) {
+  if (now < press->down || now >= press->up + press->bounceUp) {
+    return false;
+  }
+  if (now < press->down + press->bounceDown || now >= press->up) {
+    return random_next() & 1;
+  }
+  return true;
+}
+
+static uint16_t raw_matrix(int count, uint32_t now) {
+  uint16_t raw = 0;
+  for (int i = 0; i < count; i++) {
+    if (contact(&presses[i], now)) {
+      raw |= 1u << presses[i].key;
+    }
+  }
+  return raw;
+}
+
+/**
+ * 按键事件对应到最近一次同键的物理按键
+ */
+static Press *match_press(int count, int key, uint32_t now) {
+  Press *match = NULL;
+  for (int i = 0; i < count; i++) {
+    if (presses[i].key == key && presses[i].down <= now) {
+      match = &presses[i];
+    }
+  }
+  return match;
+}
+
+static int run(const Scenario *scenario) {
+  // 生成按键序列（同一键抬起100ms内不再按下）
+  int count = scenario->presses < MAX_PRESSES ? scenario->presses : MAX_PRESSES;
+  uint32_t lastUp[KEYPAD_KEYS] = {0};
+  uint32_t at = 1000;
+  for (int i = 0; i < count; i++) {
+    Press *press = &presses[i];
+    memset(press, 0, sizeof(*press));
+    press->down = at;
+    press->up = at + random_range(scenario->holdMin, scenario->holdMax);
+    press->bounceDown = random_range(0, scenario->bounceMax);
+    press->bounceUp = random_range(0, scenario->bounceMax);
+    do {
+      press->key = random_range(0, KEYPAD_KEYS - 1);
+    } while (lastUp[press->key] > 0 && press->down < lastUp[press->key] + 100);
+    lastUp[press->key] = press->up + press->bounceUp;
+    at += random_range(scenario->gapMin, scenario->gapMax);
+  }
+  uint32_t end = presses[count - 1].up + 1000;
+
+  KeypadMatrix matrix;
+  keypad_matrix_init(&matrix, keymap);
+  KeypadEvent events[KEYPAD_KEYS];
+  bool scanning = false;
+  uint32_t nextScan = 0;
+  uint16_t previous = 0;
+  uint32_t scans = 0;
+  uint32_t interrupts = 0;
+  uint32_t scanningMs = 0;
+  int unmatched = 0;
+
+  for (uint32_t now = 0; now < end; now++) {
+    uint16_t raw = raw_matrix(count, now);
+
+    // 列中断：空闲时有按键接通（该列出现下降沿）
+    if (!scanning && (raw & ~previous)) {
+      scanning = true;
+      nextScan = now + KEYPAD_SCAN_INTERVAL_MS;
+      interrupts++;
+    }
+    previous = raw;
+    scanningMs += scanning;
+
+    if (!scanning || now != nextScan) {
+      continue;
+    }
+    scans++;
+    nextScan += KEYPAD_SCAN_INTERVAL_MS;
+    int n = keypad_matrix_feed(&matrix, raw, now, events, KEYPAD_KEYS);
+    for (int i = 0; i < n; i++) {
+      int key = (int)((const char *)memchr(keymap, events[i].key, KEYPAD_KEYS) - keymap);
+      Press *press = match_press(count, key, now);
+      if (!press) {
+        unmatched++;
+        continue;
+      }
+      if (events[i].pressed) {
+        press->pressEvents++;
+        press->pressAt = now;
+      } else {
+        press->releaseEvents++;
+        press->releaseAt = now;
+      }
+    }
+    if (keypad_matrix_idle(&matrix)) {
+      // 停止后复查列电平
+      scanning = raw != 0;
+      nextScan = now + KEYPAD_SCAN_INTERVAL_MS;
+    }
+  }
+
+  // 每次按键恰好一个按下、一个抬起事件
+  int wrong = unmatched;
+  uint32_t latencyTotal = 0;
+  uint32_t latencyMax = 0;
+  for (int i = 0; i < count; i++) {
+    Press *press = &presses[i];
+    if (press->pressEvents != 1 || press->releaseEvents != 1) {
+      wrong++;
+      continue;
+    }
+    uint32_t latency = press->pressAt - press->down;
+    latencyTotal += latency;
+    latencyMax = latency > latencyMax ? latency : latencyMax;
+  }
+
+  // 原实现：任务每100ms扫描一次，按下后 delay(50) 并等到抬起才返回，期间不处理刷卡和指纹
+  uint32_t legacyBlocked = 0;
+  uint32_t legacyMax = 0;
+  int legacyMissed = 0;
+  for (int i = 0; i < count; i++) {
+    Press *press = &presses[i];
+    uint32_t poll = (press->down + press->bounceDown + LEGACY_TASK_PERIOD_MS - 1) / LEGACY_TASK_PERIOD_MS *
+                    LEGACY_TASK_PERIOD_MS;
+    if (poll >= press->up) {
+      legacyMissed++;
+      continue;
+    }
+    uint32_t release = press->up + press->bounceUp;
+    uint32_t blocked = LEGACY_DEBOUNCE_MS + (release > poll + LEGACY_DEBOUNCE_MS ? release - poll - LEGACY_DEBOUNCE_MS : 0);
+    legacyBlocked += blocked;
+    legacyMax = blocked > legacyMax ? blocked : legacyMax;
+  }
+
+  printf("%-8s %6d %6d %8.1f %8u %8.1f %8u %8.2f%% %10.1f %10u %6d\n", scenario->name, count, wrong,
+         count > wrong ? (double)latencyTotal / (count - wrong) : 0, latencyMax, (double)scans / count, interrupts,
+         100.0 * scanningMs / end, (double)legacyBlocked / count, legacyMax, legacyMissed);
+
+  if (wrong > 0 || latencyMax > (uint32_t)MAX_PRESS_LATENCY_MS(scenario->bounceMax)) {
+    printf("%s: 未达到要求\n", scenario->name);
+    return 0;
+  }
+  return 1;
+}
+
+int main() {
+  Scenario scenarios[] = {
+    {"正常",   1000, 80, 200, 400, 1200, 5},
+    {"长按",   200, 1000, 3000, 3500, 5000, 5},
+    {"快速",   1000, 40, 80, 90, 150, 3},
+    {"滚键",   1000, 120, 200, 60, 100, 5},
+    {"劣质",   1000, 80, 200, 400, 1200, 12},
+  };
+
+  printf("%-8s %6s %6s %8s %8s %8s %8s %9s %10s %10s %6s\n", "场景", "按键", "错误", "平均延迟", "最大延迟",
+         "扫描/键", "中断", "扫描时间", "原阻塞/键", "原最大阻塞", "原漏键");
+  int ok = 1;
+  for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+    ok &= run(&scenarios[i]);
+  }
+  return ok ? 0 : 1;
+}
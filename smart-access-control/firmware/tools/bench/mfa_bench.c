@@ -0,0 +1,240 @@
+/*
+ * 多因素认证主机时间线测试
+ *
+ * 按脚本给出各因素的提交和超时检查（毫秒），检查每一步的判定、拒绝原因和用户与期望一致：
+ *   - 各策略（any / card / card+pin / finger+pin / any_two）的通过、等待和不接受的因素；
+ *     人脸不单独开门，只有any_two接受
+ *   - 未匹配的凭证：单因素或第二个因素未知时拒绝
+ *   - 用户不一致：第二个因素属于其他用户
+ *   - 超时：窗口内未完成时 mfa_poll 拒绝；窗口后提交的因素开始新会话
+ *   - millis() 回绕：会话跨越 0xFFFFFFFF 时窗口照常计算
+ * 另检查策略名称的双向转换，并测量卡+密码两步认证的耗时。
+ *
+ * 编译运行（firmware 目录下）:
+ *   cc -O2 -Isrc tools/bench/mfa_bench.c src/modules/mfa.c -o mfa_bench && ./mfa_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "modules/mfa.h"
+
+#define MAX_STEPS  8
+
+#define WINDOW_MS  15000
+
+// 超时检查（不提交因素）
+#define STEP_POLL  0
+
+#define BENCH_SESSIONS  1000000
+
+typedef struct {
+  uint32_t at;             // 相对会话起点的时间(ms)
+  uint8_t factor;          // STEP_POLL 表示调用 mfa_poll
+  int userId;
+  MfaResult result;        // 期望判定
+  MfaReason reason;        // 期望拒绝原因
+  int expectedUser;        // 期望判定中的用户
+} Step;
+
+typedef struct {
+  const char *name;
+  MfaPolicy policy;
+  uint32_t base;           // 起点时间，接近 0xFFFFFFFF 时跨越回绕
+  Step steps[MAX_STEPS];
+  int stepCount;
+} Scenario;
+
+static const char *const resultNames[] = {"none", "pending", "grant", "deny"};
+static const char *const reasonNames[] = {"-", "unknown", "not_allowed", "user_mismatch", "timeout"};
+
+static double now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * 按时间线执行一个场景，返回不一致的步数
+ */
+static int run_scenario(const Scenario *scenario) {
+  MfaDoor door;
+  mfa_door_init(&door, scenario->policy, WINDOW_MS);
+
+  int failures = 0;
+  for (int i = 0; i < scenario->stepCount; i++) {
+    const Step *step = &scenario->steps[i];
+    uint32_t now = scenario->base + step->at;
+    // 时间表ID取用户ID，检查通过时带回第一个因素的用户时间表
+    MfaDecision decision = step->factor == STEP_POLL
+      ? mfa_poll(&door, now)
+      : mfa_submit(&door, (MfaFactor)step->factor, step->userId, (uint8_t)step->userId, now);
+
+    bool ok = decision.result == step->result && decision.reason == step->reason &&
+              (decision.result == MFA_RESULT_NONE || decision.userId == step->expectedUser);
+    if (ok && decision.result == MFA_RESULT_GRANT) {
+      ok = decision.scheduleId == (uint8_t)step->expectedUser;
+    }
+    if (!ok) {
+      printf("  %s 第%d步 t=%u: 期望 %s/%s 用户%d，实际 %s/%s 用户%d（%s）\n", scenario->name, i + 1, now,
+             resultNames[step->result], reasonNames[step->reason], step->expectedUser,
+             resultNames[decision.result], reasonNames[decision.reason], decision.userId,
+             mfa_method_name(decision.factors));
+      failures++;
+    }
+  }
+
+  // 每个场景结束时会话应已结束（通过、拒绝或超时）
+  if (mfa_is_pending(&door)) {
+    printf("  %s: 结束时仍在等待\n", scenario->name);
+    failures++;
+  }
+  return failures;
+}
+
+/**
+ * 策略名称双向转换，各策略是否接受人脸
+ */
+static int check_policy_names() {
+  int failures = 0;
+  for (int i = 0; i < MFA_POLICY_COUNT; i++) {
+    MfaPolicy policy;
+    const char *name = mfa_policy_name((MfaPolicy)i);
+    if (!mfa_policy_from_name(name, &policy) || policy != (MfaPolicy)i) {
+      printf("  策略名称转换错误: %s\n", name);
+      failures++;
+    }
+  }
+  MfaPolicy policy;
+  if (mfa_policy_from_name("card+face", &policy) || mfa_policy_from_name(NULL, &policy)) {
+    printf("  无效策略名称被接受\n");
+    failures++;
+  }
+
+  // 只有any_two接受人脸
+  for (int i = 0; i < MFA_POLICY_COUNT; i++) {
+    MfaDoor door;
+    mfa_door_init(&door, (MfaPolicy)i, WINDOW_MS);
+    if (mfa_accepts(&door, MFA_FACTOR_FACE) != (i == MFA_POLICY_ANY_TWO)) {
+      printf("  %s 策略对人脸的接受与期望不一致\n", mfa_policy_name((MfaPolicy)i));
+      failures++;
+    }
+  }
+  return failures;
+}
+
+int main() {
+  const uint8_t CARD = MFA_FACTOR_CARD;
+  const uint8_t FINGER = MFA_FACTOR_FINGER;
+  const uint8_t PIN = MFA_FACTOR_PIN;
+  const uint8_t FACE = MFA_FACTOR_FACE;
+  const MfaResult NONE = MFA_RESULT_NONE;
+  const MfaResult PENDING = MFA_RESULT_PENDING;
+  const MfaResult GRANT = MFA_RESULT_GRANT;
+  const MfaResult DENY = MFA_RESULT_DENY;
+
+  Scenario scenarios[] = {
+    {"any单因素", MFA_POLICY_ANY_ONE, 10000,
+     {{0, STEP_POLL, 0, NONE, MFA_REASON_NONE, 0},
+      {100, CARD, 1, GRANT, MFA_REASON_NONE, 1},
+      {2000, FINGER, 2, GRANT, MFA_REASON_NONE, 2},
+      {4000, PIN, 3, GRANT, MFA_REASON_NONE, 3},
+      {6000, FACE, 4, DENY, MFA_REASON_NOT_ALLOWED, 0},
+      {8000, CARD, 0, DENY, MFA_REASON_UNKNOWN, 0}}, 6},
+    {"card仅刷卡", MFA_POLICY_CARD_ONLY, 10000,
+     {{0, CARD, 1, GRANT, MFA_REASON_NONE, 1},
+      {1000, FINGER, 1, DENY, MFA_REASON_NOT_ALLOWED, 0},
+      {2000, PIN, 1, DENY, MFA_REASON_NOT_ALLOWED, 0},
+      {3000, FACE, 1, DENY, MFA_REASON_NOT_ALLOWED, 0},
+      {4000, CARD, 0, DENY, MFA_REASON_UNKNOWN, 0}}, 5},
+    {"card+pin", MFA_POLICY_CARD_PIN, 10000,
+     {{0, CARD, 1, PENDING, MFA_REASON_NONE, 1},
+      {500, CARD, 1, PENDING, MFA_REASON_NONE, 1},
+      {3000, PIN, 1, GRANT, MFA_REASON_NONE, 1},
+      {5000, PIN, 2, PENDING, MFA_REASON_NONE, 2},
+      {6000, CARD, 2, GRANT, MFA_REASON_NONE, 2},
+      {8000, FINGER, 2, DENY, MFA_REASON_NOT_ALLOWED, 0}}, 6},
+    {"card+pin不一致", MFA_POLICY_CARD_PIN, 10000,
+     {{0, CARD, 1, PENDING, MFA_REASON_NONE, 1},
+      {2000, PIN, 2, DENY, MFA_REASON_USER_MISMATCH, 1},
+      {2100, STEP_POLL, 0, NONE, MFA_REASON_NONE, 0},
+      {4000, CARD, 3, PENDING, MFA_REASON_NONE, 3},
+      {5000, PIN, 0, DENY, MFA_REASON_UNKNOWN, 0}}, 5},
+    {"card+pin超时", MFA_POLICY_CARD_PIN, 10000,
+     {{0, CARD, 1, PENDING, MFA_REASON_NONE, 1},
+      {WINDOW_MS - 1, STEP_POLL, 0, PENDING, MFA_REASON_NONE, 1},
+      {WINDOW_MS, STEP_POLL, 0, DENY, MFA_REASON_TIMEOUT, 1},
+      {WINDOW_MS + 1, STEP_POLL, 0, NONE, MFA_REASON_NONE, 0},
+      // 未轮询时，窗口后的因素作废旧会话并开始新会话
+      {20000, PIN, 1, PENDING, MFA_REASON_NONE, 1},
+      {20000 + WINDOW_MS, CARD, 2, PENDING, MFA_REASON_NONE, 2},
+      {20000 + WINDOW_MS + 100, PIN, 2, GRANT, MFA_REASON_NONE, 2}}, 7},
+    {"finger+pin", MFA_POLICY_FINGER_PIN, 10000,
+     {{0, FINGER, 1, PENDING, MFA_REASON_NONE, 1},
+      {1500, PIN, 1, GRANT, MFA_REASON_NONE, 1},
+      {3000, CARD, 1, DENY, MFA_REASON_NOT_ALLOWED, 0},
+      {4000, PIN, 2, PENDING, MFA_REASON_NONE, 2},
+      {5000, FINGER, 3, DENY, MFA_REASON_USER_MISMATCH, 2},
+      {6000, FINGER, 4, PENDING, MFA_REASON_NONE, 4},
+      {6000 + WINDOW_MS, STEP_POLL, 0, DENY, MFA_REASON_TIMEOUT, 4}}, 7},
+    {"any_two", MFA_POLICY_ANY_TWO, 10000,
+     {{0, CARD, 1, PENDING, MFA_REASON_NONE, 1},
+      {500, CARD, 1, PENDING, MFA_REASON_NONE, 1},
+      {1000, FACE, 1, GRANT, MFA_REASON_NONE, 1},
+      {3000, PIN, 2, PENDING, MFA_REASON_NONE, 2},
+      {4000, FINGER, 2, GRANT, MFA_REASON_NONE, 2},
+      {6000, FINGER, 3, PENDING, MFA_REASON_NONE, 3},
+      {7000, FACE, 5, DENY, MFA_REASON_USER_MISMATCH, 3},
+      {9000, FACE, 0, DENY, MFA_REASON_UNKNOWN, 0}}, 8},
+    {"回绕通过", MFA_POLICY_CARD_PIN, 0xFFFFFFFFu - 2000,
+     {{0, CARD, 1, PENDING, MFA_REASON_NONE, 1},
+      {1999, STEP_POLL, 0, PENDING, MFA_REASON_NONE, 1},
+      {2001, STEP_POLL, 0, PENDING, MFA_REASON_NONE, 1},
+      {WINDOW_MS - 1, PIN, 1, GRANT, MFA_REASON_NONE, 1}}, 4},
+    {"回绕超时", MFA_POLICY_ANY_TWO, 0xFFFFFFFFu - 100,
+     {{0, FINGER, 1, PENDING, MFA_REASON_NONE, 1},
+      {5000, STEP_POLL, 0, PENDING, MFA_REASON_NONE, 1},
+      {WINDOW_MS, STEP_POLL, 0, DENY, MFA_REASON_TIMEOUT, 1},
+      {WINDOW_MS + 1000, CARD, 1, PENDING, MFA_REASON_NONE, 1},
+      {2 * WINDOW_MS + 1000, PIN, 1, PENDING, MFA_REASON_NONE, 1},
+      {2 * WINDOW_MS + 1500, FACE, 1, GRANT, MFA_REASON_NONE, 1}}, 6},
+  };
+
+  printf("%-16s %-10s %6s %6s\n", "场景", "策略", "步数", "失败");
+  int failures = 0;
+  for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+    const Scenario *scenario = &scenarios[i];
+    int scenarioFailures = run_scenario(scenario);
+    printf("%-16s %-10s %6d %6d\n", scenario->name, mfa_policy_name(scenario->policy), scenario->stepCount,
+           scenarioFailures);
+    failures += scenarioFailures;
+  }
+  failures += check_policy_names();
+
+  // 卡+密码两步认证，每次会话换一个用户
+  MfaDoor door;
+  mfa_door_init(&door, MFA_POLICY_CARD_PIN, WINDOW_MS);
+  volatile uint32_t granted = 0;
+  uint32_t now = 0;
+  double start = now_ns();
+  for (int i = 0; i < BENCH_SESSIONS; i++) {
+    int userId = 1 + (i & 1023);
+    mfa_submit(&door, MFA_FACTOR_CARD, userId, 0, now);
+    now += 1500;
+    granted += mfa_submit(&door, MFA_FACTOR_PIN, userId, 0, now).result == MFA_RESULT_GRANT;
+  }
+  double sessionNs = (now_ns() - start) / BENCH_SESSIONS;
+  if (granted != BENCH_SESSIONS) {
+    printf("  卡+密码通过 %u/%d\n", (unsigned)granted, BENCH_SESSIONS);
+    failures++;
+  }
+  printf("卡+密码认证: %.1f ns/次（会话=%d）\n", sessionNs, BENCH_SESSIONS);
+
+  if (failures > 0) {
+    printf("%d 项与期望不一致\n", failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,277 @@
+/*
+ * 运动检测分级主机测试
+ *
+ * 1. 合成帧序列（每500ms一帧，低分辨率级80×60、全分辨率级160×120，与设备JPEG按1/2解码后一致）：
+ *    - 静止：空场景1小时，只有传感器噪声
+ *    - 曝光：空场景10分钟，自动曝光缓慢起伏并每2分钟跳变一次
+ *    - 访客：1小时12位访客，3秒走到门前、停留10秒（轻微晃动）、3秒离开
+ *    统计各级处理的帧比例、切换次数、误触发（无人时切换）、漏检、检测延迟、停留期间处于全分辨率的比例。
+ *    检查：无人场景不误触发；访客全部检出，延迟不超过2帧，停留期间全分辨率覆盖不低于90%。
+ * 2. 指定PGM（P5）灰度图像序列时，按顺序逐帧处理并输出变化格子数和级别（间隔500ms）。
+ *
+ * 编译运行（firmware 目录下）:
+ *   cc -O2 -Isrc tools/bench/motion_gate_bench.c src/modules/motion_gate.c -lm -o motion_gate_bench
+ *   ./motion_gate_bench
+ *   ./motion_gate_bench frame001.pgm frame002.pgm ...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "modules/motion_gate.h"
+
+#define FRAME_INTERVAL_MS  500
+
+// 各级帧尺寸
+#define IDLE_WIDTH    80
+#define IDLE_HEIGHT   60
+#define ACTIVE_WIDTH  160
+#define ACTIVE_HEIGHT 120
+
+// 传感器噪声（灰度级标准差）
+#define NOISE_SIGMA  3.0f
+
+// 访客：进入、停留、离开的帧数
+#define VISIT_ENTER_FRAMES  6
+#define VISIT_STAY_FRAMES   20
+#define VISIT_LEAVE_FRAMES  6
+
+// 检查项
+#define MAX_LATENCY_FRAMES  2
+#define MIN_STAY_COVERAGE   0.90
+
+static uint32_t randomState = 11;
+
+static float random_unit() {
+  randomState = randomState * 1664525u + 1013904223u;
+  return (randomState >> 8) / 16777216.0f;
+}
+
+static float random_gauss() {
+  float sum = 0;
+  for (int i = 0; i < 4; i++) {
+    sum += random_unit();
+  }
+  return (sum - 2.0f) * 1.7320508f;
+}
+
+/**
+ * 背景：门框、墙面渐变和几块明暗不同的区域（坐标归一化到0~1）
+ */
+static float background(float u, float v) {
+  float value = 110 + 40 * u - 20 * v;
+  if (u > 0.3f && u < 0.7f && v > 0.1f) {
+    value = 150 + 10 * sinf(v * 20);   // 门
+  }
+  if (fabsf(u - 0.3f) < 0.02f || fabsf(u - 0.7f) < 0.02f) {
+    value = 60;                        // 门框
+  }
+  if (u > 0.05f && u < 0.2f && v > 0.3f && v < 0.5f) {
+    value = 200;                       // 告示牌
+  }
+  return value;
+}
+
+typedef struct {
+  bool present;
+  float x;          // 中心横坐标（归一化）
+} Person;
+
+/**
+ * 访客：深色椭圆躯干加较亮的头部
+ */
+static bool person_value(const Person *person, float u, float v, float *value) {
+  if (!person->present) {
+    return false;
+  }
+  float dx = (u - person->x) / 0.12f;
+  float dy = (v - 0.72f) / 0.3f;
+  if (dx * dx + dy * dy < 1) {
+    *value = 45 + 10 * sinf(v * 40);
+    return true;
+  }
+  dx = (u - person->x) / 0.07f;
+  dy = (v - 0.32f) / 0.11f;
+  if (dx * dx + dy * dy < 1) {
+    *value = 170 - 30 * dx * dx;
+    return true;
+  }
+  return false;
+}
+
+static void render(uint8_t *gray, int width, int height, const Person *person, float gain, float offset) {
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      float u = (x + 0.5f) / width;
+      float v = (y + 0.5f) / height;
+      float value;
+      if (!person_value(person, u, v, &value)) {
+        value = background(u, v);
+      }
+      value = value * gain + offset + random_gauss() * NOISE_SIGMA;
+      gray[y * width + x] = value < 0 ? 0 : value > 255 ? 255 : (uint8_t)value;
+    }
+  }
+}
+
+typedef struct {
+  const char *name;
+  int frames;
+  int visits;             // 访客数（均匀分布）
+  bool exposure;          // 自动曝光起伏和跳变
+} Scenario;
+
+static int run(const Scenario *scenario) {
+  static uint8_t gray[ACTIVE_WIDTH * ACTIVE_HEIGHT];
+  MotionGate gate;
+  motion_gate_init(&gate);
+
+  // 摄像头分辨率在级别变化后的下一帧生效
+  MotionTier cameraTier = MOTION_TIER_IDLE;
+  int period = scenario->visits > 0 ? scenario->frames / scenario->visits : 0;
+  int visitLength = VISIT_ENTER_FRAMES + VISIT_STAY_FRAMES + VISIT_LEAVE_FRAMES;
+  int falseActivations = 0;
+  int missed = 0;
+  int latencyTotal = 0;
+  int latencyMax = 0;
+  int stayFrames = 0;
+  int stayActive = 0;
+  int detectedAt = -1;
+
+  for (int frame = 0; frame < scenario->frames; frame++) {
+    Person person = {false, 0};
+    int phase = period > 0 ? frame % period - period / 2 : -1;
+    if (phase >= 0 && phase < visitLength) {
+      person.present = true;
+      if (phase < VISIT_ENTER_FRAMES) {
+        person.x = -0.1f + 0.6f * (phase + 1) / VISIT_ENTER_FRAMES;
+      } else if (phase < VISIT_ENTER_FRAMES + VISIT_STAY_FRAMES) {
+        person.x = 0.5f + 0.02f * sinf(phase * 1.3f);
+      } else {
+        person.x = 0.5f + 0.6f * (phase - VISIT_ENTER_FRAMES - VISIT_STAY_FRAMES + 1) / VISIT_LEAVE_FRAMES;
+      }
+      if (phase == 0) {
+        detectedAt = -1;
+      }
+    }
+
+    float gain = 1;
+    float offset = 0;
+    if (scenario->exposure) {
+      gain = 1 + 0.2f * sinf(frame * 2 * 3.14159f / 120);
+      offset = (frame / 240) % 2 ? 15 : 0;
+    }
+
+    int width = cameraTier == MOTION_TIER_ACTIVE ? ACTIVE_WIDTH : IDLE_WIDTH;
+    int height = cameraTier == MOTION_TIER_ACTIVE ? ACTIVE_HEIGHT : IDLE_HEIGHT;
+    render(gray, width, height, &person, gain, offset);
+
+    MotionTier before = gate.tier;
+    if (person.present && phase >= VISIT_ENTER_FRAMES && phase < VISIT_ENTER_FRAMES + VISIT_STAY_FRAMES) {
+      stayFrames++;
+      stayActive += before == MOTION_TIER_ACTIVE;
+    }
+    if (motion_gate_feed(&gate, gray, width, height, (uint32_t)frame * FRAME_INTERVAL_MS) &&
+        gate.tier == MOTION_TIER_ACTIVE) {
+      if (!person.present && before == MOTION_TIER_IDLE) {
+        // 离开后的最后几帧仍有运动属正常，其余视为误触发
+        int sinceLeave = period > 0 ? (frame % period - period / 2 - visitLength) : frame;
+        falseActivations += sinceLeave < 0 || sinceLeave > 2;
+      }
+      if (person.present && detectedAt < 0) {
+        detectedAt = phase;
+      }
+    }
+    if (person.present && phase == visitLength - 1) {
+      if (detectedAt < 0) {
+        missed++;
+      } else {
+        latencyTotal += detectedAt;
+        latencyMax = detectedAt > latencyMax ? detectedAt : latencyMax;
+      }
+    }
+    cameraTier = gate.tier;
+  }
+
+  uint32_t total = gate.frames[MOTION_TIER_IDLE] + gate.frames[MOTION_TIER_ACTIVE];
+  int detected = scenario->visits - missed;
+  double coverage = stayFrames > 0 ? (double)stayActive / stayFrames : 1;
+  printf("%-6s %8u %9.1f%% %9.1f%% %6u %8d %6d %8.1f %8d %9.1f%%\n", scenario->name, total,
+         100.0 * gate.frames[MOTION_TIER_IDLE] / total, 100.0 * gate.frames[MOTION_TIER_ACTIVE] / total,
+         gate.activations, falseActivations, missed, detected > 0 ? (double)latencyTotal / detected : 0, latencyMax,
+         100 * coverage);
+
+  if (falseActivations > 0 || missed > 0 || latencyMax > MAX_LATENCY_FRAMES || coverage < MIN_STAY_COVERAGE) {
+    printf("%s: 未达到要求\n", scenario->name);
+    return 0;
+  }
+  return 1;
+}
+
+/**
+ * 读取PGM（P5）灰度图像
+ */
+static uint8_t *read_pgm(const char *path, int *width, int *height) {
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    return NULL;
+  }
+  int maxValue = 0;
+  uint8_t *gray = NULL;
+  if (fscanf(file, "P5 %d %d %d", width, height, &maxValue) == 3 && maxValue == 255 && fgetc(file) != EOF &&
+      *width >= MOTION_GRID_WIDTH && *height >= MOTION_GRID_HEIGHT) {
+    gray = (uint8_t *)malloc((size_t)*width * *height);
+    if (fread(gray, 1, (size_t)*width * *height, file) != (size_t)*width * *height) {
+      free(gray);
+      gray = NULL;
+    }
+  }
+  fclose(file);
+  return gray;
+}
+
+static int replay_files(int argc, char **argv) {
+  MotionGate gate;
+  motion_gate_init(&gate);
+  for (int i = 1; i < argc; i++) {
+    int width = 0;
+    int height = 0;
+    uint8_t *gray = read_pgm(argv[i], &width, &height);
+    if (!gray) {
+      fprintf(stderr, "图像无效 %s\n", argv[i]);
+      return 1;
+    }
+    bool changed = motion_gate_feed(&gate, gray, width, height, (uint32_t)(i - 1) * FRAME_INTERVAL_MS);
+    printf("%s: %dx%d 变化格子%u %s%s\n", argv[i], width, height, gate.changedCells,
+           gate.tier == MOTION_TIER_ACTIVE ? "全分辨率" : "低分辨率", changed ? "（切换）" : "");
+    free(gray);
+  }
+  uint32_t total = gate.frames[MOTION_TIER_IDLE] + gate.frames[MOTION_TIER_ACTIVE];
+  printf("低分辨率 %u 帧（%.1f%%），全分辨率 %u 帧（%.1f%%），切换 %u 次\n", gate.frames[MOTION_TIER_IDLE],
+         100.0 * gate.frames[MOTION_TIER_IDLE] / total, gate.frames[MOTION_TIER_ACTIVE],
+         100.0 * gate.frames[MOTION_TIER_ACTIVE] / total, gate.activations);
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc >= 2) {
+    return replay_files(argc, argv);
+  }
+
+  Scenario scenarios[] = {
+    {"静止", 7200, 0, false},
+    {"曝光", 1200, 0, true},
+    {"访客", 7200, 12, false},
+    {"访客+曝光", 7200, 12, true},
+  };
+
+  printf("%-6s %8s %10s %10s %6s %8s %6s %8s %8s %10s\n", "场景", "帧数", "低分辨率", "全分辨率", "切换",
+         "误触发", "漏检", "平均延迟", "最大延迟", "停留覆盖");
+  int ok = 1;
+  for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+    ok &= run(&scenarios[i]);
+  }
+  return ok ? 0 : 1;
+}
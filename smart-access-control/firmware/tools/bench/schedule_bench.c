@@ -0,0 +1,194 @@
+/*
+ * 时间表判定主机基准
+ *
+ * 10000个用户分属64个时间表组，对比：
+ *   - 位图：按分钟计算一次时段，每个用户一次位测试（与固件相同，见 schedule.h）
+ *   - 规则：逐条扫描时段规则，节假日线性查表
+ * 两种方式的结果逐一比对，不一致时退出码非0。
+ *
+ * 编译运行（firmware 目录下）:
+ *   cc -O2 -Isrc tools/bench/schedule_bench.c -o schedule_bench && ./schedule_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "modules/schedule.h"
+
+#define BENCH_USERS      10000
+#define BENCH_GROUPS     64
+#define BENCH_RULES      4
+#define BENCH_OVERRIDES  24
+#define BENCH_MINUTES    2000
+
+// 未编译的时段规则
+typedef struct {
+  uint8_t dayMask;       // 位0~6为周一至周日，位7为节假日
+  uint16_t startMinute;
+  uint16_t endMinute;    // 不含
+} ScheduleRule;
+
+typedef struct {
+  ScheduleRule rules[BENCH_RULES];
+  int ruleCount;
+} ScheduleGroup;
+
+static ScheduleGroup groups[BENCH_GROUPS];
+static uint32_t bitmaps[BENCH_GROUPS][SCHEDULE_WORDS];
+static ScheduleOverride overrides[BENCH_OVERRIDES];
+static uint8_t userSchedule[BENCH_USERS];
+
+static uint32_t rng_state = 12345;
+
+static uint32_t rng() {
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+static double now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * 规则判定（未编译）
+ */
+static bool rule_allowed(uint8_t scheduleId, uint16_t day, uint8_t weekday, uint16_t minuteOfDay) {
+  if (scheduleId == SCHEDULE_ALWAYS) {
+    return true;
+  }
+
+  uint8_t row = weekday;
+  for (int i = 0; i < BENCH_OVERRIDES; i++) {
+    if (overrides[i].day == day) {
+      row = overrides[i].row;
+      break;
+    }
+  }
+
+  const ScheduleGroup *group = &groups[scheduleId - 1];
+  for (int i = 0; i < group->ruleCount; i++) {
+    const ScheduleRule *rule = &group->rules[i];
+    if ((rule->dayMask >> row & 1) && minuteOfDay >= rule->startMinute && minuteOfDay < rule->endMinute) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * 把规则编译为位图（对应 tools/schedule_compiler.py）
+ */
+static void compile_group(int index) {
+  const ScheduleGroup *group = &groups[index];
+  for (int i = 0; i < group->ruleCount; i++) {
+    const ScheduleRule *rule = &group->rules[i];
+    for (int row = 0; row < SCHEDULE_ROWS; row++) {
+      if (!(rule->dayMask >> row & 1)) {
+        continue;
+      }
+      for (int minute = rule->startMinute; minute < rule->endMinute; minute += SCHEDULE_SLOT_MINUTES) {
+        int slot = row * SCHEDULE_SLOTS_PER_DAY + minute / SCHEDULE_SLOT_MINUTES;
+        bitmaps[index][slot >> 5] |= 1u << (slot & 31);
+      }
+    }
+  }
+}
+
+int main() {
+  // 随机生成时间表组：工作日、周末、夜班等，起止对齐15分钟
+  for (int g = 0; g < BENCH_GROUPS; g++) {
+    groups[g].ruleCount = 1 + rng() % BENCH_RULES;
+    for (int i = 0; i < groups[g].ruleCount; i++) {
+      uint16_t start = (rng() % 88) * SCHEDULE_SLOT_MINUTES;
+      uint16_t length = (1 + rng() % (96 - start / SCHEDULE_SLOT_MINUTES)) * SCHEDULE_SLOT_MINUTES;
+      groups[g].rules[i].dayMask = (uint8_t)(rng() | 1);
+      groups[g].rules[i].startMinute = start;
+      groups[g].rules[i].endMinute = start + length;
+    }
+    compile_group(g);
+  }
+
+  // 节假日及调休，按日期升序
+  uint16_t firstDay = 20454;  // 2026-01-01
+  for (int i = 0; i < BENCH_OVERRIDES; i++) {
+    overrides[i].day = firstDay + i * 15;
+    overrides[i].row = (i % 4 == 3) ? (uint8_t)(rng() % 5) : SCHEDULE_HOLIDAY_ROW;
+  }
+
+  // 约1/16用户不限时间
+  for (int u = 0; u < BENCH_USERS; u++) {
+    userSchedule[u] = (rng() % 16 == 0) ? SCHEDULE_ALWAYS : (uint8_t)(1 + rng() % BENCH_GROUPS);
+  }
+
+  ScheduleTable table = {1, BENCH_GROUPS, BENCH_OVERRIDES, (const uint32_t (*)[SCHEDULE_WORDS])bitmaps, overrides};
+
+  // 随机时刻（覆盖一年，含覆盖日期）
+  static uint16_t days[BENCH_MINUTES];
+  static uint8_t weekdays[BENCH_MINUTES];
+  static uint16_t minutes[BENCH_MINUTES];
+  for (int m = 0; m < BENCH_MINUTES; m++) {
+    days[m] = (m % 10 == 0) ? overrides[rng() % BENCH_OVERRIDES].day : firstDay + rng() % 365;
+    weekdays[m] = (days[m] + 3) % 7;  // 1970-01-01为周四
+    minutes[m] = rng() % 1440;
+  }
+
+  // 结果比对
+  for (int m = 0; m < BENCH_MINUTES; m++) {
+    uint16_t slot = schedule_slot(&table, days[m], weekdays[m], minutes[m]);
+    for (int u = 0; u < BENCH_USERS; u++) {
+      if (schedule_test(&table, userSchedule[u], slot) != rule_allowed(userSchedule[u], days[m], weekdays[m], minutes[m])) {
+        fprintf(stderr, "结果不一致: 用户=%d 日期=%u 分钟=%u\n", u, days[m], minutes[m]);
+        return 1;
+      }
+    }
+  }
+
+  const double evaluations = (double)BENCH_USERS * BENCH_MINUTES;
+  volatile uint32_t allowed = 0;
+
+  double start = now_ns();
+  for (int m = 0; m < BENCH_MINUTES; m++) {
+    uint32_t count = 0;
+    for (int u = 0; u < BENCH_USERS; u++) {
+      count += rule_allowed(userSchedule[u], days[m], weekdays[m], minutes[m]);
+    }
+    allowed += count;
+  }
+  double ruleNs = (now_ns() - start) / evaluations;
+
+  start = now_ns();
+  for (int m = 0; m < BENCH_MINUTES; m++) {
+    uint16_t slot = schedule_slot(&table, days[m], weekdays[m], minutes[m]);
+    uint32_t count = 0;
+    for (int u = 0; u < BENCH_USERS; u++) {
+      count += schedule_test(&table, userSchedule[u], slot);
+    }
+    allowed += count;
+  }
+  double bitmapNs = (now_ns() - start) / evaluations;
+
+  // 每次判定都重新计算时段（无分钟缓存）
+  start = now_ns();
+  for (int m = 0; m < BENCH_MINUTES; m++) {
+    uint32_t count = 0;
+    for (int u = 0; u < BENCH_USERS; u++) {
+      count += schedule_test(&table, userSchedule[u], schedule_slot(&table, days[m], weekdays[m], minutes[m]));
+    }
+    allowed += count;
+  }
+  double uncachedNs = (now_ns() - start) / evaluations;
+
+  printf("用户=%d 时间表组=%d 日期覆盖=%d 判定次数=%.0f 允许=%u\n",
+         BENCH_USERS, BENCH_GROUPS, BENCH_OVERRIDES, evaluations, (unsigned)allowed);
+  printf("规则扫描:          %6.2f ns/次\n", ruleNs);
+  printf("位图（时段缓存）:  %6.2f ns/次\n", bitmapNs);
+  printf("位图（逐次计算）:  %6.2f ns/次\n", uncachedNs);
+  printf("位图内存: %zu 字节\n", sizeof(bitmaps) + sizeof(overrides));
+  return 0;
+}
@@ -0,0 +1,318 @@
+/*
+ * 门磁/防拆边沿消抖主机仿真
+ *
+ * 按微秒生成门磁和防拆开关的电平变化：
+ *   - 门磁（干簧管）每次开关门抖动0~8ms，边沿间隔20~500us
+ *   - 防拆：持续触发（拆开外壳）、短暂触发（撬动后弹回，1~50ms）和干扰毛刺（<200us）
+ * 中断记录每个边沿，传感器任务按 sensor_input.c 消抖后发布事件（中断到任务唤醒按50us计），
+ * 与原实现比较：访问控制任务每100ms、安全任务每10s调用一次 sensor_check_*，50ms消抖。
+ * 统计每次真实变化的事件数（应为一次）、边沿到事件的延迟、漏检的防拆和毛刺误报。
+ *
+ * 编译运行（firmware 目录下）:
+ *   cc -O2 -Isrc tools/bench/sensor_bench.c src/drivers/sensor_input.c -o sensor_bench && ./sensor_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "drivers/sensor_input.h"
+
+// 与 sensor_driver.c 一致
+#define DOOR_SETTLE_US       50000
+#define TAMPER_SETTLE_US     20000
+#define TAMPER_MIN_PULSE_US  500
+
+// 中断到传感器任务处理的延迟(us)
+#define TASK_LATENCY_US  50
+
+// 原实现
+#define LEGACY_DEBOUNCE_MS       50
+#define LEGACY_DOOR_PERIOD_US    100000
+#define LEGACY_TAMPER_PERIOD_US  10000000
+
+// 检查项：门磁事件延迟上限(us)
+#define MAX_DOOR_LATENCY_US  1000
+
+#define MAX_EDGES   200000
+#define MAX_CHANGES 4096
+
+typedef struct {
+  uint32_t timeUs;
+  bool level;
+} Edge;
+
+// 一次真实变化（或毛刺）
+typedef struct {
+  uint32_t timeUs;
+  bool active;
+  uint32_t widthUs;   // 防拆短暂触发/毛刺的宽度，0表示持续
+  bool glitch;        // 干扰毛刺，不应上报
+  int events;
+  uint32_t latencyUs;
+  bool legacySeen;
+  uint32_t legacyLatencyUs;
+} Change;
+
+static Edge edges[MAX_EDGES];
+static int edgeCount;
+static Change changes[MAX_CHANGES];
+static int changeCount;
+
+static uint32_t randomState = 9;
+
+static uint32_t random_next() {
+  randomState = randomState * 1664525u + 1013904223u;
+  return randomState >> 8;
+}
+
+static uint32_t random_range(uint32_t low, uint32_t high) {
+  return low + random_next() % (high - low + 1);
+}
+
+static void add_edge(uint32_t timeUs, bool level) {
+  if (edgeCount < MAX_EDGES) {
+    edges[edgeCount].timeUs = timeUs;
+    edges[edgeCount].level = level;
+    edgeCount++;
+  }
+}
+
+/**
+ * 带抖动的变化：在 bounceUs 内来回跳变，最后停在 level
+ * @return 最后一个边沿时间
+ */
+static uint32_t add_bouncing(uint32_t timeUs, bool level, uint32_t bounceUs) {
+  uint32_t t = timeUs;
+  bool current = level;
+  add_edge(t, current);
+  while (bounceUs > 0) {
+    t += random_range(20, 500);
+    if (t >= timeUs + bounceUs) {
+      break;
+    }
+    current = !current;
+    add_edge(t, current);
+  }
+  if (current != level) {
+    add_edge(t, level);
+  }
+  return t;
+}
+
+static void add_change(uint32_t timeUs, bool active, uint32_t widthUs, bool glitch) {
+  if (changeCount < MAX_CHANGES) {
+    memset(&changes[changeCount], 0, sizeof(Change));
+    changes[changeCount].timeUs = timeUs;
+    changes[changeCount].active = active;
+    changes[changeCount].widthUs = widthUs;
+    changes[changeCount].glitch = glitch;
+    changeCount++;
+  }
+}
+
+/**
+ * 电平：最后一个不晚于t的边沿
+ */
+static bool level_at(uint32_t t, int *cursor) {
+  while (*cursor + 1 < edgeCount && edges[*cursor + 1].timeUs <= t) {
+    (*cursor)++;
+  }
+  return *cursor >= 0 && edges[*cursor].timeUs <= t ? edges[*cursor].level : false;
+}
+
+/**
+ * 事件对应到最近一次不晚于它的真实变化
+ */
+static Change *match_change(uint32_t timeUs) {
+  Change *match = NULL;
+  for (int i = 0; i < changeCount && changes[i].timeUs <= timeUs; i++) {
+    match = &changes[i];
+  }
+  return match;
+}
+
+/**
+ * 新实现：边沿立即进入任务，静默期结束时确认
+ */
+static void run_new(uint32_t settleUs, uint32_t minPulseUs, bool leading, uint32_t end, int *spurious) {
+  SensorInput input;
+  sensor_input_init(&input, false, settleUs, minPulseUs, leading);
+  int next = 0;
+  uint32_t now = 0;
+  *spurious = 0;
+
+  while (now < end) {
+    uint32_t wait = sensor_input_wait(&input, now);
+    uint32_t edgeAt = next < edgeCount ? edges[next].timeUs + TASK_LATENCY_US : UINT32_MAX;
+    uint32_t settleAt = wait == SENSOR_INPUT_IDLE ? UINT32_MAX : now + wait;
+    if (edgeAt == UINT32_MAX && settleAt == UINT32_MAX) {
+      break;
+    }
+    now = edgeAt <= settleAt ? edgeAt : settleAt;
+    if (edgeAt <= settleAt) {
+      sensor_input_edge(&input, edges[next].level, edges[next].timeUs);
+      next++;
+    }
+
+    SensorChange change;
+    while (sensor_input_settle(&input, now, &change)) {
+      Change *real = match_change(change.timestampUs);
+      if (real && !real->glitch && real->widthUs > 0 && !change.active) {
+        // 短暂触发长于静默时间：先确认触发，恢复时再上报一次恢复
+        continue;
+      }
+      if (!real || real->glitch || (!change.pulse && change.active != real->active)) {
+        (*spurious)++;
+        continue;
+      }
+      if (real->events++ == 0) {
+        real->latencyUs = now - real->timeUs;
+      }
+    }
+  }
+}
+
+/**
+ * 原实现：周期调用，电平与状态不同且距上次变化超过50ms时更新
+ */
+static void run_legacy(uint32_t periodUs, uint32_t end) {
+  bool state = false;
+  uint32_t changeTime = 0;
+  int cursor = -1;
+  for (uint32_t now = periodUs; now < end; now += periodUs) {
+    bool level = level_at(now, &cursor);
+    if (level != state && now / 1000 - changeTime > LEGACY_DEBOUNCE_MS) {
+      state = level;
+      changeTime = now / 1000;
+      Change *real = match_change(now);
+      if (real && !real->legacySeen) {
+        real->legacySeen = true;
+        real->legacyLatencyUs = now - real->timeUs;
+      }
+    }
+  }
+}
+
+typedef struct {
+  int total;
+  int wrong;          // 事件数不为一（毛刺：上报了）
+  int spurious;
+  uint32_t latencyMax;
+  double latencySum;
+  int legacyMissed;
+  double legacyLatencySum;
+  uint32_t legacyLatencyMax;
+} Result;
+
+static Result summarize(int spurious) {
+  Result result;
+  memset(&result, 0, sizeof(result));
+  result.spurious = spurious;
+  for (int i = 0; i < changeCount; i++) {
+    Change *change = &changes[i];
+    if (change->glitch) {
+      result.wrong += change->events > 0;
+      continue;
+    }
+    result.total++;
+    if (change->events != 1) {
+      result.wrong++;
+      continue;
+    }
+    result.latencySum += change->latencyUs;
+    result.latencyMax = change->latencyUs > result.latencyMax ? change->latencyUs : result.latencyMax;
+    if (!change->legacySeen) {
+      result.legacyMissed++;
+    } else {
+      result.legacyLatencySum += change->legacyLatencyUs;
+      if (change->legacyLatencyUs > result.legacyLatencyMax) {
+        result.legacyLatencyMax = change->legacyLatencyUs;
+      }
+    }
+  }
+  return result;
+}
+
+static void print_result(const char *name, const Result *result) {
+  int seen = result->total - result->legacyMissed;
+  printf("%-6s %6d %6d %6d %10.2f %10.2f %10.1f %10.1f %6d\n", name, result->total, result->wrong, result->spurious,
+         result->total > result->wrong ? result->latencySum / (result->total - result->wrong) / 1000 : 0,
+         result->latencyMax / 1000.0, seen > 0 ? result->legacyLatencySum / seen / 1000 : 0,
+         result->legacyLatencyMax / 1000.0, result->legacyMissed);
+}
+
+/**
+ * 门磁：1小时60次开关门，每次开门停留3~20秒
+ */
+static int run_door() {
+  edgeCount = 0;
+  changeCount = 0;
+  uint32_t t = 1000000;
+  for (int i = 0; i < 60; i++) {
+    add_change(t, true, 0, false);
+    add_bouncing(t, true, random_range(0, 8000));
+    t += random_range(3000000, 20000000);
+    add_change(t, false, 0, false);
+    add_bouncing(t, false, random_range(0, 8000));
+    t += random_range(20000000, 40000000);
+  }
+
+  int spurious;
+  run_new(DOOR_SETTLE_US, 0, true, t + 1000000, &spurious);
+  run_legacy(LEGACY_DOOR_PERIOD_US, t + 1000000);
+  Result result = summarize(spurious);
+  print_result("门磁", &result);
+  return result.wrong == 0 && result.spurious == 0 && result.latencyMax <= MAX_DOOR_LATENCY_US;
+}
+
+/**
+ * 防拆：持续触发、短暂触发和干扰毛刺各30次（时间戳为32位微秒，总时长控制在71分钟以内）
+ */
+static int run_tamper() {
+  edgeCount = 0;
+  changeCount = 0;
+  uint32_t t = 1000000;
+  for (int i = 0; i < 90; i++) {
+    int kind = i % 3;
+    if (kind == 0) {
+      // 持续触发10秒后恢复
+      add_change(t, true, 0, false);
+      add_bouncing(t, true, random_range(0, 3000));
+      t += 10000000;
+      add_change(t, false, 0, false);
+      add_bouncing(t, false, random_range(0, 3000));
+    } else if (kind == 1) {
+      // 短暂触发
+      uint32_t width = random_range(1000, 50000);
+      add_change(t, true, width, false);
+      add_bouncing(t, true, random_range(0, 500));
+      add_bouncing(t + width, false, random_range(0, 500));
+    } else {
+      // 干扰毛刺
+      uint32_t width = random_range(5, 200);
+      add_change(t, true, width, true);
+      add_edge(t, true);
+      add_edge(t + width, false);
+    }
+    t += random_range(5000000, 20000000);
+  }
+
+  int spurious;
+  run_new(TAMPER_SETTLE_US, TAMPER_MIN_PULSE_US, false, t + 1000000, &spurious);
+  run_legacy(LEGACY_TAMPER_PERIOD_US, t + 1000000);
+  Result result = summarize(spurious);
+  print_result("防拆", &result);
+  return result.wrong == 0 && result.spurious == 0;
+}
+
+int main() {
+  printf("%-6s %6s %6s %6s %10s %10s %10s %10s %6s\n", "输入", "变化", "错误", "误报", "平均延迟ms", "最大延迟ms",
+         "原平均ms", "原最大ms", "原漏检");
+  int ok = run_door();
+  ok &= run_tamper();
+  if (!ok) {
+    printf("未达到要求\n");
+  }
+  return ok ? 0 : 1;
+}
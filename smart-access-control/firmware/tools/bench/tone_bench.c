@@ -0,0 +1,225 @@
+/*
+ * 蜂鸣器提示音时间线主机测试
+ *
+ * 按驱动的方式运行 tone_sequencer.c：每次调用后按返回的等待时间设置定时器，定时器到时再推进，
+ * 记录输出频率的变化时间线。定时器回调可能延迟（esp_timer任务繁忙），仿真时给每次回调加0~3ms随机延迟，
+ * 检查步骤按计划时间衔接、不累积误差。
+ *   1. 各提示音单独播放：总时长、定时器回调次数，与原实现（delay 阻塞、delayMicroseconds 忙等）阻塞调用任务的时间比较
+ *   2. 优先级：低优先级被拒绝、高优先级打断、被打断的循环提示音（门长时间未关）在报警结束后继续、停止后空闲
+ *
+ * 编译运行（firmware 目录下）:
+ *   cc -O2 -Isrc tools/bench/tone_bench.c src/drivers/tone_sequencer.c -o tone_bench && ./tone_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "drivers/tone_sequencer.h"
+
+// 定时器回调最大延迟(ms)
+#define MAX_CALLBACK_DELAY_MS  3
+
+// 时间线最多记录的变化数
+#define MAX_CHANGES  256
+
+typedef struct {
+  uint32_t at;
+  uint16_t frequency;
+} Change;
+
+// 脚本动作
+typedef struct {
+  uint32_t at;
+  bool stop;
+  TonePatternId id;
+  bool expectStarted;   // play 的预期返回值（stop 忽略）
+} Action;
+
+typedef struct {
+  Change changes[MAX_CHANGES];
+  int changeCount;
+  uint32_t idleAt;      // 最后一次进入空闲的计划时间
+  uint32_t callbacks;
+  int failures;
+} Timeline;
+
+static uint32_t randomState = 3;
+
+static uint32_t random_delay() {
+  randomState = randomState * 1664525u + 1013904223u;
+  return (randomState >> 8) % (MAX_CALLBACK_DELAY_MS + 1);
+}
+
+static void record(Timeline *timeline, const ToneSequencer *sequencer, uint16_t *output, uint32_t now) {
+  if (sequencer->frequency == *output) {
+    return;
+  }
+  *output = sequencer->frequency;
+  if (timeline->changeCount < MAX_CHANGES) {
+    timeline->changes[timeline->changeCount].at = now;
+    timeline->changes[timeline->changeCount].frequency = *output;
+    timeline->changeCount++;
+  }
+}
+
+/**
+ * 运行脚本到end
+ * 输出频率变化按计划时间记录
+ */
+static void run_script(const Action *actions, int count, uint32_t end, Timeline *timeline) {
+  ToneSequencer sequencer;
+  tone_sequencer_init(&sequencer);
+  memset(timeline, 0, sizeof(*timeline));
+  uint16_t output = 0;
+  uint32_t timerAt = 0;
+  bool timerArmed = false;
+  int next = 0;
+
+  uint32_t now = 0;
+  while (now <= end) {
+    // 下一次处理：脚本动作或定时器（加回调延迟）
+    uint32_t actionAt = next < count ? actions[next].at : UINT32_MAX;
+    uint32_t callbackAt = timerArmed ? timerAt + random_delay() : UINT32_MAX;
+    now = actionAt <= callbackAt ? actionAt : callbackAt;
+    if (now > end) {
+      break;
+    }
+
+    // 计划时间：定时器回调以定时器到期时间为准（实际输出晚同样的延迟）
+    uint32_t plannedAt = now;
+    int32_t wait;
+    if (actionAt <= callbackAt) {
+      const Action *action = &actions[next++];
+      if (action->stop) {
+        tone_sequencer_stop(&sequencer, action->id, now);
+      } else if (tone_sequencer_play(&sequencer, action->id, now) != action->expectStarted) {
+        printf("  %ums %s: 播放结果与预期不符\n", now, tone_pattern(action->id)->name);
+        timeline->failures++;
+      }
+      wait = tone_sequencer_advance(&sequencer, now);
+    } else {
+      timeline->callbacks++;
+      plannedAt = timerAt;
+      wait = tone_sequencer_advance(&sequencer, now);
+    }
+
+    // 记录变化：播放中按当前步骤开始时间，进入空闲按计划时间
+    record(timeline, &sequencer, &output, sequencer.pattern ? sequencer.stepStart : plannedAt);
+    if (!sequencer.pattern && timerArmed) {
+      timeline->idleAt = plannedAt;
+    }
+    timerArmed = wait != TONE_IDLE;
+    timerAt = now + (timerArmed ? (uint32_t)wait : 0);
+  }
+}
+
+/**
+ * 检查时间线：在t时刻的输出频率
+ */
+static uint16_t frequency_at(const Timeline *timeline, uint32_t t) {
+  uint16_t frequency = 0;
+  for (int i = 0; i < timeline->changeCount && timeline->changes[i].at <= t; i++) {
+    frequency = timeline->changes[i].frequency;
+  }
+  return frequency;
+}
+
+static int expect_frequency(const Timeline *timeline, uint32_t t, uint16_t frequency, const char *what) {
+  uint16_t actual = frequency_at(timeline, t);
+  if (actual != frequency) {
+    printf("  %ums %s: 频率%u，预期%u\n", t, what, actual, frequency);
+    return 0;
+  }
+  return 1;
+}
+
+/**
+ * 单个提示音：总时长 = 步骤时长之和 × 次数，最后一个变化为静音
+ */
+static int run_single(TonePatternId id) {
+  const TonePattern *pattern = tone_pattern(id);
+  uint32_t length = 0;
+  for (int i = 0; i < pattern->stepCount; i++) {
+    length += pattern->steps[i].duration;
+  }
+  int repeat = pattern->repeat == TONE_REPEAT_FOREVER ? 3 : pattern->repeat;
+  uint32_t total = length * repeat;
+
+  Action actions[2] = {{100, false, id, true}, {100 + total, true, id, false}};
+  Timeline timeline;
+  run_script(actions, pattern->repeat == TONE_REPEAT_FOREVER ? 2 : 1, 100 + total + 1000, &timeline);
+
+  uint32_t end = timeline.idleAt;
+  int ok = timeline.failures == 0 && frequency_at(&timeline, end) == 0 && end - 100 == total;
+
+  // 原实现：开关锁提示音 delay() 阻塞调用任务，报警在整个时长内忙等；门未关提示音原来没有
+  static const int legacyMs[TONE_PATTERN_COUNT] = {100, 200, 500, -1, 2000, 3000};
+  char legacy[16] = "-";
+  if (legacyMs[id] >= 0) {
+    snprintf(legacy, sizeof(legacy), "%d", legacyMs[id]);
+  }
+  printf("%-10s %4u %8u %8u %10u %10s %6s\n", pattern->name, pattern->priority, total, end - 100, timeline.callbacks,
+         legacy, ok ? "通过" : "失败");
+  return ok;
+}
+
+/**
+ * 优先级场景
+ *   0ms     门长时间未关（循环）
+ *   1500ms  拒绝访问 → 被拒绝（优先级低于门未关，仍处于门未关的静音间隔）
+ *   2500ms  防拆 → 打断门未关，3秒
+ *   3000ms  开锁 → 被拒绝
+ *   5500ms  防拆结束，门未关继续
+ *   6000ms  锁定 → 打断门未关，2秒
+ *   8000ms  锁定结束，门未关继续
+ *   9000ms  关门（停止门未关） → 空闲
+ *   9500ms  开锁 → 播放
+ */
+static int run_priority() {
+  Action actions[] = {
+    {0,    false, TONE_PATTERN_HELD_OPEN, true},
+    {1500, false, TONE_PATTERN_DENY,      false},
+    {2500, false, TONE_PATTERN_TAMPER,    true},
+    {3000, false, TONE_PATTERN_ACCEPT,    false},
+    {6000, false, TONE_PATTERN_LOCKOUT,   true},
+    {9000, true,  TONE_PATTERN_HELD_OPEN, false},
+    {9500, false, TONE_PATTERN_ACCEPT,    true},
+  };
+  Timeline timeline;
+  run_script(actions, sizeof(actions) / sizeof(actions[0]), 12000, &timeline);
+
+  int ok = timeline.failures == 0;
+  ok &= expect_frequency(&timeline, 100, 1000, "门未关");
+  ok &= expect_frequency(&timeline, 1550, 0, "拒绝访问被忽略");
+  ok &= expect_frequency(&timeline, 2600, 800, "防拆打断");
+  ok &= expect_frequency(&timeline, 2800, 1200, "防拆");
+  ok &= expect_frequency(&timeline, 3100, 800, "开锁被忽略");
+  ok &= expect_frequency(&timeline, 5600, 1000, "门未关继续");
+  ok &= expect_frequency(&timeline, 5900, 0, "门未关间隔");
+  ok &= expect_frequency(&timeline, 6100, 1000, "锁定");
+  ok &= expect_frequency(&timeline, 6300, 0, "锁定间隔");
+  ok &= expect_frequency(&timeline, 8100, 1000, "门未关继续");
+  ok &= expect_frequency(&timeline, 9100, 0, "关门后空闲");
+  ok &= expect_frequency(&timeline, 9550, 2000, "开锁");
+  ok &= expect_frequency(&timeline, 9700, 2600, "开锁第二声");
+  ok &= expect_frequency(&timeline, 9800, 0, "开锁结束");
+
+  printf("\n优先级场景时间线:\n");
+  for (int i = 0; i < timeline.changeCount; i++) {
+    printf("  %6ums %5uHz\n", timeline.changes[i].at, timeline.changes[i].frequency);
+  }
+  printf("优先级场景: %s\n", ok ? "通过" : "失败");
+  return ok;
+}
+
+int main() {
+  printf("%-10s %4s %8s %8s %10s %10s %6s\n", "提示音", "优先级", "计划时长", "实际时长", "定时器回调", "原阻塞(ms)",
+         "结果");
+  int ok = 1;
+  for (int i = 0; i < TONE_PATTERN_COUNT; i++) {
+    ok &= run_single((TonePatternId)i);
+  }
+  ok &= run_priority();
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,261 @@
+/*
+ * 跟踪点环形缓冲区主机测试
+ *
+ *   - 写入开销：单线程连续写入，每个跟踪点的耗时（设备上的开销由 access_trace_init 测量并在串口打印）
+ *   - 并发写入：多个线程同时写入一个环形缓冲区（模拟同一个核上的多个任务互相抢占），读取方同时读出，
+ *     检查读出的跟踪点没有撕裂（数据与序号一致）、读出数+丢弃数=写入数
+ *   - 串联统计：按刷卡路径生成各阶段间隔已知的跟踪，混入不属于跟踪的点（编号0、其他核的远程开门、
+ *     重复阶段），检查各阶段的次数与跟踪数一致，p50/p99与精确值的偏差不超过分桶宽度
+ *
+ * 编译运行（firmware 目录下）:
+ *   cc -O2 -pthread -Isrc tools/bench/trace_ring_bench.c src/modules/trace_ring.c -lm -o trace_ring_bench && ./trace_ring_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <math.h>
+
+#include "modules/trace_ring.h"
+
+// 检查项：每个跟踪点的写入耗时上限(ns)
+#define MAX_POINT_NS  1000
+
+// 检查项：百分位相对精确值的最大偏差（每倍程4个桶）
+#define MAX_PERCENTILE_ERROR  0.25
+
+#define WRITE_POINTS     (1 << 24)
+#define WRITER_THREADS   3
+#define WRITER_POINTS    100000
+#define CHAIN_TRACES     20000
+#define CYCLES_PER_US    240
+
+// 刷卡路径阶段（与 modules/access_trace.h 一致）
+enum { PRESENT, SELECTED, DEQUEUED, LOOKUP, DECISION, RELAY, RECORD, STAGE_COUNT };
+static const char *const stageNames[STAGE_COUNT] = {
+  "present", "select", "queue", "lookup", "decision", "relay", "record"
+};
+
+static double now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint32_t rng_state = 12345;
+static uint32_t rng() {
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+// 对数均匀分布的间隔(us)
+static uint32_t random_us(uint32_t low, uint32_t high) {
+  double ratio = (double)(rng() % 100000) / 100000;
+  return (uint32_t)(low * pow((double)high / low, ratio));
+}
+
+/**
+ * 写入开销
+ */
+static double bench_write() {
+  static TraceRing ring;
+  trace_ring_init(&ring);
+  double start = now_ns();
+  for (uint32_t i = 0; i < WRITE_POINTS; i++) {
+    trace_ring_push(&ring, i, (uint16_t)(i >> 3) | 1, i & 7);
+  }
+  return (now_ns() - start) / WRITE_POINTS;
+}
+
+// 并发写入：周期计数由编号和阶段推出，读出时校验
+typedef struct {
+  TraceRing *ring;
+  int id;
+} Writer;
+
+static uint32_t point_check(uint16_t trace, uint8_t stage) {
+  return (uint32_t)trace * 2654435761u ^ stage;
+}
+
+static volatile int writersDone = 0;
+
+static void *writer_thread(void *arg) {
+  Writer *writer = (Writer *)arg;
+  for (uint32_t i = 0; i < WRITER_POINTS; i++) {
+    uint16_t trace = (uint16_t)((i * WRITER_THREADS + writer->id) % 65535 + 1);
+    uint8_t stage = (uint8_t)(i % STAGE_COUNT);
+    trace_ring_push(writer->ring, point_check(trace, stage), trace, stage);
+
+    // 成批写入后让出处理器，读取方既有跟上的时候也有被覆盖的时候
+    if (i % 32 == 31) {
+      sched_yield();
+    }
+  }
+  __atomic_fetch_add(&writersDone, 1, __ATOMIC_RELEASE);
+  return NULL;
+}
+
+static int bench_concurrent(uint64_t *readOut, uint64_t *droppedOut) {
+  static TraceRing ring;
+  trace_ring_init(&ring);
+
+  pthread_t threads[WRITER_THREADS];
+  Writer writers[WRITER_THREADS];
+  for (int i = 0; i < WRITER_THREADS; i++) {
+    writers[i].ring = &ring;
+    writers[i].id = i;
+    pthread_create(&threads[i], NULL, writer_thread, &writers[i]);
+  }
+
+  TracePoint points[32];
+  uint64_t read = 0;
+  int torn = 0;
+  while (1) {
+    int done = __atomic_load_n(&writersDone, __ATOMIC_ACQUIRE) == WRITER_THREADS;
+    int count = trace_ring_drain(&ring, points, 32);
+    for (int i = 0; i < count; i++) {
+      if (points[i].cycles != point_check(points[i].trace, points[i].stage)) {
+        torn++;
+      }
+    }
+    read += count;
+    if (done && ring.tail == ring.head) {
+      break;
+    }
+  }
+  for (int i = 0; i < WRITER_THREADS; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  *readOut = read;
+  *droppedOut = ring.dropped;
+  return torn;
+}
+
+static int compare_u32(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a;
+  uint32_t y = *(const uint32_t *)b;
+  return x < y ? -1 : x > y;
+}
+
+static uint32_t exact_percentile(uint32_t *values, int count, uint32_t percent) {
+  qsort(values, count, sizeof(uint32_t), compare_u32);
+  int index = (int)(((uint64_t)count * percent + 99) / 100) - 1;
+  return values[index < 0 ? 0 : index];
+}
+
+/**
+ * 串联统计：环形缓冲区按通信任务的周期读出（每读出一次写入若干跟踪）
+ */
+static int bench_chain() {
+  // 各阶段与上一阶段的间隔范围(us)
+  static const uint32_t ranges[STAGE_COUNT][2] = {
+    {1, 1}, {300, 3000}, {5, 400}, {2, 60}, {1, 20}, {10, 200}, {500, 40000}
+  };
+  static uint32_t exact[STAGE_COUNT][CHAIN_TRACES];
+  static uint32_t exactTotal[CHAIN_TRACES];
+  int exactCount[STAGE_COUNT] = {0};
+  int totalCount = 0;
+
+  static TraceRing ring;
+  static TracePoint points[TRACE_RING_SIZE];
+  TraceChain chain;
+  TraceHistogram segments[STAGE_COUNT];
+  TraceHistogram total;
+  trace_ring_init(&ring);
+  trace_chain_init(&chain);
+  memset(segments, 0, sizeof(segments));
+  memset(&total, 0, sizeof(total));
+
+  uint32_t cycles = 0xFFF00000u;  // 跨越周期计数回绕
+  for (int trace = 1; trace <= CHAIN_TRACES; trace++) {
+    bool denied = rng() % 5 == 0;
+    uint32_t start = cycles;
+    trace_ring_push(&ring, cycles, trace, PRESENT);
+    for (int stage = SELECTED; stage < STAGE_COUNT; stage++) {
+      if (stage == RELAY && denied) {
+        continue;
+      }
+      uint32_t us = random_us(ranges[stage][0], ranges[stage][1]);
+      cycles += us * CYCLES_PER_US;
+      exact[stage][exactCount[stage]++] = us;
+      trace_ring_push(&ring, cycles, trace, stage);
+      if (stage == RELAY) {
+        exactTotal[totalCount++] = (cycles - start) / CYCLES_PER_US;
+      }
+
+      // 不属于跟踪的点
+      if (stage == DEQUEUED && rng() % 4 == 0) {
+        trace_ring_push(&ring, cycles + 5, 0, DECISION);
+      }
+      if (stage == LOOKUP && rng() % 8 == 0) {
+        trace_ring_push(&ring, cycles + 7, trace, LOOKUP);
+      }
+    }
+    // 上一跟踪结束后其他方式开锁（编号仍为该跟踪时也不计入）
+    if (rng() % 6 == 0) {
+      trace_ring_push(&ring, cycles + 100, trace, RELAY);
+    }
+    cycles += random_us(100000, 2000000) * CYCLES_PER_US;
+
+    if (trace % 8 == 0 || trace == CHAIN_TRACES) {
+      int count = trace_ring_drain(&ring, points, TRACE_RING_SIZE);
+      for (int i = 0; i < count; i++) {
+        trace_chain_feed(&chain, &points[i], PRESENT, RELAY, CYCLES_PER_US, segments, &total);
+      }
+    }
+  }
+
+  int ok = 1;
+  printf("%-10s %8s %8s %8s %8s %8s %8s\n", "阶段", "次数", "p50", "精确", "p99", "精确", "最大");
+  for (int stage = SELECTED; stage <= STAGE_COUNT; stage++) {
+    const TraceHistogram *histogram = stage < STAGE_COUNT ? &segments[stage] : &total;
+    uint32_t *values = stage < STAGE_COUNT ? exact[stage] : exactTotal;
+    int count = stage < STAGE_COUNT ? exactCount[stage] : totalCount;
+
+    uint32_t p50 = trace_histogram_percentile(histogram, 50);
+    uint32_t p99 = trace_histogram_percentile(histogram, 99);
+    uint32_t exact50 = exact_percentile(values, count, 50);
+    uint32_t exact99 = exact_percentile(values, count, 99);
+    printf("%-10s %8u %8u %8u %8u %8u %8u\n", stage < STAGE_COUNT ? stageNames[stage] : "card_to_relay",
+           histogram->count, p50, exact50, p99, exact99, histogram->maxUs);
+
+    if ((int)histogram->count != count || p50 < exact50 || p99 < exact99 ||
+        p50 > exact50 * (1 + MAX_PERCENTILE_ERROR) + 1 || p99 > exact99 * (1 + MAX_PERCENTILE_ERROR) + 1) {
+      printf("%s: 统计与精确值不一致\n", stage < STAGE_COUNT ? stageNames[stage] : "card_to_relay");
+      ok = 0;
+    }
+  }
+  return ok;
+}
+
+int main() {
+  int ok = 1;
+
+  double pointNs = bench_write();
+  printf("单线程写入: %.1f ns/跟踪点\n", pointNs);
+  if (pointNs > MAX_POINT_NS) {
+    printf("写入开销超过 %d ns\n", MAX_POINT_NS);
+    ok = 0;
+  }
+
+  uint64_t read, dropped;
+  int torn = bench_concurrent(&read, &dropped);
+  uint64_t written = (uint64_t)WRITER_THREADS * WRITER_POINTS;
+  printf("并发写入: %d个线程写入%llu，读出%llu，丢弃%llu，撕裂%d\n", WRITER_THREADS, (unsigned long long)written,
+         (unsigned long long)read, (unsigned long long)dropped, torn);
+  if (torn > 0 || read + dropped != written) {
+    printf("并发写入: 未达到要求\n");
+    ok = 0;
+  }
+
+  if (!bench_chain()) {
+    ok = 0;
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,144 @@
+"""
+人脸特征增量下发替身后台
+
+后台在 access_methods 表登记人脸（method_type = face）后，把特征广播给门禁控制器，
+设备插入近似最近邻索引并记入SD卡日志。协议与 firmware/src/modules/face_sync.h 保持一致：
+
+    后台 -> 全部  access-control/face/delta   {"op": "add", "user_id", "method_id", "embedding"}
+                                              {"op": "delete", "user_id"}
+    设备 -> 后台  access-control/face/report  {"device_id", "op", "user_id", "method_id", "result", "face_count"}
+
+method_value 为 128 字节 int8 特征（face_embed 输出）的 Base64，共 172 个字符（列长 255）。
+
+用法（本地 Mosquitto）:
+    python face_sync.py add --user 7 --method 12 --embedding CvMb...
+    python face_sync.py add --user 7 --method 12 --embedding-file face7.bin
+    python face_sync.py delete --user 7
+    python face_sync.py watch                         # 打印设备上报
+"""
+
+import argparse
+import base64
+import binascii
+import json
+import sys
+
+# 主题（与 face_sync.h 一致）
+TOPIC_DELTA = "access-control/face/delta"
+TOPIC_REPORT = "access-control/face/report"
+
+# 特征维数（FACE_EMBEDDING_DIM）
+EMBEDDING_DIM = 128
+
+
+def access_method_message(method):
+    """
+    access_methods 记录（AccessMethod.to_dict()）转换为下发消息
+    非人脸或未启用的记录返回 None
+    """
+    if method.get("method_type") != "face" or method.get("status", "active") != "active":
+        return None
+    embedding = method["method_value"].strip()
+    try:
+        size = len(base64.b64decode(embedding, validate=True))
+    except binascii.Error:
+        size = -1
+    if size != EMBEDDING_DIM:
+        raise ValueError(f"人脸特征应为 {EMBEDDING_DIM} 字节的Base64: method_id={method.get('id')}")
+    return {"op": "add", "user_id": method["user_id"], "method_id": method["id"], "embedding": embedding}
+
+
+def encode(message):
+    return json.dumps(message, ensure_ascii=False, separators=(",", ":"))
+
+
+def connect(args):
+    """连接MQTT服务器（兼容 paho-mqtt 1.x / 2.x）"""
+    import paho.mqtt.client as mqtt
+
+    if hasattr(mqtt, "CallbackAPIVersion"):
+        client = mqtt.Client(mqtt.CallbackAPIVersion.VERSION1, client_id=args.client_id)
+    else:
+        client = mqtt.Client(client_id=args.client_id)
+    if args.username:
+        client.username_pw_set(args.username, args.password)
+    client.connect(args.host, args.port)
+    return client
+
+
+def publish(args, message):
+    print(encode(message))
+    if args.no_publish:
+        return
+    client = connect(args)
+    client.loop_start()
+    client.publish(TOPIC_DELTA, encode(message), qos=1).wait_for_publish()
+    client.loop_stop()
+    client.disconnect()
+
+
+def cmd_add(args):
+    if args.embedding_file:
+        with open(args.embedding_file, "rb") as f:
+            value = base64.b64encode(f.read()).decode("ascii")
+    else:
+        value = args.embedding or ""
+    method = {"id": args.method, "user_id": args.user, "method_type": "face", "method_value": value}
+    try:
+        message = access_method_message(method)
+    except ValueError as e:
+        print(e, file=sys.stderr)
+        return 1
+    publish(args, message)
+    return 0
+
+
+def cmd_delete(args):
+    publish(args, {"op": "delete", "user_id": args.user})
+    return 0
+
+
+def cmd_watch(args):
+    client = connect(args)
+
+    def on_message(client, userdata, msg):
+        print(msg.payload.decode("utf-8", "replace"))
+
+    client.on_message = on_message
+    client.subscribe(TOPIC_REPORT, qos=1)
+    print(f"监听 {TOPIC_REPORT}")
+    client.loop_forever()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="人脸特征增量下发替身后台")
+    parser.add_argument("--host", default="localhost")
+    parser.add_argument("--port", type=int, default=1883)
+    parser.add_argument("--username")
+    parser.add_argument("--password", help="MQTT密码")
+    parser.add_argument("--client-id", default="face-sync-backend")
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    add = sub.add_parser("add", help="下发一条人脸特征")
+    add.add_argument("--user", type=int, required=True, help="用户ID")
+    add.add_argument("--method", type=int, default=0, help="access_methods 记录ID")
+    add.add_argument("--embedding", help="Base64特征")
+    add.add_argument("--embedding-file", help="128字节特征文件")
+    add.add_argument("--no-publish", action="store_true", help="只打印消息，不广播")
+
+    delete = sub.add_parser("delete", help="删除用户的全部人脸特征")
+    delete.add_argument("--user", type=int, required=True, help="用户ID")
+    delete.add_argument("--no-publish", action="store_true", help="只打印消息，不广播")
+
+    sub.add_parser("watch", help="打印设备上报")
+
+    args = parser.parse_args()
+    if args.command == "add":
+        return cmd_add(args)
+    if args.command == "delete":
+        return cmd_delete(args)
+    return cmd_watch(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,239 @@
+"""
+时间表编译工具
+
+把按星期/时段描述的门禁时间表编译为固件使用的位图文件（SD卡 /schedules.bin），
+并输出用户到时间表ID的对照表。格式与 firmware/src/modules/schedule.h 保持一致。
+
+输入JSON:
+    {
+      "version": 3,
+      "schedules": {
+        "office":     [{"days": "mon-fri", "start": "08:00", "end": "18:00"}],
+        "contractor": {"rules": [{"days": "sat,sun", "start": "09:00", "end": "17:00"}],
+                       "holiday": [{"start": "09:00", "end": "12:00"}]},
+        "night":      [{"days": "daily", "start": "22:00", "end": "06:00"}]
+      },
+      "users": {
+        "7": "office",
+        "8": [{"days": "mon", "start": "10:00", "end": "11:30"}]
+      },
+      "overrides": [
+        {"date": "2026-10-01", "as": "holiday"},
+        {"date": "2026-10-11", "as": "mon"}
+      ]
+    }
+
+schedules 为按组共享的时间表，users 可引用组名或给出个人时间表；内容相同的位图只保留一份。
+未列出的用户时间表ID为0（不限时间）。节假日默认不开放，holiday 给出节假日当天的开放时段。
+overrides 把指定日期改用节假日行或某个星期的行（调休上班）。
+
+用法:
+    python schedule_compiler.py compile schedules.json -o schedules.bin --assignments schedule_users.json
+    python schedule_compiler.py check schedules.bin --schedule-id 1 --at "2026-10-01 09:30"
+
+schedule_users.json 可直接传给 userdb_image.py build --schedules。
+"""
+
+import argparse
+import datetime
+import json
+import struct
+import sys
+import zlib
+
+# 文件格式常量（与 schedule.h 一致）
+SCHEDULE_MAGIC = 0x44484353
+SCHEDULE_FORMAT_VERSION = 1
+SLOT_MINUTES = 15
+SLOTS_PER_DAY = 96
+ROWS = 8
+HOLIDAY_ROW = 7
+SLOTS = ROWS * SLOTS_PER_DAY
+WORDS = SLOTS // 32
+MAX_SCHEDULES = 255
+
+HEADER_FORMAT = "<IHHIHHI"
+HEADER_SIZE = struct.calcsize(HEADER_FORMAT)
+CRC_OFFSET = HEADER_SIZE - 4
+OVERRIDE_FORMAT = "<HBx"
+
+DAY_NAMES = ["mon", "tue", "wed", "thu", "fri", "sat", "sun"]
+EPOCH = datetime.date(1970, 1, 1)
+
+
+def parse_days(spec):
+    """解析星期：mon-fri / sat,sun / daily / 列表"""
+    if isinstance(spec, list):
+        parts = spec
+    elif spec in ("daily", "all"):
+        return list(range(7))
+    else:
+        parts = [p.strip() for p in spec.split(",")]
+
+    days = []
+    for part in parts:
+        if "-" in part:
+            first, last = (DAY_NAMES.index(p) for p in part.split("-"))
+            days.extend(range(first, last + 1))
+        else:
+            days.append(DAY_NAMES.index(part))
+    return days
+
+
+def parse_slot(text):
+    """解析时刻为时段下标，须对齐到15分钟"""
+    hour, minute = (int(p) for p in text.split(":"))
+    minutes = hour * 60 + minute
+    if minutes % SLOT_MINUTES or not 0 <= minutes <= 24 * 60:
+        raise ValueError(f"时刻须对齐到{SLOT_MINUTES}分钟: {text}")
+    return minutes // SLOT_MINUTES
+
+
+def mark(bits, row, start, end):
+    """置位一段时段，结束早于开始时跨到次日"""
+    if end > start:
+        for slot in range(start, end):
+            bits[row * SLOTS_PER_DAY + slot] = 1
+        return
+    next_row = (row + 1) % 7 if row < 7 else row
+    for slot in range(start, SLOTS_PER_DAY):
+        bits[row * SLOTS_PER_DAY + slot] = 1
+    for slot in range(0, end):
+        bits[next_row * SLOTS_PER_DAY + slot] = 1
+
+
+def compile_schedule(spec):
+    """编译单个时间表为位图字节串"""
+    if isinstance(spec, list):
+        spec = {"rules": spec}
+
+    bits = [0] * SLOTS
+    for rule in spec.get("rules", []):
+        start, end = parse_slot(rule["start"]), parse_slot(rule["end"])
+        for day in parse_days(rule.get("days", "daily")):
+            mark(bits, day, start, end)
+    for rule in spec.get("holiday", []):
+        mark(bits, HOLIDAY_ROW, parse_slot(rule["start"]), parse_slot(rule["end"]))
+
+    words = []
+    for w in range(WORDS):
+        value = 0
+        for b in range(32):
+            value |= bits[w * 32 + b] << b
+        words.append(value)
+    return struct.pack(f"<{WORDS}I", *words)
+
+
+def compile_config(config):
+    """编译配置，返回 (文件内容, 用户对照表, 时间表名称对照)"""
+    bitmaps = []
+    bitmap_ids = {}
+
+    def intern(bitmap):
+        if bitmap not in bitmap_ids:
+            if len(bitmaps) >= MAX_SCHEDULES:
+                raise ValueError(f"不同时间表超过{MAX_SCHEDULES}个")
+            bitmaps.append(bitmap)
+            bitmap_ids[bitmap] = len(bitmaps)
+        return bitmap_ids[bitmap]
+
+    named = {name: intern(compile_schedule(spec)) for name, spec in config.get("schedules", {}).items()}
+
+    assignments = {}
+    for user_id, spec in config.get("users", {}).items():
+        if isinstance(spec, str):
+            if spec not in named:
+                raise ValueError(f"用户 {user_id} 引用了未定义的时间表: {spec}")
+            assignments[str(int(user_id))] = named[spec]
+        else:
+            assignments[str(int(user_id))] = intern(compile_schedule(spec))
+
+    overrides = {}
+    for entry in config.get("overrides", []):
+        day = (datetime.date.fromisoformat(entry["date"]) - EPOCH).days
+        row = HOLIDAY_ROW if entry["as"] == "holiday" else DAY_NAMES.index(entry["as"])
+        overrides[day] = row
+
+    body = b"".join(bitmaps)
+    body += b"".join(struct.pack(OVERRIDE_FORMAT, day, overrides[day]) for day in sorted(overrides))
+
+    header = struct.pack(HEADER_FORMAT, SCHEDULE_MAGIC, SCHEDULE_FORMAT_VERSION, HEADER_SIZE,
+                         int(config.get("version", 1)), len(bitmaps), len(overrides), 0)
+    crc = zlib.crc32(body, zlib.crc32(header[:CRC_OFFSET]))
+    return header[:CRC_OFFSET] + struct.pack("<I", crc) + body, assignments, named
+
+
+def parse_file(data):
+    """解析时间表文件，返回 (版本, 位图列表, 日期覆盖)"""
+    magic, fmt, header_size, version, count, override_count, crc = struct.unpack_from(HEADER_FORMAT, data)
+    if magic != SCHEDULE_MAGIC or fmt != SCHEDULE_FORMAT_VERSION:
+        raise ValueError("时间表文件格式无效")
+    if zlib.crc32(data[header_size:], zlib.crc32(data[:CRC_OFFSET])) != crc:
+        raise ValueError("时间表文件CRC错误")
+
+    offset = header_size
+    bitmaps = []
+    for _ in range(count):
+        bitmaps.append(struct.unpack_from(f"<{WORDS}I", data, offset))
+        offset += WORDS * 4
+    overrides = {}
+    for _ in range(override_count):
+        day, row = struct.unpack_from(OVERRIDE_FORMAT, data, offset)
+        overrides[day] = row
+        offset += struct.calcsize(OVERRIDE_FORMAT)
+    return version, bitmaps, overrides
+
+
+def is_allowed(bitmaps, overrides, schedule_id, when):
+    """按固件相同规则判定某一时刻"""
+    if schedule_id == 0:
+        return True
+    if schedule_id > len(bitmaps):
+        return False
+    day = (when.date() - EPOCH).days
+    row = overrides.get(day, when.weekday())
+    slot = row * SLOTS_PER_DAY + (when.hour * 60 + when.minute) // SLOT_MINUTES
+    return bool((bitmaps[schedule_id - 1][slot >> 5] >> (slot & 31)) & 1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="时间表编译工具")
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    build = sub.add_parser("compile", help="编译时间表")
+    build.add_argument("config", help="时间表JSON")
+    build.add_argument("-o", "--output", required=True, help="输出文件")
+    build.add_argument("--assignments", help="输出用户到时间表ID的对照表")
+
+    check = sub.add_parser("check", help="查询某一时刻是否允许")
+    check.add_argument("file", help="时间表文件")
+    check.add_argument("--schedule-id", type=int, required=True)
+    check.add_argument("--at", required=True, help="本地时间，如 2026-10-01 09:30")
+
+    args = parser.parse_args()
+
+    if args.command == "compile":
+        with open(args.config, encoding="utf-8") as f:
+            config = json.load(f)
+        data, assignments, named = compile_config(config)
+        with open(args.output, "wb") as f:
+            f.write(data)
+        if args.assignments:
+            with open(args.assignments, "w", encoding="utf-8") as f:
+                json.dump(assignments, f, indent=2)
+        print(f"已生成: {args.output}（{len(data)} 字节）")
+        for name, schedule_id in named.items():
+            print(f"  {name}: {schedule_id}")
+        print(f"  个人时间表用户: {len(assignments)}")
+        return 0
+
+    with open(args.file, "rb") as f:
+        version, bitmaps, overrides = parse_file(f.read())
+    when = datetime.datetime.strptime(args.at, "%Y-%m-%d %H:%M")
+    allowed = is_allowed(bitmaps, overrides, args.schedule_id, when)
+    print(f"版本 {version}: 时间表 {args.schedule_id} 在 {args.at} {'允许' if allowed else '拒绝'}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
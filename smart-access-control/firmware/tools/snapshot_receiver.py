@@ -0,0 +1,156 @@
+"""
+事件录像接收替身后台
+
+订阅门禁控制器上传的事件录像，按事件保存JPEG并打印每帧的接收耗时和吞吐量。
+协议与 firmware/src/modules/event_capture.h、communication.h 保持一致：
+
+    设备 -> 后台  access-control/snapshot/event                        {"device_id", "event_id", "type", "frames": [...]}
+    设备 -> 后台  access-control/snapshot/frame/<设备ID>/<事件编号>/<帧序号>  JPEG，或带分片头的分片
+
+代理限制单条消息大小时（set_max_packet 命令），设备把一帧分成多条消息，每条负载以
+24字节分片头开头（小端）：magic "CHNK"、transfer_id、total_length、offset、index、count、crc32。
+接收方按 transfer_id 收齐 count 个分片后拼接并校验整帧CRC32。整条发布的帧直接是JPEG。
+
+用法（本地 Mosquitto）:
+    python snapshot_receiver.py watch --out snapshots
+    python snapshot_receiver.py set-max-packet --bytes 4096     # 0 表示不限
+"""
+
+import argparse
+import json
+import os
+import struct
+import sys
+import time
+import zlib
+
+# 主题（与 event_capture.h 一致）
+TOPIC_EVENT = "access-control/snapshot/event"
+TOPIC_FRAME = "access-control/snapshot/frame/"
+TOPIC_COMMAND = "access-control/command"
+
+# 分片头（与 communication.h 中 FrameChunkHeader 一致）
+CHUNK_MAGIC = 0x4B4E4843
+CHUNK_HEADER = struct.Struct("<IIIIHHI")
+
+
+class Reassembler:
+    """按传输编号拼接分片"""
+
+    def __init__(self):
+        self.transfers = {}
+
+    def add(self, key, payload):
+        """
+        加入一条消息，帧完整时返回 (数据, 消息数, 首条消息时间)，否则返回 None
+        分片CRC不一致时抛出 ValueError
+        """
+        now = time.monotonic()
+        if len(payload) < CHUNK_HEADER.size or struct.unpack_from("<I", payload)[0] != CHUNK_MAGIC:
+            return payload, 1, now
+
+        magic, transfer_id, total, offset, index, count, crc = CHUNK_HEADER.unpack_from(payload)
+        transfer = self.transfers.setdefault((key, transfer_id), {"data": bytearray(total), "parts": set(), "start": now})
+        body = payload[CHUNK_HEADER.size:]
+        if offset + len(body) > total:
+            raise ValueError(f"分片越界: transfer={transfer_id} index={index}")
+        transfer["data"][offset:offset + len(body)] = body
+        transfer["parts"].add(index)
+        if len(transfer["parts"]) < count:
+            return None
+
+        del self.transfers[(key, transfer_id)]
+        data = bytes(transfer["data"])
+        if zlib.crc32(data) != crc:
+            raise ValueError(f"整帧CRC不一致: transfer={transfer_id}")
+        return data, count, transfer["start"]
+
+
+def connect(args):
+    """连接MQTT服务器（兼容 paho-mqtt 1.x / 2.x）"""
+    import paho.mqtt.client as mqtt
+
+    if hasattr(mqtt, "CallbackAPIVersion"):
+        client = mqtt.Client(mqtt.CallbackAPIVersion.VERSION1, client_id=args.client_id)
+    else:
+        client = mqtt.Client(client_id=args.client_id)
+    if args.username:
+        client.username_pw_set(args.username, args.password)
+    client.connect(args.host, args.port)
+    return client
+
+
+def cmd_watch(args):
+    client = connect(args)
+    reassembler = Reassembler()
+
+    def on_message(client, userdata, msg):
+        if msg.topic == TOPIC_EVENT:
+            event = json.loads(msg.payload)
+            directory = os.path.join(args.out, event["device_id"], str(event["event_id"]))
+            os.makedirs(directory, exist_ok=True)
+            with open(os.path.join(directory, "event.json"), "w", encoding="utf-8") as f:
+                json.dump(event, f, ensure_ascii=False, indent=2)
+            print(f"事件 {event['event_id']}: {event['type']}，{len(event['frames'])} 帧"
+                  f"（触发前 {event['pre_frames']} 帧，丢弃 {event['dropped']} 帧）")
+            return
+
+        device_id, event_id, index = msg.topic[len(TOPIC_FRAME):].split("/")
+        try:
+            frame = reassembler.add((device_id, event_id, index), msg.payload)
+        except ValueError as e:
+            print(e, file=sys.stderr)
+            return
+        if frame is None:
+            return
+        data, messages, start = frame
+        elapsed = time.monotonic() - start
+        directory = os.path.join(args.out, device_id, event_id)
+        os.makedirs(directory, exist_ok=True)
+        with open(os.path.join(directory, f"{int(index):02d}.jpg"), "wb") as f:
+            f.write(data)
+        rate = f"，{len(data) * 8 / elapsed / 1000:.0f} kbps" if messages > 1 and elapsed > 0 else ""
+        print(f"  帧 {event_id}/{index}: {len(data)} 字节，{messages} 条消息{rate}")
+
+    client.on_message = on_message
+    client.subscribe(TOPIC_EVENT, qos=0)
+    client.subscribe(TOPIC_FRAME + "#", qos=0)
+    print(f"监听 {TOPIC_EVENT}，保存到 {args.out}")
+    client.loop_forever()
+
+
+def cmd_set_max_packet(args):
+    message = json.dumps({"command": "set_max_packet", "device_id": args.device, "bytes": args.bytes})
+    print(message)
+    client = connect(args)
+    client.loop_start()
+    client.publish(TOPIC_COMMAND, message, qos=1).wait_for_publish()
+    client.loop_stop()
+    client.disconnect()
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="事件录像接收替身后台")
+    parser.add_argument("--host", default="localhost")
+    parser.add_argument("--port", type=int, default=1883)
+    parser.add_argument("--username")
+    parser.add_argument("--password", help="MQTT密码")
+    parser.add_argument("--client-id", default="snapshot-receiver")
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    watch = sub.add_parser("watch", help="接收并保存事件录像")
+    watch.add_argument("--out", default="snapshots", help="保存目录")
+
+    limit = sub.add_parser("set-max-packet", help="设置设备的代理单条消息上限")
+    limit.add_argument("--bytes", type=int, required=True, help="MQTT报文上限，0表示不限")
+    limit.add_argument("--device", default="ESP32-ACCESS-CONTROL-001", help="设备ID")
+
+    args = parser.parse_args()
+    if args.command == "watch":
+        return cmd_watch(args)
+    return cmd_set_max_packet(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
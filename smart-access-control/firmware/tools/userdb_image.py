@@ -0,0 +1,276 @@
+"""
+二进制用户库镜像工具
+
+由后台 users / access_methods 表生成固件 userdb 分区镜像，并可校验已有镜像。
+镜像格式与 firmware/src/modules/user_db.h 保持一致。
+
+用法:
+    python userdb_image.py build -o userdb.bin --db-version 42
+    python userdb_image.py build -o userdb.bin --json users.json
+    python userdb_image.py build -o userdb.bin --db-version 42 --schedules schedule_users.json
+    python userdb_image.py validate userdb.bin
+
+烧录（偏移见 partitions.csv）:
+    esptool.py write_flash 0x310000 userdb.bin
+"""
+
+import argparse
+import hashlib
+import json
+import os
+import struct
+import sys
+import zlib
+
+# 镜像格式常量（与 user_db.h 一致）
+USER_DB_MAGIC = 0x31424455
+USER_DB_FORMAT_VERSION = 1
+USER_DB_PAGE_SIZE = 4096
+USER_DB_PARTITION_SIZE = 0xF0000
+USER_DB_SALT_SIZE = 16
+USER_DB_FLAG_ENABLED = 0x01
+
+HEADER_FORMAT = "<IHH" + "I" * 10 + "16sI"
+HEADER_SIZE = struct.calcsize(HEADER_FORMAT)
+CRC_OFFSET = HEADER_SIZE - 4
+
+USER_FORMAT = "<IBB2x"
+CARD_FORMAT = "<12sI"
+FINGERPRINT_FORMAT = "<II"
+PASSWORD_FORMAT = "<32sI"
+
+UID_SIZES = (4, 7, 10)
+
+
+def card_key(hex_uid):
+    """十六进制卡号转换为12字节卡号键（长度字节 + UID + 补零）"""
+    uid = bytes.fromhex(hex_uid)
+    if len(uid) not in UID_SIZES:
+        raise ValueError(f"卡号长度无效: {hex_uid}")
+    return bytes([len(uid)]) + uid.ljust(11, b"\0")
+
+
+def pin_digest(salt, pin):
+    """计算加盐密码摘要"""
+    return hashlib.sha256(salt + pin.encode("utf-8")).digest()
+
+
+def load_rows_from_database(database_url):
+    """从后台数据库读取用户及访问方式"""
+    from sqlalchemy import create_engine, text
+
+    engine = create_engine(database_url)
+    query = text(
+        "SELECT u.id, u.status, m.method_type, m.method_value, m.status "
+        "FROM users u LEFT JOIN access_methods m ON m.user_id = u.id "
+        "ORDER BY u.id"
+    )
+    with engine.connect() as conn:
+        return [tuple(row) for row in conn.execute(query)]
+
+
+def load_rows_from_json(path):
+    """从导出的JSON读取用户及访问方式
+
+    格式: [{"id": 1, "status": "active",
+            "access_methods": [{"method_type": "card", "method_value": "12345678", "status": "active"}]}]
+    """
+    with open(path, "r", encoding="utf-8") as f:
+        users = json.load(f)
+
+    rows = []
+    for user in users:
+        methods = user.get("access_methods") or [None]
+        for method in methods:
+            if method is None:
+                rows.append((user["id"], user.get("status", "active"), None, None, None))
+            else:
+                rows.append((user["id"], user.get("status", "active"),
+                             method["method_type"], method["method_value"],
+                             method.get("status", "active")))
+    return rows
+
+
+def align(offset):
+    """按页对齐"""
+    return (offset + USER_DB_PAGE_SIZE - 1) // USER_DB_PAGE_SIZE * USER_DB_PAGE_SIZE
+
+
+def build_image(rows, db_version, salt=None, schedules=None):
+    """生成镜像，schedules 为用户ID到时间表ID的对照（schedule_compiler.py 输出）"""
+    salt = salt if salt is not None else os.urandom(USER_DB_SALT_SIZE)
+    schedules = schedules or {}
+
+    # 用户表按ID升序
+    user_status = {}
+    for user_id, status, _, _, _ in rows:
+        user_status[user_id] = status
+    user_ids = sorted(user_status)
+    user_index = {user_id: i for i, user_id in enumerate(user_ids)}
+
+    cards = {}
+    fingerprints = {}
+    passwords = {}
+    for user_id, _, method_type, method_value, method_status in rows:
+        if method_type is None or method_status != "active":
+            continue
+
+        index = user_index[user_id]
+        if method_type == "card":
+            key = card_key(method_value)
+            if key in cards:
+                raise ValueError(f"卡号重复: {method_value}")
+            cards[key] = index
+        elif method_type == "fingerprint":
+            fingerprint_id = int(method_value)
+            if fingerprint_id in fingerprints:
+                raise ValueError(f"指纹ID重复: {fingerprint_id}")
+            fingerprints[fingerprint_id] = index
+        elif method_type == "password":
+            if not method_value.isdigit():
+                print(f"跳过用户 {user_id} 的密码：需为明文数字PIN", file=sys.stderr)
+                continue
+            digest = pin_digest(salt, method_value)
+            if digest in passwords:
+                print(f"用户 {user_id} 的密码与其他用户重复，保留先出现的用户", file=sys.stderr)
+                continue
+            passwords[digest] = index
+
+    # 分段布局
+    sections = [
+        (b"".join(struct.pack(USER_FORMAT, user_id,
+                              USER_DB_FLAG_ENABLED if user_status[user_id] == "active" else 0,
+                              schedules.get(user_id, 0))
+                  for user_id in user_ids), len(user_ids)),
+        (b"".join(struct.pack(CARD_FORMAT, key, cards[key]) for key in sorted(cards)), len(cards)),
+        (b"".join(struct.pack(FINGERPRINT_FORMAT, fid, fingerprints[fid])
+                  for fid in sorted(fingerprints)), len(fingerprints)),
+        (b"".join(struct.pack(PASSWORD_FORMAT, digest, passwords[digest])
+                  for digest in sorted(passwords)), len(passwords)),
+    ]
+
+    body = bytearray()
+    offsets = []
+    for data, _ in sections:
+        offset = align(HEADER_SIZE + len(body))
+        body.extend(b"\xff" * (offset - HEADER_SIZE - len(body)))
+        offsets.append(offset)
+        body.extend(data)
+
+    image_size = HEADER_SIZE + len(body)
+    if image_size > USER_DB_PARTITION_SIZE:
+        raise ValueError(f"镜像超出分区大小: {image_size} > {USER_DB_PARTITION_SIZE}")
+
+    fields = [USER_DB_MAGIC, USER_DB_FORMAT_VERSION, HEADER_SIZE, db_version, image_size]
+    for (_, count), offset in zip(sections, offsets):
+        fields.extend([count, offset])
+    header = struct.pack(HEADER_FORMAT, *fields, salt, 0)
+
+    crc = zlib.crc32(header[:CRC_OFFSET])
+    crc = zlib.crc32(body, crc)
+    return header[:CRC_OFFSET] + struct.pack("<I", crc) + bytes(body)
+
+
+def validate_image(image):
+    """校验镜像，返回错误列表"""
+    if len(image) < HEADER_SIZE:
+        return ["镜像长度不足"]
+
+    (magic, format_version, header_size, db_version, image_size,
+     user_count, user_offset, card_count, card_offset,
+     fingerprint_count, fingerprint_offset, password_count, password_offset,
+     salt, crc) = struct.unpack_from(HEADER_FORMAT, image)
+
+    if magic != USER_DB_MAGIC:
+        return ["镜像标识无效"]
+    if format_version != USER_DB_FORMAT_VERSION or header_size != HEADER_SIZE:
+        return [f"镜像格式不支持: {format_version}"]
+    if image_size > len(image) or image_size > USER_DB_PARTITION_SIZE:
+        return ["镜像长度无效"]
+
+    errors = []
+    actual = zlib.crc32(image[header_size:image_size], zlib.crc32(image[:CRC_OFFSET]))
+    if actual != crc:
+        errors.append(f"CRC错误: 0x{actual:08X} != 0x{crc:08X}")
+
+    def entries(name, fmt, offset, count):
+        size = struct.calcsize(fmt)
+        if count and (offset < header_size or offset % USER_DB_PAGE_SIZE
+                      or offset + count * size > image_size):
+            errors.append(f"{name}分段越界")
+            return []
+        return [struct.unpack_from(fmt, image, offset + i * size) for i in range(count)]
+
+    def check_sorted(name, keys):
+        if any(a >= b for a, b in zip(keys, keys[1:])):
+            errors.append(f"{name}未严格升序")
+
+    users = entries("用户", USER_FORMAT, user_offset, user_count)
+    check_sorted("用户", [u[0] for u in users])
+
+    for name, fmt, offset, count in (("卡号", CARD_FORMAT, card_offset, card_count),
+                                     ("指纹", FINGERPRINT_FORMAT, fingerprint_offset, fingerprint_count),
+                                     ("密码", PASSWORD_FORMAT, password_offset, password_count)):
+        items = entries(name, fmt, offset, count)
+        check_sorted(name, [item[0] for item in items])
+        if any(item[1] >= user_count for item in items):
+            errors.append(f"{name}条目用户下标越界")
+        if name == "卡号" and any(item[0][0] not in UID_SIZES for item in items):
+            errors.append("卡号长度无效")
+
+    print(f"版本={db_version} 大小={image_size} 用户={user_count} 卡={card_count} "
+          f"指纹={fingerprint_count} 密码={password_count}")
+    return errors
+
+
+def main():
+    parser = argparse.ArgumentParser(description="二进制用户库镜像工具")
+    subparsers = parser.add_subparsers(dest="command", required=True)
+
+    build = subparsers.add_parser("build", help="生成镜像")
+    build.add_argument("-o", "--output", required=True, help="输出文件")
+    build.add_argument("--db-version", type=int, required=True, help="用户库版本")
+    build.add_argument("--database-url", default=os.getenv("DATABASE_URL"), help="后台数据库URL")
+    build.add_argument("--json", help="改用导出的JSON作为输入")
+    build.add_argument("--schedules", help="用户时间表对照JSON（schedule_compiler.py --assignments）")
+
+    validate = subparsers.add_parser("validate", help="校验镜像")
+    validate.add_argument("image", help="镜像文件")
+
+    args = parser.parse_args()
+
+    if args.command == "build":
+        if args.json:
+            rows = load_rows_from_json(args.json)
+        elif args.database_url:
+            rows = load_rows_from_database(args.database_url)
+        else:
+            parser.error("需要 --database-url 或 --json")
+
+        schedules = {}
+        if args.schedules:
+            with open(args.schedules, encoding="utf-8") as f:
+                schedules = {int(k): int(v) for k, v in json.load(f).items()}
+
+        image = build_image(rows, args.db_version, schedules=schedules)
+        errors = validate_image(image)
+        if errors:
+            for error in errors:
+                print(error, file=sys.stderr)
+            return 1
+
+        with open(args.output, "wb") as f:
+            f.write(image)
+        print(f"已生成: {args.output}")
+        return 0
+
+    with open(args.image, "rb") as f:
+        errors = validate_image(f.read())
+    for error in errors:
+        print(error, file=sys.stderr)
+    print("校验失败" if errors else "校验通过")
+    return 1 if errors else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,271 @@
+"""
+用户库增量同步替身后台
+
+维护带版本号的用户列表和变更日志，通过MQTT向门禁控制器下发增量或全量同步。
+协议与 firmware/src/modules/user_sync.h 保持一致：
+
+    设备 -> 后台  access-control/userdb/report          {"device_id", "db_version", "reason"}
+    后台 -> 全部  access-control/userdb/delta           {"type": "delta", "from", "to", "ops"}
+    后台 -> 单台  access-control/userdb/device/<设备ID>  增量补齐或 {"type": "full", "to", "seq", "last", "users"}
+
+每次变更版本号加1。设备版本落后且仍在日志保留范围内时按版本顺序补发增量，
+超出范围（或设备版本高于后台）时分片下发全量用户列表。
+
+用法（本地 Mosquitto）:
+    mosquitto -v
+    python userdb_sync.py serve --host localhost
+    python userdb_sync.py add --id 7 --name 测试 --card 04A1B2C3 --fingerprint 7 --pin 1234 --schedule 1
+    python userdb_sync.py disable --id 7
+    python userdb_sync.py delete --id 7
+    python userdb_sync.py show
+
+    mosquitto_sub -t 'access-control/userdb/#' -v    # 观察同步消息
+"""
+
+import argparse
+import json
+import os
+import sys
+
+# 主题（与 user_sync.h 一致）
+TOPIC_REPORT = "access-control/userdb/report"
+TOPIC_DELTA = "access-control/userdb/delta"
+TOPIC_DEVICE = "access-control/userdb/device/"
+
+# 单条消息上限（设备MQTT缓冲区为4096字节，预留主题和报文头）
+MAX_MESSAGE_BYTES = 3584
+
+# 变更日志保留条数，超出后落后的设备走全量同步
+LOG_RETENTION = 1000
+
+# 设备单批操作上限（USER_SNAPSHOT_MAX_BATCH）
+MAX_BATCH = 128
+
+DEFAULT_STATE = "userdb_sync_state.json"
+
+
+def load_state(path):
+    """读取后台状态"""
+    if not os.path.exists(path):
+        return {"version": 0, "users": {}, "log": []}
+    with open(path, encoding="utf-8") as f:
+        return json.load(f)
+
+
+def save_state(path, state):
+    """写入后台状态（先写临时文件再替换）"""
+    tmp = path + ".tmp"
+    with open(tmp, "w", encoding="utf-8") as f:
+        json.dump(state, f, ensure_ascii=False, indent=2)
+    os.replace(tmp, path)
+
+
+def make_op(op, user_id, user=None):
+    """生成单条增量操作"""
+    if op == "add":
+        return dict(op="add", **user)
+    return {"op": op, "id": user_id}
+
+
+def apply_change(state, op, user_id, user=None):
+    """记录一次变更，返回 (from, to, 操作)"""
+    users = state["users"]
+    key = str(user_id)
+
+    if op == "add":
+        users[key] = user
+    elif op in ("enable", "disable"):
+        if key not in users:
+            raise KeyError(f"用户不存在: {user_id}")
+        users[key]["enabled"] = (op == "enable")
+    elif op == "delete":
+        if users.pop(key, None) is None:
+            raise KeyError(f"用户不存在: {user_id}")
+
+    entry = make_op(op, user_id, user)
+    state["version"] += 1
+    state["log"].append({"version": state["version"], "op": entry})
+    del state["log"][:-LOG_RETENTION]
+    return state["version"] - 1, state["version"], entry
+
+
+def message_size(message):
+    return len(json.dumps(message, ensure_ascii=False, separators=(",", ":")).encode("utf-8"))
+
+
+def build_deltas(state, device_version):
+    """
+    生成把设备从 device_version 补齐到当前版本的增量消息
+    返回 None 表示需要全量同步
+    """
+    version = state["version"]
+    log = state["log"]
+    if device_version == version:
+        return []
+
+    base = log[0]["version"] - 1 if log else version
+    if device_version > version or device_version < base:
+        return None
+
+    messages = []
+    current = {"type": "delta", "from": device_version, "to": device_version, "ops": []}
+    for entry in log:
+        if entry["version"] <= device_version:
+            continue
+        candidate = dict(current, to=entry["version"], ops=current["ops"] + [entry["op"]])
+        if current["ops"] and (message_size(candidate) > MAX_MESSAGE_BYTES or len(candidate["ops"]) > MAX_BATCH):
+            messages.append(current)
+            current = {"type": "delta", "from": current["to"], "to": entry["version"], "ops": [entry["op"]]}
+        else:
+            current = candidate
+    messages.append(current)
+    return messages
+
+
+def build_full(state):
+    """生成全量同步分片"""
+    users = [state["users"][key] for key in sorted(state["users"], key=int)]
+    messages = []
+    current = {"type": "full", "to": state["version"], "seq": 0, "last": False, "users": []}
+    for user in users:
+        candidate = dict(current, users=current["users"] + [user])
+        if current["users"] and message_size(candidate) > MAX_MESSAGE_BYTES:
+            messages.append(current)
+            current = {"type": "full", "to": state["version"], "seq": current["seq"] + 1,
+                       "last": False, "users": [user]}
+        else:
+            current = candidate
+    current["last"] = True
+    messages.append(current)
+    return messages
+
+
+def encode(message):
+    return json.dumps(message, ensure_ascii=False, separators=(",", ":"))
+
+
+def connect(args):
+    """连接MQTT服务器（兼容 paho-mqtt 1.x / 2.x）"""
+    import paho.mqtt.client as mqtt
+
+    if hasattr(mqtt, "CallbackAPIVersion"):
+        client = mqtt.Client(mqtt.CallbackAPIVersion.VERSION1, client_id=args.client_id)
+    else:
+        client = mqtt.Client(client_id=args.client_id)
+    if args.username:
+        client.username_pw_set(args.username, args.password)
+    client.connect(args.host, args.port)
+    return client
+
+
+def handle_report(state, report):
+    """处理设备版本上报，返回 (主题, 消息列表)"""
+    device_id = report.get("device_id")
+    device_version = int(report.get("db_version", 0))
+    if not device_id:
+        return None, []
+
+    messages = None
+    if report.get("reason") != "resync_failed":
+        messages = build_deltas(state, device_version)
+    if messages is None:
+        messages = build_full(state)
+
+    return TOPIC_DEVICE + device_id, messages
+
+
+def cmd_serve(args):
+    client = connect(args)
+
+    def on_message(client, userdata, msg):
+        try:
+            report = json.loads(msg.payload)
+        except ValueError:
+            return
+        state = load_state(args.state)
+        topic, messages = handle_report(state, report)
+        kind = messages[0]["type"] if messages else "-"
+        print(f"{report.get('device_id')}: 设备版本={report.get('db_version')} "
+              f"后台版本={state['version']} 原因={report.get('reason')} 下发={kind}x{len(messages)}")
+        for message in messages:
+            client.publish(topic, encode(message), qos=1)
+
+    client.on_message = on_message
+    client.subscribe(TOPIC_REPORT, qos=1)
+    print(f"监听 {TOPIC_REPORT}，状态文件 {args.state}")
+    client.loop_forever()
+
+
+def cmd_change(args):
+    state = load_state(args.state)
+    user = None
+    if args.command == "add":
+        user = {"id": args.id, "name": args.name, "card": args.card.upper(),
+                "fingerprint": args.fingerprint, "password": args.pin,
+                "enabled": not args.disabled, "schedule": args.schedule}
+        if user["card"]:
+            bytes.fromhex(user["card"])
+    try:
+        from_version, to_version, op = apply_change(state, args.command, args.id, user)
+    except KeyError as e:
+        print(e.args[0], file=sys.stderr)
+        return 1
+    save_state(args.state, state)
+
+    message = {"type": "delta", "from": from_version, "to": to_version, "ops": [op]}
+    print(f"版本 {from_version} -> {to_version}: {encode(op)}")
+    if not args.no_publish:
+        client = connect(args)
+        client.loop_start()
+        client.publish(TOPIC_DELTA, encode(message), qos=1).wait_for_publish()
+        client.loop_stop()
+        client.disconnect()
+    return 0
+
+
+def cmd_show(args):
+    state = load_state(args.state)
+    print(f"版本: {state['version']}, 用户: {len(state['users'])}, 日志: {len(state['log'])}")
+    for key in sorted(state["users"], key=int):
+        print(encode(state["users"][key]))
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="用户库增量同步替身后台")
+    parser.add_argument("--state", default=DEFAULT_STATE, help="状态文件")
+    parser.add_argument("--host", default="localhost")
+    parser.add_argument("--port", type=int, default=1883)
+    parser.add_argument("--username")
+    parser.add_argument("--password", help="MQTT密码")
+    parser.add_argument("--client-id", default="userdb-sync-backend")
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    sub.add_parser("serve", help="响应设备版本上报")
+    sub.add_parser("show", help="打印当前用户列表")
+
+    add = sub.add_parser("add", help="新增或替换用户")
+    add.add_argument("--id", type=int, required=True)
+    add.add_argument("--name", default="")
+    add.add_argument("--card", default="", help="十六进制卡号")
+    add.add_argument("--fingerprint", type=int, default=0)
+    add.add_argument("--pin", default="", help="密码")
+    add.add_argument("--schedule", type=int, default=0, help="时间表ID（schedule_compiler.py 输出，0为不限时间）")
+    add.add_argument("--disabled", action="store_true")
+    add.add_argument("--no-publish", action="store_true", help="只修改状态，不广播")
+
+    for name, text in (("enable", "启用用户"), ("disable", "禁用用户"), ("delete", "删除用户")):
+        p = sub.add_parser(name, help=text)
+        p.add_argument("--id", type=int, required=True)
+        p.add_argument("--no-publish", action="store_true", help="只修改状态，不广播")
+
+    args = parser.parse_args()
+    if args.command == "serve":
+        return cmd_serve(args)
+    if args.command == "show":
+        return cmd_show(args)
+    return cmd_change(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())